@@ -61,7 +61,12 @@
  * optional. Re-synchronisation problems in EPS can be avoided, independently of the sequence number
  * management scheme, by immediately using an authentication vector retrieved from the HSS in an
  * authentication procedure between UE and MME.
+ *
+ * The HSS allocates SQNs with the SEQ/IND scheme of TS 33.102 Annex C.3.2, each
+ * vector of a batch lands in its own IND slot, so the MME may cache a small batch
+ * of vectors per UE and consume them later without re-synchronisation; this
+ * saves one S6a round trip on most authentications.
  */
-#define MAX_EPS_AUTH_VECTORS          1
+#define MAX_EPS_AUTH_VECTORS          5
 
 #endif /* FILE_3GPP_33_401_SEEN */
@@ -41,10 +41,10 @@
  * Intertask Interface Constants
  ******************************************************************************/
 
-#define ITTI_PORT                (10007)
-
 /* This is the queue size for signal dumper */
 #define ITTI_QUEUE_MAX_ELEMENTS  (64 * 1024)
-#define ITTI_DUMP_MAX_CON        (5)    /* Max connections in parallel */
+
+/* Size of the capture ring of each task, must be a power of 2 */
+#define ITTI_DUMP_RING_SIZE      (1024 * 1024)
 
 #endif /* FILE_INTERTASK_INTERFACE_CONF_SEEN */
@@ -49,6 +49,7 @@
 #include "assertions.h"
 #include "intertask_interface.h"
 #include "intertask_interface_dump.h"
+#include "itti_trace.h"
 
 #include "memory_pools.h"
 
@@ -370,6 +371,7 @@ itti_alloc_new_message_sized (
   temp->ittiMsgHeader.messageId = message_id;
   temp->ittiMsgHeader.originTaskId = origin_task_id;
   temp->ittiMsgHeader.ittiMsgSize = size;
+  itti_trace_message_alloc (temp);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_ALLOC_MSG, 0);
   return temp;
 }
@@ -411,6 +413,7 @@ itti_send_msg_to_task (
    * Increment the global message number
    */
   message_number = itti_increment_message_number ();
+  itti_dump_queue_message (origin_task_id, message_number, message, sizeof (MessageHeader) + message->ittiMsgHeader.ittiMsgSize);
 
   if (destination_task_id != TASK_UNKNOWN) {
     VCD_SIGNAL_DUMPER_DUMP_FUNCTION_BY_NAME (VCD_SIGNAL_DUMPER_FUNCTIONS_ITTI_ENQUEUE_MESSAGE, VCD_FUNCTION_IN);
@@ -437,6 +440,7 @@ itti_send_msg_to_task (
       new->msg = message;
       new->message_number = message_number;
       new->message_priority = priority;
+      itti_trace_message_send (message);
       /*
        * Enqueue message in destination task queue
        */
@@ -632,7 +636,9 @@ itti_receive_msg (
   MessageDef ** received_msg)
 {
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_and_and_fetch (&itti_desc.vcd_receive_msg, ~(1L << task_id)));
+  itti_trace_service_end (task_id);
   itti_receive_msg_internal_event_fd (task_id, 0, received_msg);
+  itti_trace_service_begin (task_id, *received_msg);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_RECV_MSG, __sync_or_and_fetch (&itti_desc.vcd_receive_msg, 1L << task_id));
 }
 
@@ -643,6 +649,7 @@ itti_poll_msg (
 {
   AssertFatal (task_id < itti_desc.task_max, "Task id (%d) is out of range (%d)!\n", task_id, itti_desc.task_max);
   *received_msg = NULL;
+  itti_trace_service_end (task_id);
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_or_and_fetch (&itti_desc.vcd_poll_msg, 1L << task_id));
   {
     struct message_list_s                  *message;
@@ -653,11 +660,25 @@ itti_poll_msg (
       *received_msg = message->msg;
       result = itti_free (ITTI_MSG_ORIGIN_ID (*received_msg), message);
       AssertFatal (result == EXIT_SUCCESS, "Failed to free memory (%d)!\n", result);
+
+      if (TASK_GET_PARENT_TASK_ID (task_id) == TASK_UNKNOWN) {
+        /*
+         * Consume the event fd count of this message (written by the sender right after the enqueue),
+         * so that polling and itti_receive_msg() can be mixed
+         */
+        eventfd_t                               sem_counter;
+        ssize_t                                 read_ret;
+
+        read_ret = read (itti_desc.threads[TASK_GET_THREAD_ID (task_id)].task_event_fd, &sem_counter, sizeof (sem_counter));
+        AssertFatal (read_ret == sizeof (sem_counter), "Read from task message FD failed (%d/%d)!\n", (int)read_ret, (int)sizeof (sem_counter));
+      }
     }
   }
 
   if (*received_msg == NULL) {
     ITTI_DEBUG (ITTI_DEBUG_POLL, " No message in queue[(%u:%s)]\n", task_id, itti_get_task_name (task_id));
+  } else {
+    itti_trace_service_begin (task_id, *received_msg);
   }
   VCD_SIGNAL_DUMPER_DUMP_VARIABLE_BY_NAME (VCD_SIGNAL_DUMPER_VARIABLE_ITTI_POLL_MSG, __sync_and_and_fetch (&itti_desc.vcd_poll_msg, ~(1L << task_id)));
 }
@@ -884,7 +905,8 @@ itti_init (
   itti_desc.vcd_poll_msg = 0;
   itti_desc.vcd_receive_msg = 0;
   itti_desc.vcd_send_msg = 0;
-
+  itti_trace_init ();
+  itti_dump_init (messages_definition_xml, dump_file_name);
 
   CHECK_INIT_RETURN (timer_init ());
   // Could not be launched before ITTI initialization
@@ -960,6 +982,8 @@ itti_wait_tasks_end (
     ITTI_DEBUG (ITTI_DEBUG_MP_STATISTICS, " Memory pools statistics:\n%s\n", statistics);
     free_wrapper ((void**)&statistics);
   }
+  itti_dump_exit ();
+  itti_trace_exit ();
 
   for (thread_id = THREAD_FIRST; thread_id < itti_desc.thread_max; thread_id++) {
     free_wrapper((void **) &itti_desc.threads[thread_id].events);
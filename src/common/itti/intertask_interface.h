@@ -145,6 +145,7 @@ int itti_get_events(task_id_t task_id, struct epoll_event **events);
 void itti_receive_msg(task_id_t task_id, MessageDef **received_msg);
 
 /** \brief Try to retrieves a message in the queue associated to task_id.
+ * Does not block, *received_msg is NULL if the queue is empty. Can be mixed with itti_receive_msg().
  \param task_id Task ID of the receiving task
  \param received_msg Pointer to the allocated message
  **/
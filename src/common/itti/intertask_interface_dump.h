@@ -30,13 +30,27 @@
 #ifndef INTERTASK_INTERFACE_DUMP_H_
 #define INTERTASK_INTERFACE_DUMP_H_
 
-int itti_dump_queue_message(task_id_t sender_task, message_number_t message_number, MessageDef *message_p, const char *message_name,
-                            const uint32_t message_size);
+#include <stdbool.h>
 
+/** \brief Record a message in the capture ring of its sender task.
+ * Does nothing if there is no capture file or if the capture is frozen.
+ **/
+int itti_dump_queue_message(task_id_t sender_task, message_number_t message_number, MessageDef *message_p, const uint32_t message_size);
+
+/** \brief Create and map the capture file, a capture file of a previous run is renamed with a ".old" suffix.
+ * \param messages_definition_xml XML definition of messages stored in the capture for the analyzer, may be NULL
+ * \param dump_file_name capture file, nothing is recorded if NULL
+ **/
 int itti_dump_init(const char * const messages_definition_xml, const char * const dump_file_name);
 
-void itti_dump_exit(void);
+/** \brief Stop (freeze) or resume the recording of messages, the capture file can be extracted while frozen.
+ **/
+void itti_dump_freeze(bool freeze);
 
-void itti_dump_thread_use_ring_buffer(void);
+bool itti_dump_is_frozen(void);
+
+/** \brief Freeze the capture, flush it to the file and unmap it.
+ **/
+void itti_dump_exit(void);
 
 #endif /* INTERTASK_INTERFACE_DUMP_H_ */
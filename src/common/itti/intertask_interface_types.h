@@ -121,6 +121,16 @@ typedef struct itti_lte_time_s {
   struct timeval time;
 } itti_lte_time_t;
 
+/** @struct itti_trace_context_t
+ *  @brief End-to-end tracing context of a message, only present in messages when built with ITTI_TRACE.
+ */
+typedef struct itti_trace_context_s {
+  uint32_t procedure_id;          /**< Procedure the message belongs to, inherited from the message being handled by the sender */
+  uint32_t ue_id;                 /**< UE (mme_ue_s1ap_id) the procedure is bound to, 0 if not known yet */
+  uint64_t enqueue_tsc;           /**< Time stamp counter when the message was enqueued in the destination task queue */
+  uint64_t dequeue_tsc;           /**< Time stamp counter when the message was dequeued by the destination task */
+} itti_trace_context_t;
+
 /** @struct MessageHeader
  *  @brief Message Header structure for inter-task communication.
  */
@@ -134,6 +144,9 @@ typedef struct MessageHeader_s {
   MessageHeaderSize ittiMsgSize;         /**< Message size (not including header size) */
 
   itti_lte_time_t lte_time;       /**< Reference LTE time */
+#if ITTI_TRACE
+  itti_trace_context_t trace;     /**< Latency tracing context of the current hop */
+#endif
 } MessageHeader;
 
 /** @struct MessageDef
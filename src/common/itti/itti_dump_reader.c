@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file itti_dump_reader.c
+   \brief Offline reader of ITTI capture files (INTERTASK_INTERFACE.ITTI_CAPTURE_FILE).
+   Merges the per task rings in message number order and writes them in the
+   itti_analyzer dump file format (XML definition followed by messages).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "itti_types.h"
+
+typedef struct itti_dump_reader_message_s {
+  uint64_t   message_number;
+  uint32_t   length;
+  uint8_t   *data;
+} itti_dump_reader_message_t;
+
+typedef struct itti_dump_reader_stats_s {
+  uint64_t   num_messages;
+  uint64_t   num_incomplete;    // records not completed when the capture was frozen
+  uint64_t   skipped_bytes;     // bytes of records partially overwritten
+} itti_dump_reader_stats_t;
+
+static itti_dump_reader_message_t *messages = NULL;
+static uint64_t                    num_messages = 0;
+static uint64_t                    max_messages = 0;
+
+//------------------------------------------------------------------------------
+static void ring_copy(void * const dest, const uint8_t * const ring_data, const uint64_t ring_size, const uint64_t position, const size_t length)
+{
+  uint64_t index = position & (ring_size - 1);
+  size_t   first = ring_size - index;
+
+  if (first >= length) {
+    memcpy(dest, &ring_data[index], length);
+  } else {
+    memcpy(dest, &ring_data[index], first);
+    memcpy(((uint8_t *)dest) + first, ring_data, length - first);
+  }
+}
+
+//------------------------------------------------------------------------------
+static int add_message(const uint64_t message_number, const uint8_t * const ring_data, const uint64_t ring_size, const uint64_t position, const uint32_t length)
+{
+  if (num_messages == max_messages) {
+    itti_dump_reader_message_t *more = NULL;
+
+    max_messages = (max_messages) ? max_messages * 2 : 4096;
+    more = realloc(messages, max_messages * sizeof(itti_dump_reader_message_t));
+    if (!more) return -1;
+    messages = more;
+  }
+  messages[num_messages].data = malloc(length);
+  if (!messages[num_messages].data) return -1;
+  ring_copy(messages[num_messages].data, ring_data, ring_size, position, length);
+  messages[num_messages].message_number = message_number;
+  messages[num_messages].length = length;
+  num_messages++;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int read_ring(const uint8_t * const base, const size_t file_size, const itti_capture_file_header_t * const header,
+    const itti_capture_ring_t * const ring, itti_dump_reader_stats_t * const stats)
+{
+  const uint64_t          ring_size = header->ring_size;
+  const uint64_t          write_offset = ring->write_offset;
+  const uint8_t          *ring_data = NULL;
+  itti_capture_record_t   record;
+  uint64_t                position = 0;
+
+  if ((ring->data_offset + ring_size) > file_size) return -1;
+  ring_data = &base[ring->data_offset];
+  // only the last ring_size bytes are still in the ring
+  position = (write_offset > ring_size) ? write_offset - ring_size : 0;
+
+  while ((position + sizeof(record)) <= write_offset) {
+    ring_copy(&record, ring_data, ring_size, position, sizeof(record));
+    uint64_t total_size = ITTI_CAPTURE_ALIGN(sizeof(record) + record.length);
+
+    if ((record.offset != position) || ((position + total_size) > write_offset)) {
+      // partially overwritten record, resynchronize on the next record header
+      position += 8;
+      stats->skipped_bytes += 8;
+      continue;
+    }
+    if (ITTI_CAPTURE_RECORD_MAGIC != record.magic) {
+      stats->num_incomplete++;
+    } else {
+      if (add_message(record.message_number, ring_data, ring_size, position + sizeof(record), record.length)) return -1;
+      stats->num_messages++;
+    }
+    position += total_size;
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int compare_messages(const void *a, const void *b)
+{
+  const itti_dump_reader_message_t *ma = a;
+  const itti_dump_reader_message_t *mb = b;
+
+  return (ma->message_number > mb->message_number) - (ma->message_number < mb->message_number);
+}
+
+//------------------------------------------------------------------------------
+static void write_xml_definition(FILE * const out, const char * const xml, const uint32_t xml_length)
+{
+  const itti_message_types_t  end = ITTI_DUMP_XML_DEFINITION_END;
+  itti_socket_header_t        socket_header;
+
+  socket_header.message_size = sizeof(socket_header) + xml_length + sizeof(end);
+  socket_header.message_type = ITTI_DUMP_XML_DEFINITION;
+  fwrite(&socket_header, sizeof(socket_header), 1, out);
+  fwrite(xml, xml_length, 1, out);
+  fwrite(&end, sizeof(end), 1, out);
+}
+
+//------------------------------------------------------------------------------
+static void write_message(FILE * const out, const itti_dump_reader_message_t * const message)
+{
+  const itti_message_types_t  end = ITTI_DUMP_MESSAGE_TYPE_END;
+  itti_socket_header_t        socket_header;
+  itti_signal_header_t        signal_header;
+
+  socket_header.message_size = sizeof(socket_header) + sizeof(signal_header) + message->length + sizeof(end);
+  socket_header.message_type = ITTI_DUMP_MESSAGE_TYPE;
+  snprintf(signal_header.message_number_char, sizeof(signal_header.message_number_char), MESSAGE_NUMBER_CHAR_FORMAT, (uint32_t)message->message_number);
+  signal_header.message_number_char[sizeof(signal_header.message_number_char) - 1] = '\n';
+  fwrite(&socket_header, sizeof(socket_header), 1, out);
+  fwrite(&signal_header, sizeof(signal_header), 1, out);
+  fwrite(message->data, message->length, 1, out);
+  fwrite(&end, sizeof(end), 1, out);
+}
+
+//------------------------------------------------------------------------------
+static char * read_xml_file(const char * const file_name, uint32_t * const length)
+{
+  FILE   *fp = fopen(file_name, "rb");
+  char   *xml = NULL;
+  long    size = 0;
+
+  if (!fp) return NULL;
+  if ((0 == fseek(fp, 0, SEEK_END)) && ((size = ftell(fp)) > 0) && (0 == fseek(fp, 0, SEEK_SET))) {
+    xml = calloc(1, size + 1);
+    if ((xml) && (1 != fread(xml, size, 1, fp))) {
+      free(xml);
+      xml = NULL;
+    }
+    *length = size + 1;
+  }
+  fclose(fp);
+  return xml;
+}
+
+//------------------------------------------------------------------------------
+static void usage(const char * const exe)
+{
+  fprintf(stderr, "Usage: %s [-x <messages XML definition>] <capture file> <analyzer dump file>\n", exe);
+  fprintf(stderr, "Converts an ITTI capture file to the itti_analyzer dump format.\n");
+  fprintf(stderr, "The XML definition is taken from the capture file if it was recorded.\n");
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  const char                         *xml_file_name = NULL;
+  char                               *xml = NULL;
+  uint32_t                            xml_length = 0;
+  int                                 fd = -1;
+  struct stat                         st;
+  uint8_t                            *base = NULL;
+  const itti_capture_file_header_t   *header = NULL;
+  const itti_capture_ring_t          *rings = NULL;
+  FILE                               *out = NULL;
+  int                                 c;
+  int                                 rc = EXIT_SUCCESS;
+
+  while ((c = getopt(argc, argv, "x:h")) != -1) {
+    switch (c) {
+    case 'x':
+      xml_file_name = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if ((argc - optind) != 2) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  fd = open(argv[optind], O_RDONLY);
+  if ((fd < 0) || (fstat(fd, &st))) {
+    fprintf(stderr, "Could not open %s: %s\n", argv[optind], strerror(errno));
+    return EXIT_FAILURE;
+  }
+  base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if ((MAP_FAILED == base) || (st.st_size < (off_t)sizeof(itti_capture_file_header_t))) {
+    fprintf(stderr, "Could not map %s: %s\n", argv[optind], strerror(errno));
+    close(fd);
+    return EXIT_FAILURE;
+  }
+  header = (const itti_capture_file_header_t *)base;
+  rings = (const itti_capture_ring_t *)&base[ITTI_CAPTURE_ALIGN(sizeof(itti_capture_file_header_t))];
+  if ((memcmp(header->magic, ITTI_CAPTURE_FILE_MAGIC, ITTI_CAPTURE_FILE_MAGIC_LENGTH)) ||
+      (ITTI_CAPTURE_FILE_VERSION != header->version) ||
+      (0 == header->ring_size) || (header->ring_size & (header->ring_size - 1)) ||
+      ((ITTI_CAPTURE_ALIGN(sizeof(itti_capture_file_header_t)) + header->num_rings * sizeof(itti_capture_ring_t)) > (uint64_t)st.st_size)) {
+    fprintf(stderr, "%s is not an ITTI capture file (version %u)\n", argv[optind], ITTI_CAPTURE_FILE_VERSION);
+    rc = EXIT_FAILURE;
+    goto end;
+  }
+  if (!header->frozen) {
+    fprintf(stderr, "Warning: capture is not frozen, last messages may be missing\n");
+  }
+
+  if (xml_file_name) {
+    xml = read_xml_file(xml_file_name, &xml_length);
+    if (!xml) {
+      fprintf(stderr, "Could not read %s\n", xml_file_name);
+      rc = EXIT_FAILURE;
+      goto end;
+    }
+  } else if ((header->xml_length) && ((header->xml_offset + header->xml_length) <= (uint64_t)st.st_size)) {
+    xml_length = header->xml_length;
+    xml = malloc(xml_length);
+    if (xml) memcpy(xml, &base[header->xml_offset], xml_length);
+  } else {
+    fprintf(stderr, "Warning: no XML definition of messages in capture, use -x\n");
+  }
+
+  for (uint32_t i = 0; i < header->num_rings; i++) {
+    itti_dump_reader_stats_t stats = {0};
+
+    if (read_ring(base, st.st_size, header, &rings[i], &stats)) {
+      fprintf(stderr, "Could not read ring %u\n", i);
+      rc = EXIT_FAILURE;
+      goto end;
+    }
+    if ((stats.num_messages) || (stats.num_incomplete)) {
+      fprintf(stderr, "Task %3u: %" PRIu64 " messages, %" PRIu64 " incomplete, %" PRIu64 " bytes of overwritten records\n",
+          rings[i].task_id, stats.num_messages, stats.num_incomplete, stats.skipped_bytes);
+    }
+  }
+  qsort(messages, num_messages, sizeof(itti_dump_reader_message_t), compare_messages);
+
+  out = fopen(argv[optind + 1], "wb");
+  if (!out) {
+    fprintf(stderr, "Could not open %s: %s\n", argv[optind + 1], strerror(errno));
+    rc = EXIT_FAILURE;
+    goto end;
+  }
+  if (xml) {
+    write_xml_definition(out, xml, xml_length);
+  }
+  for (uint64_t i = 0; i < num_messages; i++) {
+    write_message(out, &messages[i]);
+  }
+  if (fclose(out)) {
+    fprintf(stderr, "Could not write %s: %s\n", argv[optind + 1], strerror(errno));
+    rc = EXIT_FAILURE;
+  }
+  fprintf(stderr, "%" PRIu64 " messages written in %s\n", num_messages, argv[optind + 1]);
+
+end:
+  for (uint64_t i = 0; i < num_messages; i++) {
+    free(messages[i].data);
+  }
+  free(messages);
+  free(xml);
+  munmap(base, st.st_size);
+  close(fd);
+  return rc;
+}
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file itti_trace.c
+   \brief End-to-end latency tracing of ITTI messages.
+   A task is only served by one thread, so all per task data is written without locking by
+   this thread. Time stamps are taken with the TSC (assumed invariant and synchronized
+   between cores), calibrated against CLOCK_MONOTONIC at init.
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "assertions.h"
+#include "intertask_interface.h"
+#include "itti_trace.h"
+#include "dynamic_memory_check.h"
+#include "log.h"
+
+typedef struct itti_trace_histogram_s {
+  uint64_t                                count;
+  uint64_t                                sum_ns;
+  uint64_t                                max_ns;
+  uint64_t                                buckets[ITTI_TRACE_HISTOGRAM_BUCKETS];
+} itti_trace_histogram_t;
+
+typedef struct itti_trace_span_s {
+  uint32_t                                procedure_id;
+  uint32_t                                ue_id;
+  uint16_t                                message_id;
+  uint16_t                                origin_task_id;
+  uint64_t                                enqueue_tsc;
+  uint64_t                                dequeue_tsc;
+  uint64_t                                end_tsc;
+} itti_trace_span_t;
+
+typedef struct itti_trace_task_s {
+  bool                                    in_service;
+  itti_trace_span_t                       current;   ///< Span of the message being handled
+  itti_trace_histogram_t                  queueing;
+  itti_trace_histogram_t                  service;
+  uint64_t                                num_spans;
+  itti_trace_span_t                      *spans;     ///< Ring of the last ITTI_TRACE_SPANS_PER_TASK spans
+} __attribute__ ((aligned (64))) itti_trace_task_t;
+
+static itti_trace_task_t                g_itti_trace_tasks[TASK_MAX];
+static uint32_t                         g_itti_trace_procedure_id = 0;
+static double                           g_itti_trace_tsc_per_ns = 1.0;
+static uint64_t                         g_itti_trace_tsc_origin = 0;
+static char                            *g_itti_trace_file_name = NULL;
+
+/* Span of the message being handled by the calling thread, if any */
+static __thread itti_trace_span_t      *tls_itti_trace_current = NULL;
+
+//------------------------------------------------------------------------------
+static uint64_t itti_trace_monotonic_ns(void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_trace_tsc(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return itti_trace_monotonic_ns();
+#endif
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t itti_trace_tsc_to_ns(const uint64_t start_tsc, const uint64_t end_tsc)
+{
+  // TSCs of different cores may be slightly off
+  if (end_tsc <= start_tsc) return 0;
+  return (uint64_t)((double)(end_tsc - start_tsc) / g_itti_trace_tsc_per_ns);
+}
+
+//------------------------------------------------------------------------------
+static inline void itti_trace_histogram_update(itti_trace_histogram_t * const histogram, const uint64_t ns)
+{
+  int                                     bucket = (ns <= 1) ? 0 : 64 - __builtin_clzll(ns - 1);
+
+  if (bucket >= ITTI_TRACE_HISTOGRAM_BUCKETS) {
+    bucket = ITTI_TRACE_HISTOGRAM_BUCKETS - 1;
+  }
+  histogram->buckets[bucket]++;
+  histogram->count++;
+  histogram->sum_ns += ns;
+  if (ns > histogram->max_ns) {
+    histogram->max_ns = ns;
+  }
+}
+
+//------------------------------------------------------------------------------
+static uint64_t itti_trace_histogram_percentile(const itti_trace_histogram_t * const histogram, const unsigned int percent)
+{
+  uint64_t                                threshold = (histogram->count * percent + 99) / 100;
+  uint64_t                                cumul = 0;
+
+  for (int i = 0; i < ITTI_TRACE_HISTOGRAM_BUCKETS; i++) {
+    cumul += histogram->buckets[i];
+    if (cumul >= threshold) {
+      return 1ULL << i;
+    }
+  }
+  return histogram->max_ns;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_init(void)
+{
+  uint64_t                                ns_start = 0;
+  uint64_t                                tsc_start = 0;
+  uint64_t                                ns_end = 0;
+  uint64_t                                tsc_end = 0;
+
+  memset(g_itti_trace_tasks, 0, sizeof(g_itti_trace_tasks));
+  for (int task_id = TASK_FIRST; task_id < TASK_MAX; task_id++) {
+    g_itti_trace_tasks[task_id].spans = calloc(ITTI_TRACE_SPANS_PER_TASK, sizeof(itti_trace_span_t));
+    AssertFatal (g_itti_trace_tasks[task_id].spans, "Failed to allocate ITTI trace spans of task %d\n", task_id);
+  }
+
+  // calibrate the TSC against the monotonic clock
+  ns_start = itti_trace_monotonic_ns();
+  tsc_start = itti_trace_tsc();
+  usleep(20000);
+  ns_end = itti_trace_monotonic_ns();
+  tsc_end = itti_trace_tsc();
+  if ((ns_end > ns_start) && (tsc_end > tsc_start)) {
+    g_itti_trace_tsc_per_ns = (double)(tsc_end - tsc_start) / (double)(ns_end - ns_start);
+  }
+  g_itti_trace_tsc_origin = tsc_start;
+  OAILOG_INFO (LOG_ITTI, "ITTI tracing enabled, %.3f TSC ticks per ns\n", g_itti_trace_tsc_per_ns);
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_set_output_file(const char * const file_name)
+{
+  free_wrapper((void**)&g_itti_trace_file_name);
+  if (file_name) {
+    g_itti_trace_file_name = strdup(file_name);
+  }
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_message_alloc(MessageDef * const message_p)
+{
+  const itti_trace_context_t              trace = {0};
+
+  message_p->ittiMsgHeader.trace = trace;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_message_send(MessageDef * const message_p)
+{
+  // MessageDef is packed, work on a copy
+  itti_trace_context_t                    trace = message_p->ittiMsgHeader.trace;
+  itti_trace_span_t                      *current = tls_itti_trace_current;
+
+  if (current) {
+    if (0 == trace.procedure_id) {
+      trace.procedure_id = current->procedure_id;
+    }
+    if ((0 == trace.ue_id) && (trace.procedure_id == current->procedure_id)) {
+      trace.ue_id = current->ue_id;
+    }
+  } else if (0 == trace.procedure_id) {
+    // Message not triggered by another one (socket, timer, ...), this is the start of a procedure
+    do {
+      trace.procedure_id = __sync_add_and_fetch(&g_itti_trace_procedure_id, 1);
+    } while (0 == trace.procedure_id);
+  }
+  trace.dequeue_tsc = 0;
+  trace.enqueue_tsc = itti_trace_tsc();
+  message_p->ittiMsgHeader.trace = trace;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_service_end(const task_id_t task_id)
+{
+  itti_trace_task_t                      *task = &g_itti_trace_tasks[task_id];
+
+  if (task->in_service) {
+    task->current.end_tsc = itti_trace_tsc();
+    itti_trace_histogram_update(&task->service, itti_trace_tsc_to_ns(task->current.dequeue_tsc, task->current.end_tsc));
+    task->spans[task->num_spans & (ITTI_TRACE_SPANS_PER_TASK - 1)] = task->current;
+    task->num_spans++;
+    task->in_service = false;
+  }
+  tls_itti_trace_current = NULL;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_service_begin(const task_id_t task_id, MessageDef * const message_p)
+{
+  itti_trace_task_t                      *task = &g_itti_trace_tasks[task_id];
+  uint64_t                                dequeue_tsc = 0;
+
+  if (!message_p) {
+    return;
+  }
+  dequeue_tsc = itti_trace_tsc();
+  message_p->ittiMsgHeader.trace.dequeue_tsc = dequeue_tsc;
+  task->current.procedure_id = message_p->ittiMsgHeader.trace.procedure_id;
+  task->current.ue_id = message_p->ittiMsgHeader.trace.ue_id;
+  task->current.message_id = ITTI_MSG_ID(message_p);
+  task->current.origin_task_id = ITTI_MSG_ORIGIN_ID(message_p);
+  task->current.enqueue_tsc = message_p->ittiMsgHeader.trace.enqueue_tsc;
+  task->current.dequeue_tsc = dequeue_tsc;
+  task->current.end_tsc = 0;
+  task->in_service = true;
+  if (task->current.enqueue_tsc) {
+    itti_trace_histogram_update(&task->queueing, itti_trace_tsc_to_ns(task->current.enqueue_tsc, dequeue_tsc));
+  }
+  tls_itti_trace_current = &task->current;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_set_ue_id(const uint32_t ue_id)
+{
+  if (tls_itti_trace_current) {
+    tls_itti_trace_current->ue_id = ue_id;
+  }
+}
+
+//------------------------------------------------------------------------------
+int itti_trace_dump_json(const char * const file_name)
+{
+  FILE                                   *fp = NULL;
+  uint64_t                                num_events = 0;
+
+  fp = fopen(file_name, "w");
+  if (!fp) {
+    OAILOG_ERROR (LOG_ITTI, "Could not open ITTI trace file %s: %s\n", file_name, strerror(errno));
+    return -1;
+  }
+  fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"No UE\"}}");
+
+  for (int task_id = TASK_FIRST; task_id < TASK_MAX; task_id++) {
+    const itti_trace_task_t              *task = &g_itti_trace_tasks[task_id];
+    uint64_t                              num_spans = task->num_spans;
+    uint64_t                              first = 0;
+
+    if (!task->spans) continue;
+    if (num_spans > ITTI_TRACE_SPANS_PER_TASK) {
+      first = num_spans - ITTI_TRACE_SPANS_PER_TASK;
+    }
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+        task_id, itti_get_task_name(task_id));
+
+    for (uint64_t i = first; i < num_spans; i++) {
+      const itti_trace_span_t            *span = &task->spans[i & (ITTI_TRACE_SPANS_PER_TASK - 1)];
+      const char                         *message_name = itti_get_message_name(span->message_id);
+      double                              enqueue_us = itti_trace_tsc_to_ns(g_itti_trace_tsc_origin, span->enqueue_tsc) / 1000.0;
+      double                              dequeue_us = itti_trace_tsc_to_ns(g_itti_trace_tsc_origin, span->dequeue_tsc) / 1000.0;
+      double                              service_us = itti_trace_tsc_to_ns(span->dequeue_tsc, span->end_tsc) / 1000.0;
+
+      if (span->enqueue_tsc) {
+        fprintf(fp, ",\n{\"name\":\"%s (queued)\",\"cat\":\"queue\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%d,"
+            "\"args\":{\"procedure\":%u,\"from\":\"%s\"}}",
+            message_name, enqueue_us, dequeue_us - enqueue_us, span->ue_id, task_id,
+            span->procedure_id, itti_get_task_name(span->origin_task_id));
+        num_events++;
+      }
+      fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%d,"
+          "\"args\":{\"procedure\":%u,\"from\":\"%s\"}}",
+          message_name, itti_get_task_name(task_id), dequeue_us, service_us, span->ue_id, task_id,
+          span->procedure_id, itti_get_task_name(span->origin_task_id));
+      num_events++;
+    }
+  }
+  fprintf(fp, "\n]}\n");
+  if (fclose(fp)) {
+    OAILOG_ERROR (LOG_ITTI, "Could not write ITTI trace file %s: %s\n", file_name, strerror(errno));
+    return -1;
+  }
+  OAILOG_INFO (LOG_ITTI, "Wrote %" PRIu64 " ITTI trace events in %s\n", num_events, file_name);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+void itti_trace_exit(void)
+{
+  for (int task_id = TASK_FIRST; task_id < TASK_MAX; task_id++) {
+    const itti_trace_task_t              *task = &g_itti_trace_tasks[task_id];
+
+    if (task->queueing.count) {
+      OAILOG_INFO (LOG_ITTI, "%-16s queueing: %" PRIu64 " msgs mean %" PRIu64 " p50 %" PRIu64 " p99 %" PRIu64 " max %" PRIu64 " ns\n",
+          itti_get_task_name(task_id), task->queueing.count, task->queueing.sum_ns / task->queueing.count,
+          itti_trace_histogram_percentile(&task->queueing, 50), itti_trace_histogram_percentile(&task->queueing, 99), task->queueing.max_ns);
+    }
+    if (task->service.count) {
+      OAILOG_INFO (LOG_ITTI, "%-16s service:  %" PRIu64 " msgs mean %" PRIu64 " p50 %" PRIu64 " p99 %" PRIu64 " max %" PRIu64 " ns\n",
+          itti_get_task_name(task_id), task->service.count, task->service.sum_ns / task->service.count,
+          itti_trace_histogram_percentile(&task->service, 50), itti_trace_histogram_percentile(&task->service, 99), task->service.max_ns);
+    }
+  }
+  if (g_itti_trace_file_name) {
+    itti_trace_dump_json(g_itti_trace_file_name);
+    free_wrapper((void**)&g_itti_trace_file_name);
+  }
+  for (int task_id = TASK_FIRST; task_id < TASK_MAX; task_id++) {
+    free_wrapper((void**)&g_itti_trace_tasks[task_id].spans);
+  }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file itti_trace.h
+   \brief End-to-end latency tracing of ITTI messages (build option ITTI_TRACE).
+   Every message carries a procedure id inherited from the message its sender is handling,
+   and is time stamped when enqueued and dequeued. Per task queueing and service time
+   histograms are logged at exit, per UE spans can be written as a Chrome trace JSON file
+   (chrome://tracing, ui.perfetto.dev).
+   When ITTI_TRACE is not set, all calls compile to nothing.
+*/
+#ifndef FILE_ITTI_TRACE_SEEN
+#define FILE_ITTI_TRACE_SEEN
+
+#include "intertask_interface_types.h"
+
+#if ITTI_TRACE
+
+#define ITTI_TRACE_HISTOGRAM_BUCKETS    32     /*!< \brief bucket i counts latencies <= 2^i nanoseconds */
+#define ITTI_TRACE_SPANS_PER_TASK    16384     /*!< \brief most recent spans kept per task for the JSON dump, power of 2 */
+
+void itti_trace_init(void);
+
+/*
+ * Set the Chrome trace JSON file written by itti_trace_exit(), NULL for none.
+ */
+void itti_trace_set_output_file(const char * const file_name);
+
+/*
+ * Clear the context of a newly allocated message.
+ */
+void itti_trace_message_alloc(MessageDef * const message_p);
+
+/*
+ * Give a procedure id to a message (inherited from the message being handled by the calling thread,
+ * or a new one) and time stamp its enqueuing.
+ */
+void itti_trace_message_send(MessageDef * const message_p);
+
+/*
+ * Called by a task before waiting for its next message: closes the service span of the previous one.
+ */
+void itti_trace_service_end(const task_id_t task_id);
+
+/*
+ * Called when a task dequeued a message (message_p may be NULL): records the queueing time and
+ * opens the service span.
+ */
+void itti_trace_service_begin(const task_id_t task_id, MessageDef * const message_p);
+
+/*
+ * Bind the procedure being handled by the calling thread to a UE, messages sent from now on
+ * in the procedure carry this UE id.
+ */
+void itti_trace_set_ue_id(const uint32_t ue_id);
+
+/*
+ * Write the recorded spans as a Chrome trace JSON file, one process per UE and one thread per task.
+ * Should be called when ITTI tasks are stopped.
+ *
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int itti_trace_dump_json(const char * const file_name);
+
+/*
+ * Log the per task histograms, write the JSON file if any and release resources.
+ */
+void itti_trace_exit(void);
+
+#else
+
+#define itti_trace_init()                             do {} while (0)
+#define itti_trace_set_output_file(fILEnAME)          do {} while (0)
+#define itti_trace_message_alloc(mESSAGEp)            do {} while (0)
+#define itti_trace_message_send(mESSAGEp)             do {} while (0)
+#define itti_trace_service_end(tASKiD)                do {} while (0)
+#define itti_trace_service_begin(tASKiD, mESSAGEp)    do {} while (0)
+#define itti_trace_set_ue_id(uEiD)                    do {} while (0)
+#define itti_trace_exit()                             do {} while (0)
+
+#endif /* ITTI_TRACE */
+
+#endif /* FILE_ITTI_TRACE_SEEN */
@@ -71,6 +71,42 @@ typedef struct {
   char message_number_char[12]; /* 9 chars are needed to store an unsigned 32 bits value in decimal, but must be a multiple of 32 bits to avoid alignment issues */
 } itti_signal_header_t;
 
+/* Capture file: memory mapped flight recorder of ITTI messages, one ring per sender task.
+ * Layout: itti_capture_file_header_t, num_rings itti_capture_ring_t, rings data, XML definition.
+ */
+#define ITTI_CAPTURE_FILE_MAGIC         "OAIITTI1"
+#define ITTI_CAPTURE_FILE_MAGIC_LENGTH  8
+#define ITTI_CAPTURE_FILE_VERSION       1
+#define ITTI_CAPTURE_RECORD_MAGIC       CHARS_TO_UINT32 ('I', 'c', 'r', 'd')
+#define ITTI_CAPTURE_ALIGN(sIZE)        (((sIZE) + 7) & ~((uint64_t)7))
+
+typedef struct itti_capture_file_header_s {
+  char                  magic[ITTI_CAPTURE_FILE_MAGIC_LENGTH];
+  uint32_t              version;
+  volatile uint32_t     frozen;          /* no more messages are recorded while set */
+  uint32_t              num_rings;
+  uint32_t              reserved;
+  uint64_t              ring_size;       /* bytes, power of 2 */
+  uint64_t              xml_offset;      /* file offset of the messages XML definition, 0 if none */
+  uint64_t              xml_length;
+  int64_t               start_time_sec;
+} __attribute__ ((aligned (64))) itti_capture_file_header_t;
+
+typedef struct itti_capture_ring_s {
+  volatile uint64_t     write_offset;    /* bytes ever reserved in the ring, position of the next record */
+  uint64_t              data_offset;     /* file offset of the ring data */
+  uint32_t              task_id;         /* sender task of the messages recorded in the ring */
+} __attribute__ ((aligned (64))) itti_capture_ring_t;
+
+/* Header of a record, records are 8 bytes aligned and may wrap at the end of the ring. */
+typedef struct itti_capture_record_s {
+  volatile uint32_t     magic;           /* ITTI_CAPTURE_RECORD_MAGIC, written once the record is complete */
+  uint32_t              length;          /* bytes of message (MessageDef) following the header */
+  uint64_t              offset;          /* write_offset at which the record was reserved, detects overwritten records */
+  uint64_t              message_number;
+  uint64_t              timestamp_ns;    /* CLOCK_REALTIME */
+} itti_capture_record_t;
+
 
 #define INSTANCE_DEFAULT    (UINT16_MAX - 1)
 #define INSTANCE_ALL        (UINT16_MAX)
@@ -45,6 +45,7 @@
 #include "bstrlib.h"
 
 #include "intertask_interface.h"
+#include "intertask_interface_dump.h"
 #include "timer.h"
 #include "backtrace.h"
 #include "assertions.h"
@@ -78,6 +79,7 @@ signal_mask (
   sigemptyset (&set);
   sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
+  sigaddset (&set, SIGUSR2);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
   sigaddset (&set, SIGINT);
@@ -100,6 +102,7 @@ signal_handle (
   sigemptyset (&set);
   sigaddset (&set, SIGTIMER);
   sigaddset (&set, SIGUSR1);
+  sigaddset (&set, SIGUSR2);
   sigaddset (&set, SIGABRT);
   sigaddset (&set, SIGSEGV);
   sigaddset (&set, SIGINT);
@@ -136,9 +139,16 @@ signal_handle (
       *end = 1;
       break;
 
+    case SIGUSR2:
+      // Freeze/resume the ITTI capture so that it can be extracted
+      itti_dump_freeze (!itti_dump_is_frozen ());
+      SIG_DEBUG ("Received SIGUSR2, ITTI capture %s\n", itti_dump_is_frozen () ? "frozen" : "resumed");
+      break;
+
     case SIGSEGV:              /* Fall through */
     case SIGABRT:
       SIG_DEBUG ("Received SIGABORT\n");
+      itti_dump_freeze (true);
       backtrace_handle_signal (&info);
       break;
 
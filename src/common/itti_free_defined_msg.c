@@ -185,6 +185,20 @@ void itti_free_msg_content (MessageDef * const message_p)
     // DO nothing (trxn)
     break;
 
+  case S11_BEARER_REQUEST_BATCH: {
+    // Requests not dispatched yet
+    for (int i = 0; i < message_p->ittiMsg.s11_bearer_request_batch.nb_requests; i++) {
+      MessageDef *request_p = message_p->ittiMsg.s11_bearer_request_batch.requests[i];
+
+      if (request_p) {
+        itti_free_msg_content (request_p);
+        itti_free (ITTI_MSG_ORIGIN_ID (request_p), request_p);
+      }
+    }
+    message_p->ittiMsg.s11_bearer_request_batch.nb_requests = 0;
+  }
+  break;
+
   case S1AP_UPLINK_NAS_LOG:
   case S1AP_UE_CAPABILITY_IND_LOG:
   case S1AP_INITIAL_CONTEXT_SETUP_LOG:
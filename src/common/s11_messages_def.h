@@ -43,3 +43,4 @@ MESSAGE_DEF(S11_DELETE_SESSION_REQUEST,  MESSAGE_PRIORITY_MED, itti_s11_delete_s
 MESSAGE_DEF(S11_DELETE_SESSION_RESPONSE, MESSAGE_PRIORITY_MED, itti_s11_delete_session_response_t, s11_delete_session_response)
 MESSAGE_DEF(S11_RELEASE_ACCESS_BEARERS_REQUEST, MESSAGE_PRIORITY_MED, itti_s11_release_access_bearers_request_t, s11_release_access_bearers_request)
 MESSAGE_DEF(S11_RELEASE_ACCESS_BEARERS_RESPONSE, MESSAGE_PRIORITY_MED, itti_s11_release_access_bearers_response_t, s11_release_access_bearers_response)
+MESSAGE_DEF(S11_BEARER_REQUEST_BATCH,    MESSAGE_PRIORITY_MED, itti_s11_bearer_request_batch_t,    s11_bearer_request_batch)
@@ -48,6 +48,9 @@
 #define S11_DELETE_SESSION_RESPONSE(mSGpTR)        (mSGpTR)->ittiMsg.s11_delete_session_response
 #define S11_RELEASE_ACCESS_BEARERS_REQUEST(mSGpTR) (mSGpTR)->ittiMsg.s11_release_access_bearers_request
 #define S11_RELEASE_ACCESS_BEARERS_RESPONSE(mSGpTR) (mSGpTR)->ittiMsg.s11_release_access_bearers_response
+#define S11_BEARER_REQUEST_BATCH(mSGpTR)           (mSGpTR)->ittiMsg.s11_bearer_request_batch
+
+#define S11_BEARER_REQUEST_BATCH_MAX               64
 
 //-----------------------------------------------------------------------------
 /** @struct itti_s11_create_session_request_t
@@ -1096,5 +1099,21 @@ typedef struct itti_s11_delete_bearer_command_s {
   struct in_addr  peer_ip;
 } itti_s11_delete_bearer_command_s;
 
+//-----------------------------------------------------------------------------
+/** @struct itti_s11_bearer_request_batch_t
+ *  @brief Modify Bearer and Release Access Bearers Requests to one S-GW
+ *
+ * Not a GTPv2-C message: MME_APP aggregates the requests it issues while handling a burst
+ * of messages (eNB reset, paging storm) and gives them to TASK_S11 in one ITTI message.
+ * Each request is an S11_MODIFY_BEARER_REQUEST or S11_RELEASE_ACCESS_BEARERS_REQUEST ITTI message,
+ * the requests still referenced when the batch is freed are freed with it.
+ */
+struct MessageDef_s;
+typedef struct itti_s11_bearer_request_batch_s {
+  struct in_addr        peer_ip;         ///< S-GW of all the requests
+  uint32_t              nb_requests;
+  struct MessageDef_s  *requests[S11_BEARER_REQUEST_BATCH_MAX];
+} itti_s11_bearer_request_batch_t;
+
 #endif
 /* FILE_S11_MESSAGES_TYPES_SEEN */
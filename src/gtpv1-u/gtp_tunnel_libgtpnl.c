@@ -1,10 +1,17 @@
+#define _GNU_SOURCE
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 #include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/gtp.h>
 
 #include <libgtpnl/gtp.h>
 #include <libgtpnl/gtpnl.h>
@@ -13,20 +20,252 @@
 
 #include "log.h"
 #include "common_defs.h"
+#include "common_types.h"
 #include "gtpv1u.h"
 #include "gtpv1u_sgw_defs.h"
+#include "system_executor.h"
 
 extern struct gtp_tunnel_ops gtp_tunnel_ops;
 
+/*
+ * Tunnel operations are queued by the caller and applied by the gtp_nl thread: all the operations
+ * queued since its last wakeup (up to GTP_NL_BATCH_MAX) are sent in one datagram of netlink messages,
+ * then their ACKs are read with recvmmsg.
+ */
+#define GTP_NL_QUEUE_SIZE       65536    // operations waiting for the gtp_nl thread, power of 2
+#define GTP_NL_BATCH_MAX          256    // netlink messages per datagram
+#define GTP_NL_MSG_SIZE_MAX       128    // one GTP_CMD_NEWPDP or GTP_CMD_DELPDP message
+#define GTP_NL_ACK_SIZE_MAX      1024    // NLMSG_ERROR (original message not echoed, NETLINK_CAP_ACK)
+#define GTP_NL_RCVBUF_SIZE  (4 << 20)    // ACKs of a batch, each ACK is a separate skb
+
+typedef struct gtp_nl_op_s {
+  uint8_t                   cmd;         // GTP_CMD_NEWPDP or GTP_CMD_DELPDP
+  struct gtp_tunnel_entry   tunnel;
+} gtp_nl_op_t;
+
 static struct {
   int                 genl_id;
   struct mnl_socket  *nl;
   bool                is_enabled;
-} gtp_nl;
+  unsigned int        ifindex;          // of GTP_DEVNAME
+
+  struct mnl_socket  *batch_nl;         // used by the gtp_nl thread only
+  uint32_t            seq;
+  pthread_t           thread;
+  bool                thread_started;
+  pthread_mutex_t     lock;
+  pthread_cond_t      not_empty;
+  pthread_cond_t      not_full;
+  bool                stop;
+  uint32_t            head;
+  uint32_t            count;
+  gtp_nl_op_t        *queue;
+} gtp_nl = {
+  .lock      = PTHREAD_MUTEX_INITIALIZER,
+  .not_empty = PTHREAD_COND_INITIALIZER,
+  .not_full  = PTHREAD_COND_INITIALIZER,
+};
 
 
 #define GTP_DEVNAME "gtp0"
 
+//------------------------------------------------------------------------------
+static size_t gtp_nl_build_msg (char * const buf, const gtp_nl_op_t * const op, const uint32_t seq)
+{
+  struct nlmsghdr    *nlh = mnl_nlmsg_put_header (buf);
+  struct genlmsghdr  *genl = NULL;
+
+  nlh->nlmsg_type  = gtp_nl.genl_id;
+  nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | ((GTP_CMD_NEWPDP == op->cmd) ? NLM_F_EXCL : 0);
+  nlh->nlmsg_seq   = seq;
+  genl = mnl_nlmsg_put_extra_header (nlh, sizeof (struct genlmsghdr));
+  genl->cmd = op->cmd;
+  genl->version = 0;
+
+  mnl_attr_put_u32 (nlh, GTPA_VERSION, 1);
+  mnl_attr_put_u32 (nlh, GTPA_LINK, gtp_nl.ifindex);
+  if (GTP_CMD_NEWPDP == op->cmd) {
+    // looking at kernel/drivers/net/gtp.c: not needed for deletion
+    mnl_attr_put_u32 (nlh, GTPA_PEER_ADDRESS, op->tunnel.enb.s_addr);
+    mnl_attr_put_u32 (nlh, GTPA_MS_ADDRESS, op->tunnel.ue.s_addr);
+  }
+  mnl_attr_put_u32 (nlh, GTPA_I_TEI, op->tunnel.i_tei);
+  mnl_attr_put_u32 (nlh, GTPA_O_TEI, op->tunnel.o_tei);
+  return NLMSG_ALIGN (nlh->nlmsg_len);
+}
+
+//------------------------------------------------------------------------------
+static void gtp_nl_apply (const gtp_nl_op_t * const ops, const uint32_t nb_ops)
+{
+  static char         buf[GTP_NL_BATCH_MAX * GTP_NL_MSG_SIZE_MAX];
+  static char         acks[GTP_NL_BATCH_MAX][GTP_NL_ACK_SIZE_MAX];
+  struct mmsghdr      msgs[GTP_NL_BATCH_MAX];
+  struct iovec        iovs[GTP_NL_BATCH_MAX];
+  const uint32_t      first_seq = gtp_nl.seq + 1;
+  size_t              len = 0;
+  uint32_t            nb_acks = 0;
+  int                 fd = mnl_socket_get_fd (gtp_nl.batch_nl);
+
+  for (uint32_t i = 0; i < nb_ops; i++) {
+    len += gtp_nl_build_msg (&buf[len], &ops[i], ++gtp_nl.seq);
+  }
+  if (mnl_socket_sendto (gtp_nl.batch_nl, buf, len) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot send %u GTP tunnel operations: %s\n", nb_ops, strerror (errno));
+    return;
+  }
+
+  while (nb_acks < nb_ops) {
+    for (uint32_t i = 0; i < nb_ops - nb_acks; i++) {
+      iovs[i].iov_base = acks[i];
+      iovs[i].iov_len = GTP_NL_ACK_SIZE_MAX;
+      memset (&msgs[i], 0, sizeof (msgs[i]));
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int nb_msgs = recvmmsg (fd, msgs, nb_ops - nb_acks, MSG_WAITFORONE, NULL);
+    if (nb_msgs < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      OAILOG_ERROR (LOG_GTPV1U, "Cannot read GTP tunnel operation ACKs (%u missing): %s\n", nb_ops - nb_acks, strerror (errno));
+      return;
+    }
+    for (int m = 0; m < nb_msgs; m++) {
+      int                 ack_len = msgs[m].msg_len;
+      struct nlmsghdr    *nlh = (struct nlmsghdr *)acks[m];
+
+      for (; mnl_nlmsg_ok (nlh, ack_len); nlh = mnl_nlmsg_next (nlh, &ack_len)) {
+        uint32_t index = nlh->nlmsg_seq - first_seq;
+
+        if ((NLMSG_ERROR != nlh->nlmsg_type) || (index >= nb_ops)) {
+          continue;
+        }
+        nb_acks++;
+        const struct nlmsgerr *err = mnl_nlmsg_get_payload (nlh);
+        if (err->error) {
+          OAILOG_ERROR (LOG_GTPV1U, "ERROR in %s TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT ": %s\n",
+              (GTP_CMD_NEWPDP == ops[index].cmd) ? "adding" : "deleting",
+              ops[index].tunnel.o_tei, ops[index].tunnel.i_tei, strerror (-err->error));
+        }
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *gtp_nl_thread (void *args)
+{
+  gtp_nl_op_t        *ops = calloc (GTP_NL_BATCH_MAX, sizeof (gtp_nl_op_t));
+  uint32_t            nb_ops = 0;
+
+  while (true) {
+    pthread_mutex_lock (&gtp_nl.lock);
+    while ((!gtp_nl.count) && (!gtp_nl.stop)) {
+      pthread_cond_wait (&gtp_nl.not_empty, &gtp_nl.lock);
+    }
+    if (!gtp_nl.count) {
+      pthread_mutex_unlock (&gtp_nl.lock);
+      break;
+    }
+    for (nb_ops = 0; (nb_ops < GTP_NL_BATCH_MAX) && (gtp_nl.count); nb_ops++) {
+      ops[nb_ops] = gtp_nl.queue[gtp_nl.head];
+      gtp_nl.head = (gtp_nl.head + 1) & (GTP_NL_QUEUE_SIZE - 1);
+      gtp_nl.count--;
+    }
+    pthread_cond_broadcast (&gtp_nl.not_full);
+    pthread_mutex_unlock (&gtp_nl.lock);
+
+    gtp_nl_apply (ops, nb_ops);
+  }
+  free (ops);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int gtp_nl_queue (const uint8_t cmd, const struct gtp_tunnel_entry * const tunnels, const uint32_t nb_tunnels)
+{
+  if (!gtp_nl.thread_started) {
+    return RETURNerror;
+  }
+  pthread_mutex_lock (&gtp_nl.lock);
+  for (uint32_t i = 0; i < nb_tunnels; i++) {
+    while ((GTP_NL_QUEUE_SIZE == gtp_nl.count) && (!gtp_nl.stop)) {
+      pthread_cond_signal (&gtp_nl.not_empty);
+      pthread_cond_wait (&gtp_nl.not_full, &gtp_nl.lock);
+    }
+    if (gtp_nl.stop) {
+      pthread_mutex_unlock (&gtp_nl.lock);
+      return RETURNerror;
+    }
+    gtp_nl_op_t *op = &gtp_nl.queue[(gtp_nl.head + gtp_nl.count) & (GTP_NL_QUEUE_SIZE - 1)];
+    op->cmd = cmd;
+    op->tunnel = tunnels[i];
+    gtp_nl.count++;
+  }
+  pthread_cond_signal (&gtp_nl.not_empty);
+  pthread_mutex_unlock (&gtp_nl.lock);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void gtp_nl_stop (void)
+{
+  if (gtp_nl.thread_started) {
+    // queued operations are applied before the thread exits
+    pthread_mutex_lock (&gtp_nl.lock);
+    gtp_nl.stop = true;
+    pthread_cond_broadcast (&gtp_nl.not_empty);
+    pthread_cond_broadcast (&gtp_nl.not_full);
+    pthread_mutex_unlock (&gtp_nl.lock);
+    pthread_join (gtp_nl.thread, NULL);
+    gtp_nl.thread_started = false;
+  }
+  if (gtp_nl.batch_nl) {
+    mnl_socket_close (gtp_nl.batch_nl);
+    gtp_nl.batch_nl = NULL;
+  }
+  free (gtp_nl.queue);
+  gtp_nl.queue = NULL;
+}
+
+//------------------------------------------------------------------------------
+static int gtp_nl_start (void)
+{
+  int                 one = 1;
+  int                 rcvbuf = GTP_NL_RCVBUF_SIZE;
+
+  gtp_nl.ifindex = if_nametoindex (GTP_DEVNAME);
+  if (!gtp_nl.ifindex) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot find %s ifindex: %s\n", GTP_DEVNAME, strerror (errno));
+    return RETURNerror;
+  }
+  gtp_nl.batch_nl = mnl_socket_open (NETLINK_GENERIC);
+  if ((!gtp_nl.batch_nl) || (mnl_socket_bind (gtp_nl.batch_nl, 0, MNL_SOCKET_AUTOPID) < 0)) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create genetlink socket for tunnel batches\n");
+    goto error;
+  }
+  // ACKs do not echo the request, and a whole batch of ACKs fits in the receive buffer
+  mnl_socket_setsockopt (gtp_nl.batch_nl, NETLINK_CAP_ACK, &one, sizeof (one));
+  if (setsockopt (mnl_socket_get_fd (gtp_nl.batch_nl), SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof (rcvbuf))) {
+    setsockopt (mnl_socket_get_fd (gtp_nl.batch_nl), SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof (rcvbuf));
+  }
+  gtp_nl.queue = calloc (GTP_NL_QUEUE_SIZE, sizeof (gtp_nl_op_t));
+  gtp_nl.head = 0;
+  gtp_nl.count = 0;
+  gtp_nl.stop = false;
+  if ((!gtp_nl.queue) || (pthread_create (&gtp_nl.thread, NULL, gtp_nl_thread, NULL))) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot start GTP tunnel thread\n");
+    goto error;
+  }
+  gtp_nl.thread_started = true;
+  return RETURNok;
+
+error:
+  // no thread started, only closes the socket and frees the queue
+  gtp_nl_stop ();
+  return RETURNerror;
+}
+
 int libgtpnl_init(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int *fd1u)
 {
   // we don't need GTP v0, but interface with kernel requires 2 file descriptors
@@ -77,7 +316,7 @@ int libgtpnl_init(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int
   OAILOG_NOTICE (LOG_GTPV1U, "Using the GTP kernel mode (genl ID is %d)\n", gtp_nl.genl_id);
 
   bstring system_cmd = bformat ("ip link set dev %s mtu %u", GTP_DEVNAME, mtu);
-  int ret = system ((const char *)system_cmd->data);
+  int ret = system_executor_run (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -88,7 +327,7 @@ int libgtpnl_init(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int
   struct in_addr ue_gw;
   ue_gw.s_addr = ue_net->s_addr | htonl(1);
   system_cmd = bformat ("ip addr add %s/%u dev %s", inet_ntoa(ue_gw), mask, GTP_DEVNAME);
-  ret = system ((const char *)system_cmd->data);
+  ret = system_executor_run (bdata(system_cmd));
   if (ret) {
     OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
     bdestroy(system_cmd);
@@ -104,86 +343,90 @@ int libgtpnl_init(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int
     return RETURNerror;
   }
 
+  if (gtp_nl_start() != RETURNok) {
+    return RETURNerror;
+  }
+
   OAILOG_NOTICE (LOG_GTPV1U, "GTP kernel configured\n");
 
   return RETURNok;
 }
 
+int libgtpnl_add_ue_net(struct in_addr *ue_net, uint32_t mask)
+{
+  OAILOG_DEBUG (LOG_GTPV1U, "Setting route to reach UE net %s/%u via %s\n", inet_ntoa(*ue_net), mask, GTP_DEVNAME);
+
+  if (gtp_dev_config(GTP_DEVNAME, ue_net, mask) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot add route to reach network\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
 int libgtpnl_uninit(void)
 {
   if (!gtp_nl.is_enabled)
     return -1;
 
+  gtp_nl_stop();
   return gtp_dev_destroy(GTP_DEVNAME);
 }
 
 int libgtpnl_reset(void)
 {
   int rv = 0;
-  rv = system ("rmmod gtp");
-  rv = system ("modprobe gtp");
+  rv = system_executor_run ("rmmod gtp");
+  rv = system_executor_run ("modprobe gtp");
   return rv;
 }
 
 int libgtpnl_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei)
 {
-  struct gtp_tunnel *t;
-  int ret;
+  struct gtp_tunnel_entry tunnel = {.ue = ue, .enb = enb, .i_tei = i_tei, .o_tei = o_tei};
 
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
-  t = gtp_tunnel_alloc();
-  if (t == NULL)
-    return RETURNerror;
-
-
-  gtp_tunnel_set_ifidx(t, if_nametoindex(GTP_DEVNAME));
-  gtp_tunnel_set_version(t, 1);
-  gtp_tunnel_set_ms_ip4(t, &ue);
-  gtp_tunnel_set_sgsn_ip4(t, &enb);
-  gtp_tunnel_set_i_tei(t, i_tei);
-  gtp_tunnel_set_o_tei(t, o_tei);
-
-  ret = gtp_add_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
-  gtp_tunnel_free(t);
-
-  return ret;
+  return gtp_nl_queue(GTP_CMD_NEWPDP, &tunnel, 1);
 }
 
 int libgtpnl_del_tunnel(uint32_t i_tei, uint32_t o_tei)
 {
-  struct gtp_tunnel *t;
-  int ret;
+  struct gtp_tunnel_entry tunnel = {.i_tei = i_tei, .o_tei = o_tei};
 
   if (!gtp_nl.is_enabled)
     return RETURNok;
 
-  t = gtp_tunnel_alloc();
-  if (t == NULL)
-    return RETURNerror;
+  return gtp_nl_queue(GTP_CMD_DELPDP, &tunnel, 1);
+}
 
-  gtp_tunnel_set_ifidx(t, if_nametoindex(GTP_DEVNAME));
-  gtp_tunnel_set_version(t, 1);
-  // looking at kernel/drivers/net/gtp.c: not needed gtp_tunnel_set_ms_ip4(t, &ue);
-  // looking at kernel/drivers/net/gtp.c: not needed gtp_tunnel_set_sgsn_ip4(t, &enb);
-  gtp_tunnel_set_i_tei(t, i_tei);
-  gtp_tunnel_set_o_tei(t, o_tei);
+int libgtpnl_add_tunnels(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels)
+{
+  if (!gtp_nl.is_enabled)
+    return RETURNok;
+
+  return gtp_nl_queue(GTP_CMD_NEWPDP, tunnels, nb_tunnels);
+}
 
-  ret = gtp_del_tunnel(gtp_nl.genl_id, gtp_nl.nl, t);
-  gtp_tunnel_free(t);
+int libgtpnl_del_tunnels(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels)
+{
+  if (!gtp_nl.is_enabled)
+    return RETURNok;
 
-  return ret;
+  return gtp_nl_queue(GTP_CMD_DELPDP, tunnels, nb_tunnels);
 }
 
 static const struct gtp_tunnel_ops libgtpnl_ops = {
   .init         = libgtpnl_init,
+  .add_ue_net   = libgtpnl_add_ue_net,
   .uninit       = libgtpnl_uninit,
   .reset        = libgtpnl_reset,
   .add_tunnel   = libgtpnl_add_tunnel,
   .del_tunnel   = libgtpnl_del_tunnel,
+  .add_tunnels  = libgtpnl_add_tunnels,
+  .del_tunnels  = libgtpnl_del_tunnels,
 };
 
-const struct gtp_tunnel_ops *gtp_tunnel_ops_init(void) {
+const struct gtp_tunnel_ops *gtp_tunnel_ops_init_libgtpnl(void) {
   return &libgtpnl_ops;
 }
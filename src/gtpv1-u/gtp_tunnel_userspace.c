@@ -0,0 +1,508 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtp_tunnel_userspace.c
+  \brief Userspace GTP-U data plane, alternative to the kernel gtp module.
+  Each worker thread owns a UDP socket bound to the S1-U address (SO_REUSEPORT) and a queue of the
+  multi-queue TUN device GTP_DEVNAME, and processes its packets to completion: a batch read with
+  recvmmsg on S1-U is decapsulated and written to the TUN queue, a batch read from the TUN queue is
+  encapsulated and sent with one sendmmsg.
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "gtpv1u.h"
+#include "gtpv1u_sgw_defs.h"
+#include "gtpu_forwarder.h"
+#include "system_executor.h"
+
+#define GTP_DEVNAME "gtp0"
+
+#define GTPU_US_WORKER_MAX            64    // worker threads
+#define GTPU_US_BATCH_MAX             32    // packets read (and sent) at once on each side
+#define GTPU_US_HEADROOM              GTPU_HEADER_OVERHEAD_MAX    // room for the G-PDU header before SGi packets
+#define GTPU_US_POLL_TIMEOUT_MS      100    // stop flag check period
+#define GTPU_US_NB_TUNNELS_HINT    65536
+
+typedef struct gtpu_us_worker_s {
+  uint32_t                                index;
+  pthread_t                               thread;
+  bool                                    thread_started;
+  int                                     udp_fd;
+  int                                     tun_fd;
+  uint8_t                                *buffers;       // GTPU_US_BATCH_MAX buffers of buffer_size bytes
+  struct mmsghdr                          rx_msgs[GTPU_US_BATCH_MAX];
+  struct iovec                            rx_iovs[GTPU_US_BATCH_MAX];
+  struct sockaddr_in                      rx_addrs[GTPU_US_BATCH_MAX];
+  struct mmsghdr                          tx_msgs[GTPU_US_BATCH_MAX];
+  struct iovec                            tx_iovs[GTPU_US_BATCH_MAX];
+  struct sockaddr_in                      tx_addrs[GTPU_US_BATCH_MAX];
+  gtpu_fwd_stats_t                        stats;
+} gtpu_us_worker_t;
+
+static struct {
+  bool                                    is_enabled;
+  struct in_addr                          s1u_address;
+  uint16_t                                port;
+  uint32_t                                nb_workers;
+  uint32_t                                buffer_size;
+  struct in_addr                          ue_net;          // first UE IP pool, destination of the SDF filters
+  uint32_t                                ue_prefix_len;   // without remote address
+  volatile bool                           stop;
+  gtpu_forwarder_t                       *fwd;
+  gtpu_us_worker_t                        workers[GTPU_US_WORKER_MAX];
+} gtpu_us = {
+  .nb_workers = 1,
+  .port       = GTPV1U_UDP_PORT,
+};
+
+//------------------------------------------------------------------------------
+static int gtpu_us_system(bstring system_cmd)
+{
+  int ret = system_executor_run (bdata(system_cmd));
+
+  if (ret) {
+    OAILOG_ERROR (LOG_GTPV1U, "ERROR in system command %s: %d at %s:%u\n", bdata(system_cmd), ret, __FILE__, __LINE__);
+  }
+  bdestroy(system_cmd);
+  return ret ? RETURNerror : RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_tun_open(void)
+{
+  struct ifreq                            ifr = {0};
+  int                                     fd = open("/dev/net/tun", O_RDWR | O_CLOEXEC);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot open /dev/net/tun: %s\n", strerror(errno));
+    return -1;
+  }
+  // each worker attaches its own queue to the device
+  ifr.ifr_flags = IFF_TUN | IFF_NO_PI | IFF_MULTI_QUEUE;
+  strncpy(ifr.ifr_name, GTP_DEVNAME, IFNAMSIZ - 1);
+  if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot attach a queue to TUN device %s: %s\n", GTP_DEVNAME, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static int gtpu_us_udp_open(void)
+{
+  struct sockaddr_in                      addr = {
+    .sin_family = AF_INET,
+    .sin_port   = htons(gtpu_us.port),
+    .sin_addr   = gtpu_us.s1u_address,
+  };
+  int                                     one = 1;
+  int                                     fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+  if (fd < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create S1-U socket: %s\n", strerror(errno));
+    return -1;
+  }
+  if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "SO_REUSEPORT on S1-U socket: %s\n", strerror(errno));
+    close(fd);
+    return -1;
+  }
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot bind S1-U socket to %s:%u: %s\n", inet_ntoa(gtpu_us.s1u_address), gtpu_us.port, strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_send(gtpu_us_worker_t * const worker, const uint32_t nb_msgs)
+{
+  uint32_t                                sent = 0;
+  int                                     rc = 0;
+
+  while (sent < nb_msgs) {
+    rc = sendmmsg(worker->udp_fd, &worker->tx_msgs[sent], nb_msgs - sent, 0);
+    if (rc < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      // socket buffer full or unreachable eNB: the rest of the batch is lost
+      worker->stats.drop_io += nb_msgs - sent;
+      return;
+    }
+    sent += rc;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_add_tx(gtpu_us_worker_t * const worker, const uint32_t nb_tx, uint8_t * const data, const uint32_t len, const struct in_addr peer)
+{
+  worker->tx_iovs[nb_tx].iov_base = data;
+  worker->tx_iovs[nb_tx].iov_len = len;
+  worker->tx_addrs[nb_tx].sin_family = AF_INET;
+  worker->tx_addrs[nb_tx].sin_port = htons(gtpu_us.port);
+  worker->tx_addrs[nb_tx].sin_addr = peer;
+  worker->tx_msgs[nb_tx].msg_hdr.msg_name = &worker->tx_addrs[nb_tx];
+  worker->tx_msgs[nb_tx].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  worker->tx_msgs[nb_tx].msg_hdr.msg_iov = &worker->tx_iovs[nb_tx];
+  worker->tx_msgs[nb_tx].msg_hdr.msg_iovlen = 1;
+}
+
+//------------------------------------------------------------------------------
+// S1-U -> SGi
+static void gtpu_us_uplink(gtpu_us_worker_t * const worker)
+{
+  uint8_t                                *out[GTPU_US_BATCH_MAX];
+  uint32_t                                out_len[GTPU_US_BATCH_MAX];
+  gtpu_fwd_action_t                       action[GTPU_US_BATCH_MAX];
+  uint32_t                                nb_tx = 0;
+  int                                     nb_rx = 0;
+
+  for (int i = 0; i < GTPU_US_BATCH_MAX; i++) {
+    worker->rx_iovs[i].iov_base = &worker->buffers[i * gtpu_us.buffer_size];
+    worker->rx_iovs[i].iov_len = gtpu_us.buffer_size;
+    worker->rx_msgs[i].msg_hdr.msg_name = &worker->rx_addrs[i];
+    worker->rx_msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    worker->rx_msgs[i].msg_hdr.msg_iov = &worker->rx_iovs[i];
+    worker->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+    worker->rx_msgs[i].msg_hdr.msg_control = NULL;
+    worker->rx_msgs[i].msg_hdr.msg_controllen = 0;
+    worker->rx_msgs[i].msg_hdr.msg_flags = 0;
+  }
+  nb_rx = recvmmsg(worker->udp_fd, worker->rx_msgs, GTPU_US_BATCH_MAX, MSG_DONTWAIT, NULL);
+  if (nb_rx <= 0) {
+    return;
+  }
+
+  gtpu_forwarder_read_lock(gtpu_us.fwd);
+  for (int i = 0; i < nb_rx; i++) {
+    if (worker->rx_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      worker->stats.drop_malformed++;
+      action[i] = GTPU_FWD_DROP;
+      continue;
+    }
+    action[i] = gtpu_forwarder_uplink(gtpu_us.fwd, worker->rx_iovs[i].iov_base, worker->rx_msgs[i].msg_len, &out[i], &out_len[i], &worker->stats);
+  }
+  gtpu_forwarder_read_unlock(gtpu_us.fwd);
+
+  for (int i = 0; i < nb_rx; i++) {
+    if (GTPU_FWD_TO_SGI == action[i]) {
+      if (write(worker->tun_fd, out[i], out_len[i]) < 0) {
+        worker->stats.drop_io++;
+      }
+    } else if (GTPU_FWD_TO_S1U == action[i]) {
+      gtpu_us_add_tx(worker, nb_tx++, out[i], out_len[i], worker->rx_addrs[i].sin_addr);
+    }
+  }
+  if (nb_tx) {
+    gtpu_us_send(worker, nb_tx);
+  }
+}
+
+//------------------------------------------------------------------------------
+// SGi -> S1-U
+static void gtpu_us_downlink(gtpu_us_worker_t * const worker)
+{
+  uint32_t                                len[GTPU_US_BATCH_MAX];
+  uint8_t                                *out = NULL;
+  uint32_t                                out_len = 0;
+  struct in_addr                          enb = {.s_addr = INADDR_ANY};
+  uint32_t                                nb_rx = 0;
+  uint32_t                                nb_tx = 0;
+  ssize_t                                 rc = 0;
+
+  // TUN queues have no batch read
+  for (nb_rx = 0; nb_rx < GTPU_US_BATCH_MAX; nb_rx++) {
+    rc = read(worker->tun_fd, &worker->buffers[nb_rx * gtpu_us.buffer_size + GTPU_US_HEADROOM], gtpu_us.buffer_size - GTPU_US_HEADROOM);
+    if (rc <= 0) {
+      break;
+    }
+    len[nb_rx] = (uint32_t)rc;
+  }
+  if (!nb_rx) {
+    return;
+  }
+
+  gtpu_forwarder_read_lock(gtpu_us.fwd);
+  for (uint32_t i = 0; i < nb_rx; i++) {
+    if (GTPU_FWD_TO_S1U == gtpu_forwarder_downlink(gtpu_us.fwd, &worker->buffers[i * gtpu_us.buffer_size + GTPU_US_HEADROOM], len[i],
+                                                   &out, &out_len, &enb, &worker->stats)) {
+      gtpu_us_add_tx(worker, nb_tx++, out, out_len, enb);
+    }
+  }
+  gtpu_forwarder_read_unlock(gtpu_us.fwd);
+
+  if (nb_tx) {
+    gtpu_us_send(worker, nb_tx);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void *gtpu_us_thread(void *args)
+{
+  gtpu_us_worker_t                       *worker = (gtpu_us_worker_t *)args;
+  struct pollfd                           fds[2] = {
+    {.fd = worker->udp_fd, .events = POLLIN},
+    {.fd = worker->tun_fd, .events = POLLIN},
+  };
+  char                                    name[16];
+
+  snprintf(name, sizeof(name), "gtpu_us_%u", worker->index);
+  pthread_setname_np(pthread_self(), name);
+
+  while (!gtpu_us.stop) {
+    if (poll(fds, 2, GTPU_US_POLL_TIMEOUT_MS) <= 0) {
+      continue;
+    }
+    if (fds[0].revents & POLLIN) {
+      gtpu_us_uplink(worker);
+    }
+    if (fds[1].revents & POLLIN) {
+      gtpu_us_downlink(worker);
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_us_close_workers(void)
+{
+  gtpu_us.stop = true;
+  for (uint32_t i = 0; i < gtpu_us.nb_workers; i++) {
+    gtpu_us_worker_t *worker = &gtpu_us.workers[i];
+
+    if (worker->thread_started) {
+      pthread_join(worker->thread, NULL);
+      worker->thread_started = false;
+      OAILOG_INFO (LOG_GTPV1U, "GTP-U worker %u: UL %"PRIu64" packets %"PRIu64" bytes, DL %"PRIu64" packets %"PRIu64" bytes, "
+          "%"PRIu64" echo requests, dropped: %"PRIu64" malformed %"PRIu64" unsupported %"PRIu64" unknown TEID "
+          "%"PRIu64" spoofed %"PRIu64" unknown UE %"PRIu64" I/O\n",
+          i, worker->stats.ul_packets, worker->stats.ul_bytes, worker->stats.dl_packets, worker->stats.dl_bytes,
+          worker->stats.echo_requests, worker->stats.drop_malformed, worker->stats.drop_unsupported, worker->stats.drop_unknown_teid,
+          worker->stats.drop_spoofed, worker->stats.drop_unknown_ue, worker->stats.drop_io);
+    }
+    if (worker->udp_fd >= 0) {
+      close(worker->udp_fd);
+    }
+    if (worker->tun_fd >= 0) {
+      close(worker->tun_fd);
+    }
+    worker->udp_fd = -1;
+    worker->tun_fd = -1;
+    free_wrapper((void**)&worker->buffers);
+  }
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_init(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int *fd1u)
+{
+  struct in_addr                          ue_gw = {.s_addr = INADDR_ANY};
+
+  // G-PDUs received carry at most GTPU_HEADER_OVERHEAD_MAX bytes of header, packets sent need GTPU_US_HEADROOM
+  gtpu_us.buffer_size = ((mtu > 1500) ? mtu : 1500) + GTPU_US_HEADROOM + GTPU_HEADER_OVERHEAD_MAX;
+  gtpu_us.stop = false;
+  gtpu_us.ue_net = *ue_net;
+  gtpu_us.ue_prefix_len = mask;
+  gtpu_us.fwd = gtpu_forwarder_create("GTP-U", GTPU_US_NB_TUNNELS_HINT, 0);
+  if (!gtpu_us.fwd) {
+    OAILOG_ERROR (LOG_GTPV1U, "Cannot create GTP-U forwarding tables\n");
+    return RETURNerror;
+  }
+  for (uint32_t i = 0; i < gtpu_us.nb_workers; i++) {
+    gtpu_us.workers[i].udp_fd = -1;
+    gtpu_us.workers[i].tun_fd = -1;
+  }
+  for (uint32_t i = 0; i < gtpu_us.nb_workers; i++) {
+    gtpu_us_worker_t *worker = &gtpu_us.workers[i];
+
+    worker->index = i;
+    worker->tun_fd = gtpu_us_tun_open();
+    worker->udp_fd = gtpu_us_udp_open();
+    worker->buffers = malloc((size_t)GTPU_US_BATCH_MAX * gtpu_us.buffer_size);
+    memset(&worker->stats, 0, sizeof(worker->stats));
+    if ((worker->tun_fd < 0) || (worker->udp_fd < 0) || !worker->buffers) {
+      goto error;
+    }
+  }
+
+  ue_gw.s_addr = ue_net->s_addr | htonl(1);
+  if ((RETURNok != gtpu_us_system(bformat ("ip link set dev %s mtu %u", GTP_DEVNAME, mtu)))
+      || (RETURNok != gtpu_us_system(bformat ("ip addr add %s/%u dev %s", inet_ntoa(ue_gw), mask, GTP_DEVNAME)))
+      || (RETURNok != gtpu_us_system(bformat ("ip link set dev %s up", GTP_DEVNAME)))) {
+    goto error;
+  }
+
+  for (uint32_t i = 0; i < gtpu_us.nb_workers; i++) {
+    if (pthread_create(&gtpu_us.workers[i].thread, NULL, gtpu_us_thread, &gtpu_us.workers[i])) {
+      OAILOG_ERROR (LOG_GTPV1U, "Cannot create GTP-U worker thread %u\n", i);
+      goto error;
+    }
+    gtpu_us.workers[i].thread_started = true;
+  }
+  // not used by the userspace data plane
+  *fd0 = -1;
+  *fd1u = gtpu_us.workers[0].udp_fd;
+  // tunnels and filters are accepted from now on
+  gtpu_us.is_enabled = true;
+  OAILOG_NOTICE (LOG_GTPV1U, "GTP userspace mode configured: %u workers on %s:%u and %s\n",
+      gtpu_us.nb_workers, inet_ntoa(gtpu_us.s1u_address), gtpu_us.port, GTP_DEVNAME);
+  return RETURNok;
+
+error:
+  // joins the workers already started, closes the sockets and the TUN queues (the device goes with the last one)
+  gtpu_us_close_workers();
+  gtpu_forwarder_destroy(&gtpu_us.fwd);
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_add_ue_net(struct in_addr *ue_net, uint32_t mask)
+{
+  OAILOG_DEBUG (LOG_GTPV1U, "Setting route to reach UE net %s/%u via %s\n", inet_ntoa(*ue_net), mask, GTP_DEVNAME);
+  return gtpu_us_system(bformat ("ip route add %s/%u dev %s", inet_ntoa(*ue_net), mask, GTP_DEVNAME));
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_uninit(void)
+{
+  if (!gtpu_us.is_enabled)
+    return -1;
+
+  // the TUN device disappears with its last queue
+  gtpu_us_close_workers();
+  gtpu_forwarder_destroy(&gtpu_us.fwd);
+  gtpu_us.is_enabled = false;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_reset(void)
+{
+  // no state survives the process
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_add_tunnel(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei)
+{
+  struct gtp_tunnel_entry tunnel = {.ue = ue, .enb = enb, .i_tei = i_tei, .o_tei = o_tei};
+
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_add_tunnels(gtpu_us.fwd, &tunnel, 1);
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_del_tunnel(uint32_t i_tei, uint32_t o_tei)
+{
+  struct gtp_tunnel_entry tunnel = {.i_tei = i_tei, .o_tei = o_tei};
+
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_del_tunnels(gtpu_us.fwd, &tunnel, 1);
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_add_tunnels(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_add_tunnels(gtpu_us.fwd, tunnels, nb_tunnels);
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_del_tunnels(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_del_tunnels(gtpu_us.fwd, tunnels, nb_tunnels);
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_add_sdf_filter(const struct packet_filter_s *filter, uint32_t sdf_id)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_add_sdf_filter(gtpu_us.fwd, filter, gtpu_us.ue_net, gtpu_us.ue_prefix_len, sdf_id);
+}
+
+//------------------------------------------------------------------------------
+int gtpu_us_add_bearer_sdf(uint32_t i_tei, uint32_t sdf_id)
+{
+  if (!gtpu_us.is_enabled)
+    return RETURNok;
+
+  return gtpu_forwarder_add_bearer_sdf(gtpu_us.fwd, i_tei, sdf_id);
+}
+
+static const struct gtp_tunnel_ops gtpu_us_ops = {
+  .init         = gtpu_us_init,
+  .add_ue_net   = gtpu_us_add_ue_net,
+  .uninit       = gtpu_us_uninit,
+  .reset        = gtpu_us_reset,
+  .add_tunnel   = gtpu_us_add_tunnel,
+  .del_tunnel   = gtpu_us_del_tunnel,
+  .add_tunnels  = gtpu_us_add_tunnels,
+  .del_tunnels  = gtpu_us_del_tunnels,
+  .add_sdf_filter = gtpu_us_add_sdf_filter,
+  .add_bearer_sdf = gtpu_us_add_bearer_sdf,
+};
+
+//------------------------------------------------------------------------------
+const struct gtp_tunnel_ops *gtp_tunnel_ops_init_userspace(const struct in_addr * const s1u_address, const uint16_t port, const uint32_t nb_threads)
+{
+  gtpu_us.s1u_address = *s1u_address;
+  gtpu_us.port = port ? port : GTPV1U_UDP_PORT;
+  gtpu_us.nb_workers = (nb_threads > GTPU_US_WORKER_MAX) ? GTPU_US_WORKER_MAX : ((nb_threads) ? nb_threads : 1);
+  return &gtpu_us_ops;
+}
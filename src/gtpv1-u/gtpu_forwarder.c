@@ -0,0 +1,456 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpu_forwarder.c
+  \brief GTP-U forwarding tables and per packet processing of the userspace data plane (3GPP TS 29.281).
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "hashtable.h"
+#include "3gpp_24.008.h"
+#include "gtpv1u.h"
+#include "sdf_classifier.h"
+#include "gtpu_forwarder.h"
+
+#define GTPU_FLAGS_VERSION_MASK    0xE0
+#define GTPU_FLAGS_VERSION_1       0x20
+#define GTPU_FLAGS_PT              0x10
+#define GTPU_FLAGS_E               0x04
+#define GTPU_FLAGS_S               0x02
+#define GTPU_FLAGS_PN              0x01
+#define GTPU_IE_RECOVERY             14
+
+#define IPV4_HEADER_MIN_SIZE         20
+
+// consecutive UE addresses in consecutive buckets
+#define GTPU_UE_KEY(aDDR)            ((hash_key_t)ntohl((aDDR).s_addr))
+
+// Bearers sharing a UE address are chained, the head of the chain is in the downlink table
+typedef struct gtpu_bearer_s {
+  struct gtp_tunnel_entry                 tunnel;
+  struct gtpu_bearer_s                   *next_same_ue;
+  uint32_t                                nb_sdf;
+  uint32_t                                sdf_id[TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX];
+} gtpu_bearer_t;
+
+struct gtpu_forwarder_s {
+  char                                    name[32];
+  uint8_t                                 restart_counter;
+  pthread_rwlock_t                        lock;
+  hash_table_t                           *uplink;       // i_tei -> gtpu_bearer_t, owns the bearers
+  hash_table_t                           *downlink;     // UE IPv4 address (host order) -> first gtpu_bearer_t of the UE
+  sdf_classifier_t                       *sdf;          // downlink SDF filters of all UEs
+};
+
+//------------------------------------------------------------------------------
+gtpu_forwarder_t *gtpu_forwarder_create(const char * const name, const uint32_t nb_tunnels_hint, const uint8_t restart_counter)
+{
+  gtpu_forwarder_t                       *fwd = calloc(1, sizeof(gtpu_forwarder_t));
+  pthread_rwlockattr_t                    attr;
+  hash_size_t                             size = (nb_tunnels_hint > 64) ? nb_tunnels_hint : 64;
+  bstring                                 name_b = NULL;
+
+  if (!fwd) {
+    return NULL;
+  }
+  snprintf(fwd->name, sizeof(fwd->name), "%s", name);
+  fwd->restart_counter = restart_counter;
+  name_b = bformat("%s uplink", fwd->name);
+  fwd->uplink = hashtable_create(size, NULL, NULL, name_b);
+  bdestroy_wrapper(&name_b);
+  name_b = bformat("%s downlink", fwd->name);
+  fwd->downlink = hashtable_create(size, NULL, hash_free_int_func, name_b);
+  bdestroy_wrapper(&name_b);
+  fwd->sdf = sdf_classifier_create();
+  if (!fwd->uplink || !fwd->downlink || !fwd->sdf) {
+    gtpu_forwarder_destroy(&fwd);
+    return NULL;
+  }
+  // Workers hold the read lock most of the time, tunnel updates must not starve
+  pthread_rwlockattr_init(&attr);
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&fwd->lock, &attr);
+  pthread_rwlockattr_destroy(&attr);
+  return fwd;
+}
+
+//------------------------------------------------------------------------------
+void gtpu_forwarder_destroy(gtpu_forwarder_t ** const fwd)
+{
+  if (!fwd || !*fwd) {
+    return;
+  }
+  if ((*fwd)->downlink) {
+    hashtable_destroy((*fwd)->downlink);
+  }
+  if ((*fwd)->uplink) {
+    hashtable_destroy((*fwd)->uplink);
+  }
+  sdf_classifier_destroy(&(*fwd)->sdf);
+  pthread_rwlock_destroy(&(*fwd)->lock);
+  free_wrapper((void**)fwd);
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_forwarder_link_ue(gtpu_forwarder_t * const fwd, gtpu_bearer_t * const bearer)
+{
+  gtpu_bearer_t                          *first = NULL;
+
+  if (INADDR_ANY == bearer->tunnel.ue.s_addr) {
+    return;
+  }
+  if (HASH_TABLE_OK == hashtable_get(fwd->downlink, GTPU_UE_KEY(bearer->tunnel.ue), (void**)&first)) {
+    // the first bearer of the UE keeps the downlink traffic
+    bearer->next_same_ue = first->next_same_ue;
+    first->next_same_ue = bearer;
+  } else {
+    bearer->next_same_ue = NULL;
+    hashtable_insert(fwd->downlink, GTPU_UE_KEY(bearer->tunnel.ue), bearer);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void gtpu_forwarder_unlink_ue(gtpu_forwarder_t * const fwd, gtpu_bearer_t * const bearer)
+{
+  gtpu_bearer_t                          *first = NULL;
+  gtpu_bearer_t                          *removed = NULL;
+
+  if (INADDR_ANY == bearer->tunnel.ue.s_addr) {
+    return;
+  }
+  if (HASH_TABLE_OK != hashtable_get(fwd->downlink, GTPU_UE_KEY(bearer->tunnel.ue), (void**)&first)) {
+    return;
+  }
+  if (first == bearer) {
+    hashtable_remove(fwd->downlink, GTPU_UE_KEY(bearer->tunnel.ue), (void**)&removed);
+    if (bearer->next_same_ue) {
+      hashtable_insert(fwd->downlink, GTPU_UE_KEY(bearer->tunnel.ue), bearer->next_same_ue);
+    }
+  } else {
+    while (first->next_same_ue && (first->next_same_ue != bearer)) {
+      first = first->next_same_ue;
+    }
+    if (first->next_same_ue == bearer) {
+      first->next_same_ue = bearer->next_same_ue;
+    }
+  }
+  bearer->next_same_ue = NULL;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_forwarder_add_tunnels(gtpu_forwarder_t * const fwd, const struct gtp_tunnel_entry * const tunnels, const uint32_t nb_tunnels)
+{
+  gtpu_bearer_t                          *bearer = NULL;
+  int                                     rc = RETURNok;
+
+  pthread_rwlock_wrlock(&fwd->lock);
+  for (uint32_t i = 0; i < nb_tunnels; i++) {
+    if (HASH_TABLE_OK == hashtable_get(fwd->uplink, (hash_key_t)tunnels[i].i_tei, (void**)&bearer)) {
+      // eNB or UE address change of an existing bearer, its SDFs are kept
+      gtpu_forwarder_unlink_ue(fwd, bearer);
+      bearer->tunnel = tunnels[i];
+      gtpu_forwarder_link_ue(fwd, bearer);
+      continue;
+    }
+    bearer = calloc(1, sizeof(gtpu_bearer_t));
+    if (!bearer) {
+      OAILOG_ERROR (LOG_GTPV1U, "%s: cannot allocate tunnel " TEID_FMT "\n", fwd->name, tunnels[i].i_tei);
+      rc = RETURNerror;
+      continue;
+    }
+    bearer->tunnel = tunnels[i];
+    hashtable_insert(fwd->uplink, (hash_key_t)bearer->tunnel.i_tei, bearer);
+    gtpu_forwarder_link_ue(fwd, bearer);
+  }
+  pthread_rwlock_unlock(&fwd->lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_forwarder_del_tunnels(gtpu_forwarder_t * const fwd, const struct gtp_tunnel_entry * const tunnels, const uint32_t nb_tunnels)
+{
+  gtpu_bearer_t                          *bearer = NULL;
+  int                                     rc = RETURNok;
+
+  pthread_rwlock_wrlock(&fwd->lock);
+  for (uint32_t i = 0; i < nb_tunnels; i++) {
+    if (HASH_TABLE_OK != hashtable_remove(fwd->uplink, (hash_key_t)tunnels[i].i_tei, (void**)&bearer)) {
+      OAILOG_WARNING (LOG_GTPV1U, "%s: no tunnel " TEID_FMT " to delete\n", fwd->name, tunnels[i].i_tei);
+      rc = RETURNerror;
+      continue;
+    }
+    gtpu_forwarder_unlink_ue(fwd, bearer);
+    free_wrapper((void**)&bearer);
+  }
+  pthread_rwlock_unlock(&fwd->lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_forwarder_add_sdf_filter(gtpu_forwarder_t * const fwd, const struct packet_filter_s * const filter,
+                                  const struct in_addr ue_net, const uint32_t ue_prefix_len, const uint32_t sdf_id)
+{
+  sdf_rule_t                              rule;
+  int                                     rc = RETURNerror;
+
+  if (RETURNok != sdf_classifier_rule_from_packet_filter(filter, ntohl(ue_net.s_addr), ue_prefix_len, &rule)) {
+    OAILOG_WARNING (LOG_GTPV1U, "%s: unsupported packet filter for SDF %u\n", fwd->name, sdf_id);
+    return RETURNerror;
+  }
+  pthread_rwlock_wrlock(&fwd->lock);
+  rc = sdf_classifier_add_rule(fwd->sdf, &rule, sdf_id, filter->eval_precedence);
+  pthread_rwlock_unlock(&fwd->lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int gtpu_forwarder_add_bearer_sdf(gtpu_forwarder_t * const fwd, const teid_t i_tei, const uint32_t sdf_id)
+{
+  gtpu_bearer_t                          *bearer = NULL;
+  int                                     rc = RETURNerror;
+
+  pthread_rwlock_wrlock(&fwd->lock);
+  if ((HASH_TABLE_OK == hashtable_get(fwd->uplink, (hash_key_t)i_tei, (void**)&bearer))
+      && (bearer->nb_sdf < TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX)) {
+    bearer->sdf_id[bearer->nb_sdf++] = sdf_id;
+    rc = RETURNok;
+  }
+  pthread_rwlock_unlock(&fwd->lock);
+  if (RETURNok != rc) {
+    OAILOG_WARNING (LOG_GTPV1U, "%s: cannot bind SDF %u to tunnel " TEID_FMT "\n", fwd->name, sdf_id, i_tei);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+uint32_t gtpu_forwarder_nb_tunnels(gtpu_forwarder_t * const fwd)
+{
+  uint32_t                                nb = 0;
+
+  pthread_rwlock_rdlock(&fwd->lock);
+  nb = fwd->uplink->num_elements;
+  pthread_rwlock_unlock(&fwd->lock);
+  return nb;
+}
+
+//------------------------------------------------------------------------------
+void gtpu_forwarder_read_lock(gtpu_forwarder_t * const fwd)
+{
+  pthread_rwlock_rdlock(&fwd->lock);
+}
+
+//------------------------------------------------------------------------------
+void gtpu_forwarder_read_unlock(gtpu_forwarder_t * const fwd)
+{
+  pthread_rwlock_unlock(&fwd->lock);
+}
+
+//------------------------------------------------------------------------------
+static gtpu_fwd_action_t gtpu_forwarder_echo_response(
+  gtpu_forwarder_t * const fwd,
+  uint8_t * const msg,
+  const uint32_t len,
+  uint8_t ** const out,
+  uint32_t * const out_len)
+{
+  // The sequence number of the request is kept in place (TS 29.281 7.2.1, S flag set in Echo messages)
+  if ((len < 12) || !(msg[0] & GTPU_FLAGS_S)) {
+    msg[8] = 0;
+    msg[9] = 0;
+  }
+  msg[0] = GTPU_FLAGS_VERSION_1 | GTPU_FLAGS_PT | GTPU_FLAGS_S;
+  msg[1] = GTPU_MSG_TYPE_ECHO_RESPONSE;
+  msg[2] = 0;
+  msg[3] = GTPU_FWD_ECHO_RESPONSE_SIZE - GTPU_FWD_HEADER_SIZE;
+  memset(&msg[4], 0, 4);
+  msg[10] = 0;
+  msg[11] = 0;
+  msg[12] = GTPU_IE_RECOVERY;
+  msg[13] = fwd->restart_counter;
+  *out = msg;
+  *out_len = GTPU_FWD_ECHO_RESPONSE_SIZE;
+  return GTPU_FWD_TO_S1U;
+}
+
+//------------------------------------------------------------------------------
+gtpu_fwd_action_t gtpu_forwarder_uplink(
+  gtpu_forwarder_t * const fwd,
+  uint8_t * const msg,
+  const uint32_t len,
+  uint8_t ** const out,
+  uint32_t * const out_len,
+  gtpu_fwd_stats_t * const stats)
+{
+  gtpu_bearer_t                          *bearer = NULL;
+  uint32_t                                msg_len = 0;
+  uint32_t                                offset = GTPU_FWD_HEADER_SIZE;
+  uint32_t                                teid = 0;
+  uint8_t                                 next_ext = 0;
+
+  if ((len < GTPU_FWD_HEADER_SIZE) || ((msg[0] & (GTPU_FLAGS_VERSION_MASK | GTPU_FLAGS_PT)) != (GTPU_FLAGS_VERSION_1 | GTPU_FLAGS_PT))) {
+    stats->drop_malformed++;
+    return GTPU_FWD_DROP;
+  }
+  msg_len = GTPU_FWD_HEADER_SIZE + (((uint32_t)msg[2] << 8) | msg[3]);
+  if (msg_len > len) {
+    stats->drop_malformed++;
+    return GTPU_FWD_DROP;
+  }
+  if (msg[0] & (GTPU_FLAGS_E | GTPU_FLAGS_S | GTPU_FLAGS_PN)) {
+    offset = 12;
+    if (msg_len < offset) {
+      stats->drop_malformed++;
+      return GTPU_FWD_DROP;
+    }
+    next_ext = (msg[0] & GTPU_FLAGS_E) ? msg[11] : 0;
+    // extension headers: length in 4 octets units, next extension header type in the last octet
+    while (next_ext) {
+      if ((offset >= msg_len) || (0 == msg[offset]) || (offset + 4 * (uint32_t)msg[offset] > msg_len)) {
+        stats->drop_malformed++;
+        return GTPU_FWD_DROP;
+      }
+      offset += 4 * (uint32_t)msg[offset];
+      next_ext = msg[offset - 1];
+    }
+  }
+
+  switch (msg[1]) {
+  case GTPU_MSG_TYPE_G_PDU:
+    break;
+
+  case GTPU_MSG_TYPE_ECHO_REQUEST:
+    stats->echo_requests++;
+    return gtpu_forwarder_echo_response(fwd, msg, len, out, out_len);
+
+  default:
+    stats->drop_unsupported++;
+    return GTPU_FWD_DROP;
+  }
+
+  teid = ((uint32_t)msg[4] << 24) | ((uint32_t)msg[5] << 16) | ((uint32_t)msg[6] << 8) | msg[7];
+  if (HASH_TABLE_OK != hashtable_get(fwd->uplink, (hash_key_t)teid, (void**)&bearer)) {
+    stats->drop_unknown_teid++;
+    return GTPU_FWD_DROP;
+  }
+  if ((msg_len - offset < IPV4_HEADER_MIN_SIZE) || ((msg[offset] >> 4) != 4)) {
+    if ((msg_len > offset) && ((msg[offset] >> 4) == 6)) {
+      stats->drop_unsupported++;
+    } else {
+      stats->drop_malformed++;
+    }
+    return GTPU_FWD_DROP;
+  }
+  // the UE may only send with its own address (source address at offset 12 of the IPv4 header)
+  if ((INADDR_ANY != bearer->tunnel.ue.s_addr) && memcmp(&msg[offset + 12], &bearer->tunnel.ue.s_addr, 4)) {
+    stats->drop_spoofed++;
+    return GTPU_FWD_DROP;
+  }
+  *out = &msg[offset];
+  *out_len = msg_len - offset;
+  stats->ul_packets++;
+  stats->ul_bytes += *out_len;
+  return GTPU_FWD_TO_SGI;
+}
+
+//------------------------------------------------------------------------------
+static gtpu_bearer_t *gtpu_forwarder_sdf_bearer(gtpu_bearer_t * const first, const uint32_t sdf_id)
+{
+  for (gtpu_bearer_t *bearer = first; bearer; bearer = bearer->next_same_ue) {
+    for (uint32_t i = 0; i < bearer->nb_sdf; i++) {
+      if (bearer->sdf_id[i] == sdf_id) {
+        return bearer;
+      }
+    }
+  }
+  return first;
+}
+
+//------------------------------------------------------------------------------
+gtpu_fwd_action_t gtpu_forwarder_downlink(
+  gtpu_forwarder_t * const fwd,
+  uint8_t * const packet,
+  const uint32_t len,
+  uint8_t ** const out,
+  uint32_t * const out_len,
+  struct in_addr * const enb,
+  gtpu_fwd_stats_t * const stats)
+{
+  gtpu_bearer_t                          *bearer = NULL;
+  struct in_addr                          ue = {.s_addr = INADDR_ANY};
+  uint8_t                                *header = packet - GTPU_FWD_HEADER_SIZE;
+
+  if ((len < IPV4_HEADER_MIN_SIZE) || ((packet[0] >> 4) != 4)) {
+    if (len && ((packet[0] >> 4) == 6)) {
+      stats->drop_unsupported++;
+    } else {
+      stats->drop_malformed++;
+    }
+    return GTPU_FWD_DROP;
+  }
+  if (len > 0xFFFF) {
+    stats->drop_malformed++;
+    return GTPU_FWD_DROP;
+  }
+  // destination address at offset 16 of the IPv4 header
+  memcpy(&ue.s_addr, &packet[16], 4);
+  if (HASH_TABLE_OK != hashtable_get(fwd->downlink, GTPU_UE_KEY(ue), (void**)&bearer)) {
+    stats->drop_unknown_ue++;
+    return GTPU_FWD_DROP;
+  }
+  // dedicated bearers: the SDF matched selects the bearer, the first bearer of the UE by default
+  if (bearer->next_same_ue && sdf_classifier_nb_rules(fwd->sdf)) {
+    sdf_key_t key;
+    uint32_t  sdf_id = SDF_CLASSIFIER_NO_MATCH;
+
+    if ((RETURNok == sdf_classifier_key_from_ipv4(packet, len, &key))
+        && (SDF_CLASSIFIER_NO_MATCH != (sdf_id = sdf_classifier_lookup(fwd->sdf, &key)))) {
+      bearer = gtpu_forwarder_sdf_bearer(bearer, sdf_id);
+    }
+  }
+  header[0] = GTPU_FLAGS_VERSION_1 | GTPU_FLAGS_PT;
+  header[1] = GTPU_MSG_TYPE_G_PDU;
+  header[2] = (uint8_t)(len >> 8);
+  header[3] = (uint8_t)len;
+  header[4] = (uint8_t)(bearer->tunnel.o_tei >> 24);
+  header[5] = (uint8_t)(bearer->tunnel.o_tei >> 16);
+  header[6] = (uint8_t)(bearer->tunnel.o_tei >> 8);
+  header[7] = (uint8_t)bearer->tunnel.o_tei;
+  *enb = bearer->tunnel.enb;
+  *out = header;
+  *out_len = len + GTPU_FWD_HEADER_SIZE;
+  stats->dl_packets++;
+  stats->dl_bytes += len;
+  return GTPU_FWD_TO_S1U;
+}
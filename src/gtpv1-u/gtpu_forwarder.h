@@ -0,0 +1,159 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file gtpu_forwarder.h
+  \brief GTP-U forwarding tables and per packet processing of the userspace data plane.
+  Uplink G-PDUs are matched on their TEID, downlink IPv4 packets on their destination address, then
+  on the SDF filters of the bearers of the UE when it has several (the first bearer added for a UE
+  address carries the downlink traffic matching no SDF of another bearer). The forwarder does no I/O: the
+  caller gives it the UDP payloads received on S1-U and the IP packets received on SGi, and sends
+  what it returns, so that it can be driven by worker threads or by a test harness.
+  Lookups are done under a read lock taken once per batch of packets, tunnel updates take the write
+  lock (writers are preferred).
+*/
+#ifndef FILE_GTPU_FORWARDER_SEEN
+#define FILE_GTPU_FORWARDER_SEEN
+
+#define GTPU_FWD_HEADER_SIZE               8    /*!< \brief Header of the G-PDUs sent, no optional field */
+#define GTPU_FWD_ECHO_RESPONSE_SIZE       14    /*!< \brief Header with sequence number and Recovery IE */
+
+#define GTPU_MSG_TYPE_ECHO_REQUEST         1
+#define GTPU_MSG_TYPE_ECHO_RESPONSE        2
+#define GTPU_MSG_TYPE_ERROR_INDICATION    26
+#define GTPU_MSG_TYPE_END_MARKER         254
+#define GTPU_MSG_TYPE_G_PDU              255
+
+typedef struct gtpu_forwarder_s gtpu_forwarder_t;
+
+typedef enum {
+  GTPU_FWD_DROP = 0,
+  GTPU_FWD_TO_SGI,      /*!< \brief Decapsulated packet to write on SGi */
+  GTPU_FWD_TO_S1U,      /*!< \brief GTP-U message to send on S1-U */
+} gtpu_fwd_action_t;
+
+/*
+ * Counters of the packets processed by one caller (not shared, no atomic update).
+ */
+typedef struct gtpu_fwd_stats_s {
+  uint64_t ul_packets;
+  uint64_t ul_bytes;
+  uint64_t dl_packets;
+  uint64_t dl_bytes;
+  uint64_t echo_requests;
+  uint64_t drop_malformed;          /*!< \brief Bad GTP-U header or inner IP packet */
+  uint64_t drop_unsupported;        /*!< \brief Other GTP-U messages, inner IPv6 */
+  uint64_t drop_unknown_teid;
+  uint64_t drop_spoofed;            /*!< \brief Uplink source address is not the one of the bearer */
+  uint64_t drop_unknown_ue;
+  uint64_t drop_io;                 /*!< \brief Send/write errors, counted by the caller */
+} gtpu_fwd_stats_t;
+
+/*
+ * Create empty tables.
+ *
+ * @param name            Name of the forwarder, for logs.
+ * @param nb_tunnels_hint Expected number of tunnels, sizes the hash tables.
+ * @param restart_counter Recovery IE value of the Echo Responses.
+ * @return the forwarder, or NULL if out of memory.
+ */
+gtpu_forwarder_t *gtpu_forwarder_create(const char * const name, const uint32_t nb_tunnels_hint, const uint8_t restart_counter);
+
+void gtpu_forwarder_destroy(gtpu_forwarder_t ** const fwd);
+
+/*
+ * Add tunnels, or update the eNB end and UE address of tunnels with the same i_tei.
+ *
+ * @return RETURNok, RETURNerror if out of memory (the previous tunnels are kept).
+ */
+int gtpu_forwarder_add_tunnels(gtpu_forwarder_t * const fwd, const struct gtp_tunnel_entry * const tunnels, const uint32_t nb_tunnels);
+
+/*
+ * Delete the tunnels with these i_tei.
+ *
+ * @return RETURNok, RETURNerror if one of them did not exist.
+ */
+int gtpu_forwarder_del_tunnels(gtpu_forwarder_t * const fwd, const struct gtp_tunnel_entry * const tunnels, const uint32_t nb_tunnels);
+
+/*
+ * Add a downlink packet filter of a service data flow (PCC rule), shared by all UEs.
+ * A filter without remote address only matches the packets sent to ue_net/ue_prefix_len.
+ *
+ * @return RETURNok, RETURNerror if the filter is not supported (IPv6, flow label) or out of memory.
+ */
+int gtpu_forwarder_add_sdf_filter(gtpu_forwarder_t * const fwd, const struct packet_filter_s * const filter,
+                                  const struct in_addr ue_net, const uint32_t ue_prefix_len, const uint32_t sdf_id);
+
+/*
+ * Carry the downlink packets of a service data flow of the UE on the tunnel with this i_tei,
+ * until the tunnel is deleted.
+ *
+ * @return RETURNok, RETURNerror if the tunnel does not exist or has too many SDFs.
+ */
+int gtpu_forwarder_add_bearer_sdf(gtpu_forwarder_t * const fwd, const teid_t i_tei, const uint32_t sdf_id);
+
+uint32_t gtpu_forwarder_nb_tunnels(gtpu_forwarder_t * const fwd);
+
+/*
+ * Lock the tables for the gtpu_forwarder_uplink()/gtpu_forwarder_downlink() calls of a batch.
+ */
+void gtpu_forwarder_read_lock(gtpu_forwarder_t * const fwd);
+void gtpu_forwarder_read_unlock(gtpu_forwarder_t * const fwd);
+
+/*
+ * Process a GTP-U message received on S1-U, under read lock.
+ * A G-PDU is decapsulated: *out points to the inner IPv4 packet in msg. An Echo Request is turned into
+ * an Echo Response in msg, to be sent back to the peer: msg must be able to hold GTPU_FWD_ECHO_RESPONSE_SIZE bytes.
+ *
+ * @param msg     UDP payload.
+ * @param len     UDP payload length.
+ * @param out     Packet or message to send.
+ * @param out_len Its length.
+ * @param stats   Counters of the caller.
+ */
+gtpu_fwd_action_t gtpu_forwarder_uplink(
+  gtpu_forwarder_t * const fwd,
+  uint8_t * const msg,
+  const uint32_t len,
+  uint8_t ** const out,
+  uint32_t * const out_len,
+  gtpu_fwd_stats_t * const stats);
+
+/*
+ * Process an IP packet received on SGi, under read lock.
+ * The G-PDU header is written in the GTPU_FWD_HEADER_SIZE bytes preceding the packet.
+ *
+ * @param packet  IP packet, with GTPU_FWD_HEADER_SIZE writable bytes before it.
+ * @param len     Packet length.
+ * @param out     G-PDU to send (packet - GTPU_FWD_HEADER_SIZE).
+ * @param out_len Its length.
+ * @param enb     eNB to send it to.
+ * @param stats   Counters of the caller.
+ */
+gtpu_fwd_action_t gtpu_forwarder_downlink(
+  gtpu_forwarder_t * const fwd,
+  uint8_t * const packet,
+  const uint32_t len,
+  uint8_t ** const out,
+  uint32_t * const out_len,
+  struct in_addr * const enb,
+  gtpu_fwd_stats_t * const stats);
+
+#endif /* FILE_GTPU_FORWARDER_SEEN */
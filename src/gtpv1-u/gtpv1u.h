@@ -48,6 +48,11 @@
  *         @fd0: socket file descriptor for GTPv0.
  *         @fd1u: socket file descriptor for GTPv1u.
  *
+ * int (*add_ue_net)(struct in_addr *ue_net, uint32_t mask);
+ *     Route an additional UE subnet to the GTP network device.
+ *         @ue_net: subnet assigned to UEs
+ *         @mask: network mask for the UE subnet
+ *
  * int (*uninit)(void);
  *     This function is called to destroy GTP network device.
  *
@@ -65,17 +70,47 @@
  *     Delete a gtp tunnel.
  *         @i_tei: RX GTP Tunnel ID
  *         @o_tei: TX GTP Tunnel ID.
+ *
+ * int (*add_tunnels)(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels);
+ * int (*del_tunnels)(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels);
+ *     Add or delete several gtp tunnels at once (ue and enb are not needed for
+ *     deletion).
+ *
+ * Implementations may apply the operations asynchronously, in the order they
+ * were requested: a returned error then only means the operation could not
+ * be queued, kernel errors are logged.
  */
+struct gtp_tunnel_entry {
+  struct in_addr ue;
+  struct in_addr enb;
+  uint32_t       i_tei;
+  uint32_t       o_tei;
+};
+
+struct packet_filter_s;
+
 struct gtp_tunnel_ops {
   int  (*init)(struct in_addr *ue_net, uint32_t mask, int mtu, int *fd0, int *fd1u);
+  int  (*add_ue_net)(struct in_addr *ue_net, uint32_t mask);
   int  (*uninit)(void);
   int  (*reset)(void);
   int  (*add_tunnel)(struct in_addr ue, struct in_addr enb, uint32_t i_tei, uint32_t o_tei);
   int  (*del_tunnel)(uint32_t i_tei, uint32_t o_tei);
+  int  (*add_tunnels)(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels);
+  int  (*del_tunnels)(const struct gtp_tunnel_entry *tunnels, uint32_t nb_tunnels);
+  // optional, in-process downlink SDF classification (NULL: packets are marked by iptables)
+  int  (*add_sdf_filter)(const struct packet_filter_s *filter, uint32_t sdf_id);
+  int  (*add_bearer_sdf)(uint32_t i_tei, uint32_t sdf_id);
 };
 
-uint32_t gtpv1u_new_teid(void);
+/*
+ * Kernel gtp module data plane, programmed through generic netlink.
+ */
+const struct gtp_tunnel_ops *gtp_tunnel_ops_init_libgtpnl(void);
 
-const struct gtp_tunnel_ops *gtp_tunnel_ops_init(void);
+/*
+ * Userspace data plane: UDP sockets on S1-U and a TUN device on SGi, served by nb_threads workers.
+ */
+const struct gtp_tunnel_ops *gtp_tunnel_ops_init_userspace(const struct in_addr * const s1u_address, const uint16_t port, const uint32_t nb_threads);
 
 #endif /* FILE_GTPV1_U_SEEN */
@@ -108,7 +108,12 @@ int gtpv1u_init (spgw_config_t *spgw_config)
   // START-GTP quick integration only for evaluation purpose
 
   OAILOG_DEBUG (LOG_GTPV1U , "Initializing gtp_tunnel_ops\n");
-  gtp_tunnel_ops = gtp_tunnel_ops_init();
+  if (spgw_config->sgw_config.gtpu_userspace) {
+    gtp_tunnel_ops = gtp_tunnel_ops_init_userspace(&spgw_config->sgw_config.ipv4.S1u_S12_S4_up,
+                                                   spgw_config->sgw_config.udp_port_S1u_S12_S4_up, spgw_config->sgw_config.threads_gtpu);
+  } else {
+    gtp_tunnel_ops = gtp_tunnel_ops_init_libgtpnl();
+  }
   if (gtp_tunnel_ops == NULL) {
     OAILOG_CRITICAL (LOG_GTPV1U, "ERROR in initializing gtp_tunnel_ops\n");
     return -1;
@@ -120,12 +125,19 @@ int gtpv1u_init (spgw_config_t *spgw_config)
     OAILOG_CRITICAL (LOG_GTPV1U, "ERROR clean existing gtp states.\n");
     return -1;
   }
-  AssertFatal(spgw_config->pgw_config.num_ue_pool == 1, "No more than 1 UE pool allowed actually");
-  for (int i = 0; i < spgw_config->pgw_config.num_ue_pool; i++) {
-    // GTP device uses the same MTU as SGi.
-    gtp_tunnel_ops->init(&spgw_config->pgw_config.ue_pool_addr[i],
-                         spgw_config->pgw_config.ue_pool_mask[i], spgw_config->pgw_config.ipv4.mtu_SGI,
-                         &sgw_app.gtpv1u_data.fd0, &sgw_app.gtpv1u_data.fd1u);
+  AssertFatal(spgw_config->pgw_config.num_ue_pool >= 1, "At least 1 UE pool needed");
+  // GTP device uses the same MTU as SGi, and gets the gateway address of the first UE pool.
+  rv = gtp_tunnel_ops->init(&spgw_config->pgw_config.ue_pool_addr[0],
+                       spgw_config->pgw_config.ue_pool_mask[0], spgw_config->pgw_config.ipv4.mtu_SGI,
+                       &sgw_app.gtpv1u_data.fd0, &sgw_app.gtpv1u_data.fd1u);
+  if (rv != 0) {
+    OAILOG_CRITICAL (LOG_GTPV1U, "ERROR in initializing the GTP-U data plane\n");
+    return -1;
+  }
+  for (int i = 1; i < spgw_config->pgw_config.num_ue_pool; i++) {
+    if (gtp_tunnel_ops->add_ue_net) {
+      gtp_tunnel_ops->add_ue_net(&spgw_config->pgw_config.ue_pool_addr[i], spgw_config->pgw_config.ue_pool_mask[i]);
+    }
   }
   // END-GTP quick integration only for evaluation purpose
 
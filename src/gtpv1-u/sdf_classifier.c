@@ -0,0 +1,533 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sdf_classifier.c
+  \brief Service data flow classifier of downlink packets (tuple space search).
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_defs.h"
+#include "3gpp_24.008.h"
+#include "sdf_classifier.h"
+
+#define SDF_TUPLE_MIN_BUCKETS      16
+#define SDF_PORT_ANY           0xFFFF
+#define SDF_PORT_PREFIXES_MAX      30    // prefixes covering any port range
+
+typedef struct sdf_entry_s {
+  sdf_key_t                               value;        // masked by the mask of the tuple
+  uint32_t                                sdf_id;
+  uint64_t                                priority;     // precedence then insertion order, lowest wins
+  bool                                    is_first;     // first entry of the rule, when port ranges are split
+  struct sdf_entry_s                     *next;         // same bucket, by increasing priority
+} sdf_entry_t;
+
+// Rules sharing a mask
+typedef struct sdf_tuple_s {
+  sdf_key_t                               mask;
+  uint64_t                                best_priority;
+  uint32_t                                nb_entries;
+  uint32_t                                nb_buckets;   // power of 2
+  sdf_entry_t                           **buckets;
+} sdf_tuple_t;
+
+struct sdf_classifier_s {
+  uint32_t                                nb_rules;
+  uint32_t                                nb_tuples;
+  uint32_t                                max_tuples;
+  sdf_tuple_t                           **tuples;       // by increasing best_priority
+  uint32_t                                sequence;
+};
+
+//------------------------------------------------------------------------------
+static inline void sdf_key_mask(const sdf_key_t * const key, const sdf_key_t * const mask, sdf_key_t * const masked)
+{
+  masked->src   = key->src & mask->src;
+  masked->dst   = key->dst & mask->dst;
+  masked->spi   = key->spi & mask->spi;
+  masked->sport = key->sport & mask->sport;
+  masked->dport = key->dport & mask->dport;
+  masked->proto = key->proto & mask->proto;
+  masked->tos   = key->tos & mask->tos;
+  masked->spare = 0;
+}
+
+//------------------------------------------------------------------------------
+static inline bool sdf_key_equal(const sdf_key_t * const a, const sdf_key_t * const b)
+{
+  return (a->src == b->src) && (a->dst == b->dst) && (a->spi == b->spi) && (a->sport == b->sport)
+      && (a->dport == b->dport) && (a->proto == b->proto) && (a->tos == b->tos);
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t sdf_mix(uint64_t h)
+{
+  // MurmurHash3 finalizer
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+//------------------------------------------------------------------------------
+static inline uint32_t sdf_key_hash(const sdf_key_t * const key)
+{
+  const uint64_t                          addr = ((uint64_t)key->src << 32) | key->dst;
+  const uint64_t                          other = ((uint64_t)key->spi << 32) | ((uint32_t)key->sport << 16) | key->dport;
+
+  return (uint32_t)sdf_mix(addr ^ sdf_mix(other ^ (((uint64_t)key->proto << 8) | key->tos)));
+}
+
+//------------------------------------------------------------------------------
+static uint32_t sdf_port_range_to_prefixes(const uint16_t min, const uint16_t max, uint16_t * const values, uint16_t * const masks)
+{
+  uint32_t                                nb = 0;
+  uint32_t                                port = min;
+
+  // largest aligned block starting at port and ending before max
+  while (port <= max) {
+    uint32_t size = 1;
+
+    while ((size < 0x10000) && !(port & ((size << 1) - 1)) && (port + (size << 1) - 1 <= max)) {
+      size <<= 1;
+    }
+    values[nb] = (uint16_t)port;
+    masks[nb] = (uint16_t)~(size - 1);
+    nb++;
+    port += size;
+  }
+  return nb;
+}
+
+//------------------------------------------------------------------------------
+sdf_classifier_t *sdf_classifier_create(void)
+{
+  return calloc(1, sizeof(sdf_classifier_t));
+}
+
+//------------------------------------------------------------------------------
+static void sdf_tuple_free(sdf_tuple_t ** const tuple)
+{
+  sdf_entry_t                            *entry = NULL;
+
+  for (uint32_t b = 0; b < (*tuple)->nb_buckets; b++) {
+    while ((entry = (*tuple)->buckets[b])) {
+      (*tuple)->buckets[b] = entry->next;
+      free_wrapper((void**)&entry);
+    }
+  }
+  free_wrapper((void**)&(*tuple)->buckets);
+  free_wrapper((void**)tuple);
+}
+
+//------------------------------------------------------------------------------
+void sdf_classifier_destroy(sdf_classifier_t ** const classifier)
+{
+  if (!classifier || !*classifier) {
+    return;
+  }
+  for (uint32_t t = 0; t < (*classifier)->nb_tuples; t++) {
+    sdf_tuple_free(&(*classifier)->tuples[t]);
+  }
+  free_wrapper((void**)&(*classifier)->tuples);
+  free_wrapper((void**)classifier);
+}
+
+//------------------------------------------------------------------------------
+static void sdf_classifier_sort_tuples(sdf_classifier_t * const classifier)
+{
+  // few tuples, mostly sorted
+  for (uint32_t i = 1; i < classifier->nb_tuples; i++) {
+    sdf_tuple_t *tuple = classifier->tuples[i];
+    uint32_t     j = i;
+
+    while ((j > 0) && (classifier->tuples[j - 1]->best_priority > tuple->best_priority)) {
+      classifier->tuples[j] = classifier->tuples[j - 1];
+      j--;
+    }
+    classifier->tuples[j] = tuple;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void sdf_tuple_insert(sdf_tuple_t * const tuple, sdf_entry_t * const entry)
+{
+  sdf_entry_t                           **prev = &tuple->buckets[sdf_key_hash(&entry->value) & (tuple->nb_buckets - 1)];
+
+  while (*prev && ((*prev)->priority < entry->priority)) {
+    prev = &(*prev)->next;
+  }
+  entry->next = *prev;
+  *prev = entry;
+}
+
+//------------------------------------------------------------------------------
+static int sdf_tuple_grow(sdf_tuple_t * const tuple)
+{
+  uint32_t                                nb_buckets = tuple->nb_buckets;
+  sdf_entry_t                           **buckets = tuple->buckets;
+  sdf_entry_t                            *entry = NULL;
+
+  tuple->buckets = calloc(nb_buckets * 2, sizeof(sdf_entry_t *));
+  if (!tuple->buckets) {
+    tuple->buckets = buckets;
+    return RETURNerror;
+  }
+  tuple->nb_buckets = nb_buckets * 2;
+  for (uint32_t b = 0; b < nb_buckets; b++) {
+    while ((entry = buckets[b])) {
+      buckets[b] = entry->next;
+      sdf_tuple_insert(tuple, entry);
+    }
+  }
+  free_wrapper((void**)&buckets);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static sdf_tuple_t *sdf_classifier_get_tuple(sdf_classifier_t * const classifier, const sdf_key_t * const mask)
+{
+  sdf_tuple_t                            *tuple = NULL;
+
+  for (uint32_t t = 0; t < classifier->nb_tuples; t++) {
+    if (sdf_key_equal(&classifier->tuples[t]->mask, mask)) {
+      return classifier->tuples[t];
+    }
+  }
+  if (classifier->nb_tuples == classifier->max_tuples) {
+    uint32_t      max_tuples = classifier->max_tuples ? 2 * classifier->max_tuples : 8;
+    sdf_tuple_t **tuples = realloc(classifier->tuples, max_tuples * sizeof(sdf_tuple_t *));
+
+    if (!tuples) {
+      return NULL;
+    }
+    classifier->tuples = tuples;
+    classifier->max_tuples = max_tuples;
+  }
+  tuple = calloc(1, sizeof(sdf_tuple_t));
+  if (tuple) {
+    tuple->buckets = calloc(SDF_TUPLE_MIN_BUCKETS, sizeof(sdf_entry_t *));
+    if (!tuple->buckets) {
+      free_wrapper((void**)&tuple);
+      return NULL;
+    }
+    tuple->mask = *mask;
+    tuple->mask.spare = 0;
+    tuple->nb_buckets = SDF_TUPLE_MIN_BUCKETS;
+    tuple->best_priority = UINT64_MAX;
+    classifier->tuples[classifier->nb_tuples++] = tuple;
+  }
+  return tuple;
+}
+
+//------------------------------------------------------------------------------
+// Remove the entries of a SDF, of one of its rules only if priority is not UINT64_MAX, return the number of rules removed
+static uint32_t sdf_classifier_remove(sdf_classifier_t * const classifier, const uint32_t sdf_id, const uint64_t priority)
+{
+  uint32_t                                nb_removed = 0;
+  uint32_t                                t = 0;
+
+  while (t < classifier->nb_tuples) {
+    sdf_tuple_t *tuple = classifier->tuples[t];
+
+    tuple->best_priority = UINT64_MAX;
+    for (uint32_t b = 0; b < tuple->nb_buckets; b++) {
+      sdf_entry_t **prev = &tuple->buckets[b];
+
+      while (*prev) {
+        sdf_entry_t *entry = *prev;
+
+        if ((entry->sdf_id == sdf_id) && ((UINT64_MAX == priority) || (entry->priority == priority))) {
+          *prev = entry->next;
+          nb_removed += (entry->is_first) ? 1 : 0;
+          free_wrapper((void**)&entry);
+          tuple->nb_entries--;
+        } else {
+          tuple->best_priority = (entry->priority < tuple->best_priority) ? entry->priority : tuple->best_priority;
+          prev = &entry->next;
+        }
+      }
+    }
+    if (!tuple->nb_entries) {
+      sdf_tuple_free(&classifier->tuples[t]);
+      classifier->tuples[t] = classifier->tuples[--classifier->nb_tuples];
+    } else {
+      t++;
+    }
+  }
+  sdf_classifier_sort_tuples(classifier);
+  return nb_removed;
+}
+
+//------------------------------------------------------------------------------
+static int sdf_classifier_add_entry(sdf_classifier_t * const classifier, const sdf_rule_t * const rule, const uint32_t sdf_id, const uint64_t priority, const bool is_first)
+{
+  sdf_tuple_t                            *tuple = sdf_classifier_get_tuple(classifier, &rule->mask);
+  sdf_entry_t                            *entry = calloc(1, sizeof(sdf_entry_t));
+
+  if (!tuple || !entry) {
+    free_wrapper((void**)&entry);
+    return RETURNerror;
+  }
+  if ((tuple->nb_entries >= tuple->nb_buckets) && (RETURNok != sdf_tuple_grow(tuple))) {
+    free_wrapper((void**)&entry);
+    return RETURNerror;
+  }
+  sdf_key_mask(&rule->value, &tuple->mask, &entry->value);
+  entry->sdf_id = sdf_id;
+  entry->priority = priority;
+  entry->is_first = is_first;
+  sdf_tuple_insert(tuple, entry);
+  tuple->nb_entries++;
+  if (entry->priority < tuple->best_priority) {
+    tuple->best_priority = entry->priority;
+    sdf_classifier_sort_tuples(classifier);
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int sdf_classifier_add_rule(sdf_classifier_t * const classifier, const sdf_rule_t * const rule, const uint32_t sdf_id, const uint8_t precedence)
+{
+  const uint64_t                          priority = ((uint64_t)precedence << 32) | classifier->sequence;
+  uint16_t                                sport[SDF_PORT_PREFIXES_MAX];
+  uint16_t                                sport_mask[SDF_PORT_PREFIXES_MAX];
+  uint16_t                                dport[SDF_PORT_PREFIXES_MAX];
+  uint16_t                                dport_mask[SDF_PORT_PREFIXES_MAX];
+  uint32_t                                nb_sport = 1;
+  uint32_t                                nb_dport = 1;
+  sdf_rule_t                              prefix_rule = *rule;
+
+  if ((SDF_CLASSIFIER_NO_MATCH == sdf_id) || (rule->sport_min > rule->sport_max) || (rule->dport_min > rule->dport_max)) {
+    return RETURNerror;
+  }
+  sport[0] = rule->value.sport;
+  sport_mask[0] = rule->mask.sport;
+  dport[0] = rule->value.dport;
+  dport_mask[0] = rule->mask.dport;
+  if ((rule->sport_min != 0) || (rule->sport_max != SDF_PORT_ANY)) {
+    nb_sport = sdf_port_range_to_prefixes(rule->sport_min, rule->sport_max, sport, sport_mask);
+  }
+  if ((rule->dport_min != 0) || (rule->dport_max != SDF_PORT_ANY)) {
+    nb_dport = sdf_port_range_to_prefixes(rule->dport_min, rule->dport_max, dport, dport_mask);
+  }
+  prefix_rule.sport_min = 0;
+  prefix_rule.sport_max = SDF_PORT_ANY;
+  prefix_rule.dport_min = 0;
+  prefix_rule.dport_max = SDF_PORT_ANY;
+  for (uint32_t s = 0; s < nb_sport; s++) {
+    for (uint32_t d = 0; d < nb_dport; d++) {
+      prefix_rule.value.sport = sport[s];
+      prefix_rule.mask.sport = sport_mask[s];
+      prefix_rule.value.dport = dport[d];
+      prefix_rule.mask.dport = dport_mask[d];
+      if (RETURNok != sdf_classifier_add_entry(classifier, &prefix_rule, sdf_id, priority, (0 == s) && (0 == d))) {
+        // no partial rule
+        sdf_classifier_remove(classifier, sdf_id, priority);
+        return RETURNerror;
+      }
+    }
+  }
+  classifier->sequence++;
+  classifier->nb_rules++;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sdf_classifier_del_sdf(sdf_classifier_t * const classifier, const uint32_t sdf_id)
+{
+  uint32_t                                nb_removed = sdf_classifier_remove(classifier, sdf_id, UINT64_MAX);
+
+  classifier->nb_rules -= nb_removed;
+  return nb_removed;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sdf_classifier_nb_rules(const sdf_classifier_t * const classifier)
+{
+  return classifier->nb_rules;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sdf_classifier_nb_tuples(const sdf_classifier_t * const classifier)
+{
+  return classifier->nb_tuples;
+}
+
+//------------------------------------------------------------------------------
+uint32_t sdf_classifier_lookup(const sdf_classifier_t * const classifier, const sdf_key_t * const key)
+{
+  const sdf_entry_t                      *best = NULL;
+  sdf_key_t                               masked;
+
+  for (uint32_t t = 0; t < classifier->nb_tuples; t++) {
+    const sdf_tuple_t *tuple = classifier->tuples[t];
+
+    if (best && (tuple->best_priority > best->priority)) {
+      break;
+    }
+    sdf_key_mask(key, &tuple->mask, &masked);
+    for (const sdf_entry_t *entry = tuple->buckets[sdf_key_hash(&masked) & (tuple->nb_buckets - 1)]; entry; entry = entry->next) {
+      if (best && (entry->priority > best->priority)) {
+        break;
+      }
+      if (sdf_key_equal(&entry->value, &masked)) {
+        best = entry;
+        break;
+      }
+    }
+  }
+  return (best) ? best->sdf_id : SDF_CLASSIFIER_NO_MATCH;
+}
+
+//------------------------------------------------------------------------------
+int sdf_classifier_rule_from_packet_filter(const struct packet_filter_s * const filter, const uint32_t ue_net,
+                                           const uint32_t ue_prefix_len, sdf_rule_t * const rule)
+{
+  const packet_filter_contents_t         *pfc = &filter->packetfiltercontents;
+  const bool                              is_downlink = (TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == filter->direction)
+                                                     || (TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == filter->direction);
+  uint32_t                                addr = 0;
+  uint32_t                                mask = 0;
+
+  memset(rule, 0, sizeof(*rule));
+  rule->sport_max = SDF_PORT_ANY;
+  rule->dport_max = SDF_PORT_ANY;
+  if (pfc->flags & (TRAFFIC_FLOW_TEMPLATE_IPV6_REMOTE_ADDR_FLAG | TRAFFIC_FLOW_TEMPLATE_FLOW_LABEL_FLAG)) {
+    return RETURNerror;
+  }
+  // the remote end is the source of the downlink packets
+  if (is_downlink && (TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG & pfc->flags)) {
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+      addr = (addr << 8) | pfc->ipv4remoteaddr[i].addr;
+      mask = (mask << 8) | pfc->ipv4remoteaddr[i].mask;
+    }
+    rule->value.src = addr & mask;
+    rule->mask.src = mask;
+  } else if ((ue_prefix_len) && (ue_prefix_len <= 32)) {
+    // --dest <UE pool> of the marking rules without remote address
+    rule->mask.dst = UINT32_C(0xFFFFFFFF) << (32 - ue_prefix_len);
+    rule->value.dst = ue_net & rule->mask.dst;
+  }
+  // protocol 0 stands for any protocol in iptables
+  if ((TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG & pfc->flags) && pfc->protocolidentifier_nextheader) {
+    rule->value.proto = pfc->protocolidentifier_nextheader;
+    rule->mask.proto = 0xFF;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_SINGLE_LOCAL_PORT_FLAG & pfc->flags) {
+    if (is_downlink) {
+      rule->value.dport = pfc->singlelocalport;
+      rule->mask.dport = 0xFFFF;
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == filter->direction) {
+      rule->value.sport = pfc->singlelocalport;
+      rule->mask.sport = 0xFFFF;
+    }
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG & pfc->flags) {
+    if (is_downlink) {
+      rule->dport_min = pfc->localportrange.lowlimit;
+      rule->dport_max = pfc->localportrange.highlimit;
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == filter->direction) {
+      rule->sport_min = pfc->localportrange.lowlimit;
+      rule->sport_max = pfc->localportrange.highlimit;
+    }
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG & pfc->flags) {
+    if (is_downlink) {
+      rule->value.sport = pfc->singleremoteport;
+      rule->mask.sport = 0xFFFF;
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == filter->direction) {
+      rule->value.dport = pfc->singleremoteport;
+      rule->mask.dport = 0xFFFF;
+    }
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG & pfc->flags) {
+    if (is_downlink) {
+      rule->sport_min = pfc->remoteportrange.lowlimit;
+      rule->sport_max = pfc->remoteportrange.highlimit;
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == filter->direction) {
+      rule->dport_min = pfc->remoteportrange.lowlimit;
+      rule->dport_max = pfc->remoteportrange.highlimit;
+    }
+  }
+  // -m esp only matches ESP packets
+  if (TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG & pfc->flags) {
+    rule->value.spi = pfc->securityparameterindex;
+    rule->mask.spi = 0xFFFFFFFF;
+    rule->value.proto = IPPROTO_ESP;
+    rule->mask.proto = 0xFF;
+  }
+  if (TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG & pfc->flags) {
+    rule->value.tos = pfc->typdeofservice_trafficclass.value & pfc->typdeofservice_trafficclass.mask;
+    rule->mask.tos = pfc->typdeofservice_trafficclass.mask;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int sdf_classifier_key_from_ipv4(const uint8_t * const packet, const uint32_t len, sdf_key_t * const key)
+{
+  uint32_t                                ihl = 0;
+  const uint8_t                          *l4 = NULL;
+
+  memset(key, 0, sizeof(*key));
+  if ((len < 20) || ((packet[0] >> 4) != 4) || ((ihl = (packet[0] & 0x0F) * 4) < 20) || (ihl > len)) {
+    return RETURNerror;
+  }
+  key->tos   = packet[1];
+  key->proto = packet[9];
+  key->src   = ((uint32_t)packet[12] << 24) | ((uint32_t)packet[13] << 16) | ((uint32_t)packet[14] << 8) | packet[15];
+  key->dst   = ((uint32_t)packet[16] << 24) | ((uint32_t)packet[17] << 16) | ((uint32_t)packet[18] << 8) | packet[19];
+  // transport header only in the first fragment
+  if ((((packet[6] & 0x1F) << 8) | packet[7]) || (len < ihl + 4)) {
+    return RETURNok;
+  }
+  l4 = &packet[ihl];
+  switch (key->proto) {
+  case IPPROTO_TCP:
+  case IPPROTO_UDP:
+  case IPPROTO_SCTP:
+  case IPPROTO_UDPLITE:
+    key->sport = ((uint16_t)l4[0] << 8) | l4[1];
+    key->dport = ((uint16_t)l4[2] << 8) | l4[3];
+    break;
+
+  case IPPROTO_ESP:
+    key->spi = ((uint32_t)l4[0] << 24) | ((uint32_t)l4[1] << 16) | ((uint32_t)l4[2] << 8) | l4[3];
+    break;
+
+  default:
+    break;
+  }
+  return RETURNok;
+}
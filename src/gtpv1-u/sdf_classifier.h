@@ -0,0 +1,118 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file sdf_classifier.h
+  \brief Service data flow classifier of downlink packets, in process replacement of the iptables marking.
+  SDF filters (TFT packet filters) are compiled into rules matching masked fields of the IPv4 header and
+  of the transport header. Rules are grouped by mask (tuple space search): each tuple is a hash table of
+  its rules keyed by the masked fields, so a lookup costs one hash probe per distinct mask, whatever the
+  number of rules. Port ranges are split into prefixes (at most 30 per range) so that they are hashed
+  like the other fields. Tuples are visited by decreasing priority of their best rule and the search stops as
+  soon as no remaining tuple can beat the match found.
+  Rules match the same packets as the iptables marking, but the winner differs: a lookup returns the
+  matching rule of lowest evaluation precedence (TS 23.060 15.3.3.4), while the marking ignores the
+  precedence and keeps the mark of the first rule inserted. Both agree when the SDF filters are added in
+  precedence order, as the PCEF emulation does.
+  The classifier is not thread safe, the owner serializes updates with lookups.
+*/
+#ifndef FILE_SDF_CLASSIFIER_SEEN
+#define FILE_SDF_CLASSIFIER_SEEN
+
+#define SDF_CLASSIFIER_NO_MATCH            0
+
+typedef struct sdf_classifier_s sdf_classifier_t;
+
+/*
+ * Fields of a packet compared by the rules, host byte order.
+ */
+typedef struct sdf_key_s {
+  uint32_t src;
+  uint32_t dst;
+  uint32_t spi;         /*!< \brief ESP packets only */
+  uint16_t sport;
+  uint16_t dport;
+  uint8_t  proto;
+  uint8_t  tos;
+  uint16_t spare;       /*!< \brief Always 0 */
+} sdf_key_t;
+
+/*
+ * A packet matches if (packet field & mask) == value for each field and its ports are in the ranges.
+ */
+typedef struct sdf_rule_s {
+  sdf_key_t value;
+  sdf_key_t mask;
+  uint16_t  sport_min;
+  uint16_t  sport_max;  /*!< \brief 0xFFFF when the source port is not a range */
+  uint16_t  dport_min;
+  uint16_t  dport_max;  /*!< \brief 0xFFFF when the destination port is not a range */
+} sdf_rule_t;
+
+sdf_classifier_t *sdf_classifier_create(void);
+
+void sdf_classifier_destroy(sdf_classifier_t ** const classifier);
+
+/*
+ * Add a rule. Among the rules matching a packet the one with the lowest precedence wins,
+ * the first one added if several have the same precedence.
+ *
+ * @return RETURNok, RETURNerror if sdf_id is SDF_CLASSIFIER_NO_MATCH, a port range is empty or out of memory.
+ */
+int sdf_classifier_add_rule(sdf_classifier_t * const classifier, const sdf_rule_t * const rule, const uint32_t sdf_id, const uint8_t precedence);
+
+/*
+ * Compile a TFT packet filter into a rule, the same way pgw_pcef_emulation_apply_sdf_filter() builds the
+ * iptables match: a filter without remote address only matches the packets sent to the UE network.
+ *
+ * @param ue_net         First address of the UE network (first UE IP pool), host byte order.
+ * @param ue_prefix_len  Prefix length of the UE network, 0 to match any destination.
+ * @return RETURNok, RETURNerror for IPv6 remote addresses and flow labels (the data plane is IPv4 only).
+ */
+int sdf_classifier_rule_from_packet_filter(const struct packet_filter_s * const filter, const uint32_t ue_net,
+                                           const uint32_t ue_prefix_len, sdf_rule_t * const rule);
+
+/*
+ * Remove all the rules of an SDF.
+ *
+ * @return the number of rules removed.
+ */
+uint32_t sdf_classifier_del_sdf(sdf_classifier_t * const classifier, const uint32_t sdf_id);
+
+uint32_t sdf_classifier_nb_rules(const sdf_classifier_t * const classifier);
+
+/*
+ * Number of distinct masks, i.e. of hash probes done by a lookup that matches nothing.
+ */
+uint32_t sdf_classifier_nb_tuples(const sdf_classifier_t * const classifier);
+
+/*
+ * @return the SDF of the best rule matching the key, SDF_CLASSIFIER_NO_MATCH if none.
+ */
+uint32_t sdf_classifier_lookup(const sdf_classifier_t * const classifier, const sdf_key_t * const key);
+
+/*
+ * Extract the key of an IPv4 packet (ports and SPI are 0 in non first fragments).
+ *
+ * @return RETURNok, RETURNerror if it is not a valid IPv4 packet.
+ */
+int sdf_classifier_key_from_ipv4(const uint8_t * const packet, const uint32_t len, sdf_key_t * const key);
+
+#endif /* FILE_SDF_CLASSIFIER_SEEN */
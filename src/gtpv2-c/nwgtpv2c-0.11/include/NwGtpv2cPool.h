@@ -0,0 +1,115 @@
+/*----------------------------------------------------------------------------*
+ *                                                                            *
+ *                              n w - g t p v 2 c                             *
+ *    G P R S   T u n n e l i n g    P r o t o c o l   v 2 c    S t a c k     *
+ *                                                                            *
+ *                                                                            *
+ * Copyright (c) 2010-2011 Amit Chawre                                        *
+ * All rights reserved.                                                       *
+ *                                                                            *
+ * Redistribution and use in source and binary forms, with or without         *
+ * modification, are permitted provided that the following conditions         *
+ * are met:                                                                   *
+ *                                                                            *
+ * 1. Redistributions of source code must retain the above copyright          *
+ *    notice, this list of conditions and the following disclaimer.           *
+ * 2. Redistributions in binary form must reproduce the above copyright       *
+ *    notice, this list of conditions and the following disclaimer in the     *
+ *    documentation and/or other materials provided with the distribution.    *
+ * 3. The name of the author may not be used to endorse or promote products   *
+ *    derived from this software without specific prior written permission.   *
+ *                                                                            *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR       *
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES  *
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.    *
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,           *
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT   *
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,  *
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY      *
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT        *
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF   *
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.          *
+ *----------------------------------------------------------------------------*/
+
+#ifndef __NW_GTPV2C_POOL_H__
+#define __NW_GTPV2C_POOL_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "NwTypes.h"
+#include "NwError.h"
+
+/**
+ * @file NwGtpv2cPool.h
+ * @brief Fixed size object pools owned by a stack instance. Objects are
+ * carved out of slabs preallocated at stack creation, a new slab is added
+ * when a pool runs dry. Objects are only given back to the system when the
+ * stack is finalized.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef union nw_gtpv2c_pool_slab_u {
+  union nw_gtpv2c_pool_slab_u  *next;
+  long double                   align;                  /**< Objects following the slab header are aligned for any type */
+} nw_gtpv2c_pool_slab_t;
+
+typedef struct nw_gtpv2c_pool_s {
+  void                         *pFreeList;              /**< Free objects, linked through their first word */
+  nw_gtpv2c_pool_slab_t        *pSlabList;
+  size_t                        objSize;
+  uint32_t                      objPerSlab;
+  uint32_t                      numSlabs;
+  uint32_t                      numFree;
+} nw_gtpv2c_pool_t;
+
+/**
+ * Initialize a pool and preallocate its first slab.
+ *
+ * @param[in] thiz : Pointer to pool.
+ * @param[in] objSize : Size of pooled objects.
+ * @param[in] objPerSlab : Number of objects preallocated, and added each time the pool runs dry.
+ * @return NW_OK on success.
+ */
+nw_rc_t
+nwGtpv2cPoolInit( NW_INOUT nw_gtpv2c_pool_t *thiz,
+                  NW_IN    size_t objSize,
+                  NW_IN    uint32_t objPerSlab);
+
+/**
+ * Release all slabs of a pool, objects still in use become invalid.
+ */
+void
+nwGtpv2cPoolFinalize( NW_INOUT nw_gtpv2c_pool_t *thiz);
+
+/**
+ * Get an object from a pool, content is undefined.
+ *
+ * @return Pointer to object, NULL if a new slab could not be allocated.
+ */
+void*
+nwGtpv2cPoolAlloc( NW_INOUT nw_gtpv2c_pool_t *thiz);
+
+/**
+ * Give an object back to the pool it has been taken from.
+ */
+static inline void
+nwGtpv2cPoolFree( NW_INOUT nw_gtpv2c_pool_t *thiz, NW_IN void *pObj)
+{
+  *((void **) pObj) = thiz->pFreeList;
+  thiz->pFreeList = pObj;
+  thiz->numFree++;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __NW_GTPV2C_POOL_H__ */
+
+/*--------------------------------------------------------------------------*
+ *                      E N D     O F    F I L E                            *
+ *--------------------------------------------------------------------------*/
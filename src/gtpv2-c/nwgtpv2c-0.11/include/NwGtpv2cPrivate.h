@@ -47,6 +47,7 @@
 #include "NwGtpv2cMsg.h"
 #include "NwGtpv2cMsgIeParseInfo.h"
 #include "NwGtpv2cTunnel.h"
+#include "NwGtpv2cPool.h"
 
 /**
  * @file NwGtpv2cPrivate.h
@@ -88,6 +89,17 @@ extern "C" {
  *  G T P V 2 C   S T A C K   O B J E C T   T Y P E    D E F I N I T I O N  *
  *--------------------------------------------------------------------------*/
 
+#define NW_GTPV2C_TUNNEL_MAP_BITS                                (16)    /**< log2 of the number of local tunnel map buckets */
+#define NW_GTPV2C_TRXN_MAP_BITS                                  (16)    /**< log2 of the number of outstanding transaction map buckets */
+
+#define NW_GTPV2C_MSG_POOL_SLAB_SIZE                             (256)   /**< Messages preallocated per slab, a message is ~10kB */
+#define NW_GTPV2C_TRXN_POOL_SLAB_SIZE                            (8192)  /**< Transactions preallocated per slab */
+#define NW_GTPV2C_TUNNEL_POOL_SLAB_SIZE                          (8192)  /**< Local tunnels preallocated per slab */
+#define NW_GTPV2C_TIMEOUT_INFO_POOL_SLAB_SIZE                    (8192)  /**< Timers preallocated per slab, also initial timer heap size */
+
+LIST_HEAD(nw_gtpv2c_tunnel_map_bucket_s, nw_gtpv2c_tunnel_s);
+LIST_HEAD(nw_gtpv2c_trxn_map_bucket_s, nw_gtpv2c_trxn_s);
+
 /**
  * gtpv2c stack class definition
  */
@@ -101,17 +113,22 @@ typedef struct nw_gtpv2c_stack_s {
   nw_gtpv2c_log_mgr_entity_t         logMgr;
 
   uint32_t                        seqNum;
+  nw_gtpv2c_stack_config_t          config;
   uint32_t                        logLevel;
   uint32_t                        restartCounter;
 
   nw_gtpv2c_msg_ie_parse_info_t       *pGtpv2cMsgIeParseInfo[NW_GTP_MSG_END];
   struct nw_gtpv2c_timeout_info_s    *activeTimerInfo;
 
-  RB_HEAD( NwGtpv2cTunnelMap, nw_gtpv2c_tunnel_s                ) tunnelMap;
-  RB_HEAD( NwGtpv2cOutstandingTxSeqNumTrxnMap, nw_gtpv2c_trxn_s ) outstandingTxSeqNumMap;
-  RB_HEAD( NwGtpv2cOutstandingRxSeqNumTrxnMap, nw_gtpv2c_trxn_s ) outstandingRxSeqNumMap;
-  RB_HEAD( NwGtpv2cActiveTimerList, nw_gtpv2c_timeout_info_s     ) activeTimerList;
+  struct nw_gtpv2c_tunnel_map_bucket_s *tunnelMap;                   /**< Local tunnels hashed on TEID                  */
+  struct nw_gtpv2c_trxn_map_bucket_s   *outstandingTxSeqNumMap;      /**< Outstanding TX trxns hashed on (peer, seq)    */
+  struct nw_gtpv2c_trxn_map_bucket_s   *outstandingRxSeqNumMap;      /**< Outstanding RX trxns hashed on (peer, seq)    */
   NwPtrT                        hTmrMinHeap;
+
+  nw_gtpv2c_pool_t              msgPool;
+  nw_gtpv2c_pool_t              trxnPool;
+  nw_gtpv2c_pool_t              tunnelPool;
+  nw_gtpv2c_pool_t              timeoutInfoPool;
 } nw_gtpv2c_stack_t;
 
 
@@ -130,9 +147,7 @@ typedef struct nw_gtpv2c_timeout_info_s {
   void*                             timeoutArg;
   nw_rc_t                         (*timeoutCallbackFunc)(void*);
   nw_gtpv2c_timer_handle_t          hTimer;
-  RB_ENTRY (nw_gtpv2c_timeout_info_s)       activeTimerListRbtNode;            /**< RB Tree Data Structure Node        */
   uint32_t                          timerMinHeapIndex;
-  struct nw_gtpv2c_timeout_info_s  *next;
 } nw_gtpv2c_timeout_info_t;
 
 
@@ -164,7 +179,6 @@ typedef struct nw_gtpv2c_msg_s {
   uint8_t                      *pIe[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
   uint8_t                       msgBuf[NW_GTPV2C_MAX_MSG_LEN];
   nw_gtpv2c_stack_handle_t      hStack;
-  struct nw_gtpv2c_msg_s*       next;
 } nw_gtpv2c_msg_t;
 
 /**
@@ -182,9 +196,7 @@ typedef struct nw_gtpv2c_trxn_s {
   nw_gtpv2c_timer_handle_t      hRspTmr;                                /**< Handle to reponse timer            */
   nw_gtpv2c_tunnel_handle_t     hTunnel;                                /**< Handle to local tunnel context     */
   nw_gtpv2c_ulp_trxn_handle_t   hUlpTrxn;                               /**< Handle to ULP tunnel context       */
-  RB_ENTRY (nw_gtpv2c_trxn_s)   outstandingTxSeqNumMapRbtNode;          /**< RB Tree Data Structure Node        */
-  RB_ENTRY (nw_gtpv2c_trxn_s)   outstandingRxSeqNumMapRbtNode;          /**< RB Tree Data Structure Node        */
-  struct nw_gtpv2c_trxn_s*      next;
+  LIST_ENTRY (nw_gtpv2c_trxn_s) outstandingSeqNumMapEntry;              /**< Hash bucket link in TX or RX map   */
 } nw_gtpv2c_trxn_t;
 
 /**
@@ -202,10 +214,57 @@ typedef struct NwGtpv2cPathS {
 } NwGtpv2cPathT;
 
 
-RB_PROTOTYPE(NwGtpv2cTunnelMap, nw_gtpv2c_tunnel_s, tunnelMapRbtNode, nwGtpv2cCompareTunnel)
-RB_PROTOTYPE(NwGtpv2cOutstandingTxSeqNumTrxnMap, nw_gtpv2c_trxn_s, outstandingTxSeqNumMapRbtNode, nwGtpv2cCompareSeqNum)
-RB_PROTOTYPE(NwGtpv2cOutstandingRxSeqNumTrxnMap, nw_gtpv2c_trxn_s, outstandingRxSeqNumMapRbtNode, nwGtpv2cCompareSeqNum)
-RB_PROTOTYPE(NwGtpv2cActiveTimerList, nw_gtpv2c_timeout_info_s, activeTimerListRbtNode, nwGtpv2cCompareOutstandingTxRexmitTime)
+/**
+ * Insert a local tunnel in the tunnel map.
+ *
+ * @return NULL on success, the tunnel already registered with the same TEID and peer otherwise.
+ */
+
+nw_gtpv2c_tunnel_t*
+nwGtpv2cTunnelMapInsert(nw_gtpv2c_stack_t* thiz,
+                        nw_gtpv2c_tunnel_t* pTunnel);
+
+nw_gtpv2c_tunnel_t*
+nwGtpv2cTunnelMapFind(nw_gtpv2c_stack_t* thiz,
+                      uint32_t teid,
+                      struct in_addr *peerIp);
+
+/**
+ * Remove a local tunnel from the tunnel map, no-op if the tunnel is not in the map.
+ */
+
+void
+nwGtpv2cTunnelMapRemove(nw_gtpv2c_stack_t* thiz,
+                        nw_gtpv2c_tunnel_t* pTunnel);
+
+/**
+ * Insert a transaction in the outstanding TX (keyed on peer IP, seq num) or
+ * RX (keyed on peer IP, peer port, seq num) transaction map.
+ *
+ * @return NULL on success, the outstanding transaction with the same key otherwise.
+ */
+
+nw_gtpv2c_trxn_t*
+nwGtpv2cOutstandingTxTrxnMapInsert(nw_gtpv2c_stack_t* thiz,
+                                   nw_gtpv2c_trxn_t* pTrxn);
+
+nw_gtpv2c_trxn_t*
+nwGtpv2cOutstandingTxTrxnMapFind(nw_gtpv2c_stack_t* thiz,
+                                 uint32_t seqNum,
+                                 struct in_addr *peerIp);
+
+nw_gtpv2c_trxn_t*
+nwGtpv2cOutstandingRxTrxnMapInsert(nw_gtpv2c_stack_t* thiz,
+                                   nw_gtpv2c_trxn_t* pTrxn);
+
+/**
+ * Remove a transaction from the TX or RX map it belongs to, no-op if the
+ * transaction is in none.
+ */
+
+void
+nwGtpv2cOutstandingTrxnMapRemove(nw_gtpv2c_stack_t* thiz,
+                                 nw_gtpv2c_trxn_t* pTrxn);
 
 /**
  * Start Timer with ULP Timer Manager
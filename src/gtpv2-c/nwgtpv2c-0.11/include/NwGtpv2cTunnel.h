@@ -38,7 +38,7 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "tree.h"
+#include "queue.h"
 #include "NwTypes.h"
 #include "NwUtils.h"
 #include "NwError.h"
@@ -54,8 +54,7 @@ typedef struct nw_gtpv2c_tunnel_s {
   uint32_t                      teid;
   struct in_addr                ipv4AddrRemote;
   nw_gtpv2c_ulp_tunnel_handle_t      hUlpTunnel;
-  RB_ENTRY (nw_gtpv2c_tunnel_s)     tunnelMapRbtNode;            /**< RB Tree Data Structure Node        */
-  struct nw_gtpv2c_tunnel_s*        next;
+  LIST_ENTRY (nw_gtpv2c_tunnel_s)   tunnelMapEntry;              /**< Hash bucket link in tunnel map     */
 } nw_gtpv2c_tunnel_t;
 
 nw_gtpv2c_tunnel_t*
@@ -123,7 +123,8 @@ typedef NwPtrT  nw_gtpv2c_ulp_tunnel_handle_t;                /**< Gtpv2c Ulp Tu
 typedef uint8_t   nw_gtpv2c_msg_type_t;                       /**< Gtpv2c Msg Type                    */
 
 typedef struct nw_gtpv2c_stack_config_s {
-  uint16_t                                __tbd;
+  uint32_t                                seqNumStart;  /**< First sequence number of locally initiated transactions */
+  uint32_t                                seqNumStep;   /**< Increment between two local sequence numbers, at least 1 */
 } nw_gtpv2c_stack_config_t;
 
 /*--------------------------------------------------------------------------*
@@ -563,6 +564,16 @@ nwGtpv2cProcessUlpReq( NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
 nw_rc_t
 nwGtpv2cProcessTimeout( NW_IN void* timeoutArg);
 
+/**
+ Get the stack owning a transaction.
+
+ @param[in] hTrxn : Transaction handle, as given to the ULP entity.
+ @return Stack handle.
+ */
+
+nw_gtpv2c_stack_handle_t
+nwGtpv2cTrxnGetStackHandle( NW_IN nw_gtpv2c_trxn_handle_t hTrxn);
+
 
 #ifdef __cplusplus
 }
@@ -221,6 +221,17 @@ typedef struct nw_gtpv2c_ie_tlv_s {
 
 #pragma pack()
 
+#define NW_GTPV2C_IE_TEMPLATE_MAX_LEN                           (128)  /**< Maximum length of an IE template    */
+
+/**
+ * Pre-encoded information elements, appended as a whole to a message with nwGtpv2cMsgAddIeTemplate().
+ * The caller then writes the variable fields at the offsets it recorded when building the template.
+ */
+typedef struct nw_gtpv2c_ie_template_s {
+  uint16_t len;
+  uint8_t  buf[NW_GTPV2C_IE_TEMPLATE_MAX_LEN];
+} nw_gtpv2c_ie_template_t;
+
 
 /**
  * Allocate a gtpv2c message.
@@ -399,6 +410,41 @@ nwGtpv2cMsgAddIe(NW_IN nw_gtpv2c_msg_handle_t hMsg,
                  NW_IN uint8_t       instance,
                  NW_IN uint8_t*      pVal);
 
+/**
+ * Allocate a message container used to build an IE template with the nwGtpv2cMsgAddIe* and
+ * nwGtpv2cMsgGroupedIe* APIs. The container has no header: nwGtpv2cMsgGetLength() returns the
+ * offset in the template of the next IE.
+ *
+ * @param[out] phMsg : Pointer to message handle.
+ */
+
+nw_rc_t
+nwGtpv2cMsgIeTemplateStart(NW_OUT nw_gtpv2c_msg_handle_t *phMsg);
+
+/**
+ * Save the IEs of a container allocated by nwGtpv2cMsgIeTemplateStart() in a template and free the container.
+ *
+ * @param[in] hMsg : Message handle.
+ * @param[out] pTemplate : Template.
+ */
+
+nw_rc_t
+nwGtpv2cMsgIeTemplateEnd(NW_IN nw_gtpv2c_msg_handle_t hMsg,
+                         NW_OUT nw_gtpv2c_ie_template_t *pTemplate);
+
+/**
+ * Append the IEs of a template to gtpv2c message.
+ *
+ * @param[in] hMsg : Handle to gtpv2c message.
+ * @param[in] pTemplate : Template.
+ * @param[out] ppIe : Start of the appended IEs in the message buffer, for writing the variable fields.
+ */
+
+nw_rc_t
+nwGtpv2cMsgAddIeTemplate(NW_IN nw_gtpv2c_msg_handle_t hMsg,
+                         NW_IN const nw_gtpv2c_ie_template_t *pTemplate,
+                         NW_OUT uint8_t **ppIe);
+
 /**
  * Add CAUSE information element to gtpv2c message.
  *
@@ -32,6 +32,7 @@
  *----------------------------------------------------------------------------*/
 
 #include <string.h>
+#include <stddef.h>
 #include "NwTypes.h"
 #include "NwGtpv2c.h"
 #include "NwGtpv2cIe.h"
@@ -60,6 +61,65 @@ typedef struct nw_gtpv2c_msg_parser_s {
   uint8_t *pIe[NW_GTPV2C_IE_TYPE_MAXIMUM][NW_GTPV2C_IE_INSTANCE_MAXIMUM];
 } nw_gtpv2c_msg_parser_t;
 
+/**
+ * Precompiled message parsers.
+ *
+ * A parser descriptor lists the IEs expected in a message type, or in a grouped IE, and the
+ * offset in a caller structure where each IE is decoded. It is compiled once, at stack init,
+ * with nwGtpv2cMsgParserDescInit() and is read-only afterwards: nwGtpv2cMsgParserDescRun()
+ * is re-entrant, does not allocate memory, and decodes grouped IEs recursively into the
+ * element arrays of the caller structure.
+ */
+
+#define NW_GTPV2C_MSG_PARSER_DESC_MAX_IE                (32)    /**< Maximum IE descriptors per message or grouped IE */
+
+struct nw_gtpv2c_msg_parser_desc_s;
+
+typedef struct nw_gtpv2c_ie_parse_desc_s {
+  uint8_t                 ieType;
+  uint8_t                 ieInstance;
+  uint8_t                 iePresence;
+  nw_rc_t (*ieReadCallback) (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance,  uint8_t* ieValue, void* ieReadCallbackArg);
+  size_t                  ieOffset;             /**< Offset of the decoded value (of the first element for a grouped IE) */
+
+  /* Grouped IE only: each occurrence is decoded in the next element of an array */
+  const struct nw_gtpv2c_msg_parser_desc_s *pGroupedIeDesc;
+  size_t                  ieCountOffset;        /**< Offset of the uint8_t element count */
+  size_t                  ieElementSize;
+  uint8_t                 ieMaxCount;
+} nw_gtpv2c_ie_parse_desc_t;
+
+typedef struct nw_gtpv2c_msg_parser_desc_s {
+  uint16_t                msgType;              /**< 0 for a grouped IE */
+  uint8_t                 numIe;
+  uint8_t                 mandatoryIeCount;
+  const nw_gtpv2c_ie_parse_desc_t *pIeDesc;
+  uint8_t                 ieIndex[NW_GTPV2C_IE_TYPE_MAXIMUM];         /**< 1 + first descriptor of an IE type, 0 if none */
+  uint8_t                 ieNext[NW_GTPV2C_MSG_PARSER_DESC_MAX_IE];   /**< 1 + next descriptor of the same IE type, 0 if none */
+} nw_gtpv2c_msg_parser_desc_t;
+
+/**
+ * IE decoded by ieReadCallback into the field fIELD of the structure sTRUCT.
+ * With a NULL callback the IE is accepted but not decoded.
+ */
+#define NW_GTPV2C_IE_PARSE_DESC(tYPE, iNSTANCE, pRESENCE, cALLBACK, sTRUCT, fIELD)                            \
+  { .ieType = (tYPE), .ieInstance = (iNSTANCE), .iePresence = (pRESENCE), .ieReadCallback = (cALLBACK),       \
+    .ieOffset = offsetof (sTRUCT, fIELD) }
+
+#define NW_GTPV2C_IE_PARSE_DESC_NO_VALUE(tYPE, iNSTANCE, pRESENCE)                                            \
+  { .ieType = (tYPE), .ieInstance = (iNSTANCE), .iePresence = (pRESENCE) }
+
+/**
+ * Grouped IE, every occurrence is decoded with gROUPdESC into the next element of the array
+ * sTRUCT.lIST.aRRAY, the element count being sTRUCT.lIST.cOUNT.
+ */
+#define NW_GTPV2C_GROUPED_IE_PARSE_DESC(tYPE, iNSTANCE, pRESENCE, gROUPdESC, sTRUCT, lIST, cOUNT, aRRAY)      \
+  { .ieType = (tYPE), .ieInstance = (iNSTANCE), .iePresence = (pRESENCE), .pGroupedIeDesc = (gROUPdESC),      \
+    .ieOffset = offsetof (sTRUCT, lIST.aRRAY),                                                                \
+    .ieCountOffset = offsetof (sTRUCT, lIST.cOUNT),                                                           \
+    .ieElementSize = sizeof (((sTRUCT *)0)->lIST.aRRAY[0]),                                                   \
+    .ieMaxCount = sizeof (((sTRUCT *)0)->lIST.aRRAY) / sizeof (((sTRUCT *)0)->lIST.aRRAY[0]) }
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -140,6 +200,43 @@ nwGtpv2cMsgParserRun( NW_IN nw_gtpv2c_msg_parser_t *thiz,
                       NW_OUT uint8_t             *pOffendingIeInstance,
                       NW_OUT uint16_t            *pOffendingIeLength);
 
+/**
+ * Compile a parser descriptor.
+ *
+ * @param[out] thiz : Parser descriptor, usually static.
+ * @param[in] msgType : Message type, 0 for a grouped IE.
+ * @param[in] pIeDesc : IE descriptors, must remain valid as long as the parser descriptor is used.
+ * @param[in] numIe : Number of IE descriptors.
+ */
+
+nw_rc_t
+nwGtpv2cMsgParserDescInit( NW_OUT nw_gtpv2c_msg_parser_desc_t *thiz,
+                           NW_IN uint16_t msgType,
+                           NW_IN const nw_gtpv2c_ie_parse_desc_t *pIeDesc,
+                           NW_IN uint8_t numIe);
+
+/**
+ * Compile a parser descriptor from an array of IE descriptors.
+ */
+#define NW_GTPV2C_MSG_PARSER_DESC_INIT(pDESC, mSGtYPE, iEdESCS)                                              \
+  nwGtpv2cMsgParserDescInit ((pDESC), (mSGtYPE), (iEdESCS), sizeof (iEdESCS) / sizeof ((iEdESCS)[0]))
+
+/**
+ * Parse a message with a compiled parser descriptor.
+ *
+ * @param[in] thiz : Parser descriptor.
+ * @param[in] hMsg : Message handle.
+ * @param[out] pOut : Caller structure receiving the decoded IEs.
+ */
+
+nw_rc_t
+nwGtpv2cMsgParserDescRun( NW_IN const nw_gtpv2c_msg_parser_desc_t *thiz,
+                          NW_IN nw_gtpv2c_msg_handle_t  hMsg,
+                          NW_OUT void                *pOut,
+                          NW_OUT uint8_t             *pOffendingIeType,
+                          NW_OUT uint8_t             *pOffendingIeInstance,
+                          NW_OUT uint16_t            *pOffendingIeLength);
+
 #ifdef __cplusplus
 }
 #endif
@@ -97,8 +97,6 @@
 extern                                  "C" {
 #endif
 
-  static nw_gtpv2c_timeout_info_t            *gpGtpv2cTimeoutInfoPool = NULL;
-
   typedef struct {
     int                                     currSize;
     int                                     maxSize;
@@ -131,9 +129,18 @@ extern                                  "C" {
   static nw_rc_t                            nwGtpv2cTmrMinHeapInsert (
   NwGtpv2cTmrMinHeapT * thiz,
   nw_gtpv2c_timeout_info_t * pTimerEvent) {
-    int                                     holeIndex = thiz->currSize++;
+    int                                     holeIndex = 0;
+
+    if (thiz->currSize == thiz->maxSize) {
+      nw_gtpv2c_timeout_info_t                  **pHeap = NULL;
+
+      pHeap = (nw_gtpv2c_timeout_info_t **) realloc (thiz->pHeap, 2 * thiz->maxSize * sizeof (nw_gtpv2c_timeout_info_t *));
+      NW_ASSERT (pHeap);
+      thiz->pHeap = pHeap;
+      thiz->maxSize *= 2;
+    }
 
-    NW_ASSERT (thiz->currSize < thiz->maxSize);
+    holeIndex = thiz->currSize++;
 
     while ((holeIndex > 0) && NW_GTPV2C_TIMER_CMP_P (&(thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)])->tvTimeout, &(pTimerEvent->tvTimeout), >)) {
       thiz->pHeap[holeIndex] = thiz->pHeap[NW_HEAP_PARENT_INDEX (holeIndex)];
@@ -255,129 +262,110 @@ extern                                  "C" {
   }
 
 /*---------------------------------------------------------------------------
-   Tunnel RBTree Search Data Structure
+   Tunnel and Transaction Hash Maps
   --------------------------------------------------------------------------*/
 
-/**
-  Comparator funtion for comparing two sequence number transactions.
-
-  @param[in] a: Pointer to session a.
-  @param[in] b: Pointer to session b.
-  @return  An integer greater than, equal to or less than zero according to whether the
-  object pointed to by a is greater than, equal to or less than the object pointed to by b.
-*/
-
-  static inline int32_t                    nwGtpv2cCompareTunnel (
-  struct nw_gtpv2c_tunnel_s *a,
-  struct nw_gtpv2c_tunnel_s *b) {
-    if (a->teid > b->teid)
-      return 1;
-
-    if (a->teid < b->teid)
-      return -1;
-
-    if (a->ipv4AddrRemote.s_addr > b->ipv4AddrRemote.s_addr)
-      return 1;
-
-    if (a->ipv4AddrRemote.s_addr < b->ipv4AddrRemote.s_addr)
-      return -1;
+#define NW_GTPV2C_MAP_HASH(__key, __bits)       ((uint32_t) ((uint32_t) (__key) * 0x9E3779B1U) >> (32 - (__bits)))
 
-    return 0;
+  static inline struct nw_gtpv2c_tunnel_map_bucket_s *nwGtpv2cTunnelMapBucket (
+  nw_gtpv2c_stack_t * thiz,
+  uint32_t teid) {
+    return &thiz->tunnelMap[NW_GTPV2C_MAP_HASH (teid, NW_GTPV2C_TUNNEL_MAP_BITS)];
   }
 
-  RB_GENERATE (NwGtpv2cTunnelMap, nw_gtpv2c_tunnel_s, tunnelMapRbtNode, nwGtpv2cCompareTunnel)
-
-/*---------------------------------------------------------------------------
-   Transaction RBTree Search Data Structure
-  --------------------------------------------------------------------------*/
-/**
-  Comparator funtion for comparing two outstancing TX transactions.
-
-  @param[in] a: Pointer to session a.
-  @param[in] b: Pointer to session b.
-  @return  An integer greater than, equal to or less than zero according to whether the
-  object pointed to by a is greater than, equal to or less than the object pointed to by b.
-*/
-  static inline int32_t                    nwGtpv2cCompareOutstandingTxSeqNumTrxn (
-  struct nw_gtpv2c_trxn_s *a,
-  struct nw_gtpv2c_trxn_s *b) {
-    if (a->seqNum > b->seqNum)
-      return 1;
-
-    if (a->seqNum < b->seqNum)
-      return -1;
-
-    if (a->peerIp.s_addr > b->peerIp.s_addr)
-      return 1;
-
-    if (a->peerIp.s_addr < b->peerIp.s_addr)
-      return -1;
-
-    return 0;
+  static inline struct nw_gtpv2c_trxn_map_bucket_s *nwGtpv2cTrxnMapBucket (
+  struct nw_gtpv2c_trxn_map_bucket_s *map,
+  uint32_t seqNum,
+  struct in_addr *peerIp) {
+    return &map[NW_GTPV2C_MAP_HASH (seqNum ^ peerIp->s_addr, NW_GTPV2C_TRXN_MAP_BITS)];
   }
 
-  RB_GENERATE (NwGtpv2cOutstandingTxSeqNumTrxnMap, nw_gtpv2c_trxn_s, outstandingTxSeqNumMapRbtNode, nwGtpv2cCompareOutstandingTxSeqNumTrxn)
+  nw_gtpv2c_tunnel_t                       *nwGtpv2cTunnelMapFind (
+  nw_gtpv2c_stack_t * thiz,
+  uint32_t teid,
+  struct in_addr *peerIp) {
+    nw_gtpv2c_tunnel_t                        *pTunnel = NULL;
 
-/**
-  Comparator funtion for comparing outstanding RX transactions.
+    LIST_FOREACH (pTunnel, nwGtpv2cTunnelMapBucket (thiz, teid), tunnelMapEntry) {
+      if ((pTunnel->teid == teid) && (pTunnel->ipv4AddrRemote.s_addr == peerIp->s_addr))
+        break;
+    }
+    return pTunnel;
+  }
 
-  @param[in] a: Pointer to session a.
-  @param[in] b: Pointer to session b.
-  @return  An integer greater than, equal to or less than zero according to whether the
-  object pointed to by a is greater than, equal to or less than the object pointed to by b.
-*/
-  static inline int32_t                    nwGtpv2cCompareOutstandingRxSeqNumTrxn (
-  struct nw_gtpv2c_trxn_s *a,
-  struct nw_gtpv2c_trxn_s *b) {
-    if (a->seqNum > b->seqNum)
-      return 1;
+  nw_gtpv2c_tunnel_t                       *nwGtpv2cTunnelMapInsert (
+  nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_tunnel_t * pTunnel) {
+    nw_gtpv2c_tunnel_t                        *pCollision = NULL;
 
-    if (a->seqNum < b->seqNum)
-      return -1;
+    pCollision = nwGtpv2cTunnelMapFind (thiz, pTunnel->teid, &pTunnel->ipv4AddrRemote);
 
-    if (a->peerIp.s_addr > b->peerIp.s_addr)
-      return 1;
+    if (!pCollision) {
+      LIST_INSERT_HEAD (nwGtpv2cTunnelMapBucket (thiz, pTunnel->teid), pTunnel, tunnelMapEntry);
+    }
 
-    if (a->peerIp.s_addr < b->peerIp.s_addr)
-      return -1;
+    return pCollision;
+  }
 
-    if (a->peerPort > b->peerPort)
-      return 1;
+  void                                      nwGtpv2cTunnelMapRemove (
+  __attribute__ ((unused)) nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_tunnel_t * pTunnel) {
+    if (pTunnel->tunnelMapEntry.le_prev) {
+      LIST_REMOVE (pTunnel, tunnelMapEntry);
+      pTunnel->tunnelMapEntry.le_prev = NULL;
+    }
+  }
 
-    if (a->peerPort < b->peerPort)
-      return -1;
+  nw_gtpv2c_trxn_t                         *nwGtpv2cOutstandingTxTrxnMapFind (
+  nw_gtpv2c_stack_t * thiz,
+  uint32_t seqNum,
+  struct in_addr *peerIp) {
+    nw_gtpv2c_trxn_t                          *pTrxn = NULL;
 
-    return 0;
+    LIST_FOREACH (pTrxn, nwGtpv2cTrxnMapBucket (thiz->outstandingTxSeqNumMap, seqNum, peerIp), outstandingSeqNumMapEntry) {
+      if ((pTrxn->seqNum == seqNum) && (pTrxn->peerIp.s_addr == peerIp->s_addr))
+        break;
+    }
+    return pTrxn;
   }
 
-  RB_GENERATE (NwGtpv2cOutstandingRxSeqNumTrxnMap, nw_gtpv2c_trxn_s, outstandingRxSeqNumMapRbtNode, nwGtpv2cCompareOutstandingRxSeqNumTrxn)
-
-/*---------------------------------------------------------------------------
-   Timer RB-tree data structure.
-  --------------------------------------------------------------------------*/
-/**
-  Comparator funtion for comparing two outstancing TX transactions.
+  nw_gtpv2c_trxn_t                         *nwGtpv2cOutstandingTxTrxnMapInsert (
+  nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_trxn_t * pTrxn) {
+    nw_gtpv2c_trxn_t                          *pCollision = NULL;
 
-  @param[in] a: Pointer to session a.
-  @param[in] b: Pointer to session b.
-  @return  An integer greater than, equal to or less than zero according to whether the
-  object pointed to by a is greater than, equal to or less than the object pointed to by b.
-*/
-  static inline int32_t                    nwGtpv2cCompareOutstandingTxRexmitTime (
-  struct nw_gtpv2c_timeout_info_s *a,
-  struct nw_gtpv2c_timeout_info_s *b) {
-    if (NW_GTPV2C_TIMER_CMP_P (&a->tvTimeout, &b->tvTimeout, >))
-      return 1;
+    pCollision = nwGtpv2cOutstandingTxTrxnMapFind (thiz, pTrxn->seqNum, &pTrxn->peerIp);
 
-    if (NW_GTPV2C_TIMER_CMP_P (&a->tvTimeout, &b->tvTimeout, <))
-      return -1;
+    if (!pCollision) {
+      LIST_INSERT_HEAD (nwGtpv2cTrxnMapBucket (thiz->outstandingTxSeqNumMap, pTrxn->seqNum, &pTrxn->peerIp), pTrxn, outstandingSeqNumMapEntry);
+    }
 
-    return 0;
+    return pCollision;
   }
 
-  RB_GENERATE (NwGtpv2cActiveTimerList, nw_gtpv2c_timeout_info_s, activeTimerListRbtNode, nwGtpv2cCompareOutstandingTxRexmitTime)
-
+  nw_gtpv2c_trxn_t                         *nwGtpv2cOutstandingRxTrxnMapInsert (
+  nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_trxn_t * pTrxn) {
+    struct nw_gtpv2c_trxn_map_bucket_s        *pBucket = NULL;
+    nw_gtpv2c_trxn_t                          *pCollision = NULL;
+
+    pBucket = nwGtpv2cTrxnMapBucket (thiz->outstandingRxSeqNumMap, pTrxn->seqNum, &pTrxn->peerIp);
+    LIST_FOREACH (pCollision, pBucket, outstandingSeqNumMapEntry) {
+      if ((pCollision->seqNum == pTrxn->seqNum) && (pCollision->peerIp.s_addr == pTrxn->peerIp.s_addr) && (pCollision->peerPort == pTrxn->peerPort))
+        return pCollision;
+    }
+    LIST_INSERT_HEAD (pBucket, pTrxn, outstandingSeqNumMapEntry);
+    return NULL;
+  }
 
+  void                                      nwGtpv2cOutstandingTrxnMapRemove (
+  __attribute__ ((unused)) nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_trxn_t * pTrxn) {
+    if (pTrxn->outstandingSeqNumMapEntry.le_prev) {
+      LIST_REMOVE (pTrxn, outstandingSeqNumMapEntry);
+      pTrxn->outstandingSeqNumMapEntry.le_prev = NULL;
+    }
+  }
 
 /**
    Send msg to peer via data request to UDP Entity
@@ -484,7 +472,7 @@ static nw_rc_t nwGtpv2cCreateLocalTunnel (
     pTunnel = nwGtpv2cTunnelNew (thiz, teid, ipv4Remote, hUlpTunnel);
 
     if (pTunnel) {
-      pCollision = RB_INSERT (NwGtpv2cTunnelMap, &(thiz->tunnelMap), pTunnel);
+      pCollision = nwGtpv2cTunnelMapInsert (thiz, pTunnel);
 
       if (pCollision) {
         rc = nwGtpv2cTunnelDelete (thiz, pTunnel);
@@ -517,8 +505,8 @@ static nw_rc_t nwGtpv2cCreateLocalTunnel (
     char                                    ipv4[INET_ADDRSTRLEN];
 
     OAILOG_FUNC_IN (LOG_GTPV2C);
-    pTunnel = RB_REMOVE (NwGtpv2cTunnelMap, &(thiz->tunnelMap), (nw_gtpv2c_tunnel_t *) hTunnel);
-    NW_ASSERT (pTunnel == (nw_gtpv2c_tunnel_t *) hTunnel);
+    NW_ASSERT (pTunnel);
+    nwGtpv2cTunnelMapRemove (thiz, pTunnel);
     inet_ntop (AF_INET, (void*)&pTunnel->ipv4AddrRemote, ipv4, INET_ADDRSTRLEN);
     OAILOG_DEBUG (LOG_GTPV2C, "Deleting local tunnel with teid '0x%x' and peer IP %s\n", pTunnel->teid, ipv4);
     rc = nwGtpv2cTunnelDelete (thiz, pTunnel);
@@ -577,9 +565,9 @@ static nw_rc_t nwGtpv2cCreateLocalTunnel (
         rc = nwGtpv2cTrxnStartPeerRspWaitTimer (pTrxn);
         NW_ASSERT (NW_OK == rc);
         /*
-         * Insert into search tree
+         * Insert into search map
          */
-        pTrxn = RB_INSERT (NwGtpv2cOutstandingTxSeqNumTrxnMap, &(thiz->outstandingTxSeqNumMap), pTrxn);
+        pTrxn = nwGtpv2cOutstandingTxTrxnMapInsert (thiz, pTrxn);
         NW_ASSERT (pTrxn == NULL);
       } else {
         rc = nwGtpv2cTrxnDelete (&pTrxn);
@@ -628,9 +616,9 @@ static nw_rc_t nwGtpv2cCreateLocalTunnel (
         rc = nwGtpv2cTrxnStartPeerRspWaitTimer (pTrxn);
         NW_ASSERT (NW_OK == rc);
         /*
-         * Insert into search tree
+         * Insert into search map
          */
-        RB_INSERT (NwGtpv2cOutstandingTxSeqNumTrxnMap, &(thiz->outstandingTxSeqNumMap), pTrxn);
+        nwGtpv2cOutstandingTxTrxnMapInsert (thiz, pTrxn);
 
         if (!pUlpReq->u_api_info.triggeredReqInfo.hTunnel) {
           rc = nwGtpv2cCreateLocalTunnel (thiz, pUlpReq->u_api_info.triggeredReqInfo.teidLocal, &pReqTrxn->peerIp,
@@ -707,7 +695,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
                               &pUlpReq->u_api_info.createLocalTunnelInfo.peerIp,
                               pUlpReq->u_api_info.triggeredRspInfo.hUlpTunnel);
   NW_ASSERT (pTunnel);
-  pCollision = RB_INSERT (NwGtpv2cTunnelMap, &(thiz->tunnelMap), pTunnel);
+  pCollision = nwGtpv2cTunnelMapInsert (thiz, pTunnel);
 
   if (pCollision) {
     rc = nwGtpv2cTunnelDelete (thiz, pTunnel);
@@ -853,8 +841,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     uint32_t                                seqNum = 0;
     uint32_t                                teidLocal = 0;
     nw_gtpv2c_trxn_t                          *pTrxn = NULL;
-    nw_gtpv2c_tunnel_t                        *pLocalTunnel = NULL,
-                                            keyTunnel = {0};
+    nw_gtpv2c_tunnel_t                        *pLocalTunnel = NULL;
     nw_gtpv2c_msg_handle_t                      hMsg = 0;
     nw_gtpv2c_ulp_tunnel_handle_t                hUlpTunnel = 0;
     nw_gtpv2c_error_t                          error = {0};
@@ -864,9 +851,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     inet_ntop (AF_INET, (void*)peerIp, ipv4, INET_ADDRSTRLEN);
 
     if (teidLocal) {
-      keyTunnel.teid = ntohl (teidLocal);
-      keyTunnel.ipv4AddrRemote.s_addr = peerIp->s_addr;
-      pLocalTunnel = RB_FIND (NwGtpv2cTunnelMap, &(thiz->tunnelMap), &keyTunnel);
+      pLocalTunnel = nwGtpv2cTunnelMapFind (thiz, ntohl (teidLocal), peerIp);
 
       if (!pLocalTunnel) {
         OAILOG_WARNING (LOG_GTPV2C,  "Request message received on non-existent teid 0x%x from peer %s received! Discarding.\n", ntohl (teidLocal), ipv4);
@@ -911,14 +896,13 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
   NW_IN uint16_t peerPort,
   NW_IN struct in_addr* peerIp) {
     nw_rc_t                                   rc = NW_FAILURE;
-    nw_gtpv2c_trxn_t                          *pTrxn = NULL,
-                                            keyTrxn;
+    nw_gtpv2c_trxn_t                          *pTrxn = NULL;
     nw_gtpv2c_msg_handle_t                      hMsg = 0;
     nw_gtpv2c_error_t                          error = {0};
+    uint32_t                                seqNum = 0;
 
-    keyTrxn.seqNum = ntohl (*((uint32_t *) (msgBuf + (((*msgBuf) & 0x08) ? 8 : 4)))) >> 8;;
-    keyTrxn.peerIp.s_addr = peerIp->s_addr;
-    pTrxn = RB_FIND (NwGtpv2cOutstandingTxSeqNumTrxnMap, &(thiz->outstandingTxSeqNumMap), &keyTrxn);
+    seqNum = ntohl (*((uint32_t *) (msgBuf + (((*msgBuf) & 0x08) ? 8 : 4)))) >> 8;
+    pTrxn = nwGtpv2cOutstandingTxTrxnMapFind (thiz, seqNum, peerIp);
 
     if (pTrxn) {
       uint32_t                                hUlpTrxn;
@@ -926,7 +910,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
 
       hUlpTrxn = pTrxn->hUlpTrxn;
       hUlpTunnel = (pTrxn->hTunnel ? ((nw_gtpv2c_tunnel_t *) (pTrxn->hTunnel))->hUlpTunnel : 0);
-      RB_REMOVE (NwGtpv2cOutstandingTxSeqNumTrxnMap, &(thiz->outstandingTxSeqNumMap), pTrxn);
+      nwGtpv2cOutstandingTrxnMapRemove (thiz, pTrxn);
       rc = nwGtpv2cTrxnDelete (&pTrxn);
       NW_ASSERT (NW_OK == rc);
       NW_ASSERT (msgBuf && msgBufLen);
@@ -962,20 +946,32 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     nw_rc_t                                   rc = NW_OK;
     nw_gtpv2c_stack_t                         *thiz = NULL;
 
-    thiz = (nw_gtpv2c_stack_t *) malloc (sizeof (nw_gtpv2c_stack_t));
-    memset (thiz, 0, sizeof (nw_gtpv2c_stack_t));
+    thiz = (nw_gtpv2c_stack_t *) calloc (1, sizeof (nw_gtpv2c_stack_t));
 
     if (thiz) {
       OAI_GCC_DIAG_OFF(pointer-to-int-cast);
       thiz->id = (uint32_t) thiz;
       thiz->seqNum = ((uint32_t) thiz) & 0x0000FFFF;
       OAI_GCC_DIAG_ON(pointer-to-int-cast);
-      RB_INIT (&(thiz->tunnelMap));
-      RB_INIT (&(thiz->outstandingTxSeqNumMap));
-      RB_INIT (&(thiz->outstandingRxSeqNumMap));
-      RB_INIT (&(thiz->activeTimerList));
+      thiz->config.seqNumStart = 0;
+      thiz->config.seqNumStep = 1;
+      /*
+       * Buckets are zeroed, i.e. empty lists
+       */
+      thiz->tunnelMap = calloc (1 << NW_GTPV2C_TUNNEL_MAP_BITS, sizeof (struct nw_gtpv2c_tunnel_map_bucket_s));
+      thiz->outstandingTxSeqNumMap = calloc (1 << NW_GTPV2C_TRXN_MAP_BITS, sizeof (struct nw_gtpv2c_trxn_map_bucket_s));
+      thiz->outstandingRxSeqNumMap = calloc (1 << NW_GTPV2C_TRXN_MAP_BITS, sizeof (struct nw_gtpv2c_trxn_map_bucket_s));
+      NW_ASSERT (thiz->tunnelMap && thiz->outstandingTxSeqNumMap && thiz->outstandingRxSeqNumMap);
+      rc = nwGtpv2cPoolInit (&thiz->msgPool, sizeof (nw_gtpv2c_msg_t), NW_GTPV2C_MSG_POOL_SLAB_SIZE);
+      NW_ASSERT (NW_OK == rc);
+      rc = nwGtpv2cPoolInit (&thiz->trxnPool, sizeof (nw_gtpv2c_trxn_t), NW_GTPV2C_TRXN_POOL_SLAB_SIZE);
+      NW_ASSERT (NW_OK == rc);
+      rc = nwGtpv2cPoolInit (&thiz->tunnelPool, sizeof (nw_gtpv2c_tunnel_t), NW_GTPV2C_TUNNEL_POOL_SLAB_SIZE);
+      NW_ASSERT (NW_OK == rc);
+      rc = nwGtpv2cPoolInit (&thiz->timeoutInfoPool, sizeof (nw_gtpv2c_timeout_info_t), NW_GTPV2C_TIMEOUT_INFO_POOL_SLAB_SIZE);
+      NW_ASSERT (NW_OK == rc);
       OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-      thiz->hTmrMinHeap = (NwPtrT) nwGtpv2cTmrMinHeapNew (10000);
+      thiz->hTmrMinHeap = (NwPtrT) nwGtpv2cTmrMinHeapNew (NW_GTPV2C_TIMEOUT_INFO_POOL_SLAB_SIZE);
       OAI_GCC_DIAG_ON(pointer-to-int-cast);
       NW_GTPV2C_INIT_MSG_IE_PARSE_INFO (thiz, NW_GTP_ECHO_RSP);
       /*
@@ -1050,11 +1046,19 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
 //    nwGtpv2cMsgIeParseInfoDelete(((NwGtpv2cStackT*)hGtpcStackHandle)->pGtpv2cMsgIeParseInfo[NW_GTP_IDENTIFICATION_REQ]);
 //    nwGtpv2cMsgIeParseInfoDelete(((NwGtpv2cStackT*)hGtpcStackHandle)->pGtpv2cMsgIeParseInfo[NW_GTP_IDENTIFICATION_RSP]);
 
+    nw_gtpv2c_stack_t                         *thiz = (nw_gtpv2c_stack_t *) hGtpcStackHandle;
+
     OAI_GCC_DIAG_OFF(int-to-pointer-cast);
-    nwGtpv2cTmrMinHeapDelete((NwGtpv2cTmrMinHeapT*)((nw_gtpv2c_stack_t*)hGtpcStackHandle)->hTmrMinHeap);
+    nwGtpv2cTmrMinHeapDelete((NwGtpv2cTmrMinHeapT*)thiz->hTmrMinHeap);
     OAI_GCC_DIAG_ON(int-to-pointer-cast);
-
-    free_wrapper ((void**)&hGtpcStackHandle);
+    free_wrapper ((void**)&thiz->tunnelMap);
+    free_wrapper ((void**)&thiz->outstandingTxSeqNumMap);
+    free_wrapper ((void**)&thiz->outstandingRxSeqNumMap);
+    nwGtpv2cPoolFinalize (&thiz->msgPool);
+    nwGtpv2cPoolFinalize (&thiz->trxnPool);
+    nwGtpv2cPoolFinalize (&thiz->tunnelPool);
+    nwGtpv2cPoolFinalize (&thiz->timeoutInfoPool);
+    free_wrapper ((void**)&thiz);
     return NW_OK;
   }
 
@@ -1153,6 +1157,42 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     return NW_OK;
   }
 
+/**
+  Set configuration of the stack.
+*/
+
+  nw_rc_t                                   nwGtpv2cConfigSet (
+  NW_IN nw_gtpv2c_stack_handle_t * phGtpcStackHandle,
+  NW_IN nw_gtpv2c_stack_config_t * pConfig) {
+    nw_gtpv2c_stack_t                         *thiz = (nw_gtpv2c_stack_t *) (*phGtpcStackHandle);
+
+    if ((!pConfig) || (!pConfig->seqNumStep) || (pConfig->seqNumStart >= 0x800000))
+      return NW_FAILURE;
+
+    thiz->config = *(pConfig);
+    /*
+     * Local sequence numbers are seqNumStart + k * seqNumStep
+     */
+    thiz->seqNum = thiz->config.seqNumStart;
+    return NW_OK;
+  }
+
+/**
+  Get configuration of the stack.
+*/
+
+  nw_rc_t                                   nwGtpv2cConfigGet (
+  NW_IN nw_gtpv2c_stack_handle_t * phGtpcStackHandle,
+  NW_OUT nw_gtpv2c_stack_config_t * pConfig) {
+    nw_gtpv2c_stack_t                         *thiz = (nw_gtpv2c_stack_t *) (*phGtpcStackHandle);
+
+    if (!pConfig)
+      return NW_FAILURE;
+
+    *(pConfig) = thiz->config;
+    return NW_OK;
+  }
+
 /**
    Process Request from Udp Layer
 */
@@ -1303,64 +1343,26 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
   }
 
 /**
-   Process Timer timeout Request from Timer ULP Manager
+   Give back an expired timer to the pool and call its handler.
 */
 
-  nw_rc_t                                   nwGtpv2cProcessTimeoutOld (
-  void *arg) {
-    nw_rc_t                                   rc = NW_FAILURE;
-    nw_gtpv2c_stack_t                         *thiz = NULL;
-    nw_gtpv2c_timeout_info_t                   *timeoutInfo = (nw_gtpv2c_timeout_info_t *) arg;
-    nw_gtpv2c_timeout_info_t                   *pNextTimeoutInfo = NULL;
-    struct timeval                          tv = {0};
-
-    NW_ASSERT (timeoutInfo != NULL);
-    thiz = (nw_gtpv2c_stack_t *) (((nw_gtpv2c_timeout_info_t *) timeoutInfo)->hStack);
-    NW_ASSERT (thiz != NULL);
-    OAILOG_FUNC_IN (LOG_GTPV2C);
-
-    if (thiz->activeTimerInfo == timeoutInfo) {
-      thiz->activeTimerInfo = NULL;
-      RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
-      rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
-    } else {
-      OAILOG_WARNING (LOG_GTPV2C,  "Received timeout event from ULP for non-existent timeoutInfo 0x%p and activeTimer 0x%p!\n", timeoutInfo, thiz->activeTimerInfo);
-      OAILOG_FUNC_RETURN (LOG_GTPV2C, NW_OK);
-    }
-
-    NW_ASSERT (gettimeofday (&tv, NULL) == 0);
-
-    for ((timeoutInfo) = RB_MIN (NwGtpv2cActiveTimerList, &(thiz->activeTimerList)); (timeoutInfo) != NULL;) {
-      if (NW_GTPV2C_TIMER_CMP_P (&timeoutInfo->tvTimeout, &tv, >))
-        break;
-
-      pNextTimeoutInfo = RB_NEXT (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-      RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
-      rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
-      timeoutInfo = pNextTimeoutInfo;
-    }
+  static nw_rc_t                            nwGtpv2cTimeoutInfoExpire (
+  nw_gtpv2c_stack_t * thiz,
+  nw_gtpv2c_timeout_info_t * timeoutInfo) {
+    nw_rc_t                                   (*timeoutCallbackFunc) (void *) = timeoutInfo->timeoutCallbackFunc;
+    void                                   *timeoutArg = timeoutInfo->timeoutArg;
 
     /*
-     * activeTimerInfo may be reset by the timeoutCallbackFunc call above
+     * Released first since the handler may restart a timer
      */
-    if (thiz->activeTimerInfo == NULL) {
-      timeoutInfo = RB_MIN (NwGtpv2cActiveTimerList, &(thiz->activeTimerList));
-
-      if (timeoutInfo) {
-        NW_GTPV2C_TIMER_SUB (&timeoutInfo->tvTimeout, &tv, &tv);
-        rc = thiz->tmrMgr.tmrStartCallback (thiz->tmrMgr.tmrMgrHandle, tv.tv_sec, tv.tv_usec, timeoutInfo->tmrType, (void *)timeoutInfo, &timeoutInfo->hTimer);
-        NW_ASSERT (NW_OK == rc);
-        thiz->activeTimerInfo = timeoutInfo;
-      }
-    }
-
-    OAILOG_FUNC_RETURN (LOG_GTPV2C, rc);
+    nwGtpv2cPoolFree (&thiz->timeoutInfoPool, timeoutInfo);
+    return timeoutCallbackFunc (timeoutArg);
   }
 
+/**
+   Process Timer timeout Request from Timer ULP Manager
+*/
+
   nw_rc_t                                   nwGtpv2cProcessTimeout (
   void *arg) {
     nw_rc_t                                   rc = NW_FAILURE;
@@ -1378,9 +1380,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT*)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
-      rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
+      rc = nwGtpv2cTimeoutInfoExpire (thiz, timeoutInfo);
     } else {
       OAILOG_WARNING (LOG_GTPV2C,  "Received timeout event from ULP for " "non-existent timeoutInfo 0x%p and activeTimer 0x%p!\n", timeoutInfo, thiz->activeTimerInfo);
       OAILOG_FUNC_RETURN (LOG_GTPV2C, NW_OK);
@@ -1399,9 +1399,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
-      timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = timeoutInfo;
-      rc = ((timeoutInfo)->timeoutCallbackFunc) (timeoutInfo->timeoutArg);
+      rc = nwGtpv2cTimeoutInfoExpire (thiz, timeoutInfo);
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       timeoutInfo = nwGtpv2cTmrMinHeapPeek ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
@@ -1448,12 +1446,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
 
     OAILOG_FUNC_IN (LOG_GTPV2C);
 
-    if (gpGtpv2cTimeoutInfoPool) {
-      timeoutInfo = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = gpGtpv2cTimeoutInfoPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (thiz, sizeof (nw_gtpv2c_timeout_info_t), timeoutInfo, nw_gtpv2c_timeout_info_t *);
-    }
+    timeoutInfo = (nw_gtpv2c_timeout_info_t *) nwGtpv2cPoolAlloc (&thiz->timeoutInfoPool);
 
     if (timeoutInfo) {
       timeoutInfo->tmrType = tmrType;
@@ -1461,102 +1454,12 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
       timeoutInfo->timeoutCallbackFunc = timeoutCallbackFunc;
       timeoutInfo->hStack = (nw_gtpv2c_stack_handle_t) thiz;
       NW_ASSERT (gettimeofday (&tv, NULL) == 0);
-      NW_ASSERT (gettimeofday (&timeoutInfo->tvTimeout, NULL) == 0);
       timeoutInfo->tvTimeout.tv_sec = timeoutSec;
       timeoutInfo->tvTimeout.tv_usec = timeoutUsec;
       NW_GTPV2C_TIMER_ADD (&tv, &timeoutInfo->tvTimeout, &timeoutInfo->tvTimeout);
       OAI_GCC_DIAG_OFF(int-to-pointer-cast);
       rc = nwGtpv2cTmrMinHeapInsert ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap, timeoutInfo);
       OAI_GCC_DIAG_ON(int-to-pointer-cast);
-#if 0
-
-      do {
-        collision = RB_INSERT (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-
-        if (!collision)
-          break;
-
-        OAILOG_WARNING (LOG_GTPV2C,  "timer collision!\n");
-        timeoutInfo->tvTimeout.tv_usec++;       /* HACK: In case there is a collision, schedule this event 1 usec later */
-
-        if (timeoutInfo->tvTimeout.tv_usec > (999999 /*1000000 - 1 */ )) {
-          timeoutInfo->tvTimeout.tv_usec = 0;
-          timeoutInfo->tvTimeout.tv_sec++;
-        }
-      } while (1);
-
-#endif
-
-      if (thiz->activeTimerInfo) {
-        if (NW_GTPV2C_TIMER_CMP_P (&(thiz->activeTimerInfo->tvTimeout), &(timeoutInfo->tvTimeout), >)) {
-          OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", thiz->activeTimerInfo->hTimer, thiz->activeTimerInfo);
-          rc = thiz->tmrMgr.tmrStopCallback (thiz->tmrMgr.tmrMgrHandle, thiz->activeTimerInfo->hTimer);
-          NW_ASSERT (NW_OK == rc);
-        } else {
-          OAILOG_DEBUG (LOG_GTPV2C, "Already Started timer 0x%" PRIxPTR " for info 0x%p!\n", thiz->activeTimerInfo->hTimer, thiz->activeTimerInfo);
-          *phTimer = (nw_gtpv2c_timer_handle_t) timeoutInfo;
-          OAILOG_FUNC_RETURN (LOG_GTPV2C, NW_OK);
-        }
-      }
-
-      rc = thiz->tmrMgr.tmrStartCallback (thiz->tmrMgr.tmrMgrHandle, timeoutSec, timeoutUsec, tmrType, (void *)timeoutInfo, &timeoutInfo->hTimer);
-      OAILOG_DEBUG (LOG_GTPV2C, "Started timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
-      NW_ASSERT (NW_OK == rc);
-      thiz->activeTimerInfo = timeoutInfo;
-    }
-
-    *phTimer = (nw_gtpv2c_timer_handle_t) timeoutInfo;
-    OAILOG_FUNC_RETURN (LOG_GTPV2C, rc);
-  }
-
-  nw_rc_t                                   nwGtpv2cStartTimerOld (
-  nw_gtpv2c_stack_t * thiz,
-  uint32_t timeoutSec,
-  uint32_t timeoutUsec,
-  uint32_t tmrType,
-  nw_rc_t                                   (*timeoutCallbackFunc) (void *),
-  void *timeoutCallbackArg,
-  nw_gtpv2c_timer_handle_t * phTimer) {
-    nw_rc_t                                   rc = NW_OK;
-    struct timeval                          tv;
-    nw_gtpv2c_timeout_info_t                   *timeoutInfo;
-    nw_gtpv2c_timeout_info_t                   *collision;
-
-    NW_ASSERT (thiz != NULL);
-    OAILOG_FUNC_IN (LOG_GTPV2C);
-
-    if (gpGtpv2cTimeoutInfoPool) {
-      timeoutInfo = gpGtpv2cTimeoutInfoPool;
-      gpGtpv2cTimeoutInfoPool = gpGtpv2cTimeoutInfoPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (thiz, sizeof (nw_gtpv2c_timeout_info_t), timeoutInfo, nw_gtpv2c_timeout_info_t *);
-    }
-
-    if (timeoutInfo) {
-      timeoutInfo->tmrType = tmrType;
-      timeoutInfo->timeoutArg = timeoutCallbackArg;
-      timeoutInfo->timeoutCallbackFunc = timeoutCallbackFunc;
-      timeoutInfo->hStack = (nw_gtpv2c_stack_handle_t) thiz;
-      NW_ASSERT (gettimeofday (&tv, NULL) == 0);
-      NW_ASSERT (gettimeofday (&timeoutInfo->tvTimeout, NULL) == 0);
-      timeoutInfo->tvTimeout.tv_sec = timeoutSec;
-      timeoutInfo->tvTimeout.tv_usec = timeoutUsec;
-      NW_GTPV2C_TIMER_ADD (&tv, &timeoutInfo->tvTimeout, &timeoutInfo->tvTimeout);
-
-      do {
-        collision = RB_INSERT (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-
-        if (!collision)
-          break;
-
-        OAILOG_WARNING (LOG_GTPV2C,  "timer collision!\n");
-        timeoutInfo->tvTimeout.tv_usec++;       /* HACK: In case there is a collision, schedule this event 1 usec later */
-
-        if (timeoutInfo->tvTimeout.tv_usec > (999999 /*1000000 - 1 */ )) {
-          timeoutInfo->tvTimeout.tv_usec = 0;
-          timeoutInfo->tvTimeout.tv_sec++;
-        }
-      } while (1);
 
       if (thiz->activeTimerInfo) {
         if (NW_GTPV2C_TIMER_CMP_P (&(thiz->activeTimerInfo->tvTimeout), &(timeoutInfo->tvTimeout), >)) {
@@ -1596,8 +1499,7 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     OAI_GCC_DIAG_OFF(int-to-pointer-cast);
     rc = nwGtpv2cTmrMinHeapRemove ((NwGtpv2cTmrMinHeapT *)thiz->hTmrMinHeap, timeoutInfo->timerMinHeapIndex);
     OAI_GCC_DIAG_ON(int-to-pointer-cast);
-    timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-    gpGtpv2cTimeoutInfoPool = timeoutInfo;
+    nwGtpv2cPoolFree (&thiz->timeoutInfoPool, timeoutInfo);
     OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
 
     if (thiz->activeTimerInfo == timeoutInfo) {
@@ -1631,46 +1533,16 @@ static nw_rc_t nwGtpv2cHandleUlpCreateLocalTunnel (NW_IN nw_gtpv2c_stack_t * thi
     OAILOG_FUNC_RETURN (LOG_GTPV2C, rc);
   }
 
-  nw_rc_t                                   nwGtpv2cStopTimerOld (
-  nw_gtpv2c_stack_t * thiz,
-  nw_gtpv2c_timer_handle_t hTimer) {
-    nw_rc_t                                   rc = NW_OK;
-    struct timeval                          tv;
-    nw_gtpv2c_timeout_info_t                   *timeoutInfo;
-
-    NW_ASSERT (thiz != NULL);
-    OAILOG_FUNC_IN (LOG_GTPV2C);
-    timeoutInfo = (nw_gtpv2c_timeout_info_t *) hTimer;
-    RB_REMOVE (NwGtpv2cActiveTimerList, &(thiz->activeTimerList), timeoutInfo);
-    timeoutInfo->next = gpGtpv2cTimeoutInfoPool;
-    gpGtpv2cTimeoutInfoPool = timeoutInfo;
-    OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
-
-    if (thiz->activeTimerInfo == timeoutInfo) {
-      OAILOG_DEBUG (LOG_GTPV2C, "Stopping active timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
-      rc = thiz->tmrMgr.tmrStopCallback (thiz->tmrMgr.tmrMgrHandle, timeoutInfo->hTimer);
-      thiz->activeTimerInfo = NULL;
-      NW_ASSERT (NW_OK == rc);
-      timeoutInfo = RB_MIN (NwGtpv2cActiveTimerList, &(thiz->activeTimerList));
-
-      if (timeoutInfo) {
-        NW_ASSERT (gettimeofday (&tv, NULL) == 0);
+/**
+   Get the stack owning a transaction
+*/
 
-        if (NW_GTPV2C_TIMER_CMP_P (&timeoutInfo->tvTimeout, &tv, <)) {
-          thiz->activeTimerInfo = timeoutInfo;
-          rc = nwGtpv2cProcessTimeout (timeoutInfo);
-          NW_ASSERT (NW_OK == rc);
-        } else {
-          NW_GTPV2C_TIMER_SUB (&timeoutInfo->tvTimeout, &tv, &tv);
-          rc = thiz->tmrMgr.tmrStartCallback (thiz->tmrMgr.tmrMgrHandle, tv.tv_sec, tv.tv_usec, timeoutInfo->tmrType, (void *)timeoutInfo, &timeoutInfo->hTimer);
-          NW_ASSERT (NW_OK == rc);
-          OAILOG_DEBUG (LOG_GTPV2C, "Started timer 0x%" PRIxPTR " for info 0x%p!\n", timeoutInfo->hTimer, timeoutInfo);
-          thiz->activeTimerInfo = timeoutInfo;
-        }
-      }
-    }
+  nw_gtpv2c_stack_handle_t                  nwGtpv2cTrxnGetStackHandle (
+  NW_IN nw_gtpv2c_trxn_handle_t hTrxn) {
+    nw_gtpv2c_trxn_t                          *pTrxn = (nw_gtpv2c_trxn_t *) hTrxn;
 
-    OAILOG_FUNC_RETURN (LOG_GTPV2C, rc);
+    NW_ASSERT (pTrxn != NULL);
+    return (nw_gtpv2c_stack_handle_t) pTrxn->pStack;
   }
 
 #ifdef __cplusplus
@@ -32,6 +32,7 @@
   ----------------------------------------------------------------------------*/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <inttypes.h>
@@ -47,6 +48,7 @@
 #include "NwGtpv2cPrivate.h"
 #include "NwGtpv2cIe.h"
 #include "NwGtpv2cMsg.h"
+#include "dynamic_memory_check.h"
 #include "log.h"
 
 #ifdef __cplusplus
@@ -54,12 +56,6 @@ extern                                  "C" {
 #endif
 
 
-/*----------------------------------------------------------------------------*
-                       P R I V A T E     F U N C T I O N S
-  ----------------------------------------------------------------------------*/
-
-  static nw_gtpv2c_msg_t                    *gpGtpv2cMsgPool = NULL;
-
 /*----------------------------------------------------------------------------*
                          P U B L I C   F U N C T I O N S
   ----------------------------------------------------------------------------*/
@@ -76,12 +72,7 @@ extern                                  "C" {
                                             NW_ASSERT (
   pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (nw_gtpv2c_msg_t), pMsg, nw_gtpv2c_msg_t *);
-    }
+    pMsg = (nw_gtpv2c_msg_t *) nwGtpv2cPoolAlloc (&pStack->msgPool);
 
     if (pMsg) {
       pMsg->version = NW_GTP_VERSION;
@@ -110,12 +101,7 @@ extern                                  "C" {
 
     NW_ASSERT (pStack);
 
-    if (gpGtpv2cMsgPool) {
-      pMsg = gpGtpv2cMsgPool;
-      gpGtpv2cMsgPool = gpGtpv2cMsgPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (pStack, sizeof (nw_gtpv2c_msg_t), pMsg, nw_gtpv2c_msg_t *);
-    }
+    pMsg = (nw_gtpv2c_msg_t *) nwGtpv2cPoolAlloc (&pStack->msgPool);
 
     if (pMsg) {
       *phMsg = (nw_gtpv2c_msg_handle_t) pMsg;
@@ -145,11 +131,11 @@ extern                                  "C" {
   nw_rc_t                                   nwGtpv2cMsgDelete (
   NW_IN nw_gtpv2c_stack_handle_t hGtpcStackHandle,
   NW_IN nw_gtpv2c_msg_handle_t hMsg) {
-    // warning: unused variable ‘pStack’ [-Wunused-variable]: NwGtpv2cStackT                         *pStack = (NwGtpv2cStackT *) hGtpcStackHandle;
+    nw_gtpv2c_stack_t                         *pStack = (nw_gtpv2c_stack_t *) hGtpcStackHandle;
 
+    NW_ASSERT (pStack);
     OAILOG_DEBUG (LOG_GTPV2C, "Purging message %" PRIxPTR "!\n", hMsg);
-    ((nw_gtpv2c_msg_t *) hMsg)->next = gpGtpv2cMsgPool;
-    gpGtpv2cMsgPool = (nw_gtpv2c_msg_t *) hMsg;
+    nwGtpv2cPoolFree (&pStack->msgPool, (nw_gtpv2c_msg_t *) hMsg);
     return NW_OK;
   }
 
@@ -366,6 +352,70 @@ extern                                  "C" {
     return NW_OK;
   }
 
+  nw_rc_t                                   nwGtpv2cMsgIeTemplateStart (
+  NW_OUT nw_gtpv2c_msg_handle_t * phMsg) {
+    nw_gtpv2c_msg_t                           *pMsg;
+
+    /*
+     * Not taken from a stack pool: templates are built once, before or outside the stacks threads.
+     */
+    pMsg = (nw_gtpv2c_msg_t *) calloc (1, sizeof (nw_gtpv2c_msg_t));
+
+    if (pMsg) {
+      pMsg->version = NW_GTP_VERSION;
+      pMsg->msgLen = 0;
+      *phMsg = (nw_gtpv2c_msg_handle_t) pMsg;
+      return NW_OK;
+    }
+
+    return NW_FAILURE;
+  }
+
+  nw_rc_t                                   nwGtpv2cMsgIeTemplateEnd (
+  NW_IN nw_gtpv2c_msg_handle_t hMsg,
+  NW_OUT nw_gtpv2c_ie_template_t * pTemplate) {
+    nw_gtpv2c_msg_t                           *pMsg = (nw_gtpv2c_msg_t *) hMsg;
+    nw_rc_t                                   rc = NW_FAILURE;
+
+    NW_ASSERT (pMsg);
+    NW_ASSERT (pMsg->groupedIeEncodeStack.top == 0);
+
+    if (pMsg->msgLen <= NW_GTPV2C_IE_TEMPLATE_MAX_LEN) {
+      memcpy (pTemplate->buf, pMsg->msgBuf, pMsg->msgLen);
+      pTemplate->len = pMsg->msgLen;
+      rc = NW_OK;
+    } else {
+      OAILOG_ERROR (LOG_GTPV2C, "IE template of %u bytes exceeds %u bytes\n", pMsg->msgLen, NW_GTPV2C_IE_TEMPLATE_MAX_LEN);
+    }
+
+    free_wrapper ((void**)&pMsg);
+    return rc;
+  }
+
+  nw_rc_t                                   nwGtpv2cMsgAddIeTemplate (
+  NW_IN nw_gtpv2c_msg_handle_t hMsg,
+  NW_IN const nw_gtpv2c_ie_template_t * pTemplate,
+  NW_OUT uint8_t ** ppIe) {
+    nw_gtpv2c_msg_t                           *pMsg = (nw_gtpv2c_msg_t *) hMsg;
+
+    if (pMsg->msgLen + pTemplate->len > NW_GTPV2C_MAX_MSG_LEN)
+      return NW_FAILURE;
+
+    *ppIe = pMsg->msgBuf + pMsg->msgLen;
+
+    /*
+     * A constant size copy is a few vector moves, a variable size one ends up in rep movs or a libc call
+     * costing more than the whole encoding: copy the full template buffer when the message has room for it.
+     */
+    if (pMsg->msgLen + NW_GTPV2C_IE_TEMPLATE_MAX_LEN <= NW_GTPV2C_MAX_MSG_LEN)
+      memcpy (*ppIe, pTemplate->buf, NW_GTPV2C_IE_TEMPLATE_MAX_LEN);
+    else
+      memcpy (*ppIe, pTemplate->buf, pTemplate->len);
+
+    pMsg->msgLen += pTemplate->len;
+    return NW_OK;
+  }
+
   nw_rc_t                                   nwGtpv2cMsgAddIeCause (
   NW_IN nw_gtpv2c_msg_handle_t hMsg,
   NW_IN uint8_t instance,
@@ -266,6 +266,167 @@ extern                                  "C" {
     return rc;
   }
 
+/**
+   Compile a parser descriptor: IE descriptors are chained by IE type so that a received IE is
+   looked up with one table access and a short walk over its instances.
+*/
+
+  nw_rc_t                                   nwGtpv2cMsgParserDescInit (
+  NW_OUT nw_gtpv2c_msg_parser_desc_t * thiz,
+  NW_IN uint16_t msgType,
+  NW_IN const nw_gtpv2c_ie_parse_desc_t * pIeDesc,
+  NW_IN uint8_t numIe) {
+    uint8_t                                 i,
+                                            j;
+
+    NW_ASSERT (thiz);
+    NW_ASSERT (numIe <= NW_GTPV2C_MSG_PARSER_DESC_MAX_IE);
+    memset (thiz, 0, sizeof (nw_gtpv2c_msg_parser_desc_t));
+    thiz->msgType = msgType;
+    thiz->numIe = numIe;
+    thiz->pIeDesc = pIeDesc;
+
+    /*
+     * Walk backwards so that each chain keeps the declaration order
+     */
+    for (i = numIe; i > 0; i--) {
+      for (j = thiz->ieIndex[pIeDesc[i - 1].ieType]; j; j = thiz->ieNext[j - 1]) {
+        if (pIeDesc[j - 1].ieInstance == pIeDesc[i - 1].ieInstance) {
+          OAILOG_ERROR (LOG_GTPV2C, "Cannot add IE to parser of msg %u for type %u and instance %u. IE info already exists!\n",
+                        msgType, pIeDesc[i - 1].ieType, pIeDesc[i - 1].ieInstance);
+          return NW_FAILURE;
+        }
+      }
+
+      thiz->ieNext[i - 1] = thiz->ieIndex[pIeDesc[i - 1].ieType];
+      thiz->ieIndex[pIeDesc[i - 1].ieType] = i;
+
+      if (pIeDesc[i - 1].iePresence == NW_GTPV2C_IE_PRESENCE_MANDATORY) {
+        thiz->mandatoryIeCount++;
+      }
+    }
+
+    return NW_OK;
+  }
+
+/**
+   Parse the IEs found between pIeStart and pIeEnd into pOut, recursing into grouped IEs.
+*/
+
+  static nw_rc_t                            nwGtpv2cMsgParserDescParseIes (
+  NW_IN const nw_gtpv2c_msg_parser_desc_t * thiz,
+  NW_IN uint8_t * pIeStart,
+  NW_IN uint8_t * pIeEnd,
+  NW_OUT uint8_t * pOut,
+  NW_OUT uint8_t * pOffendingIeType,
+  NW_OUT uint8_t * pOffendingIeInstance,
+  NW_OUT uint16_t * pOffendingIeLength) {
+    nw_rc_t                                   rc = NW_OK;
+    uint32_t                                receivedIes = 0;
+    uint16_t                                mandatoryIeCount = 0;
+    uint16_t                                ieLength;
+    uint8_t                                 i;
+    nw_gtpv2c_ie_tlv_t                         *pIe;
+    const nw_gtpv2c_ie_parse_desc_t            *pIeDesc;
+
+    while (pIeStart < pIeEnd) {
+      pIe = (nw_gtpv2c_ie_tlv_t *) pIeStart;
+
+      if ((pIeStart + sizeof (nw_gtpv2c_ie_tlv_t) > pIeEnd) ||
+          (pIeStart + sizeof (nw_gtpv2c_ie_tlv_t) + ntohs (pIe->l) > pIeEnd)) {
+        *pOffendingIeType = pIe->t;
+        *pOffendingIeLength = pIe->l;
+        *pOffendingIeInstance = pIe->i;
+        return NW_GTPV2C_MSG_MALFORMED;
+      }
+
+      ieLength = ntohs (pIe->l);
+
+      for (i = thiz->ieIndex[pIe->t]; i; i = thiz->ieNext[i - 1]) {
+        if (thiz->pIeDesc[i - 1].ieInstance == pIe->i)
+          break;
+      }
+
+      if (i) {
+        pIeDesc = &thiz->pIeDesc[i - 1];
+
+        if (pIeDesc->pGroupedIeDesc) {
+          uint8_t                                *pCount = pOut + pIeDesc->ieCountOffset;
+
+          if (*pCount < pIeDesc->ieMaxCount) {
+            rc = nwGtpv2cMsgParserDescParseIes (pIeDesc->pGroupedIeDesc, pIeStart + 4, pIeStart + 4 + ieLength,
+                                                pOut + pIeDesc->ieOffset + (*pCount) * pIeDesc->ieElementSize,
+                                                pOffendingIeType, pOffendingIeInstance, pOffendingIeLength);
+
+            if (NW_OK == rc) {
+              (*pCount)++;
+            } else {
+              return rc;
+            }
+          } else {
+            OAILOG_WARNING (LOG_GTPV2C, "Ignoring grouped IE %u instance %u in msg %u, already %u received!\n", pIe->t, pIe->i, thiz->msgType, *pCount);
+          }
+        } else if (pIeDesc->ieReadCallback) {
+          rc = pIeDesc->ieReadCallback (pIe->t, ieLength, pIe->i, pIeStart + 4, pOut + pIeDesc->ieOffset);
+
+          if (NW_OK != rc) {
+            OAILOG_ERROR (LOG_GTPV2C, "Error while parsing IE %u with instance %u and length %u!\n", pIe->t, pIe->i, ieLength);
+            *pOffendingIeType = pIe->t;
+            *pOffendingIeLength = ieLength;
+            *pOffendingIeInstance = pIe->i;
+            return rc;
+          }
+        } else {
+          OAILOG_DEBUG (LOG_GTPV2C, "Received IE %u of length %u!\n", pIe->t, ieLength);
+        }
+
+        if ((pIeDesc->iePresence == NW_GTPV2C_IE_PRESENCE_MANDATORY) && !(receivedIes & (1u << (i - 1)))) {
+          mandatoryIeCount++;
+        }
+
+        receivedIes |= (1u << (i - 1));
+      } else {
+        OAILOG_WARNING (LOG_GTPV2C, "Unexpected IE %u of length %u received in msg %u!\n", pIe->t, ieLength, thiz->msgType);
+      }
+
+      pIeStart += (ieLength + 4);
+    }
+
+    if (mandatoryIeCount != thiz->mandatoryIeCount) {
+      for (i = 0; i < thiz->numIe; i++) {
+        if ((thiz->pIeDesc[i].iePresence == NW_GTPV2C_IE_PRESENCE_MANDATORY) && !(receivedIes & (1u << i))) {
+          *pOffendingIeType = thiz->pIeDesc[i].ieType;
+          *pOffendingIeInstance = thiz->pIeDesc[i].ieInstance;
+          *pOffendingIeLength = 0;
+          return NW_GTPV2C_MANDATORY_IE_MISSING;
+        }
+      }
+    }
+
+    return NW_OK;
+  }
+
+  nw_rc_t                                   nwGtpv2cMsgParserDescRun (
+  NW_IN const nw_gtpv2c_msg_parser_desc_t * thiz,
+  NW_IN nw_gtpv2c_msg_handle_t hMsg,
+  NW_OUT void *pOut,
+  NW_OUT uint8_t * pOffendingIeType,
+  NW_OUT uint8_t * pOffendingIeInstance,
+  NW_OUT uint16_t * pOffendingIeLength) {
+    nw_gtpv2c_msg_t                           *pMsg = (nw_gtpv2c_msg_t *) hMsg;
+    uint8_t                                 flags;
+
+    NW_ASSERT (thiz);
+    NW_ASSERT (pMsg);
+    NW_ASSERT (pOut);
+    flags = *((uint8_t *) (pMsg->msgBuf));
+    *pOffendingIeType = 0;
+    *pOffendingIeInstance = 0;
+    *pOffendingIeLength = 0;
+    return nwGtpv2cMsgParserDescParseIes (thiz, pMsg->msgBuf + (flags & 0x08 ? 12 : 8), pMsg->msgBuf + pMsg->msgLen,
+                                          (uint8_t *) pOut, pOffendingIeType, pOffendingIeInstance, pOffendingIeLength);
+  }
+
 #ifdef __cplusplus
 }
 #endif
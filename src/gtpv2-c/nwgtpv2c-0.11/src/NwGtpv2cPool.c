@@ -0,0 +1,133 @@
+/*----------------------------------------------------------------------------*
+ *                                                                            *
+                                n w - g t p v 2 c
+      G P R S   T u n n e l i n g    P r o t o c o l   v 2 c    S t a c k
+ *                                                                            *
+ *                                                                            *
+   Copyright (c) 2010-2011 Amit Chawre
+   All rights reserved.
+ *                                                                            *
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+ *                                                                            *
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+   3. The name of the author may not be used to endorse or promote products
+      derived from this software without specific prior written permission.
+ *                                                                            *
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  ----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "NwTypes.h"
+#include "NwUtils.h"
+#include "NwError.h"
+#include "NwGtpv2cPool.h"
+#include "log.h"
+
+#ifdef __cplusplus
+extern                                  "C" {
+#endif
+
+//------------------------------------------------------------------------------
+static nw_rc_t nwGtpv2cPoolAddSlab (nw_gtpv2c_pool_t * thiz)
+{
+  nw_gtpv2c_pool_slab_t                  *pSlab = NULL;
+  uint8_t                                *pObj = NULL;
+
+  /*
+   * Zeroed so that intrusive links of never used objects are cleared
+   */
+  pSlab = (nw_gtpv2c_pool_slab_t *) calloc (1, sizeof (nw_gtpv2c_pool_slab_t) + (thiz->objSize * thiz->objPerSlab));
+
+  if (!pSlab) {
+    OAILOG_ERROR (LOG_GTPV2C, "Failed to allocate a slab of %u objects of %zu bytes\n", thiz->objPerSlab, thiz->objSize);
+    return NW_FAILURE;
+  }
+
+  pSlab->next = thiz->pSlabList;
+  thiz->pSlabList = pSlab;
+  thiz->numSlabs++;
+  /*
+   * Push objects in reverse order, so that they are handed out in address order
+   */
+  pObj = ((uint8_t *) (pSlab + 1)) + (thiz->objSize * thiz->objPerSlab);
+
+  for (uint32_t i = 0; i < thiz->objPerSlab; i++) {
+    pObj -= thiz->objSize;
+    nwGtpv2cPoolFree (thiz, pObj);
+  }
+
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+nw_rc_t nwGtpv2cPoolInit (nw_gtpv2c_pool_t * thiz, size_t objSize, uint32_t objPerSlab)
+{
+  NW_ASSERT (objSize >= sizeof (void *));
+  NW_ASSERT (objPerSlab > 0);
+  memset (thiz, 0, sizeof (nw_gtpv2c_pool_t));
+  thiz->objSize = objSize;
+  thiz->objPerSlab = objPerSlab;
+  return nwGtpv2cPoolAddSlab (thiz);
+}
+
+//------------------------------------------------------------------------------
+void nwGtpv2cPoolFinalize (nw_gtpv2c_pool_t * thiz)
+{
+  nw_gtpv2c_pool_slab_t                  *pSlab = thiz->pSlabList;
+
+  while (pSlab) {
+    thiz->pSlabList = pSlab->next;
+    free (pSlab);
+    pSlab = thiz->pSlabList;
+  }
+
+  thiz->pFreeList = NULL;
+  thiz->numSlabs = 0;
+  thiz->numFree = 0;
+}
+
+//------------------------------------------------------------------------------
+void *nwGtpv2cPoolAlloc (nw_gtpv2c_pool_t * thiz)
+{
+  void                                   *pObj = NULL;
+
+  if (!thiz->pFreeList) {
+    OAILOG_DEBUG (LOG_GTPV2C, "Pool of %zu bytes objects exhausted, adding slab %u\n", thiz->objSize, thiz->numSlabs + 1);
+
+    if (NW_OK != nwGtpv2cPoolAddSlab (thiz)) {
+      return NULL;
+    }
+  }
+
+  pObj = thiz->pFreeList;
+  thiz->pFreeList = *((void **) pObj);
+  thiz->numFree--;
+  return pObj;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/*--------------------------------------------------------------------------*
+                        E N D     O F    F I L E
+  --------------------------------------------------------------------------*/
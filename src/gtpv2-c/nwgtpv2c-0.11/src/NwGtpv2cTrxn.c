@@ -54,8 +54,6 @@
 extern                                  "C" {
 #endif
 
-  static nw_gtpv2c_trxn_t                   *gpGtpv2cTrxnPool = NULL;
-
 /*--------------------------------------------------------------------------*
                      P R I V A T E      F U N C T I O N S
   --------------------------------------------------------------------------*/
@@ -96,7 +94,7 @@ extern                                  "C" {
       ulpApi.u_api_info.rspFailureInfo.hUlpTrxn = thiz->hUlpTrxn;
       ulpApi.u_api_info.rspFailureInfo.hUlpTunnel = ((thiz->hTunnel) ? ((nw_gtpv2c_tunnel_t *) (thiz->hTunnel))->hUlpTunnel : 0);
       OAILOG_ERROR (LOG_GTPV2C, "N3 retries expired for transaction 0x%p\n", thiz);
-      RB_REMOVE (NwGtpv2cOutstandingTxSeqNumTrxnMap, &(pStack->outstandingTxSeqNumMap), thiz);
+      nwGtpv2cOutstandingTrxnMapRemove (pStack, thiz);
       rc = nwGtpv2cTrxnDelete (&thiz);
       rc = pStack->ulp.ulpReqCallback (pStack->ulp.hUlp, &ulpApi);
     }
@@ -116,7 +114,7 @@ extern                                  "C" {
     NW_ASSERT (pStack);
     OAILOG_DEBUG (LOG_GTPV2C,  "Duplicate request hold timer expired for transaction 0x%p\n", thiz);
     thiz->hRspTmr = 0;
-    RB_REMOVE (NwGtpv2cOutstandingRxSeqNumTrxnMap, &(pStack->outstandingRxSeqNumMap), thiz);
+    nwGtpv2cOutstandingTrxnMapRemove (pStack, thiz);
     rc = nwGtpv2cTrxnDelete (&thiz);
     NW_ASSERT (NW_OK == rc);
     return rc;
@@ -185,14 +183,10 @@ extern                                  "C" {
   NW_IN nw_gtpv2c_stack_t * thiz) {
     nw_gtpv2c_trxn_t                          *pTrxn;
 
-    if (gpGtpv2cTrxnPool) {
-      pTrxn = gpGtpv2cTrxnPool;
-      gpGtpv2cTrxnPool = gpGtpv2cTrxnPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (thiz, sizeof (nw_gtpv2c_trxn_t), pTrxn, nw_gtpv2c_trxn_t *);
-    }
+    pTrxn = (nw_gtpv2c_trxn_t *) nwGtpv2cPoolAlloc (&thiz->trxnPool);
 
     if (pTrxn) {
+      memset (pTrxn, 0, sizeof (nw_gtpv2c_trxn_t));
       pTrxn->pStack = thiz;
       pTrxn->pMsg = NULL;
       pTrxn->maxRetries = 2;
@@ -201,10 +195,10 @@ extern                                  "C" {
       /*
        * Increment sequence number
        */
-      thiz->seqNum++;
+      thiz->seqNum += thiz->config.seqNumStep;
 
-      if (thiz->seqNum == 0x800000)
-        thiz->seqNum = 0;
+      if (thiz->seqNum >= 0x800000)
+        thiz->seqNum = thiz->config.seqNumStart;
     }
 
     OAILOG_DEBUG (LOG_GTPV2C,  "Created transaction 0x%p\n", pTrxn);
@@ -223,14 +217,10 @@ extern                                  "C" {
   NW_IN uint32_t seqNum) {
     nw_gtpv2c_trxn_t                          *pTrxn;
 
-    if (gpGtpv2cTrxnPool) {
-      pTrxn = gpGtpv2cTrxnPool;
-      gpGtpv2cTrxnPool = gpGtpv2cTrxnPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (thiz, sizeof (nw_gtpv2c_trxn_t), pTrxn, nw_gtpv2c_trxn_t *);
-    }
+    pTrxn = (nw_gtpv2c_trxn_t *) nwGtpv2cPoolAlloc (&thiz->trxnPool);
 
     if (pTrxn) {
+      memset (pTrxn, 0, sizeof (nw_gtpv2c_trxn_t));
       pTrxn->pStack = thiz;
       pTrxn->pMsg = NULL;
       pTrxn->maxRetries = 2;
@@ -265,14 +255,10 @@ extern                                  "C" {
     nw_gtpv2c_trxn_t                          *pTrxn,
                                            *pCollision;
 
-    if (gpGtpv2cTrxnPool) {
-      pTrxn = gpGtpv2cTrxnPool;
-      gpGtpv2cTrxnPool = gpGtpv2cTrxnPool->next;
-    } else {
-      NW_GTPV2C_MALLOC (thiz, sizeof (nw_gtpv2c_trxn_t), pTrxn, nw_gtpv2c_trxn_t *);
-    }
+    pTrxn = (nw_gtpv2c_trxn_t *) nwGtpv2cPoolAlloc (&thiz->trxnPool);
 
     if (pTrxn) {
+      memset (pTrxn, 0, sizeof (nw_gtpv2c_trxn_t));
       pTrxn->pStack = thiz;
       pTrxn->maxRetries = 2;
       pTrxn->t3Timer = 2;
@@ -281,7 +267,7 @@ extern                                  "C" {
       pTrxn->peerPort = peerPort;
       pTrxn->pMsg = NULL;
       pTrxn->hRspTmr = 0;
-      pCollision = RB_INSERT (NwGtpv2cOutstandingRxSeqNumTrxnMap, &(thiz->outstandingRxSeqNumMap), pTrxn);
+      pCollision = nwGtpv2cOutstandingRxTrxnMapInsert (thiz, pTrxn);
 
       if (pCollision) {
         OAILOG_WARNING (LOG_GTPV2C,  "Duplicate request message received for seq num 0x%x!\n", (uint32_t) seqNum);
@@ -334,8 +320,7 @@ extern                                  "C" {
     }
 
     OAILOG_DEBUG (LOG_GTPV2C,  "Purging  transaction 0x%p\n", thiz);
-    thiz->next = gpGtpv2cTrxnPool;
-    gpGtpv2cTrxnPool = thiz;
+    nwGtpv2cPoolFree (&pStack->trxnPool, thiz);
     *pthiz = NULL;
     return rc;
   }
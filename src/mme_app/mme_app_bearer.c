@@ -42,6 +42,7 @@
 #include "conversions.h"
 #include "common_types.h"
 #include "intertask_interface.h"
+#include "itti_trace.h"
 #include "mme_config.h"
 #include "mme_app_extern.h"
 #include "mme_app_ue_context.h"
@@ -307,6 +308,7 @@ mme_app_handle_initial_ue_message (
   }
   ue_context_p->sctp_assoc_id_key = initial_pP->sctp_assoc_id;
   ue_context_p->e_utran_cgi = initial_pP->ecgi;
+  itti_trace_set_ue_id (ue_context_p->mme_ue_s1ap_id);
   // Notify S1AP about the mapping between mme_ue_s1ap_id and sctp assoc id + enb_ue_s1ap_id 
   notify_s1ap_new_ue_mme_s1ap_id_association (ue_context_p);
   // Initialize timers to INVALID IDs
@@ -416,8 +418,10 @@ mme_app_handle_delete_session_rsp (
     OAILOG_WARNING (LOG_MME_APP, "We didn't find this teid in list of UE: %08x\n", delete_sess_resp_pP->teid);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
+  mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S11_RTT, &ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
   hashtable_uint64_ts_remove(mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl,
                       (const hash_key_t) ue_context_p->mme_teid_s11);
+  teid_pool_free (mme_app_desc.s11_teid_pool, ue_context_p->mme_teid_s11);
   ue_context_p->mme_teid_s11 = 0;
 
   if (delete_sess_resp_pP->cause.cause_value != REQUEST_ACCEPTED) {
@@ -482,6 +486,7 @@ mme_app_handle_create_sess_resp (
     OAILOG_DEBUG (LOG_MME_APP, "We didn't find this teid in list of UE: %08x\n", create_sess_resp_pP->teid);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+  mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S11_RTT, &ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
 
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
       create_sess_resp_pP->teid, ue_context_p->emm_context._imsi64);
@@ -639,6 +644,7 @@ mme_app_handle_initial_context_setup_rsp (
     ue_context_p->initial_context_setup_rsp_timer.id = MME_APP_TIMER_INACTIVE_ID;
   }
 
+  mme_app_stats_latency_start (&ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
   message_p = itti_alloc_new_message (TASK_MME_APP, S11_MODIFY_BEARER_REQUEST);
   AssertFatal (message_p , "itti_alloc_new_message Failed");
   itti_s11_modify_bearer_request_t *s11_modify_bearer_request = &message_p->ittiMsg.s11_modify_bearer_request;
@@ -690,7 +696,7 @@ mme_app_handle_initial_context_setup_rsp (
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,  MSC_S11_MME ,
                       NULL, 0, "0 S11_MODIFY_BEARER_REQUEST teid %u ebi %u", s11_modify_bearer_request->teid,
                       s11_modify_bearer_request->bearer_contexts_to_be_modified.bearer_contexts[0].eps_bearer_id);
-  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  mme_app_s11_batch_send (message_p, s11_modify_bearer_request->peer_ip);
 
   unlock_ue_contexts(ue_context_p);
   OAILOG_FUNC_OUT (LOG_MME_APP);
@@ -712,6 +718,7 @@ mme_app_handle_release_access_bearers_resp (
     OAILOG_DEBUG (LOG_MME_APP, "We didn't find this teid in list of UE: %" PRIX32 "\n", rel_access_bearers_rsp_pP->teid);
     OAILOG_FUNC_OUT (LOG_MME_APP);
   }
+  mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S11_RTT, &ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
   MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ", rel_access_bearers_rsp_pP->teid, ue_context_p->emm_context._imsi64);
   /*
    * Updating statistics
@@ -885,10 +892,12 @@ void mme_app_handle_e_rab_setup_rsp (itti_s1ap_e_rab_setup_rsp_t  * const e_rab_
     s11_create_bearer_response->trxn = NULL;
     s11_create_bearer_response->cause.cause_value = 0;
     int msg_bearer_index = 0;
+    struct in_addr peer_ip = {.s_addr = INADDR_ANY};
 
     for (int i = 0; i < e_rab_setup_rsp->e_rab_setup_list.no_of_items; i++) {
       e_rab_id_t e_rab_id = e_rab_setup_rsp->e_rab_setup_list.item[i].e_rab_id;
       bearer_context_t * bc = mme_app_get_bearer_context(ue_context_p, (ebi_t) e_rab_id);
+      peer_ip = ue_context_p->pdn_contexts[bc->pdn_cx_id]->s_gw_address_s11_s4.address.ipv4_address;
       if (bc->bearer_state & BEARER_STATE_ENB_CREATED) {
         s11_create_bearer_response->cause.cause_value = REQUEST_ACCEPTED;
         s11_create_bearer_response->bearer_contexts.bearer_contexts[msg_bearer_index].eps_bearer_id = e_rab_id;
@@ -920,7 +929,7 @@ void mme_app_handle_e_rab_setup_rsp (itti_s1ap_e_rab_setup_rsp_t  * const e_rab_
 
     MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,  MSC_S11_MME ,
                       NULL, 0, "0 S11_CREATE_BEARER_RESPONSE teid %u", s11_create_bearer_response->teid);
-    itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    mme_app_s11_send (message_p, peer_ip);
   } else {
     // not send S11 response
     // TODO create a procedure with bearers to receive a response from NAS
@@ -991,11 +1000,7 @@ mme_app_handle_initial_context_setup_rsp_timer_expiry (struct ue_mm_context_s *u
     itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
   } else {
     // Release S1-U bearer and move the UE to idle mode
-    for (pdn_cid_t i = 0; i < MAX_APN_PER_UE; i++) {
-      if (ue_context_p->pdn_contexts[i]) {
-        mme_app_send_s11_release_access_bearers_req(ue_context_p, i);
-      }
-    }
+    mme_app_send_s11_release_access_bearers_req (ue_context_p);
   }
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
@@ -1036,11 +1041,7 @@ mme_app_handle_initial_context_setup_failure (
     itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
   } else {
     // Release S1-U bearer and move the UE to idle mode 
-    for (pdn_cid_t i = 0; i < MAX_APN_PER_UE; i++) {
-      if (ue_context_p->pdn_contexts[i]) {
-        mme_app_send_s11_release_access_bearers_req(ue_context_p, i);
-      }
-    }
+    mme_app_send_s11_release_access_bearers_req (ue_context_p);
   }
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
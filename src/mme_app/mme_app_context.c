@@ -629,6 +629,7 @@ void mme_remove_ue_context (
       if (HASH_TABLE_OK != hash_rc)
         OAILOG_DEBUG(LOG_MME_APP, "UE context enb_ue_s1ap_ue_id "ENB_UE_S1AP_ID_FMT " mme_ue_s1ap_id " MME_UE_S1AP_ID_FMT ", MME S11 TEID  " TEID_FMT "  not in S11 collection\n",
             ue_context_p->enb_ue_s1ap_id, ue_context_p->mme_ue_s1ap_id, ue_context_p->mme_teid_s11);
+      teid_pool_free (mme_app_desc.s11_teid_pool, ue_context_p->mme_teid_s11);
     }
     // filled guti
     if ((ue_context_p->emm_context._guti.gummei.mme_code) || (ue_context_p->emm_context._guti.gummei.mme_gid) || (ue_context_p->emm_context._guti.m_tmsi) ||
@@ -774,7 +775,7 @@ void mme_app_dump_protocol_configuration_options (const protocol_configuration_o
           }
         }
       }
-      OAILOG_STREAM_HEX(OAILOG_LEVEL_DEBUG, LOG_MME_APP, "        Hex data: ", bdata(pco->protocol_or_container_ids[i].contents), blength(pco->protocol_or_container_ids[i].contents))
+      OAILOG_STREAM_HEX(OAILOG_LEVEL_DEBUG, LOG_MME_APP, "        Hex data: ", bdata(pco->protocol_or_container_ids[i].contents), blength(pco->protocol_or_container_ids[i].contents));
       i++;
     }
   }
@@ -1332,12 +1333,7 @@ _mme_app_handle_s1ap_ue_context_release (const mme_ue_s1ap_id_t mme_ue_s1ap_id,
     itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
   } else {
     // release S1-U tunnel mapping in S_GW for all the active bearers for the UE
-    // release S1-U tunnel mapping in S_GW for all the active bearers for the UE
-    for (pdn_cid_t i = 0; i < MAX_APN_PER_UE; i++) {
-      if (ue_mm_context->pdn_contexts[i]) {
-        mme_app_send_s11_release_access_bearers_req(ue_mm_context, i);
-      }
-    }
+    mme_app_send_s11_release_access_bearers_req (ue_mm_context);
   }
   unlock_ue_contexts(ue_mm_context);
   OAILOG_FUNC_OUT (LOG_MME_APP);
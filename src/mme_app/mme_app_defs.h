@@ -37,6 +37,9 @@
 #define FILE_MME_APP_DEFS_SEEN
 #include "intertask_interface.h"
 #include "mme_app_ue_context.h"
+#include "teid_pool.h"
+
+#define MME_APP_S11_TEID_POOL_SIZE    (1 << 20)    /*!< \brief MME S11 TEIDs, one per UE with PDN connections */
 
 typedef struct mme_app_desc_s {
   /* UE contexts + some statistics variables */
@@ -44,34 +47,11 @@ typedef struct mme_app_desc_s {
 
   long statistic_timer_id;
   uint32_t statistic_timer_period;
-  
-  /* Reader/writer lock */
-  pthread_rwlock_t rw_lock;
-  
-  /* ***************Statistics*************
-   * number of attached UE,number of connected UE,
-   * number of idle UE,number of default bearers, 
-   * number of S1_U bearers,number of PDN sessions
-   */ 
-  
-  uint32_t               nb_enb_connected;
-  uint32_t               nb_ue_attached;
-  uint32_t               nb_ue_connected;
-  uint32_t               nb_default_eps_bearers;
-  uint32_t               nb_s1u_bearers;
-  
-  /* ***************Changes in Statistics**************/
-
-  uint32_t               nb_ue_attached_since_last_stat;
-  uint32_t               nb_ue_detached_since_last_stat;
-  uint32_t               nb_ue_connected_since_last_stat;
-  uint32_t               nb_ue_disconnected_since_last_stat;
-  uint32_t               nb_eps_bearers_established_since_last_stat;
-  uint32_t               nb_eps_bearers_released_since_last_stat;
-  uint32_t               nb_enb_connected_since_last_stat;
-  uint32_t               nb_enb_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_released_since_last_stat;
-  uint32_t               nb_s1u_bearers_established_since_last_stat;
+
+  /* MME S11 TEIDs, released with the last PDN connection or the UE context */
+  teid_pool_t *s11_teid_pool;
+
+  /* Statistics are kept in per thread counters, see mme_app_statistics.c */
 } mme_app_desc_t;
 
 extern mme_app_desc_t mme_app_desc;
@@ -134,8 +114,4 @@ void mme_app_handle_initial_context_setup_rsp_timer_expiry (struct ue_mm_context
 
 void mme_app_handle_enb_reset_req( const itti_s1ap_enb_initiated_reset_req_t const * enb_reset_req); 
 
-#define mme_stats_read_lock(mMEsTATS)  pthread_rwlock_rdlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_write_lock(mMEsTATS) pthread_rwlock_wrlock(&(mMEsTATS)->rw_lock)
-#define mme_stats_unlock(mMEsTATS)     pthread_rwlock_unlock(&(mMEsTATS)->rw_lock)
-
 #endif /* MME_APP_DEFS_H_ */
@@ -52,15 +52,14 @@ void mme_app_send_delete_session_request (struct ue_mm_context_s * const ue_cont
 {
   MessageDef                             *message_p = NULL;
 
+  mme_app_stats_latency_start (&ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
   message_p = itti_alloc_new_message (TASK_MME_APP, S11_DELETE_SESSION_REQUEST);
   AssertFatal (message_p , "itti_alloc_new_message Failed");
   S11_DELETE_SESSION_REQUEST (message_p).local_teid = ue_context_p->mme_teid_s11;
   S11_DELETE_SESSION_REQUEST (message_p).teid       = ue_context_p->pdn_contexts[cid]->s_gw_teid_s11_s4;
   S11_DELETE_SESSION_REQUEST (message_p).lbi        = ebi; //default bearer
 
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = (teid_t) ue_context_p;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.teid = ue_context_p->mme_teid_s11;
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
   mme_config_read_lock (&mme_config);
   S11_DELETE_SESSION_REQUEST (message_p).sender_fteid_for_cp.ipv4_address = mme_config.ipv4.s11;
@@ -81,7 +80,7 @@ void mme_app_send_delete_session_request (struct ue_mm_context_s * const ue_cont
                       S11_DELETE_SESSION_REQUEST  (message_p).teid,
                       S11_DELETE_SESSION_REQUEST  (message_p).lbi);
 
-  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  mme_app_s11_send (message_p, S11_DELETE_SESSION_REQUEST (message_p).peer_ip);
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
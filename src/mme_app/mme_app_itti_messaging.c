@@ -32,6 +32,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <pthread.h>
+#include <arpa/inet.h>
 
 #include <libxml/xmlwriter.h>
 #include <libxml/xpath.h>
@@ -44,6 +45,7 @@
 #include "conversions.h"
 #include "common_types.h"
 #include "intertask_interface.h"
+#include "itti_free_defined_msg.h"
 #include "gcc_diag.h"
 #include "mme_config.h"
 #include "mme_app_extern.h"
@@ -73,30 +75,138 @@ void mme_app_itti_ue_context_release(struct ue_mm_context_s *ue_context_p, enum
   OAILOG_FUNC_OUT (LOG_MME_APP);
 }
 
+/*
+ * S11 requests to S-GWs waiting for the MME_APP queue to drain, one batch per S-GW.
+ * Only touched by the TASK_MME_APP thread.
+ */
+static MessageDef                        *mme_app_s11_batches[MME_APP_S11_BATCH_SGW_MAX] = {NULL};
+static uint32_t                           mme_app_s11_nb_batches = 0;
+
+//------------------------------------------------------------------------------
+static void mme_app_s11_batch_send_to_task (MessageDef * const batch_p)
+{
+  itti_s11_bearer_request_batch_t        *batch = &batch_p->ittiMsg.s11_bearer_request_batch;
+
+  if (batch->nb_requests == 1) {
+    // Not worth the indirection
+    itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, batch->requests[0]);
+    batch->nb_requests = 0;
+    itti_free (ITTI_MSG_ORIGIN_ID (batch_p), batch_p);
+  } else {
+    OAILOG_DEBUG (LOG_MME_APP, "Sending %u S11 requests to %s in one batch\n", batch->nb_requests, inet_ntoa (batch->peer_ip));
+    itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, batch_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+int mme_app_s11_batch_send (MessageDef * const message_p, const struct in_addr peer_ip)
+{
+  itti_s11_bearer_request_batch_t        *batch = NULL;
+  uint32_t                                i;
+
+  for (i = 0; i < mme_app_s11_nb_batches; i++) {
+    if (mme_app_s11_batches[i]->ittiMsg.s11_bearer_request_batch.peer_ip.s_addr == peer_ip.s_addr) {
+      break;
+    }
+  }
+  if (i == mme_app_s11_nb_batches) {
+    if (mme_app_s11_nb_batches == MME_APP_S11_BATCH_SGW_MAX) {
+      mme_app_s11_batch_flush ();
+      i = 0;
+    }
+    mme_app_s11_batches[i] = itti_alloc_new_message (TASK_MME_APP, S11_BEARER_REQUEST_BATCH);
+    DevAssert (mme_app_s11_batches[i]);
+    mme_app_s11_batches[i]->ittiMsg.s11_bearer_request_batch.peer_ip = peer_ip;
+    mme_app_s11_batches[i]->ittiMsg.s11_bearer_request_batch.nb_requests = 0;
+    mme_app_s11_nb_batches++;
+  }
+  batch = &mme_app_s11_batches[i]->ittiMsg.s11_bearer_request_batch;
+  batch->requests[batch->nb_requests++] = message_p;
+  if (batch->nb_requests == S11_BEARER_REQUEST_BATCH_MAX) {
+    mme_app_s11_batch_send_to_task (mme_app_s11_batches[i]);
+    mme_app_s11_batches[i] = mme_app_s11_batches[--mme_app_s11_nb_batches];
+    mme_app_s11_batches[mme_app_s11_nb_batches] = NULL;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_s11_send (MessageDef * const message_p, const struct in_addr peer_ip)
+{
+  uint32_t                                i;
+
+  for (i = 0; i < mme_app_s11_nb_batches; i++) {
+    if (mme_app_s11_batches[i]->ittiMsg.s11_bearer_request_batch.peer_ip.s_addr == peer_ip.s_addr) {
+      // Requests already queued for this S-GW go first, TASK_S11 keeps the order of a UE's requests
+      mme_app_s11_batch_send_to_task (mme_app_s11_batches[i]);
+      mme_app_s11_batches[i] = mme_app_s11_batches[--mme_app_s11_nb_batches];
+      mme_app_s11_batches[mme_app_s11_nb_batches] = NULL;
+      break;
+    }
+  }
+  return itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+}
+
 //------------------------------------------------------------------------------
-int mme_app_send_s11_release_access_bearers_req (struct ue_mm_context_s *const ue_mm_context, const pdn_cid_t pdn_index)
+bool mme_app_s11_batch_pending (void)
+{
+  return (mme_app_s11_nb_batches > 0);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_s11_batch_flush (void)
+{
+  uint32_t                                i;
+
+  for (i = 0; i < mme_app_s11_nb_batches; i++) {
+    mme_app_s11_batch_send_to_task (mme_app_s11_batches[i]);
+    mme_app_s11_batches[i] = NULL;
+  }
+  mme_app_s11_nb_batches = 0;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_send_s11_release_access_bearers_req (struct ue_mm_context_s *const ue_mm_context)
 {
   OAILOG_FUNC_IN (LOG_MME_APP);
-  /*
-   * Keep the identifier to the default APN
-   */
   MessageDef                             *message_p = NULL;
   itti_s11_release_access_bearers_request_t         *release_access_bearers_request_p = NULL;
   int                                     rc = RETURNok;
 
   DevAssert (ue_mm_context );
-  message_p = itti_alloc_new_message (TASK_MME_APP, S11_RELEASE_ACCESS_BEARERS_REQUEST);
-  release_access_bearers_request_p = &message_p->ittiMsg.s11_release_access_bearers_request;
-  release_access_bearers_request_p->local_teid = ue_mm_context->mme_teid_s11;
-  pdn_context_t * pdn_connection = ue_mm_context->pdn_contexts[pdn_index];
-  release_access_bearers_request_p->teid = pdn_connection->s_gw_teid_s11_s4;
-  release_access_bearers_request_p->peer_ip = pdn_connection->s_gw_address_s11_s4.address.ipv4_address;
+  mme_app_stats_latency_start (&ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
+  for (pdn_cid_t i = 0; i < MAX_APN_PER_UE; i++) {
+    pdn_context_t * pdn_connection = ue_mm_context->pdn_contexts[i];
+    pdn_cid_t       j;
 
-  release_access_bearers_request_p->originating_node = NODE_TYPE_MME;
+    if (!pdn_connection) {
+      continue;
+    }
+    /*
+     * Release Access Bearers applies to all the PDN connections of the UE on the S11 tunnel
+     * (3GPP TS 29.274 7.2.21): one request per S-GW S11 tunnel, not per PDN connection.
+     */
+    for (j = 0; j < i; j++) {
+      if ((ue_mm_context->pdn_contexts[j]) &&
+          (ue_mm_context->pdn_contexts[j]->s_gw_teid_s11_s4 == pdn_connection->s_gw_teid_s11_s4) &&
+          (ue_mm_context->pdn_contexts[j]->s_gw_address_s11_s4.address.ipv4_address.s_addr == pdn_connection->s_gw_address_s11_s4.address.ipv4_address.s_addr)) {
+        break;
+      }
+    }
+    if (j < i) {
+      continue;
+    }
+    message_p = itti_alloc_new_message (TASK_MME_APP, S11_RELEASE_ACCESS_BEARERS_REQUEST);
+    release_access_bearers_request_p = &message_p->ittiMsg.s11_release_access_bearers_request;
+    release_access_bearers_request_p->local_teid = ue_mm_context->mme_teid_s11;
+    release_access_bearers_request_p->teid = pdn_connection->s_gw_teid_s11_s4;
+    release_access_bearers_request_p->peer_ip = pdn_connection->s_gw_address_s11_s4.address.ipv4_address;
 
+    release_access_bearers_request_p->originating_node = NODE_TYPE_MME;
 
-  MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_REQUEST teid %u", release_access_bearers_request_p->teid);
-  rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+    MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 S11_RELEASE_ACCESS_BEARERS_REQUEST teid %u", release_access_bearers_request_p->teid);
+    rc = mme_app_s11_batch_send (message_p, release_access_bearers_request_p->peer_ip);
+  }
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
 
@@ -124,6 +234,7 @@ int mme_app_send_s11_create_session_req (struct ue_mm_context_s *const ue_mm_con
     DevMessage ("Not implemented: ACCESS NOT GRANTED, send ESM Failure to NAS\n");
   }
 
+  mme_app_stats_latency_start (&ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
   message_p = itti_alloc_new_message (TASK_MME_APP, S11_CREATE_SESSION_REQUEST);
   /*
    * WARNING:
@@ -183,12 +294,18 @@ int mme_app_send_s11_create_session_req (struct ue_mm_context_s *const ue_mm_con
   session_request_p->bearer_contexts_to_be_created.num_bearer_context = 1;
   /*
    * Asking for default bearer in initial UE message.
-   * Use the address of ue_context as unique TEID: Need to find better here
-   * and will generate unique id only for 32 bits platforms.
+   * All the PDN connections of the UE share the MME S11 TEID.
    */
-  OAI_GCC_DIAG_OFF(pointer-to-int-cast);
-  session_request_p->sender_fteid_for_cp.teid = (teid_t) ue_mm_context;
-  OAI_GCC_DIAG_ON(pointer-to-int-cast);
+  if (ue_mm_context->mme_teid_s11 == INVALID_TEID) {
+    session_request_p->sender_fteid_for_cp.teid = teid_pool_alloc (mme_app_desc.s11_teid_pool, 0);
+    if (session_request_p->sender_fteid_for_cp.teid == INVALID_TEID) {
+      itti_free_msg_content (message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+      OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+    }
+  } else {
+    session_request_p->sender_fteid_for_cp.teid = ue_mm_context->mme_teid_s11;
+  }
   session_request_p->sender_fteid_for_cp.interface_type = S11_MME_GTP_C;
   mme_config_read_lock (&mme_config);
   session_request_p->sender_fteid_for_cp.ipv4_address.s_addr = mme_config.ipv4.s11.s_addr;
@@ -252,6 +369,6 @@ int mme_app_send_s11_create_session_req (struct ue_mm_context_s *const ue_mm_con
   session_request_p->selection_mode = MS_O_N_P_APN_S_V;
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0,
       "0 S11_CREATE_SESSION_REQUEST imsi " IMSI_64_FMT, ue_mm_context->emm_context._imsi64);
-  rc = itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  rc = mme_app_s11_send (message_p, session_request_p->peer_ip);
   OAILOG_FUNC_RETURN (LOG_MME_APP, rc);
 }
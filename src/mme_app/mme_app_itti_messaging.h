@@ -32,7 +32,35 @@
 
 void mme_app_itti_ue_context_release(struct ue_mm_context_s *ue_context_p, enum s1cause cause);
 int mme_app_notify_s1ap_ue_context_released(const mme_ue_s1ap_id_t   ue_idP);
-int mme_app_send_s11_release_access_bearers_req (struct ue_mm_context_s *const ue_mm_context, const pdn_cid_t pdn_index);
+
+/*
+ * Release the S1-U bearers of all the PDN connections of the UE, one request per S-GW S11 tunnel.
+ */
+int mme_app_send_s11_release_access_bearers_req (struct ue_mm_context_s *const ue_mm_context);
 int mme_app_send_s11_create_session_req (struct ue_mm_context_s *const ue_mm_context, const pdn_cid_t pdn_cid);
 
+#define MME_APP_S11_BATCH_SGW_MAX     8    /*!< \brief S-GWs with a batch of S11 requests pending */
+
+/*
+ * Queue a S11_MODIFY_BEARER_REQUEST or S11_RELEASE_ACCESS_BEARERS_REQUEST for TASK_S11.
+ * Requests to the same S-GW are given to TASK_S11 in one S11_BEARER_REQUEST_BATCH message when
+ * S11_BEARER_REQUEST_BATCH_MAX are pending or when mme_app_s11_batch_flush() is called.
+ * TASK_MME_APP thread only.
+ */
+int mme_app_s11_batch_send (MessageDef * const message_p, const struct in_addr peer_ip);
+
+/*
+ * Send any other S11 message to TASK_S11 at once, after the batch pending for the same S-GW: a
+ * Create or Delete Session Request cannot overtake a Modify Bearer Request of the same UE.
+ * TASK_MME_APP thread only.
+ */
+int mme_app_s11_send (MessageDef * const message_p, const struct in_addr peer_ip);
+
+bool mme_app_s11_batch_pending (void);
+
+/*
+ * Send the pending batches, called by TASK_MME_APP when its queue is empty.
+ */
+void mme_app_s11_batch_flush (void);
+
 #endif /* FILE_MME_APP_ITTI_MESSAGING_SEEN */
@@ -60,6 +60,7 @@ int mme_app_send_s6a_update_location_req (
   int                                     rc = RETURNok;
 
 
+  mme_app_stats_latency_start (&ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_S6A_ULR_RTT]);
   message_p = itti_alloc_new_message (TASK_MME_APP, S6A_UPDATE_LOCATION_REQ);
 
   if (message_p == NULL) {
@@ -128,6 +129,7 @@ int mme_app_handle_s6a_update_location_ans (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_UPDATE_LOCATION unknown imsi %s", ula_pP->imsi);
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
   }
+  mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S6A_ULR_RTT, &ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_S6A_ULR_RTT]);
 
   ue_mm_context->subscription_known = SUBSCRIPTION_KNOWN;
   ue_mm_context->sub_status = ula_pP->subscription_data.subscriber_status;
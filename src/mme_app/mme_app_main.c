@@ -48,6 +48,7 @@
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
 #include "mme_app_statistics.h"
+#include "mme_app_itti_messaging.h"
 #include "common_defs.h"
 #include "mme_app_edns_emulation.h"
 #include "nas_proc.h"
@@ -70,8 +71,17 @@ void *mme_app_thread (void *args)
      * Trying to fetch a message from the message queue.
      * If the queue is empty, this function will block till a
      * message is sent to the task.
+     * While S11 requests are batched, only poll: the batches are sent once the queue is empty.
      */
-    itti_receive_msg (TASK_MME_APP, &received_message_p);
+    if (mme_app_s11_batch_pending ()) {
+      itti_poll_msg (TASK_MME_APP, &received_message_p);
+      if (received_message_p == NULL) {
+        mme_app_s11_batch_flush ();
+        continue;
+      }
+    } else {
+      itti_receive_msg (TASK_MME_APP, &received_message_p);
+    }
     DevAssert (received_message_p );
 
     switch (ITTI_MSG_ID (received_message_p)) {
@@ -167,6 +177,8 @@ void *mme_app_thread (void *args)
         } else {
           MSC_LOG_RX_MESSAGE (MSC_MMEAPP_MME, MSC_S11_MME, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " IMSI " IMSI_64_FMT " ",
             received_message_p->ittiMsg.s11_modify_bearer_response.teid, ue_context_p->emm_context._imsi64);
+          mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S11_RTT, &ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_S11_RTT]);
+          mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_SERVICE_REQUEST, &ue_context_p->latency_start_usec[MME_APP_STATS_LATENCY_SERVICE_REQUEST]);
           /*
            * Updating statistics
            */
@@ -291,7 +303,6 @@ int mme_app_init (const mme_config_t * mme_config_p)
 {
   OAILOG_FUNC_IN (LOG_MME_APP);
   memset (&mme_app_desc, 0, sizeof (mme_app_desc));
-  pthread_rwlock_init (&mme_app_desc.rw_lock, NULL);
   bstring b = bfromcstr("mme_app_imsi_ue_context_htbl");
   mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl = hashtable_uint64_ts_create (mme_config.max_ues, NULL, b);
   btrunc(b, 0);
@@ -308,6 +319,10 @@ int mme_app_init (const mme_config_t * mme_config_p)
   bassigncstr(b, "mme_app_guti_ue_context_htbl");
   mme_app_desc.mme_ue_contexts.guti_ue_context_htbl = obj_hashtable_uint64_ts_create (mme_config.max_ues, NULL, NULL, b);
   bdestroy_wrapper (&b);
+  mme_app_desc.s11_teid_pool = teid_pool_create ("mme_app_s11_teid_pool", 1, MME_APP_S11_TEID_POOL_SIZE, 1);
+  if (!mme_app_desc.s11_teid_pool) {
+    OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
+  }
 
   if (mme_app_edns_init(mme_config_p)) {
     OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNerror);
@@ -337,6 +352,7 @@ int mme_app_init (const mme_config_t * mme_config_p)
     OAILOG_ERROR (LOG_MME_APP, "Failed to request new timer for statistics with %ds " "of periocidity\n", mme_config_p->mme_statistic_timer);
     mme_app_desc.statistic_timer_id = 0;
   }
+  mme_app_statistics_export_init (mme_config_p->mme_statistic_socket);
 
   OAILOG_DEBUG (LOG_MME_APP, "Initializing MME applicative layer: DONE\n");
   OAILOG_FUNC_RETURN (LOG_MME_APP, RETURNok);
@@ -345,12 +361,15 @@ int mme_app_init (const mme_config_t * mme_config_p)
 //------------------------------------------------------------------------------
 void mme_app_exit (void)
 {
+  mme_app_s11_batch_flush ();
   timer_remove(mme_app_desc.statistic_timer_id, NULL);
+  mme_app_statistics_export_exit();
   mme_app_edns_exit();
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.imsi_ue_context_htbl);
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.tun11_ue_context_htbl);
   hashtable_ts_destroy (mme_app_desc.mme_ue_contexts.mme_ue_s1ap_id_ue_context_htbl);
   hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.enb_ue_s1ap_id_ue_context_htbl);
   obj_hashtable_uint64_ts_destroy (mme_app_desc.mme_ue_contexts.guti_ue_context_htbl);
+  teid_pool_destroy (&mme_app_desc.s11_teid_pool);
   mme_config_exit();
 }
@@ -45,6 +45,7 @@
 #include "mme_app_extern.h"
 #include "mme_app_ue_context.h"
 #include "mme_app_defs.h"
+#include "mme_app_itti_messaging.h"
 #include "sgw_ie_defs.h"
 #include "common_defs.h"
 #include "mme_app_procedures.h"
@@ -135,6 +136,7 @@ void mme_app_s11_procedure_create_bearer_send_response(ue_mm_context_t * const u
   s11_create_bearer_response->cause.cause_value = 0;
   int msg_bearer_index = 0;
   int num_rejected = 0;
+  struct in_addr peer_ip = {.s_addr = INADDR_ANY};
 
   for (int ebix = 0; ebix < BEARERS_PER_UE; ebix++) {
     ebi_t ebi = INDEX_TO_EBI(ebix);
@@ -143,6 +145,7 @@ void mme_app_s11_procedure_create_bearer_send_response(ue_mm_context_t * const u
       // should not fail (bc != NULL)
       // Find remote S11 teid == find pdn
       s11_create_bearer_response->teid = ue_context_p->pdn_contexts[bc->pdn_cx_id]->s_gw_teid_s11_s4;
+      peer_ip = ue_context_p->pdn_contexts[bc->pdn_cx_id]->s_gw_address_s11_s4.address.ipv4_address;
 
       s11_create_bearer_response->bearer_contexts.bearer_contexts[msg_bearer_index].eps_bearer_id = ebi;
       s11_create_bearer_response->bearer_contexts.bearer_contexts[msg_bearer_index].cause.cause_value = REQUEST_REJECTED;
@@ -156,6 +159,7 @@ void mme_app_s11_procedure_create_bearer_send_response(ue_mm_context_t * const u
       // should not fail (bc != NULL)
       // Find remote S11 teid == find pdn
       s11_create_bearer_response->teid = ue_context_p->pdn_contexts[bc->pdn_cx_id]->s_gw_teid_s11_s4;
+      peer_ip = ue_context_p->pdn_contexts[bc->pdn_cx_id]->s_gw_address_s11_s4.address.ipv4_address;
 
       s11_create_bearer_response->bearer_contexts.bearer_contexts[msg_bearer_index].eps_bearer_id = ebi;
       s11_create_bearer_response->bearer_contexts.bearer_contexts[msg_bearer_index].cause.cause_value = REQUEST_ACCEPTED;
@@ -176,7 +180,7 @@ void mme_app_s11_procedure_create_bearer_send_response(ue_mm_context_t * const u
   }
   MSC_LOG_TX_MESSAGE (MSC_MMEAPP_MME,  MSC_S11_MME ,
       NULL, 0, "0 S11_CREATE_BEARER_RESPONSE teid %u", s11_create_bearer_response->teid);
-  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
+  mme_app_s11_send (message_p, peer_ip);
 }
 
 
@@ -22,150 +22,440 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "bstrlib.h"
 
+#include "dynamic_memory_check.h"
 #include "log.h"
-#include "intertask_interface.h"
-#include "mme_app_ue_context.h"
-#include "mme_app_defs.h"
+#include "common_defs.h"
 #include "mme_app_statistics.h"
 
+/* One shard per thread, cache line aligned, written only by its owner */
+typedef struct mme_app_stats_shard_s {
+  uint64_t               gauge_added[MME_APP_STATS_GAUGE_MAX];
+  uint64_t               gauge_removed[MME_APP_STATS_GAUGE_MAX];
+  uint64_t               latency_count[MME_APP_STATS_LATENCY_MAX][MME_APP_STATS_LATENCY_BUCKETS];
+  uint64_t               latency_sum_usec[MME_APP_STATS_LATENCY_MAX];
+  bool                   is_shared;         /*!< \brief more threads than shards, updated with atomic add */
+} __attribute__ ((aligned (64))) mme_app_stats_shard_t;
+
+/* Sum of all shards */
+typedef struct mme_app_stats_snapshot_s {
+  uint64_t               gauge_added[MME_APP_STATS_GAUGE_MAX];
+  uint64_t               gauge_removed[MME_APP_STATS_GAUGE_MAX];
+  uint64_t               latency_count[MME_APP_STATS_LATENCY_MAX][MME_APP_STATS_LATENCY_BUCKETS];
+  uint64_t               latency_sum_usec[MME_APP_STATS_LATENCY_MAX];
+} mme_app_stats_snapshot_t;
+
+static mme_app_stats_shard_t           *g_stats_shards[MME_APP_STATS_MAX_SHARDS] = {NULL};
+static volatile uint32_t                g_stats_num_shards = 0;
+static mme_app_stats_shard_t            g_stats_shared_shard = {.is_shared = true};
+static __thread mme_app_stats_shard_t  *g_stats_thread_shard = NULL;
+
+/* Last displayed values, only accessed by the MME_APP task (statistics timer) */
+static mme_app_stats_snapshot_t         g_stats_last_display = {{0}};
+
+static const char * const               g_stats_gauge_names[MME_APP_STATS_GAUGE_MAX] = {
+  "connected_enb", "connected_ue", "attached_ue", "default_bearer", "s1u_bearer"};
+static const char * const               g_stats_latency_names[MME_APP_STATS_LATENCY_MAX] = {
+  "attach", "tau", "service_request", "s11_rtt", "s6a_air_rtt", "s6a_ulr_rtt"};
+
+static mme_app_statistics_dump_hook_t  g_stats_dump_hooks[MME_APP_STATS_MAX_DUMP_HOOKS] = {NULL};
+static uint32_t                         g_stats_num_dump_hooks = 0;
+
+static int                              g_stats_export_fd = -1;
+static pthread_t                        g_stats_export_thread;
+static bstring                          g_stats_export_path = NULL;
+
+//------------------------------------------------------------------------------
+static mme_app_stats_shard_t * mme_app_stats_get_shard(void)
+{
+  mme_app_stats_shard_t *shard = g_stats_thread_shard;
+
+  if (shard) {
+    return shard;
+  }
+  if (0 == posix_memalign ((void **)&shard, 64, sizeof (*shard))) {
+    memset (shard, 0, sizeof (*shard));
+    uint32_t index = __sync_fetch_and_add (&g_stats_num_shards, 1);
+    if (MME_APP_STATS_MAX_SHARDS > index) {
+      __atomic_store_n (&g_stats_shards[index], shard, __ATOMIC_RELEASE);
+    } else {
+      free (shard);
+      shard = &g_stats_shared_shard;
+    }
+  } else {
+    shard = &g_stats_shared_shard;
+  }
+  g_stats_thread_shard = shard;
+  return shard;
+}
+
+//------------------------------------------------------------------------------
+static inline void mme_app_stats_add(const mme_app_stats_shard_t * const shard, uint64_t * const counter, const uint64_t value)
+{
+  if (shard->is_shared) {
+    __atomic_fetch_add (counter, value, __ATOMIC_RELAXED);
+  } else {
+    // single writer, no need for a locked instruction
+    __atomic_store_n (counter, __atomic_load_n (counter, __ATOMIC_RELAXED) + value, __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_stats_shard_accumulate(mme_app_stats_snapshot_t * const snapshot, const mme_app_stats_shard_t * const shard)
+{
+  for (int i = 0; i < MME_APP_STATS_GAUGE_MAX; i++) {
+    snapshot->gauge_added[i]   += __atomic_load_n (&shard->gauge_added[i], __ATOMIC_RELAXED);
+    snapshot->gauge_removed[i] += __atomic_load_n (&shard->gauge_removed[i], __ATOMIC_RELAXED);
+  }
+  for (int i = 0; i < MME_APP_STATS_LATENCY_MAX; i++) {
+    for (int b = 0; b < MME_APP_STATS_LATENCY_BUCKETS; b++) {
+      snapshot->latency_count[i][b] += __atomic_load_n (&shard->latency_count[i][b], __ATOMIC_RELAXED);
+    }
+    snapshot->latency_sum_usec[i] += __atomic_load_n (&shard->latency_sum_usec[i], __ATOMIC_RELAXED);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_stats_aggregate(mme_app_stats_snapshot_t * const snapshot)
+{
+  uint32_t num_shards = __atomic_load_n (&g_stats_num_shards, __ATOMIC_ACQUIRE);
+
+  memset (snapshot, 0, sizeof (*snapshot));
+  if (MME_APP_STATS_MAX_SHARDS < num_shards) {
+    num_shards = MME_APP_STATS_MAX_SHARDS;
+  }
+  for (uint32_t i = 0; i < num_shards; i++) {
+    const mme_app_stats_shard_t *shard = __atomic_load_n (&g_stats_shards[i], __ATOMIC_ACQUIRE);
+    // slot reserved but not yet published
+    if (shard) {
+      mme_app_stats_shard_accumulate (snapshot, shard);
+    }
+  }
+  mme_app_stats_shard_accumulate (snapshot, &g_stats_shared_shard);
+}
+
+//------------------------------------------------------------------------------
+static inline uint64_t mme_app_stats_gauge_value(const mme_app_stats_snapshot_t * const snapshot, const mme_app_stats_gauge_t gauge)
+{
+  return (snapshot->gauge_added[gauge] > snapshot->gauge_removed[gauge]) ?
+      snapshot->gauge_added[gauge] - snapshot->gauge_removed[gauge] : 0;
+}
+
+//------------------------------------------------------------------------------
+// Upper bound in microseconds of the bucket containing the percentile (lower bound for the unbounded bucket)
+static inline uint64_t mme_app_stats_latency_percentile(const uint64_t * const counts, const uint64_t total, const unsigned int percent)
+{
+  uint64_t threshold = (total * percent + 99) / 100;
+  uint64_t cumul = 0;
+  int      b = 0;
+
+  for (b = 0; b < MME_APP_STATS_LATENCY_BUCKETS - 1; b++) {
+    cumul += counts[b];
+    if (cumul >= threshold) {
+      break;
+    }
+  }
+  return UINT64_C(1) << b;
+}
+
+//------------------------------------------------------------------------------
+static void mme_app_statistics_display_gauge(const char * const label, const mme_app_stats_snapshot_t * const current, const mme_app_stats_gauge_t gauge)
+{
+  OAILOG_DEBUG (LOG_MME_APP, "%s| %10" PRIu64 "      |     %10" PRIu64 "              |    %10" PRIu64 "               |\n", label,
+      mme_app_stats_gauge_value (current, gauge),
+      current->gauge_added[gauge] - g_stats_last_display.gauge_added[gauge],
+      current->gauge_removed[gauge] - g_stats_last_display.gauge_removed[gauge]);
+}
+
+//------------------------------------------------------------------------------
 int mme_app_statistics_display (
   void)
 {
+  mme_app_stats_snapshot_t   current = {{0}};
+
+  mme_app_stats_aggregate (&current);
+
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
   OAILOG_DEBUG (LOG_MME_APP, "               |   Current Status| Added since last display|  Removed since last display |\n");
-  OAILOG_DEBUG (LOG_MME_APP, "Connected eNBs | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_enb_connected,
-                                          mme_app_desc.nb_enb_connected_since_last_stat,mme_app_desc.nb_enb_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Attached UEs   | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_attached,
-                                          mme_app_desc.nb_ue_attached_since_last_stat,mme_app_desc.nb_ue_detached_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Connected UEs  | %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_ue_connected,
-                                          mme_app_desc.nb_ue_connected_since_last_stat,mme_app_desc.nb_ue_disconnected_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "Default Bearers| %10u      |     %10u              |    %10u               |\n",mme_app_desc.nb_default_eps_bearers,
-                                          mme_app_desc.nb_eps_bearers_established_since_last_stat,mme_app_desc.nb_eps_bearers_released_since_last_stat);
-  OAILOG_DEBUG (LOG_MME_APP, "S1-U Bearers   | %10u      |     %10u              |    %10u               |\n\n",mme_app_desc.nb_s1u_bearers,
-                                          mme_app_desc.nb_s1u_bearers_established_since_last_stat,mme_app_desc.nb_s1u_bearers_released_since_last_stat);
+  mme_app_statistics_display_gauge ("Connected eNBs ", &current, MME_APP_STATS_CONNECTED_ENB);
+  mme_app_statistics_display_gauge ("Attached UEs   ", &current, MME_APP_STATS_ATTACHED_UE);
+  mme_app_statistics_display_gauge ("Connected UEs  ", &current, MME_APP_STATS_CONNECTED_UE);
+  mme_app_statistics_display_gauge ("Default Bearers", &current, MME_APP_STATS_DEFAULT_BEARER);
+  mme_app_statistics_display_gauge ("S1-U Bearers   ", &current, MME_APP_STATS_S1U_BEARER);
+
+  OAILOG_DEBUG (LOG_MME_APP, "Latency (usec) | Count since last display |   Mean   |   p50 <=   |   p99 <=   |\n");
+  for (int i = 0; i < MME_APP_STATS_LATENCY_MAX; i++) {
+    uint64_t counts[MME_APP_STATS_LATENCY_BUCKETS];
+    uint64_t total = 0;
+
+    for (int b = 0; b < MME_APP_STATS_LATENCY_BUCKETS; b++) {
+      counts[b] = current.latency_count[i][b] - g_stats_last_display.latency_count[i][b];
+      total += counts[b];
+    }
+    if (total) {
+      OAILOG_DEBUG (LOG_MME_APP, "%-15s| %10" PRIu64 "               | %8" PRIu64 " | %10" PRIu64 " | %10" PRIu64 " |\n",
+          g_stats_latency_names[i], total, (current.latency_sum_usec[i] - g_stats_last_display.latency_sum_usec[i]) / total,
+          mme_app_stats_latency_percentile (counts, total, 50), mme_app_stats_latency_percentile (counts, total, 99));
+    }
+  }
   OAILOG_DEBUG (LOG_MME_APP, "======================================= STATISTICS ============================================\n\n");
-  
-  mme_stats_write_lock (&mme_app_desc);
-  
-  // resetting stats for next display
-  mme_app_desc.nb_enb_connected_since_last_stat = 0;
-  mme_app_desc.nb_enb_released_since_last_stat  = 0;
-  mme_app_desc.nb_ue_connected_since_last_stat  = 0;
-  mme_app_desc.nb_ue_disconnected_since_last_stat  = 0;
-  mme_app_desc.nb_s1u_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_s1u_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_established_since_last_stat = 0;
-  mme_app_desc.nb_eps_bearers_released_since_last_stat = 0;
-  mme_app_desc.nb_ue_attached_since_last_stat = 0;
-  mme_app_desc.nb_ue_detached_since_last_stat = 0;
-  
-  mme_stats_unlock(&mme_app_desc);
 
+  // reference for next display
+  g_stats_last_display = current;
   return 0;
 }
 
+//------------------------------------------------------------------------------
+void mme_app_statistics_dump(bstring buffer)
+{
+  mme_app_stats_snapshot_t   current = {{0}};
+
+  mme_app_stats_aggregate (&current);
+  for (int i = 0; i < MME_APP_STATS_GAUGE_MAX; i++) {
+    bformata (buffer, "# TYPE mme_%s gauge\n", g_stats_gauge_names[i]);
+    bformata (buffer, "mme_%s %" PRIu64 "\n", g_stats_gauge_names[i], mme_app_stats_gauge_value (&current, i));
+    bformata (buffer, "mme_%s_added_total %" PRIu64 "\n", g_stats_gauge_names[i], current.gauge_added[i]);
+    bformata (buffer, "mme_%s_removed_total %" PRIu64 "\n", g_stats_gauge_names[i], current.gauge_removed[i]);
+  }
+  bcatcstr (buffer, "# TYPE mme_procedure_latency_usec histogram\n");
+  for (int i = 0; i < MME_APP_STATS_LATENCY_MAX; i++) {
+    uint64_t cumul = 0;
+
+    for (int b = 0; b < MME_APP_STATS_LATENCY_BUCKETS - 1; b++) {
+      cumul += current.latency_count[i][b];
+      bformata (buffer, "mme_procedure_latency_usec_bucket{procedure=\"%s\",le=\"%" PRIu64 "\"} %" PRIu64 "\n",
+          g_stats_latency_names[i], UINT64_C(1) << b, cumul);
+    }
+    cumul += current.latency_count[i][MME_APP_STATS_LATENCY_BUCKETS - 1];
+    bformata (buffer, "mme_procedure_latency_usec_bucket{procedure=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", g_stats_latency_names[i], cumul);
+    bformata (buffer, "mme_procedure_latency_usec_sum{procedure=\"%s\"} %" PRIu64 "\n", g_stats_latency_names[i], current.latency_sum_usec[i]);
+    bformata (buffer, "mme_procedure_latency_usec_count{procedure=\"%s\"} %" PRIu64 "\n", g_stats_latency_names[i], cumul);
+  }
+  uint32_t num_hooks = __atomic_load_n (&g_stats_num_dump_hooks, __ATOMIC_ACQUIRE);
+  for (uint32_t i = 0; i < num_hooks; i++) {
+    g_stats_dump_hooks[i] (buffer);
+  }
+}
+
+//------------------------------------------------------------------------------
+int mme_app_statistics_register_dump(const mme_app_statistics_dump_hook_t hook)
+{
+  uint32_t num_hooks = __atomic_load_n (&g_stats_num_dump_hooks, __ATOMIC_RELAXED);
+
+  if (MME_APP_STATS_MAX_DUMP_HOOKS <= num_hooks) {
+    OAILOG_ERROR (LOG_MME_APP, "Too many statistics dump hooks\n");
+    return RETURNerror;
+  }
+  g_stats_dump_hooks[num_hooks] = hook;
+  // published once set, the export thread may be running
+  __atomic_store_n (&g_stats_num_dump_hooks, num_hooks + 1, __ATOMIC_RELEASE);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void *mme_app_statistics_export_thread(void *args_p)
+{
+  bstring dump = bfromcstralloc (16384, "");
+
+  while (true) {
+    int fd = accept (g_stats_export_fd, NULL, NULL);
+
+    if (0 > fd) {
+      if ((EINTR == errno) || (ECONNABORTED == errno)) {
+        continue;
+      }
+      // socket shut down by mme_app_statistics_export_exit()
+      break;
+    }
+    btrunc (dump, 0);
+    mme_app_statistics_dump (dump);
+
+    int offset = 0;
+    while (offset < blength (dump)) {
+      ssize_t sent = send (fd, &dump->data[offset], blength (dump) - offset, MSG_NOSIGNAL);
+      if (0 >= sent) {
+        if ((0 > sent) && (EINTR == errno)) continue;
+        break;
+      }
+      offset += sent;
+    }
+    close (fd);
+  }
+  bdestroy_wrapper (&dump);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+int mme_app_statistics_export_init(const_bstring const socket_path)
+{
+  struct sockaddr_un  addr = {0};
+
+  if ((!socket_path) || (!blength (socket_path))) {
+    return RETURNok;
+  }
+  if (blength (socket_path) >= sizeof (addr.sun_path)) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics socket path too long: %s\n", bdata (socket_path));
+    return RETURNerror;
+  }
+  g_stats_export_fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (0 > g_stats_export_fd) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics socket creation failed: %s\n", strerror (errno));
+    return RETURNerror;
+  }
+  addr.sun_family = AF_UNIX;
+  memcpy (addr.sun_path, socket_path->data, blength (socket_path));
+  unlink (addr.sun_path);
+  if ((0 > bind (g_stats_export_fd, (struct sockaddr *)&addr, sizeof (addr))) ||
+      (0 > listen (g_stats_export_fd, 4))) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics socket %s bind/listen failed: %s\n", addr.sun_path, strerror (errno));
+    close (g_stats_export_fd);
+    g_stats_export_fd = -1;
+    return RETURNerror;
+  }
+  g_stats_export_path = bstrcpy (socket_path);
+  if (pthread_create (&g_stats_export_thread, NULL, mme_app_statistics_export_thread, NULL)) {
+    OAILOG_ERROR (LOG_MME_APP, "Statistics export thread creation failed\n");
+    mme_app_statistics_export_exit ();
+    return RETURNerror;
+  }
+  OAILOG_INFO (LOG_MME_APP, "Statistics exported on UNIX socket %s\n", addr.sun_path);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void mme_app_statistics_export_exit(void)
+{
+  if (0 <= g_stats_export_fd) {
+    // wakes up accept()
+    shutdown (g_stats_export_fd, SHUT_RDWR);
+    if (g_stats_export_path) {
+      pthread_join (g_stats_export_thread, NULL);
+      unlink ((const char *)g_stats_export_path->data);
+    }
+    close (g_stats_export_fd);
+    g_stats_export_fd = -1;
+  }
+  bdestroy_wrapper (&g_stats_export_path);
+}
+
 /*********************************** Utility Functions to update Statistics**************************************/
 
-// Number of Connected eNBs 
+//------------------------------------------------------------------------------
+static inline void mme_app_stats_gauge_add(const mme_app_stats_gauge_t gauge)
+{
+  mme_app_stats_shard_t *shard = mme_app_stats_get_shard ();
+  mme_app_stats_add (shard, &shard->gauge_added[gauge], 1);
+}
+
+//------------------------------------------------------------------------------
+static inline void mme_app_stats_gauge_sub(const mme_app_stats_gauge_t gauge)
+{
+  mme_app_stats_shard_t *shard = mme_app_stats_get_shard ();
+  mme_app_stats_add (shard, &shard->gauge_removed[gauge], 1);
+}
+
+// Number of Connected eNBs
 void update_mme_app_stats_connected_enb_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_enb_connected)++;
-  (mme_app_desc.nb_enb_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_add (MME_APP_STATS_CONNECTED_ENB);
 }
 void update_mme_app_stats_connected_enb_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_enb_connected !=0)
-    (mme_app_desc.nb_enb_connected)--;
-  (mme_app_desc.nb_enb_released_since_last_stat)--;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_sub (MME_APP_STATS_CONNECTED_ENB);
 }
 
 /*****************************************************/
 // Number of Connected UEs
 void update_mme_app_stats_connected_ue_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_connected)++;
-  (mme_app_desc.nb_ue_connected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_add (MME_APP_STATS_CONNECTED_UE);
 }
 void update_mme_app_stats_connected_ue_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_connected !=0)
-    (mme_app_desc.nb_ue_connected)--;
-  (mme_app_desc.nb_ue_disconnected_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_sub (MME_APP_STATS_CONNECTED_UE);
 }
 
 /*****************************************************/
-// Number of S1U Bearers 
+// Number of S1U Bearers
 void update_mme_app_stats_s1u_bearer_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_s1u_bearers)++;
-  (mme_app_desc.nb_s1u_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_add (MME_APP_STATS_S1U_BEARER);
 }
 void update_mme_app_stats_s1u_bearer_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_s1u_bearers !=0)
-    (mme_app_desc.nb_s1u_bearers)--;
-  (mme_app_desc.nb_s1u_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_sub (MME_APP_STATS_S1U_BEARER);
 }
 
 /*****************************************************/
-// Number of Default EPS Bearers 
+// Number of Default EPS Bearers
 void update_mme_app_stats_default_bearer_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_default_eps_bearers)++;
-  (mme_app_desc.nb_eps_bearers_established_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_add (MME_APP_STATS_DEFAULT_BEARER);
 }
 void update_mme_app_stats_default_bearer_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_default_eps_bearers !=0)
-    (mme_app_desc.nb_default_eps_bearers)--;
-  (mme_app_desc.nb_eps_bearers_released_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_sub (MME_APP_STATS_DEFAULT_BEARER);
 }
 
 /*****************************************************/
-// Number of Attached UEs 
+// Number of Attached UEs
 void update_mme_app_stats_attached_ue_add(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  (mme_app_desc.nb_ue_attached)++;
-  (mme_app_desc.nb_ue_attached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_add (MME_APP_STATS_ATTACHED_UE);
 }
 void update_mme_app_stats_attached_ue_sub(void)
 {
-  mme_stats_write_lock (&mme_app_desc);
-  if (mme_app_desc.nb_ue_attached !=0)
-    (mme_app_desc.nb_ue_attached)--;
-  (mme_app_desc.nb_ue_detached_since_last_stat)++;
-  mme_stats_unlock(&mme_app_desc);
-  return;
+  mme_app_stats_gauge_sub (MME_APP_STATS_ATTACHED_UE);
+}
+
+/*********************************** Procedure latencies **************************************/
+
+//------------------------------------------------------------------------------
+static inline uint64_t mme_app_stats_now_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+//------------------------------------------------------------------------------
+void mme_app_stats_latency_start(uint64_t * const start_usec)
+{
+  *start_usec = mme_app_stats_now_usec ();
+}
+
+//------------------------------------------------------------------------------
+void mme_app_stats_latency_stop(const mme_app_stats_latency_t latency, uint64_t * const start_usec)
+{
+  mme_app_stats_shard_t *shard = NULL;
+  uint64_t               now = 0;
+  uint64_t               elapsed = 0;
+  int                    bucket = 0;
+
+  if ((!*start_usec) || (MME_APP_STATS_LATENCY_MAX <= latency)) {
+    return;
+  }
+  now = mme_app_stats_now_usec ();
+  elapsed = (now > *start_usec) ? now - *start_usec : 0;
+  *start_usec = 0;
+  // smallest bucket b such as elapsed <= 2^b
+  bucket = (elapsed <= 1) ? 0 : 64 - __builtin_clzll (elapsed - 1);
+  if (MME_APP_STATS_LATENCY_BUCKETS <= bucket) {
+    bucket = MME_APP_STATS_LATENCY_BUCKETS - 1;
+  }
+  shard = mme_app_stats_get_shard ();
+  mme_app_stats_add (shard, &shard->latency_count[latency][bucket], 1);
+  mme_app_stats_add (shard, &shard->latency_sum_usec[latency], elapsed);
 }
-/*****************************************************/
@@ -23,8 +23,61 @@
 #ifndef FILE_MME_APP_STATISTICS_SEEN
 #define FILE_MME_APP_STATISTICS_SEEN
 
+#include <stdint.h>
+#include "bstrlib.h"
+
+/* Counters are sharded per thread, a shard is only written by its owner thread and
+ * shards are summed on read (display timer, export socket).
+ */
+#define MME_APP_STATS_MAX_SHARDS                 64
+
+/* Latency histogram bucket i counts latencies <= 2^i microseconds, last bucket is unbounded */
+#define MME_APP_STATS_LATENCY_BUCKETS            26
+
+typedef enum {
+  MME_APP_STATS_CONNECTED_ENB = 0,
+  MME_APP_STATS_CONNECTED_UE,
+  MME_APP_STATS_ATTACHED_UE,
+  MME_APP_STATS_DEFAULT_BEARER,
+  MME_APP_STATS_S1U_BEARER,
+  MME_APP_STATS_GAUGE_MAX
+} mme_app_stats_gauge_t;
+
+typedef enum {
+  MME_APP_STATS_LATENCY_ATTACH = 0,          /*!< \brief Attach Request -> Attach Complete */
+  MME_APP_STATS_LATENCY_TAU,                 /*!< \brief TAU Request -> TAU Accept */
+  MME_APP_STATS_LATENCY_SERVICE_REQUEST,     /*!< \brief Service Request -> Modify Bearer Response */
+  MME_APP_STATS_LATENCY_S11_RTT,             /*!< \brief S11 request -> S11 response */
+  MME_APP_STATS_LATENCY_S6A_AIR_RTT,         /*!< \brief AIR -> AIA */
+  MME_APP_STATS_LATENCY_S6A_ULR_RTT,         /*!< \brief ULR -> ULA */
+  MME_APP_STATS_LATENCY_MAX
+} mme_app_stats_latency_t;
+
 int mme_app_statistics_display(void);
 
+/*
+ * Start the export endpoint: every connection on the UNIX stream socket socket_path receives
+ * a text dump of the aggregated counters and histograms, then is closed.
+ */
+int mme_app_statistics_export_init(const_bstring const socket_path);
+void mme_app_statistics_export_exit(void);
+
+/*
+ * Write the text dump of the aggregated counters and histograms in buffer.
+ */
+void mme_app_statistics_dump(bstring buffer);
+
+/* Counters of another task appended to the text dump, called from the export thread */
+#define MME_APP_STATS_MAX_DUMP_HOOKS             4
+typedef void (*mme_app_statistics_dump_hook_t)(bstring buffer);
+
+/*
+ * Register a dump hook, at initialization.
+ *
+ * @return RETURNok, RETURNerror if MME_APP_STATS_MAX_DUMP_HOOKS are already registered.
+ */
+int mme_app_statistics_register_dump(const mme_app_statistics_dump_hook_t hook);
+
 /*********************************** Utility Functions to update Statistics**************************************/
 void update_mme_app_stats_connected_enb_add(void);
 void update_mme_app_stats_connected_enb_sub(void);
@@ -37,4 +90,16 @@ void update_mme_app_stats_default_bearer_sub(void);
 void update_mme_app_stats_attached_ue_add(void);
 void update_mme_app_stats_attached_ue_sub(void);
 
+/*********************************** Procedure latencies **************************************/
+/*
+ * Store the current time (microseconds, monotonic clock) in start_usec.
+ */
+void mme_app_stats_latency_start(uint64_t * const start_usec);
+
+/*
+ * Record now - *start_usec in the histogram of the procedure and clear *start_usec.
+ * Nothing is recorded if *start_usec is 0 (procedure not started or already recorded).
+ */
+void mme_app_stats_latency_stop(const mme_app_stats_latency_t latency, uint64_t * const start_usec);
+
 #endif /* FILE_MME_APP_STATISTICS_SEEN */
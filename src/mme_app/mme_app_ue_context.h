@@ -52,6 +52,7 @@
 #include "sgw_ie_defs.h"
 #include "emm_data.h"
 #include "esm_data.h"
+#include "mme_app_statistics.h"
 
 
 
@@ -421,6 +422,8 @@ typedef struct ue_mm_context_s {
   struct mme_app_timer_t       implicit_detach_timer; 
   // Initial Context Setup Procedure Guard timer 
   struct mme_app_timer_t       initial_context_setup_rsp_timer; 
+  // Start time of running procedures for latency statistics, 0 if not running
+  uint64_t                     latency_start_usec[MME_APP_STATS_LATENCY_MAX];
 
 #define SUBSCRIPTION_UNKNOWN    false
 #define SUBSCRIPTION_KNOWN      true
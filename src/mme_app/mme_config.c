@@ -107,6 +107,7 @@ static void mme_config_init (mme_config_t * config_pP)
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
   config_pP->log_config.output             = NULL;
   config_pP->log_config.is_output_thread_safe = false;
+  config_pP->log_config.is_output_binary   = false;
   config_pP->log_config.color              = false;
   config_pP->log_config.udp_log_level      = MAX_LOG_LEVEL; // Means invalid
   config_pP->log_config.gtpv1u_log_level   = MAX_LOG_LEVEL; // will not overwrite existing log levels if MME and S-GW bundled in same executable
@@ -145,9 +146,14 @@ static void mme_config_init (mme_config_t * config_pP)
   config_pP->ipv4.if_name_s11 = NULL;
   config_pP->ipv4.s11.s_addr = INADDR_ANY;
   config_pP->ipv4.port_s11 = 2123;
+  config_pP->ipv4.threads_s11 = 1;
   config_pP->s6a_config.conf_file = bfromcstr(S6A_CONF_FILE);
+  config_pP->s6a_config.max_in_flight_per_hss = S6A_MAX_IN_FLIGHT_PER_HSS;
+  config_pP->s6a_config.request_backlog = S6A_REQUEST_BACKLOG;
+  config_pP->s6a_config.request_timeout_ms = S6A_REQUEST_TIMEOUT_MS;
   config_pP->itti_config.queue_size = ITTI_QUEUE_MAX_ELEMENTS;
   config_pP->itti_config.log_file = NULL;
+  config_pP->itti_config.trace_file = NULL;
   config_pP->sctp_config.in_streams = SCTP_IN_STREAMS;
   config_pP->sctp_config.out_streams = SCTP_OUT_STREAMS;
   config_pP->relative_capacity = RELATIVE_CAPACITY;
@@ -197,6 +203,7 @@ void mme_config_exit (void)
   bdestroy_wrapper(&mme_config.log_config.output);
   bdestroy_wrapper(&mme_config.realm);
   bdestroy_wrapper(&mme_config.config_file);
+  bdestroy_wrapper(&mme_config.mme_statistic_socket);
 
   /*
    * IP configuration
@@ -204,8 +211,11 @@ void mme_config_exit (void)
   bdestroy_wrapper(&mme_config.ipv4.if_name_s1_mme);
   bdestroy_wrapper(&mme_config.ipv4.if_name_s11);
   bdestroy_wrapper(&mme_config.s6a_config.conf_file);
-  bdestroy_wrapper(&mme_config.s6a_config.hss_host_name);
+  for (int i = 0; i < mme_config.s6a_config.nb_hss; i++) {
+    bdestroy_wrapper(&mme_config.s6a_config.hss_host_name[i]);
+  }
   bdestroy_wrapper(&mme_config.itti_config.log_file);
+  bdestroy_wrapper(&mme_config.itti_config.trace_file);
 
   free_wrapper((void**)&mme_config.served_tai.plmn_mcc);
   free_wrapper((void**)&mme_config.served_tai.plmn_mnc);
@@ -288,6 +298,16 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         }
       }
 
+      if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_OUTPUT_BINARY, (const char **)&astring)) {
+        if (astring != NULL) {
+          if (strcasecmp (astring, "yes") == 0) {
+            config_pP->log_config.is_output_binary = true;
+          } else {
+            config_pP->log_config.is_output_binary = false;
+          }
+        }
+      }
+
       if (config_setting_lookup_string (setting, LOG_CONFIG_STRING_COLOR, (const char **)&astring)) {
         if (0 == strcasecmp("yes", astring)) config_pP->log_config.color = true;
         else config_pP->log_config.color = false;
@@ -367,6 +387,12 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       config_pP->mme_statistic_timer = (uint32_t) aint;
     }
 
+    if ((config_setting_lookup_string (setting_mme, MME_CONFIG_STRING_STATISTIC_SOCKET, (const char **)&astring))) {
+      if (strlen(astring)) {
+        config_pP->mme_statistic_socket = bfromcstr (astring);
+      }
+    }
+
     if ((config_setting_lookup_string (setting_mme, EPS_NETWORK_FEATURE_SUPPORT_EMERGENCY_BEARER_SERVICES_IN_S1_MODE, (const char **)&astring))) {
       if (strcasecmp (astring, "yes") == 0)
         config_pP->eps_network_feature_support.emergency_bearer_services_in_s1_mode = 1;
@@ -406,6 +432,12 @@ static int mme_config_parse_file (mme_config_t * config_pP)
       if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE, &aint))) {
         config_pP->itti_config.queue_size = (uint32_t) aint;
       }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE, (const char **)&astring))) {
+        config_pP->itti_config.log_file = bfromcstr (astring);
+      }
+      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_FILE, (const char **)&astring))) {
+        config_pP->itti_config.trace_file = bfromcstr (astring);
+      }
     }
     // S6A SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_S6A_CONFIG);
@@ -421,15 +453,36 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         }
       }
 
-      if ((config_setting_lookup_string (setting, MME_CONFIG_STRING_S6A_HSS_HOSTNAME, (const char **)&astring))) {
-        if (astring != NULL) {
-          if (config_pP->s6a_config.hss_host_name) {
-            bassigncstr(config_pP->s6a_config.hss_host_name , astring);
-          } else {
-            config_pP->s6a_config.hss_host_name = bfromcstr(astring);
-          }
-        } else
-          AssertFatal (1 == 0, "You have to provide a valid HSS hostname %s=...\n", MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+      // One host name or a list of host names
+      subsetting = config_setting_get_member (setting, MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+      if (subsetting != NULL) {
+        for (i = 0; i < config_pP->s6a_config.nb_hss; i++) {
+          bdestroy_wrapper (&config_pP->s6a_config.hss_host_name[i]);
+        }
+        config_pP->s6a_config.nb_hss = 0;
+        num = (CONFIG_TYPE_STRING == config_setting_type (subsetting)) ? 1 : config_setting_length (subsetting);
+        AssertFatal ((0 < num) && (MME_CONFIG_MAX_HSS >= num), "Bad number of HSS %d in %s (max %d)\n", num, MME_CONFIG_STRING_S6A_HSS_HOSTNAME, MME_CONFIG_MAX_HSS);
+        for (i = 0; i < num; i++) {
+          astring = (CONFIG_TYPE_STRING == config_setting_type (subsetting)) ?
+              config_setting_get_string (subsetting) : config_setting_get_string_elem (subsetting, i);
+          AssertFatal ((astring) && (astring[0]), "You have to provide a valid HSS hostname %s=...\n", MME_CONFIG_STRING_S6A_HSS_HOSTNAME);
+          config_pP->s6a_config.hss_host_name[i] = bfromcstr (astring);
+          config_pP->s6a_config.nb_hss++;
+        }
+      }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT_PER_HSS, &aint))) {
+        AssertFatal (0 < aint, "Bad %s %d\n", MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT_PER_HSS, aint);
+        config_pP->s6a_config.max_in_flight_per_hss = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_REQUEST_BACKLOG, &aint))) {
+        AssertFatal (0 <= aint, "Bad %s %d\n", MME_CONFIG_STRING_S6A_REQUEST_BACKLOG, aint);
+        config_pP->s6a_config.request_backlog = (uint32_t) aint;
+      }
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT, &aint))) {
+        AssertFatal ((0 < aint) && ((aint + 2 * S6A_PIPELINE_TICK_MSEC) < S6A_AUTH_INFO_RSP_TIMER_MS), "Bad %s %d, must be below %d ms\n",
+            MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT, aint, S6A_AUTH_INFO_RSP_TIMER_MS - 2 * S6A_PIPELINE_TICK_MSEC);
+        config_pP->s6a_config.request_timeout_ms = (uint32_t) aint;
       }
     }
     // SCTP SETTING
@@ -643,6 +696,11 @@ static int mme_config_parse_file (mme_config_t * config_pP)
         OAILOG_INFO (LOG_MME_APP, "Parsing configuration file found S11: %s/%d on %s\n",
                        inet_ntoa (in_addr_var), config_pP->ipv4.netmask_s11, bdata(config_pP->ipv4.if_name_s11));
       }
+
+      if ((config_setting_lookup_int (setting, MME_CONFIG_STRING_MME_THREADS_FOR_S11, &aint))) {
+        AssertFatal(aint > 0, "Bad number of S11 threads %d", aint);
+        config_pP->ipv4.threads_s11 = (uint32_t)aint;
+      }
     }
     // NAS SETTING
     setting = config_setting_get_member (setting_mme, MME_CONFIG_STRING_NAS_CONFIG);
@@ -823,7 +881,8 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "- Extended service request .............: %s\n", config_pP->eps_network_feature_support.extended_service_request == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Unauth IMSI support ..................: %s\n", config_pP->unauthenticated_imsi_supported == 0 ? "false" : "true");
   OAILOG_INFO (LOG_CONFIG, "- Relative capa ........................: %u\n", config_pP->relative_capacity);
-  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics timer .....................: %u (seconds)\n", config_pP->mme_statistic_timer);
+  OAILOG_INFO (LOG_CONFIG, "- Statistics socket ....................: %s\n\n", (config_pP->mme_statistic_socket) ? bdata(config_pP->mme_statistic_socket) : "disabled");
   OAILOG_INFO (LOG_CONFIG, "- S1-MME:\n");
   OAILOG_INFO (LOG_CONFIG, "    port number ......: %d\n", config_pP->s1ap_config.port_number);
   OAILOG_INFO (LOG_CONFIG, "- IP:\n");
@@ -832,9 +891,11 @@ static void mme_config_display (mme_config_t * config_pP)
   OAILOG_INFO (LOG_CONFIG, "    s11 MME iface ....: %s\n", bdata(config_pP->ipv4.if_name_s11));
   OAILOG_INFO (LOG_CONFIG, "    s11 MME port .....: %d\n", config_pP->ipv4.port_s11);
   OAILOG_INFO (LOG_CONFIG, "    s11 MME ip .......: %s\n", inet_ntoa (*((struct in_addr *)&config_pP->ipv4.s11)));
+  OAILOG_INFO (LOG_CONFIG, "    s11 MME threads ..: %u\n", config_pP->ipv4.threads_s11);
   OAILOG_INFO (LOG_CONFIG, "- ITTI:\n");
   OAILOG_INFO (LOG_CONFIG, "    queue size .......: %u (bytes)\n", config_pP->itti_config.queue_size);
-  OAILOG_INFO (LOG_CONFIG, "    log file .........: %s\n", bdata(config_pP->itti_config.log_file));
+  OAILOG_INFO (LOG_CONFIG, "    capture file .....: %s\n", bdata(config_pP->itti_config.log_file));
+  OAILOG_INFO (LOG_CONFIG, "    trace file .......: %s\n", bdata(config_pP->itti_config.trace_file));
   OAILOG_INFO (LOG_CONFIG, "- SCTP:\n");
   OAILOG_INFO (LOG_CONFIG, "    in streams .......: %u\n", config_pP->sctp_config.in_streams);
   OAILOG_INFO (LOG_CONFIG, "    out streams ......: %u\n", config_pP->sctp_config.out_streams);
@@ -893,9 +954,16 @@ static void mme_config_display (mme_config_t * config_pP)
 
   OAILOG_INFO (LOG_CONFIG, "- S6A:\n");
   OAILOG_INFO (LOG_CONFIG, "    conf file ........: %s\n", bdata(config_pP->s6a_config.conf_file));
+  for (int i = 0; i < config_pP->s6a_config.nb_hss; i++) {
+    OAILOG_INFO (LOG_CONFIG, "    HSS host name ....: %s\n", bdata(config_pP->s6a_config.hss_host_name[i]));
+  }
+  OAILOG_INFO (LOG_CONFIG, "    in flight per HSS : %u\n", config_pP->s6a_config.max_in_flight_per_hss);
+  OAILOG_INFO (LOG_CONFIG, "    request backlog ..: %u\n", config_pP->s6a_config.request_backlog);
+  OAILOG_INFO (LOG_CONFIG, "    request timeout ..: %u ms\n", config_pP->s6a_config.request_timeout_ms);
   OAILOG_INFO (LOG_CONFIG, "- Logging:\n");
   OAILOG_INFO (LOG_CONFIG, "    Output ..............: %s\n", bdata(config_pP->log_config.output));
   OAILOG_INFO (LOG_CONFIG, "    Output thread safe ..: %s\n", (config_pP->log_config.is_output_thread_safe) ? "true":"false");
+  OAILOG_INFO (LOG_CONFIG, "    Output binary .......: %s\n", (config_pP->log_config.is_output_binary) ? "true":"false");
   OAILOG_INFO (LOG_CONFIG, "    Output with color ...: %s\n", (config_pP->log_config.color) ? "true":"false");
   OAILOG_INFO (LOG_CONFIG, "    UDP log level........: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.udp_log_level));
   OAILOG_INFO (LOG_CONFIG, "    GTPV2-C log level....: %s\n", OAILOG_LEVEL_INT2STR(config_pP->log_config.gtpv2c_log_level));
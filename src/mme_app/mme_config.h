@@ -54,6 +54,7 @@
 #define MME_CONFIG_STRING_MAXUE                          "MAXUE"
 #define MME_CONFIG_STRING_RELATIVE_CAPACITY              "RELATIVE_CAPACITY"
 #define MME_CONFIG_STRING_STATISTIC_TIMER                "MME_STATISTIC_TIMER"
+#define MME_CONFIG_STRING_STATISTIC_SOCKET               "MME_STATISTIC_SOCKET"
 
 #define MME_CONFIG_STRING_EMERGENCY_ATTACH_SUPPORTED     "EMERGENCY_ATTACH_SUPPORTED"
 #define MME_CONFIG_STRING_UNAUTHENTICATED_IMSI_SUPPORTED "UNAUTHENTICATED_IMSI_SUPPORTED"
@@ -66,10 +67,15 @@
 
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_CONFIG     "INTERTASK_INTERFACE"
 #define MME_CONFIG_STRING_INTERTASK_INTERFACE_QUEUE_SIZE "ITTI_QUEUE_SIZE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_TRACE_FILE "ITTI_TRACE_FILE"
+#define MME_CONFIG_STRING_INTERTASK_INTERFACE_CAPTURE_FILE "ITTI_CAPTURE_FILE"
 
 #define MME_CONFIG_STRING_S6A_CONFIG                     "S6A"
 #define MME_CONFIG_STRING_S6A_CONF_FILE_PATH             "S6A_CONF"
 #define MME_CONFIG_STRING_S6A_HSS_HOSTNAME               "HSS_HOSTNAME"
+#define MME_CONFIG_STRING_S6A_MAX_IN_FLIGHT_PER_HSS      "MAX_IN_FLIGHT_PER_HSS"
+#define MME_CONFIG_STRING_S6A_REQUEST_BACKLOG            "REQUEST_BACKLOG"
+#define MME_CONFIG_STRING_S6A_REQUEST_TIMEOUT            "REQUEST_TIMEOUT_MS"
 
 #define MME_CONFIG_STRING_SCTP_CONFIG                    "SCTP"
 #define MME_CONFIG_STRING_SCTP_INSTREAMS                 "SCTP_INSTREAMS"
@@ -94,6 +100,7 @@
 #define MME_CONFIG_STRING_INTERFACE_NAME_FOR_S11_MME     "MME_INTERFACE_NAME_FOR_S11_MME"
 #define MME_CONFIG_STRING_IPV4_ADDRESS_FOR_S11_MME       "MME_IPV4_ADDRESS_FOR_S11_MME"
 #define MME_CONFIG_STRING_MME_PORT_FOR_S11               "MME_PORT_FOR_S11_MME"
+#define MME_CONFIG_STRING_MME_THREADS_FOR_S11            "MME_THREADS_FOR_S11_MME"
 
 
 #define MME_CONFIG_STRING_NAS_CONFIG                     "NAS"
@@ -139,6 +146,7 @@ typedef struct mme_config_s {
   uint8_t relative_capacity;
 
   uint32_t mme_statistic_timer;
+  bstring  mme_statistic_socket;
 
   uint8_t unauthenticated_imsi_supported;
 
@@ -185,16 +193,23 @@ typedef struct mme_config_s {
     struct in_addr s11;
     int        netmask_s11;
     uint16_t   port_s11;
+    uint32_t   threads_s11;
 
   } ipv4;
 
   struct {
-    bstring conf_file;
-    bstring hss_host_name;
+    bstring  conf_file;
+    int      nb_hss;
+#define MME_CONFIG_MAX_HSS 8
+    bstring  hss_host_name[MME_CONFIG_MAX_HSS];  // requests are load balanced between the HSS
+    uint32_t max_in_flight_per_hss;
+    uint32_t request_backlog;
+    uint32_t request_timeout_ms;
   } s6a_config;
   struct {
     uint32_t  queue_size;
     bstring   log_file;
+    bstring   trace_file;
   } itti_config;
 
   struct {
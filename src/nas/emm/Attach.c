@@ -582,6 +582,7 @@ int emm_proc_attach_complete (
   if (ue_mm_context) {
     if (is_nas_specific_procedure_attach_running (&ue_mm_context->emm_context)) {
       attach_proc = (nas_emm_attach_proc_t*)ue_mm_context->emm_context.emm_procedures->emm_specific_proc;
+      mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_ATTACH, &ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_ATTACH]);
 
       /*
        * Upon receiving an ATTACH COMPLETE message, the MME shall enter state EMM-REGISTERED
@@ -672,6 +673,7 @@ static void _emm_proc_create_procedure_attach_request(ue_mm_context_t * const ue
   nas_emm_attach_proc_t *attach_proc = nas_new_attach_procedure(&ue_mm_context->emm_context);
   AssertFatal(attach_proc, "TODO Handle this");
   if ((attach_proc)) {
+    mme_app_stats_latency_start (&ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_ATTACH]);
     attach_proc->ies = ies;
     ((nas_base_proc_t*)attach_proc)->abort = _emm_attach_abort;
     ((nas_base_proc_t*)attach_proc)->fail_in = NULL; // No parent procedure
@@ -102,7 +102,9 @@ static int _authentication_ll_failure (struct emm_context_s *emm_context, struct
 static int _authentication_non_delivered_ho (struct emm_context_s *emm_context, struct nas_emm_proc_s * emm_proc);
 static int _authentication_abort (struct emm_context_s *emm_context, struct nas_base_proc_s * base_proc);
 
-static int _start_authentication_information_procedure(struct emm_context_s *emm_context, nas_emm_auth_proc_t * const auth_proc, const_bstring auts);
+static int _start_authentication_information_procedure(struct emm_context_s *emm_context, nas_emm_auth_proc_t * const auth_proc, const uint8_t nb_vectors, const_bstring auts);
+static void _refill_authentication_vectors(struct emm_context_s *emm_context);
+static bool _auth_info_proc_send_pending_resync (struct emm_context_s *emm_ctx, nas_auth_info_proc_t * const auth_info_proc);
 static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx);
 static int _auth_info_proc_failure_cb (struct emm_context_s *emm_ctx);
 
@@ -271,41 +273,35 @@ emm_proc_authentication (
     auth_proc->emm_com_proc.emm_proc.base_proc.fail_out      = _authentication_reject;
     auth_proc->emm_com_proc.emm_proc.base_proc.time_out      = NULL;
 
-    bool  run_auth_info_proc = false;
-    if (!IS_EMM_CTXT_VALID_AUTH_VECTORS(emm_context)) {
+    auth_proc->vector_index = EMM_SECURITY_VECTOR_INDEX_INVALID;
+    int vector_index = emm_ctx_next_auth_vector(emm_context);
+    if (0 > vector_index) {
       // Ask upper layer to fetch new security context
       nas_auth_info_proc_t * auth_info_proc = get_nas_cn_procedure_auth_info(emm_context);
-      if (!auth_info_proc) {
-        auth_info_proc = nas_new_cn_auth_info_procedure(emm_context);
-      }
-      if (!auth_info_proc->request_sent) {
-        run_auth_info_proc = true;
+      if ((auth_info_proc) && (auth_info_proc->request_sent)) {
+        // A refill is already in flight, its answer will start the authentication
+        auth_info_proc->cn_proc.base_proc.parent = &auth_proc->emm_com_proc.emm_proc.base_proc;
+        auth_proc->emm_com_proc.emm_proc.base_proc.child = &auth_info_proc->cn_proc.base_proc;
+        rc = RETURNok;
+      } else {
+        rc = _start_authentication_information_procedure(emm_context, auth_proc, emm_ctx_free_auth_vectors(emm_context), NULL);
       }
-      rc = RETURNok;
     } else {
       ksi_t                                   eksi = 0;
       if (emm_context->_security.eksi < KSI_NO_KEY_AVAILABLE) {
         REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
         eksi = (emm_context->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
       }
-      for (; eksi < MAX_EPS_AUTH_VECTORS; eksi++) {
-        if (IS_EMM_CTXT_VALID_AUTH_VECTOR(emm_context, (eksi % MAX_EPS_AUTH_VECTORS))) {
-          break;
-        }
-      }
-      // eksi should always be 0
-      if (!IS_EMM_CTXT_VALID_AUTH_VECTOR(emm_context, (eksi % MAX_EPS_AUTH_VECTORS))) {
-        run_auth_info_proc = true;
-      } else {
-        rc = emm_proc_authentication_ksi (emm_context, emm_specific_proc, eksi,
-          emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].rand,
-          emm_context->_vector[eksi % MAX_EPS_AUTH_VECTORS].autn,
-          success, failure);
-        OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
-      }
-    }
-    if (run_auth_info_proc) {
-      rc = _start_authentication_information_procedure(emm_context, auth_proc, NULL);
+      OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " EMM-PROC  - Using cached auth vector %d (%d left)\n",
+          ue_id, vector_index, emm_context->remaining_vectors - 1);
+      auth_proc->vector_index = vector_index;
+      emm_ctx_use_auth_vector(emm_context, vector_index);
+      _refill_authentication_vectors(emm_context);
+
+      rc = emm_proc_authentication_ksi (emm_context, emm_specific_proc, eksi,
+        emm_context->_vector[vector_index].rand,
+        emm_context->_vector[vector_index].autn,
+        success, failure);
     }
   }
 
@@ -313,7 +309,25 @@ emm_proc_authentication (
 }
 
 //------------------------------------------------------------------------------
-static int _start_authentication_information_procedure(struct emm_context_s *emm_context, nas_emm_auth_proc_t * const auth_proc, const_bstring auts)
+/*
+ * Ask the HSS for new vectors in background while the UE is still served from the cached ones,
+ * the answer is stored in the EMM context and consumed by the next authentications.
+ */
+static void _refill_authentication_vectors(struct emm_context_s *emm_context)
+{
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  int nb_vectors = emm_ctx_free_auth_vectors(emm_context);
+
+  if ((EMM_AUTH_VECTORS_REFILL_THRESHOLD >= emm_context->remaining_vectors) && (0 < nb_vectors) &&
+      (!get_nas_cn_procedure_auth_info(emm_context))) {
+    OAILOG_DEBUG (LOG_NAS_EMM, "EMM-PROC  - %d auth vector(s) left, refill %d\n", emm_context->remaining_vectors, nb_vectors);
+    _start_authentication_information_procedure(emm_context, NULL, nb_vectors, NULL);
+  }
+  OAILOG_FUNC_OUT (LOG_NAS_EMM);
+}
+
+//------------------------------------------------------------------------------
+static int _start_authentication_information_procedure(struct emm_context_s *emm_context, nas_emm_auth_proc_t * const auth_proc, const uint8_t nb_vectors, const_bstring auts)
 {
   OAILOG_FUNC_IN (LOG_NAS_EMM);
   mme_ue_s1ap_id_t                        ue_id = PARENT_STRUCT(emm_context, struct ue_mm_context_s, emm_context)->mme_ue_s1ap_id;
@@ -324,8 +338,11 @@ static int _start_authentication_information_procedure(struct emm_context_s *emm
     auth_info_proc->request_sent = false;
   }
 
-  auth_info_proc->cn_proc.base_proc.parent = &auth_proc->emm_com_proc.emm_proc.base_proc;
-  auth_proc->emm_com_proc.emm_proc.base_proc.child = &auth_info_proc->cn_proc.base_proc;
+  // No parent for background refills
+  if (auth_proc) {
+    auth_info_proc->cn_proc.base_proc.parent = &auth_proc->emm_com_proc.emm_proc.base_proc;
+    auth_proc->emm_com_proc.emm_proc.base_proc.child = &auth_info_proc->cn_proc.base_proc;
+  }
   auth_info_proc->success_notif = _auth_info_proc_success_cb;
   auth_info_proc->failure_notif = _auth_info_proc_failure_cb;
   auth_info_proc->cn_proc.base_proc.time_out = s6a_auth_info_rsp_timer_expiry_handler;
@@ -345,7 +362,8 @@ static int _start_authentication_information_procedure(struct emm_context_s *emm
 
   nas_start_Ts6a_auth_info (auth_info_proc->ue_id, &auth_info_proc->timer_s6a, auth_info_proc->cn_proc.base_proc.time_out, emm_context);
 
-  nas_itti_auth_info_req (ue_id, &emm_context->_imsi, is_initial_req, &visited_plmn, MAX_EPS_AUTH_VECTORS, auts);
+  mme_app_stats_latency_start (&PARENT_STRUCT(emm_context, struct ue_mm_context_s, emm_context)->latency_start_usec[MME_APP_STATS_LATENCY_S6A_AIR_RTT]);
+  nas_itti_auth_info_req (ue_id, &emm_context->_imsi, is_initial_req, &visited_plmn, (nb_vectors) ? nb_vectors:1, auts);
 
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
 }
@@ -361,13 +379,38 @@ static int _start_authentication_information_procedure_synch(struct emm_context_
   if (!auth_info_proc) {
     auth_info_proc = nas_new_cn_auth_info_procedure(emm_context);
     auth_info_proc->request_sent = true;
-    _start_authentication_information_procedure(emm_context, auth_proc, auts);
+    _start_authentication_information_procedure(emm_context, auth_proc, emm_ctx_free_auth_vectors(emm_context), auts);
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
   }
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
 }
 
 
+//------------------------------------------------------------------------------
+/*
+ * The UE reported a synch failure while a request was in flight: the answer of this request
+ * was computed from the stale SQN, discard it and send the re-synchronisation request instead.
+ */
+static bool _auth_info_proc_send_pending_resync (struct emm_context_s *emm_ctx, nas_auth_info_proc_t * const auth_info_proc)
+{
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  if (!auth_info_proc->resync_param) {
+    OAILOG_FUNC_RETURN (LOG_NAS_EMM, false);
+  }
+  bstring resync_param = auth_info_proc->resync_param;
+  auth_info_proc->resync_param = NULL;
+  auth_info_proc->nb_vectors   = 0;
+
+  void * unused = NULL;
+  nas_stop_Ts6a_auth_info(auth_info_proc->ue_id, &auth_info_proc->timer_s6a, unused);
+  OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Discard auth vectors answer, send pending re-synchronisation UE id " MME_UE_S1AP_ID_FMT "\n", auth_info_proc->ue_id);
+
+  nas_emm_auth_proc_t * auth_proc = get_nas_common_procedure_authentication(emm_ctx);
+  _start_authentication_information_procedure(emm_ctx, auth_proc, emm_ctx_free_auth_vectors(emm_ctx), resync_param);
+  bdestroy_wrapper(&resync_param);
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, true);
+}
+
 //------------------------------------------------------------------------------
 static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
 {
@@ -382,50 +425,43 @@ static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
       OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
     }
 
-    // compute next eksi
-    ksi_t eksi = 0;
-    if (emm_ctx->_security.eksi <  KSI_NO_KEY_AVAILABLE) {
-      REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
-      eksi = (emm_ctx->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
+    if (_auth_info_proc_send_pending_resync (emm_ctx, auth_info_proc)) {
+      OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
     }
 
     /*
-     * Copy provided vector to user context
+     * Copy provided vectors to user context
      */
     for (int i = 0; i < auth_info_proc->nb_vectors; i++) {
-      AssertFatal (MAX_EPS_AUTH_VECTORS > i, " TOO many vectors");
-      int destination_index = (i + eksi)%MAX_EPS_AUTH_VECTORS;
-      memcpy (emm_ctx->_vector[destination_index].kasme, auth_info_proc->vector[i]->kasme, AUTH_KASME_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].autn,  auth_info_proc->vector[i]->autn, AUTH_AUTN_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].rand, auth_info_proc->vector[i]->rand, AUTH_RAND_SIZE);
-      memcpy (emm_ctx->_vector[destination_index].xres, auth_info_proc->vector[i]->xres.data, auth_info_proc->vector[i]->xres.size);
-      emm_ctx->_vector[destination_index].xres_size = auth_info_proc->vector[i]->xres.size;
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received Vector %u:\n", i);
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n", XRES_DISPLAY (emm_ctx->_vector[destination_index].xres));
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n", RAND_DISPLAY (emm_ctx->_vector[destination_index].rand));
-      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n", AUTN_DISPLAY (emm_ctx->_vector[destination_index].autn));
+      int vector_index = emm_ctx_store_auth_vector(emm_ctx, auth_info_proc->vector[i]);
+      if (0 > vector_index) {
+        OAILOG_WARNING (LOG_NAS_EMM, "EMM-PROC  - No room for received Vector %u, dropped\n", i);
+        continue;
+      }
+      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received Vector %u (stored at %d):\n", i, vector_index);
+      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received XRES ..: " XRES_FORMAT "\n", XRES_DISPLAY (emm_ctx->_vector[vector_index].xres));
+      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received RAND ..: " RAND_FORMAT "\n", RAND_DISPLAY (emm_ctx->_vector[vector_index].rand));
+      OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received AUTN ..: " AUTN_FORMAT "\n", AUTN_DISPLAY (emm_ctx->_vector[vector_index].autn));
       OAILOG_INFO (LOG_NAS_EMM, "EMM-PROC  - Received KASME .: " KASME_FORMAT " " KASME_FORMAT "\n",
-          KASME_DISPLAY_1 (emm_ctx->_vector[destination_index].kasme), KASME_DISPLAY_2 (emm_ctx->_vector[destination_index].kasme));
-      emm_ctx_set_attribute_valid(emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTOR0+destination_index);
+          KASME_DISPLAY_1 (emm_ctx->_vector[vector_index].kasme), KASME_DISPLAY_2 (emm_ctx->_vector[vector_index].kasme));
     }
 
     nas_emm_auth_proc_t * auth_proc = get_nas_common_procedure_authentication(emm_ctx);
 
-    if (auth_proc) {
-      if (auth_info_proc->nb_vectors > 0) {
-        emm_ctx_set_attribute_present(emm_ctx, EMM_CTXT_MEMBER_AUTH_VECTORS);
+    // An authentication procedure already running on a cached vector does not wait for this answer
+    if ((auth_proc) && (EMM_SECURITY_VECTOR_INDEX_INVALID == auth_proc->vector_index)) {
+      int vector_index = emm_ctx_next_auth_vector(emm_ctx);
 
-        for (; eksi < MAX_EPS_AUTH_VECTORS; eksi++) {
-          if (IS_EMM_CTXT_VALID_AUTH_VECTOR(emm_ctx, (eksi % MAX_EPS_AUTH_VECTORS))) {
-            break;
-          }
+      if (0 <= vector_index) {
+        // compute next eksi
+        ksi_t eksi = 0;
+        if (emm_ctx->_security.eksi <  KSI_NO_KEY_AVAILABLE) {
+          REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
+          eksi = (emm_ctx->_security.eksi + 1) % (EKSI_MAX_VALUE + 1);
         }
-        // eksi should always be 0
-        ksi_t eksi_mod = eksi % MAX_EPS_AUTH_VECTORS;
-        AssertFatal(IS_EMM_CTXT_VALID_AUTH_VECTOR(emm_ctx, eksi_mod), "TODO No valid vector, should not happen");
-
-
-        auth_proc->ksi = eksi;
+        auth_proc->ksi          = eksi;
+        auth_proc->vector_index = vector_index;
+        emm_ctx_use_auth_vector(emm_ctx, vector_index);
 
         // re-enter previous EMM state, before re-initiating the procedure
         emm_sap_t                               emm_sap = {0};
@@ -439,9 +475,9 @@ static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
         rc = emm_sap_send (&emm_sap);
 
 
-        rc = emm_proc_authentication_ksi (emm_ctx, (nas_emm_specific_proc_t*)auth_info_proc->cn_proc.base_proc.parent, eksi,
-            emm_ctx->_vector[eksi % MAX_EPS_AUTH_VECTORS].rand,
-            emm_ctx->_vector[eksi % MAX_EPS_AUTH_VECTORS].autn,
+        rc = emm_proc_authentication_ksi (emm_ctx, (nas_emm_specific_proc_t*)((nas_base_proc_t *)auth_proc)->parent, eksi,
+            emm_ctx->_vector[vector_index].rand,
+            emm_ctx->_vector[vector_index].autn,
             auth_proc->emm_com_proc.emm_proc.base_proc.success_notif,
             auth_proc->emm_com_proc.emm_proc.base_proc.failure_notif);
 
@@ -473,6 +509,7 @@ static int _auth_info_proc_success_cb (struct emm_context_s *emm_ctx)
       }
     } else {
       nas_delete_cn_procedure(emm_ctx, &auth_info_proc->cn_proc);
+      rc = RETURNok;
     }
   }
   OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
@@ -488,12 +525,17 @@ static int _auth_info_proc_failure_cb (struct emm_context_s *emm_ctx)
   int                                     rc = RETURNerror;
 
   if (auth_info_proc) {
+    if (_auth_info_proc_send_pending_resync (emm_ctx, auth_info_proc)) {
+      OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+    }
+
     nas_emm_auth_proc_t * auth_proc = get_nas_common_procedure_authentication(emm_ctx);
 
     int emm_cause = auth_info_proc->nas_cause;
     nas_delete_cn_procedure(emm_ctx, &auth_info_proc->cn_proc);
 
-    if (auth_proc) {
+    // A failed background refill does not affect an authentication running on a cached vector
+    if ((auth_proc) && (EMM_SECURITY_VECTOR_INDEX_INVALID == auth_proc->vector_index)) {
       auth_proc->emm_cause = emm_cause;
 
       if (EMM_COMMON_PROCEDURE_INITIATED == emm_fsm_get_state(emm_ctx)) {
@@ -577,12 +619,26 @@ int emm_proc_authentication_failure (
           OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
         }
 
-        memcpy (resync_param.data, (emm_ctx->_vector[emm_ctx->_security.vector_index].rand), RAND_LENGTH_OCTETS);
+        memcpy (resync_param.data, auth_proc->rand, RAND_LENGTH_OCTETS);
         memcpy ((resync_param.data + RAND_LENGTH_OCTETS), auts->data, AUTS_LENGTH);
-        // TODO: Double check this case as there is no identity request being sent.
-        _start_authentication_information_procedure_synch(emm_ctx, auth_proc, &resync_param);
+        // The cached vectors were computed from the SQN the USIM rejected, the vectors of the security contexts stay
+        auth_proc->vector_index = EMM_SECURITY_VECTOR_INDEX_INVALID;
+        emm_ctx_clear_unused_auth_vectors(emm_ctx);
+
+        nas_auth_info_proc_t * auth_info_proc = get_nas_cn_procedure_auth_info(emm_ctx);
+        if (auth_info_proc) {
+          // A refill is in flight, re-synchronise when it completes
+          if (auth_info_proc->resync_param) {
+            bdestroy_wrapper(&auth_info_proc->resync_param);
+          }
+          auth_info_proc->resync_param = blk2bstr(resync_param.data, RESYNC_PARAM_LENGTH);
+          auth_info_proc->cn_proc.base_proc.parent = &auth_proc->emm_com_proc.emm_proc.base_proc;
+          auth_proc->emm_com_proc.emm_proc.base_proc.child = &auth_info_proc->cn_proc.base_proc;
+        } else {
+          // TODO: Double check this case as there is no identity request being sent.
+          _start_authentication_information_procedure_synch(emm_ctx, auth_proc, &resync_param);
+        }
         free_wrapper((void**)&resync_param.data);
-        emm_ctx_clear_auth_vectors(emm_ctx);
         rc = RETURNok;
         unlock_ue_contexts(ue_mm_context);
         OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
@@ -770,6 +826,9 @@ emm_proc_authentication_complete (
 
     REQUIREMENT_3GPP_24_301(R10_5_4_2_4__2);
     emm_ctx_set_security_eksi(emm_ctx, auth_proc->ksi);
+    if (EMM_SECURITY_VECTOR_INDEX_INVALID != auth_proc->vector_index) {
+      emm_ctx_set_security_vector_index(emm_ctx, auth_proc->vector_index);
+    }
     OAILOG_DEBUG (LOG_NAS_EMM, "EMM-PROC  - Success to authentify the UE  RESP XRES == XRES UE CONTEXT\n");
     /*
      * Notify EMM that the authentication procedure successfully completed
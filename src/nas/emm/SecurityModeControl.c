@@ -233,8 +233,8 @@ emm_proc_security_mode_control (
 
       emm_ctx_set_security_type(emm_ctx, SECURITY_CTX_TYPE_FULL_NATIVE);
       AssertFatal(KSI_NO_KEY_AVAILABLE > emm_ctx->_security.eksi, "eksi not valid");
-      derive_key_nas (NAS_INT_ALG, emm_ctx->_security.selected_algorithms.integrity,  emm_ctx->_vector[emm_ctx->_security.eksi%MAX_EPS_AUTH_VECTORS].kasme, emm_ctx->_security.knas_int);
-      derive_key_nas (NAS_ENC_ALG, emm_ctx->_security.selected_algorithms.encryption, emm_ctx->_vector[emm_ctx->_security.eksi%MAX_EPS_AUTH_VECTORS].kasme, emm_ctx->_security.knas_enc);
+      derive_key_nas (NAS_INT_ALG, emm_ctx->_security.selected_algorithms.integrity,  emm_ctx->_vector[emm_ctx->_security.vector_index].kasme, emm_ctx->_security.knas_int);
+      derive_key_nas (NAS_ENC_ALG, emm_ctx->_security.selected_algorithms.encryption, emm_ctx->_vector[emm_ctx->_security.vector_index].kasme, emm_ctx->_security.knas_enc);
       /*
        * Set new security context indicator
        */
@@ -115,6 +115,7 @@ int emm_proc_tracking_area_update_request (
   ue_mm_context = mme_ue_context_exists_mme_ue_s1ap_id (&mme_app_desc.mme_ue_contexts, ue_id);
   if (ue_mm_context) {
     emm_context = &ue_mm_context->emm_context;
+    mme_app_stats_latency_start (&ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_TAU]);
   }
 
   // May be the MME APP module did not find the context, but if we have the GUTI, we may find it
@@ -497,6 +498,9 @@ static int _emm_tracking_area_update_accept (nas_emm_tau_proc_t * const tau_proc
 
       nas_delete_tau_procedure(emm_context);
     }
+    if (RETURNerror != rc) {
+      mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_TAU, &ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_TAU]);
+    }
   } else {
     OAILOG_WARNING (LOG_NAS_EMM, "EMM-PROC  - TAU procedure NULL");
   }
@@ -61,6 +61,7 @@ Description Defines internal private data handled by EPS Mobility
 /****************************************************************************/
 
 #define TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE 2 // two second timeout value to wait for auth_info_rsp message from HSS
+#define EMM_AUTH_VECTORS_REFILL_THRESHOLD     1 // ask the HSS for new vectors in background when that many or less remain unused
 
 /****************************************************************************/
 /************************  G L O B A L    T Y P E S  ************************/
@@ -163,6 +164,7 @@ typedef struct emm_context_s {
 //#define           EMM_CTXT_MEMBER_AUTH_VECTOR3                 ((uint32_t)1 << 29)  // reserved bit for AUTH VECTOR
 //#define           EMM_CTXT_MEMBER_AUTH_VECTOR4                 ((uint32_t)1 << 30)  // reserved bit for AUTH VECTOR
 //#define           EMM_CTXT_MEMBER_AUTH_VECTOR5                 ((uint32_t)1 << 31)  // reserved bit for AUTH VECTOR
+#define           EMM_CTXT_MEMBER_AUTH_VECTOR( vEcToRiNdEx )     (EMM_CTXT_MEMBER_AUTH_VECTOR0 << (vEcToRiNdEx))
 
 #define           EMM_CTXT_MEMBER_SET_BIT( eMmCtXtMemBeRmAsK, bIt )   do { (eMmCtXtMemBeRmAsK) |= bIt;} while (0)
 #define           EMM_CTXT_MEMBER_CLEAR_BIT( eMmCtXtMemBeRmAsK, bIt ) do { (eMmCtXtMemBeRmAsK) &= ~bIt;} while (0)
@@ -188,6 +190,8 @@ typedef struct emm_context_s {
 
   int                      remaining_vectors;         // remaining unused vectors
   auth_vector_t            _vector[MAX_EPS_AUTH_VECTORS];/* EPS authentication vector                            */
+  uint32_t                 vectors_received;          // number of vectors stored so far, orders _vector_seq
+  uint32_t                 _vector_seq[MAX_EPS_AUTH_VECTORS];/* arrival order of each vector, oldest is used first */
   emm_security_context_t   _security;                /* Current EPS security context: The security context which has been activated most recently. Note that a current EPS
                                                         security context originating from either a mapped or native EPS security context may exist simultaneously with a native
                                                         non-current EPS security context.*/
@@ -311,6 +315,11 @@ void emm_ctx_set_valid_lvr_tai(emm_context_t * const ctxt, tai_t *lvr_tai) __att
 
 void emm_ctx_clear_auth_vectors(emm_context_t * const ctxt) __attribute__ ((nonnull)) __attribute__ ((flatten));
 void emm_ctx_clear_auth_vector(emm_context_t * const ctxt, ksi_t eksi) __attribute__ ((nonnull)) __attribute__ ((flatten));
+int  emm_ctx_store_auth_vector(emm_context_t * const ctxt, const eutran_vector_t * const vector) __attribute__ ((nonnull)) ;
+int  emm_ctx_free_auth_vectors(const emm_context_t * const ctxt) __attribute__ ((nonnull)) ;
+void emm_ctx_clear_unused_auth_vectors(emm_context_t * const ctxt) __attribute__ ((nonnull)) ;
+int  emm_ctx_next_auth_vector(const emm_context_t * const ctxt) __attribute__ ((nonnull)) ;
+void emm_ctx_use_auth_vector(emm_context_t * const ctxt, const int vector_index) __attribute__ ((nonnull)) ;
 void emm_ctx_clear_security(emm_context_t * const ctxt) __attribute__ ((nonnull)) __attribute__ ((flatten));
 void emm_ctx_set_security_type(emm_context_t * const ctxt, emm_sc_type_t sc_type) __attribute__ ((nonnull)) __attribute__ ((flatten));
 void emm_ctx_set_security_eksi(emm_context_t * const ctxt, ksi_t eksi) __attribute__ ((nonnull)) __attribute__ ((flatten));
@@ -265,8 +265,9 @@ inline void emm_ctx_clear_auth_vectors(emm_context_t * const ctxt)
   emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
   for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
     memset((void *)&ctxt->_vector[i], 0, sizeof(ctxt->_vector[i]));
-    emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0+i);
+    emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR(i));
   }
+  ctxt->remaining_vectors = 0;
   emm_ctx_clear_security_vector_index(ctxt);
   OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " cleared auth vectors \n", (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id);
 }
@@ -276,7 +277,7 @@ inline void emm_ctx_clear_auth_vector(emm_context_t * const ctxt, ksi_t eksi)
 {
   AssertFatal(eksi < MAX_EPS_AUTH_VECTORS, "Out of bounds eksi %d", eksi);
   memset((void *)&ctxt->_vector[eksi%MAX_EPS_AUTH_VECTORS], 0, sizeof(ctxt->_vector[eksi%MAX_EPS_AUTH_VECTORS]));
-  emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR0+eksi);
+  emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR(eksi));
   int remaining_vectors = 0;
   for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
     if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
@@ -292,6 +293,103 @@ inline void emm_ctx_clear_auth_vector(emm_context_t * const ctxt, ksi_t eksi)
   }
 }
 //------------------------------------------------------------------------------
+/* Returns true if the vector slot is referenced by a security context or by the running authentication procedure */
+static bool _emm_ctx_auth_vector_in_use(const emm_context_t * const ctxt, const int vector_index)
+{
+  if ((ctxt->_security.vector_index == vector_index) || (ctxt->_non_current_security.vector_index == vector_index)) {
+    return true;
+  }
+  nas_emm_auth_proc_t * auth_proc = get_nas_common_procedure_authentication(ctxt);
+  if ((auth_proc) && (auth_proc->vector_index == vector_index)) {
+    return true;
+  }
+  return false;
+}
+//------------------------------------------------------------------------------
+/* Store a vector received from the HSS in a free slot, returns the slot index or -1 if there is no free slot */
+int emm_ctx_store_auth_vector(emm_context_t * const ctxt, const eutran_vector_t * const vector)
+{
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if ((IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) || (_emm_ctx_auth_vector_in_use(ctxt, i))) {
+      continue;
+    }
+    memcpy (ctxt->_vector[i].kasme, vector->kasme, AUTH_KASME_SIZE);
+    memcpy (ctxt->_vector[i].autn,  vector->autn, AUTH_AUTN_SIZE);
+    memcpy (ctxt->_vector[i].rand,  vector->rand, AUTH_RAND_SIZE);
+    memcpy (ctxt->_vector[i].xres,  vector->xres.data, vector->xres.size);
+    ctxt->_vector[i].xres_size = vector->xres.size;
+    ctxt->_vector_seq[i] = ctxt->vectors_received++;
+    emm_ctx_set_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR(i));
+    emm_ctx_set_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+    ctxt->remaining_vectors += 1;
+    OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " stored auth vector %d (%d unused)\n",
+        (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id, i, ctxt->remaining_vectors);
+    return i;
+  }
+  return -1;
+}
+//------------------------------------------------------------------------------
+/* Returns the number of vectors that can be stored without overwriting a valid or referenced one */
+int emm_ctx_free_auth_vectors(const emm_context_t * const ctxt)
+{
+  int free_vectors = 0;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if ((!IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) && (!_emm_ctx_auth_vector_in_use(ctxt, i))) {
+      free_vectors += 1;
+    }
+  }
+  return free_vectors;
+}
+//------------------------------------------------------------------------------
+/* Drop the vectors not used yet. The slots of the security contexts are kept, the keys
+ * of the current context (KeNB derivation) are still derived from them. */
+void emm_ctx_clear_unused_auth_vectors(emm_context_t * const ctxt)
+{
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if ((IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) && (!_emm_ctx_auth_vector_in_use(ctxt, i))) {
+      memset((void *)&ctxt->_vector[i], 0, sizeof(ctxt->_vector[i]));
+      emm_ctx_clear_attribute_present(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR(i));
+    }
+  }
+  ctxt->remaining_vectors = 0;
+  emm_ctx_clear_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+  OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " cleared unused auth vectors\n", (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id);
+}
+//------------------------------------------------------------------------------
+/* Returns the index of the oldest unused vector or -1 if there is none.
+ * Vectors are used in the order they were received so that the UE sees increasing SQNs. */
+int emm_ctx_next_auth_vector(const emm_context_t * const ctxt)
+{
+  int vector_index = -1;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
+      if ((0 > vector_index) || ((int32_t)(ctxt->_vector_seq[i] - ctxt->_vector_seq[vector_index]) < 0)) {
+        vector_index = i;
+      }
+    }
+  }
+  return vector_index;
+}
+//------------------------------------------------------------------------------
+/* Mark a vector as consumed by an authentication procedure, its content is kept for key derivation */
+void emm_ctx_use_auth_vector(emm_context_t * const ctxt, const int vector_index)
+{
+  AssertFatal((0 <= vector_index) && (MAX_EPS_AUTH_VECTORS > vector_index), "Out of bounds vector index %d", vector_index);
+  emm_ctx_clear_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTOR(vector_index));
+  int remaining_vectors = 0;
+  for (int i = 0; i < MAX_EPS_AUTH_VECTORS; i++) {
+    if (IS_EMM_CTXT_VALID_AUTH_VECTOR(ctxt, i)) {
+      remaining_vectors+=1;
+    }
+  }
+  ctxt->remaining_vectors = remaining_vectors;
+  if (!(remaining_vectors)) {
+    emm_ctx_clear_attribute_valid(ctxt, EMM_CTXT_MEMBER_AUTH_VECTORS);
+  }
+  OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=" MME_UE_S1AP_ID_FMT " use auth vector %d (%d unused)\n",
+      (PARENT_STRUCT(ctxt, struct ue_mm_context_s, emm_context))->mme_ue_s1ap_id, vector_index, remaining_vectors);
+}
+//------------------------------------------------------------------------------
 /* Clear security  */
 inline void emm_ctx_clear_security(emm_context_t * const ctxt)
 {
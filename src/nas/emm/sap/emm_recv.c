@@ -652,6 +652,9 @@ emm_recv_service_request (
   
   // Get emm_ctx 
   emm_ctx = emm_context_get (&_emm_data,ue_id);
+  if (emm_ctx) {
+    mme_app_stats_latency_start (&PARENT_STRUCT(emm_ctx, struct ue_mm_context_s, emm_context)->latency_start_usec[MME_APP_STATS_LATENCY_SERVICE_REQUEST]);
+  }
   /*
    * Do following: 
    * 1. Re-establish UE specfic S1 signaling connection and S1-U tunnel for default bearer.
@@ -387,6 +387,7 @@ nas_proc_authentication_info_answer (
     MSC_LOG_EVENT (MSC_MMEAPP_MME, "0 S6A_AUTH_INFO_ANS Unknown imsi " IMSI_64_FMT, imsi64);
     OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNerror);
   }
+  mme_app_stats_latency_stop (MME_APP_STATS_LATENCY_S6A_AIR_RTT, &ue_mm_context->latency_start_usec[MME_APP_STATS_LATENCY_S6A_AIR_RTT]);
 
   if ((aia->result.present == S6A_RESULT_BASE)
       && (aia->result.choice.base == DIAMETER_SUCCESS)) {
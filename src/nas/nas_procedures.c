@@ -67,6 +67,13 @@
 #include "digest.h"
 #include "nas_procedures.h"
 
+#if (S6A_AUTH_INFO_RSP_TIMER_MS != (TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE * 1000))
+#  error "S6A_AUTH_INFO_RSP_TIMER_MS does not match TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE"
+#endif
+#if ((S6A_REQUEST_TIMEOUT_MS + 2 * S6A_PIPELINE_TICK_MSEC) >= (TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE * 1000))
+#  error "The S6a request timeout may expire after TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE"
+#endif
+
 static  nas_emm_common_proc_t *get_nas_common_procedure(const struct emm_context_s * const ctxt, emm_common_proc_type_t proc_type);
 static  nas_cn_proc_t *get_nas_cn_procedure(const struct emm_context_s * const ctxt, cn_proc_type_t proc_type);
 
@@ -323,6 +330,10 @@ void nas_delete_common_procedure(struct emm_context_s *emm_context, nas_emm_comm
           if (auth_info_proc->unchecked_imsi) {
             free_wrapper((void**)&auth_info_proc->unchecked_imsi);
           }
+          // a pending S6a request outlives the procedure, its answer refills the vectors of the context
+          if (auth_info_proc->emm_com_proc.emm_proc.base_proc.child) {
+            auth_info_proc->emm_com_proc.emm_proc.base_proc.child->parent = NULL;
+          }
         }
         break;
       case EMM_COMM_PROC_SMC: {
@@ -491,6 +502,9 @@ static void nas_delete_auth_info_procedure(struct emm_context_s *emm_context, na
     }
     void *unused = NULL;
     nas_stop_Ts6a_auth_info(PARENT_STRUCT(emm_context, struct ue_mm_context_s, emm_context)->mme_ue_s1ap_id, &(*auth_info_proc)->timer_s6a, unused);
+    if ((*auth_info_proc)->resync_param) {
+      bdestroy_wrapper(&(*auth_info_proc)->resync_param);
+    }
     free_wrapper((void**)auth_info_proc);
   }
 }
@@ -696,6 +710,7 @@ nas_emm_auth_proc_t *nas_new_authentication_procedure(struct emm_context_s * con
 
   auth_proc->T3460.sec       = mme_config.nas_config.t3460_sec;
   auth_proc->T3460.id        = NAS_TIMER_INACTIVE_ID;
+  auth_proc->vector_index    = EMM_SECURITY_VECTOR_INDEX_INVALID;
 
   nas_emm_common_procedure_t * wrapper = calloc(1, sizeof(*wrapper));
   if (wrapper) {
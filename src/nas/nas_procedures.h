@@ -188,6 +188,7 @@ typedef struct nas_emm_auth_proc_s {
   mme_ue_s1ap_id_t            ue_id;
   bool                        is_cause_is_attach; //  could also be done by seeking parent procedure
   ksi_t                       ksi;
+  int                         vector_index; /* Vector of emm_context used by this procedure, EMM_SECURITY_VECTOR_INDEX_INVALID if none yet */
   uint8_t                     rand[AUTH_RAND_SIZE]; /* Random challenge number  */
   uint8_t                     autn[AUTH_AUTN_SIZE]; /* Authentication token     */
   imsi_t                     *unchecked_imsi;
@@ -313,6 +314,7 @@ typedef struct nas_auth_info_proc_s {
   struct nas_timer_s          timer_s6a;
   mme_ue_s1ap_id_t            ue_id;
   bool                        resync; // Indicates whether the authentication information is requested due to sync failure
+  bstring                     resync_param; // RAND || AUTS of a sync failure received while a request was already in flight, sent on completion
 } nas_auth_info_proc_t;
 
 ////////////////////////////////////////////////////////////////////////////////
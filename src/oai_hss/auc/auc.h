@@ -45,7 +45,7 @@ typedef mpz_t sqn_t;
 
 typedef uint8_t uint8_t;
 
-typedef struct {
+typedef struct auc_vector_s {
   uint8_t rand[16];
   uint8_t rand_new;
   uint8_t xres[8];
@@ -53,8 +53,22 @@ typedef struct {
   uint8_t kasme[32];
 } auc_vector_t;
 
-void RijndaelKeySchedule(const uint8_t const key[16]);
-void RijndaelEncrypt(const uint8_t const in[16], uint8_t out[16]);
+/* Expanded AES-128 key, owned by the caller so that concurrent requests do not share it */
+typedef struct rijndael_ctx_s {
+  /* Round keys as a byte string (AES-NI) */
+  uint8_t  rk_bytes[176] __attribute__ ((aligned (16)));
+  /* Round keys as big endian words (T-tables) */
+  uint32_t rk[44];
+} rijndael_ctx_t;
+
+/* Milenage key K expanded once, with OPc, for all the vectors of a subscriber */
+typedef struct milenage_ctx_s {
+  rijndael_ctx_t aes;
+  uint8_t        opc[16];
+} milenage_ctx_t;
+
+void RijndaelKeySchedule(rijndael_ctx_t *ctx, const uint8_t const key[16]);
+void RijndaelEncrypt(const rijndael_ctx_t *ctx, const uint8_t const in[16], uint8_t out[16]);
 
 /* Sequence number functions */
 struct sqn_ue_s;
@@ -74,6 +88,18 @@ void generate_random(uint8_t *random, ssize_t length);
 
 void ComputeOPc( const uint8_t const kP[16], const uint8_t const opP[16], uint8_t opcP[16] );
 
+void milenage_init(milenage_ctx_t *ctx, const uint8_t const opc[16], const uint8_t const k[16]);
+void milenage_f1(const milenage_ctx_t *ctx, const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
+                 uint8_t mac_a[8]);
+void milenage_f1star(const milenage_ctx_t *ctx, const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
+                     uint8_t mac_s[8]);
+void milenage_f2345(const milenage_ctx_t *ctx, const uint8_t const rand[16],
+                    uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6]);
+void milenage_f5star(const milenage_ctx_t *ctx, const uint8_t const rand[16], uint8_t ak[6]);
+/* f1 and f2345 of a vector, E_K(RAND ^ OPc) computed once */
+void milenage_f1_f2345(const milenage_ctx_t *ctx, const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
+                       uint8_t mac_a[8], uint8_t res[8], uint8_t ck[16], uint8_t ik[16], uint8_t ak[6]);
+
 void f1 ( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
           uint8_t mac_a[8] );
 void f1star( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t const rand[16], const uint8_t const sqn[6], const uint8_t const amf[2],
@@ -84,8 +110,11 @@ void f5star( const uint8_t const kP[16],const uint8_t const k[16], const uint8_t
              uint8_t ak[6] );
 
 void generate_autn(const uint8_t const sqn[6], const uint8_t const ak[6], const uint8_t const amf[2], const uint8_t const mac_a[8], uint8_t autn[16]);
-int generate_vector(const uint8_t const opc[16], uint64_t imsi, uint8_t key[16], uint8_t plmn[3],
+int generate_vector(const milenage_ctx_t *ctx, uint64_t imsi, uint8_t plmn[3],
                     uint8_t sqn[6], auc_vector_t *vector);
+/* nb_vectors vectors with the SQNs sqn_base, sqn_base + 1, ... */
+int generate_vectors(const milenage_ctx_t *ctx, uint64_t imsi, uint8_t plmn[3],
+                     const uint8_t sqn_base[6], int nb_vectors, auc_vector_t *vectors);
 
 void kdf(uint8_t *key, uint16_t key_len, uint8_t *s, uint16_t s_len, uint8_t *out,
          uint16_t out_len);
@@ -93,7 +122,7 @@ void kdf(uint8_t *key, uint16_t key_len, uint8_t *s, uint16_t s_len, uint8_t *ou
 void derive_kasme(uint8_t ck[16], uint8_t ik[16], uint8_t plmn[3], uint8_t sqn[6],
                   uint8_t ak[6], uint8_t kasme[32]);
 
-uint8_t *sqn_ms_derive(const uint8_t const opc[16], uint8_t *key, uint8_t *auts, uint8_t *rand);
+uint8_t *sqn_ms_derive(const milenage_ctx_t *ctx, uint8_t *auts, uint8_t *rand);
 
 static inline void print_buffer(const char *prefix, uint8_t *buffer, int length)
 {
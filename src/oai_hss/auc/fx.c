@@ -25,10 +25,12 @@
 
    A sample implementation of the example 3GPP authentication and
    key agreement functions f1, f1*, f2, f3, f4, f5 and f5*. This is
-   a byte-oriented implementation of the functions, and of the block
-   cipher kernel function Rijndael.
+   a byte-oriented implementation of the functions. The block cipher
+   kernel function Rijndael (rijndael.c) uses AES-NI or T-tables.
 
-   This has been coded for clarity, not necessarily for efficiency.
+   The key schedule of K is kept in a milenage_ctx_t of the caller,
+   computed once for all the vectors of a request, so that the
+   functions can run concurrently on the S6a threads.
 
    The functions f2, f3, f4 and f5 share the same inputs and have
    been coded together as a single function. f1, f1* and f5* are
@@ -76,35 +78,48 @@ generate_autn (
 }
 
 /*-------------------------------------------------------------------
-   Algorithm f1
-  -------------------------------------------------------------------
-
-   Computes network authentication code MAC-A from key K, random
-   challenge RAND, sequence number SQN and authentication management
-   field AMF.
-
+   Milenage context: the key schedule of K is computed once and
+   used by all the functions of the subscriber vectors, on the
+   stack of the calling thread.
   -----------------------------------------------------------------*/
 void
-f1 (
+milenage_init (
+  milenage_ctx_t * ctx,
   const uint8_t const opc[16],
-  const uint8_t const k[16],
+  const uint8_t const k[16])
+{
+  RijndaelKeySchedule (&ctx->aes, k);
+  memcpy (ctx->opc, opc, 16);
+}
+
+/* TEMP = E[RAND XOR OPc]K */
+static void
+milenage_temp (
+  const milenage_ctx_t * ctx,
   const uint8_t const _rand[16],
-  const uint8_t const sqn[6],
-  const uint8_t const amf[2],
-  uint8_t mac_a[8])
+  uint8_t temp[16])
 {
-  uint8_t                                 temp[16];
-  uint8_t                                 in1[16];
-  uint8_t                                 out1[16];
   uint8_t                                 rijndaelInput[16];
   uint8_t                                 i;
 
-  RijndaelKeySchedule (k);
-
   for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
+    rijndaelInput[i] = _rand[i] ^ ctx->opc[i];
 
-  RijndaelEncrypt (rijndaelInput, temp);
+  RijndaelEncrypt (&ctx->aes, rijndaelInput, temp);
+}
+
+/* OUT1, MAC-A is its first half and MAC-S its second half */
+static void
+milenage_out1 (
+  const milenage_ctx_t * ctx,
+  const uint8_t const temp[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t out1[16])
+{
+  uint8_t                                 in1[16];
+  uint8_t                                 rijndaelInput[16];
+  uint8_t                                 i;
 
   for (i = 0; i < 6; i++) {
     in1[i] = sqn[i];
@@ -121,7 +136,7 @@ f1 (
    * * * * on the constant c1 (which is all zeroes)
    */
   for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 8) % 16] = in1[i] ^ opc[i];
+    rijndaelInput[(i + 8) % 16] = in1[i] ^ ctx->opc[i];
 
   /*
    * XOR on the value temp computed before
@@ -129,172 +144,160 @@ f1 (
   for (i = 0; i < 16; i++)
     rijndaelInput[i] ^= temp[i];
 
-  RijndaelEncrypt (rijndaelInput, out1);
+  RijndaelEncrypt (&ctx->aes, rijndaelInput, out1);
 
   for (i = 0; i < 16; i++)
-    out1[i] ^= opc[i];
+    out1[i] ^= ctx->opc[i];
+}
 
-  for (i = 0; i < 8; i++)
-    mac_a[i] = out1[i];
+/*
+ * OUT2 to OUT5: XOR OPc and TEMP, rotate by rotation bytes, XOR the
+ * last byte on the constant c, encrypt and XOR OPc
+ */
+static void
+milenage_out (
+  const milenage_ctx_t * ctx,
+  const uint8_t const temp[16],
+  uint8_t rotation,
+  uint8_t c,
+  uint8_t out[16])
+{
+  uint8_t                                 rijndaelInput[16];
+  uint8_t                                 i;
 
-  return;
-}                               /* end of function f1 */
+  for (i = 0; i < 16; i++)
+    rijndaelInput[(i + 16 - rotation) % 16] = temp[i] ^ ctx->opc[i];
 
-/*-------------------------------------------------------------------
-   Algorithms f2-f5
-  -------------------------------------------------------------------
+  rijndaelInput[15] ^= c;
+  RijndaelEncrypt (&ctx->aes, rijndaelInput, out);
 
-   Takes key K and random challenge RAND, and returns response RES,
-   confidentiality key CK, integrity key IK and anonymity key AK.
+  for (i = 0; i < 16; i++)
+    out[i] ^= ctx->opc[i];
+}
 
-  -----------------------------------------------------------------*/
-void
-f2345 (
-  const uint8_t const opc[16],
-  const uint8_t const k[16],
-  const uint8_t const _rand[16],
+static void
+milenage_f2345_temp (
+  const milenage_ctx_t * ctx,
+  const uint8_t const temp[16],
   uint8_t res[8],
   uint8_t ck[16],
   uint8_t ik[16],
   uint8_t ak[6])
 {
-  uint8_t                                 temp[16];
   uint8_t                                 out[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
-
-  RijndaelKeySchedule (k);
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
-
-  RijndaelEncrypt (rijndaelInput, temp);
 
   /*
-   * To obtain output block OUT2: XOR OPc and TEMP,
-   * * * * rotate by r2=0, and XOR on the constant c2 (which *
-   * * * * is all zeroes except that the last bit is 1).
+   * OUT2: r2=0, c2 is all zeroes except that the last bit is 1
    */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 1;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 8; i++)
-    res[i] = out[i + 8];
-
-  for (i = 0; i < 6; i++)
-    ak[i] = out[i];
-
+  milenage_out (ctx, temp, 0, 1, out);
+  memcpy (res, &out[8], 8);
+  memcpy (ak, out, 6);
   /*
-   * To obtain output block OUT3: XOR OPc and TEMP,
-   * * * * rotate by r3=32, and XOR on the constant c3 (which *
-   * * * * is all zeroes except that the next to last bit is 1).
+   * OUT3: r3=32, c3 is all zeroes except that the next to last bit is 1
    */
-
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 12) % 16] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 2;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 16; i++)
-    ck[i] = out[i];
-
+  milenage_out (ctx, temp, 4, 2, ck);
   /*
-   * To obtain output block OUT4: XOR OPc and TEMP,
-   * * * * rotate by r4=64, and XOR on the constant c4 (which *
-   * * * * is all zeroes except that the 2nd from last bit is 1).
+   * OUT4: r4=64, c4 is all zeroes except that the 2nd from last bit is 1
    */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 8) % 16] = temp[i] ^ opc[i];
-
-  rijndaelInput[15] ^= 4;
-  RijndaelEncrypt (rijndaelInput, out);
-
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
-
-  for (i = 0; i < 16; i++)
-    ik[i] = out[i];
-
-  return;
-}                               /* end of function f2345 */
+  milenage_out (ctx, temp, 8, 4, ik);
+}
 
 /*-------------------------------------------------------------------
    Algorithm f1
   -------------------------------------------------------------------
 
-   Computes resynch authentication code MAC-S from key K, random
+   Computes network authentication code MAC-A from key K, random
    challenge RAND, sequence number SQN and authentication management
    field AMF.
 
   -----------------------------------------------------------------*/
 void
-f1star (
-  const uint8_t const opc[16],
-  const uint8_t const k[16],
+milenage_f1 (
+  const milenage_ctx_t * ctx,
   const uint8_t const _rand[16],
   const uint8_t const sqn[6],
   const uint8_t const amf[2],
-  uint8_t mac_s[8])
+  uint8_t mac_a[8])
 {
   uint8_t                                 temp[16];
-  uint8_t                                 in1[16];
   uint8_t                                 out1[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
 
-  RijndaelKeySchedule (k);
+  milenage_temp (ctx, _rand, temp);
+  milenage_out1 (ctx, temp, sqn, amf, out1);
+  memcpy (mac_a, out1, 8);
+}                               /* end of function milenage_f1 */
 
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
+/*-------------------------------------------------------------------
+   Algorithms f2-f5
+  -------------------------------------------------------------------
 
-  RijndaelEncrypt (rijndaelInput, temp);
+   Takes key K and random challenge RAND, and returns response RES,
+   confidentiality key CK, integrity key IK and anonymity key AK.
 
-  for (i = 0; i < 6; i++) {
-    in1[i] = sqn[i];
-    in1[i + 8] = sqn[i];
-  }
+  -----------------------------------------------------------------*/
+void
+milenage_f2345 (
+  const milenage_ctx_t * ctx,
+  const uint8_t const _rand[16],
+  uint8_t res[8],
+  uint8_t ck[16],
+  uint8_t ik[16],
+  uint8_t ak[6])
+{
+  uint8_t                                 temp[16];
 
-  for (i = 0; i < 2; i++) {
-    in1[i + 6] = amf[i];
-    in1[i + 14] = amf[i];
-  }
+  milenage_temp (ctx, _rand, temp);
+  milenage_f2345_temp (ctx, temp, res, ck, ik, ak);
+}                               /* end of function milenage_f2345 */
 
-  /*
-   * XOR op_c and in1, rotate by r1=64, and XOR
-   * * * * on the constant c1 (which is all zeroes)
-   */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 8) % 16] = in1[i] ^ opc[i];
+void
+milenage_f1_f2345 (
+  const milenage_ctx_t * ctx,
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_a[8],
+  uint8_t res[8],
+  uint8_t ck[16],
+  uint8_t ik[16],
+  uint8_t ak[6])
+{
+  uint8_t                                 temp[16];
+  uint8_t                                 out1[16];
 
-  /*
-   * XOR on the value temp computed before
-   */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] ^= temp[i];
+  milenage_temp (ctx, _rand, temp);
+  milenage_out1 (ctx, temp, sqn, amf, out1);
+  memcpy (mac_a, out1, 8);
+  milenage_f2345_temp (ctx, temp, res, ck, ik, ak);
+}
 
-  RijndaelEncrypt (rijndaelInput, out1);
+/*-------------------------------------------------------------------
+   Algorithm f1*
+  -------------------------------------------------------------------
 
-  for (i = 0; i < 16; i++)
-    out1[i] ^= opc[i];
+   Computes resynch authentication code MAC-S from key K, random
+   challenge RAND, sequence number SQN and authentication management
+   field AMF.
 
-  for (i = 0; i < 8; i++)
-    mac_s[i] = out1[i + 8];
+  -----------------------------------------------------------------*/
+void
+milenage_f1star (
+  const milenage_ctx_t * ctx,
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_s[8])
+{
+  uint8_t                                 temp[16];
+  uint8_t                                 out1[16];
 
-  return;
-}                               /* end of function f1star */
+  milenage_temp (ctx, _rand, temp);
+  milenage_out1 (ctx, temp, sqn, amf, out1);
+  memcpy (mac_s, &out1[8], 8);
+}                               /* end of function milenage_f1star */
 
 /*-------------------------------------------------------------------
-   Algorithm f5
+   Algorithm f5*
   -------------------------------------------------------------------
 
    Takes key K and random challenge RAND, and returns resynch
@@ -302,43 +305,83 @@ f1star (
 
   -----------------------------------------------------------------*/
 void
-f5star (
-  const uint8_t const opc[16],
-  const uint8_t const k[16],
+milenage_f5star (
+  const milenage_ctx_t * ctx,
   const uint8_t const _rand[16],
   uint8_t ak[6])
 {
   uint8_t                                 temp[16];
   uint8_t                                 out[16];
-  uint8_t                                 rijndaelInput[16];
-  uint8_t                                 i;
 
-  RijndaelKeySchedule (k);
+  milenage_temp (ctx, _rand, temp);
+  /*
+   * OUT5: r5=96, c5 is all zeroes except that the 3rd from last bit is 1
+   */
+  milenage_out (ctx, temp, 12, 8, out);
+  memcpy (ak, out, 6);
+}                               /* end of function milenage_f5star */
 
-  for (i = 0; i < 16; i++)
-    rijndaelInput[i] = _rand[i] ^ opc[i];
+/*
+ * Functions of a single computation, the key is expanded on each call
+ */
+void
+f1 (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_a[8])
+{
+  milenage_ctx_t                          ctx;
 
-  RijndaelEncrypt (rijndaelInput, temp);
+  milenage_init (&ctx, opc, k);
+  milenage_f1 (&ctx, _rand, sqn, amf, mac_a);
+}
 
-  /*
-   * To obtain output block OUT5: XOR OPc and TEMP,
-   * * * * rotate by r5=96, and XOR on the constant c5 (which *
-   * * * * is all zeroes except that the 3rd from last bit is 1).
-   */
-  for (i = 0; i < 16; i++)
-    rijndaelInput[(i + 4) % 16] = temp[i] ^ opc[i];
+void
+f2345 (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  uint8_t res[8],
+  uint8_t ck[16],
+  uint8_t ik[16],
+  uint8_t ak[6])
+{
+  milenage_ctx_t                          ctx;
 
-  rijndaelInput[15] ^= 8;
-  RijndaelEncrypt (rijndaelInput, out);
+  milenage_init (&ctx, opc, k);
+  milenage_f2345 (&ctx, _rand, res, ck, ik, ak);
+}
 
-  for (i = 0; i < 16; i++)
-    out[i] ^= opc[i];
+void
+f1star (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  const uint8_t const sqn[6],
+  const uint8_t const amf[2],
+  uint8_t mac_s[8])
+{
+  milenage_ctx_t                          ctx;
 
-  for (i = 0; i < 6; i++)
-    ak[i] = out[i];
+  milenage_init (&ctx, opc, k);
+  milenage_f1star (&ctx, _rand, sqn, amf, mac_s);
+}
 
-  return;
-}                               /* end of function f5star */
+void
+f5star (
+  const uint8_t const opc[16],
+  const uint8_t const k[16],
+  const uint8_t const _rand[16],
+  uint8_t ak[6])
+{
+  milenage_ctx_t                          ctx;
+
+  milenage_init (&ctx, opc, k);
+  milenage_f5star (&ctx, _rand, ak);
+}
 
 /*-------------------------------------------------------------------
    Function to compute OPc from OP and K.
@@ -349,11 +392,12 @@ ComputeOPc (
   const uint8_t const opP[16],
   uint8_t opcP[16])
 {
+  rijndael_ctx_t                          ctx;
   uint8_t                                 i;
 
-  RijndaelKeySchedule (kP);
+  RijndaelKeySchedule (&ctx, kP);
   FPRINTF_DEBUG ("Compute opc:\n\tK:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n", kP[0], kP[1], kP[2], kP[3], kP[4], kP[5], kP[6], kP[7], kP[8], kP[9], kP[10], kP[11], kP[12], kP[13], kP[14], kP[15]);
-  RijndaelEncrypt (opP, opcP);
+  RijndaelEncrypt (&ctx, opP, opcP);
   FPRINTF_DEBUG ("\tIn:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n\tRinj:\t%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n",
           opP[0], opP[1], opP[2], opP[3], opP[4], opP[5], opP[6], opP[7],
           opP[8], opP[9], opP[10], opP[11], opP[12], opP[13], opP[14], opP[15], opcP[0], opcP[1], opcP[2], opcP[3], opcP[4], opcP[5], opcP[6], opcP[7], opcP[8], opcP[9], opcP[10], opcP[11], opcP[12], opcP[13], opcP[14], opcP[15]);
@@ -139,9 +139,8 @@ derive_kasme (
 
 int
 generate_vector (
-  const uint8_t const opc[16],
+  const milenage_ctx_t * ctx,
   uint64_t imsi,
-  uint8_t key[16],
   uint8_t plmn[3],
   uint8_t sqn[6],
   auc_vector_t * vector)
@@ -164,16 +163,12 @@ generate_vector (
   }
 
   /*
-   * Compute MAC
+   * Compute MAC, XRES, CK, IK, AK
    */
-  f1 (opc, key, vector->rand, sqn, amf, mac_a);
+  milenage_f1_f2345 (ctx, vector->rand, sqn, amf, mac_a, vector->xres, ck, ik, ak);
   print_buffer ("MAC_A   : ", mac_a, 8);
   print_buffer ("SQN     : ", sqn, 6);
   print_buffer ("RAND    : ", vector->rand, 16);
-  /*
-   * Compute XRES, CK, IK, AK
-   */
-  f2345 (opc, key, vector->rand, vector->xres, ck, ik, ak);
   print_buffer ("AK      : ", ak, 6);
   print_buffer ("CK      : ", ck, 16);
   print_buffer ("IK      : ", ik, 16);
@@ -187,3 +182,47 @@ generate_vector (
   print_buffer ("KASME   : ", vector->kasme, 32);
   return 0;
 }
+
+/*
+ * Vectors of one request. Vector i uses SQN = sqn_base + i: sqn_base + i may carry
+ * from the IND bits into SEQ (33.102 C.3.2), but the SQN of the next request is one
+ * step of 32 above sqn_base, so with fewer than 32 vectors the SQNs stay unique and
+ * increasing over the requests, and the USIM accepts the vectors used in order.
+ * The RANDs are picked by the caller.
+ */
+int
+generate_vectors (
+  const milenage_ctx_t * ctx,
+  uint64_t imsi,
+  uint8_t plmn[3],
+  const uint8_t sqn_base[6],
+  int nb_vectors,
+  auc_vector_t * vectors)
+{
+  uint64_t                                base = 0;
+  uint8_t                                 sqn[6];
+  int                                     rc;
+
+  if ((vectors == NULL) || (nb_vectors < 0)) {
+    return EINVAL;
+  }
+
+  for (int i = 0; i < 6; i++) {
+    base = (base << 8) | sqn_base[i];
+  }
+
+  for (int i = 0; i < nb_vectors; i++) {
+    uint64_t                                value = (base + i) & 0xFFFFFFFFFFFFULL;
+
+    for (int j = 5; j >= 0; j--) {
+      sqn[j] = value & 0xFF;
+      value >>= 8;
+    }
+
+    if ((rc = generate_vector (ctx, imsi, plmn, sqn, &vectors[i])) != 0) {
+      return rc;
+    }
+  }
+
+  return 0;
+}
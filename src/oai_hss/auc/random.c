@@ -19,77 +19,175 @@
  *      contact@openairinterface.org
  */
 
-#include <pthread.h>
+/*
+ * RAND generation. Each thread has its own ChaCha20 keystream, seeded from the
+ * kernel and re-seeded every RANDOM_RESEED_BLOCKS blocks, so that the S6a threads
+ * draw random numbers without sharing a lock.
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include <unistd.h>
-
-#include <gmp.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <sys/time.h>
+#include <sys/syscall.h>
 
 #include "log.h"
 #include "auc.h"
 #include "hss_config.h"
 
+/* Blocks of 64 bytes produced with a seed, 4 MB */
+#define RANDOM_RESEED_BLOCKS (1 << 16)
+
 typedef struct random_state_s {
-  pthread_mutex_t                         lock;
-  gmp_randstate_t                         state;
+  uint32_t                                key[8];
+  uint64_t                                counter;
+  uint32_t                                nb_blocks;
+  /* Unused bytes at the end of block */
+  uint32_t                                available;
+  uint8_t                                 block[64];
 } random_state_t;
 
-random_state_t                          random_state;
+static __thread random_state_t          random_state;
 extern hss_config_t                     hss_config;
 static uint8_t                          no_random_delta = 0;
 
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTERROUND(a, b, c, d)                  \
+  a += b; d ^= a; d = ROTL32 (d, 16);             \
+  c += d; b ^= c; b = ROTL32 (b, 12);             \
+  a += b; d ^= a; d = ROTL32 (d, 8);              \
+  c += d; b ^= c; b = ROTL32 (b, 7)
+
+/* ChaCha20 block of the thread key and counter (RFC 7539, 64 bit counter) */
+static void
+random_chacha20_block (
+  random_state_t * state)
+{
+  uint32_t                                input[16];
+  uint32_t                                x[16];
+  int                                     i;
+
+  input[0] = 0x61707865;
+  input[1] = 0x3320646e;
+  input[2] = 0x79622d32;
+  input[3] = 0x6b206574;
+  memcpy (&input[4], state->key, sizeof (state->key));
+  input[12] = (uint32_t) state->counter;
+  input[13] = (uint32_t) (state->counter >> 32);
+  input[14] = 0;
+  input[15] = 0;
+  memcpy (x, input, sizeof (x));
+
+  for (i = 0; i < 10; i++) {
+    QUARTERROUND (x[0], x[4], x[8], x[12]);
+    QUARTERROUND (x[1], x[5], x[9], x[13]);
+    QUARTERROUND (x[2], x[6], x[10], x[14]);
+    QUARTERROUND (x[3], x[7], x[11], x[15]);
+    QUARTERROUND (x[0], x[5], x[10], x[15]);
+    QUARTERROUND (x[1], x[6], x[11], x[12]);
+    QUARTERROUND (x[2], x[7], x[8], x[13]);
+    QUARTERROUND (x[3], x[4], x[9], x[14]);
+  }
+
+  for (i = 0; i < 16; i++) {
+    uint32_t                                v = x[i] + input[i];
+
+    state->block[4 * i] = v;
+    state->block[4 * i + 1] = v >> 8;
+    state->block[4 * i + 2] = v >> 16;
+    state->block[4 * i + 3] = v >> 24;
+  }
+  state->counter++;
+  state->nb_blocks++;
+  state->available = sizeof (state->block);
+}
+
+static void
+random_seed (
+  random_state_t * state)
+{
+  ssize_t                                 length = -1;
+
+#ifdef SYS_getrandom
+  length = syscall (SYS_getrandom, state->key, sizeof (state->key), 0);
+#endif
+
+  if (length != sizeof (state->key)) {
+    int                                     fd = open ("/dev/urandom", O_RDONLY | O_CLOEXEC);
+
+    length = (fd >= 0) ? read (fd, state->key, sizeof (state->key)) : -1;
+
+    if (fd >= 0) {
+      close (fd);
+    }
+  }
+
+  if (length != sizeof (state->key)) {
+    struct timeval                          t1;
+
+    FPRINTF_ERROR ("Cannot read the kernel random source: %s, RANDs are predictable\n", strerror (errno));
+    gettimeofday (&t1, NULL);
+    state->key[0] ^= t1.tv_usec;
+    state->key[1] ^= t1.tv_sec;
+    state->key[2] ^= getpid ();
+    state->key[3] ^= (uint32_t) (uintptr_t) state;
+  }
+  state->counter = 0;
+  state->nb_blocks = 0;
+  state->available = 0;
+}
+
 void
 random_init (
   void)
 {
-  pthread_mutex_init(&random_state.lock, NULL);
   if (hss_config.random_bool > 0) {
-    mpz_t number;
-    mpz_init(number);
-    gmp_randinit_default(random_state.state);
-    struct timeval     t1;
-    gettimeofday (&t1, NULL);
-    srand (t1.tv_usec * t1.tv_sec);
     FPRINTF_DEBUG ("Initialized random\n");
   } else {
-    srand (1);
     FPRINTF_DEBUG ("Initialized pseudo-random\n");
   }
 }
 
 /* Generate a random number between 0 and 2^length - 1 where length is expressed
-   in bits.
+   in bytes.
 */
 void
 generate_random (
   uint8_t * random_p,
   ssize_t length)
 {
+  random_state_t                         *state = &random_state;
+
   if (hss_config.random_bool > 0) {
-    random_t random_nb;
-    mpz_init_set_ui(random_nb, 0);
-    pthread_mutex_lock(&random_state.lock);
-    mpz_urandomb(random_nb, random_state.state, 8 * length);
-    pthread_mutex_unlock(&random_state.lock);
-    mpz_export(random_p, NULL, 1, length, 0, 0, random_nb);
-    int   r = 0,  mask = 0, shift;
-    for (int i = 0; i < length; i++) {
-      if ((i % sizeof(i)) == 0)
-        r = rand();
-      shift = 8 * (i % sizeof(i));
-      mask = 0xFF << shift;
-      random_p[i] = (r & mask) >> shift;
+    while (length > 0) {
+      uint32_t                                n;
+
+      if (state->available == 0) {
+        if ((state->nb_blocks == 0) || (state->nb_blocks >= RANDOM_RESEED_BLOCKS)) {
+          random_seed (state);
+        }
+        random_chacha20_block (state);
+      }
+      n = (length < state->available) ? length : state->available;
+      memcpy (random_p, &state->block[sizeof (state->block) - state->available], n);
+      /*
+       * Bytes handed out are not kept
+       */
+      memset (&state->block[sizeof (state->block) - state->available], 0, n);
+      state->available -= n;
+      random_p += n;
+      length -= n;
     }
-    FPRINTF_DEBUG ("Generated random\n");
   } else {
-    pthread_mutex_lock(&random_state.lock);
+    uint8_t                                 delta = __sync_fetch_and_add (&no_random_delta, 1);
+
     for (int i = 0; i < length; i++) {
-      random_p[i] = i + no_random_delta;
+      random_p[i] = i + delta;
     }
-    no_random_delta += 1;
-    pthread_mutex_unlock(&random_state.lock);
     FPRINTF_DEBUG ("Generated pseudo-random\n");
   }
 }
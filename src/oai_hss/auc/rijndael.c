@@ -21,19 +21,22 @@
 
 #include <stdlib.h>
 #include <stdint.h>
-#include <gmp.h>
+#include <string.h>
 
 #include "auc.h"
 #include "log.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define RIJNDAEL_AESNI 1
+#  include <cpuid.h>
+#  include <wmmintrin.h>
+#endif
+
 typedef uint8_t                         u8;
 typedef uint32_t                        u32;
 
-/*-------------------- Rijndael round subkeys ---------------------*/
-u8                                      roundKeys[11][4][4];
-
 /*--------------------- Rijndael S box table ----------------------*/
-u8                                      S[256] = {
+static const u8                         S[256] = {
   99, 124, 119, 123, 242, 107, 111, 197, 48, 1, 103, 43, 254, 215, 171, 118,
   202, 130, 201, 125, 250, 89, 71, 240, 173, 212, 162, 175, 156, 164, 114, 192,
   183, 253, 147, 38, 54, 63, 247, 204, 52, 165, 229, 241, 113, 216, 49, 21,
@@ -52,223 +55,205 @@ u8                                      S[256] = {
   140, 161, 137, 13, 191, 230, 66, 104, 65, 153, 45, 15, 176, 84, 187, 22,
 };
 
-/*------- This array does the multiplication by x in GF(2^8) ------*/
-u8                                      Xtime[256] = {
-  0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
-  32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
-  64, 66, 68, 70, 72, 74, 76, 78, 80, 82, 84, 86, 88, 90, 92, 94,
-  96, 98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
-  128, 130, 132, 134, 136, 138, 140, 142, 144, 146, 148, 150, 152, 154, 156, 158,
-  160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180, 182, 184, 186, 188, 190,
-  192, 194, 196, 198, 200, 202, 204, 206, 208, 210, 212, 214, 216, 218, 220, 222,
-  224, 226, 228, 230, 232, 234, 236, 238, 240, 242, 244, 246, 248, 250, 252, 254,
-  27, 25, 31, 29, 19, 17, 23, 21, 11, 9, 15, 13, 3, 1, 7, 5,
-  59, 57, 63, 61, 51, 49, 55, 53, 43, 41, 47, 45, 35, 33, 39, 37,
-  91, 89, 95, 93, 83, 81, 87, 85, 75, 73, 79, 77, 67, 65, 71, 69,
-  123, 121, 127, 125, 115, 113, 119, 117, 107, 105, 111, 109, 99, 97, 103, 101,
-  155, 153, 159, 157, 147, 145, 151, 149, 139, 137, 143, 141, 131, 129, 135, 133,
-  187, 185, 191, 189, 179, 177, 183, 181, 171, 169, 175, 173, 163, 161, 167, 165,
-  219, 217, 223, 221, 211, 209, 215, 213, 203, 201, 207, 205, 195, 193, 199, 197,
-  251, 249, 255, 253, 243, 241, 247, 245, 235, 233, 239, 237, 227, 225, 231, 229
+/*------------------ Rijndael round constants ---------------------*/
+static const u8                         Rcon[10] = {
+  0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
 };
 
+/*-------------------------------------------------------------------
+   Combined SubBytes and MixColumns table: Te0[x] is the column
+   {02}.S[x], S[x], S[x], {03}.S[x]. The tables of the three other
+   rows are rotations of Te0.
+  -----------------------------------------------------------------*/
+static const u32                        Te0[256] = {
+  0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd, 0xde6f6fb1, 0x91c5c554,
+  0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d, 0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a,
+  0x8fcaca45, 0x1f82829d, 0x89c9c940, 0xfa7d7d87, 0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+  0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea, 0x239c9cbf, 0x53a4a4f7, 0xe4727296, 0x9bc0c05b,
+  0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a, 0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f,
+  0x6834345c, 0x51a5a5f4, 0xd1e5e534, 0xf9f1f108, 0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+  0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e, 0x30181828, 0x379696a1, 0x0a05050f, 0x2f9a9ab5,
+  0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d, 0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f,
+  0x1209091b, 0x1d83839e, 0x582c2c74, 0x341a1a2e, 0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+  0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce, 0x5229297b, 0xdde3e33e, 0x5e2f2f71, 0x13848497,
+  0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c, 0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed,
+  0xd46a6abe, 0x8dcbcb46, 0x67bebed9, 0x7239394b, 0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+  0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16, 0x864343c5, 0x9a4d4dd7, 0x66333355, 0x11858594,
+  0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81, 0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3,
+  0xa25151f3, 0x5da3a3fe, 0x804040c0, 0x058f8f8a, 0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+  0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163, 0x20101030, 0xe5ffff1a, 0xfdf3f30e, 0xbfd2d26d,
+  0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f, 0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739,
+  0x93c4c457, 0x55a7a7f2, 0xfc7e7e82, 0x7a3d3d47, 0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+  0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f, 0x44222266, 0x542a2a7e, 0x3b9090ab, 0x0b888883,
+  0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c, 0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76,
+  0xdbe0e03b, 0x64323256, 0x743a3a4e, 0x140a0a1e, 0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+  0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6, 0x399191a8, 0x319595a4, 0xd3e4e437, 0xf279798b,
+  0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7, 0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0,
+  0xd86c6cb4, 0xac5656fa, 0xf3f4f407, 0xcfeaea25, 0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+  0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72, 0x381c1c24, 0x57a6a6f1, 0x73b4b4c7, 0x97c6c651,
+  0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21, 0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85,
+  0xe0707090, 0x7c3e3e42, 0x71b5b5c4, 0xcc6666aa, 0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+  0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0, 0x17868691, 0x99c1c158, 0x3a1d1d27, 0x279e9eb9,
+  0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133, 0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7,
+  0x2d9b9bb6, 0x3c1e1e22, 0x15878792, 0xc9e9e920, 0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+  0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17, 0x65bfbfda, 0xd7e6e631, 0x844242c6, 0xd06868b8,
+  0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11, 0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a,
+};
+
+#define ROR8(x)  (((x) >> 8)  | ((x) << 24))
+#define ROR16(x) (((x) >> 16) | ((x) << 16))
+#define ROR24(x) (((x) >> 24) | ((x) << 8))
+
+#define GETU32(p) (((u32)(p)[0] << 24) | ((u32)(p)[1] << 16) | ((u32)(p)[2] << 8) | ((u32)(p)[3]))
+#define PUTU32(p, v) do { (p)[0] = (u8)((v) >> 24); (p)[1] = (u8)((v) >> 16); (p)[2] = (u8)((v) >> 8); (p)[3] = (u8)(v); } while (0)
+
+static void                             rijndael_encrypt_ttable (
+  const rijndael_ctx_t * ctx,
+  const u8 input[16],
+  u8 output[16]);
+
+/* Block cipher used by RijndaelEncrypt(), AES-NI when the CPU has it */
+static void                             (*rijndael_encrypt) (
+  const rijndael_ctx_t * ctx,
+  const u8 input[16],
+  u8 output[16]) = rijndael_encrypt_ttable;
+
 /*-------------------------------------------------------------------
    Rijndael key schedule function. Takes 16-byte key and creates
-   all Rijndael's internal subkeys ready for encryption.
+   all Rijndael's internal subkeys ready for encryption in ctx.
   -----------------------------------------------------------------*/
 void
 RijndaelKeySchedule (
+  rijndael_ctx_t * ctx,
   const u8 const key[16])
 {
-  u8                                      roundConst;
-  int                                     i,
-                                          j;
+  u32                                    *rk = ctx->rk;
+  int                                     i;
 
-  FPRINTF_DEBUG ("RijndaelKeySchedule: K %02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X%02X\n", key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7], key[8], key[9], key[10], key[11], key[12], key[13], key[14], key[15]);
+  rk[0] = GETU32 (key);
+  rk[1] = GETU32 (key + 4);
+  rk[2] = GETU32 (key + 8);
+  rk[3] = GETU32 (key + 12);
 
-  /*
-   * first round key equals key
-   */
-  for (i = 0; i < 16; i++)
-    roundKeys[0][i & 0x03][i >> 2] = key[i];
+  for (i = 0; i < 10; i++, rk += 4) {
+    u32                                     temp = rk[3];
 
-  roundConst = 1;
+    rk[4] = rk[0] ^ ((u32) S[(temp >> 16) & 0xff] << 24) ^ ((u32) S[(temp >> 8) & 0xff] << 16)
+      ^ ((u32) S[temp & 0xff] << 8) ^ (u32) S[temp >> 24] ^ ((u32) Rcon[i] << 24);
+    rk[5] = rk[1] ^ rk[4];
+    rk[6] = rk[2] ^ rk[5];
+    rk[7] = rk[3] ^ rk[6];
+  }
 
   /*
-   * now calculate round keys
+   * Same round keys as a byte string for AES-NI
    */
-  for (i = 1; i < 11; i++) {
-    roundKeys[i][0][0] = S[roundKeys[i - 1][1][3]]
-      ^ roundKeys[i - 1][0][0] ^ roundConst;
-    roundKeys[i][1][0] = S[roundKeys[i - 1][2][3]]
-      ^ roundKeys[i - 1][1][0];
-    roundKeys[i][2][0] = S[roundKeys[i - 1][3][3]]
-      ^ roundKeys[i - 1][2][0];
-    roundKeys[i][3][0] = S[roundKeys[i - 1][0][3]]
-      ^ roundKeys[i - 1][3][0];
-
-    for (j = 0; j < 4; j++) {
-      roundKeys[i][j][1] = roundKeys[i - 1][j][1] ^ roundKeys[i][j][0];
-      roundKeys[i][j][2] = roundKeys[i - 1][j][2] ^ roundKeys[i][j][1];
-      roundKeys[i][j][3] = roundKeys[i - 1][j][3] ^ roundKeys[i][j][2];
-    }
-
-    /*
-     * update round constant
-     */
-    roundConst = Xtime[roundConst];
+  for (i = 0; i < 44; i++) {
+    PUTU32 (&ctx->rk_bytes[i * 4], ctx->rk[i]);
   }
 
   return;
 }                               /* end of function RijndaelKeySchedule */
 
-/* Round key addition function */
-void
-KeyAdd (
-  u8 state[4][4],
-  u8 roundKeys[11][4][4],
-  int round)
-{
-  int                                     i,
-                                          j;
-
-  for (i = 0; i < 4; i++)
-    for (j = 0; j < 4; j++)
-      state[i][j] ^= roundKeys[round][i][j];
-
-  return;
-}
-
-/* Byte substitution transformation */
-int
-ByteSub (
-  u8 state[4][4])
-{
-  int                                     i,
-                                          j;
-
-  for (i = 0; i < 4; i++)
-    for (j = 0; j < 4; j++)
-      state[i][j] = S[state[i][j]];
-
-  return 0;
-}
-
-/* Row shift transformation */
-void
-ShiftRow (
-  u8 state[4][4])
+static void
+rijndael_encrypt_ttable (
+  const rijndael_ctx_t * ctx,
+  const u8 input[16],
+  u8 output[16])
 {
-  u8                                      temp;
+  const u32                              *rk = ctx->rk;
+  u32                                     s0,
+                                          s1,
+                                          s2,
+                                          s3,
+                                          t0,
+                                          t1,
+                                          t2,
+                                          t3;
+  int                                     r;
 
   /*
-   * left rotate row 1 by 1
+   * add first round_key
    */
-  temp = state[1][0];
-  state[1][0] = state[1][1];
-  state[1][1] = state[1][2];
-  state[1][2] = state[1][3];
-  state[1][3] = temp;
+  s0 = GETU32 (input) ^ rk[0];
+  s1 = GETU32 (input + 4) ^ rk[1];
+  s2 = GETU32 (input + 8) ^ rk[2];
+  s3 = GETU32 (input + 12) ^ rk[3];
+
   /*
-   * left rotate row 2 by 2
+   * 9 full rounds: SubBytes, ShiftRows and MixColumns are table lookups
    */
-  temp = state[2][0];
-  state[2][0] = state[2][2];
-  state[2][2] = temp;
-  temp = state[2][1];
-  state[2][1] = state[2][3];
-  state[2][3] = temp;
+  for (r = 1; r <= 9; r++) {
+    rk += 4;
+    t0 = Te0[s0 >> 24] ^ ROR8 (Te0[(s1 >> 16) & 0xff]) ^ ROR16 (Te0[(s2 >> 8) & 0xff]) ^ ROR24 (Te0[s3 & 0xff]) ^ rk[0];
+    t1 = Te0[s1 >> 24] ^ ROR8 (Te0[(s2 >> 16) & 0xff]) ^ ROR16 (Te0[(s3 >> 8) & 0xff]) ^ ROR24 (Te0[s0 & 0xff]) ^ rk[1];
+    t2 = Te0[s2 >> 24] ^ ROR8 (Te0[(s3 >> 16) & 0xff]) ^ ROR16 (Te0[(s0 >> 8) & 0xff]) ^ ROR24 (Te0[s1 & 0xff]) ^ rk[2];
+    t3 = Te0[s3 >> 24] ^ ROR8 (Te0[(s0 >> 16) & 0xff]) ^ ROR16 (Te0[(s1 >> 8) & 0xff]) ^ ROR24 (Te0[s2 & 0xff]) ^ rk[3];
+    s0 = t0;
+    s1 = t1;
+    s2 = t2;
+    s3 = t3;
+  }
+
   /*
-   * left rotate row 3 by 3
+   * final round, no MixColumns
    */
-  temp = state[3][0];
-  state[3][0] = state[3][3];
-  state[3][3] = state[3][2];
-  state[3][2] = state[3][1];
-  state[3][1] = temp;
-  return;
+  rk += 4;
+  t0 = ((u32) S[s0 >> 24] << 24) ^ ((u32) S[(s1 >> 16) & 0xff] << 16) ^ ((u32) S[(s2 >> 8) & 0xff] << 8) ^ S[s3 & 0xff] ^ rk[0];
+  t1 = ((u32) S[s1 >> 24] << 24) ^ ((u32) S[(s2 >> 16) & 0xff] << 16) ^ ((u32) S[(s3 >> 8) & 0xff] << 8) ^ S[s0 & 0xff] ^ rk[1];
+  t2 = ((u32) S[s2 >> 24] << 24) ^ ((u32) S[(s3 >> 16) & 0xff] << 16) ^ ((u32) S[(s0 >> 8) & 0xff] << 8) ^ S[s1 & 0xff] ^ rk[2];
+  t3 = ((u32) S[s3 >> 24] << 24) ^ ((u32) S[(s0 >> 16) & 0xff] << 16) ^ ((u32) S[(s1 >> 8) & 0xff] << 8) ^ S[s2 & 0xff] ^ rk[3];
+  PUTU32 (output, t0);
+  PUTU32 (output + 4, t1);
+  PUTU32 (output + 8, t2);
+  PUTU32 (output + 12, t3);
 }
 
-/* MixColumn transformation*/
-void
-MixColumn (
-  u8 state[4][4])
+#ifdef RIJNDAEL_AESNI
+__attribute__ ((target ("aes,sse2")))
+static void
+rijndael_encrypt_aesni (
+  const rijndael_ctx_t * ctx,
+  const u8 input[16],
+  u8 output[16])
 {
-  u8                                      temp,
-                                          tmp,
-                                          tmp0;
-  int                                     i;
+  const __m128i                          *rk = (const __m128i *)ctx->rk_bytes;
+  __m128i                                 state = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)input), _mm_load_si128 (&rk[0]));
+  int                                     r;
 
-  /*
-   * do one column at a time
-   */
-  for (i = 0; i < 4; i++) {
-    temp = state[0][i] ^ state[1][i] ^ state[2][i] ^ state[3][i];
-    tmp0 = state[0][i];
-    /*
-     * Xtime array does multiply by x in GF2^8
-     */
-    tmp = Xtime[state[0][i] ^ state[1][i]];
-    state[0][i] ^= temp ^ tmp;
-    tmp = Xtime[state[1][i] ^ state[2][i]];
-    state[1][i] ^= temp ^ tmp;
-    tmp = Xtime[state[2][i] ^ state[3][i]];
-    state[2][i] ^= temp ^ tmp;
-    tmp = Xtime[state[3][i] ^ tmp0];
-    state[3][i] ^= temp ^ tmp;
+  for (r = 1; r <= 9; r++) {
+    state = _mm_aesenc_si128 (state, _mm_load_si128 (&rk[r]));
   }
 
-  return;
+  _mm_storeu_si128 ((__m128i *) output, _mm_aesenclast_si128 (state, _mm_load_si128 (&rk[10])));
 }
 
+__attribute__ ((constructor))
+static void
+rijndael_select (
+  void)
+{
+  unsigned int                            eax,
+                                          ebx,
+                                          ecx,
+                                          edx;
+
+  if (__get_cpuid (1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES)) {
+    rijndael_encrypt = rijndael_encrypt_aesni;
+  }
+}
+#endif
+
 /*-------------------------------------------------------------------
    Rijndael encryption function. Takes 16-byte input and creates
    16-byte output (using round keys already derived from 16-byte
-   key).
+   key in ctx).
   -----------------------------------------------------------------*/
 void
 RijndaelEncrypt (
+  const rijndael_ctx_t * ctx,
   const u8 const input[16],
   u8 output[16])
 {
-  u8                                      state[4][4];
-  int                                     i,
-                                          r;
-
-  /*
-   * initialise state array from input byte string
-   */
-  for (i = 0; i < 16; i++)
-    state[i & 0x3][i >> 2] = input[i];
-
-  /*
-   * add first round_key
-   */
-  KeyAdd (state, roundKeys, 0);
-
-  /*
-   * do lots of full rounds
-   */
-  for (r = 1; r <= 9; r++) {
-    ByteSub (state);
-    ShiftRow (state);
-    MixColumn (state);
-    KeyAdd (state, roundKeys, r);
-  }
-
-  /*
-   * final round
-   */
-  ByteSub (state);
-  ShiftRow (state);
-  KeyAdd (state, roundKeys, r);
-
-  /*
-   * produce output byte string from state array
-   */
-  for (i = 0; i < 16; i++) {
-    output[i] = state[i & 0x3][i >> 2];
-  }
-
-  return;
+  rijndael_encrypt (ctx, input, output);
 }                               /* end of function RijndaelEncrypt */
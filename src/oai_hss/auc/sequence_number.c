@@ -33,8 +33,7 @@ extern uint8_t                          op[16];
 
 uint8_t                                *
 sqn_ms_derive (
-  const uint8_t const opc[16],
-  uint8_t * key,
+  const milenage_ctx_t * ctx,
   uint8_t * auts,
   uint8_t * rand_p)
 {
@@ -62,19 +61,18 @@ sqn_ms_derive (
   /*
    * Derive AK from key and rand
    */
-  f5star (opc, key, rand_p, ak);
+  milenage_f5star (ctx, rand_p, ak);
 
   for (i = 0; i < 6; i++) {
     sqn_ms[i] = ak[i] ^ conc_sqn_ms[i];
   }
 
-  print_buffer ("sqn_ms_derive() KEY    : ", key, 16);
   print_buffer ("sqn_ms_derive() RAND   : ", rand_p, 16);
   print_buffer ("sqn_ms_derive() AUTS   : ", auts, 14);
   print_buffer ("sqn_ms_derive() AK     : ", ak, 6);
   print_buffer ("sqn_ms_derive() SQN_MS : ", sqn_ms, 6);
   print_buffer ("sqn_ms_derive() MAC_S  : ", mac_s, 8);
-  f1star (opc, key, rand_p, sqn_ms, amf, mac_s_computed);
+  milenage_f1star (ctx, rand_p, sqn_ms, amf, mac_s_computed);
   print_buffer ("MAC_S +: ", mac_s_computed, 8);
 
   if (memcmp (mac_s_computed, mac_s, 8) != 0) {
@@ -0,0 +1,157 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+
+/*
+ * Storage backend of the HSS, chosen at connection time by DB_backend:
+ * "mysql" (default) or "local" (db_local.c).
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+
+static const hss_db_ops_t              *hss_db_ops = &hss_db_mysql_ops;
+
+int
+hss_db_connect (
+  const hss_config_t * hss_config_p)
+{
+  if ((hss_config_p->db_backend == NULL) || (strcasecmp (hss_config_p->db_backend, hss_db_mysql_ops.name) == 0)) {
+    hss_db_ops = &hss_db_mysql_ops;
+  } else if (strcasecmp (hss_config_p->db_backend, hss_db_local_ops.name) == 0) {
+    hss_db_ops = &hss_db_local_ops;
+  } else {
+    FPRINTF_ERROR ("Unknown database backend %s (allowed values {mysql,local})\n", hss_config_p->db_backend);
+    return EINVAL;
+  }
+  FPRINTF_DEBUG ("Database backend: %s\n", hss_db_ops->name);
+  return hss_db_ops->connect (hss_config_p);
+}
+
+void
+hss_db_disconnect (
+  void)
+{
+  hss_db_ops->disconnect ();
+}
+
+int
+hss_db_get_user (
+  const char *imsi)
+{
+  return hss_db_ops->get_user (imsi);
+}
+
+int
+hss_db_list_users (
+  void (*callback) (const char *imsi, void *arg),
+  void *arg)
+{
+  return hss_db_ops->list_users (callback, arg);
+}
+
+int
+hss_db_update_loc (
+  const char *imsi,
+  mysql_ul_ans_t * mysql_ul_ans)
+{
+  return hss_db_ops->update_loc (imsi, mysql_ul_ans);
+}
+
+int
+hss_db_push_up_loc (
+  mysql_ul_push_t * ul_push_p)
+{
+  return hss_db_ops->push_up_loc (ul_push_p);
+}
+
+int
+hss_db_purge_ue (
+  mysql_pu_req_t * mysql_pu_req,
+  mysql_pu_ans_t * mysql_pu_ans)
+{
+  return hss_db_ops->purge_ue (mysql_pu_req, mysql_pu_ans);
+}
+
+int
+hss_db_query_pdns (
+  const char *imsi,
+  mysql_pdn_t ** pdns_p,
+  uint8_t * nb_pdns)
+{
+  return hss_db_ops->query_pdns (imsi, pdns_p, nb_pdns);
+}
+
+int
+hss_db_check_epc_equipment (
+  mysql_mme_identity_t * mme_identity_p)
+{
+  return hss_db_ops->check_epc_equipment (mme_identity_p);
+}
+
+int
+hss_db_auth_info (
+  mysql_auth_info_req_t * auth_info_req,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  return hss_db_ops->auth_info (auth_info_req, auth_info_resp);
+}
+
+int
+hss_db_auth_info_sqn (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * resync_sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  return hss_db_ops->auth_info_sqn (imsi, rand_p, resync_sqn, auth_info_resp);
+}
+
+int
+hss_db_push_rand_sqn (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * sqn)
+{
+  return hss_db_ops->push_rand_sqn (imsi, rand_p, sqn);
+}
+
+int
+hss_db_increment_sqn (
+  const char *imsi)
+{
+  return hss_db_ops->increment_sqn (imsi);
+}
+
+int
+hss_db_check_opc_keys (
+  const uint8_t opP[16])
+{
+  return hss_db_ops->check_opc_keys (opP);
+}
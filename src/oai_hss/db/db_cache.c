@@ -0,0 +1,621 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Subscriber profiles of the update location requests: the row of the users table
+ * with the serving MME and the rows of the pdn table.
+ *
+ * The cache holds CACHE_size profiles in a table of slots indexed by a hash of the
+ * IMSI. When it is full the slot to reuse is chosen by a CLOCK hand, skipping the
+ * profiles read since the hand last passed. A profile is used CACHE_ttl seconds then
+ * read again from the database. The MME written by a request replaces the cached one,
+ * the other columns are only written by the operator: hss_cache_invalidate_all()
+ * (SIGHUP) makes the changes visible before the TTL.
+ * A profile read from the database on a miss is only put in the cache if no MME was
+ * written and nothing was invalidated meanwhile (generation unchanged), otherwise an
+ * update location request could put back the MME it replaced.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <mysql/mysql.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+
+#define HSS_CACHE_NO_SLOT             (UINT32_MAX)
+/* LIMIT of DB_STMT_QUERY_PDNS */
+#define HSS_CACHE_PDNS_MAX            (10)
+
+typedef struct hss_cache_entry_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  /* Monotonic time after which the profile is read again, 0 if it never expires */
+  time_t                                  expires;
+  /* Set on each read, cleared by the CLOCK hand */
+  volatile int                            referenced;
+  int                                     has_ul;
+  mysql_ul_ans_t                          ul;
+  int                                     has_pdns;
+  uint8_t                                 nb_pdns;
+  mysql_pdn_t                            *pdns;
+  uint32_t                                next;
+} hss_cache_entry_t;
+
+static struct {
+  int                                     enabled;
+  int                                     ttl;
+  uint32_t                                capacity;
+  uint32_t                                nb_used;
+  uint32_t                                hand;
+  hss_cache_entry_t                      *entries;
+  uint32_t                                nb_buckets;
+  uint32_t                               *buckets;
+  /* Readers share the lock, the referenced flag is a plain store */
+  pthread_rwlock_t                        lock;
+  /* Incremented under the write lock by the MME writes and the invalidations */
+  uint32_t                                generation;
+  uint64_t                                hits;
+  uint64_t                                misses;
+} hss_cache;
+
+static time_t
+hss_cache_now (
+  void)
+{
+  struct timespec                         ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+static uint32_t
+hss_cache_hash (
+  const char *imsi)
+{
+  uint32_t                                h = 2166136261u;
+
+  while (*imsi) {
+    h = (h ^ (uint8_t) * imsi++) * 16777619u;
+  }
+  return h & (hss_cache.nb_buckets - 1);
+}
+
+/*
+ * Called with the lock
+ */
+static hss_cache_entry_t *
+hss_cache_find (
+  const char *imsi)
+{
+  uint32_t                                slot;
+
+  for (slot = hss_cache.buckets[hss_cache_hash (imsi)]; slot != HSS_CACHE_NO_SLOT; slot = hss_cache.entries[slot].next) {
+    if (strcmp (hss_cache.entries[slot].imsi, imsi) == 0) {
+      return &hss_cache.entries[slot];
+    }
+  }
+  return NULL;
+}
+
+static int
+hss_cache_is_valid (
+  const hss_cache_entry_t * entry)
+{
+  return (entry->expires == 0) || (entry->expires > hss_cache_now ());
+}
+
+/*
+ * Called with the write lock, the slot is free for another IMSI
+ */
+static void
+hss_cache_release (
+  uint32_t slot)
+{
+  hss_cache_entry_t                      *entry = &hss_cache.entries[slot];
+  uint32_t                               *link;
+
+  if (entry->imsi[0] == '\0') {
+    /*
+     * Invalidated
+     */
+    return;
+  }
+  link = &hss_cache.buckets[hss_cache_hash (entry->imsi)];
+
+  while (*link != slot) {
+    link = &hss_cache.entries[*link].next;
+  }
+  *link = entry->next;
+  free (entry->pdns);
+  memset (entry, 0, sizeof (hss_cache_entry_t));
+  entry->next = HSS_CACHE_NO_SLOT;
+}
+
+/*
+ * Called with the write lock, entry of the IMSI created if needed
+ */
+static hss_cache_entry_t *
+hss_cache_entry (
+  const char *imsi)
+{
+  hss_cache_entry_t                      *entry;
+  uint32_t                                bucket;
+  uint32_t                                slot;
+
+  if ((entry = hss_cache_find (imsi)) != NULL) {
+    if (hss_cache_is_valid (entry)) {
+      return entry;
+    }
+    /*
+     * Expired, the parts not read again are dropped
+     */
+    slot = entry - hss_cache.entries;
+    hss_cache_release (slot);
+  } else if (hss_cache.nb_used < hss_cache.capacity) {
+    slot = hss_cache.nb_used++;
+  } else {
+    /*
+     * CLOCK: a second chance for the profiles read since the last turn
+     */
+    while (hss_cache.entries[hss_cache.hand].referenced) {
+      hss_cache.entries[hss_cache.hand].referenced = 0;
+      hss_cache.hand = (hss_cache.hand + 1) % hss_cache.capacity;
+    }
+    slot = hss_cache.hand;
+    hss_cache.hand = (hss_cache.hand + 1) % hss_cache.capacity;
+    hss_cache_release (slot);
+  }
+
+  entry = &hss_cache.entries[slot];
+  strcpy (entry->imsi, imsi);
+  entry->expires = hss_cache.ttl ? hss_cache_now () + hss_cache.ttl : 0;
+  entry->referenced = 1;
+  bucket = hss_cache_hash (imsi);
+  entry->next = hss_cache.buckets[bucket];
+  hss_cache.buckets[bucket] = slot;
+  return entry;
+}
+
+/*
+ * Called with the write lock
+ */
+static void
+hss_cache_set_pdns (
+  hss_cache_entry_t * entry,
+  const mysql_pdn_t * pdns,
+  uint8_t nb_pdns)
+{
+  mysql_pdn_t                            *copy = NULL;
+
+  if (nb_pdns && ((copy = malloc (nb_pdns * sizeof (mysql_pdn_t))) == NULL)) {
+    return;
+  }
+  if (nb_pdns) {
+    memcpy (copy, pdns, nb_pdns * sizeof (mysql_pdn_t));
+  }
+  free (entry->pdns);
+  entry->pdns = copy;
+  entry->nb_pdns = nb_pdns;
+  entry->has_pdns = 1;
+}
+
+static void
+hss_cache_print_stats (
+  void)
+{
+  FPRINTF_NOTICE ("Subscriber cache: %u profiles, %" PRIu64 " hits, %" PRIu64 " misses\n",
+                  hss_cache.nb_used, hss_cache.hits, hss_cache.misses);
+}
+
+/*
+ * Bulk load of the users table, with the serving MME and the data of the AIRs
+ */
+static int
+hss_cache_warm_users (
+  void)
+{
+  const char                             *query = "SELECT `users`.`imsi`,`access_restriction`,`msisdn`,`ue_ambr_ul`,`ue_ambr_dl`,`rau_tau_timer`,"
+    "`mmehost`,`mmerealm`,`key`,`sqn`,`rand`,`OPc` FROM `users` LEFT JOIN `mmeidentity` "
+    "ON `users`.`mmeidentity_idmmeidentity`=`mmeidentity`.`idmmeidentity`";
+  MYSQL_RES                              *res;
+  MYSQL_ROW                               row;
+  unsigned long                          *lengths;
+  mysql_ul_ans_t                          ul;
+  mysql_auth_info_resp_t                  auth_info;
+  hss_cache_entry_t                      *entry;
+  uint32_t                                nb_users = 0;
+
+  FPRINTF_DEBUG ("Query: %s\n", query);
+  pthread_mutex_lock (&db_desc->db_cs_mutex);
+
+  if (mysql_query (db_desc->db_conn, query) || ((res = mysql_use_result (db_desc->db_conn)) == NULL)) {
+    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+    pthread_mutex_unlock (&db_desc->db_cs_mutex);
+    return EINVAL;
+  }
+
+  while ((row = mysql_fetch_row (res)) != NULL) {
+    lengths = mysql_fetch_lengths (res);
+
+    if ((row[0] == NULL) || (lengths[0] > IMSI_LENGTH_MAX)) {
+      continue;
+    }
+
+    if (nb_users < hss_cache.capacity) {
+      memset (&ul, 0, sizeof (ul));
+      strcpy (ul.imsi, row[0]);
+      ul.access_restriction = row[1] ? atoi (row[1]) : 0;
+      if (row[2]) {
+        strncpy (ul.msisdn, row[2], sizeof (ul.msisdn) - 1);
+      }
+      ul.aggr_ul = row[3] ? strtoul (row[3], NULL, 10) : 0;
+      ul.aggr_dl = row[4] ? strtoul (row[4], NULL, 10) : 0;
+      ul.rau_tau = row[5] ? strtoul (row[5], NULL, 10) : 0;
+      if (row[6] && row[7]) {
+        strncpy (ul.mme_identity.mme_host, row[6], sizeof (ul.mme_identity.mme_host) - 1);
+        strncpy (ul.mme_identity.mme_realm, row[7], sizeof (ul.mme_identity.mme_realm) - 1);
+      }
+
+      pthread_rwlock_wrlock (&hss_cache.lock);
+      entry = hss_cache_entry (ul.imsi);
+      entry->ul = ul;
+      entry->has_ul = 1;
+      entry->referenced = 0;
+      pthread_rwlock_unlock (&hss_cache.lock);
+      nb_users++;
+    }
+
+    /*
+     * The AIRs are served from memory if the SQNs are written behind
+     */
+    if (row[8] && row[9] && row[10] && row[11] && (lengths[8] == KEY_LENGTH) && (lengths[10] == RAND_LENGTH) && (lengths[11] == KEY_LENGTH)) {
+      memcpy (auth_info.key, row[8], KEY_LENGTH);
+      memcpy (auth_info.rand, row[10], RAND_LENGTH);
+      memcpy (auth_info.opc, row[11], KEY_LENGTH);
+      hss_sqn_from_u64 (strtoull (row[9], NULL, 10), auth_info.sqn);
+      hss_sqn_warm (row[0], &auth_info);
+    }
+  }
+
+  mysql_free_result (res);
+  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  FPRINTF_NOTICE ("Subscriber cache: %u users loaded\n", nb_users);
+  return 0;
+}
+
+/*
+ * Called with the write lock, the PDNs of the IMSI are added to its profile if it is cached
+ */
+static void
+hss_cache_warm_add_pdns (
+  const char *imsi,
+  const mysql_pdn_t * pdns,
+  uint8_t nb_pdns)
+{
+  hss_cache_entry_t                      *entry;
+
+  if ((imsi[0] != '\0') && ((entry = hss_cache_find (imsi)) != NULL)) {
+    hss_cache_set_pdns (entry, pdns, nb_pdns);
+  }
+}
+
+/*
+ * Bulk load of the pdn table, in the profiles loaded from the users table
+ */
+static int
+hss_cache_warm_pdns (
+  void)
+{
+  const char                             *query = "SELECT `users_imsi`,`apn`,`pdn_type`,`pdn_ipv4`,`pdn_ipv6`,`aggregate_ambr_ul`,`aggregate_ambr_dl`,"
+    "`qci`,`priority_level`,`pre_emp_cap`,`pre_emp_vul` FROM `pdn` ORDER BY `users_imsi`";
+  MYSQL_RES                              *res;
+  MYSQL_ROW                               row;
+  mysql_pdn_t                             pdns[HSS_CACHE_PDNS_MAX];
+  mysql_pdn_t                            *pdn_elm;
+  char                                    imsi[IMSI_LENGTH_MAX + 1] = "";
+  uint8_t                                 nb_pdns = 0;
+
+  FPRINTF_DEBUG ("Query: %s\n", query);
+  pthread_mutex_lock (&db_desc->db_cs_mutex);
+
+  if (mysql_query (db_desc->db_conn, query) || ((res = mysql_use_result (db_desc->db_conn)) == NULL)) {
+    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+    pthread_mutex_unlock (&db_desc->db_cs_mutex);
+    return EINVAL;
+  }
+
+  pthread_rwlock_wrlock (&hss_cache.lock);
+
+  while ((row = mysql_fetch_row (res)) != NULL) {
+    if ((row[0] == NULL) || (strlen (row[0]) > IMSI_LENGTH_MAX)) {
+      continue;
+    }
+
+    if (strcmp (row[0], imsi) != 0) {
+      hss_cache_warm_add_pdns (imsi, pdns, nb_pdns);
+      strcpy (imsi, row[0]);
+      nb_pdns = 0;
+    }
+
+    if (nb_pdns == HSS_CACHE_PDNS_MAX) {
+      continue;
+    }
+    pdn_elm = &pdns[nb_pdns++];
+    memset (pdn_elm, 0, sizeof (mysql_pdn_t));
+    strncpy (pdn_elm->apn, row[1] ? row[1] : "", sizeof (pdn_elm->apn) - 1);
+    hss_mysql_pdn_set (pdn_elm, row[2] ? row[2] : "", row[3] ? row[3] : "", row[4] ? row[4] : "", row[9] ? row[9] : "", row[10] ? row[10] : "");
+    pdn_elm->aggr_ul = row[5] ? strtoul (row[5], NULL, 10) : 0;
+    pdn_elm->aggr_dl = row[6] ? strtoul (row[6], NULL, 10) : 0;
+    pdn_elm->qci = row[7] ? atoi (row[7]) : 0;
+    pdn_elm->priority_level = row[8] ? atoi (row[8]) : 0;
+  }
+  hss_cache_warm_add_pdns (imsi, pdns, nb_pdns);
+
+  pthread_rwlock_unlock (&hss_cache.lock);
+  mysql_free_result (res);
+  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  return 0;
+}
+
+int
+hss_cache_init (
+  const hss_config_t * hss_config_p)
+{
+  uint32_t                                i;
+
+  memset (&hss_cache, 0, sizeof (hss_cache));
+
+  /*
+   * Only the MySQL backend is cached, the local store is in memory
+   */
+  if ((hss_config_p->cache_size <= 0) || (db_desc == NULL)) {
+    return 0;
+  }
+
+  hss_cache.capacity = hss_config_p->cache_size;
+  hss_cache.ttl = hss_config_p->cache_ttl;
+
+  for (hss_cache.nb_buckets = 1; hss_cache.nb_buckets < hss_cache.capacity; hss_cache.nb_buckets <<= 1);
+
+  hss_cache.entries = calloc (hss_cache.capacity, sizeof (hss_cache_entry_t));
+  hss_cache.buckets = malloc (hss_cache.nb_buckets * sizeof (uint32_t));
+
+  if ((hss_cache.entries == NULL) || (hss_cache.buckets == NULL)) {
+    FPRINTF_ERROR ("An error occured on MALLOC\n");
+    free (hss_cache.entries);
+    free (hss_cache.buckets);
+    return ENOMEM;
+  }
+
+  for (i = 0; i < hss_cache.nb_buckets; i++) {
+    hss_cache.buckets[i] = HSS_CACHE_NO_SLOT;
+  }
+
+  for (i = 0; i < hss_cache.capacity; i++) {
+    hss_cache.entries[i].next = HSS_CACHE_NO_SLOT;
+  }
+  pthread_rwlock_init (&hss_cache.lock, NULL);
+  hss_cache.enabled = 1;
+
+  if (hss_config_p->cache_warm_load_bool) {
+    if (hss_cache_warm_users () || hss_cache_warm_pdns ()) {
+      FPRINTF_ERROR ("Subscriber cache: warm load failed, profiles are read on demand\n");
+      hss_cache_invalidate_all ();
+    }
+  }
+  return 0;
+}
+
+void
+hss_cache_exit (
+  void)
+{
+  uint32_t                                i;
+
+  if (!hss_cache.enabled) {
+    return;
+  }
+  hss_cache_print_stats ();
+  hss_cache.enabled = 0;
+
+  for (i = 0; i < hss_cache.capacity; i++) {
+    free (hss_cache.entries[i].pdns);
+  }
+  free (hss_cache.entries);
+  free (hss_cache.buckets);
+  pthread_rwlock_destroy (&hss_cache.lock);
+}
+
+int
+hss_cache_get_ul (
+  const char *imsi,
+  mysql_ul_ans_t * mysql_ul_ans,
+  uint32_t * generation_p)
+{
+  hss_cache_entry_t                      *entry;
+  int                                     ret = ENOENT;
+
+  if (!hss_cache.enabled) {
+    return ENOENT;
+  }
+  pthread_rwlock_rdlock (&hss_cache.lock);
+
+  if (((entry = hss_cache_find (imsi)) != NULL) && entry->has_ul && hss_cache_is_valid (entry)) {
+    *mysql_ul_ans = entry->ul;
+    entry->referenced = 1;
+    ret = 0;
+  }
+  *generation_p = hss_cache.generation;
+  pthread_rwlock_unlock (&hss_cache.lock);
+  __sync_fetch_and_add (ret ? &hss_cache.misses : &hss_cache.hits, 1);
+  return ret;
+}
+
+void
+hss_cache_put_ul (
+  const char *imsi,
+  const mysql_ul_ans_t * mysql_ul_ans,
+  uint32_t generation)
+{
+  hss_cache_entry_t                      *entry;
+
+  if (!hss_cache.enabled) {
+    return;
+  }
+  pthread_rwlock_wrlock (&hss_cache.lock);
+
+  /*
+   * The row may have been read before an MME write, read it again on the next request
+   */
+  if (generation == hss_cache.generation) {
+    entry = hss_cache_entry (imsi);
+    entry->ul = *mysql_ul_ans;
+    entry->has_ul = 1;
+  }
+  pthread_rwlock_unlock (&hss_cache.lock);
+}
+
+int
+hss_cache_get_pdns (
+  const char *imsi,
+  mysql_pdn_t ** pdns_p,
+  uint8_t * nb_pdns,
+  uint32_t * generation_p)
+{
+  hss_cache_entry_t                      *entry;
+  mysql_pdn_t                            *copy;
+  int                                     ret = ENOENT;
+
+  if (!hss_cache.enabled) {
+    return ENOENT;
+  }
+  pthread_rwlock_rdlock (&hss_cache.lock);
+
+  /*
+   * A user without PDN is not cached, its request fails the same way from the database
+   */
+  if (((entry = hss_cache_find (imsi)) != NULL) && entry->has_pdns && entry->nb_pdns && hss_cache_is_valid (entry)
+      && ((copy = malloc (entry->nb_pdns * sizeof (mysql_pdn_t))) != NULL)) {
+    memcpy (copy, entry->pdns, entry->nb_pdns * sizeof (mysql_pdn_t));
+    *pdns_p = copy;
+    *nb_pdns = entry->nb_pdns;
+    entry->referenced = 1;
+    ret = 0;
+  }
+  *generation_p = hss_cache.generation;
+  pthread_rwlock_unlock (&hss_cache.lock);
+  __sync_fetch_and_add (ret ? &hss_cache.misses : &hss_cache.hits, 1);
+  return ret;
+}
+
+void
+hss_cache_put_pdns (
+  const char *imsi,
+  const mysql_pdn_t * pdns,
+  uint8_t nb_pdns,
+  uint32_t generation)
+{
+  if (!hss_cache.enabled) {
+    return;
+  }
+  pthread_rwlock_wrlock (&hss_cache.lock);
+
+  if (generation == hss_cache.generation) {
+    hss_cache_set_pdns (hss_cache_entry (imsi), pdns, nb_pdns);
+  }
+  pthread_rwlock_unlock (&hss_cache.lock);
+}
+
+void
+hss_cache_set_mme_identity (
+  const char *imsi,
+  const mysql_mme_identity_t * mme_identity_p)
+{
+  hss_cache_entry_t                      *entry;
+
+  if (!hss_cache.enabled) {
+    return;
+  }
+  pthread_rwlock_wrlock (&hss_cache.lock);
+  hss_cache.generation++;
+
+  if (((entry = hss_cache_find (imsi)) != NULL) && entry->has_ul) {
+    entry->ul.mme_identity = *mme_identity_p;
+  }
+  pthread_rwlock_unlock (&hss_cache.lock);
+}
+
+void
+hss_cache_invalidate (
+  const char *imsi)
+{
+  hss_cache_entry_t                      *entry;
+
+  if (!hss_cache.enabled) {
+    return;
+  }
+  pthread_rwlock_wrlock (&hss_cache.lock);
+  hss_cache.generation++;
+
+  if ((entry = hss_cache_find (imsi)) != NULL) {
+    /*
+     * The slot stays in the CLOCK: unreferenced, it is reused when the hand reaches it
+     * once the cache is full, the free slots after nb_used are used before
+     */
+    hss_cache_release (entry - hss_cache.entries);
+  }
+  pthread_rwlock_unlock (&hss_cache.lock);
+}
+
+void
+hss_cache_invalidate_all (
+  void)
+{
+  uint32_t                                i;
+
+  if (!hss_cache.enabled) {
+    return;
+  }
+  hss_cache_print_stats ();
+  pthread_rwlock_wrlock (&hss_cache.lock);
+
+  for (i = 0; i < hss_cache.capacity; i++) {
+    free (hss_cache.entries[i].pdns);
+    memset (&hss_cache.entries[i], 0, sizeof (hss_cache_entry_t));
+    hss_cache.entries[i].next = HSS_CACHE_NO_SLOT;
+  }
+
+  for (i = 0; i < hss_cache.nb_buckets; i++) {
+    hss_cache.buckets[i] = HSS_CACHE_NO_SLOT;
+  }
+  hss_cache.nb_used = 0;
+  hss_cache.hand = 0;
+  hss_cache.generation++;
+  pthread_rwlock_unlock (&hss_cache.lock);
+}
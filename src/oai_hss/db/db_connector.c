@@ -31,6 +31,8 @@
 #include <inttypes.h>
 
 #include <mysql/mysql.h>
+#include <mysql/errmsg.h>
+#include <mysql/mysqld_error.h>
 
 #include "hss_config.h"
 #include "db_proto.h"
@@ -62,11 +64,108 @@ print_buffer (
   fprintf (stdout, "\n");
 }
 
+static const char * const               db_stmt_sql[DB_STMT_MAX] = {
+  [DB_STMT_AUTH_INFO]         = "SELECT `key`,`sqn`,`rand`,`OPc` FROM `users` WHERE `users`.`imsi`=?",
+  [DB_STMT_PUSH_RAND_SQN]     = "UPDATE `users` SET `rand`=?,`sqn`=? WHERE `users`.`imsi`=?",
+  /*
+   * + 32 = 2 ^ sizeof(IND) (see 3GPP TS. 33.102)
+   */
+  [DB_STMT_INCREMENT_SQN]     = "UPDATE `users` SET `sqn` = `sqn` + 32 WHERE `users`.`imsi`=?",
+  [DB_STMT_UPDATE_LOC]        = "SELECT `access_restriction`,`mmeidentity_idmmeidentity`,`msisdn`,`ue_ambr_ul`,`ue_ambr_dl`,`rau_tau_timer` "
+                                "FROM `users` WHERE `users`.`imsi`=?",
+  [DB_STMT_QUERY_MMEIDENTITY] = "SELECT `mmehost`,`mmerealm` FROM `mmeidentity` WHERE `mmeidentity`.`idmmeidentity`=?",
+  [DB_STMT_QUERY_PDNS]        = "SELECT `apn`,`pdn_type`,`pdn_ipv4`,`pdn_ipv6`,`aggregate_ambr_ul`,`aggregate_ambr_dl`,`qci`,`priority_level`,"
+                                "`pre_emp_cap`,`pre_emp_vul` FROM `pdn` WHERE `pdn`.`users_imsi`=? LIMIT 10",
+  [DB_STMT_AUTH_INFO_SQN]     = "CALL `hss_auth_info_sqn`(?,?,?)",
+};
+
+/* Connection of the pool used by the thread, chosen on its first request */
+static __thread db_connection_t        *db_thread_connection = NULL;
+
+static MYSQL *
+hss_mysql_open (
+  void)
+{
+  const int                               mysql_reconnect_val = 1;
+  MYSQL                                  *db_conn = mysql_init (NULL);
+
+  if (db_conn == NULL) {
+    FPRINTF_ERROR ("An error occured on mysql_init\n");
+    return NULL;
+  }
+
+  mysql_options (db_conn, MYSQL_OPT_RECONNECT, &mysql_reconnect_val);
+
+  /*
+   * Try to connect to database
+   */
+  if (!mysql_real_connect (db_conn, db_desc->server, db_desc->user, db_desc->password, db_desc->database, 0, NULL, 0)) {
+    FPRINTF_ERROR ("An error occured while connecting to db: %s\n", mysql_error (db_conn));
+    mysql_close (db_conn);
+    return NULL;
+  }
+  return db_conn;
+}
+
+static void
+hss_mysql_connection_close_stmts (
+  db_connection_t * connection)
+{
+  int                                     i;
+
+  for (i = 0; i < DB_STMT_MAX; i++) {
+    if (connection->stmt[i]) {
+      mysql_stmt_close (connection->stmt[i]);
+      connection->stmt[i] = NULL;
+    }
+  }
+}
+
+/*
+ * (Re)prepare the statements of a connection, the statements do not survive a reconnection.
+ */
+static int
+hss_mysql_connection_prepare (
+  db_connection_t * connection)
+{
+  int                                     i;
+
+  hss_mysql_connection_close_stmts (connection);
+
+  /*
+   * Reconnects if the connection was lost (MYSQL_OPT_RECONNECT)
+   */
+  if (mysql_ping (connection->db_conn)) {
+    FPRINTF_ERROR ("Lost connection to db: %s\n", mysql_error (connection->db_conn));
+    return EINVAL;
+  }
+
+  for (i = 0; i < DB_STMT_MAX; i++) {
+    connection->stmt[i] = mysql_stmt_init (connection->db_conn);
+
+    if ((connection->stmt[i] == NULL) || mysql_stmt_prepare (connection->stmt[i], db_stmt_sql[i], strlen (db_stmt_sql[i]))) {
+      if ((i == DB_STMT_AUTH_INFO_SQN) && (connection->stmt[i] != NULL)) {
+        /*
+         * Database created without the procedure, the requests fall back to separate queries
+         */
+        FPRINTF_NOTICE ("Cannot prepare statement %s: %s\n", db_stmt_sql[i], mysql_stmt_error (connection->stmt[i]));
+        mysql_stmt_close (connection->stmt[i]);
+        connection->stmt[i] = NULL;
+        continue;
+      }
+      FPRINTF_ERROR ("Cannot prepare statement %s: %s\n", db_stmt_sql[i], mysql_error (connection->db_conn));
+      hss_mysql_connection_close_stmts (connection);
+      return EINVAL;
+    }
+  }
+  return 0;
+}
+
 int
 hss_mysql_connect (
   const hss_config_t * hss_config_p)
 {
-  const int                               mysql_reconnect_val = 1;
+  int                                     i;
 
   if ((hss_config_p->mysql_server == NULL) || (hss_config_p->mysql_user == NULL) || (hss_config_p->mysql_password == NULL) || (hss_config_p->mysql_database == NULL)) {
     FPRINTF_ERROR ( "An empty name is not allowed\n");
@@ -74,7 +173,7 @@ hss_mysql_connect (
   }
 
   FPRINTF_DEBUG ("Initializing db layer\n");
-  db_desc = malloc (sizeof (database_t));
+  db_desc = calloc (1, sizeof (database_t));
 
   if (db_desc == NULL) {
     FPRINTF_DEBUG ("An error occured on MALLOC\n");
@@ -89,17 +188,11 @@ hss_mysql_connect (
   db_desc->user = strdup (hss_config_p->mysql_user);
   db_desc->password = strdup (hss_config_p->mysql_password);
   db_desc->database = strdup (hss_config_p->mysql_database);
-  /*
-   * Init mySQL client
-   */
-  db_desc->db_conn = mysql_init (NULL);
-  mysql_options (db_desc->db_conn, MYSQL_OPT_RECONNECT, &mysql_reconnect_val);
 
   /*
-   * Try to connect to database
+   * Init mySQL client
    */
-  if (!mysql_real_connect (db_desc->db_conn, db_desc->server, db_desc->user, db_desc->password, db_desc->database, 0, NULL, 0)) {
-    FPRINTF_ERROR ("An error occured while connecting to db: %s\n", mysql_error (db_desc->db_conn));
+  if ((db_desc->db_conn = hss_mysql_open ()) == NULL) {
     mysql_thread_end();
     return -1;
   }
@@ -108,7 +201,31 @@ hss_mysql_connect (
    * Set the multi statement ON
    */
   mysql_set_server_option (db_desc->db_conn, MYSQL_OPTION_MULTI_STATEMENTS_ON);
-  FPRINTF_DEBUG ("Initializing db layer: DONE\n");
+
+  /*
+   * Pool of connections with the prepared statements of the S6a requests
+   */
+  db_desc->nb_connections = hss_config_p->mysql_pool_size;
+  if ((db_desc->nb_connections <= 0) || (db_desc->nb_connections > HSS_MYSQL_POOL_SIZE_MAX)) {
+    db_desc->nb_connections = HSS_MYSQL_POOL_SIZE_DEFAULT;
+  }
+  db_desc->connections = calloc (db_desc->nb_connections, sizeof (db_connection_t));
+
+  if (db_desc->connections == NULL) {
+    FPRINTF_DEBUG ("An error occured on MALLOC\n");
+    return errno;
+  }
+
+  for (i = 0; i < db_desc->nb_connections; i++) {
+    pthread_mutex_init (&db_desc->connections[i].lock, NULL);
+
+    if (((db_desc->connections[i].db_conn = hss_mysql_open ()) == NULL)
+        || hss_mysql_connection_prepare (&db_desc->connections[i])) {
+      mysql_thread_end();
+      return -1;
+    }
+  }
+  FPRINTF_DEBUG ("Initializing db layer: DONE (%d connections)\n", db_desc->nb_connections);
   return 0;
 }
 
@@ -116,30 +233,132 @@ void
 hss_mysql_disconnect (
   void)
 {
+  int                                     i;
+
+  for (i = 0; i < db_desc->nb_connections; i++) {
+    hss_mysql_connection_close_stmts (&db_desc->connections[i]);
+
+    if (db_desc->connections[i].db_conn) {
+      mysql_close (db_desc->connections[i].db_conn);
+    }
+    pthread_mutex_destroy (&db_desc->connections[i].lock);
+  }
+  free (db_desc->connections);
+  db_desc->connections = NULL;
+  db_desc->nb_connections = 0;
   mysql_close (db_desc->db_conn);
   mysql_thread_end();
 }
 
+db_connection_t *
+hss_mysql_connection_get (
+  void)
+{
+  if ((db_desc == NULL) || (db_desc->connections == NULL)) {
+    return NULL;
+  }
+
+  if (db_thread_connection == NULL) {
+    /*
+     * The freeDiameter threads are spread over the connections in a round robin way
+     */
+    db_thread_connection = &db_desc->connections[__sync_fetch_and_add (&db_desc->next_connection, 1) % db_desc->nb_connections];
+  }
+  pthread_mutex_lock (&db_thread_connection->lock);
+  return db_thread_connection;
+}
+
+void
+hss_mysql_connection_put (
+  db_connection_t * connection)
+{
+  pthread_mutex_unlock (&connection->lock);
+}
+
+void
+hss_mysql_bind (
+  MYSQL_BIND * bind,
+  enum enum_field_types type,
+  void *buffer,
+  unsigned long buffer_length,
+  unsigned long *length,
+  my_bool * is_null)
+{
+  memset (bind, 0, sizeof (MYSQL_BIND));
+  bind->buffer_type = type;
+  bind->buffer = buffer;
+  bind->buffer_length = buffer_length;
+  bind->length = length;
+  bind->is_null = is_null;
+  /*
+   * Counters, AMBRs and identifiers of the HSS tables are unsigned
+   */
+  bind->is_unsigned = 1;
+}
+
+void
+hss_mysql_string_end (
+  char *string,
+  size_t size,
+  unsigned long length,
+  my_bool is_null)
+{
+  if (is_null) {
+    length = 0;
+  } else if (length >= size) {
+    length = size - 1;
+  }
+  string[length] = '\0';
+}
+
 int
-hss_mysql_update_loc (
-  const char *imsi,
-  mysql_ul_ans_t * mysql_ul_ans)
+hss_mysql_stmt_execute (
+  db_connection_t * connection,
+  db_stmt_id_t id,
+  MYSQL_BIND * params,
+  MYSQL_BIND * results)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-  int                                     ret = 0;
+  int                                     attempt;
 
-  if ((db_desc->db_conn == NULL) || (mysql_ul_ans == NULL)) {
-    return EINVAL;
+  for (attempt = 0; ; attempt++) {
+    MYSQL_STMT                             *stmt = connection->stmt[id];
+    unsigned int                            error = CR_SERVER_LOST;
+
+    if (stmt != NULL) {
+      if (!mysql_stmt_bind_param (stmt, params) && !mysql_stmt_execute (stmt)
+          && ((results == NULL) || (!mysql_stmt_bind_result (stmt, results) && !mysql_stmt_store_result (stmt)))) {
+        return 0;
+      }
+      error = mysql_stmt_errno (stmt);
+      FPRINTF_ERROR ("Query execution failed: %s\n", mysql_stmt_error (stmt));
+    }
+
+    /*
+     * Only retry once, after the loss of the connection
+     */
+    if (attempt || ((error != CR_SERVER_GONE_ERROR) && (error != CR_SERVER_LOST) && (error != ER_UNKNOWN_STMT_HANDLER))) {
+      return EINVAL;
+    }
+
+    if (hss_mysql_connection_prepare (connection)) {
+      return EINVAL;
+    }
   }
+}
 
-  if (strlen (imsi) > 15) {
+int
+hss_mysql_list_users (
+  void (*callback) (const char *imsi, void *arg),
+  void *arg)
+{
+  MYSQL_RES                              *res;
+  MYSQL_ROW                               row;
+  const char                             *query = "SELECT `imsi` FROM `users`";
+
+  if ((db_desc->db_conn == NULL) || (callback == NULL)) {
     return EINVAL;
   }
 
-  sprintf (query, "SELECT `access_restriction`,`mmeidentity_idmmeidentity`," "`msisdn`,`ue_ambr_ul`,`ue_ambr_dl`,`rau_tau_timer` " "FROM `users` WHERE `users`.`imsi`='%s' ", imsi);
-  memcpy (mysql_ul_ans->imsi, imsi, strlen (imsi) + 1);
   FPRINTF_DEBUG ("Query: %s\n", query);
   pthread_mutex_lock (&db_desc->db_cs_mutex);
 
@@ -152,34 +371,107 @@ hss_mysql_update_loc (
   res = mysql_store_result (db_desc->db_conn);
   pthread_mutex_unlock (&db_desc->db_cs_mutex);
 
-  if ( res == NULL )
+  if (res == NULL) {
     return EINVAL;
+  }
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    int                                     mme_id;
+  while ((row = mysql_fetch_row (res)) != NULL) {
+    if (row[0] != NULL) {
+      callback (row[0], arg);
+    }
+  }
 
-    /*
-     * MSISDN may be NULL
-     */
-    mysql_ul_ans->access_restriction = atoi (row[0]);
+  mysql_free_result (res);
+  return 0;
+}
+
+int
+hss_mysql_update_loc (
+  const char *imsi,
+  mysql_ul_ans_t * mysql_ul_ans)
+{
+  db_connection_t                        *connection;
+  MYSQL_BIND                              param;
+  MYSQL_BIND                              result[6];
+  unsigned long                           msisdn_length = 0;
+  my_bool                                 is_null[6] = {0};
+  char                                    msisdn[47];
+  uint32_t                                access_restriction = 0;
+  uint32_t                                mme_id = 0;
+  uint64_t                                aggr_ul = 0;
+  uint64_t                                aggr_dl = 0;
+  uint32_t                                rau_tau = 0;
+  uint32_t                                cache_generation = 0;
+  int                                     ret = 0;
+  int                                     status;
+
+  if (mysql_ul_ans == NULL) {
+    return EINVAL;
+  }
+
+  if (strlen (imsi) > 15) {
+    return EINVAL;
+  }
+
+  memcpy (mysql_ul_ans->imsi, imsi, strlen (imsi) + 1);
+
+  if (hss_cache_get_ul (imsi, mysql_ul_ans, &cache_generation) == 0) {
+    return 0;
+  }
+
+  FPRINTF_DEBUG ("Query: %s (%s)\n", db_stmt_sql[DB_STMT_UPDATE_LOC], imsi);
+
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
+    return EINVAL;
+  }
+
+  hss_mysql_bind (&param, MYSQL_TYPE_STRING, (void *)imsi, strlen (imsi), NULL, NULL);
+  hss_mysql_bind (&result[0], MYSQL_TYPE_LONG, &access_restriction, 0, NULL, &is_null[0]);
+  hss_mysql_bind (&result[1], MYSQL_TYPE_LONG, &mme_id, 0, NULL, &is_null[1]);
+  hss_mysql_bind (&result[2], MYSQL_TYPE_STRING, msisdn, sizeof (msisdn), &msisdn_length, &is_null[2]);
+  hss_mysql_bind (&result[3], MYSQL_TYPE_LONGLONG, &aggr_ul, 0, NULL, &is_null[3]);
+  hss_mysql_bind (&result[4], MYSQL_TYPE_LONGLONG, &aggr_dl, 0, NULL, &is_null[4]);
+  hss_mysql_bind (&result[5], MYSQL_TYPE_LONG, &rau_tau, 0, NULL, &is_null[5]);
+
+  if (hss_mysql_stmt_execute (connection, DB_STMT_UPDATE_LOC, &param, result)) {
+    hss_mysql_connection_put (connection);
+    return EINVAL;
+  }
+
+  status = mysql_stmt_fetch (connection->stmt[DB_STMT_UPDATE_LOC]);
+  mysql_stmt_free_result (connection->stmt[DB_STMT_UPDATE_LOC]);
+  hss_mysql_connection_put (connection);
 
-    if ((mme_id = atoi (row[1])) > 0) {
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    mysql_ul_ans->access_restriction = access_restriction;
+
+    if (!is_null[1] && (mme_id > 0)) {
       ret = hss_mysql_query_mmeidentity (mme_id, &mysql_ul_ans->mme_identity);
     } else {
       mysql_ul_ans->mme_identity.mme_host[0] = '\0';
       mysql_ul_ans->mme_identity.mme_realm[0] = '\0';
     }
 
-    if (row[2] != 0) {
-      memcpy (mysql_ul_ans->msisdn, row[2], strlen (row[2]));
+    /*
+     * MSISDN may be NULL
+     */
+    if (!is_null[2]) {
+      if (msisdn_length >= sizeof (mysql_ul_ans->msisdn)) {
+        msisdn_length = sizeof (mysql_ul_ans->msisdn) - 1;
+      }
+      memcpy (mysql_ul_ans->msisdn, msisdn, msisdn_length);
+      mysql_ul_ans->msisdn[msisdn_length] = '\0';
     }
 
-    mysql_ul_ans->aggr_ul = atoi (row[3]);
-    mysql_ul_ans->aggr_dl = atoi (row[4]);
-    mysql_ul_ans->rau_tau = atoi (row[5]);
+    mysql_ul_ans->aggr_ul = aggr_ul;
+    mysql_ul_ans->aggr_dl = aggr_dl;
+    mysql_ul_ans->rau_tau = rau_tau;
+
+    if (ret == 0) {
+      hss_cache_put_ul (imsi, mysql_ul_ans, cache_generation);
+    }
   }
 
-  mysql_free_result (res);
   return ret;
 }
 
@@ -343,6 +635,7 @@ mysql_push_up_loc (
         FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
       } else {                  /* some error occurred */
         FPRINTF_ERROR ( "Could not retrieve result set\n");
+        status = EINVAL;
         break;
       }
     }
@@ -355,6 +648,15 @@ mysql_push_up_loc (
   } while (status == 0);
 
   pthread_mutex_unlock (&db_desc->db_cs_mutex);
+
+  /*
+   * The UE is now served by this MME, or the cached MME is unknown if the update failed
+   */
+  if (status > 0) {
+    hss_cache_invalidate (ul_push_p->imsi);
+  } else if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
+    hss_cache_set_mme_identity (ul_push_p->imsi, &ul_push_p->mme_identity);
+  }
   return 0;
 }
 
@@ -364,135 +666,153 @@ hss_mysql_push_rand_sqn (
   uint8_t * rand_p,
   uint8_t * sqn)
 {
-  int                                     status = 0,
-    i;
-  MYSQL_RES                              *res;
-  char                                    query[1000];
-  int                                     query_length = 0;
+  db_connection_t                        *connection;
+  MYSQL_BIND                              params[3];
   uint64_t                                sqn_decimal = 0;
+  int                                     ret = 0;
 
-  if (db_desc->db_conn == NULL) {
+  if (rand_p == NULL || sqn == NULL) {
     return EINVAL;
   }
 
-  if (rand_p == NULL || sqn == NULL) {
+  sqn_decimal = ((uint64_t) sqn[0] << 40) | ((uint64_t) sqn[1] << 32) | ((uint64_t) sqn[2] << 24) | (sqn[3] << 16) | (sqn[4] << 8) | sqn[5];
+  FPRINTF_DEBUG ("Query: %s (%" PRIu64 ", %s)\n", db_stmt_sql[DB_STMT_PUSH_RAND_SQN], sqn_decimal, imsi);
+
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
     return EINVAL;
   }
 
-  sqn_decimal = ((uint64_t) sqn[0] << 40) | ((uint64_t) sqn[1] << 32) | ((uint64_t) sqn[2] << 24) | (sqn[3] << 16) | (sqn[4] << 8) | sqn[5];
-  query_length = sprintf (query, "UPDATE `users` SET `rand`=UNHEX('");
+  hss_mysql_bind (&params[0], MYSQL_TYPE_BLOB, rand_p, RAND_LENGTH, NULL, NULL);
+  hss_mysql_bind (&params[1], MYSQL_TYPE_LONGLONG, &sqn_decimal, 0, NULL, NULL);
+  hss_mysql_bind (&params[2], MYSQL_TYPE_STRING, (void *)imsi, strlen (imsi), NULL, NULL);
 
-  for (i = 0; i < RAND_LENGTH; i++) {
-    query_length += sprintf (&query[query_length], "%02x", rand_p[i]);
+  if (hss_mysql_stmt_execute (connection, DB_STMT_PUSH_RAND_SQN, params, NULL)) {
+    ret = EINVAL;
+  } else {
+    FPRINTF_DEBUG ("%lld rows affected\n", mysql_stmt_affected_rows (connection->stmt[DB_STMT_PUSH_RAND_SQN]));
   }
 
-  query_length += sprintf (&query[query_length], "'),`sqn`=%" PRIu64, sqn_decimal);
-  query_length += sprintf (&query[query_length], " WHERE `users`.`imsi`='%s'", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  hss_mysql_connection_put (connection);
+  return ret;
+}
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+int
+hss_mysql_auth_info_sqn (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * resync_sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  db_connection_t                        *connection;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              params[3];
+  MYSQL_BIND                              result[3];
+  my_bool                                 resync_is_null = (resync_sqn == NULL);
+  my_bool                                 is_null[3] = {0};
+  unsigned long                           length[3] = {0};
+  uint64_t                                resync_decimal = 0;
+  uint64_t                                sqn = 0;
+  int                                     status;
+  int                                     ret = 0;
+
+  if ((imsi == NULL) || (rand_p == NULL) || (auth_info_resp == NULL)) {
     return EINVAL;
   }
 
-  /*
-   * process each statement result
-   */
-  do {
+  if (resync_sqn) {
+    resync_decimal = ((uint64_t) resync_sqn[0] << 40) | ((uint64_t) resync_sqn[1] << 32) | ((uint64_t) resync_sqn[2] << 24) |
+      (resync_sqn[3] << 16) | (resync_sqn[4] << 8) | resync_sqn[5];
+  }
+
+  FPRINTF_DEBUG ("Query: %s (%s)\n", db_stmt_sql[DB_STMT_AUTH_INFO_SQN], imsi);
+
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
+    return EINVAL;
+  }
+
+  if (connection->stmt[DB_STMT_AUTH_INFO_SQN] == NULL) {
+    hss_mysql_connection_put (connection);
+    return ENOTSUP;
+  }
+
+  hss_mysql_bind (&params[0], MYSQL_TYPE_STRING, (void *)imsi, strlen (imsi), NULL, NULL);
+  hss_mysql_bind (&params[1], MYSQL_TYPE_BLOB, rand_p, RAND_LENGTH, NULL, NULL);
+  hss_mysql_bind (&params[2], MYSQL_TYPE_LONGLONG, &resync_decimal, 0, NULL, &resync_is_null);
+  hss_mysql_bind (&result[0], MYSQL_TYPE_BLOB, auth_info_resp->key, KEY_LENGTH, &length[0], &is_null[0]);
+  hss_mysql_bind (&result[1], MYSQL_TYPE_LONGLONG, &sqn, 0, &length[1], &is_null[1]);
+  hss_mysql_bind (&result[2], MYSQL_TYPE_BLOB, auth_info_resp->opc, KEY_LENGTH, &length[2], &is_null[2]);
+
+  if (hss_mysql_stmt_execute (connection, DB_STMT_AUTH_INFO_SQN, params, result)) {
     /*
-     * did current statement return data?
+     * The procedure may have been dropped since the statement was prepared
      */
-    res = mysql_store_result (db_desc->db_conn);
+    ret = (connection->stmt[DB_STMT_AUTH_INFO_SQN] && (mysql_stmt_errno (connection->stmt[DB_STMT_AUTH_INFO_SQN]) == ER_SP_DOES_NOT_EXIST)) ?
+      ENOTSUP : EINVAL;
+    hss_mysql_connection_put (connection);
+    return ret;
+  }
 
-    if (res) {
-      /*
-       * yes; process rows and free the result set
-       */
-      mysql_free_result (res);
-    } else {                    /* no result set or error */
-      if (mysql_field_count (db_desc->db_conn) == 0) {
-        FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-      } else {                  /* some error occurred */
-        FPRINTF_ERROR ( "Could not retrieve result set\n");
-        break;
-      }
+  stmt = connection->stmt[DB_STMT_AUTH_INFO_SQN];
+  status = mysql_stmt_fetch (stmt);
+  mysql_stmt_free_result (stmt);
+
+  /*
+   * A CALL returns the status of the procedure after its result set
+   */
+  while (mysql_stmt_next_result (stmt) == 0) {
+    mysql_stmt_free_result (stmt);
+  }
+
+  hss_mysql_connection_put (connection);
+
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    if (is_null[0] || is_null[1] || is_null[2]) {
+      return EINVAL;
     }
 
-    /*
-     * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-     */
-    if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-      FPRINTF_ERROR ( "Could not execute statement\n");
-  } while (status == 0);
+    auth_info_resp->sqn[0] = (sqn & (255UL << 40)) >> 40;
+    auth_info_resp->sqn[1] = (sqn & (255UL << 32)) >> 32;
+    auth_info_resp->sqn[2] = (sqn & (255UL << 24)) >> 24;
+    auth_info_resp->sqn[3] = (sqn & (255UL << 16)) >> 16;
+    auth_info_resp->sqn[4] = (sqn & (255UL << 8)) >> 8;
+    auth_info_resp->sqn[5] = (sqn & 0xFF);
+    memcpy (auth_info_resp->rand, rand_p, RAND_LENGTH);
+    print_buffer ("SQN: ", auth_info_resp->sqn, SQN_LENGTH);
+  } else {
+    ret = DIAMETER_ERROR_USER_UNKNOWN;
+  }
 
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-  return 0;
+  return ret;
 }
 
 int
 hss_mysql_increment_sqn (
   const char *imsi)
 {
-  int                                     status;
-  MYSQL_RES                              *res;
-  char                                    query[1000];
-
-  if (db_desc->db_conn == NULL) {
-    return EINVAL;
-  }
+  db_connection_t                        *connection;
+  MYSQL_BIND                              param;
+  int                                     ret = 0;
 
   if (imsi == NULL) {
     return EINVAL;
   }
 
-  /*
-   * + 32 = 2 ^ sizeof(IND) (see 3GPP TS. 33.102)
-   */
-  sprintf (query, "UPDATE `users` SET `sqn` = `sqn` + 32 WHERE `users`.`imsi`='%s'", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-
-  pthread_mutex_lock(&db_desc->db_cs_mutex);
+  FPRINTF_DEBUG ("Query: %s (%s)\n", db_stmt_sql[DB_STMT_INCREMENT_SQN], imsi);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
     return EINVAL;
   }
 
-  /*
-   * process each statement result
-   */
-  do {
-    /*
-     * did current statement return data?
-     */
-    res = mysql_store_result (db_desc->db_conn);
-
-    if (res) {
-      /*
-       * yes; process rows and free the result set
-       */
-      mysql_free_result (res);
-    } else {                    /* no result set or error */
-      if (mysql_field_count (db_desc->db_conn) == 0) {
-        FPRINTF_ERROR ( "%lld rows affected\n", mysql_affected_rows (db_desc->db_conn));
-      } else {                  /* some error occurred */
-        FPRINTF_ERROR ( "Could not retrieve result set\n");
-        break;
-      }
-    }
+  hss_mysql_bind (&param, MYSQL_TYPE_STRING, (void *)imsi, strlen (imsi), NULL, NULL);
 
-    /*
-     * more results? -1 = no, >0 = error, 0 = yes (keep looping)
-     */
-    if ((status = mysql_next_result (db_desc->db_conn)) > 0)
-      FPRINTF_ERROR ( "Could not execute statement\n");
-  } while (status == 0);
+  if (hss_mysql_stmt_execute (connection, DB_STMT_INCREMENT_SQN, &param, NULL)) {
+    ret = EINVAL;
+  } else {
+    FPRINTF_DEBUG ("%lld rows affected\n", mysql_stmt_affected_rows (connection->stmt[DB_STMT_INCREMENT_SQN]));
+  }
 
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-  return 0;
+  hss_mysql_connection_put (connection);
+  return ret;
 }
 
 int
@@ -501,51 +821,50 @@ hss_mysql_auth_info (
   mysql_auth_info_resp_t * auth_info_resp)
 {
   int                                     ret = 0;
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-
-  if (db_desc->db_conn == NULL) {
-    return EINVAL;
-  }
+  int                                     status;
+  db_connection_t                        *connection;
+  MYSQL_BIND                              param;
+  MYSQL_BIND                              result[4];
+  my_bool                                 is_null[4] = {0};
+  unsigned long                           length[4] = {0};
+  uint64_t                                sqn = 0;
 
   if ((auth_info_req == NULL) || (auth_info_resp == NULL)) {
     return EINVAL;
   }
 
-  sprintf (query, "SELECT `key`,`sqn`,`rand`,`OPc` FROM `users` WHERE `users`.`imsi`='%s' ", auth_info_req->imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  FPRINTF_DEBUG ("Query: %s (%s)\n", db_stmt_sql[DB_STMT_AUTH_INFO], auth_info_req->imsi);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  hss_mysql_bind (&param, MYSQL_TYPE_STRING, auth_info_req->imsi, strlen (auth_info_req->imsi), NULL, NULL);
+  hss_mysql_bind (&result[0], MYSQL_TYPE_BLOB, auth_info_resp->key, KEY_LENGTH, &length[0], &is_null[0]);
+  hss_mysql_bind (&result[1], MYSQL_TYPE_LONGLONG, &sqn, 0, &length[1], &is_null[1]);
+  hss_mysql_bind (&result[2], MYSQL_TYPE_BLOB, auth_info_resp->rand, RAND_LENGTH, &length[2], &is_null[2]);
+  hss_mysql_bind (&result[3], MYSQL_TYPE_BLOB, auth_info_resp->opc, KEY_LENGTH, &length[3], &is_null[3]);
 
-  if ( res == NULL )
+  if (hss_mysql_stmt_execute (connection, DB_STMT_AUTH_INFO, &param, result)) {
+    hss_mysql_connection_put (connection);
     return EINVAL;
+  }
 
-  ret = 0;
+  status = mysql_stmt_fetch (connection->stmt[DB_STMT_AUTH_INFO]);
+  mysql_stmt_free_result (connection->stmt[DB_STMT_AUTH_INFO]);
+  hss_mysql_connection_put (connection);
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    if (row[0] == NULL || row[1] == NULL || row[2] == NULL || row[3] == NULL) {
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    if (is_null[0] || is_null[1] || is_null[2] || is_null[3]) {
       ret = EINVAL;
     }
 
-    if (row[0] != NULL) {
-      print_buffer ("Key: ", (uint8_t *) row[0], KEY_LENGTH);
-      memcpy (auth_info_resp->key, row[0], KEY_LENGTH);
+    if (!is_null[0]) {
+      print_buffer ("Key: ", auth_info_resp->key, KEY_LENGTH);
     }
 
-    if (row[1] != NULL) {
-      uint64_t                                sqn = 0;
-
-      sqn = atoll (row[1]);
-      printf ("Received SQN %s converted to %" PRIu64 "\n", row[1], sqn);
+    if (!is_null[1]) {
+      printf ("Received SQN %" PRIu64 "\n", sqn);
       auth_info_resp->sqn[0] = (sqn & (255UL << 40)) >> 40;
       auth_info_resp->sqn[1] = (sqn & (255UL << 32)) >> 32;
       auth_info_resp->sqn[2] = (sqn & (255UL << 24)) >> 24;
@@ -555,21 +874,17 @@ hss_mysql_auth_info (
       print_buffer ("SQN: ", auth_info_resp->sqn, SQN_LENGTH);
     }
 
-    if (row[2] != NULL) {
-      print_buffer ("RAND: ", (uint8_t *) row[2], RAND_LENGTH);
-      memcpy (auth_info_resp->rand, row[2], RAND_LENGTH);
+    if (!is_null[2]) {
+      print_buffer ("RAND: ", auth_info_resp->rand, RAND_LENGTH);
     }
 
-    if (row[3] != NULL) {
-      print_buffer ("OPc: ", (uint8_t *) row[3], KEY_LENGTH);
-      memcpy (auth_info_resp->opc, row[3], KEY_LENGTH);
+    if (!is_null[3]) {
+      print_buffer ("OPc: ", auth_info_resp->opc, KEY_LENGTH);
     }
-
   } else {
     ret =  DIAMETER_ERROR_USER_UNKNOWN;
   }
 
-  mysql_free_result (res);
   return ret;
 }
 
@@ -689,3 +1004,21 @@ hss_mysql_check_opc_keys (
   mysql_thread_end ();
   return ret;
 }
+
+const hss_db_ops_t                      hss_db_mysql_ops = {
+  .name                = "mysql",
+  .connect             = hss_mysql_connect,
+  .disconnect          = hss_mysql_disconnect,
+  .get_user            = hss_mysql_get_user,
+  .list_users          = hss_mysql_list_users,
+  .update_loc          = hss_mysql_update_loc,
+  .push_up_loc         = mysql_push_up_loc,
+  .purge_ue            = hss_mysql_purge_ue,
+  .query_pdns          = hss_mysql_query_pdns,
+  .check_epc_equipment = hss_mysql_check_epc_equipment,
+  .auth_info           = hss_mysql_auth_info,
+  .auth_info_sqn       = hss_mysql_auth_info_sqn,
+  .push_rand_sqn       = hss_mysql_push_rand_sqn,
+  .increment_sqn       = hss_mysql_increment_sqn,
+  .check_opc_keys      = hss_mysql_check_opc_keys,
+};
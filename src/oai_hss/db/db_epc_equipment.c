@@ -39,49 +39,44 @@ hss_mysql_query_mmeidentity (
   const int id_mme_identity,
   mysql_mme_identity_t * mme_identity_p)
 {
-  MYSQL_RES                              *res;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
-
-  if ((db_desc->db_conn == NULL) || (mme_identity_p == NULL)) {
+  db_connection_t                        *connection;
+  MYSQL_BIND                              param;
+  MYSQL_BIND                              result[2];
+  my_bool                                 is_null[2] = {0};
+  unsigned long                           length[2] = {0};
+  uint32_t                                id = id_mme_identity;
+  int                                     status;
+
+  if (mme_identity_p == NULL) {
     return EINVAL;
   }
 
   memset (mme_identity_p, 0, sizeof (mysql_mme_identity_t));
-  sprintf (query, "SELECT mmehost,mmerealm FROM mmeidentity WHERE " "mmeidentity.idmmeidentity='%d' ", id_mme_identity);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  FPRINTF_DEBUG ("Query: %s (%d)\n", "SELECT mmehost,mmerealm FROM mmeidentity", id_mme_identity);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    FPRINTF_ERROR ("Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
+  hss_mysql_bind (&param, MYSQL_TYPE_LONG, &id, 0, NULL, NULL);
+  hss_mysql_bind (&result[0], MYSQL_TYPE_STRING, mme_identity_p->mme_host, sizeof (mme_identity_p->mme_host), &length[0], &is_null[0]);
+  hss_mysql_bind (&result[1], MYSQL_TYPE_STRING, mme_identity_p->mme_realm, sizeof (mme_identity_p->mme_realm), &length[1], &is_null[1]);
 
-  if ( res == NULL )
+  if (hss_mysql_stmt_execute (connection, DB_STMT_QUERY_MMEIDENTITY, &param, result)) {
+    hss_mysql_connection_put (connection);
     return EINVAL;
+  }
 
-  if ((row = mysql_fetch_row (res)) != NULL) {
-    if (row[0] != NULL) {
-      memcpy (mme_identity_p->mme_host, row[0], strlen (row[0]));
-    } else {
-      mme_identity_p->mme_host[0] = '\0';
-    }
-
-    if (row[1] != NULL) {
-      memcpy (mme_identity_p->mme_realm, row[1], strlen (row[1]));
-    } else {
-      mme_identity_p->mme_realm[0] = '\0';
-    }
+  status = mysql_stmt_fetch (connection->stmt[DB_STMT_QUERY_MMEIDENTITY]);
+  mysql_stmt_free_result (connection->stmt[DB_STMT_QUERY_MMEIDENTITY]);
+  hss_mysql_connection_put (connection);
 
-    mysql_free_result (res);
+  if ((status == 0) || (status == MYSQL_DATA_TRUNCATED)) {
+    hss_mysql_string_end (mme_identity_p->mme_host, sizeof (mme_identity_p->mme_host), length[0], is_null[0]);
+    hss_mysql_string_end (mme_identity_p->mme_realm, sizeof (mme_identity_p->mme_realm), length[1], is_null[1]);
     return 0;
   }
 
-  mysql_free_result (res);
   return EINVAL;
 }
 
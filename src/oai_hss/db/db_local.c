@@ -0,0 +1,1595 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Local storage backend (DB_backend = "local"): the subscribers are held in memory,
+ * indexed by IMSI, and every change is appended to a log file (LOCAL_db_file).
+ *
+ * The log is a header followed by records: a full subscriber with its PDNs, the SQN
+ * and RAND of a subscriber, or a known MME. At startup the log is mapped and replayed,
+ * the last record torn by a crash is truncated, any other invalid record stops the
+ * startup. The log is rewritten with one record per subscriber when it is more than
+ * twice that size, at startup and by the request that crosses the limit. An empty store
+ * is filled from LOCAL_db_import, a MySQL dump of the HSS database such as oai_db.sql.
+ *
+ * The records are written to the page cache, not synced: they survive a crash of the
+ * HSS but a crash of the host loses the ones not yet written back by the kernel (up to
+ * vm.dirty_expire_centisecs, 30 s by default). A lost SQN is detected by the UE and
+ * recovered by a resynchronisation. The rewritten log is synced before it replaces the
+ * current one.
+ *
+ * The subscribers are only created at startup, the table is not locked by the requests.
+ * The records are written with the lock of the subscriber, in the order of the changes.
+ * The rewrite at run time holds the MME lock and every subscriber lock.
+ * Records store the structures of this build, the header rejects a log of another layout.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+#include "s6a_proto.h"
+
+extern void                             ComputeOPc (
+  const uint8_t const kP[16],
+  const uint8_t const opP[16],
+  uint8_t opcP[16]);
+
+#define HSS_LOCAL_MAGIC               "OAIHSSDB"
+#define HSS_LOCAL_VERSION             (1)
+#define HSS_LOCAL_LOCKS               (64)
+/* LIMIT of DB_STMT_QUERY_PDNS */
+#define HSS_LOCAL_PDNS_MAX            (10)
+#define HSS_LOCAL_MMES_MAX            (256)
+/* The log is not rewritten below this size */
+#define HSS_LOCAL_COMPACT_MIN_SIZE    (1 << 20)
+/* 2 ^ sizeof(IND) (see 3GPP TS. 33.102) */
+#define HSS_LOCAL_SQN_STEP            (32)
+
+/* SQL dump import */
+#define HSS_LOCAL_SQL_TABLES_MAX      (16)
+#define HSS_LOCAL_SQL_COLUMNS_MAX     (32)
+#define HSS_LOCAL_SQL_NAME_MAX        (64)
+#define HSS_LOCAL_SQL_ROW_MAX         (16384)
+
+typedef enum {
+  HSS_LOCAL_REC_USER = 1,
+  HSS_LOCAL_REC_SQN,
+  HSS_LOCAL_REC_MME,
+} hss_local_rec_type_t;
+
+typedef struct hss_local_header_s {
+  char                                    magic[8];
+  uint32_t                                version;
+  uint32_t                                user_size;
+  uint32_t                                pdn_size;
+  uint32_t                                sqn_size;
+} hss_local_header_t;
+
+typedef struct hss_local_rec_hdr_s {
+  uint32_t                                type;
+  uint32_t                                length;
+  /* FNV-1a of the payload */
+  uint32_t                                checksum;
+} hss_local_rec_hdr_t;
+
+/* Followed by nb_pdns mysql_pdn_t in a HSS_LOCAL_REC_USER record */
+typedef struct hss_local_user_rec_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  char                                    msisdn[16];
+  char                                    imei[IMEI_LENGTH_MAX + 1];
+  char                                    imei_sv[2 + 1];
+  uint8_t                                 key[KEY_LENGTH];
+  uint8_t                                 opc[KEY_LENGTH];
+  uint8_t                                 rand[RAND_LENGTH];
+  uint64_t                                sqn;
+  uint32_t                                access_restriction;
+  uint32_t                                rau_tau;
+  uint32_t                                aggr_ul;
+  uint32_t                                aggr_dl;
+  uint32_t                                purged;
+  uint32_t                                nb_pdns;
+  mysql_mme_identity_t                    mme_identity;
+} hss_local_user_rec_t;
+
+typedef struct hss_local_sqn_rec_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 rand[RAND_LENGTH];
+  uint64_t                                sqn;
+} hss_local_sqn_rec_t;
+
+typedef struct hss_local_user_s {
+  hss_local_user_rec_t                    rec;
+  mysql_pdn_t                             pdns[HSS_LOCAL_PDNS_MAX];
+  struct hss_local_user_s                *next;
+} hss_local_user_t;
+
+static struct {
+  char                                   *file;
+  int                                     fd;
+  /* Size of the log, rewritten when it reaches compact_at */
+  volatile off_t                          size;
+  off_t                                   compact_at;
+  volatile int                            compacting;
+  uint32_t                                nb_buckets;
+  uint32_t                                nb_users;
+  hss_local_user_t                      **buckets;
+  /* A lock protects the subscribers of the buckets equal to its index modulo HSS_LOCAL_LOCKS */
+  pthread_mutex_t                         locks[HSS_LOCAL_LOCKS];
+  pthread_mutex_t                         mme_lock;
+  int                                     nb_mmes;
+  mysql_mme_identity_t                    mmes[HSS_LOCAL_MMES_MAX];
+} hss_local = {.fd = -1};
+
+/*
+ * Tables of the SQL dump, the rows of users and pdn are joined once the file is read
+ */
+typedef struct hss_local_sql_table_s {
+  char                                    name[HSS_LOCAL_SQL_NAME_MAX];
+  int                                     nb_columns;
+  char                                    columns[HSS_LOCAL_SQL_COLUMNS_MAX][HSS_LOCAL_SQL_NAME_MAX];
+} hss_local_sql_table_t;
+
+typedef struct hss_local_sql_value_s {
+  const char                             *data;
+  size_t                                  length;
+  int                                     is_null;
+} hss_local_sql_value_t;
+
+typedef struct hss_local_import_s {
+  int                                     nb_tables;
+  hss_local_sql_table_t                   tables[HSS_LOCAL_SQL_TABLES_MAX];
+  /* mmeidentity rows, with their id */
+  int                                     nb_mmes;
+  int                                     mme_ids[HSS_LOCAL_MMES_MAX];
+  mysql_mme_identity_t                    mmes[HSS_LOCAL_MMES_MAX];
+  /* pdn rows, added to their subscriber after the users rows */
+  size_t                                  nb_pdns;
+  size_t                                  max_pdns;
+  char                                  (*pdn_imsis)[IMSI_LENGTH_MAX + 1];
+  mysql_pdn_t                            *pdns;
+} hss_local_import_t;
+
+static uint32_t
+hss_local_fnv (
+  uint32_t h,
+  const void *data,
+  size_t length)
+{
+  const uint8_t                          *p = data;
+
+  while (length--) {
+    h = (h ^ *p++) * 16777619u;
+  }
+  return h;
+}
+
+static uint32_t
+hss_local_bucket (
+  const char *imsi)
+{
+  return hss_local_fnv (2166136261u, imsi, strlen (imsi)) & (hss_local.nb_buckets - 1);
+}
+
+static pthread_mutex_t *
+hss_local_lock (
+  const hss_local_user_t * user)
+{
+  return &hss_local.locks[hss_local_bucket (user->rec.imsi) % HSS_LOCAL_LOCKS];
+}
+
+static hss_local_user_t *
+hss_local_find (
+  const char *imsi)
+{
+  hss_local_user_t                       *user;
+
+  if ((imsi == NULL) || (hss_local.buckets == NULL)) {
+    return NULL;
+  }
+
+  for (user = hss_local.buckets[hss_local_bucket (imsi)]; user; user = user->next) {
+    if (strcmp (user->rec.imsi, imsi) == 0) {
+      return user;
+    }
+  }
+  return NULL;
+}
+
+/*
+ * Startup only, the table grows with the number of subscribers
+ */
+static hss_local_user_t *
+hss_local_add (
+  const char *imsi)
+{
+  hss_local_user_t                       *user;
+  hss_local_user_t                      **buckets;
+  uint32_t                                nb_buckets;
+  uint32_t                                i;
+
+  if (hss_local.nb_users >= hss_local.nb_buckets) {
+    nb_buckets = hss_local.nb_buckets ? hss_local.nb_buckets << 1 : 1024;
+
+    if ((buckets = calloc (nb_buckets, sizeof (hss_local_user_t *))) == NULL) {
+      return NULL;
+    }
+
+    for (i = 0; i < hss_local.nb_buckets; i++) {
+      while ((user = hss_local.buckets[i]) != NULL) {
+        uint32_t                                bucket = hss_local_fnv (2166136261u, user->rec.imsi, strlen (user->rec.imsi)) & (nb_buckets - 1);
+
+        hss_local.buckets[i] = user->next;
+        user->next = buckets[bucket];
+        buckets[bucket] = user;
+      }
+    }
+    free (hss_local.buckets);
+    hss_local.buckets = buckets;
+    hss_local.nb_buckets = nb_buckets;
+  }
+
+  if ((user = calloc (1, sizeof (hss_local_user_t))) == NULL) {
+    return NULL;
+  }
+  strcpy (user->rec.imsi, imsi);
+  user->next = hss_local.buckets[hss_local_bucket (imsi)];
+  hss_local.buckets[hss_local_bucket (imsi)] = user;
+  hss_local.nb_users++;
+  return user;
+}
+
+static int
+hss_local_write (
+  int fd,
+  hss_local_rec_type_t type,
+  const void *data,
+  size_t length,
+  const void *data2,
+  size_t length2)
+{
+  hss_local_rec_hdr_t                     hdr;
+  struct iovec                            iov[3];
+  ssize_t                                 written;
+
+  hdr.type = type;
+  hdr.length = length + length2;
+  hdr.checksum = hss_local_fnv (hss_local_fnv (2166136261u, data, length), data2, length2);
+  iov[0].iov_base = &hdr;
+  iov[0].iov_len = sizeof (hdr);
+  iov[1].iov_base = (void *)data;
+  iov[1].iov_len = length;
+  iov[2].iov_base = (void *)data2;
+  iov[2].iov_len = length2;
+
+  /*
+   * O_APPEND, one writev is one record even with concurrent writers
+   */
+  written = writev (fd, iov, 3);
+
+  if (written != (ssize_t) (sizeof (hdr) + length + length2)) {
+    FPRINTF_ERROR ("Cannot write %s: %s\n", hss_local.file, (written < 0) ? strerror (errno) : "short write");
+    return EIO;
+  }
+  __sync_fetch_and_add (&hss_local.size, written);
+  return 0;
+}
+
+/*
+ * Called with the lock of the subscriber
+ */
+static int
+hss_local_write_user (
+  int fd,
+  hss_local_user_t * user)
+{
+  return hss_local_write (fd, HSS_LOCAL_REC_USER, &user->rec, sizeof (user->rec), user->pdns, user->rec.nb_pdns * sizeof (mysql_pdn_t));
+}
+
+/*
+ * Called with the lock of the subscriber
+ */
+static int
+hss_local_write_sqn (
+  hss_local_user_t * user)
+{
+  hss_local_sqn_rec_t                     rec;
+
+  memset (&rec, 0, sizeof (rec));
+  strcpy (rec.imsi, user->rec.imsi);
+  memcpy (rec.rand, user->rec.rand, RAND_LENGTH);
+  rec.sqn = user->rec.sqn;
+  return hss_local_write (hss_local.fd, HSS_LOCAL_REC_SQN, &rec, sizeof (rec), NULL, 0);
+}
+
+static int
+hss_local_write_header (
+  int fd)
+{
+  hss_local_header_t                      header;
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, HSS_LOCAL_MAGIC, sizeof (header.magic));
+  header.version = HSS_LOCAL_VERSION;
+  header.user_size = sizeof (hss_local_user_rec_t);
+  header.pdn_size = sizeof (mysql_pdn_t);
+  header.sqn_size = sizeof (hss_local_sqn_rec_t);
+  return (write (fd, &header, sizeof (header)) == sizeof (header)) ? 0 : EIO;
+}
+
+/*
+ * Called with the MME lock or at startup
+ */
+static int
+hss_local_mme_known (
+  const char *mme_host)
+{
+  int                                     i;
+
+  for (i = 0; i < hss_local.nb_mmes; i++) {
+    if (strcmp (hss_local.mmes[i].mme_host, mme_host) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void
+hss_local_mme_add (
+  const mysql_mme_identity_t * mme_identity_p,
+  int fd)
+{
+  pthread_mutex_lock (&hss_local.mme_lock);
+
+  if ((mme_identity_p->mme_host[0] != '\0') && !hss_local_mme_known (mme_identity_p->mme_host) && (hss_local.nb_mmes < HSS_LOCAL_MMES_MAX)) {
+    hss_local.mmes[hss_local.nb_mmes++] = *mme_identity_p;
+
+    if (fd >= 0) {
+      hss_local_write (fd, HSS_LOCAL_REC_MME, mme_identity_p, sizeof (mysql_mme_identity_t), NULL, 0);
+    }
+  }
+  pthread_mutex_unlock (&hss_local.mme_lock);
+}
+
+static int
+hss_local_replay_record (
+  const hss_local_rec_hdr_t * hdr,
+  const uint8_t * data)
+{
+  const hss_local_user_rec_t             *user_rec = (const hss_local_user_rec_t *)data;
+  const hss_local_sqn_rec_t              *sqn_rec = (const hss_local_sqn_rec_t *)data;
+  hss_local_user_t                       *user;
+
+  switch (hdr->type) {
+  case HSS_LOCAL_REC_USER:
+    if ((hdr->length < sizeof (hss_local_user_rec_t)) || (user_rec->nb_pdns > HSS_LOCAL_PDNS_MAX)
+        || (hdr->length != sizeof (hss_local_user_rec_t) + user_rec->nb_pdns * sizeof (mysql_pdn_t))
+        || (memchr (user_rec->imsi, '\0', sizeof (user_rec->imsi)) == NULL)) {
+      return EINVAL;
+    }
+
+    if (((user = hss_local_find (user_rec->imsi)) == NULL) && ((user = hss_local_add (user_rec->imsi)) == NULL)) {
+      return ENOMEM;
+    }
+    memcpy (&user->rec, user_rec, sizeof (hss_local_user_rec_t));
+    memcpy (user->pdns, data + sizeof (hss_local_user_rec_t), user_rec->nb_pdns * sizeof (mysql_pdn_t));
+    return 0;
+
+  case HSS_LOCAL_REC_SQN:
+    if ((hdr->length != sizeof (hss_local_sqn_rec_t)) || (memchr (sqn_rec->imsi, '\0', sizeof (sqn_rec->imsi)) == NULL)) {
+      return EINVAL;
+    }
+
+    if ((user = hss_local_find (sqn_rec->imsi)) != NULL) {
+      memcpy (user->rec.rand, sqn_rec->rand, RAND_LENGTH);
+      user->rec.sqn = sqn_rec->sqn;
+    }
+    return 0;
+
+  case HSS_LOCAL_REC_MME:
+    if (hdr->length != sizeof (mysql_mme_identity_t)) {
+      return EINVAL;
+    }
+    hss_local_mme_add ((const mysql_mme_identity_t *)data, -1);
+    return 0;
+
+  default:
+    return EINVAL;
+  }
+}
+
+/*
+ * Size of the log rewritten with one record per subscriber
+ */
+static off_t
+hss_local_live_size (
+  void)
+{
+  off_t                                   live_size;
+  hss_local_user_t                       *user;
+  uint32_t                                i;
+
+  live_size = sizeof (hss_local_header_t) + hss_local.nb_mmes * (sizeof (hss_local_rec_hdr_t) + sizeof (mysql_mme_identity_t));
+
+  for (i = 0; i < hss_local.nb_buckets; i++) {
+    for (user = hss_local.buckets[i]; user; user = user->next) {
+      live_size += sizeof (hss_local_rec_hdr_t) + sizeof (hss_local_user_rec_t) + user->rec.nb_pdns * sizeof (mysql_pdn_t);
+    }
+  }
+  return live_size;
+}
+
+/*
+ * A record that cannot be read is the tail torn by a crash if nothing valid can follow it:
+ * it runs past the end of the log, or the rest of the log is zeros (size extended before
+ * the data reached the disk).
+ */
+static int
+hss_local_is_torn_tail (
+  const uint8_t * map,
+  off_t offset,
+  off_t size,
+  const hss_local_rec_hdr_t * hdr)
+{
+  if ((offset + (off_t) sizeof (*hdr) > size) || (offset + (off_t) sizeof (*hdr) + hdr->length >= size)) {
+    return 1;
+  }
+
+  for (; offset < size; offset++) {
+    if (map[offset]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Read the log, a torn tail is truncated.
+ * *live_size is the size of the log rewritten with one record per subscriber.
+ */
+static int
+hss_local_replay (
+  off_t * live_size)
+{
+  struct stat                             st;
+  const uint8_t                          *map;
+  const hss_local_header_t               *header;
+  hss_local_rec_hdr_t                     hdr;
+  /* Records are not aligned in the log */
+  union {
+    hss_local_user_rec_t                    user;
+    hss_local_sqn_rec_t                     sqn;
+    mysql_mme_identity_t                    mme;
+    uint8_t                                 data[sizeof (hss_local_user_rec_t) + HSS_LOCAL_PDNS_MAX * sizeof (mysql_pdn_t)];
+  }                                       record;
+  off_t                                   offset;
+  uint32_t                                nb_records = 0;
+  int                                     ret = 0;
+
+  if (fstat (hss_local.fd, &st) < 0) {
+    return errno;
+  }
+
+  if (st.st_size == 0) {
+    *live_size = 0;
+    return hss_local_write_header (hss_local.fd);
+  }
+
+  if ((size_t) st.st_size < sizeof (hss_local_header_t)) {
+    FPRINTF_ERROR ("%s is not a HSS local database\n", hss_local.file);
+    return EINVAL;
+  }
+
+  if ((map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, hss_local.fd, 0)) == MAP_FAILED) {
+    FPRINTF_ERROR ("Cannot map %s: %s\n", hss_local.file, strerror (errno));
+    return errno;
+  }
+  madvise ((void *)map, st.st_size, MADV_SEQUENTIAL);
+  header = (const hss_local_header_t *)map;
+
+  if (memcmp (header->magic, HSS_LOCAL_MAGIC, sizeof (header->magic)) || (header->version != HSS_LOCAL_VERSION)
+      || (header->user_size != sizeof (hss_local_user_rec_t)) || (header->pdn_size != sizeof (mysql_pdn_t))
+      || (header->sqn_size != sizeof (hss_local_sqn_rec_t))) {
+    FPRINTF_ERROR ("%s is not a HSS local database of this version\n", hss_local.file);
+    munmap ((void *)map, st.st_size);
+    return EINVAL;
+  }
+
+  for (offset = sizeof (hss_local_header_t); offset < st.st_size; nb_records++) {
+    memset (&hdr, 0, sizeof (hdr));
+    memcpy (&hdr, map + offset, (offset + (off_t) sizeof (hdr) <= st.st_size) ? sizeof (hdr) : (size_t) (st.st_size - offset));
+
+    if ((offset + (off_t) sizeof (hdr) > st.st_size) || (offset + (off_t) sizeof (hdr) + hdr.length > st.st_size) || (hdr.length > sizeof (record))
+        || (hss_local_fnv (2166136261u, map + offset + sizeof (hdr), hdr.length) != hdr.checksum)) {
+      if (!hss_local_is_torn_tail (map, offset, st.st_size, &hdr)) {
+        FPRINTF_ERROR ("%s: invalid record at offset %jd, followed by %jd bytes\n", hss_local.file, (intmax_t) offset, (intmax_t) (st.st_size - offset));
+        ret = EINVAL;
+      }
+      break;
+    }
+    memcpy (record.data, map + offset + sizeof (hdr), hdr.length);
+
+    /*
+     * A record with a valid checksum is not torn: the log is not truncated
+     */
+    if ((ret = hss_local_replay_record (&hdr, record.data)) != 0) {
+      FPRINTF_ERROR ("%s: cannot replay record at offset %jd: %s\n", hss_local.file, (intmax_t) offset, strerror (ret));
+      break;
+    }
+    offset += sizeof (hdr) + hdr.length;
+  }
+  munmap ((void *)map, st.st_size);
+
+  if (ret) {
+    return ret;
+  }
+
+  if (offset != st.st_size) {
+    FPRINTF_ERROR ("%s: %jd bytes of a torn record dropped\n", hss_local.file, (intmax_t) (st.st_size - offset));
+
+    if (ftruncate (hss_local.fd, offset) < 0) {
+      return errno;
+    }
+  }
+  *live_size = hss_local_live_size ();
+  FPRINTF_NOTICE ("%s: %u records, %u subscribers, %d MMEs\n", hss_local.file, nb_records, hss_local.nb_users, hss_local.nb_mmes);
+  return 0;
+}
+
+/*
+ * Size of the log and its limit, called at startup or with every lock held.
+ * After a failed rewrite the limit moves on, the log is not rewritten again on each record.
+ */
+static void
+hss_local_set_compact_at (
+  void)
+{
+  struct stat                             st;
+  off_t                                   live_size = hss_local_live_size ();
+
+  if (fstat (hss_local.fd, &st) == 0) {
+    hss_local.size = st.st_size;
+  }
+  hss_local.compact_at = (2 * live_size > HSS_LOCAL_COMPACT_MIN_SIZE) ? 2 * live_size : HSS_LOCAL_COMPACT_MIN_SIZE;
+
+  if (hss_local.size >= hss_local.compact_at) {
+    hss_local.compact_at = hss_local.size + HSS_LOCAL_COMPACT_MIN_SIZE;
+  }
+}
+
+/*
+ * Write the log again with one record per subscriber, replace the current one
+ */
+static int
+hss_local_compact (
+  void)
+{
+  char                                   *tmp_file;
+  hss_local_user_t                       *user;
+  int                                     fd;
+  int                                     ret = 0;
+  int                                     i;
+  uint32_t                                bucket;
+
+  if ((tmp_file = malloc (strlen (hss_local.file) + sizeof (".tmp"))) == NULL) {
+    return ENOMEM;
+  }
+  sprintf (tmp_file, "%s.tmp", hss_local.file);
+
+  if ((fd = open (tmp_file, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600)) < 0) {
+    FPRINTF_ERROR ("Cannot create %s: %s\n", tmp_file, strerror (errno));
+    free (tmp_file);
+    return errno;
+  }
+  ret = hss_local_write_header (fd);
+
+  for (i = 0; (ret == 0) && (i < hss_local.nb_mmes); i++) {
+    ret = hss_local_write (fd, HSS_LOCAL_REC_MME, &hss_local.mmes[i], sizeof (mysql_mme_identity_t), NULL, 0);
+  }
+
+  for (bucket = 0; (ret == 0) && (bucket < hss_local.nb_buckets); bucket++) {
+    for (user = hss_local.buckets[bucket]; (ret == 0) && user; user = user->next) {
+      ret = hss_local_write_user (fd, user);
+    }
+  }
+
+  if ((ret == 0) && ((fsync (fd) < 0) || (rename (tmp_file, hss_local.file) < 0))) {
+    FPRINTF_ERROR ("Cannot replace %s: %s\n", hss_local.file, strerror (errno));
+    ret = errno;
+  }
+
+  if (ret) {
+    close (fd);
+    unlink (tmp_file);
+  } else {
+    close (hss_local.fd);
+    hss_local.fd = fd;
+  }
+  free (tmp_file);
+  hss_local_set_compact_at ();
+  return ret;
+}
+
+/*
+ * Called by a request without lock once the log reached its limit: the log is rewritten
+ * with every subscriber lock held, the requests wait for the rewrite.
+ */
+static void
+hss_local_compact_if_needed (
+  void)
+{
+  int                                     i;
+
+  if ((hss_local.size < hss_local.compact_at) || !__sync_bool_compare_and_swap (&hss_local.compacting, 0, 1)) {
+    return;
+  }
+  pthread_mutex_lock (&hss_local.mme_lock);
+
+  for (i = 0; i < HSS_LOCAL_LOCKS; i++) {
+    pthread_mutex_lock (&hss_local.locks[i]);
+  }
+
+  /*
+   * Another request may have rewritten it before the locks were taken
+   */
+  if ((hss_local.size >= hss_local.compact_at) && (hss_local_compact () != 0)) {
+    FPRINTF_ERROR ("%s: rewrite failed, the log keeps growing\n", hss_local.file);
+  }
+
+  for (i = HSS_LOCAL_LOCKS - 1; i >= 0; i--) {
+    pthread_mutex_unlock (&hss_local.locks[i]);
+  }
+  pthread_mutex_unlock (&hss_local.mme_lock);
+  hss_local.compacting = 0;
+}
+
+/*
+ * SQL dump import
+ */
+static const char *
+hss_local_sql_skip_spaces (
+  const char *p,
+  const char *end)
+{
+  while ((p < end) && ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n'))) {
+    p++;
+  }
+  return p;
+}
+
+/*
+ * `name` at p, copied in name, returns the position after it or NULL
+ */
+static const char *
+hss_local_sql_name (
+  const char *p,
+  const char *end,
+  char *name)
+{
+  const char                             *start;
+
+  if ((p >= end) || (*p != '`')) {
+    return NULL;
+  }
+
+  for (start = ++p; (p < end) && (*p != '`'); p++);
+
+  if ((p >= end) || (p - start >= HSS_LOCAL_SQL_NAME_MAX)) {
+    return NULL;
+  }
+  memcpy (name, start, p - start);
+  name[p - start] = '\0';
+  return p + 1;
+}
+
+static int
+hss_local_sql_starts (
+  const char *p,
+  const char *end,
+  const char *keyword)
+{
+  size_t                                  length = strlen (keyword);
+
+  return ((size_t) (end - p) >= length) && (strncasecmp (p, keyword, length) == 0);
+}
+
+static hss_local_sql_table_t *
+hss_local_sql_table (
+  hss_local_import_t * import,
+  const char *name)
+{
+  int                                     i;
+
+  for (i = 0; i < import->nb_tables; i++) {
+    if (strcmp (import->tables[i].name, name) == 0) {
+      return &import->tables[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+ * CREATE TABLE `name` ( with a column definition per line starting with its name
+ */
+static const char *
+hss_local_sql_create (
+  hss_local_import_t * import,
+  const char *p,
+  const char *end)
+{
+  hss_local_sql_table_t                  *table;
+  char                                    name[HSS_LOCAL_SQL_NAME_MAX];
+
+  p = hss_local_sql_skip_spaces (p + strlen ("CREATE TABLE"), end);
+
+  if ((p = hss_local_sql_name (p, end, name)) == NULL) {
+    return NULL;
+  }
+
+  if ((table = hss_local_sql_table (import, name)) == NULL) {
+    if (import->nb_tables == HSS_LOCAL_SQL_TABLES_MAX) {
+      return NULL;
+    }
+    table = &import->tables[import->nb_tables++];
+    strcpy (table->name, name);
+  }
+  table->nb_columns = 0;
+
+  while ((p = memchr (p, '\n', end - p)) != NULL) {
+    p = hss_local_sql_skip_spaces (p, end);
+
+    if ((p >= end) || (*p != '`')) {
+      break;
+    }
+
+    if ((table->nb_columns == HSS_LOCAL_SQL_COLUMNS_MAX) || ((p = hss_local_sql_name (p, end, table->columns[table->nb_columns++])) == NULL)) {
+      return NULL;
+    }
+  }
+  return p ? p : end;
+}
+
+static const char *
+hss_local_sql_value (
+  const char *p,
+  const char *end,
+  hss_local_sql_value_t * value,
+  char **buffer,
+  const char *buffer_end)
+{
+  char                                   *out = *buffer;
+  const char                             *start;
+
+  memset (value, 0, sizeof (*value));
+
+  if (hss_local_sql_starts (p, end, "NULL")) {
+    value->is_null = 1;
+    return p + 4;
+  }
+
+  if (hss_local_sql_starts (p, end, "_binary")) {
+    p = hss_local_sql_skip_spaces (p + 7, end);
+  }
+
+  if ((p < end) && (*p == '\'')) {
+    for (p++; p < end; p++) {
+      char                                    c = *p;
+
+      if (out == buffer_end) {
+        return NULL;
+      }
+
+      if (c == '\'') {
+        if ((p + 1 < end) && (p[1] == '\'')) {
+          *out++ = '\'';
+          p++;
+          continue;
+        }
+        break;
+      }
+
+      if ((c == '\\') && (p + 1 < end)) {
+        switch (*++p) {
+        case '0': c = '\0'; break;
+        case 'b': c = '\b'; break;
+        case 'n': c = '\n'; break;
+        case 'r': c = '\r'; break;
+        case 't': c = '\t'; break;
+        case 'Z': c = 0x1a; break;
+        default:  c = *p; break;
+        }
+      }
+      *out++ = c;
+    }
+
+    if (p >= end) {
+      return NULL;
+    }
+    p++;
+  } else if (hss_local_sql_starts (p, end, "0x")) {
+    for (p += 2; (p + 1 < end) && (out < buffer_end); p += 2) {
+      unsigned int                            byte;
+
+      if (sscanf (p, "%2x", &byte) != 1) {
+        break;
+      }
+      *out++ = byte;
+    }
+  } else {
+    for (start = p; (p < end) && (*p != ',') && (*p != ')'); p++);
+
+    if ((size_t) (buffer_end - out) < (size_t) (p - start)) {
+      return NULL;
+    }
+    memcpy (out, start, p - start);
+    out += p - start;
+  }
+
+  value->data = *buffer;
+  value->length = out - *buffer;
+
+  /*
+   * NUL terminated for the conversions, not counted in the length
+   */
+  if (out == buffer_end) {
+    return NULL;
+  }
+  *out++ = '\0';
+  *buffer = out;
+  return p;
+}
+
+static const hss_local_sql_value_t *
+hss_local_sql_column (
+  const hss_local_sql_table_t * table,
+  const int *columns,
+  int nb_values,
+  const hss_local_sql_value_t * values,
+  const char *name)
+{
+  int                                     i;
+
+  for (i = 0; i < nb_values; i++) {
+    if (strcasecmp (table->columns[columns[i]], name) == 0) {
+      return &values[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+hss_local_sql_string (
+  char *string,
+  size_t size,
+  const hss_local_sql_value_t * value,
+  const char *default_value)
+{
+  const char                             *data = ((value == NULL) || value->is_null) ? default_value : value->data;
+
+  snprintf (string, size, "%s", data);
+}
+
+static unsigned long long
+hss_local_sql_number (
+  const hss_local_sql_value_t * value,
+  unsigned long long default_value)
+{
+  return ((value == NULL) || value->is_null) ? default_value : strtoull (value->data, NULL, 10);
+}
+
+static void
+hss_local_sql_bytes (
+  uint8_t * bytes,
+  size_t size,
+  const hss_local_sql_value_t * value)
+{
+  memset (bytes, 0, size);
+
+  if ((value != NULL) && !value->is_null) {
+    memcpy (bytes, value->data, (value->length < size) ? value->length : size);
+  }
+}
+
+static int
+hss_local_sql_row (
+  hss_local_import_t * import,
+  const hss_local_sql_table_t * table,
+  const int *columns,
+  int nb_values,
+  const hss_local_sql_value_t * values)
+{
+#define COLUMN(nAME) hss_local_sql_column (table, columns, nb_values, values, nAME)
+  hss_local_user_t                       *user;
+  mysql_pdn_t                            *pdn;
+  char                                    imsi[IMSI_LENGTH_MAX + 2];
+  char                                    pdn_type[16];
+  char                                    pre_emp_cap[16];
+  char                                    pre_emp_vul[16];
+  char                                    ms_ps_status[16];
+
+  if (strcmp (table->name, "mmeidentity") == 0) {
+    if (import->nb_mmes == HSS_LOCAL_MMES_MAX) {
+      return 0;
+    }
+    import->mme_ids[import->nb_mmes] = hss_local_sql_number (COLUMN ("idmmeidentity"), 0);
+    hss_local_sql_string (import->mmes[import->nb_mmes].mme_host, sizeof (import->mmes[0].mme_host), COLUMN ("mmehost"), "");
+    hss_local_sql_string (import->mmes[import->nb_mmes].mme_realm, sizeof (import->mmes[0].mme_realm), COLUMN ("mmerealm"), "");
+    import->nb_mmes++;
+  } else if (strcmp (table->name, "users") == 0) {
+    hss_local_sql_string (imsi, sizeof (imsi), COLUMN ("imsi"), "");
+
+    if ((imsi[0] == '\0') || (strlen (imsi) > IMSI_LENGTH_MAX)) {
+      return 0;
+    }
+
+    if (hss_local_find (imsi) != NULL) {
+      FPRINTF_NOTICE ("IMSI %s imported twice, first row kept\n", imsi);
+      return 0;
+    }
+
+    if ((user = hss_local_add (imsi)) == NULL) {
+      return ENOMEM;
+    }
+    hss_local_sql_string (user->rec.msisdn, sizeof (user->rec.msisdn), COLUMN ("msisdn"), "");
+    hss_local_sql_string (user->rec.imei, sizeof (user->rec.imei), COLUMN ("imei"), "");
+    hss_local_sql_string (user->rec.imei_sv, sizeof (user->rec.imei_sv), COLUMN ("imei_sv"), "");
+    hss_local_sql_string (ms_ps_status, sizeof (ms_ps_status), COLUMN ("ms_ps_status"), "PURGED");
+    user->rec.purged = (strcmp (ms_ps_status, "NOT_PURGED") != 0);
+    user->rec.rau_tau = hss_local_sql_number (COLUMN ("rau_tau_timer"), 120);
+    user->rec.aggr_ul = hss_local_sql_number (COLUMN ("ue_ambr_ul"), 50000000);
+    user->rec.aggr_dl = hss_local_sql_number (COLUMN ("ue_ambr_dl"), 100000000);
+    user->rec.access_restriction = hss_local_sql_number (COLUMN ("access_restriction"), 60);
+    user->rec.sqn = hss_local_sql_number (COLUMN ("sqn"), 0);
+    hss_local_sql_bytes (user->rec.key, KEY_LENGTH, COLUMN ("key"));
+    hss_local_sql_bytes (user->rec.rand, RAND_LENGTH, COLUMN ("rand"));
+    hss_local_sql_bytes (user->rec.opc, KEY_LENGTH, COLUMN ("OPc"));
+    /*
+     * Identifier of the MME until the mmeidentity rows are known
+     */
+    snprintf (user->rec.mme_identity.mme_host, sizeof (user->rec.mme_identity.mme_host), "%llu",
+              hss_local_sql_number (COLUMN ("mmeidentity_idmmeidentity"), 0));
+  } else if (strcmp (table->name, "pdn") == 0) {
+    if (import->nb_pdns == import->max_pdns) {
+      size_t                                  max_pdns = import->max_pdns ? import->max_pdns * 2 : 1024;
+      void                                   *pdns = realloc (import->pdns, max_pdns * sizeof (mysql_pdn_t));
+      void                                   *imsis;
+
+      if (pdns == NULL) {
+        return ENOMEM;
+      }
+      import->pdns = pdns;
+
+      if ((imsis = realloc (import->pdn_imsis, max_pdns * sizeof (*import->pdn_imsis))) == NULL) {
+        return ENOMEM;
+      }
+      import->pdn_imsis = imsis;
+      import->max_pdns = max_pdns;
+    }
+    hss_local_sql_string (imsi, sizeof (imsi), COLUMN ("users_imsi"), "");
+
+    if ((imsi[0] == '\0') || (strlen (imsi) > IMSI_LENGTH_MAX)) {
+      return 0;
+    }
+    strcpy (import->pdn_imsis[import->nb_pdns], imsi);
+    pdn = &import->pdns[import->nb_pdns++];
+    memset (pdn, 0, sizeof (mysql_pdn_t));
+    hss_local_sql_string (pdn->apn, sizeof (pdn->apn), COLUMN ("apn"), "");
+    hss_local_sql_string (pdn_type, sizeof (pdn_type), COLUMN ("pdn_type"), "IPv4");
+    hss_local_sql_string (pre_emp_cap, sizeof (pre_emp_cap), COLUMN ("pre_emp_cap"), "DISABLED");
+    hss_local_sql_string (pre_emp_vul, sizeof (pre_emp_vul), COLUMN ("pre_emp_vul"), "DISABLED");
+    hss_mysql_pdn_set (pdn, pdn_type, COLUMN ("pdn_ipv4") && !COLUMN ("pdn_ipv4")->is_null ? COLUMN ("pdn_ipv4")->data : "0.0.0.0",
+                       COLUMN ("pdn_ipv6") && !COLUMN ("pdn_ipv6")->is_null ? COLUMN ("pdn_ipv6")->data : "0:0:0:0:0:0:0:0", pre_emp_cap, pre_emp_vul);
+    pdn->aggr_ul = hss_local_sql_number (COLUMN ("aggregate_ambr_ul"), 50000000);
+    pdn->aggr_dl = hss_local_sql_number (COLUMN ("aggregate_ambr_dl"), 100000000);
+    pdn->qci = hss_local_sql_number (COLUMN ("qci"), 9);
+    pdn->priority_level = hss_local_sql_number (COLUMN ("priority_level"), 15);
+  }
+  return 0;
+#undef COLUMN
+}
+
+/*
+ * INSERT INTO `name` [(`column`,...)] VALUES (...),(...);
+ */
+static const char *
+hss_local_sql_insert (
+  hss_local_import_t * import,
+  const char *p,
+  const char *end,
+  char *buffer)
+{
+  hss_local_sql_table_t                  *table;
+  hss_local_sql_value_t                   values[HSS_LOCAL_SQL_COLUMNS_MAX];
+  int                                     columns[HSS_LOCAL_SQL_COLUMNS_MAX];
+  int                                     nb_columns = 0;
+  int                                     nb_values;
+  char                                    name[HSS_LOCAL_SQL_NAME_MAX];
+  char                                   *out;
+  int                                     i;
+
+  p = hss_local_sql_skip_spaces (p + strlen ("INSERT INTO"), end);
+
+  if (((p = hss_local_sql_name (p, end, name)) == NULL) || ((table = hss_local_sql_table (import, name)) == NULL)) {
+    return NULL;
+  }
+  p = hss_local_sql_skip_spaces (p, end);
+
+  if ((p < end) && (*p == '(')) {
+    /*
+     * Explicit list of columns
+     */
+    do {
+      char                                    column[HSS_LOCAL_SQL_NAME_MAX];
+
+      p = hss_local_sql_skip_spaces (p + 1, end);
+
+      if ((nb_columns == HSS_LOCAL_SQL_COLUMNS_MAX) || ((p = hss_local_sql_name (p, end, column)) == NULL)) {
+        return NULL;
+      }
+
+      for (i = 0; (i < table->nb_columns) && strcmp (table->columns[i], column); i++);
+
+      if (i == table->nb_columns) {
+        return NULL;
+      }
+      columns[nb_columns++] = i;
+      p = hss_local_sql_skip_spaces (p, end);
+    } while ((p < end) && (*p == ','));
+
+    p = hss_local_sql_skip_spaces (p + 1, end);
+  } else {
+    for (nb_columns = 0; nb_columns < table->nb_columns; nb_columns++) {
+      columns[nb_columns] = nb_columns;
+    }
+  }
+
+  if (!hss_local_sql_starts (p, end, "VALUES")) {
+    return NULL;
+  }
+  p += strlen ("VALUES");
+
+  for (;;) {
+    p = hss_local_sql_skip_spaces (p, end);
+
+    if ((p >= end) || (*p != '(')) {
+      return NULL;
+    }
+    out = buffer;
+    nb_values = 0;
+
+    do {
+      p = hss_local_sql_skip_spaces (p + 1, end);
+
+      if ((nb_values == nb_columns) || ((p = hss_local_sql_value (p, end, &values[nb_values++], &out, buffer + HSS_LOCAL_SQL_ROW_MAX)) == NULL)) {
+        return NULL;
+      }
+      p = hss_local_sql_skip_spaces (p, end);
+    } while ((p < end) && (*p == ','));
+
+    if ((p >= end) || (*p != ')') || (nb_values != nb_columns) || hss_local_sql_row (import, table, columns, nb_values, values)) {
+      return NULL;
+    }
+    p = hss_local_sql_skip_spaces (p + 1, end);
+
+    if ((p < end) && (*p == ',')) {
+      p++;
+    } else if ((p < end) && (*p == ';')) {
+      return p + 1;
+    } else {
+      return NULL;
+    }
+  }
+}
+
+/*
+ * Fill the empty store with the users, pdn and mmeidentity tables of a MySQL dump
+ */
+static int
+hss_local_import (
+  const char *sql_file)
+{
+  hss_local_import_t                     *import;
+  hss_local_user_t                       *user;
+  struct stat                             st;
+  const char                             *map;
+  const char                             *p;
+  const char                             *end;
+  char                                   *buffer;
+  int                                     fd;
+  int                                     ret = 0;
+  uint32_t                                bucket;
+  size_t                                  i;
+  int                                     j;
+
+  if ((fd = open (sql_file, O_RDONLY | O_CLOEXEC)) < 0) {
+    FPRINTF_ERROR ("Cannot open %s: %s\n", sql_file, strerror (errno));
+    return errno;
+  }
+
+  if ((fstat (fd, &st) < 0) || (st.st_size == 0) || ((map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)) {
+    FPRINTF_ERROR ("Cannot map %s\n", sql_file);
+    close (fd);
+    return EINVAL;
+  }
+  close (fd);
+  import = calloc (1, sizeof (hss_local_import_t));
+  buffer = malloc (HSS_LOCAL_SQL_ROW_MAX);
+
+  if ((import == NULL) || (buffer == NULL)) {
+    ret = ENOMEM;
+    goto out;
+  }
+
+  /*
+   * Statements of interest start a line, the others are skipped line by line
+   */
+  for (p = map, end = map + st.st_size; p && (p < end);) {
+    p = hss_local_sql_skip_spaces (p, end);
+
+    if (hss_local_sql_starts (p, end, "CREATE TABLE")) {
+      p = hss_local_sql_create (import, p, end);
+    } else if (hss_local_sql_starts (p, end, "INSERT INTO")) {
+      p = hss_local_sql_insert (import, p, end, buffer);
+    } else if ((p = memchr (p, '\n', end - p)) != NULL) {
+      p++;
+      continue;
+    } else {
+      break;
+    }
+
+    if (p == NULL) {
+      FPRINTF_ERROR ("%s: cannot parse the dump\n", sql_file);
+      ret = EINVAL;
+      goto out;
+    }
+  }
+
+  /*
+   * Join the rows
+   */
+  for (bucket = 0; bucket < hss_local.nb_buckets; bucket++) {
+    for (user = hss_local.buckets[bucket]; user; user = user->next) {
+      int                                     mme_id = atoi (user->rec.mme_identity.mme_host);
+
+      memset (&user->rec.mme_identity, 0, sizeof (user->rec.mme_identity));
+
+      for (j = 0; (mme_id > 0) && (j < import->nb_mmes); j++) {
+        if (import->mme_ids[j] == mme_id) {
+          user->rec.mme_identity = import->mmes[j];
+          break;
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < import->nb_pdns; i++) {
+    if (((user = hss_local_find (import->pdn_imsis[i])) != NULL) && (user->rec.nb_pdns < HSS_LOCAL_PDNS_MAX)) {
+      user->pdns[user->rec.nb_pdns++] = import->pdns[i];
+    }
+  }
+
+  for (j = 0; j < import->nb_mmes; j++) {
+    hss_local_mme_add (&import->mmes[j], -1);
+  }
+  FPRINTF_NOTICE ("%s: %u subscribers, %zu PDNs, %d MMEs imported\n", sql_file, hss_local.nb_users, import->nb_pdns, import->nb_mmes);
+
+out:
+  munmap ((void *)map, st.st_size);
+
+  if (import) {
+    free (import->pdns);
+    free (import->pdn_imsis);
+  }
+  free (import);
+  free (buffer);
+  return ret;
+}
+
+static void
+hss_local_free (
+  void)
+{
+  hss_local_user_t                       *user;
+  uint32_t                                i;
+
+  for (i = 0; i < hss_local.nb_buckets; i++) {
+    while ((user = hss_local.buckets[i]) != NULL) {
+      hss_local.buckets[i] = user->next;
+      free (user);
+    }
+  }
+  free (hss_local.buckets);
+  hss_local.buckets = NULL;
+  hss_local.nb_buckets = 0;
+  hss_local.nb_users = 0;
+  hss_local.nb_mmes = 0;
+}
+
+static void
+hss_local_disconnect (
+  void)
+{
+  if (hss_local.fd >= 0) {
+    fsync (hss_local.fd);
+    close (hss_local.fd);
+    hss_local.fd = -1;
+  }
+  hss_local_free ();
+  free (hss_local.file);
+  hss_local.file = NULL;
+}
+
+static int
+hss_local_connect (
+  const hss_config_t * hss_config_p)
+{
+  off_t                                   live_size = 0;
+  struct stat                             st;
+  int                                     ret;
+  int                                     i;
+
+  if (hss_config_p->local_db_file == NULL) {
+    FPRINTF_ERROR ("LOCAL_db_file is not set\n");
+    return EINVAL;
+  }
+  hss_local.file = strdup (hss_config_p->local_db_file);
+
+  for (i = 0; i < HSS_LOCAL_LOCKS; i++) {
+    pthread_mutex_init (&hss_local.locks[i], NULL);
+  }
+  pthread_mutex_init (&hss_local.mme_lock, NULL);
+
+  if ((hss_local.fd = open (hss_local.file, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600)) < 0) {
+    FPRINTF_ERROR ("Cannot open %s: %s\n", hss_local.file, strerror (errno));
+    hss_local_disconnect ();
+    return EINVAL;
+  }
+
+  if ((ret = hss_local_replay (&live_size)) != 0) {
+    hss_local_disconnect ();
+    return ret;
+  }
+
+  if ((hss_local.nb_users == 0) && (hss_config_p->local_db_import != NULL)) {
+    if ((ret = hss_local_import (hss_config_p->local_db_import)) != 0) {
+      hss_local_disconnect ();
+      return ret;
+    }
+    /*
+     * The imported subscribers are written as a compacted log
+     */
+    live_size = 0;
+  }
+
+  if ((fstat (hss_local.fd, &st) == 0) && ((live_size == 0) || ((st.st_size > HSS_LOCAL_COMPACT_MIN_SIZE) && (st.st_size > 2 * live_size)))
+      && (hss_local.nb_users > 0) && ((ret = hss_local_compact ()) != 0)) {
+    hss_local_disconnect ();
+    return ret;
+  }
+  hss_local_set_compact_at ();
+  FPRINTF_DEBUG ("Initializing local db layer: DONE (%u subscribers)\n", hss_local.nb_users);
+  return 0;
+}
+
+static int
+hss_local_get_user (
+  const char *imsi)
+{
+  return hss_local_find (imsi) ? 0 : EINVAL;
+}
+
+static int
+hss_local_list_users (
+  void (*callback) (const char *imsi, void *arg),
+  void *arg)
+{
+  hss_local_user_t                       *user;
+  uint32_t                                i;
+
+  for (i = 0; i < hss_local.nb_buckets; i++) {
+    for (user = hss_local.buckets[i]; user; user = user->next) {
+      callback (user->rec.imsi, arg);
+    }
+  }
+  return 0;
+}
+
+static int
+hss_local_update_loc (
+  const char *imsi,
+  mysql_ul_ans_t * mysql_ul_ans)
+{
+  hss_local_user_t                       *user;
+
+  if ((mysql_ul_ans == NULL) || ((user = hss_local_find (imsi)) == NULL)) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  strcpy (mysql_ul_ans->imsi, user->rec.imsi);
+  strcpy (mysql_ul_ans->msisdn, user->rec.msisdn);
+  mysql_ul_ans->aggr_ul = user->rec.aggr_ul;
+  mysql_ul_ans->aggr_dl = user->rec.aggr_dl;
+  mysql_ul_ans->rau_tau = user->rec.rau_tau;
+  mysql_ul_ans->access_restriction = user->rec.access_restriction;
+  mysql_ul_ans->mme_identity = user->rec.mme_identity;
+  pthread_mutex_unlock (hss_local_lock (user));
+  return 0;
+}
+
+static int
+hss_local_push_up_loc (
+  mysql_ul_push_t * ul_push_p)
+{
+  hss_local_user_t                       *user;
+  int                                     ret;
+
+  if ((ul_push_p == NULL) || ((user = hss_local_find (ul_push_p->imsi)) == NULL)) {
+    return EINVAL;
+  }
+
+  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
+    hss_local_mme_add (&ul_push_p->mme_identity, hss_local.fd);
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+
+  if (ul_push_p->imei_present == IMEI_PRESENT) {
+    snprintf (user->rec.imei, sizeof (user->rec.imei), "%s", ul_push_p->imei);
+  }
+
+  if (ul_push_p->sv_present == SV_PRESENT) {
+    memcpy (user->rec.imei_sv, ul_push_p->software_version, 2);
+    user->rec.imei_sv[2] = '\0';
+  }
+
+  if (ul_push_p->mme_identity_present == MME_IDENTITY_PRESENT) {
+    user->rec.mme_identity = ul_push_p->mme_identity;
+    user->rec.purged = 0;
+  }
+  ret = hss_local_write_user (hss_local.fd, user);
+  pthread_mutex_unlock (hss_local_lock (user));
+  hss_local_compact_if_needed ();
+  return ret;
+}
+
+static int
+hss_local_purge_ue (
+  mysql_pu_req_t * mysql_pu_req,
+  mysql_pu_ans_t * mysql_pu_ans)
+{
+  hss_local_user_t                       *user;
+  int                                     ret;
+
+  if ((mysql_pu_req == NULL) || (mysql_pu_ans == NULL) || ((user = hss_local_find (mysql_pu_req->imsi)) == NULL)) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  user->rec.purged = 1;
+  *mysql_pu_ans = user->rec.mme_identity;
+  ret = hss_local_write_user (hss_local.fd, user);
+  pthread_mutex_unlock (hss_local_lock (user));
+  hss_local_compact_if_needed ();
+  return ret;
+}
+
+static int
+hss_local_query_pdns (
+  const char *imsi,
+  mysql_pdn_t ** pdns_p,
+  uint8_t * nb_pdns)
+{
+  hss_local_user_t                       *user;
+  int                                     ret = 0;
+
+  if ((pdns_p == NULL) || (nb_pdns == NULL) || ((user = hss_local_find (imsi)) == NULL)) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  *nb_pdns = user->rec.nb_pdns;
+
+  if ((*nb_pdns == 0) || ((*pdns_p = malloc (*nb_pdns * sizeof (mysql_pdn_t))) == NULL)) {
+    *nb_pdns = 0;
+    ret = EINVAL;
+  } else {
+    memcpy (*pdns_p, user->pdns, *nb_pdns * sizeof (mysql_pdn_t));
+  }
+  pthread_mutex_unlock (hss_local_lock (user));
+  return ret;
+}
+
+static int
+hss_local_check_epc_equipment (
+  mysql_mme_identity_t * mme_identity_p)
+{
+  int                                     known;
+
+  if (mme_identity_p == NULL) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (&hss_local.mme_lock);
+  known = hss_local_mme_known (mme_identity_p->mme_host);
+  pthread_mutex_unlock (&hss_local.mme_lock);
+  return known ? 0 : EINVAL;
+}
+
+/*
+ * Called with the lock of the subscriber
+ */
+static void
+hss_local_auth_info_resp (
+  const hss_local_user_t * user,
+  uint64_t sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  memcpy (auth_info_resp->key, user->rec.key, KEY_LENGTH);
+  memcpy (auth_info_resp->opc, user->rec.opc, KEY_LENGTH);
+  memcpy (auth_info_resp->rand, user->rec.rand, RAND_LENGTH);
+  hss_sqn_from_u64 (sqn, auth_info_resp->sqn);
+}
+
+static int
+hss_local_auth_info (
+  mysql_auth_info_req_t * auth_info_req,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  hss_local_user_t                       *user;
+
+  if ((auth_info_req == NULL) || (auth_info_resp == NULL)) {
+    return EINVAL;
+  }
+
+  if ((user = hss_local_find (auth_info_req->imsi)) == NULL) {
+    return DIAMETER_ERROR_USER_UNKNOWN;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  hss_local_auth_info_resp (user, user->rec.sqn, auth_info_resp);
+  pthread_mutex_unlock (hss_local_lock (user));
+  return 0;
+}
+
+static int
+hss_local_auth_info_sqn (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * resync_sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  hss_local_user_t                       *user;
+  hss_local_user_rec_t                    previous;
+  uint64_t                                sqn;
+  int                                     ret;
+
+  if ((rand_p == NULL) || (auth_info_resp == NULL)) {
+    return EINVAL;
+  }
+
+  if ((user = hss_local_find (imsi)) == NULL) {
+    return DIAMETER_ERROR_USER_UNKNOWN;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  previous = user->rec;
+  sqn = resync_sqn ? hss_sqn_to_u64 (resync_sqn) + HSS_LOCAL_SQN_STEP : user->rec.sqn;
+  user->rec.sqn = sqn + HSS_LOCAL_SQN_STEP;
+  memcpy (user->rec.rand, rand_p, RAND_LENGTH);
+
+  if ((ret = hss_local_write_sqn (user)) != 0) {
+    user->rec = previous;
+  } else {
+    hss_local_auth_info_resp (user, sqn, auth_info_resp);
+  }
+  pthread_mutex_unlock (hss_local_lock (user));
+  hss_local_compact_if_needed ();
+  return ret;
+}
+
+static int
+hss_local_push_rand_sqn (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * sqn)
+{
+  hss_local_user_t                       *user;
+  int                                     ret;
+
+  if ((rand_p == NULL) || (sqn == NULL) || ((user = hss_local_find (imsi)) == NULL)) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  memcpy (user->rec.rand, rand_p, RAND_LENGTH);
+  user->rec.sqn = hss_sqn_to_u64 (sqn);
+  ret = hss_local_write_sqn (user);
+  pthread_mutex_unlock (hss_local_lock (user));
+  hss_local_compact_if_needed ();
+  return ret;
+}
+
+static int
+hss_local_increment_sqn (
+  const char *imsi)
+{
+  hss_local_user_t                       *user;
+  int                                     ret;
+
+  if ((user = hss_local_find (imsi)) == NULL) {
+    return EINVAL;
+  }
+  pthread_mutex_lock (hss_local_lock (user));
+  user->rec.sqn += HSS_LOCAL_SQN_STEP;
+  ret = hss_local_write_sqn (user);
+  pthread_mutex_unlock (hss_local_lock (user));
+  hss_local_compact_if_needed ();
+  return ret;
+}
+
+static int
+hss_local_check_opc_keys (
+  const uint8_t opP[16])
+{
+  hss_local_user_t                       *user;
+  uint32_t                                i;
+  int                                     ret = 0;
+
+  for (i = 0; i < hss_local.nb_buckets; i++) {
+    for (user = hss_local.buckets[i]; user; user = user->next) {
+      uint8_t                                 opc[KEY_LENGTH];
+
+      ComputeOPc (user->rec.key, opP, opc);
+      pthread_mutex_lock (hss_local_lock (user));
+
+      if (memcmp (opc, user->rec.opc, KEY_LENGTH)) {
+        memcpy (user->rec.opc, opc, KEY_LENGTH);
+        ret |= hss_local_write_user (hss_local.fd, user);
+      }
+      pthread_mutex_unlock (hss_local_lock (user));
+    }
+  }
+  hss_local_compact_if_needed ();
+  return ret ? EIO : 0;
+}
+
+const hss_db_ops_t                      hss_db_local_ops = {
+  .name                = "local",
+  .connect             = hss_local_connect,
+  .disconnect          = hss_local_disconnect,
+  .get_user            = hss_local_get_user,
+  .list_users          = hss_local_list_users,
+  .update_loc          = hss_local_update_loc,
+  .push_up_loc         = hss_local_push_up_loc,
+  .purge_ue            = hss_local_purge_ue,
+  .query_pdns          = hss_local_query_pdns,
+  .check_epc_equipment = hss_local_check_epc_equipment,
+  .auth_info           = hss_local_auth_info,
+  .auth_info_sqn       = hss_local_auth_info_sqn,
+  .push_rand_sqn       = hss_local_push_rand_sqn,
+  .increment_sqn       = hss_local_increment_sqn,
+  .check_opc_keys      = hss_local_check_opc_keys,
+};
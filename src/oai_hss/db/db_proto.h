@@ -30,8 +30,32 @@
 #ifndef DB_PROTO_H_
 #define DB_PROTO_H_
 
+#if !defined(MARIADB_BASE_VERSION) && defined(MYSQL_VERSION_ID) && (MYSQL_VERSION_ID >= 80000)
+typedef bool my_bool;
+#endif
+
+/* Statements prepared once on each connection of the pool */
+typedef enum {
+  DB_STMT_AUTH_INFO = 0,
+  DB_STMT_PUSH_RAND_SQN,
+  DB_STMT_INCREMENT_SQN,
+  DB_STMT_UPDATE_LOC,
+  DB_STMT_QUERY_MMEIDENTITY,
+  DB_STMT_QUERY_PDNS,
+  /* Optional, needs the hss_auth_info_sqn procedure of oai_db.sql */
+  DB_STMT_AUTH_INFO_SQN,
+  DB_STMT_MAX
+} db_stmt_id_t;
+
+typedef struct db_connection_s {
+  MYSQL          *db_conn;
+  MYSQL_STMT     *stmt[DB_STMT_MAX];
+  /* Taken for the duration of a request, if more threads than connections */
+  pthread_mutex_t lock;
+} db_connection_t;
+
 typedef struct {
-  /* The mysql reference connector object */
+  /* The mysql reference connector object, for the queries that are not prepared */
   MYSQL *db_conn;
   char  *server;
   char  *user;
@@ -39,6 +63,11 @@ typedef struct {
   char  *database;
 
   pthread_mutex_t db_cs_mutex;
+
+  /* Pool of connections, a thread always uses the same connection */
+  int              nb_connections;
+  db_connection_t *connections;
+  unsigned int     next_connection;
 } database_t;
 
 extern database_t *db_desc;
@@ -162,12 +191,78 @@ typedef struct mysql_pu_req_s{
 
 typedef mysql_mme_identity_t mysql_pu_ans_t;
 
+/* Storage backend of the subscribers, selected by DB_backend (db_backend.c).
+ * The S6a procedures only use the hss_db_* functions, the hss_mysql_* functions
+ * are the MySQL backend.
+ */
+typedef struct hss_db_ops_s {
+  const char *name;
+  int  (*connect)(const hss_config_t *hss_config_p);
+  void (*disconnect)(void);
+  int  (*get_user)(const char *imsi);
+  int  (*list_users)(void (*callback)(const char *imsi, void *arg), void *arg);
+  int  (*update_loc)(const char *imsi, mysql_ul_ans_t *mysql_ul_ans);
+  int  (*push_up_loc)(mysql_ul_push_t *ul_push_p);
+  int  (*purge_ue)(mysql_pu_req_t *mysql_pu_req, mysql_pu_ans_t *mysql_pu_ans);
+  int  (*query_pdns)(const char *imsi, mysql_pdn_t **pdns_p, uint8_t *nb_pdns);
+  int  (*check_epc_equipment)(mysql_mme_identity_t *mme_identity_p);
+  int  (*auth_info)(mysql_auth_info_req_t *auth_info_req, mysql_auth_info_resp_t *auth_info_resp);
+  int  (*auth_info_sqn)(const char *imsi, uint8_t *rand_p, uint8_t *resync_sqn, mysql_auth_info_resp_t *auth_info_resp);
+  int  (*push_rand_sqn)(const char *imsi, uint8_t *rand_p, uint8_t *sqn);
+  int  (*increment_sqn)(const char *imsi);
+  int  (*check_opc_keys)(const uint8_t opP[16]);
+} hss_db_ops_t;
+
+extern const hss_db_ops_t hss_db_mysql_ops;
+extern const hss_db_ops_t hss_db_local_ops;
+
+int hss_db_connect(const hss_config_t *hss_config_p);
+void hss_db_disconnect(void);
+int hss_db_get_user(const char *imsi);
+/* Calls callback for each subscriber */
+int hss_db_list_users(void (*callback)(const char *imsi, void *arg), void *arg);
+int hss_db_update_loc(const char *imsi, mysql_ul_ans_t *mysql_ul_ans);
+int hss_db_push_up_loc(mysql_ul_push_t *ul_push_p);
+int hss_db_purge_ue(mysql_pu_req_t *mysql_pu_req, mysql_pu_ans_t *mysql_pu_ans);
+int hss_db_query_pdns(const char *imsi, mysql_pdn_t **pdns_p, uint8_t *nb_pdns);
+int hss_db_check_epc_equipment(mysql_mme_identity_t *mme_identity_p);
+int hss_db_auth_info(mysql_auth_info_req_t *auth_info_req, mysql_auth_info_resp_t *auth_info_resp);
+int hss_db_auth_info_sqn(const char *imsi, uint8_t *rand_p, uint8_t *resync_sqn, mysql_auth_info_resp_t *auth_info_resp);
+int hss_db_push_rand_sqn(const char *imsi, uint8_t *rand_p, uint8_t *sqn);
+int hss_db_increment_sqn(const char *imsi);
+int hss_db_check_opc_keys(const uint8_t opP[16]);
+
+/* SQN of the database (48 bits integer) to/from the SQN of the vectors */
+uint64_t hss_sqn_to_u64(const uint8_t *sqn);
+void hss_sqn_from_u64(uint64_t sqn_decimal, uint8_t *sqn);
+
 int hss_mysql_connect(const hss_config_t *hss_config_p);
 
+/* Connection of the calling thread, locked, NULL if the pool is not initialized */
+db_connection_t *hss_mysql_connection_get(void);
+
+void hss_mysql_connection_put(db_connection_t *connection);
+
+/* Fill a parameter or result binding of a prepared statement */
+void hss_mysql_bind(MYSQL_BIND *bind, enum enum_field_types type, void *buffer,
+                    unsigned long buffer_length, unsigned long *length, my_bool *is_null);
+
+/* NUL terminate a string column fetched in a buffer of this size (truncated if longer) */
+void hss_mysql_string_end(char *string, size_t size, unsigned long length, my_bool is_null);
+
+/* Execute a prepared statement, reconnect and prepare the statements again if the connection was lost.
+ * If results is not NULL the result set is stored, the caller fetches the rows
+ * with mysql_stmt_fetch() then calls mysql_stmt_free_result().
+ */
+int hss_mysql_stmt_execute(db_connection_t *connection, db_stmt_id_t id,
+                           MYSQL_BIND *params, MYSQL_BIND *results);
+
 void hss_mysql_disconnect(void);
 
 int hss_mysql_get_user(const char *imsi);
 
+int hss_mysql_list_users(void (*callback)(const char *imsi, void *arg), void *arg);
+
 int hss_mysql_update_loc(const char *imsi, mysql_ul_ans_t *mysql_ul_ans);
 
 int hss_mysql_query_mmeidentity(const int id_mme_identity,
@@ -184,6 +279,11 @@ int hss_mysql_query_pdns(const char   *imsi,
                          mysql_pdn_t **pdns_p,
                          uint8_t      *nb_pdns);
 
+/* Fields of a PDN given as strings in the pdn table, the element is zeroed by the caller */
+void hss_mysql_pdn_set(mysql_pdn_t *pdn_elm, const char *pdn_type,
+                       const char *ipv4_address, const char *ipv6_address,
+                       const char *pre_emp_cap, const char *pre_emp_vul);
+
 int hss_mysql_auth_info(mysql_auth_info_req_t  *auth_info_req,
                         mysql_auth_info_resp_t *auth_info_resp);
 
@@ -193,5 +293,57 @@ int hss_mysql_increment_sqn(const char *imsi);
 
 int hss_mysql_check_opc_keys(const uint8_t const opP[16]);
 
+/* Allocate the SQN of an authentication information request and store rand_p in one round trip.
+ * The allocated SQN is the stored one, or resync_sqn + 32 if resync_sqn is not NULL,
+ * the stored SQN becomes the allocated one + 32.
+ * Returns ENOTSUP if the database does not have the hss_auth_info_sqn procedure.
+ */
+int hss_mysql_auth_info_sqn(const char *imsi, uint8_t *rand_p, uint8_t *resync_sqn,
+                            mysql_auth_info_resp_t *auth_info_resp);
+
+/* SQN management of the authentication information requests (db_sqn.c),
+ * SQNs are written to the database at each request or behind if SQN_write_behind is set.
+ */
+int hss_sqn_init(const hss_config_t *hss_config_p);
+
+void hss_sqn_exit(void);
+
+/* Key, OPc, last RAND and next SQN of the subscriber, to derive SQN MS of a re-synchronisation */
+int hss_sqn_read(const char *imsi, mysql_auth_info_resp_t *auth_info_resp);
+
+/* Same as hss_db_auth_info_sqn() */
+int hss_sqn_auth_info(const char *imsi, uint8_t *rand_p, uint8_t *resync_sqn,
+                      mysql_auth_info_resp_t *auth_info_resp);
+
+/* Subscriber known from the database by a bulk load, ignored if the SQNs are not written behind */
+void hss_sqn_warm(const char *imsi, const mysql_auth_info_resp_t *auth_info_resp);
+
+/* Cache of the subscriber profiles read by the update location requests (db_cache.c).
+ * The getters return 0 on a hit, ENOENT on a miss or if the cache is disabled.
+ * The generation given by a getter is passed to the put of the profile read from the
+ * database after the miss, the put is ignored if an MME was written or the cache
+ * invalidated since the getter.
+ */
+int hss_cache_init(const hss_config_t *hss_config_p);
+
+void hss_cache_exit(void);
+
+int hss_cache_get_ul(const char *imsi, mysql_ul_ans_t *mysql_ul_ans, uint32_t *generation_p);
+
+void hss_cache_put_ul(const char *imsi, const mysql_ul_ans_t *mysql_ul_ans, uint32_t generation);
+
+/* *pdns_p is allocated, freed by the caller */
+int hss_cache_get_pdns(const char *imsi, mysql_pdn_t **pdns_p, uint8_t *nb_pdns, uint32_t *generation_p);
+
+void hss_cache_put_pdns(const char *imsi, const mysql_pdn_t *pdns, uint8_t nb_pdns, uint32_t generation);
+
+/* Written by the update location request, kept in the cached profile */
+void hss_cache_set_mme_identity(const char *imsi, const mysql_mme_identity_t *mme_identity_p);
+
+/* Invalidation hooks, the profiles are read again from the database on their next request */
+void hss_cache_invalidate(const char *imsi);
+
+void hss_cache_invalidate_all(void);
+
 
 #endif /* DB_PROTO_H_ */
@@ -0,0 +1,488 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * SQN allocation of the authentication information requests.
+ *
+ * By default an allocation is one call of the hss_auth_info_sqn procedure (three
+ * queries if the database does not have it).
+ *
+ * With SQN_write_behind the SQNs are allocated in memory. The database holds a
+ * high-water mark that is always above the SQNs handed out: when an allocation
+ * reaches it, it is raised by HSS_SQN_RESERVE before the SQN is returned. A thread
+ * writes the last RAND of the subscribers and raises their mark again in the
+ * background. After a restart the SQNs start from the mark, never reusing one.
+ * The key, OPc and SQN of a subscriber are read once, changes made to the
+ * database while the HSS runs are not seen.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "log.h"
+#include "s6a_proto.h"
+
+#define HSS_SQN_BUCKETS               (1 << 16)
+#define HSS_SQN_LOCKS                 (64)
+/* 2 ^ sizeof(IND) (see 3GPP TS. 33.102) */
+#define HSS_SQN_STEP                  (32)
+/* SQNs written ahead of the allocations, 1024 requests, far below the USIM limit of 2 ^ 28 */
+#define HSS_SQN_RESERVE               (1024 * HSS_SQN_STEP)
+#define HSS_SQN_FLUSH_PERIOD_US       (100000)
+
+typedef struct hss_sqn_entry_s {
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 key[KEY_LENGTH];
+  uint8_t                                 opc[KEY_LENGTH];
+  uint8_t                                 rand[RAND_LENGTH];
+  /* Next SQN allocated */
+  uint64_t                                sqn;
+  /* SQN stored in the database, above all the SQNs allocated */
+  uint64_t                                sqn_persisted;
+  int                                     is_dirty;
+  pthread_mutex_t                        *lock;
+  struct hss_sqn_entry_s                 *next;
+  struct hss_sqn_entry_s                 *dirty_next;
+} hss_sqn_entry_t;
+
+static struct {
+  int                                     write_behind;
+  int                                     no_procedure;
+  hss_sqn_entry_t                       **buckets;
+  /* A lock protects the entries of the buckets equal to its index modulo HSS_SQN_LOCKS */
+  pthread_mutex_t                         locks[HSS_SQN_LOCKS];
+  /* Taken after the lock of an entry */
+  pthread_mutex_t                         dirty_lock;
+  hss_sqn_entry_t                        *dirty;
+  volatile int                            running;
+  pthread_t                               flush_thread;
+} hss_sqn;
+
+uint64_t
+hss_sqn_to_u64 (
+  const uint8_t * sqn)
+{
+  return ((uint64_t) sqn[0] << 40) | ((uint64_t) sqn[1] << 32) | ((uint64_t) sqn[2] << 24) | (sqn[3] << 16) | (sqn[4] << 8) | sqn[5];
+}
+
+void
+hss_sqn_from_u64 (
+  uint64_t sqn_decimal,
+  uint8_t * sqn)
+{
+  sqn[0] = (sqn_decimal >> 40) & 0xFF;
+  sqn[1] = (sqn_decimal >> 32) & 0xFF;
+  sqn[2] = (sqn_decimal >> 24) & 0xFF;
+  sqn[3] = (sqn_decimal >> 16) & 0xFF;
+  sqn[4] = (sqn_decimal >> 8) & 0xFF;
+  sqn[5] = sqn_decimal & 0xFF;
+}
+
+static uint32_t
+hss_sqn_hash (
+  const char *imsi)
+{
+  uint32_t                                h = 2166136261u;
+
+  while (*imsi) {
+    h = (h ^ (uint8_t) * imsi++) * 16777619u;
+  }
+  return h & (HSS_SQN_BUCKETS - 1);
+}
+
+static int
+hss_sqn_persist (
+  hss_sqn_entry_t * entry,
+  uint64_t sqn_decimal)
+{
+  uint8_t                                 sqn[SQN_LENGTH];
+  int                                     ret;
+
+  hss_sqn_from_u64 (sqn_decimal, sqn);
+
+  if ((ret = hss_db_push_rand_sqn (entry->imsi, entry->rand, sqn)) == 0) {
+    entry->sqn_persisted = sqn_decimal;
+  }
+  return ret;
+}
+
+/*
+ * Called with the lock of the entry
+ */
+static void
+hss_sqn_entry_dirty (
+  hss_sqn_entry_t * entry)
+{
+  if (entry->is_dirty) {
+    return;
+  }
+  entry->is_dirty = 1;
+  pthread_mutex_lock (&hss_sqn.dirty_lock);
+  entry->dirty_next = hss_sqn.dirty;
+  hss_sqn.dirty = entry;
+  pthread_mutex_unlock (&hss_sqn.dirty_lock);
+}
+
+/*
+ * Called with the lock of the bucket
+ */
+static hss_sqn_entry_t *
+hss_sqn_entry_new (
+  const char *imsi,
+  uint32_t bucket,
+  const mysql_auth_info_resp_t * auth_info_resp)
+{
+  hss_sqn_entry_t                        *entry;
+
+  if ((entry = calloc (1, sizeof (hss_sqn_entry_t))) == NULL) {
+    return NULL;
+  }
+  strcpy (entry->imsi, imsi);
+  memcpy (entry->key, auth_info_resp->key, KEY_LENGTH);
+  memcpy (entry->opc, auth_info_resp->opc, KEY_LENGTH);
+  memcpy (entry->rand, auth_info_resp->rand, RAND_LENGTH);
+  entry->sqn = hss_sqn_to_u64 (auth_info_resp->sqn);
+  entry->sqn_persisted = entry->sqn;
+  entry->lock = &hss_sqn.locks[bucket % HSS_SQN_LOCKS];
+  entry->next = hss_sqn.buckets[bucket];
+  hss_sqn.buckets[bucket] = entry;
+  return entry;
+}
+
+/*
+ * Entry of the subscriber, read from the database if not known, returned locked.
+ */
+static hss_sqn_entry_t *
+hss_sqn_entry_lock (
+  const char *imsi,
+  int *ret)
+{
+  uint32_t                                bucket = hss_sqn_hash (imsi);
+  pthread_mutex_t                        *lock = &hss_sqn.locks[bucket % HSS_SQN_LOCKS];
+  mysql_auth_info_req_t                   auth_info_req;
+  mysql_auth_info_resp_t                  auth_info_resp;
+  hss_sqn_entry_t                        *entry;
+
+  pthread_mutex_lock (lock);
+
+  for (entry = hss_sqn.buckets[bucket]; entry; entry = entry->next) {
+    if (strcmp (entry->imsi, imsi) == 0) {
+      return entry;
+    }
+  }
+  pthread_mutex_unlock (lock);
+
+  /*
+   * Do not hold the lock during the query
+   */
+  memset (&auth_info_req, 0, sizeof (auth_info_req));
+  strcpy (auth_info_req.imsi, imsi);
+
+  if ((*ret = hss_db_auth_info (&auth_info_req, &auth_info_resp)) != 0) {
+    return NULL;
+  }
+
+  pthread_mutex_lock (lock);
+
+  for (entry = hss_sqn.buckets[bucket]; entry; entry = entry->next) {
+    if (strcmp (entry->imsi, imsi) == 0) {
+      /*
+       * Read by another request in the meantime
+       */
+      return entry;
+    }
+  }
+
+  if ((entry = hss_sqn_entry_new (imsi, bucket, &auth_info_resp)) == NULL) {
+    pthread_mutex_unlock (lock);
+    *ret = ENOMEM;
+  }
+  return entry;
+}
+
+static void
+hss_sqn_entry_read (
+  hss_sqn_entry_t * entry,
+  uint64_t sqn_decimal,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  memcpy (auth_info_resp->key, entry->key, KEY_LENGTH);
+  memcpy (auth_info_resp->opc, entry->opc, KEY_LENGTH);
+  memcpy (auth_info_resp->rand, entry->rand, RAND_LENGTH);
+  hss_sqn_from_u64 (sqn_decimal, auth_info_resp->sqn);
+}
+
+static void
+hss_sqn_flush (
+  void)
+{
+  hss_sqn_entry_t                        *entry;
+  hss_sqn_entry_t                        *list;
+  uint64_t                                sqn_decimal;
+
+  pthread_mutex_lock (&hss_sqn.dirty_lock);
+  list = hss_sqn.dirty;
+  hss_sqn.dirty = NULL;
+  pthread_mutex_unlock (&hss_sqn.dirty_lock);
+
+  while ((entry = list) != NULL) {
+    list = entry->dirty_next;
+
+    /*
+     * The lock is held during the write, the marks of an entry are written in order
+     */
+    pthread_mutex_lock (entry->lock);
+    entry->is_dirty = 0;
+    entry->dirty_next = NULL;
+    sqn_decimal = entry->sqn + HSS_SQN_RESERVE;
+
+    if (sqn_decimal < entry->sqn_persisted) {
+      sqn_decimal = entry->sqn_persisted;
+    }
+
+    if (hss_sqn_persist (entry, sqn_decimal) != 0) {
+      FPRINTF_ERROR ("Cannot write the SQN of %s, retrying later\n", entry->imsi);
+      hss_sqn_entry_dirty (entry);
+    }
+    pthread_mutex_unlock (entry->lock);
+  }
+}
+
+static void *
+hss_sqn_flush_thread (
+  void *arg)
+{
+  while (hss_sqn.running) {
+    usleep (HSS_SQN_FLUSH_PERIOD_US);
+    hss_sqn_flush ();
+  }
+  return NULL;
+}
+
+/*
+ * One request to the database per allocation, three if it does not have the procedure
+ */
+static int
+hss_sqn_auth_info_db (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * resync_sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  mysql_auth_info_req_t                   auth_info_req;
+  int                                     ret;
+
+  if (!hss_sqn.no_procedure) {
+    if ((ret = hss_db_auth_info_sqn (imsi, rand_p, resync_sqn, auth_info_resp)) != ENOTSUP) {
+      return ret;
+    }
+    FPRINTF_NOTICE ("No hss_auth_info_sqn procedure in the database, SQNs are updated with separate queries\n");
+    hss_sqn.no_procedure = 1;
+  }
+
+  if (resync_sqn) {
+    if (((ret = hss_db_push_rand_sqn (imsi, rand_p, resync_sqn)) != 0) || ((ret = hss_db_increment_sqn (imsi)) != 0)) {
+      return ret;
+    }
+  }
+
+  memset (&auth_info_req, 0, sizeof (auth_info_req));
+  strcpy (auth_info_req.imsi, imsi);
+
+  if (((ret = hss_db_auth_info (&auth_info_req, auth_info_resp)) != 0)
+      || ((ret = hss_db_push_rand_sqn (imsi, rand_p, auth_info_resp->sqn)) != 0)) {
+    return ret;
+  }
+  memcpy (auth_info_resp->rand, rand_p, RAND_LENGTH);
+  return hss_db_increment_sqn (imsi);
+}
+
+int
+hss_sqn_init (
+  const hss_config_t * hss_config_p)
+{
+  int                                     i;
+
+  memset (&hss_sqn, 0, sizeof (hss_sqn));
+  hss_sqn.write_behind = hss_config_p->sqn_write_behind_bool;
+
+  if (!hss_sqn.write_behind) {
+    return 0;
+  }
+
+  if ((hss_sqn.buckets = calloc (HSS_SQN_BUCKETS, sizeof (hss_sqn_entry_t *))) == NULL) {
+    FPRINTF_ERROR ("An error occured on MALLOC\n");
+    return ENOMEM;
+  }
+
+  for (i = 0; i < HSS_SQN_LOCKS; i++) {
+    pthread_mutex_init (&hss_sqn.locks[i], NULL);
+  }
+  pthread_mutex_init (&hss_sqn.dirty_lock, NULL);
+  hss_sqn.running = 1;
+
+  if (pthread_create (&hss_sqn.flush_thread, NULL, hss_sqn_flush_thread, NULL) != 0) {
+    FPRINTF_ERROR ("Cannot create the SQN flush thread\n");
+    hss_sqn.running = 0;
+    return EINVAL;
+  }
+  FPRINTF_DEBUG ("SQN write behind: reserve %d, flush every %d ms\n", HSS_SQN_RESERVE, HSS_SQN_FLUSH_PERIOD_US / 1000);
+  return 0;
+}
+
+void
+hss_sqn_exit (
+  void)
+{
+  hss_sqn_entry_t                        *entry;
+  int                                     i;
+
+  if (!hss_sqn.write_behind) {
+    return;
+  }
+
+  if (hss_sqn.running) {
+    hss_sqn.running = 0;
+    pthread_join (hss_sqn.flush_thread, NULL);
+  }
+  hss_sqn_flush ();
+
+  for (i = 0; i < HSS_SQN_BUCKETS; i++) {
+    while ((entry = hss_sqn.buckets[i]) != NULL) {
+      hss_sqn.buckets[i] = entry->next;
+      free (entry);
+    }
+  }
+  free (hss_sqn.buckets);
+  hss_sqn.buckets = NULL;
+  hss_sqn.write_behind = 0;
+}
+
+void
+hss_sqn_warm (
+  const char *imsi,
+  const mysql_auth_info_resp_t * auth_info_resp)
+{
+  uint32_t                                bucket;
+  pthread_mutex_t                        *lock;
+  hss_sqn_entry_t                        *entry;
+
+  if (!hss_sqn.write_behind || (imsi == NULL) || (strlen (imsi) > IMSI_LENGTH_MAX)) {
+    return;
+  }
+  bucket = hss_sqn_hash (imsi);
+  lock = &hss_sqn.locks[bucket % HSS_SQN_LOCKS];
+  pthread_mutex_lock (lock);
+
+  for (entry = hss_sqn.buckets[bucket]; entry; entry = entry->next) {
+    if (strcmp (entry->imsi, imsi) == 0) {
+      break;
+    }
+  }
+
+  if (entry == NULL) {
+    hss_sqn_entry_new (imsi, bucket, auth_info_resp);
+  }
+  pthread_mutex_unlock (lock);
+}
+
+int
+hss_sqn_read (
+  const char *imsi,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  mysql_auth_info_req_t                   auth_info_req;
+  hss_sqn_entry_t                        *entry;
+  int                                     ret = 0;
+
+  if ((imsi == NULL) || (auth_info_resp == NULL) || (strlen (imsi) > IMSI_LENGTH_MAX)) {
+    return EINVAL;
+  }
+
+  if (!hss_sqn.write_behind) {
+    memset (&auth_info_req, 0, sizeof (auth_info_req));
+    strcpy (auth_info_req.imsi, imsi);
+    return hss_db_auth_info (&auth_info_req, auth_info_resp);
+  }
+
+  if ((entry = hss_sqn_entry_lock (imsi, &ret)) == NULL) {
+    return ret;
+  }
+  hss_sqn_entry_read (entry, entry->sqn, auth_info_resp);
+  pthread_mutex_unlock (entry->lock);
+  return 0;
+}
+
+int
+hss_sqn_auth_info (
+  const char *imsi,
+  uint8_t * rand_p,
+  uint8_t * resync_sqn,
+  mysql_auth_info_resp_t * auth_info_resp)
+{
+  hss_sqn_entry_t                        *entry;
+  uint64_t                                sqn_decimal;
+  uint64_t                                sqn_previous;
+  uint8_t                                 rand_previous[RAND_LENGTH];
+  int                                     ret = 0;
+
+  if ((imsi == NULL) || (rand_p == NULL) || (auth_info_resp == NULL) || (strlen (imsi) > IMSI_LENGTH_MAX)) {
+    return EINVAL;
+  }
+
+  if (!hss_sqn.write_behind) {
+    return hss_sqn_auth_info_db (imsi, rand_p, resync_sqn, auth_info_resp);
+  }
+
+  if ((entry = hss_sqn_entry_lock (imsi, &ret)) == NULL) {
+    return ret;
+  }
+  sqn_previous = entry->sqn;
+  memcpy (rand_previous, entry->rand, RAND_LENGTH);
+
+  if (resync_sqn) {
+    entry->sqn = hss_sqn_to_u64 (resync_sqn) + HSS_SQN_STEP;
+  }
+  sqn_decimal = entry->sqn;
+  entry->sqn += HSS_SQN_STEP;
+  memcpy (entry->rand, rand_p, RAND_LENGTH);
+
+  /*
+   * The SQN must be in the database before it is used, write the mark now
+   */
+  if ((entry->sqn > entry->sqn_persisted) && ((ret = hss_sqn_persist (entry, entry->sqn + HSS_SQN_RESERVE)) != 0)) {
+    entry->sqn = sqn_previous;
+    memcpy (entry->rand, rand_previous, RAND_LENGTH);
+    pthread_mutex_unlock (entry->lock);
+    return ret;
+  }
+  hss_sqn_entry_dirty (entry);
+  hss_sqn_entry_read (entry, sqn_decimal, auth_info_resp);
+  pthread_mutex_unlock (entry->lock);
+  return 0;
+}
@@ -33,6 +33,49 @@
 #include "db_proto.h"
 #include "log.h"
 
+void
+hss_mysql_pdn_set (
+  mysql_pdn_t * pdn_elm,
+  const char *pdn_type,
+  const char *ipv4_address,
+  const char *ipv6_address,
+  const char *pre_emp_cap,
+  const char *pre_emp_vul)
+{
+  /*
+   * PDN Type + PDN address
+   */
+  if (strcmp (pdn_type, "IPv6") == 0) {
+    pdn_elm->pdn_type = IPV6;
+  } else if (strcmp (pdn_type, "IPv4v6") == 0) {
+    pdn_elm->pdn_type = IPV4V6;
+  } else if (strcmp (pdn_type, "IPv4_or_IPv6") == 0) {
+    pdn_elm->pdn_type = IPV4_OR_IPV6;
+  } else {
+    pdn_elm->pdn_type = IPV4;
+  }
+
+  if (pdn_elm->pdn_type != IPV6) {
+    strncpy (pdn_elm->pdn_address.ipv4_address, ipv4_address, sizeof (pdn_elm->pdn_address.ipv4_address) - 1);
+  }
+
+  if (pdn_elm->pdn_type != IPV4) {
+    strncpy (pdn_elm->pdn_address.ipv6_address, ipv6_address, sizeof (pdn_elm->pdn_address.ipv6_address) - 1);
+  }
+
+  if (strcmp (pre_emp_cap, "ENABLED") == 0) {
+    pdn_elm->pre_emp_cap = 0;
+  } else {
+    pdn_elm->pre_emp_cap = 1;
+  }
+
+  if (strcmp (pre_emp_vul, "DISABLED") == 0) {
+    pdn_elm->pre_emp_vul = 1;
+  } else {
+    pdn_elm->pre_emp_vul = 0;
+  }
+}
+
 int
 hss_mysql_query_pdns (
   const char *imsi,
@@ -40,42 +83,61 @@ hss_mysql_query_pdns (
   uint8_t * nb_pdns)
 {
   int                                     ret;
-  MYSQL_RES                              *res = NULL;
-  MYSQL_ROW                               row;
-  char                                    query[1000];
+  int                                     status;
+  db_connection_t                        *connection;
+  MYSQL_STMT                             *stmt;
+  MYSQL_BIND                              param;
+  MYSQL_BIND                              result[10];
+  my_bool                                 is_null[10];
+  unsigned long                           length[10];
+  mysql_pdn_t                             pdn;
+  char                                    pdn_type[16];
+  char                                    pre_emp_cap[16];
+  char                                    pre_emp_vul[16];
+  uint32_t                                aggr_ul = 0;
+  uint32_t                                aggr_dl = 0;
+  uint8_t                                 qci = 0;
+  uint8_t                                 priority_level = 0;
+  uint32_t                                cache_generation = 0;
   mysql_pdn_t                            *pdn_array = NULL;
 
-  if (db_desc->db_conn == NULL) {
+  if (nb_pdns == NULL || pdns_p == NULL) {
     return EINVAL;
   }
 
-  if (nb_pdns == NULL || pdns_p == NULL) {
-    return EINVAL;
+  if (hss_cache_get_pdns (imsi, pdns_p, nb_pdns, &cache_generation) == 0) {
+    return 0;
   }
 
-  sprintf (query, "SELECT * FROM `pdn` WHERE " "`pdn`.`users_imsi`=%s LIMIT 10; ", imsi);
-  FPRINTF_DEBUG ("Query: %s\n", query);
-  pthread_mutex_lock (&db_desc->db_cs_mutex);
+  FPRINTF_DEBUG ("Query: %s (%s)\n", "SELECT FROM pdn", imsi);
 
-  if (mysql_query (db_desc->db_conn, query)) {
-    pthread_mutex_unlock (&db_desc->db_cs_mutex);
-    fprintf (stderr, "Query execution failed: %s\n", mysql_error (db_desc->db_conn));
+  if ((connection = hss_mysql_connection_get ()) == NULL) {
     return EINVAL;
   }
 
-  res = mysql_store_result (db_desc->db_conn);
-  pthread_mutex_unlock (&db_desc->db_cs_mutex);
-
-  if ( res == NULL )
+  stmt = connection->stmt[DB_STMT_QUERY_PDNS];
+  hss_mysql_bind (&param, MYSQL_TYPE_STRING, (void *)imsi, strlen (imsi), NULL, NULL);
+  hss_mysql_bind (&result[0], MYSQL_TYPE_STRING, pdn.apn, sizeof (pdn.apn), &length[0], &is_null[0]);
+  hss_mysql_bind (&result[1], MYSQL_TYPE_STRING, pdn_type, sizeof (pdn_type), &length[1], &is_null[1]);
+  hss_mysql_bind (&result[2], MYSQL_TYPE_STRING, pdn.pdn_address.ipv4_address, sizeof (pdn.pdn_address.ipv4_address), &length[2], &is_null[2]);
+  hss_mysql_bind (&result[3], MYSQL_TYPE_STRING, pdn.pdn_address.ipv6_address, sizeof (pdn.pdn_address.ipv6_address), &length[3], &is_null[3]);
+  hss_mysql_bind (&result[4], MYSQL_TYPE_LONG, &aggr_ul, 0, &length[4], &is_null[4]);
+  hss_mysql_bind (&result[5], MYSQL_TYPE_LONG, &aggr_dl, 0, &length[5], &is_null[5]);
+  hss_mysql_bind (&result[6], MYSQL_TYPE_TINY, &qci, 0, &length[6], &is_null[6]);
+  hss_mysql_bind (&result[7], MYSQL_TYPE_TINY, &priority_level, 0, &length[7], &is_null[7]);
+  hss_mysql_bind (&result[8], MYSQL_TYPE_STRING, pre_emp_cap, sizeof (pre_emp_cap), &length[8], &is_null[8]);
+  hss_mysql_bind (&result[9], MYSQL_TYPE_STRING, pre_emp_vul, sizeof (pre_emp_vul), &length[9], &is_null[9]);
+
+  if (hss_mysql_stmt_execute (connection, DB_STMT_QUERY_PDNS, &param, result)) {
+    hss_mysql_connection_put (connection);
     return EINVAL;
+  }
 
   *nb_pdns = 0;
 
-  while ((row = mysql_fetch_row (res)) != NULL) {
+  while (((status = mysql_stmt_fetch (stmt)) == 0) || (status == MYSQL_DATA_TRUNCATED)) {
     mysql_pdn_t                            *pdn_elm;    /* Local PDN element in array */
-    unsigned long                          *lengths;
 
-    lengths = mysql_fetch_lengths (res);
     *nb_pdns += 1;
 
     if (*nb_pdns == 1) {
@@ -84,7 +146,12 @@ hss_mysql_query_pdns (
        */
       pdn_array = malloc (sizeof (mysql_pdn_t));
     } else {
-      pdn_array = realloc (pdn_array, *nb_pdns * sizeof (mysql_pdn_t));
+      mysql_pdn_t                            *new_array = realloc (pdn_array, *nb_pdns * sizeof (mysql_pdn_t));
+
+      if (new_array == NULL) {
+        free (pdn_array);
+      }
+      pdn_array = new_array;
     }
 
     if (pdn_array == NULL) {
@@ -96,56 +163,27 @@ hss_mysql_query_pdns (
     }
 
     pdn_elm = &pdn_array[*nb_pdns - 1];
-    /*
-     * Copying the APN
-     */
     memset (pdn_elm, 0, sizeof (mysql_pdn_t));
-    memcpy (pdn_elm->apn, row[1], lengths[1]);
-
     /*
-     * PDN Type + PDN address
+     * Copying the APN
      */
-    if (strcmp (row[2], "IPv6") == 0) {
-      pdn_elm->pdn_type = IPV6;
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
-    } else if (strcmp (row[2], "IPv4v6") == 0) {
-      pdn_elm->pdn_type = IPV4V6;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
-    } else if (strcmp (row[2], "IPv4_or_IPv6") == 0) {
-      pdn_elm->pdn_type = IPV4_OR_IPV6;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
-      memcpy (pdn_elm->pdn_address.ipv6_address, row[4], lengths[4]);
-      pdn_elm->pdn_address.ipv6_address[lengths[4]] = '\0';
-    } else {
-      pdn_elm->pdn_type = IPV4;
-      memcpy (pdn_elm->pdn_address.ipv4_address, row[3], lengths[3]);
-      pdn_elm->pdn_address.ipv4_address[lengths[3]] = '\0';
-    }
-
-    pdn_elm->aggr_ul = atoi (row[5]);
-    pdn_elm->aggr_dl = atoi (row[6]);
-    pdn_elm->qci = atoi (row[9]);
-    pdn_elm->priority_level = atoi (row[10]);
-
-    if (strcmp (row[11], "ENABLED") == 0) {
-      pdn_elm->pre_emp_cap = 0;
-    } else {
-      pdn_elm->pre_emp_cap = 1;
-    }
-
-    if (strcmp (row[12], "DISABLED") == 0) {
-      pdn_elm->pre_emp_vul = 1;
-    } else {
-      pdn_elm->pre_emp_vul = 0;
-    }
+    hss_mysql_string_end (pdn.apn, sizeof (pdn.apn), length[0], is_null[0]);
+    memcpy (pdn_elm->apn, pdn.apn, sizeof (pdn_elm->apn));
+    hss_mysql_string_end (pdn_type, sizeof (pdn_type), length[1], is_null[1]);
+    hss_mysql_string_end (pre_emp_cap, sizeof (pre_emp_cap), length[8], is_null[8]);
+    hss_mysql_string_end (pre_emp_vul, sizeof (pre_emp_vul), length[9], is_null[9]);
+
+    hss_mysql_string_end (pdn.pdn_address.ipv4_address, sizeof (pdn.pdn_address.ipv4_address), length[2], is_null[2]);
+    hss_mysql_string_end (pdn.pdn_address.ipv6_address, sizeof (pdn.pdn_address.ipv6_address), length[3], is_null[3]);
+    hss_mysql_pdn_set (pdn_elm, pdn_type, pdn.pdn_address.ipv4_address, pdn.pdn_address.ipv6_address, pre_emp_cap, pre_emp_vul);
+    pdn_elm->aggr_ul = aggr_ul;
+    pdn_elm->aggr_dl = aggr_dl;
+    pdn_elm->qci = qci;
+    pdn_elm->priority_level = priority_level;
   }
 
-  mysql_free_result (res);
+  mysql_stmt_free_result (stmt);
+  hss_mysql_connection_put (connection);
 
   /*
    * We did not find any APN for the requested IMSI
@@ -153,19 +191,16 @@ hss_mysql_query_pdns (
   if (*nb_pdns == 0) {
     return EINVAL;
   } else {
+    hss_cache_put_pdns (imsi, pdn_array, *nb_pdns, cache_generation);
     *pdns_p = pdn_array;
     return 0;
   }
 
 err:
-
-  if (pdn_array) {
-    free (pdn_array);
-  }
-
+  mysql_stmt_free_result (stmt);
+  hss_mysql_connection_put (connection);
   pdn_array = NULL;
   *pdns_p = pdn_array;
   *nb_pdns = 0;
-  mysql_free_result (res);
   return ret;
 }
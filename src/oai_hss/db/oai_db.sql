@@ -193,6 +193,24 @@ LOCK TABLES `users` WRITE;
 INSERT INTO `users` VALUES ('20834123456789','380561234567','35609204079300',NULL,'PURGED',50,40000000,100000000,47,0000000000,1,'+Eų\0,IHH',0,0,00000000000000000096,'PxX \Z1x','^KFeU'),('20810000001234','33611123456','35609204079299',NULL,'PURGED',120,40000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000281454575616225,'\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0','4s@z~'),('31002890832150','33638060059','35611302209414',NULL,'PURGED',120,40000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012416,'`F݆Dϛ','4s@z~'),('001010123456789','33600101789','35609204079298',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'\0	\n\r',1,0,00000000000000000351,'\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0','L*\\^] '),('208930000000001','33638030001','35609204079301',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208950000000002','33638050002','35609204079502',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000020471,'\0	\n\r','4s@z~'),('208950000000003','33638050003','35609204079503',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012343,'\0	\n\r','4s@z~'),('208950000000004','33638050004','35609204079504',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000005','33638050005','35609204079505',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000001','33638050001','35609204079501',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208950000000006','33638050006','35609204079506',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000007','33638050007','35609204079507',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208930000000002','33638030002','35609204079302',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208930000000003','33638030003','35609204079303',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208930000000004','33638030004','35609204079304',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208930000000005','33638030005','35609204079305',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208930000000006','33638030006','35609204079306',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208930000000007','33638030007','35609204079307',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000007','33638040007','35609204079407',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000006','33638040006','35609204079406',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000005','33638040005','35609204079405',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000004','33638040004','35609204079404',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000003','33638040003','35609204079403',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000002','33638040002','35609204079402',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208940000000001','33638040001','35609204079401',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'wqgzWЁZ]','4s@z~'),('208920100001100','33638020001','35609204079201',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001101','33638020001','35609204079201',NULL,'NOT_PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000281044204937234,'\0	\n\r','$I6;+fku|'),('208920100001102','33638020002','35609204079202',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001103','33638020003','35609204079203',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001104','33638020004','35609204079204',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001105','33638020005','35609204079205',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001106','33638020006','35609204079206',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000000000000006103,'ebd07771ace8677a','$I6;+fku|'),('208920100001107','33638020007','35609204079207',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001108','33638020008','35609204079208',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001109','33638020009','35609204079209',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208920100001110','33638020010','35609204079210',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208930100001111','33638030011','35609304079211',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208930100001112','33638030012','35609304079212',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006103,'ebd07771ace8677a','4s@z~'),('208930100001113','33638030013','35609304079213',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000006263,'SNܒIve6','4s@z~'),('208950000000008','33638050008','35609204079508',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000009','33638050009','35609204079509',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000010','33638050010','35609204079510',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000011','33638050011','35609204079511',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000012','33638050012','35609204079512',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000013','33638050013','35609204079513',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000014','33638050014','35609204079514',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000012215,'56f0261d9d051063','4s@z~'),('208950000000015','33638050015','35609204079515',NULL,'PURGED',120,50000000,100000000,47,0000000000,1,'G?/Д	|hb',1,0,00000000000000000000,'3536663032363164','4s@z~'),('208920100001118','33638020010','35609204079210',NULL,'NOT_PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000281044204934762,'~?03u-%eyy','$I6;+fku|'),('208920100001121','33638020010','35609204079210',NULL,'NOT_PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000281044204935293,'&@xg]\nVp','$I6;+fku|'),('208920100001119','33638020010','35609204079210',NULL,'NOT_PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000281044204935293,'269482407867805d','$I6;+fku|'),('208920100001120','33638020010','35609204079210',NULL,'NOT_PURGED',120,50000000,100000000,47,0000000000,1,'kp~Љu{K',1,0,00000281044204935293,'3236393438323430','$I6;+fku|');
 /*!40000 ALTER TABLE `users` ENABLE KEYS */;
 UNLOCK TABLES;
+
+--
+-- Procedure `hss_auth_info_sqn`: allocate the SQN of an authentication information request
+-- and store the last RAND in one round trip. The allocated SQN is the stored one, or the SQN
+-- of the re-synchronisation + 32 when p_resync_sqn is not NULL, the stored SQN is the allocated
+-- one + 32 (2 ^ sizeof(IND), see 3GPP TS 33.102). `users` is MyISAM: the allocation is a single
+-- UPDATE to be atomic.
+--
+
+DROP PROCEDURE IF EXISTS `hss_auth_info_sqn`;
+DELIMITER ;;
+CREATE PROCEDURE `hss_auth_info_sqn`(IN p_imsi VARCHAR(15), IN p_rand VARBINARY(16), IN p_resync_sqn BIGINT UNSIGNED)
+BEGIN
+  SET @hss_sqn = NULL;
+  UPDATE `users` SET `sqn` = (@hss_sqn := IFNULL(p_resync_sqn + 32, `sqn`)) + 32, `rand` = p_rand WHERE `users`.`imsi` = p_imsi;
+  SELECT `key`, CAST(@hss_sqn AS UNSIGNED) AS `sqn`, `OPc` FROM `users` WHERE `users`.`imsi` = p_imsi;
+END ;;
+DELIMITER ;
 /*!40103 SET TIME_ZONE=@OLD_TIME_ZONE */;
 
 /*!40101 SET SQL_MODE=@OLD_SQL_MODE */;
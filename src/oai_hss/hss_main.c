@@ -39,6 +39,16 @@
 
 hss_config_t                            hss_config;
 
+/* Set on SIGHUP, the operator changed the subscribers in the database */
+static volatile sig_atomic_t            hss_cache_reload = 0;
+
+static void
+hss_sighup_handler (
+  int signum)
+{
+  hss_cache_reload = 1;
+}
+
 
 int
 main (
@@ -102,16 +112,29 @@ main (
     return -1;
   }
 
-  if (hss_mysql_connect (&hss_config) != 0) {
+  if (hss_db_connect (&hss_config) != 0) {
     return -1;
   }
 
   random_init ();
 
   if (hss_config.valid_op) {
-    hss_mysql_check_opc_keys ((uint8_t *) hss_config.operator_key_bin);
+    hss_db_check_opc_keys ((uint8_t *) hss_config.operator_key_bin);
+  }
+
+  if (hss_sqn_init (&hss_config) != 0) {
+    return -1;
   }
 
+  if (hss_cache_init (&hss_config) != 0) {
+    return -1;
+  }
+
+  if (s6a_auth_pool_init (&hss_config) != 0) {
+    return -1;
+  }
+
+  signal (SIGHUP, hss_sighup_handler);
   s6a_init (&hss_config);
 
   while (1) {
@@ -119,6 +142,11 @@ main (
      * TODO: handle signals here
      */
     sleep (1);
+
+    if (hss_cache_reload) {
+      hss_cache_reload = 0;
+      hss_cache_invalidate_all ();
+    }
   }
 
   pid_file_unlock();
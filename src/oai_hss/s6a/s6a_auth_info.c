@@ -63,6 +63,7 @@ s6a_auth_info_cb (
    */
   mysql_auth_info_req_t                   auth_info_req;
   mysql_auth_info_resp_t                  auth_info_resp;
+  milenage_ctx_t                          milenage_ctx;
 
   /*
    * Authentication vector
@@ -73,6 +74,9 @@ s6a_auth_info_cb (
   int                                     experimental = 0;
   uint64_t                                imsi = 0;
   uint32_t                                num_vectors = 0;
+  int                                     nb_pool_vectors = 0;
+  int                                     nb_pool_rands = 0;
+  uint8_t                                 pool_rands[S6A_AUTH_POOL_RANDS][RAND_LENGTH];
   uint8_t                                *sqn = NULL,
     *auts = NULL;
 
@@ -233,76 +237,91 @@ s6a_auth_info_cb (
   }
 
   /*
-   * Fetch User data
+   * Vectors generated in advance, the SQN_MS of a re-synchronisation is derived from
+   * the RAND of one of them
    */
-  int rc = hss_mysql_auth_info (&auth_info_req, &auth_info_resp);
-  if (rc != 0) {
-    result_code = rc;
-    /*
-     * Database query failed...
-     */
-    if (DIAMETER_ERROR_USER_UNKNOWN == result_code) {
-      experimental = 1;
-      goto out;
-    }
-    result_code = DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE;
-    experimental = 1;
-    goto out;
+  if (auts == NULL) {
+    nb_pool_vectors = s6a_auth_pool_get (auth_info_req.imsi, hdr->avp_value->os.data, vector, num_vectors);
+  } else {
+    nb_pool_rands = s6a_auth_pool_flush (auth_info_req.imsi, pool_rands, S6A_AUTH_POOL_RANDS);
   }
 
-  if (auts != NULL) {
+  if ((num_vectors == 0) || (nb_pool_vectors < num_vectors)) {
     /*
-     * Try to derive SQN_MS from previous RAND
+     * Pick the RANDs first, the last one is stored with the SQN in the HSS
      */
-    sqn = sqn_ms_derive (auth_info_resp.opc, auth_info_resp.key, auts, auth_info_resp.rand);
+    for (int i = nb_pool_vectors; i < num_vectors; i++) {
+      generate_random (vector[i].rand, RAND_LENGTH);
+    }
+
+    if (num_vectors == 0) {
+      generate_random (vector[0].rand, RAND_LENGTH);
+    }
 
-    if (sqn != NULL) {
+    if (auts != NULL) {
       /*
-       * We succeeded to verify SQN_MS...
+       * Fetch User data, SQN_MS is derived from previous RAND
        */
+      int rc = hss_sqn_read (auth_info_req.imsi, &auth_info_resp);
+      if (rc != 0) {
+        result_code = rc;
+        /*
+         * Database query failed...
+         */
+        if (DIAMETER_ERROR_USER_UNKNOWN == result_code) {
+          experimental = 1;
+          goto out;
+        }
+        result_code = DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE;
+        experimental = 1;
+        goto out;
+      }
+
       /*
-       * Pick a new RAND and store SQN_MS + RAND in the HSS
+       * NULL if SQN_MS cannot be verified, the SQN is then not re-synchronised
        */
-      generate_random (vector[0].rand, RAND_LENGTH);
-      hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[0].rand, sqn);
-      hss_mysql_increment_sqn (auth_info_req.imsi);
-      free (sqn);
+      milenage_init (&milenage_ctx, auth_info_resp.opc, auth_info_resp.key);
+      sqn = sqn_ms_derive (&milenage_ctx, auts, auth_info_resp.rand);
+
+      for (int i = 0; (sqn == NULL) && (i < nb_pool_rands); i++) {
+        sqn = sqn_ms_derive (&milenage_ctx, auts, pool_rands[i]);
+      }
     }
 
     /*
-     * Fetch new user data
+     * Allocate the SQN of the vectors and store it with the last RAND in one request
      */
-    if (hss_mysql_auth_info (&auth_info_req, &auth_info_resp) != 0) {
+    int rc = hss_sqn_auth_info (auth_info_req.imsi, vector[num_vectors ? num_vectors - 1 : 0].rand, sqn, &auth_info_resp);
+    free (sqn);
+    sqn = NULL;
+
+    if (rc != 0) {
+      result_code = rc;
       /*
        * Database query failed...
        */
+      if (DIAMETER_ERROR_USER_UNKNOWN == result_code) {
+        experimental = 1;
+        goto out;
+      }
       result_code = DIAMETER_AUTHENTICATION_DATA_UNAVAILABLE;
       experimental = 1;
       goto out;
     }
 
-    sqn = auth_info_resp.sqn;
-    for (int i = 0; i < num_vectors; i++) {
-      generate_random (vector[i].rand, RAND_LENGTH);
-      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, sqn, &vector[i]);
-    }
-    hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[num_vectors-1].rand, sqn);
-  } else {
     /*
-     * Pick a new RAND and store SQN_MS + RAND in the HSS
+     * The key is expanded once for all the vectors, each vector has its own SQN
      */
-    for (int i = 0; i < num_vectors; i++) {
-      generate_random (vector[i].rand, RAND_LENGTH);
-      sqn = auth_info_resp.sqn;
-      /*
-       * Generate authentication vector
-       */
-      generate_vector (auth_info_resp.opc, imsi, auth_info_resp.key, hdr->avp_value->os.data, sqn, &vector[i]);
-    }
-    hss_mysql_push_rand_sqn (auth_info_req.imsi, vector[num_vectors-1].rand, sqn);
+    milenage_init (&milenage_ctx, auth_info_resp.opc, auth_info_resp.key);
+    generate_vectors (&milenage_ctx, imsi, hdr->avp_value->os.data, auth_info_resp.sqn,
+                      num_vectors - nb_pool_vectors, &vector[nb_pool_vectors]);
+
+    /*
+     * The vectors in the pool are older than the ones of this request
+     */
+    s6a_auth_pool_flush (auth_info_req.imsi, NULL, 0);
   }
 
-  hss_mysql_increment_sqn (auth_info_req.imsi);
   /*
    * We add the vector
    */
@@ -0,0 +1,408 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Authentication vectors generated ahead of the requests.
+ *
+ * The pool keeps up to AUTH_pool_size vectors for AUTH_pool_subscribers subscribers,
+ * in a table indexed by a hash of the IMSI (a subscriber takes over the slot of
+ * another one). An authentication information request takes the vectors of its
+ * subscriber in SQN order, the ones missing are generated by the request as before.
+ * The pool is then refilled by AUTH_pool_workers threads: a refill allocates the SQNs
+ * of its vectors with one hss_sqn_auth_info() like a request.
+ *
+ * The vectors handed out must have increasing SQNs. Each slot has an epoch, bumped by
+ * s6a_auth_pool_flush() once a request has allocated SQNs itself (vectors missing in
+ * the pool, re-synchronisation): a refill started before may hold older SQNs and is
+ * dropped, one started after allocates newer SQNs.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+#include "s6a_proto.h"
+#include "auc.h"
+#include "log.h"
+
+#define S6A_AUTH_POOL_NO_SLOT         (UINT32_MAX)
+
+typedef struct s6a_auth_pool_entry_s {
+  pthread_mutex_t                         lock;
+  /* Empty if the slot is free */
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint8_t                                 plmn[3];
+  uint32_t                                epoch;
+  /* In the refill queue or being refilled */
+  int                                     queued;
+  uint32_t                                next_queued;
+  /* Vectors not handed out yet, oldest SQN first */
+  int                                     first;
+  int                                     nb_vectors;
+  auc_vector_t                            vectors[HSS_AUTH_POOL_SIZE_MAX];
+  /* RANDs of the last vectors handed out, for the re-synchronisation */
+  int                                     last_rand;
+  int                                     nb_rands;
+  uint8_t                                 rands[S6A_AUTH_POOL_RANDS][RAND_LENGTH];
+} s6a_auth_pool_entry_t;
+
+static struct {
+  int                                     enabled;
+  int                                     size;
+  uint32_t                                nb_entries;
+  s6a_auth_pool_entry_t                  *entries;
+  /* Refill queue, FIFO of slots */
+  pthread_mutex_t                         queue_lock;
+  pthread_cond_t                          queue_cond;
+  uint32_t                                queue_head;
+  uint32_t                                queue_tail;
+  volatile int                            running;
+  int                                     nb_workers;
+  pthread_t                              *workers;
+  uint64_t                                hits;
+  uint64_t                                misses;
+  uint64_t                                dropped;
+} s6a_auth_pool;
+
+static uint32_t
+s6a_auth_pool_slot (
+  const char *imsi)
+{
+  uint32_t                                h = 2166136261u;
+
+  while (*imsi) {
+    h = (h ^ (uint8_t) * imsi++) * 16777619u;
+  }
+  return h % s6a_auth_pool.nb_entries;
+}
+
+/*
+ * Called with the lock of the entry
+ */
+static void
+s6a_auth_pool_queue (
+  uint32_t slot)
+{
+  s6a_auth_pool_entry_t                  *entry = &s6a_auth_pool.entries[slot];
+
+  if (entry->queued) {
+    return;
+  }
+  entry->queued = 1;
+  entry->next_queued = S6A_AUTH_POOL_NO_SLOT;
+  pthread_mutex_lock (&s6a_auth_pool.queue_lock);
+
+  if (s6a_auth_pool.queue_tail == S6A_AUTH_POOL_NO_SLOT) {
+    s6a_auth_pool.queue_head = slot;
+  } else {
+    s6a_auth_pool.entries[s6a_auth_pool.queue_tail].next_queued = slot;
+  }
+  s6a_auth_pool.queue_tail = slot;
+  pthread_cond_signal (&s6a_auth_pool.queue_cond);
+  pthread_mutex_unlock (&s6a_auth_pool.queue_lock);
+}
+
+/*
+ * Called with the lock of the entry, the vectors of the pool are dropped
+ */
+static void
+s6a_auth_pool_reset (
+  s6a_auth_pool_entry_t * entry)
+{
+  entry->first = 0;
+  entry->nb_vectors = 0;
+  entry->epoch++;
+}
+
+static void
+s6a_auth_pool_refill (
+  uint32_t slot)
+{
+  s6a_auth_pool_entry_t                  *entry = &s6a_auth_pool.entries[slot];
+  mysql_auth_info_resp_t                  auth_info_resp;
+  milenage_ctx_t                          milenage_ctx;
+  auc_vector_t                            vectors[HSS_AUTH_POOL_SIZE_MAX];
+  char                                    imsi[IMSI_LENGTH_MAX + 1];
+  uint64_t                                imsi_nb = 0;
+  uint8_t                                 plmn[3];
+  uint32_t                                epoch;
+  int                                     nb_vectors;
+  int                                     rc;
+
+  pthread_mutex_lock (&entry->lock);
+  strcpy (imsi, entry->imsi);
+  epoch = entry->epoch;
+  memcpy (plmn, entry->plmn, sizeof (plmn));
+  nb_vectors = s6a_auth_pool.size - entry->nb_vectors;
+  pthread_mutex_unlock (&entry->lock);
+
+  if ((imsi[0] == '\0') || (nb_vectors <= 0)) {
+    goto out;
+  }
+
+  for (int i = 0; i < nb_vectors; i++) {
+    generate_random (vectors[i].rand, RAND_LENGTH);
+  }
+
+  sscanf (imsi, "%" SCNu64, &imsi_nb);
+  rc = hss_sqn_auth_info (imsi, vectors[nb_vectors - 1].rand, NULL, &auth_info_resp);
+
+  if (rc != 0) {
+    FPRINTF_DEBUG ("Cannot refill the vectors of %s (%d)\n", imsi, rc);
+    goto out;
+  }
+
+  milenage_init (&milenage_ctx, auth_info_resp.opc, auth_info_resp.key);
+  generate_vectors (&milenage_ctx, imsi_nb, plmn, auth_info_resp.sqn, nb_vectors, vectors);
+  memset (&milenage_ctx, 0, sizeof (milenage_ctx));
+  memset (&auth_info_resp, 0, sizeof (auth_info_resp));
+
+  pthread_mutex_lock (&entry->lock);
+
+  if ((strcmp (entry->imsi, imsi) == 0) && (entry->epoch == epoch)) {
+    /*
+     * Behind the vectors left, their SQNs are lower
+     */
+    if (entry->first > 0) {
+      memmove (&entry->vectors[0], &entry->vectors[entry->first], entry->nb_vectors * sizeof (auc_vector_t));
+      entry->first = 0;
+    }
+
+    if (entry->nb_vectors + nb_vectors > s6a_auth_pool.size) {
+      nb_vectors = s6a_auth_pool.size - entry->nb_vectors;
+    }
+    memcpy (&entry->vectors[entry->nb_vectors], vectors, nb_vectors * sizeof (auc_vector_t));
+    entry->nb_vectors += nb_vectors;
+  } else {
+    __sync_fetch_and_add (&s6a_auth_pool.dropped, 1);
+  }
+  entry->queued = 0;
+  pthread_mutex_unlock (&entry->lock);
+  memset (vectors, 0, sizeof (vectors));
+  return;
+
+out:
+  pthread_mutex_lock (&entry->lock);
+  entry->queued = 0;
+  pthread_mutex_unlock (&entry->lock);
+}
+
+static void                            *
+s6a_auth_pool_worker (
+  void *arg)
+{
+  uint32_t                                slot;
+
+  while (1) {
+    pthread_mutex_lock (&s6a_auth_pool.queue_lock);
+
+    while (s6a_auth_pool.running && (s6a_auth_pool.queue_head == S6A_AUTH_POOL_NO_SLOT)) {
+      pthread_cond_wait (&s6a_auth_pool.queue_cond, &s6a_auth_pool.queue_lock);
+    }
+
+    if (!s6a_auth_pool.running) {
+      pthread_mutex_unlock (&s6a_auth_pool.queue_lock);
+      break;
+    }
+    slot = s6a_auth_pool.queue_head;
+    s6a_auth_pool.queue_head = s6a_auth_pool.entries[slot].next_queued;
+
+    if (s6a_auth_pool.queue_head == S6A_AUTH_POOL_NO_SLOT) {
+      s6a_auth_pool.queue_tail = S6A_AUTH_POOL_NO_SLOT;
+    }
+    pthread_mutex_unlock (&s6a_auth_pool.queue_lock);
+    s6a_auth_pool_refill (slot);
+  }
+  return NULL;
+}
+
+int
+s6a_auth_pool_init (
+  const hss_config_t * hss_config_p)
+{
+  uint32_t                                i;
+
+  memset (&s6a_auth_pool, 0, sizeof (s6a_auth_pool));
+
+  if ((hss_config_p->auth_pool_size <= 0) || (hss_config_p->auth_pool_subscribers <= 0)) {
+    return 0;
+  }
+
+  s6a_auth_pool.size = hss_config_p->auth_pool_size;
+  s6a_auth_pool.nb_entries = hss_config_p->auth_pool_subscribers;
+  s6a_auth_pool.nb_workers = hss_config_p->auth_pool_workers;
+  s6a_auth_pool.entries = calloc (s6a_auth_pool.nb_entries, sizeof (s6a_auth_pool_entry_t));
+  s6a_auth_pool.workers = calloc (s6a_auth_pool.nb_workers, sizeof (pthread_t));
+
+  if ((s6a_auth_pool.entries == NULL) || (s6a_auth_pool.workers == NULL)) {
+    FPRINTF_ERROR ("An error occured on MALLOC\n");
+    free (s6a_auth_pool.entries);
+    free (s6a_auth_pool.workers);
+    return ENOMEM;
+  }
+
+  for (i = 0; i < s6a_auth_pool.nb_entries; i++) {
+    pthread_mutex_init (&s6a_auth_pool.entries[i].lock, NULL);
+  }
+  pthread_mutex_init (&s6a_auth_pool.queue_lock, NULL);
+  pthread_cond_init (&s6a_auth_pool.queue_cond, NULL);
+  s6a_auth_pool.queue_head = S6A_AUTH_POOL_NO_SLOT;
+  s6a_auth_pool.queue_tail = S6A_AUTH_POOL_NO_SLOT;
+  s6a_auth_pool.running = 1;
+
+  for (int w = 0; w < s6a_auth_pool.nb_workers; w++) {
+    if (pthread_create (&s6a_auth_pool.workers[w], NULL, s6a_auth_pool_worker, NULL) != 0) {
+      FPRINTF_ERROR ("Cannot start the authentication vector workers\n");
+      s6a_auth_pool.nb_workers = w;
+      s6a_auth_pool_exit ();
+      return EAGAIN;
+    }
+  }
+  s6a_auth_pool.enabled = 1;
+  FPRINTF_NOTICE ("Pool of %d authentication vectors for %u subscribers, %d workers\n",
+                  s6a_auth_pool.size, s6a_auth_pool.nb_entries, s6a_auth_pool.nb_workers);
+  return 0;
+}
+
+void
+s6a_auth_pool_exit (
+  void)
+{
+  if (s6a_auth_pool.entries == NULL) {
+    return;
+  }
+  pthread_mutex_lock (&s6a_auth_pool.queue_lock);
+  s6a_auth_pool.running = 0;
+  pthread_cond_broadcast (&s6a_auth_pool.queue_cond);
+  pthread_mutex_unlock (&s6a_auth_pool.queue_lock);
+
+  for (int i = 0; i < s6a_auth_pool.nb_workers; i++) {
+    pthread_join (s6a_auth_pool.workers[i], NULL);
+  }
+
+  if (s6a_auth_pool.enabled) {
+    FPRINTF_NOTICE ("Authentication vector pool: %" PRIu64 " vectors from the pool, %" PRIu64 " generated by the requests, %" PRIu64 " refills dropped\n",
+                    s6a_auth_pool.hits, s6a_auth_pool.misses, s6a_auth_pool.dropped);
+  }
+
+  for (uint32_t i = 0; i < s6a_auth_pool.nb_entries; i++) {
+    pthread_mutex_destroy (&s6a_auth_pool.entries[i].lock);
+  }
+  pthread_mutex_destroy (&s6a_auth_pool.queue_lock);
+  pthread_cond_destroy (&s6a_auth_pool.queue_cond);
+  memset (s6a_auth_pool.entries, 0, s6a_auth_pool.nb_entries * sizeof (s6a_auth_pool_entry_t));
+  free (s6a_auth_pool.entries);
+  free (s6a_auth_pool.workers);
+  memset (&s6a_auth_pool, 0, sizeof (s6a_auth_pool));
+}
+
+int
+s6a_auth_pool_get (
+  const char *imsi,
+  const uint8_t plmn[3],
+  struct auc_vector_s * vectors,
+  int nb_vectors)
+{
+  s6a_auth_pool_entry_t                  *entry;
+  uint32_t                                slot;
+  int                                     nb = 0;
+
+  if (!s6a_auth_pool.enabled || (nb_vectors <= 0)) {
+    return 0;
+  }
+
+  slot = s6a_auth_pool_slot (imsi);
+  entry = &s6a_auth_pool.entries[slot];
+  pthread_mutex_lock (&entry->lock);
+
+  if (strcmp (entry->imsi, imsi) != 0) {
+    s6a_auth_pool_reset (entry);
+    snprintf (entry->imsi, sizeof (entry->imsi), "%s", imsi);
+    entry->nb_rands = 0;
+    memcpy (entry->plmn, plmn, sizeof (entry->plmn));
+  } else if (memcmp (entry->plmn, plmn, sizeof (entry->plmn)) != 0) {
+    /*
+     * KASME is bound to the serving network
+     */
+    s6a_auth_pool_reset (entry);
+    memcpy (entry->plmn, plmn, sizeof (entry->plmn));
+  }
+
+  nb = (entry->nb_vectors < nb_vectors) ? entry->nb_vectors : nb_vectors;
+  memcpy (vectors, &entry->vectors[entry->first], nb * sizeof (auc_vector_t));
+  memset (&entry->vectors[entry->first], 0, nb * sizeof (auc_vector_t));
+  entry->first += nb;
+  entry->nb_vectors -= nb;
+
+  for (int i = 0; i < nb; i++) {
+    entry->last_rand = (entry->last_rand + 1) % S6A_AUTH_POOL_RANDS;
+    memcpy (entry->rands[entry->last_rand], vectors[i].rand, RAND_LENGTH);
+
+    if (entry->nb_rands < S6A_AUTH_POOL_RANDS) {
+      entry->nb_rands++;
+    }
+  }
+
+  if (entry->nb_vectors <= s6a_auth_pool.size / 2) {
+    s6a_auth_pool_queue (slot);
+  }
+  pthread_mutex_unlock (&entry->lock);
+  __sync_fetch_and_add (&s6a_auth_pool.hits, nb);
+  __sync_fetch_and_add (&s6a_auth_pool.misses, nb_vectors - nb);
+  return nb;
+}
+
+int
+s6a_auth_pool_flush (
+  const char *imsi,
+  uint8_t rands[][16],
+  int max_rands)
+{
+  s6a_auth_pool_entry_t                  *entry;
+  int                                     nb = 0;
+
+  if (!s6a_auth_pool.enabled) {
+    return 0;
+  }
+  entry = &s6a_auth_pool.entries[s6a_auth_pool_slot (imsi)];
+  pthread_mutex_lock (&entry->lock);
+
+  if (strcmp (entry->imsi, imsi) == 0) {
+    s6a_auth_pool_reset (entry);
+
+    /*
+     * Most recent first
+     */
+    for (nb = 0; (rands != NULL) && (nb < entry->nb_rands) && (nb < max_rands); nb++) {
+      int                                     i = (entry->last_rand + S6A_AUTH_POOL_RANDS - nb) % S6A_AUTH_POOL_RANDS;
+
+      memcpy (rands[nb], entry->rands[i], RAND_LENGTH);
+    }
+  }
+  pthread_mutex_unlock (&entry->lock);
+  return nb;
+}
@@ -214,6 +214,40 @@ int s6a_up_loc_cb(struct msg **msg, struct avp *paramavp,
                   struct session *sess, void *opaque,
                   enum disp_action *act);
 
+/* RANDs of the vectors handed out by the pool kept for the re-synchronisation */
+#define S6A_AUTH_POOL_RANDS (2 * HSS_AUTH_POOL_SIZE_MAX)
+
+struct auc_vector_s;
+
+/** \brief Start the workers of the pool of authentication vectors, the pool is
+ * disabled when AUTH_pool_size is 0
+ * \param hss_config_p pointer the global HSS configuration
+ * @returns 0 if the init was successfull, != 0 in case of failure
+ */
+int s6a_auth_pool_init(const hss_config_t *hss_config_p);
+void s6a_auth_pool_exit(void);
+
+/** \brief Take the vectors of a subscriber generated in advance, and queue a
+ * refill. The SQNs of the vectors are increasing.
+ * \param imsi IMSI of the subscriber
+ * \param plmn Visited PLMN, KASME is derived from it
+ * \param vectors Vectors returned
+ * \param nb_vectors Vectors requested
+ * @returns the number of vectors returned, the caller generates the others
+ * then calls s6a_auth_pool_flush()
+ */
+int s6a_auth_pool_get(const char *imsi, const uint8_t plmn[3],
+                      struct auc_vector_s *vectors, int nb_vectors);
+
+/** \brief Drop the vectors of a subscriber after its SQN was allocated out of
+ * the pool (vectors missing, re-synchronisation)
+ * \param imsi IMSI of the subscriber
+ * \param rands If not NULL, RANDs of the last vectors handed out, most recent first
+ * \param max_rands Size of rands
+ * @returns the number of RANDs returned
+ */
+int s6a_auth_pool_flush(const char *imsi, uint8_t rands[][16], int max_rands);
+
 int s6a_purge_ue_cb(struct msg **msg, struct avp *paramavp,
                     struct session *sess, void *opaque,
                     enum disp_action *act);
@@ -48,7 +48,7 @@ s6a_add_subscription_data_avp (
     return -1;
   }
 
-  ret = hss_mysql_query_pdns (mysql_ans->imsi, &pdns, &nb_pdns);
+  ret = hss_db_query_pdns (mysql_ans->imsi, &pdns, &nb_pdns);
 
   if (ret != 0) {
     /*
@@ -98,7 +98,7 @@ s6a_up_loc_cb (
     // ...
     sprintf (mysql_push.imsi, "%*s", (int)hdr->avp_value->os.len, (char *)hdr->avp_value->os.data);
 
-    if ((ret = hss_mysql_update_loc (mysql_push.imsi, &mysql_ans)) != 0) {
+    if ((ret = hss_db_update_loc (mysql_push.imsi, &mysql_ans)) != 0) {
       /*
        * We failed to find the IMSI in the database. Replying to the request
        * * * * with the user unknown cause.
@@ -434,7 +434,7 @@ s6a_up_loc_cb (
     }
   }
 
-  mysql_push_up_loc (&mysql_push);
+  hss_db_push_up_loc (&mysql_push);
   /*
    * ULA flags
    */
@@ -0,0 +1,218 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Load test of the HSS database layer, against a MySQL/MariaDB server loaded with oai_db.sql
+ * or against the local database (-b local), loaded from oai_db.sql when its file is empty.
+ * N threads, like the freeDiameter worker threads, replay the queries of an AIR
+ * (auth info, push rand/sqn, increment sqn) and of an ULR (update loc, pdns)
+ * for the IMSIs of the users table with PDNs, over a pool of P MySQL connections.
+ *
+ * usage: hss_db_load_test [-b mysql] -s server -u user -p password -d database [-c connections] [-t threads] [-n requests per thread]
+ *        hss_db_load_test -b local -f file [-i oai_db.sql] [-t threads] [-n requests per thread]
+ *
+ * WARNING: the SQN and RAND of the subscribers are modified.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "hss_config.h"
+#include "db_proto.h"
+
+#define LOAD_TEST_IMSI_MAX 100000
+
+typedef struct load_test_thread_s {
+  pthread_t                               thread;
+  int                                     nb_requests;
+  int                                     nb_errors;
+  uint64_t                                air_ns;
+  uint64_t                                ulr_ns;
+} load_test_thread_t;
+
+static char                             (*imsis)[IMSI_LENGTH_MAX + 1] = NULL;
+static int                                nb_imsis = 0;
+
+static uint64_t
+load_test_now_ns (
+  void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void                            *
+load_test_thread (
+  void *arg)
+{
+  load_test_thread_t                     *t = (load_test_thread_t *) arg;
+  unsigned int                            seed = (unsigned int)(uintptr_t) t;
+  int                                     i;
+
+  for (i = 0; i < t->nb_requests; i++) {
+    mysql_auth_info_req_t                   air_req = {{0}};
+    mysql_auth_info_resp_t                  air_resp = {{0}};
+    mysql_ul_ans_t                          ul_ans = {{0}};
+    mysql_pdn_t                            *pdns = NULL;
+    uint8_t                                 nb_pdns = 0;
+    uint8_t                                 rand_p[RAND_LENGTH];
+    const char                             *imsi = imsis[rand_r (&seed) % nb_imsis];
+    uint64_t                                start_ns = load_test_now_ns ();
+
+    strcpy (air_req.imsi, imsi);
+    memset (rand_p, i, sizeof (rand_p));
+
+    if (hss_db_auth_info (&air_req, &air_resp) || hss_db_push_rand_sqn (imsi, rand_p, air_resp.sqn) || hss_db_increment_sqn (imsi)) {
+      t->nb_errors++;
+    }
+    t->air_ns += load_test_now_ns () - start_ns;
+
+    start_ns = load_test_now_ns ();
+    if (hss_db_update_loc (imsi, &ul_ans) || hss_db_query_pdns (imsi, &pdns, &nb_pdns)) {
+      t->nb_errors++;
+    }
+    t->ulr_ns += load_test_now_ns () - start_ns;
+    free (pdns);
+  }
+  return NULL;
+}
+
+static void
+load_test_add_imsi (
+  const char *imsi,
+  void *arg)
+{
+  if (nb_imsis < LOAD_TEST_IMSI_MAX) {
+    snprintf (imsis[nb_imsis++], IMSI_LENGTH_MAX + 1, "%s", imsi);
+  }
+}
+
+static int
+load_test_read_imsis (
+  void)
+{
+  mysql_pdn_t                            *pdns = NULL;
+  uint8_t                                 nb_pdns = 0;
+  int                                     i;
+  int                                     j;
+
+  if (((imsis = calloc (LOAD_TEST_IMSI_MAX, sizeof (*imsis))) == NULL) || hss_db_list_users (load_test_add_imsi, NULL)) {
+    fprintf (stderr, "Cannot read the IMSIs\n");
+    return -1;
+  }
+
+  /*
+   * Only the subscribers with PDNs can attach
+   */
+  for (i = 0, j = 0; i < nb_imsis; i++) {
+    if (hss_db_query_pdns (imsis[i], &pdns, &nb_pdns) == 0) {
+      memmove (imsis[j++], imsis[i], IMSI_LENGTH_MAX + 1);
+    }
+    free (pdns);
+    pdns = NULL;
+  }
+  nb_imsis = j;
+  return nb_imsis ? 0 : -1;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  hss_config_t                            hss_config = {0};
+  load_test_thread_t                     *threads = NULL;
+  int                                     nb_threads = 8;
+  int                                     nb_requests = 1000;
+  int                                     nb_errors = 0;
+  uint64_t                                air_ns = 0;
+  uint64_t                                ulr_ns = 0;
+  uint64_t                                start_ns = 0;
+  double                                  elapsed_s = 0;
+  int                                     c;
+  int                                     i;
+
+  hss_config.mysql_pool_size = HSS_MYSQL_POOL_SIZE_DEFAULT;
+
+  while ((c = getopt (argc, argv, "b:f:i:s:u:p:d:c:t:n:")) != -1) {
+    switch (c) {
+    case 'b': hss_config.db_backend = optarg; break;
+    case 'f': hss_config.local_db_file = optarg; break;
+    case 'i': hss_config.local_db_import = optarg; break;
+    case 's': hss_config.mysql_server = optarg; break;
+    case 'u': hss_config.mysql_user = optarg; break;
+    case 'p': hss_config.mysql_password = optarg; break;
+    case 'd': hss_config.mysql_database = optarg; break;
+    case 'c': hss_config.mysql_pool_size = atoi (optarg); break;
+    case 't': nb_threads = atoi (optarg); break;
+    case 'n': nb_requests = atoi (optarg); break;
+    default:
+      fprintf (stderr, "usage: %s [-b mysql] -s server -u user -p password -d database [-c connections] [-t threads] [-n requests per thread]\n"
+               "       %s -b local -f file [-i oai_db.sql] [-t threads] [-n requests per thread]\n", argv[0], argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ((nb_threads <= 0) || (nb_requests <= 0) || hss_db_connect (&hss_config) || load_test_read_imsis ()) {
+    fprintf (stderr, "Initialization failed\n");
+    return EXIT_FAILURE;
+  }
+
+  /*
+   * The queries print the subscriber data, keep only the report
+   */
+  if (freopen ("/dev/null", "w", stdout) == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  threads = calloc (nb_threads, sizeof (load_test_thread_t));
+  start_ns = load_test_now_ns ();
+
+  for (i = 0; i < nb_threads; i++) {
+    threads[i].nb_requests = nb_requests;
+    pthread_create (&threads[i].thread, NULL, load_test_thread, &threads[i]);
+  }
+
+  for (i = 0; i < nb_threads; i++) {
+    pthread_join (threads[i].thread, NULL);
+    nb_errors += threads[i].nb_errors;
+    air_ns += threads[i].air_ns;
+    ulr_ns += threads[i].ulr_ns;
+  }
+
+  elapsed_s = (load_test_now_ns () - start_ns) / 1e9;
+  fprintf (stderr, "%d IMSIs, %s database, %d threads x %d AIR+ULR: %.2f s, %.0f AIR+ULR/s, "
+           "mean AIR %.0f us, mean ULR %.0f us, %d errors\n",
+           nb_imsis, (hss_config.db_backend == NULL) ? "mysql" : hss_config.db_backend, nb_threads, nb_requests, elapsed_s, nb_threads * nb_requests / elapsed_s,
+           air_ns / 1e3 / (nb_threads * nb_requests), ulr_ns / 1e3 / (nb_threads * nb_requests), nb_errors);
+  hss_db_disconnect ();
+  free (threads);
+  free (imsis);
+  return nb_errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
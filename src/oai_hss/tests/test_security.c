@@ -24,7 +24,10 @@
 #include <unistd.h>
 #include <string.h>
 
-#include "config.h"
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "test_utils.h"
 #include "test_fd.h"
 
@@ -84,10 +87,13 @@ doit (
   int                                     i;
 
   for (i = 0; i < sizeof (test_set) / sizeof (test_set_t); i++) {
+    milenage_ctx_t                          ctx;
+    uint8_t                                 opc[16];
     uint8_t                                 res[8];
 
-    SetOPc (test_set[i].op);
-    f1 (test_set[i].key, test_set[i].rand, test_set[i].sqn, test_set[i].amf, res);
+    ComputeOPc (test_set[i].key, test_set[i].op, opc);
+    milenage_init (&ctx, opc, test_set[i].key);
+    milenage_f1 (&ctx, test_set[i].rand, test_set[i].sqn, test_set[i].amf, res);
 
     //         printf("%02x%02x%02x%02x%02x%02x%02x%02x\n", res[0], res[1], res[2],
     //                res[3], res[4], res[5], res[6], res[7]);
@@ -97,7 +103,7 @@ doit (
       success ("Test set %d (f1) : success\n", i);
     }
 
-    f1star (test_set[i].key, test_set[i].rand, test_set[i].sqn, test_set[i].amf, res);
+    milenage_f1star (&ctx, test_set[i].rand, test_set[i].sqn, test_set[i].amf, res);
 
     //         printf("%02x%02x%02x%02x%02x%02x%02x%02x\n", res[0], res[1], res[2],
     //                res[3], res[4], res[5], res[6], res[7]);
@@ -24,7 +24,10 @@
 #include <unistd.h>
 #include <string.h>
 
-#include "config.h"
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "test_utils.h"
 #include "test_fd.h"
 
@@ -41,16 +44,19 @@ do_f1_f1star (
   uint8_t * f1_exp,
   uint8_t * f1star_exp)
 {
+  milenage_ctx_t                          ctx;
+  uint8_t                                 opc[16];
   uint8_t                                 res[8];
 
-  SetOPc (op);
-  f1 (key, rand, sqn, amf, res);
+  ComputeOPc (key, op, opc);
+  milenage_init (&ctx, opc, key);
+  milenage_f1 (&ctx, rand, sqn, amf, res);
 
   if (compare_buffer (res, 8, f1_exp, 8) != 0) {
     fail ("Fail: f1");
   }
 
-  f1star (key, rand, sqn, amf, res);
+  milenage_f1star (&ctx, rand, sqn, amf, res);
 
   if (compare_buffer (res, 8, f1star_exp, 8) != 0) {
     fail ("Fail: f1*");
@@ -24,7 +24,10 @@
 #include <unistd.h>
 #include <string.h>
 
-#include "config.h"
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "test_utils.h"
 #include "test_fd.h"
 
@@ -44,15 +47,18 @@ do_f4f5star (
   uint8_t                                 res_f3[16];
   uint8_t                                 res_f4[16];
   uint8_t                                 res_f5star[6];
+  milenage_ctx_t                          ctx;
+  uint8_t                                 opc[16];
 
-  SetOPc (op);
-  f2345 (key, rand, res_f2, res_f3, res_f4, res_f5);
+  ComputeOPc (key, op, opc);
+  milenage_init (&ctx, opc, key);
+  milenage_f2345 (&ctx, rand, res_f2, res_f3, res_f4, res_f5);
 
   if (compare_buffer (res_f4, 16, f4_exp, 16) != 0) {
     fail ("Fail: f4");
   }
 
-  f5star (key, rand, res_f5star);
+  milenage_f5star (&ctx, rand, res_f5star);
 
   if (compare_buffer (res_f5star, 6, f5star_exp, 6) != 0) {
     fail ("Fail: f5star");
@@ -25,7 +25,10 @@
 #include <unistd.h>
 #include <string.h>
 
-#include "config.h"
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include "test_utils.h"
 #include "test_fd.h"
 
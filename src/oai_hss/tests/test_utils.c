@@ -0,0 +1,147 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "test_utils.h"
+
+int                                     debug = 0;
+int                                     error_count = 0;
+
+void
+fail (
+  const char *format,
+  ...)
+{
+  va_list                                 args;
+
+  va_start (args, format);
+  vfprintf (stderr, format, args);
+  va_end (args);
+  if ((format[0]) && (format[strlen (format) - 1] != '\n')) {
+    fprintf (stderr, "\n");
+  }
+  error_count++;
+}
+
+void
+success (
+  const char *format,
+  ...)
+{
+  va_list                                 args;
+
+  if (!debug) {
+    return;
+  }
+  va_start (args, format);
+  vfprintf (stdout, format, args);
+  va_end (args);
+}
+
+int
+compare_buffer (
+  const uint8_t * const buffer,
+  const uint32_t length_buffer,
+  const uint8_t * const pattern,
+  const uint32_t length_pattern)
+{
+  if (length_buffer != length_pattern) {
+    fail ("Length mismatch, expecting %u, got %u\n", length_pattern, length_buffer);
+    return -1;
+  }
+  if (memcmp (buffer, pattern, length_buffer) != 0) {
+    if (debug) {
+      fprintf (stderr, "Expecting:");
+      for (uint32_t i = 0; i < length_pattern; i++) {
+        fprintf (stderr, " %02x", pattern[i]);
+      }
+      fprintf (stderr, "\nReceived: ");
+      for (uint32_t i = 0; i < length_buffer; i++) {
+        fprintf (stderr, " %02x", buffer[i]);
+      }
+      fprintf (stderr, "\n");
+    }
+    return -1;
+  }
+  return 0;
+}
+
+uint8_t *
+decode_hex (
+  const char * const hex)
+{
+  static uint8_t                          buffers[TEST_HEX_BUFFERS][TEST_HEX_MAX_LENGTH];
+  static unsigned int                     next = 0;
+  uint8_t                                *buffer = buffers[next];
+  unsigned int                            length = 0;
+  const char                             *p = hex;
+
+  next = (next + 1) % TEST_HEX_BUFFERS;
+  memset (buffer, 0, TEST_HEX_MAX_LENGTH);
+  while (*p) {
+    if (isspace ((unsigned char)*p)) {
+      p++;
+      continue;
+    }
+    if ((!isxdigit ((unsigned char)p[0])) || (!isxdigit ((unsigned char)p[1])) || (length == TEST_HEX_MAX_LENGTH)) {
+      fprintf (stderr, "Bad hexadecimal string \"%s\"\n", hex);
+      exit (EXIT_FAILURE);
+    }
+    sscanf (p, "%2hhx", &buffer[length++]);
+    p += 2;
+  }
+  return buffer;
+}
+
+unsigned int
+decode_hex_length (
+  const char * const hex)
+{
+  unsigned int                            nb_digits = 0;
+
+  for (const char *p = hex; *p; p++) {
+    if (!isspace ((unsigned char)*p)) {
+      nb_digits++;
+    }
+  }
+  return nb_digits / 2;
+}
+
+int
+main (
+  int argc,
+  char *argv[])
+{
+  if ((argc > 1) && (strcmp (argv[1], "-v") == 0)) {
+    debug = 1;
+  }
+  doit ();
+  if (debug) {
+    printf ("Self test `%s' finished with %d errors\n", argv[0], error_count);
+  }
+  return error_count ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -18,31 +18,38 @@
  * For more information about the OpenAirInterface (OAI) Software Alliance:
  *      contact@openairinterface.org
  */
-/*! \file gtpv1u_task.c
-  \brief
-  \author Lionel Gauthier
-  \company Eurecom
-  \email: lionel.gauthier@eurecom.fr
-*/
-#include <stdlib.h>
+
+#ifndef TEST_UTILS_H_
+#define TEST_UTILS_H_
+
 #include <stdint.h>
 
-#include "gtpv1u.h"
-
-//#define GTPV1U_LINEAR_TEID_ALLOCATION 1
-
-#if GTPV1U_LINEAR_TEID_ALLOCATION
-static uint32_t                         g_gtpv1u_teid = 0;
-#endif
-
-uint32_t
-gtpv1u_new_teid (
-  void)
-{
-#if GTPV1U_LINEAR_TEID_ALLOCATION
-  g_gtpv1u_teid = g_gtpv1u_teid + 1;
-  return g_gtpv1u_teid;
-#else
-  return random () + random () % (RAND_MAX - 1) + 1;
-#endif
-}
+/* Set by the -v command line option, success() only prints when set */
+extern int debug;
+extern int error_count;
+
+void fail (const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+
+void success (const char *format, ...) __attribute__ ((format (printf, 1, 2)));
+
+int compare_buffer (const uint8_t * const buffer, const uint32_t length_buffer, const uint8_t * const pattern, const uint32_t length_pattern);
+
+/*
+ * Decode a string of hexadecimal digits, spaces are skipped. The result is in one of
+ * TEST_HEX_BUFFERS static buffers reused in turn, enough for the arguments of one call.
+ */
+#define TEST_HEX_BUFFERS     16
+#define TEST_HEX_MAX_LENGTH  256
+
+uint8_t *decode_hex (const char * const hex);
+
+/* Number of bytes decoded from hex */
+unsigned int decode_hex_length (const char * const hex);
+
+#define H(x)  decode_hex (x)
+#define HL(x) decode_hex (x), decode_hex_length (x)
+
+/* Test body, implemented by each test and called by main() */
+void doit (void);
+
+#endif  /* TEST_UTILS_H_ */
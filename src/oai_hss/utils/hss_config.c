@@ -55,12 +55,23 @@
 #endif
 
 #define HSS_CONFIG_STRING_MAIN_SECTION             "HSS"
+#define HSS_CONFIG_STRING_DB_BACKEND               "DB_backend"
+#define HSS_CONFIG_STRING_LOCAL_DB_FILE            "LOCAL_db_file"
+#define HSS_CONFIG_STRING_LOCAL_DB_IMPORT          "LOCAL_db_import"
 #define HSS_CONFIG_STRING_MYSQL_SERVER             "MYSQL_server"
 #define HSS_CONFIG_STRING_MYSQL_USER               "MYSQL_user"
 #define HSS_CONFIG_STRING_MYSQL_PASS               "MYSQL_pass"
 #define HSS_CONFIG_STRING_MYSQL_DB                 "MYSQL_db"
+#define HSS_CONFIG_STRING_MYSQL_POOL_SIZE          "MYSQL_pool_size"
 #define HSS_CONFIG_STRING_OPERATOR_KEY             "OPERATOR_key"
 #define HSS_CONFIG_STRING_RANDOM                   "RANDOM"
+#define HSS_CONFIG_STRING_SQN_WRITE_BEHIND         "SQN_write_behind"
+#define HSS_CONFIG_STRING_CACHE_SIZE               "CACHE_size"
+#define HSS_CONFIG_STRING_CACHE_TTL                "CACHE_ttl"
+#define HSS_CONFIG_STRING_CACHE_WARM_LOAD          "CACHE_warm_load"
+#define HSS_CONFIG_STRING_AUTH_POOL_SIZE           "AUTH_pool_size"
+#define HSS_CONFIG_STRING_AUTH_POOL_SUBSCRIBERS    "AUTH_pool_subscribers"
+#define HSS_CONFIG_STRING_AUTH_POOL_WORKERS        "AUTH_pool_workers"
 #define HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE   "FD_conf"
 
 
@@ -129,6 +140,45 @@ hss_config_init (
     FPRINTF_ERROR( "Default values for random: %s (allowed values {true,false})\n", hss_config_p->random);
   }
 
+  if (hss_config_p->sqn_write_behind) {
+    if (strcasecmp (hss_config_p->sqn_write_behind, "false") == 0) {
+      hss_config_p->sqn_write_behind_bool = 0;
+    } else if (strcasecmp (hss_config_p->sqn_write_behind, "true") == 0) {
+      hss_config_p->sqn_write_behind_bool = 1;
+    } else {
+      FPRINTF_ERROR( "Error in configuration file: SQN write behind: %s (allowed values {true,false})\n", hss_config_p->sqn_write_behind);
+      abort ();
+    }
+  } else {
+    hss_config_p->sqn_write_behind = "false";
+    hss_config_p->sqn_write_behind_bool = 0;
+  }
+
+  if (hss_config_p->cache_warm_load) {
+    if (strcasecmp (hss_config_p->cache_warm_load, "false") == 0) {
+      hss_config_p->cache_warm_load_bool = 0;
+    } else if (strcasecmp (hss_config_p->cache_warm_load, "true") == 0) {
+      hss_config_p->cache_warm_load_bool = 1;
+    } else {
+      FPRINTF_ERROR( "Error in configuration file: cache warm load: %s (allowed values {true,false})\n", hss_config_p->cache_warm_load);
+      abort ();
+    }
+  } else {
+    hss_config_p->cache_warm_load = "false";
+    hss_config_p->cache_warm_load_bool = 0;
+  }
+
+  if ((hss_config_p->cache_size < 0) || (hss_config_p->cache_ttl < 0)) {
+    FPRINTF_ERROR( "Error in configuration file: negative cache size or TTL\n");
+    abort ();
+  }
+
+  if ((hss_config_p->auth_pool_size < 0) || (hss_config_p->auth_pool_size > HSS_AUTH_POOL_SIZE_MAX) ||
+      (hss_config_p->auth_pool_subscribers < 0) || (hss_config_p->auth_pool_workers < 1)) {
+    FPRINTF_ERROR( "Error in configuration file: authentication vector pool size (0..%d), subscribers or workers (>= 1)\n", HSS_AUTH_POOL_SIZE_MAX);
+    abort ();
+  }
+
   // post processing for op key
   if (hss_config_p->operator_key) {
     if (strlen (hss_config_p->operator_key) == 32) {
@@ -187,16 +237,30 @@ hss_config_display (
   FPRINTF_NOTICE ( "Configuration\n");
   FPRINTF_NOTICE ( "* Global:\n");
   FPRINTF_NOTICE ( "\t- File .............: %s\n", hss_config_p->config);
+  FPRINTF_NOTICE ( "* Database .........: %s\n", hss_config_p->db_backend);
+  FPRINTF_NOTICE ( "* LOCAL:\n");
+  FPRINTF_NOTICE ( "\t- File .............: %s\n", hss_config_p->local_db_file);
+  FPRINTF_NOTICE ( "\t- Import ...........: %s\n", hss_config_p->local_db_import);
   FPRINTF_NOTICE ( "* MYSQL:\n");
   FPRINTF_NOTICE ( "\t- Server ...........: %s\n", hss_config_p->mysql_server);
   FPRINTF_NOTICE ( "\t- Database .........: %s\n", hss_config_p->mysql_database);
   FPRINTF_NOTICE ( "\t- User .............: %s\n", hss_config_p->mysql_user);
   FPRINTF_NOTICE ( "\t- Password .........: %s\n", (hss_config_p->mysql_password == NULL) ? "None" : "*****");
+  FPRINTF_NOTICE ( "\t- Connections ......: %d\n", hss_config_p->mysql_pool_size);
   FPRINTF_NOTICE ( "* FreeDiameter:\n");
   FPRINTF_NOTICE ( "\t- Conf file ........: %s\n", hss_config_p->freediameter_config);
   FPRINTF_NOTICE ( "* Security:\n");
   FPRINTF_NOTICE ( "\t- Operator key......: %s\n", (hss_config_p->operator_key == NULL) ? "None" : "********************************");
   FPRINTF_NOTICE ( "\t- Random      ......: %s\n", hss_config_p->random);
+  FPRINTF_NOTICE ( "\t- SQN write behind..: %s\n", hss_config_p->sqn_write_behind);
+  FPRINTF_NOTICE ( "* Subscriber cache:\n");
+  FPRINTF_NOTICE ( "\t- Size .............: %d\n", hss_config_p->cache_size);
+  FPRINTF_NOTICE ( "\t- TTL ..............: %d s\n", hss_config_p->cache_ttl);
+  FPRINTF_NOTICE ( "\t- Warm load ........: %s\n", hss_config_p->cache_warm_load);
+  FPRINTF_NOTICE ( "* Authentication vector pool:\n");
+  FPRINTF_NOTICE ( "\t- Vectors ..........: %d\n", hss_config_p->auth_pool_size);
+  FPRINTF_NOTICE ( "\t- Subscribers ......: %d\n", hss_config_p->auth_pool_subscribers);
+  FPRINTF_NOTICE ( "\t- Workers ..........: %d\n", hss_config_p->auth_pool_workers);
 }
 
 static int
@@ -248,6 +312,7 @@ hss_config_parse_file (
   config_t                                cfg;
   const char                             *astring = NULL;
   config_setting_t                       *setting = NULL;
+  int                                     mysql_required = 1;
 
   if (hss_config_p == NULL) {
     return ret;
@@ -267,34 +332,58 @@ hss_config_parse_file (
   setting = config_lookup(&cfg, HSS_CONFIG_STRING_MAIN_SECTION);
   if (setting != NULL) {
 
+    // optional
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_DB_BACKEND, (const char **)&astring) )) {
+      hss_config_p->db_backend = strdup(astring);
+    } else {
+      hss_config_p->db_backend = strdup("mysql");
+    }
+    mysql_required = (strcasecmp(hss_config_p->db_backend, "mysql") == 0);
+
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_LOCAL_DB_FILE, (const char **)&astring) )) {
+      hss_config_p->local_db_file = strdup(astring);
+    } else if (! mysql_required) {
+      FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_LOCAL_DB_FILE);
+      return ret;
+    }
+
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_LOCAL_DB_IMPORT, (const char **)&astring) )) {
+      hss_config_p->local_db_import = strdup(astring);
+    }
+
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_MYSQL_SERVER, (const char **)&astring) )) {
       hss_config_p->mysql_server = strdup(astring);
-    } else {
+    } else if (mysql_required) {
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s astring %s!\n", HSS_CONFIG_STRING_MYSQL_SERVER, astring);
       return ret;
     }
 
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_MYSQL_USER, (const char **)&astring) )) {
       hss_config_p->mysql_user = strdup(astring);
-    } else {
+    } else if (mysql_required) {
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_MYSQL_USER);
       return ret;
     }
 
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_MYSQL_PASS, (const char **)&astring) )) {
       hss_config_p->mysql_password = strdup(astring);
-    } else {
+    } else if (mysql_required) {
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_MYSQL_PASS);
       return ret;
     }
 
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_MYSQL_DB, (const char **)&astring) )) {
       hss_config_p->mysql_database = strdup(astring);
-    } else {
+    } else if (mysql_required) {
       FPRINTF_ERROR( "Failed to parse HSS configuration file token %s!\n", HSS_CONFIG_STRING_MYSQL_DB);
       return ret;
     }
 
+    // optional
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_MYSQL_POOL_SIZE, &hss_config_p->mysql_pool_size)) {
+      hss_config_p->mysql_pool_size = HSS_MYSQL_POOL_SIZE_DEFAULT;
+    }
+
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_OPERATOR_KEY, (const char **)&astring) )) {
       hss_config_p->operator_key = strdup(astring);
     } else {
@@ -309,6 +398,37 @@ hss_config_parse_file (
       return ret;
    }
 
+    // optional
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_SQN_WRITE_BEHIND, (const char **)&astring) )) {
+      hss_config_p->sqn_write_behind = strdup(astring);
+    }
+
+    // optional
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_CACHE_SIZE, &hss_config_p->cache_size)) {
+      hss_config_p->cache_size = HSS_CACHE_SIZE_DEFAULT;
+    }
+
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_CACHE_TTL, &hss_config_p->cache_ttl)) {
+      hss_config_p->cache_ttl = HSS_CACHE_TTL_DEFAULT;
+    }
+
+    if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_CACHE_WARM_LOAD, (const char **)&astring) )) {
+      hss_config_p->cache_warm_load = strdup(astring);
+    }
+
+    // optional
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_AUTH_POOL_SIZE, &hss_config_p->auth_pool_size)) {
+      hss_config_p->auth_pool_size = HSS_AUTH_POOL_SIZE_DEFAULT;
+    }
+
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_AUTH_POOL_SUBSCRIBERS, &hss_config_p->auth_pool_subscribers)) {
+      hss_config_p->auth_pool_subscribers = HSS_AUTH_POOL_SUBSCRIBERS_DEFAULT;
+    }
+
+    if (! config_setting_lookup_int( setting, HSS_CONFIG_STRING_AUTH_POOL_WORKERS, &hss_config_p->auth_pool_workers)) {
+      hss_config_p->auth_pool_workers = HSS_AUTH_POOL_WORKERS_DEFAULT;
+    }
+
     if (  (config_setting_lookup_string( setting, HSS_CONFIG_STRING_FREEDIAMETER_CONF_FILE, (const char **)&astring) )) {
      hss_config_p->freediameter_config = strdup(astring);
     } else {
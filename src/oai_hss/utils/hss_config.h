@@ -22,12 +22,36 @@
 #ifndef HSS_CONFIG_H_
 #define HSS_CONFIG_H_
 
+/* Default number of MySQL connections used by the S6a threads */
+#define HSS_MYSQL_POOL_SIZE_DEFAULT (4)
+#define HSS_MYSQL_POOL_SIZE_MAX     (64)
+
+/* Subscriber cache disabled unless configured */
+#define HSS_CACHE_SIZE_DEFAULT      (0)
+#define HSS_CACHE_TTL_DEFAULT       (300)
+
+/* Authentication vectors generated in advance, disabled unless configured. The
+   vectors of a refill use consecutive SQNs, below the SQN of the next refill (32 above) */
+#define HSS_AUTH_POOL_SIZE_DEFAULT        (0)
+#define HSS_AUTH_POOL_SIZE_MAX            (16)
+#define HSS_AUTH_POOL_SUBSCRIBERS_DEFAULT (4096)
+#define HSS_AUTH_POOL_WORKERS_DEFAULT     (2)
+
 typedef struct hss_config_s {
+  /* Subscriber database: "mysql" or "local" */
+  char *db_backend;
+
   char *mysql_server;
   char *mysql_user;
   char *mysql_password;
   char *mysql_database;
+  /* Number of connections used by the S6a threads */
+  int   mysql_pool_size;
 
+  /* Log file of the local database */
+  char *local_db_file;
+  /* MySQL dump loaded in an empty local database */
+  char *local_db_import;
 
   char *operator_key;
   unsigned char operator_key_bin[16];
@@ -41,6 +65,25 @@ typedef struct hss_config_s {
 
   char *random;
   char  random_bool;
+
+  /* SQNs of the authentication vectors are written to the database behind the requests */
+  char *sqn_write_behind;
+  char  sqn_write_behind_bool;
+
+  /* Subscriber profiles cached, 0 disables the cache */
+  int   cache_size;
+  /* Seconds a cached profile is used, 0 for no limit */
+  int   cache_ttl;
+  /* Load the users and pdn tables in the cache at startup */
+  char *cache_warm_load;
+  char  cache_warm_load_bool;
+
+  /* Authentication vectors kept per subscriber, 0 disables the pool */
+  int   auth_pool_size;
+  /* Subscribers with vectors in the pool */
+  int   auth_pool_subscribers;
+  /* Threads refilling the pool */
+  int   auth_pool_workers;
 } hss_config_t;
 
 int hss_config_init(int argc, char *argv[], hss_config_t *hss_config_p);
@@ -62,6 +62,7 @@
 #include "mme_config.h"
 
 #include "intertask_interface_init.h"
+#include "itti_trace.h"
 
 #include "sctp_primitives_server.h"
 #include "udp_primitives_server.h"
@@ -148,7 +149,8 @@ main (
 #endif
 
 
-  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, NULL));
+  CHECK_INIT_RETURN (itti_init (TASK_MAX, THREAD_MAX, MESSAGES_ID_MAX, tasks_info, messages_info, NULL, bdata(mme_config.itti_config.log_file)));
+  itti_trace_set_output_file (bdata(mme_config.itti_config.trace_file));
   MSC_INIT (MSC_MME, THREAD_MAX + TASK_MAX);
   /*
    * Calling each layer init function
@@ -63,6 +63,7 @@
 #include "common_types.h"
 #include "common_defs.h"
 #include "intertask_interface_init.h"
+#include "intertask_interface_dump.h"
 #include "udp_primitives_server.h"
 #include "sgw_config.h"
 #include "pgw_config.h"
@@ -138,6 +139,8 @@ main (
    * Parse the command line for options and set the mme_config accordingly.
    */
   CHECK_INIT_RETURN (spgw_config_parse_opt_line (argc, argv, &spgw_config));
+  // ITTI capture file is known only now
+  itti_dump_init (NULL, bdata(spgw_config.sgw_config.itti_config.log_file));
   /*
    * Calling each layer init function
    */
@@ -523,82 +523,6 @@ gtpv2c_bearer_context_to_create_ie_set (
   return RETURNok;
 }
 
-//------------------------------------------------------------------------------
-nw_rc_t
-gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_get (
-  uint8_t ieType,
-  uint8_t ieLength,
-  uint8_t ieInstance,
-  uint8_t * ieValue,
-  void *arg)
-{
-  bearer_contexts_to_be_created_t         *bearer_contexts = (bearer_contexts_to_be_created_t *) arg;
-  DevAssert (bearer_contexts );
-  DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
-  bearer_context_to_be_created_t          *bearer_context  = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
-  nw_rc_t                                   rc;
-
-  while (ieLength > read) {
-    nw_gtpv2c_ie_tlv_t                         *ie_p;
-
-    ie_p = (nw_gtpv2c_ie_tlv_t *) & ieValue[read];
-
-    switch (ie_p->t) {
-    case NW_GTPV2C_IE_EBI:
-      rc = gtpv2c_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_BEARER_LEVEL_QOS:
-      rc = gtpv2c_bearer_qos_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->bearer_level_qos);
-      break;
-
-    case NW_GTPV2C_IE_BEARER_TFT:
-      OAILOG_ERROR (LOG_S11, "Received IE %u to implement\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-      break;
-
-    case NW_GTPV2C_IE_FTEID:
-      switch (ie_p->i) {
-        case 0:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1u_enb_fteid);
-          break;
-        case 1:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s4u_sgsn_fteid);
-          break;
-        case 2:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s5_s8_u_sgw_fteid);
-          break;
-        case 3:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s5_s8_u_pgw_fteid);
-          break;
-        case 4:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s12_rnc_fteid);
-          break;
-        case 5:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s2b_u_epdg_fteid);
-          break;
-        default:
-          OAILOG_ERROR (LOG_S11, "Received unexpected IE %u instance %u\n", ie_p->t, ie_p->i);
-          return NW_GTPV2C_IE_INCORRECT;
-
-      }
-      DevAssert (NW_OK == rc);
-      break;
-
-    default:
-      OAILOG_ERROR (LOG_S11, "Received unexpected IE %u\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-    }
-
-    read += (ntohs (ie_p->l) + sizeof (nw_gtpv2c_ie_tlv_t));
-  }
-  bearer_contexts->num_bearer_context += 1;
-  return NW_OK;
-}
-
 //------------------------------------------------------------------------------
 int
 gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_set (
@@ -624,84 +548,6 @@ gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_set (
   return RETURNok;
 }
 
-//------------------------------------------------------------------------------
-nw_rc_t
-gtpv2c_bearer_context_to_be_created_within_create_bearer_request_ie_get (
-  uint8_t ieType,
-  uint8_t ieLength,
-  uint8_t ieInstance,
-  uint8_t * ieValue,
-  void *arg)
-{
-  bearer_contexts_within_create_bearer_request_t         *bearer_contexts = (bearer_contexts_within_create_bearer_request_t *) arg;
-  DevAssert (bearer_contexts );
-  DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_CREATE_BEARER_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
-  bearer_context_within_create_bearer_request_t          *bearer_context  = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
-  nw_rc_t                                   rc;
-
-  while (ieLength > read) {
-    nw_gtpv2c_ie_tlv_t                         *ie_p;
-
-    ie_p = (nw_gtpv2c_ie_tlv_t *) & ieValue[read];
-
-    switch (ie_p->t) {
-    case NW_GTPV2C_IE_EBI:
-      rc = gtpv2c_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_BEARER_LEVEL_QOS:
-      rc = gtpv2c_bearer_qos_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->bearer_level_qos);
-      break;
-
-    case NW_GTPV2C_IE_BEARER_TFT:
-      rc = gtpv2c_tft_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->tft);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_PCO:
-      rc = gtpv2c_pco_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->pco);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_FTEID:
-      switch (ie_p->i) {
-        case 0:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1u_sgw_fteid);
-          break;
-        case 1:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s5_s8_u_pgw_fteid);
-          break;
-        case 2:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s12_sgw_fteid);
-          break;
-        case 3:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s4_u_sgw_fteid);
-          break;
-        case 4:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s2b_u_pgw_fteid);
-          break;
-        default:
-          OAILOG_ERROR (LOG_S11, "Received unexpected IE %u instance %u\n", ie_p->t, ie_p->i);
-          return NW_GTPV2C_IE_INCORRECT;
-
-      }
-      DevAssert (NW_OK == rc);
-      break;
-
-    default:
-      OAILOG_ERROR (LOG_S11, "Received unexpected IE %u\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-    }
-
-    read += (ntohs (ie_p->l) + sizeof (nw_gtpv2c_ie_tlv_t));
-  }
-  bearer_contexts->num_bearer_context += 1;
-  return NW_OK;
-}
-
 //------------------------------------------------------------------------------
 int
 gtpv2c_bearer_context_to_be_created_within_create_bearer_request_ie_set (
@@ -801,95 +647,6 @@ int gtpv2c_bearer_context_within_create_bearer_response_ie_set (
   return RETURNok;
 }
 
-//------------------------------------------------------------------------------
-nw_rc_t
-gtpv2c_bearer_context_within_create_bearer_response_ie_get (
-  uint8_t ieType,
-  uint8_t ieLength,
-  uint8_t ieInstance,
-  uint8_t * ieValue,
-  void *arg)
-{
-  bearer_contexts_within_create_bearer_response_t       *bearer_contexts = (bearer_contexts_within_create_bearer_response_t *) arg;
-  DevAssert (bearer_contexts);
-  DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_MODIFY_BEARER_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
-  bearer_context_within_create_bearer_response_t        *bearer_context = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
-  nw_rc_t                                   rc;
-
-  DevAssert (bearer_context);
-
-  while (ieLength > read) {
-    nw_gtpv2c_ie_tlv_t                         *ie_p;
-
-    ie_p = (nw_gtpv2c_ie_tlv_t *) & ieValue[read];
-
-    switch (ie_p->t) {
-    case NW_GTPV2C_IE_EBI:
-      rc = gtpv2c_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_CAUSE:
-      rc = gtpv2c_cause_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->cause);
-      break;
-
-    case NW_GTPV2C_IE_PCO:
-      rc = gtpv2c_pco_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->pco);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_FTEID:
-      switch (ie_p->i) {
-        case 0:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1u_enb_fteid);
-          break;
-        case 1:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1u_sgw_fteid);
-          break;
-        case 2:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s5_s8_u_sgw_fteid);
-          break;
-        case 3:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s5_s8_u_pgw_fteid);
-          break;
-        case 4:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s12_rnc_fteid);
-          break;
-        case 5:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s12_sgw_fteid);
-          break;
-        case 6:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s4_u_sgsn_fteid);
-          break;
-        case 7:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s4_u_sgw_fteid);
-          break;
-        case 8:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s2b_u_epdg_fteid);
-          break;
-        case 9:
-          rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s2b_u_pgw_fteid);
-          break;
-
-        default:
-          OAILOG_ERROR (LOG_S11, "Received unexpected instance %u for fteid\n", ie_p->i);
-      }
-      break;
-
-    default:
-      OAILOG_ERROR (LOG_S11, "Received unexpected IE %u\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-    }
-
-    read += (ntohs (ie_p->l) + sizeof (nw_gtpv2c_ie_tlv_t));
-  }
-  bearer_contexts->num_bearer_context += 1;
-  return NW_OK;
-}
-
-
 //------------------------------------------------------------------------------
 int
 gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_set (
@@ -915,98 +672,6 @@ gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_set (
   return RETURNok;
 }
 
-//------------------------------------------------------------------------------
-nw_rc_t
-gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_get (
-  uint8_t ieType,
-  uint8_t ieLength,
-  uint8_t ieInstance,
-  uint8_t * ieValue,
-  void *arg)
-{
-  bearer_contexts_to_be_modified_t       *bearer_contexts = (bearer_contexts_to_be_modified_t *) arg;
-  DevAssert (bearer_contexts);
-  DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_MODIFY_BEARER_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
-  bearer_context_to_be_modified_t        *bearer_context = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
-  nw_rc_t                                   rc;
-
-  DevAssert (bearer_context);
-
-  while (ieLength > read) {
-    nw_gtpv2c_ie_tlv_t                         *ie_p;
-
-    ie_p = (nw_gtpv2c_ie_tlv_t *) & ieValue[read];
-
-    switch (ie_p->t) {
-    case NW_GTPV2C_IE_EBI:
-      rc = gtpv2c_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_FTEID:
-      rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1_eNB_fteid);
-      break;
-
-    default:
-      OAILOG_ERROR (LOG_S11, "Received unexpected IE %u\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-    }
-
-    read += (ntohs (ie_p->l) + sizeof (nw_gtpv2c_ie_tlv_t));
-  }
-  bearer_contexts->num_bearer_context += 1;
-  return NW_OK;
-}
-
-//------------------------------------------------------------------------------
-nw_rc_t
-gtpv2c_bearer_context_created_ie_get (
-  uint8_t ieType,
-  uint8_t ieLength,
-  uint8_t ieInstance,
-  uint8_t * ieValue,
-  void *arg)
-{
-  bearer_contexts_created_t              *bearer_contexts = (bearer_contexts_created_t *) arg;
-  DevAssert (bearer_contexts);
-  DevAssert (0 <= bearer_contexts->num_bearer_context);
-  DevAssert (MSG_CREATE_SESSION_REQUEST_MAX_BEARER_CONTEXTS >= bearer_contexts->num_bearer_context);
-  bearer_context_created_t               *bearer_context = &bearer_contexts->bearer_contexts[bearer_contexts->num_bearer_context];
-  uint8_t                                 read = 0;
-  nw_rc_t                                   rc;
-
-  while (ieLength > read) {
-    nw_gtpv2c_ie_tlv_t                         *ie_p;
-
-    ie_p = (nw_gtpv2c_ie_tlv_t *) & ieValue[read];
-
-    switch (ie_p->t) {
-    case NW_GTPV2C_IE_EBI:
-      rc = gtpv2c_ebi_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->eps_bearer_id);
-      DevAssert (NW_OK == rc);
-      break;
-
-    case NW_GTPV2C_IE_FTEID:
-      rc = gtpv2c_fteid_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->s1u_sgw_fteid);
-      break;
-
-    case NW_GTPV2C_IE_CAUSE:
-      rc = gtpv2c_cause_ie_get (ie_p->t, ntohs (ie_p->l), ie_p->i, &ieValue[read + sizeof (nw_gtpv2c_ie_tlv_t)], &bearer_context->cause);
-      break;
-
-    default:
-      OAILOG_ERROR (LOG_S11, "Received unexpected IE %u\n", ie_p->t);
-      return NW_GTPV2C_IE_INCORRECT;
-    }
-
-    read += (ntohs (ie_p->l) + sizeof (nw_gtpv2c_ie_tlv_t));
-  }
-  bearer_contexts->num_bearer_context += 1;
-  return NW_OK;
-}
-
 //------------------------------------------------------------------------------
 int
 gtpv2c_bearer_context_created_ie_set (
@@ -1141,32 +806,26 @@ gtpv2c_serving_network_ie_set (
 
 //------------------------------------------------------------------------------
 int
-gtpv2c_fteid_ie_set (
-  nw_gtpv2c_msg_handle_t * msg,
-  const fteid_t * fteid,
-  const uint8_t   instance)
+gtpv2c_fteid_value_set (
+  uint8_t * const value,
+  const fteid_t * fteid)
 {
-  nw_rc_t                                   rc;
-  uint8_t                                 value[25];
+  int                                     offset = 5;
 
-  DevAssert (msg );
+  DevAssert (value );
   DevAssert (fteid );
-  /*
-   * MCC Decimal | MCC Hundreds
-   */
   value[0] = (fteid->ipv4 << 7) | (fteid->ipv6 << 6) | (fteid->interface_type & 0x3F);
   value[1] = (fteid->teid >> 24 );
   value[2] = (fteid->teid >> 16 ) & 0xFF;
   value[3] = (fteid->teid >>  8 ) & 0xFF;
   value[4] = (fteid->teid >>  0 ) & 0xFF;
 
-  int offset = 5;
   if (fteid->ipv4 == 1) {
-    uint32_t hbo = ntohl(fteid->ipv4_address.s_addr);
-    value[offset++] = (uint8_t)(hbo >> 24);
-    value[offset++] = (uint8_t)(hbo >> 16);
-    value[offset++] = (uint8_t)(hbo >> 8);
-    value[offset++] = (uint8_t)hbo;
+    /*
+     * s_addr is already in network byte order
+     */
+    memcpy (&value[offset], &fteid->ipv4_address.s_addr, 4);
+    offset += 4;
   }
   if (fteid->ipv6 == 1) {
     /*
@@ -1175,8 +834,24 @@ gtpv2c_fteid_ie_set (
     memcpy (&value[offset], fteid->ipv6_address.__in6_u.__u6_addr8, 16);
     offset += 16;
   }
+  return offset;
+}
 
-  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_FTEID, offset, instance, value);
+//------------------------------------------------------------------------------
+int
+gtpv2c_fteid_ie_set (
+  nw_gtpv2c_msg_handle_t * msg,
+  const fteid_t * fteid,
+  const uint8_t   instance)
+{
+  nw_rc_t                                   rc;
+  uint8_t                                 value[25];
+  int                                     length;
+
+  DevAssert (msg );
+  DevAssert (fteid );
+  length = gtpv2c_fteid_value_set (value, fteid);
+  rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_FTEID, length, instance, value);
   DevAssert (NW_OK == rc);
   return RETURNok;
 }
@@ -1590,16 +1265,14 @@ gtpv2c_bearer_qos_ie_get (
 
 
 //------------------------------------------------------------------------------
-int
-gtpv2c_bearer_qos_ie_set (
-  nw_gtpv2c_msg_handle_t * msg,
+void
+gtpv2c_bearer_qos_value_set (
+  uint8_t * const value,
   const bearer_qos_t * bearer_qos)
 {
-  nw_rc_t                                   rc;
-  uint8_t                                 value[22];
   int                                     index = 0;
 
-  DevAssert (msg );
+  DevAssert (value );
   DevAssert (bearer_qos );
   value[index++] = (bearer_qos->pci << 6) | (bearer_qos->pl << 2) | (bearer_qos->pvi);
   value[index++] = bearer_qos->qci;
@@ -1629,6 +1302,20 @@ gtpv2c_bearer_qos_ie_set (
   value[index++] = (bearer_qos->gbr.br_dl & 0x0000FF0000) >> 16;
   value[index++] = (bearer_qos->gbr.br_dl & 0x000000FF00) >> 8;
   value[index++] = (bearer_qos->gbr.br_dl & 0x00000000FF);
+}
+
+//------------------------------------------------------------------------------
+int
+gtpv2c_bearer_qos_ie_set (
+  nw_gtpv2c_msg_handle_t * msg,
+  const bearer_qos_t * bearer_qos)
+{
+  nw_rc_t                                   rc;
+  uint8_t                                 value[22];
+
+  DevAssert (msg );
+  DevAssert (bearer_qos );
+  gtpv2c_bearer_qos_value_set (value, bearer_qos);
   rc = nwGtpv2cMsgAddIe (*msg, NW_GTPV2C_IE_BEARER_LEVEL_QOS, 22, 0, value);
   DevAssert (NW_OK == rc);
   return RETURNok;
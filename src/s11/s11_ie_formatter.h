@@ -79,18 +79,15 @@ int gtpv2c_ebi_ie_set(nw_gtpv2c_msg_handle_t *msg, const unsigned ebi);
 
 /* Bearer Contexts to Create Information Element as part of Create Session Request
  * 3GPP TS 29.274 Table 7.2.1-2.
+ * Grouped bearer context IEs are decoded by the precompiled message parsers (NwGtpv2cMsgParser.h).
  */
-nw_rc_t gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_get (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t * ieValue, void *arg);
 int gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_set (nw_gtpv2c_msg_handle_t * msg, const bearer_context_to_be_created_t * bearer_context);
 
-nw_rc_t gtpv2c_bearer_context_to_be_created_within_create_bearer_request_ie_get (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t * ieValue, void *arg);
 int gtpv2c_bearer_context_to_be_created_within_create_bearer_request_ie_set (nw_gtpv2c_msg_handle_t * msg, const bearer_context_within_create_bearer_request_t * bearer_context);
 
 int gtpv2c_bearer_context_within_create_bearer_response_ie_set (nw_gtpv2c_msg_handle_t * msg, const bearer_context_within_create_bearer_response_t * bearer_context);
-nw_rc_t gtpv2c_bearer_context_within_create_bearer_response_ie_get(uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
 
 int gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_set (nw_gtpv2c_msg_handle_t * msg, const bearer_context_to_be_modified_t * bearer_context);
-nw_rc_t gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_get(uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
 
 /* EPS Bearer Id Information Element
  * 3GPP TS 29.274 #8.8
@@ -107,8 +104,6 @@ nw_rc_t gtpv2c_cause_ie_get(uint8_t ieType, uint8_t ieLength, uint8_t ieInstance
 int gtpv2c_cause_ie_set(nw_gtpv2c_msg_handle_t *msg, const gtpv2c_cause_t  *cause);
 
 /* Bearer Context Created grouped Information Element */
-nw_rc_t gtpv2c_bearer_context_created_ie_get(uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
-
 int gtpv2c_bearer_context_created_ie_set(nw_gtpv2c_msg_handle_t *msg, const bearer_context_created_t const * bearer);
 
 /* Serving Network Information Element
@@ -120,6 +115,8 @@ int gtpv2c_serving_network_ie_set(nw_gtpv2c_msg_handle_t     *msg, const Serving
 
 /* Fully Qualified TEID (F-TEID) Information Element */
 int gtpv2c_fteid_ie_set (nw_gtpv2c_msg_handle_t * msg, const fteid_t * fteid, const uint8_t   instance);
+/* Encode the IE value, used to fill IE templates, returns its length (9 bytes for an IPv4 only F-TEID) */
+int gtpv2c_fteid_value_set (uint8_t * const value, const fteid_t * fteid);
 nw_rc_t gtpv2c_fteid_ie_get(uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t *ieValue, void *arg);
 
 /* Protocol Configuration Options Information Element */
@@ -161,6 +158,8 @@ int gtpv2c_apn_restriction_ie_set(nw_gtpv2c_msg_handle_t *msg, const uint8_t apn
  */
 nw_rc_t gtpv2c_bearer_qos_ie_get (uint8_t ieType, uint8_t ieLength, uint8_t ieInstance, uint8_t * ieValue, void *arg);
 int gtpv2c_bearer_qos_ie_set(nw_gtpv2c_msg_handle_t *msg, const bearer_qos_t *bearer_qos);
+/* Encode the 22 bytes of the IE value, used to fill IE templates */
+void gtpv2c_bearer_qos_value_set(uint8_t * const value, const bearer_qos_t *bearer_qos);
 
 /* IP address Information Element
  * 3GPP TS 29.274 #8.9
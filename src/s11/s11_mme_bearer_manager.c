@@ -52,6 +52,127 @@
 
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_release_access_bearers_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, itti_s11_release_access_bearers_response_t, cause),
+  /*
+   * TODO Recovery IE
+   */
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_release_access_bearers_response_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_modify_bearer_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, itti_s11_modify_bearer_response_t, cause),
+  /*
+   * TODO Recovery IE
+   */
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_modify_bearer_response_parser;
+
+/*
+ * Bearer Context within Create Bearer Request, 3GPP TS 29.274 Table 7.2.3-2.
+ */
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_bearer_context_within_create_bearer_request_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, bearer_context_within_create_bearer_request_t, eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_TFT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_tft_ie_get, bearer_context_within_create_bearer_request_t, tft),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_request_t, s1u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_request_t, s5_s8_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_TWO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_request_t, s12_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_THREE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_request_t, s4_u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_FOUR, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_request_t, s2b_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_LEVEL_QOS, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_bearer_qos_ie_get, bearer_context_within_create_bearer_request_t, bearer_level_qos),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_pco_ie_get, bearer_context_within_create_bearer_request_t, pco),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_bearer_context_within_create_bearer_request_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_create_bearer_request_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, itti_s11_create_bearer_request_t, linked_eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_pco_ie_get, itti_s11_create_bearer_request_t, pco),
+  NW_GTPV2C_GROUPED_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      &s11_mme_bearer_context_within_create_bearer_request_parser, itti_s11_create_bearer_request_t, bearer_contexts, num_bearer_context, bearer_contexts),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_create_bearer_request_parser;
+
+/*
+ * Pre-encoded IEs of the requests sent for every idle/connected transition, built once by
+ * s11_mme_bearer_manager_init(): only the variable fields are written when a request is sent.
+ */
+static nw_gtpv2c_ie_template_t                 s11_mme_release_access_bearers_request_template;  /* Node Type */
+static uint16_t                                s11_mme_rab_node_type_offset;
+
+static nw_gtpv2c_ie_template_t                 s11_mme_bearer_context_to_be_modified_template;   /* Bearer Context: EBI, S1-U eNB F-TEID IPv4 */
+static uint16_t                                s11_mme_bc_modified_ebi_offset;
+static uint16_t                                s11_mme_bc_modified_fteid_offset;
+
+//------------------------------------------------------------------------------
+static int
+s11_mme_bearer_manager_templates_init (void)
+{
+  nw_gtpv2c_msg_handle_t                      hMsg = 0;
+  bearer_context_to_be_modified_t             bearer_context = {0};
+  node_type_t                                 node_type = NODE_TYPE_MME;
+
+  if (NW_OK != nwGtpv2cMsgIeTemplateStart (&hMsg)) {
+    return RETURNerror;
+  }
+  s11_mme_rab_node_type_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_node_type_ie_set (&hMsg, &node_type);
+  if (NW_OK != nwGtpv2cMsgIeTemplateEnd (hMsg, &s11_mme_release_access_bearers_request_template)) {
+    return RETURNerror;
+  }
+
+  if (NW_OK != nwGtpv2cMsgIeTemplateStart (&hMsg)) {
+    return RETURNerror;
+  }
+  bearer_context.s1_eNB_fteid.ipv4 = 1;
+  nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+  s11_mme_bc_modified_ebi_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_ebi_ie_set (&hMsg, bearer_context.eps_bearer_id);
+  s11_mme_bc_modified_fteid_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_fteid_ie_set (&hMsg, &bearer_context.s1_eNB_fteid, 0);
+  nwGtpv2cMsgGroupedIeEnd (hMsg);
+  if (NW_OK != nwGtpv2cMsgIeTemplateEnd (hMsg, &s11_mme_bearer_context_to_be_modified_template)) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int
+s11_mme_bearer_manager_init (void)
+{
+  if ((NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_release_access_bearers_response_parser, NW_GTP_RELEASE_ACCESS_BEARERS_RSP,
+                                                s11_mme_release_access_bearers_response_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_modify_bearer_response_parser, NW_GTP_MODIFY_BEARER_RSP, s11_mme_modify_bearer_response_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_bearer_context_within_create_bearer_request_parser, 0,
+                                                s11_mme_bearer_context_within_create_bearer_request_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_create_bearer_request_parser, NW_GTP_CREATE_BEARER_REQ, s11_mme_create_bearer_request_ies))) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 MME bearer management message parsers\n");
+    return RETURNerror;
+  }
+  if (RETURNok != s11_mme_bearer_manager_templates_init ()) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 MME bearer management message templates\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 int
 s11_mme_release_access_bearers_request (
@@ -60,16 +181,12 @@ s11_mme_release_access_bearers_request (
 {
   nw_gtpv2c_ulp_api_t                         ulp_req;
   nw_rc_t                                   rc;
-  //uint8_t                                 restart_counter = 0;
+  uint8_t                                *ie = NULL;
 
   DevAssert (stack_p );
   DevAssert (req_p );
   memset (&ulp_req, 0, sizeof (nw_gtpv2c_ulp_api_t));
   ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
-  /*
-   * Prepare a new Create Session Request msg
-   */
-  rc = nwGtpv2cMsgNew (*stack_p, true, NW_GTP_RELEASE_ACCESS_BEARERS_REQ, req_p->teid, 0, &(ulp_req.hMsg));
   ulp_req.u_api_info.initialReqInfo.peerIp = req_p->peer_ip;
   ulp_req.u_api_info.initialReqInfo.teidLocal  = req_p->local_teid;
 
@@ -81,9 +198,16 @@ s11_mme_release_access_bearers_request (
     return RETURNerror;
   }
 
+  /*
+   * Prepare a new Release Access Bearers Request msg
+   */
+  rc = nwGtpv2cMsgNew (*stack_p, true, NW_GTP_RELEASE_ACCESS_BEARERS_REQ, req_p->teid, 0, &(ulp_req.hMsg));
+  DevAssert (NW_OK == rc);
+
   // TODO add node_type_t originating_node if ISR active
-  rc = nwGtpv2cMsgAddIe ((ulp_req.hMsg), NW_GTPV2C_IE_NODE_TYPE, 1, 0, (uint8_t *) & req_p->originating_node);
+  rc = nwGtpv2cMsgAddIeTemplate ((ulp_req.hMsg), &s11_mme_release_access_bearers_request_template, &ie);
   DevAssert (NW_OK == rc);
+  ie[s11_mme_rab_node_type_offset] = (uint8_t)req_p->originating_node;
 
   rc = nwGtpv2cProcessUlpReq (*stack_p, &ulp_req);
   DevAssert (NW_OK == rc);
@@ -103,7 +227,6 @@ s11_mme_handle_release_access_bearer_response (
   uint16_t                                offendingIeLength;
   itti_s11_release_access_bearers_response_t  *resp_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_RELEASE_ACCESS_BEARERS_RESPONSE);
@@ -111,28 +234,10 @@ s11_mme_handle_release_access_bearer_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_RELEASE_ACCESS_BEARERS_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, gtpv2c_cause_ie_get,
-		  &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /*rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc);*/
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_mme_release_access_bearers_response_parser, (pUlpApi->hMsg), resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -141,8 +246,6 @@ s11_mme_handle_release_access_bearer_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
@@ -151,8 +254,6 @@ s11_mme_handle_release_access_bearer_response (
   MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 RELEASE_ACCESS_BEARERS_RESPONSE local S11 teid " TEID_FMT " cause %u",
     resp_p->teid, resp_p->cause);
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
@@ -166,16 +267,12 @@ s11_mme_modify_bearer_request (
 {
   nw_gtpv2c_ulp_api_t                         ulp_req;
   nw_rc_t                                   rc;
-  //uint8_t                                 restart_counter = 0;
+  uint8_t                                *ie = NULL;
 
   DevAssert (stack_p );
   DevAssert (req_p );
   memset (&ulp_req, 0, sizeof (nw_gtpv2c_ulp_api_t));
   ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
-  /*
-   * Prepare a new Modify Bearer Request msg
-   */
-  rc = nwGtpv2cMsgNew (*stack_p, true, NW_GTP_MODIFY_BEARER_REQ, req_p->teid, 0, &(ulp_req.hMsg));
   ulp_req.u_api_info.initialReqInfo.peerIp = req_p->peer_ip;
   ulp_req.u_api_info.initialReqInfo.teidLocal  = req_p->local_teid;
 
@@ -187,6 +284,12 @@ s11_mme_modify_bearer_request (
     return RETURNerror;
   }
 
+  /*
+   * Prepare a new Modify Bearer Request msg
+   */
+  rc = nwGtpv2cMsgNew (*stack_p, true, NW_GTP_MODIFY_BEARER_REQ, req_p->teid, 0, &(ulp_req.hMsg));
+  DevAssert (NW_OK == rc);
+
   /*
    * Sender F-TEID for Control Plane (MME S11)
    */
@@ -196,22 +299,26 @@ s11_mme_modify_bearer_request (
                               req_p->sender_fteid_for_cp.ipv4 ? &req_p->sender_fteid_for_cp.ipv4_address : 0,
                               req_p->sender_fteid_for_cp.ipv6 ? &req_p->sender_fteid_for_cp.ipv6_address : NULL);
 
-
-
   for (int i=0; i < req_p->bearer_contexts_to_be_modified.num_bearer_context; i++) {
-    rc = gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_set (&(ulp_req.hMsg), & req_p->bearer_contexts_to_be_modified.bearer_contexts[i]);
-    DevAssert (NW_OK == rc);
-  }
-
+    const bearer_context_to_be_modified_t * const bearer_context = &req_p->bearer_contexts_to_be_modified.bearer_contexts[i];
 
+    if ((bearer_context->s1_eNB_fteid.ipv4) && !(bearer_context->s1_eNB_fteid.ipv6)) {
+      rc = nwGtpv2cMsgAddIeTemplate ((ulp_req.hMsg), &s11_mme_bearer_context_to_be_modified_template, &ie);
+      DevAssert (NW_OK == rc);
+      ie[s11_mme_bc_modified_ebi_offset] = bearer_context->eps_bearer_id & 0x0F;
+      gtpv2c_fteid_value_set (&ie[s11_mme_bc_modified_fteid_offset], &bearer_context->s1_eNB_fteid);
+    } else {
+      rc = gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_set (&(ulp_req.hMsg), bearer_context);
+      DevAssert (NW_OK == rc);
+    }
+  }
 
   MSC_LOG_TX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 MODIFY_BEARER_REQUEST local S11 teid " TEID_FMT " num bearers ctx %u",
     req_p->local_teid, req_p->bearer_contexts_to_be_modified.num_bearer_context);
 
   rc = nwGtpv2cProcessUlpReq (*stack_p, &ulp_req);
-   DevAssert (NW_OK == rc);
-   return RETURNok;
-
+  DevAssert (NW_OK == rc);
+  return RETURNok;
 }
 
 //------------------------------------------------------------------------------
@@ -279,7 +386,6 @@ s11_mme_handle_modify_bearer_response (
   uint16_t                                offendingIeLength;
   itti_s11_modify_bearer_response_t      *resp_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_MODIFY_BEARER_RESPONSE);
@@ -287,28 +393,10 @@ s11_mme_handle_modify_bearer_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_MODIFY_BEARER_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, gtpv2c_cause_ie_get,
-      &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /*rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc);*/
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_mme_modify_bearer_response_parser, (pUlpApi->hMsg), resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -317,8 +405,6 @@ s11_mme_handle_modify_bearer_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
@@ -326,8 +412,6 @@ s11_mme_handle_modify_bearer_response (
 
   MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 MODIFY_BEARER_RESPONSE local S11 teid " TEID_FMT " cause %u",
     resp_p->teid, resp_p->cause);
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
@@ -345,7 +429,6 @@ s11_mme_handle_create_bearer_request (
   uint16_t                                offendingIeLength;
   itti_s11_create_bearer_request_t       *req_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_BEARER_REQUEST);
@@ -356,29 +439,10 @@ s11_mme_handle_create_bearer_request (
     req_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
     req_p->trxn = (void *)pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
 
-    /*
-     * Create a new message parser
-     */
-    rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_BEARER_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-    DevAssert (NW_OK == rc);
-
-    rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, gtpv2c_ebi_ie_get,
-        &req_p->linked_eps_bearer_id);
-    DevAssert (NW_OK == rc);
-
-    rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, gtpv2c_pco_ie_get,
-        &req_p->pco);
-    DevAssert (NW_OK == rc);
-
-    rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-        gtpv2c_bearer_context_to_be_created_within_create_bearer_request_ie_get,
-        &req_p->bearer_contexts);
-    DevAssert (NW_OK == rc);
-
     /*
      * Run the parser
      */
-    rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+    rc = nwGtpv2cMsgParserDescRun (&s11_mme_create_bearer_request_parser, (pUlpApi->hMsg), req_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
     if (rc != NW_OK) {
       MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_BEARER_REQUEST local S11 teid " TEID_FMT " ", req_p->teid);
@@ -387,8 +451,6 @@ s11_mme_handle_create_bearer_request (
        */
       itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
       message_p = NULL;
-      rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-      DevAssert (NW_OK == rc);
       rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
       DevAssert (NW_OK == rc);
       return RETURNerror;
@@ -396,8 +458,6 @@ s11_mme_handle_create_bearer_request (
 
     MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_BEARER_REQUEST local S11 teid " TEID_FMT " lebi %u",
         req_p->teid, req_p->linked_eps_bearer_id);
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return itti_send_msg_to_task (TASK_MME_APP, INSTANCE_DEFAULT, message_p);
@@ -29,6 +29,8 @@
 #ifndef FILE_S11_MME_BEARER_MANAGER_SEEN
 #define FILE_S11_MME_BEARER_MANAGER_SEEN
 
+/* @brief Compile the parsers of the bearer management messages received from S-GW. */
+int s11_mme_bearer_manager_init (void);
 
 /* @brief Create a new Release Access Bearers Request and send it to provided S-GW. */
 int s11_mme_release_access_bearers_request(nw_gtpv2c_stack_handle_t *stack_p, itti_s11_release_access_bearers_request_t *release_access_bearers_p);
@@ -53,6 +53,127 @@
 
 extern hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle;
 
+/*
+ * Bearer Context Created within Create Session Response, 3GPP TS 29.274 Table 7.2.2-2.
+ */
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_bearer_context_created_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, bearer_context_created_t, eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, bearer_context_created_t, cause),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_created_t, s1u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_created_t, s4u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_TWO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_created_t, s5_s8_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_THREE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_created_t, s12_sgw_fteid),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_bearer_context_created_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_create_session_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, itti_s11_create_session_response_t, cause),
+  /*
+   * Sender FTEID for CP IE
+   */
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, itti_s11_create_session_response_t, s11_sgw_fteid),
+  /*
+   * Sender FTEID for PGW S5/S8 IE
+   */
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, itti_s11_create_session_response_t, s5_s8_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_paa_ie_get, itti_s11_create_session_response_t, paa),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_apn_restriction_ie_get, itti_s11_create_session_response_t, apn_restriction),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_pco_ie_get, itti_s11_create_session_response_t, pco),
+  NW_GTPV2C_GROUPED_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      &s11_mme_bearer_context_created_parser, itti_s11_create_session_response_t, bearer_contexts_created, num_bearer_context, bearer_contexts),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_create_session_response_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_mme_delete_session_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, itti_s11_delete_session_response_t, cause),
+  /*
+   * TODO Recovery IE
+   */
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_pco_ie_get, itti_s11_delete_session_response_t, pco),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_mme_delete_session_response_parser;
+
+/*
+ * Pre-encoded fixed layout IEs of the Create Session Request, built once by s11_mme_session_manager_init():
+ * only the variable fields are written when a request is sent, the variable length IEs are appended as usual.
+ */
+static nw_gtpv2c_ie_template_t                 s11_mme_create_session_request_template;        /* Recovery, Sender F-TEID IPv4 */
+static uint16_t                                s11_mme_csr_sender_fteid_offset;
+
+static nw_gtpv2c_ie_template_t                 s11_mme_bearer_context_to_be_created_template;  /* Bearer Context: EBI, Bearer QoS */
+static uint16_t                                s11_mme_bc_created_ebi_offset;
+static uint16_t                                s11_mme_bc_created_qos_offset;
+
+//------------------------------------------------------------------------------
+static int
+s11_mme_session_manager_templates_init (void)
+{
+  nw_gtpv2c_msg_handle_t                      hMsg = 0;
+  bearer_context_to_be_created_t              bearer_context = {0};
+  fteid_t                                     fteid = {0};
+  uint8_t                                     restart_counter = 0;
+
+  if (NW_OK != nwGtpv2cMsgIeTemplateStart (&hMsg)) {
+    return RETURNerror;
+  }
+  nwGtpv2cMsgAddIe (hMsg, NW_GTPV2C_IE_RECOVERY, 1, 0, &restart_counter);
+  fteid.ipv4 = 1;
+  fteid.interface_type = S11_MME_GTP_C;
+  s11_mme_csr_sender_fteid_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_fteid_ie_set (&hMsg, &fteid, NW_GTPV2C_IE_INSTANCE_ZERO);
+  if (NW_OK != nwGtpv2cMsgIeTemplateEnd (hMsg, &s11_mme_create_session_request_template)) {
+    return RETURNerror;
+  }
+
+  if (NW_OK != nwGtpv2cMsgIeTemplateStart (&hMsg)) {
+    return RETURNerror;
+  }
+  nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+  s11_mme_bc_created_ebi_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_ebi_ie_set (&hMsg, bearer_context.eps_bearer_id);
+  s11_mme_bc_created_qos_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  gtpv2c_bearer_qos_ie_set (&hMsg, &bearer_context.bearer_level_qos);
+  nwGtpv2cMsgGroupedIeEnd (hMsg);
+  if (NW_OK != nwGtpv2cMsgIeTemplateEnd (hMsg, &s11_mme_bearer_context_to_be_created_template)) {
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int
+s11_mme_session_manager_init (void)
+{
+  if ((NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_bearer_context_created_parser, 0, s11_mme_bearer_context_created_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_create_session_response_parser, NW_GTP_CREATE_SESSION_RSP, s11_mme_create_session_response_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_mme_delete_session_response_parser, NW_GTP_DELETE_SESSION_RSP, s11_mme_delete_session_response_ies))) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 MME session management message parsers\n");
+    return RETURNerror;
+  }
+  if (RETURNok != s11_mme_session_manager_templates_init ()) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 MME session management message templates\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 int
 s11_mme_create_session_request (
@@ -62,6 +183,7 @@ s11_mme_create_session_request (
   nw_gtpv2c_ulp_api_t                         ulp_req;
   nw_rc_t                                   rc;
   uint8_t                                 restart_counter = 0;
+  uint8_t                                *ie = NULL;
 
   DevAssert (stack_p );
   DevAssert (req_p );
@@ -77,23 +199,27 @@ s11_mme_create_session_request (
   ulp_req.u_api_info.initialReqInfo.hTunnel    = 0;
   /*
    * Add recovery if contacting the peer for the first time
+   * Sender F-TEID for Control Plane (MME S11)
    */
-  rc = nwGtpv2cMsgAddIe ((ulp_req.hMsg), NW_GTPV2C_IE_RECOVERY, 1, 0, (uint8_t *) & restart_counter);
-  DevAssert (NW_OK == rc);
+  if ((req_p->sender_fteid_for_cp.ipv4) && !(req_p->sender_fteid_for_cp.ipv6)) {
+    rc = nwGtpv2cMsgAddIeTemplate ((ulp_req.hMsg), &s11_mme_create_session_request_template, &ie);
+    DevAssert (NW_OK == rc);
+    gtpv2c_fteid_value_set (&ie[s11_mme_csr_sender_fteid_offset], &req_p->sender_fteid_for_cp);
+  } else {
+    rc = nwGtpv2cMsgAddIe ((ulp_req.hMsg), NW_GTPV2C_IE_RECOVERY, 1, 0, (uint8_t *) & restart_counter);
+    DevAssert (NW_OK == rc);
+    rc = nwGtpv2cMsgAddIeFteid ((ulp_req.hMsg), NW_GTPV2C_IE_INSTANCE_ZERO,
+                                S11_MME_GTP_C,
+                                req_p->sender_fteid_for_cp.teid,
+                                req_p->sender_fteid_for_cp.ipv4 ? &req_p->sender_fteid_for_cp.ipv4_address : 0,
+                                req_p->sender_fteid_for_cp.ipv6 ? &req_p->sender_fteid_for_cp.ipv6_address : NULL);
+  }
   /*
    * Putting the information Elements
    */
   gtpv2c_imsi_ie_set (&(ulp_req.hMsg), &req_p->imsi);
   gtpv2c_rat_type_ie_set (&(ulp_req.hMsg), &req_p->rat_type);
   gtpv2c_pdn_type_ie_set (&(ulp_req.hMsg), &req_p->pdn_type);
-  /*
-   * Sender F-TEID for Control Plane (MME S11)
-   */
-  rc = nwGtpv2cMsgAddIeFteid ((ulp_req.hMsg), NW_GTPV2C_IE_INSTANCE_ZERO,
-                              S11_MME_GTP_C,
-                              req_p->sender_fteid_for_cp.teid,
-                              req_p->sender_fteid_for_cp.ipv4 ? &req_p->sender_fteid_for_cp.ipv4_address : 0,
-                              req_p->sender_fteid_for_cp.ipv6 ? &req_p->sender_fteid_for_cp.ipv6_address : NULL);
   /*
    * The P-GW TEID should be present on the S11 interface.
    * * * * In case of an initial attach it should be set to 0...
@@ -108,7 +234,12 @@ s11_mme_create_session_request (
   gtpv2c_serving_network_ie_set (&(ulp_req.hMsg), &req_p->serving_network);
   gtpv2c_pco_ie_set (&(ulp_req.hMsg), &req_p->pco);
   for (int i = 0; i < req_p->bearer_contexts_to_be_created.num_bearer_context; i++) {
-    gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_set (&(ulp_req.hMsg), &req_p->bearer_contexts_to_be_created.bearer_contexts[i]);
+    const bearer_context_to_be_created_t * const bearer_context = &req_p->bearer_contexts_to_be_created.bearer_contexts[i];
+
+    rc = nwGtpv2cMsgAddIeTemplate ((ulp_req.hMsg), &s11_mme_bearer_context_to_be_created_template, &ie);
+    DevAssert (NW_OK == rc);
+    ie[s11_mme_bc_created_ebi_offset] = bearer_context->eps_bearer_id & 0x0F;
+    gtpv2c_bearer_qos_value_set (&ie[s11_mme_bc_created_qos_offset], &bearer_context->bearer_level_qos);
   }
   rc = nwGtpv2cProcessUlpReq (*stack_p, &ulp_req);
   DevAssert (NW_OK == rc);
@@ -137,7 +268,6 @@ s11_mme_handle_create_session_response (
   uint16_t                                offendingIeLength;
   itti_s11_create_session_response_t     *resp_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_RESPONSE);
@@ -145,57 +275,10 @@ s11_mme_handle_create_session_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_SESSION_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      gtpv2c_cause_ie_get, &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Sender FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_fteid_ie_get, &resp_p->s11_sgw_fteid);
-  DevAssert (NW_OK == rc);
-  /*
-   * Sender FTEID for PGW S5/S8 IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_fteid_ie_get, &resp_p->s5_s8_pgw_fteid);
-  DevAssert (NW_OK == rc);
-  /*
-   * PAA IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_paa_ie_get, &resp_p->paa);
-  DevAssert (NW_OK == rc);
-  /*
-   * APN RESTRICTION
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_apn_restriction_ie_get, &resp_p->apn_restriction);
-  DevAssert (NW_OK == rc);
-  /*
-   * PCO IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_pco_ie_get, &resp_p->pco);
-  DevAssert (NW_OK == rc);
-  /*
-   * Bearer Contexts Created IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_bearer_context_created_ie_get, &resp_p->bearer_contexts_created);
-  DevAssert (NW_OK == rc);
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_mme_create_session_response_parser, (pUlpApi->hMsg), resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_SESSION_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -204,15 +287,11 @@ s11_mme_handle_create_session_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
@@ -288,7 +367,6 @@ s11_mme_handle_delete_session_response (
   uint16_t                                offendingIeLength;
   itti_s11_delete_session_response_t     *resp_p = NULL;
   MessageDef                             *message_p = NULL;
-  nw_gtpv2c_msg_parser_t                 *pMsgParser = NULL;
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
 
   DevAssert (stack_p );
@@ -297,34 +375,10 @@ s11_mme_handle_delete_session_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_DELETE_SESSION_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      gtpv2c_cause_ie_get, &resp_p->cause);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  /* TODO rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL, s11_fteid_ie_get,
-		  &resp_p->recovery);
-  DevAssert (NW_OK == rc); */
-  /*
-   * PCO IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_pco_ie_get, &resp_p->pco);
-  DevAssert (NW_OK == rc);
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_mme_delete_session_response_parser, (pUlpApi->hMsg), resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 DELETE_SESSION_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -333,15 +387,11 @@ s11_mme_handle_delete_session_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
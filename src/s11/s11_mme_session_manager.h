@@ -29,6 +29,9 @@
 #ifndef FILE_S11_MME_SESSION_MANAGER_SEEN
 #define FILE_S11_MME_SESSION_MANAGER_SEEN
 
+/* @brief Compile the parsers of the session management messages received from S-GW. */
+int s11_mme_session_manager_init (void);
+
 /* @brief Create a new Create Session Request and send it to provided S-GW. */
 int s11_mme_create_session_request(nw_gtpv2c_stack_handle_t *stack_p, itti_s11_create_session_request_t *create_session_p);
 
@@ -50,23 +50,11 @@
 #include "s11_mme.h"
 #include "s11_mme_session_manager.h"
 #include "s11_mme_bearer_manager.h"
+#include "s11_shard.h"
 
-static nw_gtpv2c_stack_handle_t             s11_mme_stack_handle = 0;
 // Store the GTPv2-C teid handle
 hash_table_ts_t                        *s11_mme_teid_2_gtv2c_teid_handle = NULL;
 static void s11_mme_exit (void);
-//------------------------------------------------------------------------------
-static nw_rc_t
-s11_mme_log_wrapper (
-  nw_gtpv2c_log_mgr_handle_t hLogMgr,
-  uint32_t logLevel,
-  char * file,
-  uint32_t line,
-  char * logStr)
-{
-  OAILOG_DEBUG (LOG_S11, "%s\n", logStr);
-  return NW_OK;
-}
 
 //------------------------------------------------------------------------------
 static nw_rc_t
@@ -75,6 +63,7 @@ s11_mme_ulp_process_stack_req_cb (
   nw_gtpv2c_ulp_api_t * pUlpApi)
 {
   //     NwRcT rc = NW_OK;
+  nw_gtpv2c_stack_handle_t               *stack_p = (nw_gtpv2c_stack_handle_t *)hUlp;
   int                                     ret = 0;
 
   DevAssert (pUlpApi );
@@ -83,19 +72,19 @@ s11_mme_ulp_process_stack_req_cb (
     case NW_GTPV2C_ULP_API_TRIGGERED_RSP_IND:
       switch (pUlpApi->u_api_info.triggeredRspIndInfo.msgType) {
       case NW_GTP_CREATE_SESSION_RSP:
-        ret = s11_mme_handle_create_session_response (&s11_mme_stack_handle, pUlpApi);
+        ret = s11_mme_handle_create_session_response (stack_p, pUlpApi);
         break;
 
       case NW_GTP_DELETE_SESSION_RSP:
-        ret = s11_mme_handle_delete_session_response (&s11_mme_stack_handle, pUlpApi);
+        ret = s11_mme_handle_delete_session_response (stack_p, pUlpApi);
         break;
 
       case NW_GTP_MODIFY_BEARER_RSP:
-        ret = s11_mme_handle_modify_bearer_response (&s11_mme_stack_handle, pUlpApi);
+        ret = s11_mme_handle_modify_bearer_response (stack_p, pUlpApi);
         break;
 
       case NW_GTP_RELEASE_ACCESS_BEARERS_RSP:
-        ret = s11_mme_handle_release_access_bearer_response (&s11_mme_stack_handle, pUlpApi);
+        ret = s11_mme_handle_release_access_bearer_response (stack_p, pUlpApi);
         break;
 
       default:
@@ -106,7 +95,7 @@ s11_mme_ulp_process_stack_req_cb (
     case NW_GTPV2C_ULP_API_INITIAL_REQ_IND:
       switch (pUlpApi->u_api_info.initialReqIndInfo.msgType) {
         case NW_GTP_CREATE_BEARER_REQ:
-          ret = s11_mme_handle_create_bearer_request (&s11_mme_stack_handle, pUlpApi);
+          ret = s11_mme_handle_create_bearer_request (stack_p, pUlpApi);
           break;
 
         default:
@@ -123,64 +112,80 @@ s11_mme_ulp_process_stack_req_cb (
 }
 
 //------------------------------------------------------------------------------
-static nw_rc_t
-s11_mme_send_udp_msg (
-  nw_gtpv2c_udp_handle_t udpHandle,
-  uint8_t * buffer,
-  uint32_t buffer_len,
-  struct in_addr *peerIpAddr,
-  uint16_t peerPort)
+// Called on the thread of the shard owning the tunnel or transaction
+static void
+s11_mme_shard_message_handler (
+  nw_gtpv2c_stack_handle_t * const stack_p,
+  MessageDef * const received_message_p)
 {
-  // Create and alloc new message
-  MessageDef                             *message_p;
-  udp_data_req_t                         *udp_data_req_p;
-  int                                     ret = 0;
+  switch (ITTI_MSG_ID (received_message_p)) {
+  case S11_CREATE_BEARER_RESPONSE:{
+    s11_mme_create_bearer_response (stack_p, &received_message_p->ittiMsg.s11_create_bearer_response);
+    }
+    break;
 
-  message_p = itti_alloc_new_message (TASK_S11, UDP_DATA_REQ);
-  udp_data_req_p = &message_p->ittiMsg.udp_data_req;
-  udp_data_req_p->peer_address.s_addr = peerIpAddr->s_addr;
-  udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
-  udp_data_req_p->buffer_length = buffer_len;
-  ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
-  return ((ret == 0) ? NW_OK : NW_FAILURE);
-}
+  case S11_CREATE_SESSION_REQUEST:{
+      s11_mme_create_session_request (stack_p, &received_message_p->ittiMsg.s11_create_session_request);
+    }
+    break;
 
-//------------------------------------------------------------------------------
-static nw_rc_t
-s11_mme_start_timer_wrapper (
-  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
-  uint32_t timeoutSec,
-  uint32_t timeoutUsec,
-  uint32_t tmrType,
-  void *timeoutArg,
-  nw_gtpv2c_timer_handle_t * hTmr)
-{
-  long                                    timer_id;
-  int                                     ret = 0;
+  case S11_DELETE_SESSION_REQUEST:{
+      s11_mme_delete_session_request (stack_p, &received_message_p->ittiMsg.s11_delete_session_request);
+    }
+    break;
 
-  if (tmrType == NW_GTPV2C_TMR_TYPE_REPETITIVE) {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
-  } else {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
-  }
+  case S11_MODIFY_BEARER_REQUEST:{
+      s11_mme_modify_bearer_request (stack_p, &received_message_p->ittiMsg.s11_modify_bearer_request);
+    }
+    break;
+
+  case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
+      s11_mme_release_access_bearers_request (stack_p, &received_message_p->ittiMsg.s11_release_access_bearers_request);
+    }
+    break;
+
+  case TIMER_HAS_EXPIRED:{
+      OAILOG_DEBUG (LOG_S11, "Processing timeout for timer_id 0x%lx and arg %p\n", received_message_p->ittiMsg.timer_has_expired.timer_id, received_message_p->ittiMsg.timer_has_expired.arg);
+      DevAssert (nwGtpv2cProcessTimeout (received_message_p->ittiMsg.timer_has_expired.arg) == NW_OK);
+    }
+    break;
 
-  *hTmr = (nw_gtpv2c_timer_handle_t) timer_id;
-  return ((ret == 0) ? NW_OK : NW_FAILURE);
+  default:
+      OAILOG_ERROR (LOG_S11, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+  }
 }
 
 //------------------------------------------------------------------------------
-static nw_rc_t
-s11_mme_stop_timer_wrapper (
-  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
-  nw_gtpv2c_timer_handle_t tmrHandle)
+// Requests aggregated by MME_APP, dispatched as if they had been sent one by one
+static void
+s11_mme_dispatch_bearer_request_batch (
+  itti_s11_bearer_request_batch_t * const batch)
 {
-  long       timer_id= (long)tmrHandle;
-  void      *timeoutArg = NULL;
+  MessageDef                             *message_p = NULL;
+  uint32_t                                i;
+
+  for (i = 0; i < batch->nb_requests; i++) {
+    message_p = batch->requests[i];
+    batch->requests[i] = NULL;
+    switch (ITTI_MSG_ID (message_p)) {
+    case S11_MODIFY_BEARER_REQUEST:
+      s11_shard_send_msg (s11_shard_from_teid (message_p->ittiMsg.s11_modify_bearer_request.local_teid), message_p);
+      break;
+
+    case S11_RELEASE_ACCESS_BEARERS_REQUEST:
+      s11_shard_send_msg (s11_shard_from_teid (message_p->ittiMsg.s11_release_access_bearers_request.local_teid), message_p);
+      break;
 
-  return ((timer_remove (timer_id, &timeoutArg) == 0) ? NW_OK : NW_FAILURE);
+    default:
+      OAILOG_ERROR (LOG_S11, "Unexpected message %s in bearer request batch\n", ITTI_MSG_NAME (message_p));
+      itti_free_msg_content (message_p);
+      itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+    }
+  }
+  batch->nb_requests = 0;
 }
 
+//------------------------------------------------------------------------------
 static void                            *
 s11_mme_thread (
   void *args)
@@ -190,9 +195,23 @@ s11_mme_thread (
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_S11, &received_message_p);
+    /*
+     * While shards have messages they were not woken up for, only poll: they are woken up once the queue is empty
+     */
+    if (s11_shard_flush_pending ()) {
+      itti_poll_msg (TASK_S11, &received_message_p);
+      if (received_message_p == NULL) {
+        s11_shard_flush ();
+        continue;
+      }
+    } else {
+      itti_receive_msg (TASK_S11, &received_message_p);
+    }
     assert (received_message_p );
 
+    /*
+     * Hand the message to the shard owning the MME S11 TEID (or the transaction), the shard frees it
+     */
     switch (ITTI_MSG_ID (received_message_p)) {
     case MESSAGE_TEST:{
         OAI_FPRINTF_INFO("TASK_S11 received MESSAGE_TEST\n");
@@ -200,53 +219,44 @@ s11_mme_thread (
       break;
 
     case S11_CREATE_BEARER_RESPONSE:{
-      s11_mme_create_bearer_response (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_create_bearer_response);
+        s11_shard_send_msg (s11_shard_from_trxn (received_message_p->ittiMsg.s11_create_bearer_response.trxn), received_message_p);
       }
-      break;
+      continue;
 
     case S11_CREATE_SESSION_REQUEST:{
-        s11_mme_create_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_create_session_request);
+        s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_create_session_request.sender_fteid_for_cp.teid), received_message_p);
       }
-      break;
+      continue;
 
     case S11_DELETE_SESSION_REQUEST:{
-        s11_mme_delete_session_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_delete_session_request);
+        s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_delete_session_request.local_teid), received_message_p);
       }
-      break;
+      continue;
 
     case S11_MODIFY_BEARER_REQUEST:{
-        s11_mme_modify_bearer_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_request);
+        s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_modify_bearer_request.local_teid), received_message_p);
       }
-      break;
+      continue;
 
     case S11_RELEASE_ACCESS_BEARERS_REQUEST:{
-        s11_mme_release_access_bearers_request (&s11_mme_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_request);
+        s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_release_access_bearers_request.local_teid), received_message_p);
       }
-      break;
+      continue;
 
-    case TERMINATE_MESSAGE:{
-        s11_mme_exit();
-        OAI_FPRINTF_INFO("TASK_S11 terminated\n");
-        itti_exit_task ();
+    case S11_BEARER_REQUEST_BATCH:{
+        s11_mme_dispatch_bearer_request_batch (&received_message_p->ittiMsg.s11_bearer_request_batch);
       }
       break;
 
     case TIMER_HAS_EXPIRED:{
-        OAILOG_DEBUG (LOG_S11, "Processing timeout for timer_id 0x%lx and arg %p\n", received_message_p->ittiMsg.timer_has_expired.timer_id, received_message_p->ittiMsg.timer_has_expired.arg);
-        DevAssert (nwGtpv2cProcessTimeout (received_message_p->ittiMsg.timer_has_expired.arg) == NW_OK);
+        s11_shard_send_msg (ITTI_MSG_INSTANCE (received_message_p), received_message_p);
       }
-      break;
+      continue;
 
-    case UDP_DATA_IND:{
-        /*
-         * We received new data to handle from the UDP layer
-         */
-        nw_rc_t                                   rc;
-        udp_data_ind_t                         *udp_data_ind;
-
-        udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
-        rc = nwGtpv2cProcessUdpReq (s11_mme_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, &udp_data_ind->peer_address);
-        DevAssert (rc == NW_OK);
+    case TERMINATE_MESSAGE:{
+        s11_mme_exit();
+        OAI_FPRINTF_INFO("TASK_S11 terminated\n");
+        itti_exit_task ();
       }
       break;
 
@@ -262,77 +272,40 @@ s11_mme_thread (
   return NULL;
 }
 
-//------------------------------------------------------------------------------
-static int
-s11_send_init_udp (
-  struct in_addr *address,
-  uint16_t port_number)
-{
-  MessageDef                             *message_p = itti_alloc_new_message (TASK_S11, UDP_INIT);
-  if (message_p == NULL) {
-    return RETURNerror;
-  }
-  message_p->ittiMsg.udp_init.port = port_number;
-  message_p->ittiMsg.udp_init.address.s_addr = address->s_addr;
-  char ipv4[INET_ADDRSTRLEN];
-  inet_ntop (AF_INET, (void*)&message_p->ittiMsg.udp_init.address, ipv4, INET_ADDRSTRLEN);
-  OAILOG_DEBUG (LOG_S11, "Tx UDP_INIT IP addr %s:%" PRIu16 "\n", ipv4, message_p->ittiMsg.udp_init.port);
-  return itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
-}
-
 //------------------------------------------------------------------------------
 int s11_mme_init (const mme_config_t * const mme_config_p)
 {
   int                                     ret = 0;
-  nw_gtpv2c_ulp_entity_t                      ulp;
-  nw_gtpv2c_udp_entity_t                      udp;
-  nw_gtpv2c_timer_mgr_entity_t                 tmrMgr;
-  nw_gtpv2c_log_mgr_entity_t                   logMgr;
+  struct in_addr                          s11_address = {0};
+  uint16_t                                s11_port = 0;
+  uint32_t                                s11_threads = 0;
 
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface\n");
 
-  if (nwGtpv2cInitialize (&s11_mme_stack_handle) != NW_OK) {
-    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
+  if ((s11_mme_session_manager_init () != RETURNok) || (s11_mme_bearer_manager_init () != RETURNok)) {
     goto fail;
   }
 
-  /*
-   * Set ULP entity
-   */
-  ulp.hUlp = (nw_gtpv2c_ulp_handle_t) NULL;
-  ulp.ulpReqCallback = s11_mme_ulp_process_stack_req_cb;
-  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (s11_mme_stack_handle, &ulp));
-  /*
-   * Set UDP entity
-   */
-  udp.hUdp = (nw_gtpv2c_udp_handle_t) NULL;
-  udp.udpDataReqCallback = s11_mme_send_udp_msg;
-  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (s11_mme_stack_handle, &udp));
-  /*
-   * Set Timer entity
-   */
-  tmrMgr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t) NULL;
-  tmrMgr.tmrStartCallback = s11_mme_start_timer_wrapper;
-  tmrMgr.tmrStopCallback = s11_mme_stop_timer_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (s11_mme_stack_handle, &tmrMgr));
-  logMgr.logMgrHandle = 0;
-  logMgr.logReqCallback = s11_mme_log_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (s11_mme_stack_handle, &logMgr));
+  bstring b = bfromcstr("s11_mme_teid_2_gtv2c_teid_handle");
+  s11_mme_teid_2_gtv2c_teid_handle = hashtable_ts_create(mme_config_p->max_ues, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, b);
+  bdestroy_wrapper (&b);
+
+  mme_config_read_lock (&mme_config);
+  s11_address.s_addr = mme_config.ipv4.s11.s_addr;
+  s11_port = mme_config.ipv4.port_s11;
+  s11_threads = mme_config.ipv4.threads_s11;
+  mme_config_unlock (&mme_config);
+
+  if (s11_shard_init (s11_threads, &s11_address, s11_port, s11_mme_ulp_process_stack_req_cb, s11_mme_shard_message_handler) != RETURNok) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stacks\n");
+    goto fail;
+  }
 
   if (itti_create_task (TASK_S11, &s11_mme_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S11, "gtpv1u phtread_create: %s\n", strerror (errno));
     goto fail;
   }
 
-  DevAssert (NW_OK == nwGtpv2cSetLogLevel (s11_mme_stack_handle, NW_LOG_LEVEL_DEBG));
-  mme_config_read_lock (&mme_config);
-  s11_send_init_udp (&mme_config.ipv4.s11, mme_config.ipv4.port_s11);
-  mme_config_unlock (&mme_config);
-
-  bstring b = bfromcstr("s11_mme_teid_2_gtv2c_teid_handle");
-  s11_mme_teid_2_gtv2c_teid_handle = hashtable_ts_create(mme_config_p->max_ues, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, b);
-  bdestroy_wrapper (&b);
-
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface: DONE\n");
   return ret;
 fail:
@@ -342,9 +315,7 @@ fail:
 //------------------------------------------------------------------------------
 static void s11_mme_exit (void)
 {
-  if (nwGtpv2cFinalize(s11_mme_stack_handle) != NW_OK) {
-    OAI_FPRINTF_ERR ("An error occurred during tear down of nwGtp s11 stack.\n");
-  }
+  s11_shard_exit ();
   if (hashtable_ts_destroy(s11_mme_teid_2_gtv2c_teid_handle) != HASH_TABLE_OK) {
     OAI_FPRINTF_ERR("An error occured while destroying s11 teid hash table");
   }
@@ -54,10 +54,9 @@
 #include "s11_sgw.h"
 #include "s11_sgw_bearer_manager.h"
 #include "s11_sgw_session_manager.h"
+#include "s11_shard.h"
 
 
-static nw_gtpv2c_stack_handle_t             s11_sgw_stack_handle = 0;
-
 hash_table_ts_t                        *s11_sgw_teid_2_gtv2c_teid_handle = NULL;
 
 static void s11_sgw_exit (void);
@@ -66,6 +65,7 @@ static void s11_sgw_exit (void);
 //------------------------------------------------------------------------------
 static nw_rc_t s11_sgw_ulp_process_stack_req_cb (nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t * pUlpApi)
 {
+  nw_gtpv2c_stack_handle_t               *stack_p = (nw_gtpv2c_stack_handle_t *)hUlp;
   int                                     ret = 0;
 
   DevAssert (pUlpApi );
@@ -76,19 +76,19 @@ static nw_rc_t s11_sgw_ulp_process_stack_req_cb (nw_gtpv2c_ulp_handle_t hUlp, nw
 
       switch (pUlpApi->u_api_info.initialReqIndInfo.msgType) {
         case NW_GTP_CREATE_SESSION_REQ:
-          ret = s11_sgw_handle_create_session_request (&s11_sgw_stack_handle, pUlpApi);
+          ret = s11_sgw_handle_create_session_request (stack_p, pUlpApi);
           break;
 
         case NW_GTP_MODIFY_BEARER_REQ:
-          ret = s11_sgw_handle_modify_bearer_request (&s11_sgw_stack_handle, pUlpApi);
+          ret = s11_sgw_handle_modify_bearer_request (stack_p, pUlpApi);
           break;
 
         case NW_GTP_DELETE_SESSION_REQ:
-          ret = s11_sgw_handle_delete_session_request (&s11_sgw_stack_handle, pUlpApi);
+          ret = s11_sgw_handle_delete_session_request (stack_p, pUlpApi);
           break;
 
         case NW_GTP_RELEASE_ACCESS_BEARERS_REQ:
-          ret = s11_sgw_handle_release_access_bearers_request (&s11_sgw_stack_handle, pUlpApi);
+          ret = s11_sgw_handle_release_access_bearers_request (stack_p, pUlpApi);
           break;
 
         default:
@@ -105,7 +105,7 @@ static nw_rc_t s11_sgw_ulp_process_stack_req_cb (nw_gtpv2c_ulp_handle_t hUlp, nw
         OAILOG_WARNING (LOG_S11, "Received response indication from ULP API\n");
         switch (pUlpApi->u_api_info.triggeredRspIndInfo.msgType) {
         case NW_GTP_CREATE_BEARER_RSP:
-          ret = s11_sgw_handle_create_bearer_response (&s11_sgw_stack_handle, pUlpApi);
+          ret = s11_sgw_handle_create_bearer_response (stack_p, pUlpApi);
           break;
 
           default:
@@ -123,72 +123,78 @@ static nw_rc_t s11_sgw_ulp_process_stack_req_cb (nw_gtpv2c_ulp_handle_t hUlp, nw
 }
 
 //------------------------------------------------------------------------------
-static nw_rc_t s11_sgw_send_udp_msg (
-  nw_gtpv2c_udp_handle_t udpHandle,
-  uint8_t * buffer,
-  uint32_t buffer_len,
-  struct in_addr *peerIpAddr,
-  uint16_t peerPort)
+// Hand a Create Session Response back to TASK_S11, that sends it to the shard owning its transaction
+static void s11_sgw_forward_create_session_response (itti_s11_create_session_response_t * const create_session_response_p)
 {
-  // Create and alloc new message
-  MessageDef                             *message_p;
-  udp_data_req_t                         *udp_data_req_p;
-  int                                     ret = 0;
+  MessageDef                             *message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_RESPONSE);
 
-  message_p = itti_alloc_new_message (TASK_S11, UDP_DATA_REQ);
-  udp_data_req_p = &message_p->ittiMsg.udp_data_req;
-  udp_data_req_p->peer_address.s_addr = peerIpAddr->s_addr;
-  udp_data_req_p->peer_port = peerPort;
-  udp_data_req_p->buffer = buffer;
-  udp_data_req_p->buffer_length = buffer_len;
-  ret = itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
-  return ret == 0 ? NW_OK : NW_FAILURE;
+  if (!message_p) {
+    OAILOG_ERROR (LOG_S11, "Could not forward S11_CREATE_SESSION_RESPONSE for S-GW teid " TEID_FMT "\n", create_session_response_p->s11_sgw_fteid.teid);
+    return;
+  }
+  message_p->ittiMsg.s11_create_session_response = *create_session_response_p;
+  // The PCO now belong to the forwarded message
+  memset (&create_session_response_p->pco, 0, sizeof (create_session_response_p->pco));
+  itti_send_msg_to_task (TASK_S11, INSTANCE_DEFAULT, message_p);
 }
 
 //------------------------------------------------------------------------------
-static nw_rc_t s11_sgw_log_wrapper (
-  nw_gtpv2c_log_mgr_handle_t hLogMgr,
-  uint32_t logLevel,
-  char * file,
-  uint32_t line,
-  char * logStr)
+// Called on the thread of the shard owning the tunnel or transaction
+static void s11_sgw_shard_message_handler (nw_gtpv2c_stack_handle_t * const stack_p, MessageDef * const received_message_p)
 {
-  OAILOG_DEBUG (LOG_S11, "%s\n", logStr);
-  return NW_OK;
-}
+  switch (ITTI_MSG_ID (received_message_p)) {
+  case S11_CREATE_BEARER_REQUEST:{
+      OAILOG_DEBUG (LOG_S11, "Received S11_CREATE_BEARER_REQUEST from S-PGW APP\n");
+      s11_sgw_handle_create_bearer_request (stack_p, &received_message_p->ittiMsg.s11_create_bearer_request);
+    }
+    break;
 
-//------------------------------------------------------------------------------
-static nw_rc_t s11_sgw_start_timer_wrapper (
-  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
-  uint32_t timeoutSec,
-  uint32_t timeoutUsec,
-  uint32_t tmrType,
-  void *timeoutArg,
-  nw_gtpv2c_timer_handle_t * hTmr)
-{
-  long                                    timer_id;
-  int                                     ret = 0;
+  case S11_CREATE_SESSION_RESPONSE:{
+      itti_s11_create_session_response_t * const create_session_response_p = &received_message_p->ittiMsg.s11_create_session_response;
 
-  if (tmrType == NW_GTPV2C_TMR_TYPE_REPETITIVE) {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_PERIODIC, timeoutArg, &timer_id);
-  } else {
-    ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, INSTANCE_DEFAULT, TIMER_ONE_SHOT, timeoutArg, &timer_id);
-  }
+      OAILOG_DEBUG (LOG_S11, "Received S11_CREATE_SESSION_RESPONSE from %s\n", ITTI_MSG_ORIGIN_NAME (received_message_p));
+      if (TASK_S11 != ITTI_MSG_ORIGIN_ID (received_message_p)) {
+        // This is the shard owning the S-GW S11 TEID, the tunnel must exist before the MME gets the response
+        s11_sgw_create_local_tunnel (stack_p, create_session_response_p);
+        if (s11_shard_from_trxn (create_session_response_p->trxn) != s11_shard_from_teid (create_session_response_p->s11_sgw_fteid.teid)) {
+          s11_sgw_forward_create_session_response (create_session_response_p);
+          break;
+        }
+      }
+      s11_sgw_handle_create_session_response (stack_p, create_session_response_p);
+    }
+    break;
 
-  return ret == 0 ? NW_OK : NW_FAILURE;
-}
+  case S11_DELETE_SESSION_RESPONSE:{
+      OAILOG_DEBUG (LOG_S11, "Received S11_DELETE_SESSION_RESPONSE from S-PGW APP\n");
+      s11_sgw_handle_delete_session_response (stack_p, &received_message_p->ittiMsg.s11_delete_session_response);
+    }
+    break;
 
-//------------------------------------------------------------------------------
-static nw_rc_t s11_sgw_stop_timer_wrapper (
-  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
-  nw_gtpv2c_timer_handle_t tmrHandle)
-{
-  int                                     ret;
-  long                                    timer_id;
+  case S11_MODIFY_BEARER_RESPONSE:{
+      OAILOG_DEBUG (LOG_S11, "Received S11_MODIFY_BEARER_RESPONSE from S-PGW APP\n");
+      s11_sgw_handle_modify_bearer_response (stack_p, &received_message_p->ittiMsg.s11_modify_bearer_response);
+    }
+    break;
+
+  case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
+      OAILOG_DEBUG (LOG_S11, "Received S11_RELEASE_ACCESS_BEARERS_RESPONSE from S-PGW APP\n");
+      s11_sgw_handle_release_access_bearers_response (stack_p, &received_message_p->ittiMsg.s11_release_access_bearers_response);
+    }
+    break;
+
+  case TIMER_HAS_EXPIRED:{
+      OAILOG_DEBUG (LOG_S11, "Received event TIMER_HAS_EXPIRED for timer_id 0x%lx and arg %p\n",
+          received_message_p->ittiMsg.timer_has_expired.timer_id, received_message_p->ittiMsg.timer_has_expired.arg);
+      DevAssert (nwGtpv2cProcessTimeout (received_message_p->ittiMsg.timer_has_expired.arg) == NW_OK);
+    }
+    break;
 
-  timer_id = (long)tmrHandle;
-  ret = timer_remove (timer_id, NULL);
-  return ret == 0 ? NW_OK : NW_FAILURE;
+  default:{
+      OAILOG_ERROR (LOG_S11, "Unkwnon message ID %d:%s\n", ITTI_MSG_ID (received_message_p), ITTI_MSG_NAME (received_message_p));
+    }
+    break;
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -199,59 +205,60 @@ static void *s11_sgw_thread (void *args)
   while (1) {
     MessageDef                             *received_message_p = NULL;
 
-    itti_receive_msg (TASK_S11, &received_message_p);
-
-    switch (ITTI_MSG_ID (received_message_p)) {
-    case UDP_DATA_IND:{
-        /*
-         * We received new data to handle from the UDP layer
-         */
-        nw_rc_t                                   rc;
-        udp_data_ind_t                         *udp_data_ind;
-
-        udp_data_ind = &received_message_p->ittiMsg.udp_data_ind;
-        OAILOG_DEBUG (LOG_S11, "Processing new data indication from UDP\n");
-        rc = nwGtpv2cProcessUdpReq (s11_sgw_stack_handle, udp_data_ind->buffer, udp_data_ind->buffer_length, udp_data_ind->peer_port, &udp_data_ind->peer_address);
-        DevAssert (rc == NW_OK);
+    /*
+     * While shards have messages they were not woken up for, only poll: they are woken up once the queue is empty
+     */
+    if (s11_shard_flush_pending ()) {
+      itti_poll_msg (TASK_S11, &received_message_p);
+      if (received_message_p == NULL) {
+        s11_shard_flush ();
+        continue;
       }
-      break;
+    } else {
+      itti_receive_msg (TASK_S11, &received_message_p);
+    }
 
+    /*
+     * Hand the message to the shard owning the transaction (or the S-GW S11 TEID), the shard frees it
+     */
+    switch (ITTI_MSG_ID (received_message_p)) {
     case S11_CREATE_BEARER_REQUEST:{
-        OAILOG_DEBUG (LOG_S11, "Received S11_CREATE_BEARER_REQUEST from S-PGW APP\n");
-        s11_sgw_handle_create_bearer_request (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_create_bearer_request);
+        s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_create_bearer_request.local_teid), received_message_p);
       }
-      break;
+      continue;
 
     case S11_CREATE_SESSION_RESPONSE:{
-        OAILOG_DEBUG (LOG_S11, "Received S11_CREATE_SESSION_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_create_session_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_create_session_response);
+        /*
+         * From S-PGW APP, to the shard owning the S-GW S11 TEID that creates its local tunnel;
+         * forwarded by that shard when the transaction belongs to another shard.
+         */
+        if (TASK_S11 == ITTI_MSG_ORIGIN_ID (received_message_p)) {
+          s11_shard_send_msg (s11_shard_from_trxn (received_message_p->ittiMsg.s11_create_session_response.trxn), received_message_p);
+        } else {
+          s11_shard_send_msg (s11_shard_from_teid (received_message_p->ittiMsg.s11_create_session_response.s11_sgw_fteid.teid), received_message_p);
+        }
       }
-      break;
+      continue;
 
     case S11_DELETE_SESSION_RESPONSE:{
-        OAILOG_DEBUG (LOG_S11, "Received S11_DELETE_SESSION_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_delete_session_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_delete_session_response);
+        s11_shard_send_msg (s11_shard_from_trxn (received_message_p->ittiMsg.s11_delete_session_response.trxn), received_message_p);
       }
-      break;
+      continue;
 
     case S11_MODIFY_BEARER_RESPONSE:{
-        OAILOG_DEBUG (LOG_S11, "Received S11_MODIFY_BEARER_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_modify_bearer_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_modify_bearer_response);
+        s11_shard_send_msg (s11_shard_from_trxn (received_message_p->ittiMsg.s11_modify_bearer_response.trxn), received_message_p);
       }
-      break;
+      continue;
 
     case S11_RELEASE_ACCESS_BEARERS_RESPONSE:{
-        OAILOG_DEBUG (LOG_S11, "Received S11_RELEASE_ACCESS_BEARERS_RESPONSE from S-PGW APP\n");
-        s11_sgw_handle_release_access_bearers_response (&s11_sgw_stack_handle, &received_message_p->ittiMsg.s11_release_access_bearers_response);
+        s11_shard_send_msg (s11_shard_from_trxn (received_message_p->ittiMsg.s11_release_access_bearers_response.trxn), received_message_p);
       }
-      break;
+      continue;
 
     case TIMER_HAS_EXPIRED:{
-        OAILOG_DEBUG (LOG_S11, "Received event TIMER_HAS_EXPIRED for timer_id 0x%lx and arg %p\n",
-            received_message_p->ittiMsg.timer_has_expired.timer_id, received_message_p->ittiMsg.timer_has_expired.arg);
-        DevAssert (nwGtpv2cProcessTimeout (received_message_p->ittiMsg.timer_has_expired.arg) == NW_OK);
+        s11_shard_send_msg (ITTI_MSG_INSTANCE (received_message_p), received_message_p);
       }
-      break;
+      continue;
 
     case TERMINATE_MESSAGE:{
         s11_sgw_exit();
@@ -274,79 +281,38 @@ static void *s11_sgw_thread (void *args)
   return NULL;
 }
 
-//------------------------------------------------------------------------------
-static int s11_send_init_udp (struct in_addr *address, uint16_t port_number)
-{
-  MessageDef                             *message_p;
-
-  message_p = itti_alloc_new_message (TASK_S11, UDP_INIT);
-
-  if (message_p == NULL) {
-    return RETURNerror;
-  }
-
-  message_p->ittiMsg.udp_init.port = port_number;
-  message_p->ittiMsg.udp_init.address.s_addr = address->s_addr;
-  char ipv4[INET_ADDRSTRLEN];
-  inet_ntop (AF_INET, (void*)&message_p->ittiMsg.udp_init.address, ipv4, INET_ADDRSTRLEN);
-  OAILOG_DEBUG (LOG_S11, "Tx UDP_INIT IP addr %s:%" PRIu16"\n", ipv4, message_p->ittiMsg.udp_init.port);
-  return itti_send_msg_to_task (TASK_UDP, INSTANCE_DEFAULT, message_p);
-}
-
 //------------------------------------------------------------------------------
 int s11_sgw_init (sgw_config_t * config_p)
 {
   int                                     ret = 0;
-  nw_gtpv2c_ulp_entity_t                      ulp;
-  nw_gtpv2c_udp_entity_t                      udp;
-  nw_gtpv2c_timer_mgr_entity_t                 tmrMgr;
-  nw_gtpv2c_log_mgr_entity_t                   logMgr;
+  struct in_addr                          s11_address = {0};
+  uint32_t                                s11_threads = 0;
 
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface\n");
 
-  if (nwGtpv2cInitialize (&s11_sgw_stack_handle) != NW_OK) {
-    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stack\n");
+  if ((s11_sgw_session_manager_init () != RETURNok) || (s11_sgw_bearer_manager_init () != RETURNok)) {
     goto fail;
   }
 
-  /*
-   * Set ULP entity
-   */
-  ulp.hUlp = (nw_gtpv2c_ulp_handle_t) NULL;
-  ulp.ulpReqCallback = s11_sgw_ulp_process_stack_req_cb;
-  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (s11_sgw_stack_handle, &ulp));
-  /*
-   * Set UDP entity
-   */
-  udp.hUdp = (nw_gtpv2c_udp_handle_t) NULL;
-  udp.udpDataReqCallback = s11_sgw_send_udp_msg;
-  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (s11_sgw_stack_handle, &udp));
-  /*
-   * Set Timer entity
-   */
-  tmrMgr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t) NULL;
-  tmrMgr.tmrStartCallback = s11_sgw_start_timer_wrapper;
-  tmrMgr.tmrStopCallback = s11_sgw_stop_timer_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (s11_sgw_stack_handle, &tmrMgr));
-  logMgr.logMgrHandle = 0;
-  logMgr.logReqCallback = s11_sgw_log_wrapper;
-  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (s11_sgw_stack_handle, &logMgr));
-
-
   bstring b = bfromcstr("s11_sgw_teid_2_gtv2c_teid_handle");
   s11_sgw_teid_2_gtv2c_teid_handle = hashtable_ts_create(256, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, b);
   bdestroy_wrapper (&b);
 
+  sgw_config_read_lock (config_p);
+  s11_address.s_addr = config_p->ipv4.S11.s_addr;
+  s11_threads = config_p->ipv4.threads_S11;
+  sgw_config_unlock (config_p);
+
+  if (s11_shard_init (s11_threads, &s11_address, 2123, s11_sgw_ulp_process_stack_req_cb, s11_sgw_shard_message_handler) != RETURNok) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize gtpv2-c stacks\n");
+    goto fail;
+  }
 
   if (itti_create_task (TASK_S11, &s11_sgw_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S11, "S11 pthread_create: %s\n", strerror (errno));
     goto fail;
   }
 
-  DevAssert (NW_OK == nwGtpv2cSetLogLevel (s11_sgw_stack_handle, NW_LOG_LEVEL_DEBG));
-  sgw_config_read_lock (config_p);
-  s11_send_init_udp (&config_p->ipv4.S11, 2123);
-  sgw_config_unlock (config_p);
   OAILOG_DEBUG (LOG_S11, "Initializing S11 interface: DONE\n");
   return ret;
 fail:
@@ -356,7 +322,6 @@ fail:
 //------------------------------------------------------------------------------
 static void s11_sgw_exit (void)
 {
-  nwGtpv2cFinalize (s11_sgw_stack_handle);
+  s11_shard_exit ();
   hashtable_ts_destroy(s11_sgw_teid_2_gtv2c_teid_handle);
 }
-
@@ -51,6 +51,102 @@
 
 extern hash_table_ts_t                        *s11_sgw_teid_2_gtv2c_teid_handle;
 
+/*
+ * Bearer Context to be modified within Modify Bearer Request, 3GPP TS 29.274 Table 7.2.7-2.
+ */
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_bearer_context_to_be_modified_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, bearer_context_to_be_modified_t, eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_modified_t, s1_eNB_fteid),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_bearer_context_to_be_modified_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_modify_bearer_request_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_indication_flags_ie_get, itti_s11_modify_bearer_request_t, indication_flags),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FQ_CSID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fqcsid_ie_get, itti_s11_modify_bearer_request_t, mme_fq_csid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_rat_type_ie_get, itti_s11_modify_bearer_request_t, rat_type),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_delay_value_ie_get, itti_s11_modify_bearer_request_t, delay_dl_packet_notif_req),
+  NW_GTPV2C_GROUPED_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      &s11_sgw_bearer_context_to_be_modified_parser, itti_s11_modify_bearer_request_t, bearer_contexts_to_be_modified, num_bearer_context, bearer_contexts),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_modify_bearer_request_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_release_access_bearers_request_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_NODE_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_node_type_ie_get, itti_s11_release_access_bearers_request_t, originating_node),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_release_access_bearers_request_parser;
+
+/*
+ * Bearer Context within Create Bearer Response, 3GPP TS 29.274 Table 7.2.4-2.
+ */
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_bearer_context_within_create_bearer_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, bearer_context_within_create_bearer_response_t, eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_cause_ie_get, bearer_context_within_create_bearer_response_t, cause),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s1u_enb_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s1u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_TWO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s5_s8_u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_THREE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s5_s8_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_FOUR, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s12_rnc_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 5, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s12_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 6, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s4_u_sgsn_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 7, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s4_u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 8, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s2b_u_epdg_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 9, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_within_create_bearer_response_t, s2b_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_pco_ie_get, bearer_context_within_create_bearer_response_t, pco),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_bearer_context_within_create_bearer_response_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_create_bearer_response_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_cause_ie_get, itti_s11_create_bearer_response_t, cause),
+  NW_GTPV2C_GROUPED_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      &s11_sgw_bearer_context_within_create_bearer_response_parser, itti_s11_create_bearer_response_t, bearer_contexts, num_bearer_context, bearer_contexts),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_pco_ie_get, itti_s11_create_bearer_response_t, pco),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_create_bearer_response_parser;
+
+//------------------------------------------------------------------------------
+int
+s11_sgw_bearer_manager_init (void)
+{
+  if ((NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_bearer_context_to_be_modified_parser, 0, s11_sgw_bearer_context_to_be_modified_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_modify_bearer_request_parser, NW_GTP_MODIFY_BEARER_REQ, s11_sgw_modify_bearer_request_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_release_access_bearers_request_parser, NW_GTP_RELEASE_ACCESS_BEARERS_REQ,
+                                                s11_sgw_release_access_bearers_request_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_bearer_context_within_create_bearer_response_parser, 0,
+                                                s11_sgw_bearer_context_within_create_bearer_response_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_create_bearer_response_parser, NW_GTP_CREATE_BEARER_RSP, s11_sgw_create_bearer_response_ies))) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 S-GW bearer management message parsers\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
 //------------------------------------------------------------------------------
 int
 s11_sgw_handle_modify_bearer_request (
@@ -63,7 +159,6 @@ s11_sgw_handle_modify_bearer_request (
   uint16_t                                offendingIeLength;
   itti_s11_modify_bearer_request_t       *request_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_MODIFY_BEARER_REQUEST);
@@ -71,41 +166,9 @@ s11_sgw_handle_modify_bearer_request (
   request_p->trxn = (void *)pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
   request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_MODIFY_BEARER_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Indication Flags IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_indication_flags_ie_get, &request_p->indication_flags);
-  DevAssert (NW_OK == rc);
-  /*
-   * MME-FQ-CSID IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FQ_CSID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_fqcsid_ie_get, &request_p->mme_fq_csid);
-  DevAssert (NW_OK == rc);
-  /*
-   * RAT Type IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_rat_type_ie_get, &request_p->rat_type);
-  DevAssert (NW_OK == rc);
-  /*
-   * Delay Value IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_DELAY_VALUE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_delay_value_ie_get, &request_p->delay_dl_packet_notif_req);
-  DevAssert (NW_OK == rc);
-  /*
-   * Bearer Context to be modified IE
+   * Run the parser
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_bearer_context_to_be_modified_within_modify_bearer_request_ie_get, &request_p->bearer_contexts_to_be_modified);
-  DevAssert (NW_OK == rc);
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_sgw_modify_bearer_request_parser, (pUlpApi->hMsg), request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtpv2c_cause_t                             cause;
@@ -141,15 +204,11 @@ s11_sgw_handle_modify_bearer_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return NW_OK;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
@@ -202,7 +261,6 @@ s11_sgw_handle_release_access_bearers_request (
   uint16_t                                offendingIeLength;
   itti_s11_release_access_bearers_request_t  *request_p = NULL;
   MessageDef                             *message_p = NULL;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser = NULL;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_RELEASE_ACCESS_BEARERS_REQUEST);
@@ -211,16 +269,9 @@ s11_sgw_handle_release_access_bearers_request (
   request_p->trxn = (void *)pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
   request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   /*
-   * Create a new message parser
+   * Run the parser
    */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_RELEASE_ACCESS_BEARERS_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-
-
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_NODE_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_node_type_ie_get, &request_p->originating_node);
-
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_sgw_release_access_bearers_request_parser, (pUlpApi->hMsg), request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtpv2c_cause_t                             cause;
@@ -256,15 +307,11 @@ s11_sgw_handle_release_access_bearers_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNok;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
 
@@ -330,11 +377,9 @@ s11_sgw_handle_create_bearer_request (
   ulp_req.u_api_info.initialReqInfo.peerIp     = request_p->peer_ip;
   ulp_req.u_api_info.initialReqInfo.teidLocal  = request_p->local_teid;
 
+  // If not found, hTunnel stays 0 and the stack creates the local tunnel
   hashtable_rc_t hash_rc = hashtable_ts_get(s11_sgw_teid_2_gtv2c_teid_handle,
       (hash_key_t) ulp_req.u_api_info.initialReqInfo.teidLocal, (void **)(uintptr_t)&ulp_req.u_api_info.initialReqInfo.hTunnel);
-  if (HASH_TABLE_OK != hash_rc) {
-    OAILOG_WARNING (LOG_S11, "Could not get GTPv2-C hTunnel for local teid %X\n", ulp_req.u_api_info.initialReqInfo.teidLocal);
-  }
 
   /*
    * Set the remote TEID
@@ -360,6 +405,15 @@ s11_sgw_handle_create_bearer_request (
 
   rc = nwGtpv2cProcessUlpReq (*stack_p, &ulp_req);
   DevAssert (NW_OK == rc);
+
+  if (HASH_TABLE_OK != hash_rc) {
+    hash_rc = hashtable_ts_insert(s11_sgw_teid_2_gtv2c_teid_handle,
+        (hash_key_t) ulp_req.u_api_info.initialReqInfo.teidLocal, (void *)ulp_req.u_api_info.initialReqInfo.hTunnel);
+    if (HASH_TABLE_OK != hash_rc) {
+      OAILOG_WARNING (LOG_S11, "Could not save GTPv2-C hTunnel %p for local teid %X\n", (void*)ulp_req.u_api_info.initialReqInfo.hTunnel,
+          ulp_req.u_api_info.initialReqInfo.teidLocal);
+    }
+  }
   return RETURNok;
 }
 
@@ -375,7 +429,6 @@ s11_sgw_handle_create_bearer_response (
   uint16_t                                offendingIeLength;
   itti_s11_create_bearer_response_t      *resp_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                 *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_BEARER_RESPONSE);
@@ -383,33 +436,10 @@ s11_sgw_handle_create_bearer_response (
 
   resp_p->teid = nwGtpv2cMsgGetTeid(pUlpApi->hMsg);
 
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_BEARER_RSP, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Cause IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_CAUSE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY, gtpv2c_cause_ie_get,
-      &resp_p->cause);
-  DevAssert (NW_OK == rc);
-
-
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      gtpv2c_bearer_context_within_create_bearer_response_ie_get,
-      &resp_p->bearer_contexts);
-  DevAssert (NW_OK == rc);
-
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL, gtpv2c_pco_ie_get,
-      &resp_p->pco);
-  DevAssert (NW_OK == rc);
-
-
   /*
    * Run the parser
    */
-  rc = nwGtpv2cMsgParserRun (pMsgParser, (pUlpApi->hMsg), &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  rc = nwGtpv2cMsgParserDescRun (&s11_sgw_create_bearer_response_parser, (pUlpApi->hMsg), resp_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     MSC_LOG_RX_DISCARDED_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_BEARER_RESPONSE local S11 teid " TEID_FMT " ", resp_p->teid);
@@ -418,8 +448,6 @@ s11_sgw_handle_create_bearer_response (
      */
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNerror;
@@ -428,8 +456,6 @@ s11_sgw_handle_create_bearer_response (
   MSC_LOG_RX_MESSAGE (MSC_S11_MME, MSC_SGW, NULL, 0, "0 CREATE_BEARER_RESPONSE local S11 teid " TEID_FMT " cause %u",
     resp_p->teid, resp_p->cause);
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
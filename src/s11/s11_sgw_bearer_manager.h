@@ -30,6 +30,8 @@
 #ifndef FILE_S11_SGW_BEARER_MANAGER_SEEN
 #define FILE_S11_SGW_BEARER_MANAGER_SEEN
 
+int s11_sgw_bearer_manager_init(void);
+
 int s11_sgw_handle_modify_bearer_request(
   nw_gtpv2c_stack_handle_t *stack_p,
   nw_gtpv2c_ulp_api_t      *pUlpApi);
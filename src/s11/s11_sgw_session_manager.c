@@ -51,148 +51,139 @@
 
 extern hash_table_ts_t                        *s11_sgw_teid_2_gtv2c_teid_handle;
 
-//------------------------------------------------------------------------------
-int
-s11_sgw_handle_create_session_request (
-  nw_gtpv2c_stack_handle_t * stack_p,
-  nw_gtpv2c_ulp_api_t * pUlpApi)
-{
-  nw_rc_t                                   rc = NW_OK;
-  uint8_t                                 offendingIeType,
-                                          offendingIeInstance;
-  uint16_t                                offendingIeLength;
-  itti_s11_create_session_request_t      *create_session_request_p;
-  MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
-
-  DevAssert (stack_p );
-  message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_REQUEST);
-  create_session_request_p = &message_p->ittiMsg.s11_create_session_request;
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_CREATE_SESSION_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * Imsi IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_imsi_ie_get, &create_session_request_p->imsi);
-  DevAssert (NW_OK == rc);
+/*
+ * Bearer Context to be created within Create Session Request, 3GPP TS 29.274 Table 7.2.1-2.
+ */
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_bearer_context_to_be_created_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_ebi_ie_get, bearer_context_to_be_created_t, eps_bearer_id),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_TFT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_tft_ie_get, bearer_context_to_be_created_t, tft),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s1u_enb_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s4u_sgsn_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_TWO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s5_s8_u_sgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_THREE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s5_s8_u_pgw_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_FOUR, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s12_rnc_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, 5, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, bearer_context_to_be_created_t, s2b_u_epdg_fteid),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_LEVEL_QOS, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_bearer_qos_ie_get, bearer_context_to_be_created_t, bearer_level_qos),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_bearer_context_to_be_created_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_create_session_request_ies[] = {
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_IMSI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_imsi_ie_get, itti_s11_create_session_request_t, imsi),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_MSISDN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_msisdn_ie_get, itti_s11_create_session_request_t, msisdn),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_MEI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_mei_ie_get, itti_s11_create_session_request_t, mei),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_ULI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_uli_ie_get, itti_s11_create_session_request_t, uli),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_SERVING_NETWORK, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_serving_network_ie_get, itti_s11_create_session_request_t, serving_network),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_rat_type_ie_get, itti_s11_create_session_request_t, rat_type),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_indication_flags_ie_get, itti_s11_create_session_request_t, indication_flags),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_apn_ie_get, itti_s11_create_session_request_t, apn),
+  NW_GTPV2C_IE_PARSE_DESC_NO_VALUE (NW_GTPV2C_IE_SELECTION_MODE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PDN_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_pdn_type_ie_get, itti_s11_create_session_request_t, pdn_type),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_paa_ie_get, itti_s11_create_session_request_t, paa),
   /*
-   * MSISDN IE
+   * Sender FTEID for CP IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_MSISDN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_msisdn_ie_get, &create_session_request_p->msisdn);
-  DevAssert (NW_OK == rc);
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      gtpv2c_fteid_ie_get, itti_s11_create_session_request_t, sender_fteid_for_cp),
   /*
-   * MEI IE
+   * PGW FTEID for CP IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_MEI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_mei_ie_get, &create_session_request_p->mei);
-  DevAssert (NW_OK == rc);
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_fteid_ie_get, itti_s11_create_session_request_t, pgw_address_for_cp),
+  NW_GTPV2C_IE_PARSE_DESC_NO_VALUE (NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL),
+  NW_GTPV2C_GROUPED_IE_PARSE_DESC (NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
+      &s11_sgw_bearer_context_to_be_created_parser, itti_s11_create_session_request_t, bearer_contexts_to_be_created, num_bearer_context, bearer_contexts),
   /*
-   * ULI IE
+   * TODO Bearer Contexts to be removed IE (instance 1)
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_ULI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_uli_ie_get, &create_session_request_p->uli);
-  DevAssert (NW_OK == rc);
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_pco_ie_get, itti_s11_create_session_request_t, pco),
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_ambr_ie_get, itti_s11_create_session_request_t, ambr),
+  NW_GTPV2C_IE_PARSE_DESC_NO_VALUE (NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY),
+};
+
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_create_session_request_parser;
+
+static const nw_gtpv2c_ie_parse_desc_t         s11_sgw_delete_session_request_ies[] = {
   /*
-   * Serving Network IE
+   * MME FTEID for CP IE
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_SERVING_NETWORK, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_serving_network_ie_get, &create_session_request_p->serving_network);
-  DevAssert (NW_OK == rc);
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_fteid_ie_get, itti_s11_delete_session_request_t, sender_fteid_for_cp),
   /*
-   * RAT Type IE
+   * Linked EPS Bearer Id IE
+   * This information element shall not be present for TAU/RAU/Handover with
+   * S-GW relocation procedures.
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RAT_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  gtpv2c_rat_type_ie_get, &create_session_request_p->rat_type);
-  DevAssert (NW_OK == rc);
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
+      gtpv2c_ebi_ie_get, itti_s11_delete_session_request_t, lbi),
   /*
    * Indication Flags IE
+   * For a Delete Session Request on S11 interface,
+   * only the Operation Indication flag might be present.
    */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_indication_flags_ie_get, &create_session_request_p->indication_flags);
-  DevAssert (NW_OK == rc);
-  /*
-   * APN IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_APN, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  gtpv2c_apn_ie_get, &create_session_request_p->apn);
-  DevAssert (NW_OK == rc);
-  /*
-   * Selection Mode IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_SELECTION_MODE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
-  /*
-   * PDN Type IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PDN_TYPE, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_pdn_type_ie_get, &create_session_request_p->pdn_type);
-  DevAssert (NW_OK == rc);
-  /*
-   * PAA IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PAA, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           gtpv2c_paa_ie_get, &create_session_request_p->paa);
-  DevAssert (NW_OK == rc);
-  /*
-   * Sender FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-           gtpv2c_fteid_ie_get, &create_session_request_p->sender_fteid_for_cp);
-  DevAssert (NW_OK == rc);
-  /*
-   * PGW FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-		  gtpv2c_fteid_ie_get, &create_session_request_p->pgw_address_for_cp);
-  DevAssert (NW_OK == rc);
-  /*
-   * APN Restriction IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_APN_RESTRICTION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
-  /*
-   * Bearer Context IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-      gtpv2c_bearer_context_to_be_created_within_create_session_request_ie_get, &create_session_request_p->bearer_contexts_to_be_created);
-  DevAssert (NW_OK == rc);
-
+  NW_GTPV2C_IE_PARSE_DESC (NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
+      gtpv2c_indication_flags_ie_get, itti_s11_delete_session_request_t, indication_flags),
+};
 
-  /*
-   * Protocol Configuration Options IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_PCO, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_pco_ie_get, &create_session_request_p->pco);
-  DevAssert (NW_OK == rc);
+static nw_gtpv2c_msg_parser_desc_t             s11_sgw_delete_session_request_parser;
 
+//------------------------------------------------------------------------------
+int
+s11_sgw_session_manager_init (void)
+{
+  if ((NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_bearer_context_to_be_created_parser, 0, s11_sgw_bearer_context_to_be_created_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_create_session_request_parser, NW_GTP_CREATE_SESSION_REQ, s11_sgw_create_session_request_ies)) ||
+      (NW_OK != NW_GTPV2C_MSG_PARSER_DESC_INIT (&s11_sgw_delete_session_request_parser, NW_GTP_DELETE_SESSION_REQ, s11_sgw_delete_session_request_ies))) {
+    OAILOG_ERROR (LOG_S11, "Failed to initialize S11 S-GW session management message parsers\n");
+    return RETURNerror;
+  }
+  return RETURNok;
+}
 
-  /*TODO rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ONE, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           s11_bearer_context_to_be_removed_ie_get, &create_session_request_p->bearer_contexts_to_be_removed);
-  DevAssert (NW_OK == rc);*/
+//------------------------------------------------------------------------------
+int
+s11_sgw_handle_create_session_request (
+  nw_gtpv2c_stack_handle_t * stack_p,
+  nw_gtpv2c_ulp_api_t * pUlpApi)
+{
+  nw_rc_t                                   rc = NW_OK;
+  uint8_t                                 offendingIeType,
+                                          offendingIeInstance;
+  uint16_t                                offendingIeLength;
+  itti_s11_create_session_request_t      *create_session_request_p;
+  MessageDef                             *message_p;
 
-  /*
-   * AMBR IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_AMBR, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-           gtpv2c_ambr_ie_get, &create_session_request_p->ambr);
-  DevAssert (NW_OK == rc);
-  /*
-   * Recovery IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_RECOVERY, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_MANDATORY,
-		  s11_ie_indication_generic, NULL);
-  DevAssert (NW_OK == rc);
+  DevAssert (stack_p );
+  message_p = itti_alloc_new_message (TASK_S11, S11_CREATE_SESSION_REQUEST);
+  create_session_request_p = &message_p->ittiMsg.s11_create_session_request;
   create_session_request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   create_session_request_p->trxn = (void *)pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
   create_session_request_p->peer_ip = pUlpApi->u_api_info.initialReqIndInfo.peerIp;
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  /*
+   * Run the parser
+   */
+  rc = nwGtpv2cMsgParserDescRun (&s11_sgw_create_session_request_parser, (pUlpApi->hMsg), create_session_request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     gtpv2c_cause_t                             cause;
@@ -228,15 +219,11 @@ s11_sgw_handle_create_session_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return RETURNok;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
@@ -244,19 +231,18 @@ s11_sgw_handle_create_session_request (
 
 //------------------------------------------------------------------------------
 int
-s11_sgw_handle_create_session_response (
+s11_sgw_create_local_tunnel (
   nw_gtpv2c_stack_handle_t * stack_p,
   itti_s11_create_session_response_t * create_session_response_p)
 {
   nw_rc_t                                   rc;
   nw_gtpv2c_ulp_api_t                         ulp_req;
-  nw_gtpv2c_trxn_handle_t                     trxn;
-  gtpv2c_cause_t                             cause;
 
   DevAssert (create_session_response_p );
   DevAssert (stack_p );
-  trxn = (nw_gtpv2c_trxn_handle_t) create_session_response_p->trxn;
-  DevAssert (trxn );
+  if (HASH_TABLE_OK == hashtable_ts_is_key_exists (s11_sgw_teid_2_gtv2c_teid_handle, (hash_key_t) create_session_response_p->s11_sgw_fteid.teid)) {
+    return RETURNok;
+  }
   /*
    * Create a tunnel for the GTPv2-C stack
    */
@@ -267,8 +253,6 @@ s11_sgw_handle_create_session_response (
   rc = nwGtpv2cProcessUlpReq (*stack_p, &ulp_req);
   DevAssert (NW_OK == rc);
 
-
-
   hashtable_rc_t hash_rc = hashtable_ts_insert(s11_sgw_teid_2_gtv2c_teid_handle,
       (hash_key_t) create_session_response_p->s11_sgw_fteid.teid,
       (void *)ulp_req.u_api_info.createLocalTunnelInfo.hTunnel);
@@ -278,6 +262,24 @@ s11_sgw_handle_create_session_response (
         create_session_response_p->s11_sgw_fteid.teid);
     return RETURNerror;
   }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int
+s11_sgw_handle_create_session_response (
+  nw_gtpv2c_stack_handle_t * stack_p,
+  itti_s11_create_session_response_t * create_session_response_p)
+{
+  nw_rc_t                                   rc;
+  nw_gtpv2c_ulp_api_t                         ulp_req;
+  nw_gtpv2c_trxn_handle_t                     trxn;
+  gtpv2c_cause_t                             cause;
+
+  DevAssert (create_session_response_p );
+  DevAssert (stack_p );
+  trxn = (nw_gtpv2c_trxn_handle_t) create_session_response_p->trxn;
+  DevAssert (trxn );
   /*
    * Prepare a create session response to send to MME.
    */
@@ -335,42 +337,17 @@ s11_sgw_handle_delete_session_request (
   uint16_t                                offendingIeLength;
   itti_s11_delete_session_request_t      *delete_session_request_p;
   MessageDef                             *message_p;
-  nw_gtpv2c_msg_parser_t                     *pMsgParser;
 
   DevAssert (stack_p );
   message_p = itti_alloc_new_message (TASK_S11, S11_DELETE_SESSION_REQUEST);
   delete_session_request_p = &message_p->ittiMsg.s11_delete_session_request;
-  /*
-   * Create a new message parser
-   */
-  rc = nwGtpv2cMsgParserNew (*stack_p, NW_GTP_DELETE_SESSION_REQ, s11_ie_indication_generic, NULL, &pMsgParser);
-  DevAssert (NW_OK == rc);
-  /*
-   * MME FTEID for CP IE
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_FTEID, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
-      gtpv2c_fteid_ie_get, &delete_session_request_p->sender_fteid_for_cp);
-  DevAssert (NW_OK == rc);
-  /*
-   * Linked EPS Bearer Id IE
-   * * * * This information element shall not be present for TAU/RAU/Handover with
-   * * * * S-GW relocation procedures.
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_EBI, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_OPTIONAL,
-      gtpv2c_ebi_ie_get, &delete_session_request_p->lbi);
-  DevAssert (NW_OK == rc);
-  /*
-   * Indication Flags IE
-   * * * * For a Delete Session Request on S11 interface,
-   * * * * only the Operation Indication flag might be present.
-   */
-  rc = nwGtpv2cMsgParserAddIe (pMsgParser, NW_GTPV2C_IE_INDICATION, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IE_PRESENCE_CONDITIONAL,
-      gtpv2c_indication_flags_ie_get, &delete_session_request_p->indication_flags);
-  DevAssert (NW_OK == rc);
   delete_session_request_p->teid = nwGtpv2cMsgGetTeid (pUlpApi->hMsg);
   delete_session_request_p->trxn = (void *)pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
   delete_session_request_p->peer_ip = pUlpApi->u_api_info.initialReqIndInfo.peerIp;
-  rc = nwGtpv2cMsgParserRun (pMsgParser, pUlpApi->hMsg, &offendingIeType, &offendingIeInstance, &offendingIeLength);
+  /*
+   * Run the parser
+   */
+  rc = nwGtpv2cMsgParserDescRun (&s11_sgw_delete_session_request_parser, (pUlpApi->hMsg), delete_session_request_p, &offendingIeType, &offendingIeInstance, &offendingIeLength);
 
   if (rc != NW_OK) {
     nw_gtpv2c_ulp_api_t                         ulp_req;
@@ -408,15 +385,11 @@ s11_sgw_handle_delete_session_request (
     DevAssert (NW_OK == rc);
     itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
     message_p = NULL;
-    rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-    DevAssert (NW_OK == rc);
     rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
     DevAssert (NW_OK == rc);
     return NW_OK;
   }
 
-  rc = nwGtpv2cMsgParserDelete (*stack_p, pMsgParser);
-  DevAssert (NW_OK == rc);
   rc = nwGtpv2cMsgDelete (*stack_p, (pUlpApi->hMsg));
   DevAssert (NW_OK == rc);
   return itti_send_msg_to_task (TASK_SPGW_APP, INSTANCE_DEFAULT, message_p);
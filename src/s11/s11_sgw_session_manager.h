@@ -29,10 +29,20 @@
 #ifndef FILE_S11_SGW_SESSION_MANAGER_SEEN
 #define FILE_S11_SGW_SESSION_MANAGER_SEEN
 
+int s11_sgw_session_manager_init(void);
+
 int s11_sgw_handle_create_session_request(
   nw_gtpv2c_stack_handle_t *stack_p,
   nw_gtpv2c_ulp_api_t      *pUlpApi);
 
+/*
+ * Create the GTPv2-C local tunnel of the S-GW S11 TEID of a session, on the stack that receives the
+ * requests for this TEID. Without it the stack discards every later request of the MME on the session.
+ */
+int s11_sgw_create_local_tunnel(
+  nw_gtpv2c_stack_handle_t     *stack_p,
+  itti_s11_create_session_response_t *create_session_response_p);
+
 int s11_sgw_handle_create_session_response(
   nw_gtpv2c_stack_handle_t     *stack_p,
   itti_s11_create_session_response_t *create_session_response_p);
@@ -0,0 +1,602 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s11_shard.c
+  \brief S11 GTPv2-C stacks sharded over worker threads.
+*/
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+
+#include "bstrlib.h"
+#include "liblfds710.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "itti_free_defined_msg.h"
+#include "timer.h"
+#include "NwLog.h"
+#include "NwGtpv2c.h"
+#include "s11_shard.h"
+
+#ifndef SO_ATTACH_REUSEPORT_CBPF
+#  define SO_ATTACH_REUSEPORT_CBPF 51
+#endif
+
+typedef struct s11_shard_s {
+  uint32_t                                index;
+  nw_gtpv2c_stack_handle_t                stack_handle;
+  int                                     sd;
+  int                                     event_fd;
+  int                                     epoll_fd;
+  pthread_t                               thread;
+  bool                                    is_running;
+  s11_shard_message_handler_t             message_handler;
+  struct lfds710_queue_bmm_state          message_queue __attribute__((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
+  struct lfds710_queue_bmm_element       *qbmme;
+  struct mmsghdr                          rx_msgs[S11_SHARD_RX_BATCH_MAX];
+  struct iovec                            rx_iovs[S11_SHARD_RX_BATCH_MAX];
+  struct sockaddr_in                      rx_peer_addrs[S11_SHARD_RX_BATCH_MAX];
+  uint8_t                                 rx_buffers[S11_SHARD_RX_BATCH_MAX][S11_SHARD_RX_BUFFER_SIZE];
+  // Datagrams written while a burst of messages or datagrams is processed are sent at its end
+  bool                                    tx_deferred;
+  uint32_t                                nb_tx;
+  struct mmsghdr                          tx_msgs[S11_SHARD_TX_BATCH_MAX];
+  struct iovec                            tx_iovs[S11_SHARD_TX_BATCH_MAX];
+  struct sockaddr_in                      tx_peer_addrs[S11_SHARD_TX_BATCH_MAX];
+  uint8_t                                 tx_buffers[S11_SHARD_TX_BATCH_MAX][S11_SHARD_TX_BUFFER_SIZE];
+  // Written by the TASK_S11 thread only
+  uint32_t                                nb_posted __attribute__((aligned (LFDS710_PAL_ATOMIC_ISOLATION_IN_BYTES)));
+} s11_shard_t;
+
+static s11_shard_t                       *s11_shards    = NULL;
+static uint32_t                           s11_nb_shards = 0;
+static uint64_t                           s11_shard_posted_mask = 0;   // shards to wake up, TASK_S11 thread only
+static volatile int                       s11_shard_terminate = 0;
+
+//------------------------------------------------------------------------------
+static nw_rc_t s11_shard_log_wrapper (
+  nw_gtpv2c_log_mgr_handle_t hLogMgr,
+  uint32_t logLevel,
+  char * file,
+  uint32_t line,
+  char * logStr)
+{
+  OAILOG_DEBUG (LOG_S11, "%s\n", logStr);
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static void s11_shard_flush_tx (s11_shard_t * const shard)
+{
+  uint32_t                                nb_sent = 0;
+  int                                     rc;
+
+  while (nb_sent < shard->nb_tx) {
+    rc = sendmmsg (shard->sd, &shard->tx_msgs[nb_sent], shard->nb_tx - nb_sent, 0);
+    if (rc < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Skip the datagram at fault, the GTPv2-C stack retransmits requests
+      OAILOG_ERROR (LOG_S11, "Shard %u: sendmmsg to %s failed: %s\n", shard->index,
+          inet_ntoa (shard->tx_peer_addrs[nb_sent].sin_addr), strerror (errno));
+      rc = 1;
+    }
+    nb_sent += rc;
+  }
+  shard->nb_tx = 0;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t s11_shard_send_udp_msg (
+  nw_gtpv2c_udp_handle_t udpHandle,
+  uint8_t * buffer,
+  uint32_t buffer_len,
+  struct in_addr *peerIpAddr,
+  uint16_t peerPort)
+{
+  s11_shard_t                            *shard = (s11_shard_t *)udpHandle;
+  struct sockaddr_in                      peer_addr = {0};
+  ssize_t                                 bytes_written = 0;
+  uint32_t                                i;
+
+  if ((shard->tx_deferred) && (buffer_len <= S11_SHARD_TX_BUFFER_SIZE)) {
+    // The stack may reuse its buffer as soon as we return
+    i = shard->nb_tx++;
+    memcpy (shard->tx_buffers[i], buffer, buffer_len);
+    shard->tx_iovs[i].iov_base = shard->tx_buffers[i];
+    shard->tx_iovs[i].iov_len = buffer_len;
+    shard->tx_peer_addrs[i].sin_family = AF_INET;
+    shard->tx_peer_addrs[i].sin_port = htons (peerPort);
+    shard->tx_peer_addrs[i].sin_addr.s_addr = peerIpAddr->s_addr;
+    memset (&shard->tx_msgs[i], 0, sizeof (struct mmsghdr));
+    shard->tx_msgs[i].msg_hdr.msg_iov = &shard->tx_iovs[i];
+    shard->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    shard->tx_msgs[i].msg_hdr.msg_name = &shard->tx_peer_addrs[i];
+    shard->tx_msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    if (shard->nb_tx == S11_SHARD_TX_BATCH_MAX) {
+      s11_shard_flush_tx (shard);
+    }
+    return NW_OK;
+  }
+
+  peer_addr.sin_family = AF_INET;
+  peer_addr.sin_port = htons (peerPort);
+  peer_addr.sin_addr.s_addr = peerIpAddr->s_addr;
+
+  do {
+    bytes_written = sendto (shard->sd, buffer, buffer_len, 0, (struct sockaddr *)&peer_addr, sizeof (peer_addr));
+  } while ((bytes_written < 0) && (errno == EINTR));
+
+  if (bytes_written != buffer_len) {
+    OAILOG_ERROR (LOG_S11, "Shard %u: sendto %u bytes to %s:%u failed: %s\n", shard->index, buffer_len,
+        inet_ntoa (*peerIpAddr), peerPort, (bytes_written < 0) ? strerror (errno) : "truncated");
+    return NW_FAILURE;
+  }
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t s11_shard_start_timer_wrapper (
+  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
+  uint32_t timeoutSec,
+  uint32_t timeoutUsec,
+  uint32_t tmrType,
+  void *timeoutArg,
+  nw_gtpv2c_timer_handle_t * hTmr)
+{
+  s11_shard_t                            *shard = (s11_shard_t *)tmrMgrHandle;
+  long                                    timer_id = 0;
+  int                                     ret = 0;
+
+  // The expiry is dispatched by TASK_S11 to the shard given by the message instance
+  ret = timer_setup (timeoutSec, timeoutUsec, TASK_S11, (instance_t)shard->index,
+      (tmrType == NW_GTPV2C_TMR_TYPE_REPETITIVE) ? TIMER_PERIODIC : TIMER_ONE_SHOT, timeoutArg, &timer_id);
+  *hTmr = (nw_gtpv2c_timer_handle_t) timer_id;
+  return ((ret == 0) ? NW_OK : NW_FAILURE);
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t s11_shard_stop_timer_wrapper (
+  nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle,
+  nw_gtpv2c_timer_handle_t tmrHandle)
+{
+  long                                    timer_id = (long)tmrHandle;
+
+  return ((timer_remove (timer_id, NULL) == 0) ? NW_OK : NW_FAILURE);
+}
+
+//------------------------------------------------------------------------------
+static void s11_shard_process_messages (s11_shard_t * const shard)
+{
+  MessageDef                             *received_message_p = NULL;
+
+  shard->tx_deferred = true;
+  while (lfds710_queue_bmm_dequeue (&shard->message_queue, NULL, (void **)&received_message_p)) {
+    shard->message_handler (&shard->stack_handle, received_message_p);
+    itti_free_msg_content (received_message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+    received_message_p = NULL;
+  }
+  shard->tx_deferred = false;
+  s11_shard_flush_tx (shard);
+}
+
+//------------------------------------------------------------------------------
+static void s11_shard_process_datagrams (s11_shard_t * const shard)
+{
+  int                                     nb_received;
+  int                                     i;
+
+  // Responses to a batch of requests go out with one sendmmsg
+  shard->tx_deferred = true;
+  do {
+    for (i = 0; i < S11_SHARD_RX_BATCH_MAX; i++) {
+      shard->rx_iovs[i].iov_base = shard->rx_buffers[i];
+      shard->rx_iovs[i].iov_len = S11_SHARD_RX_BUFFER_SIZE;
+      memset (&shard->rx_msgs[i], 0, sizeof (struct mmsghdr));
+      shard->rx_msgs[i].msg_hdr.msg_iov = &shard->rx_iovs[i];
+      shard->rx_msgs[i].msg_hdr.msg_iovlen = 1;
+      shard->rx_msgs[i].msg_hdr.msg_name = &shard->rx_peer_addrs[i];
+      shard->rx_msgs[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    }
+    nb_received = recvmmsg (shard->sd, shard->rx_msgs, S11_SHARD_RX_BATCH_MAX, 0, NULL);
+    if (nb_received < 0) {
+      // Level triggered epoll: an interrupted read is retried on the next wake up
+      if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+        OAILOG_ERROR (LOG_S11, "Shard %u: recvmmsg failed: %s\n", shard->index, strerror (errno));
+      }
+      break;
+    }
+    for (i = 0; i < nb_received; i++) {
+      if (shard->rx_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+        OAILOG_WARNING (LOG_S11, "Shard %u: dropping truncated datagram from %s\n", shard->index, inet_ntoa (shard->rx_peer_addrs[i].sin_addr));
+        continue;
+      }
+      if (nwGtpv2cProcessUdpReq (shard->stack_handle, shard->rx_buffers[i], shard->rx_msgs[i].msg_len,
+            ntohs (shard->rx_peer_addrs[i].sin_port), &shard->rx_peer_addrs[i].sin_addr) != NW_OK) {
+        OAILOG_WARNING (LOG_S11, "Shard %u: failed to process %u bytes from %s\n", shard->index, shard->rx_msgs[i].msg_len,
+            inet_ntoa (shard->rx_peer_addrs[i].sin_addr));
+      }
+    }
+    // A full batch means more datagrams may be waiting
+  } while (nb_received == S11_SHARD_RX_BATCH_MAX);
+  shard->tx_deferred = false;
+  s11_shard_flush_tx (shard);
+}
+
+//------------------------------------------------------------------------------
+static void *s11_shard_thread (void *args)
+{
+  s11_shard_t                            *shard = (s11_shard_t *)args;
+  struct epoll_event                      events[2];
+  eventfd_t                               sem_counter;
+  int                                     nb_events;
+  int                                     i;
+
+  LFDS710_MISC_MAKE_VALID_ON_CURRENT_LOGICAL_CORE_INITS_COMPLETED_BEFORE_NOW_ON_ANY_OTHER_LOGICAL_CORE;
+  OAILOG_DEBUG (LOG_S11, "Shard %u started\n", shard->index);
+
+  while (!__atomic_load_n (&s11_shard_terminate, __ATOMIC_ACQUIRE)) {
+    nb_events = epoll_wait (shard->epoll_fd, events, 2, -1);
+    if (nb_events < 0) {
+      AssertFatal (errno == EINTR, "Shard %u: epoll_wait failed: %s\n", shard->index, strerror (errno));
+      continue;
+    }
+    for (i = 0; i < nb_events; i++) {
+      if (events[i].data.fd == shard->event_fd) {
+        if (read (shard->event_fd, &sem_counter, sizeof (sem_counter)) == sizeof (sem_counter)) {
+          s11_shard_process_messages (shard);
+        }
+      } else if (events[i].data.fd == shard->sd) {
+        s11_shard_process_datagrams (shard);
+      }
+    }
+  }
+  OAILOG_DEBUG (LOG_S11, "Shard %u stopped\n", shard->index);
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int s11_shard_attach_steering (const int sd, const uint32_t nb_shards)
+{
+  /*
+   * Classic BPF run by the kernel on the UDP payload of each datagram, returns the index of the
+   * socket (bind order) in the SO_REUSEPORT group:
+   *   TEID % nb_shards if the T flag is set and the TEID is not 0, else sequence number % nb_shards.
+   */
+  struct sock_filter                      code[] = {
+    BPF_STMT (BPF_LD  | BPF_B   | BPF_ABS, 0),            // 0: A = flags
+    BPF_JUMP (BPF_JMP | BPF_JSET | BPF_K, 0x08, 0, 4),    // 1: no TEID -> 6
+    BPF_STMT (BPF_LD  | BPF_W   | BPF_ABS, 4),            // 2: A = TEID
+    BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 4),        // 3: TEID != 0 -> 8
+    BPF_STMT (BPF_LD  | BPF_W   | BPF_ABS, 8),            // 4: A = sequence number, spare
+    BPF_STMT (BPF_JMP | BPF_JA, 1),                       // 5: -> 7
+    BPF_STMT (BPF_LD  | BPF_W   | BPF_ABS, 4),            // 6: A = sequence number, spare
+    BPF_STMT (BPF_ALU | BPF_RSH | BPF_K, 8),              // 7: A = sequence number
+    BPF_STMT (BPF_ALU | BPF_MOD | BPF_K, nb_shards),      // 8
+    BPF_STMT (BPF_RET | BPF_A, 0),                        // 9
+  };
+  struct sock_fprog                       prog = {
+    .len = sizeof (code) / sizeof (code[0]),
+    .filter = code,
+  };
+
+  return setsockopt (sd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof (prog));
+}
+
+//------------------------------------------------------------------------------
+static int s11_shard_create_socket (
+  s11_shard_t * const shard,
+  const struct in_addr * const address,
+  const uint16_t port,
+  const bool reuse_port)
+{
+  struct sockaddr_in                      addr = {0};
+  int                                     one = 1;
+
+  shard->sd = socket (AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+  if (shard->sd < 0) {
+    OAILOG_ERROR (LOG_S11, "Shard %u: socket failed: %s\n", shard->index, strerror (errno));
+    return RETURNerror;
+  }
+  if (reuse_port && (setsockopt (shard->sd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof (one)) < 0)) {
+    OAILOG_ERROR (LOG_S11, "Shard %u: SO_REUSEPORT failed: %s\n", shard->index, strerror (errno));
+    return RETURNerror;
+  }
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons (port);
+  addr.sin_addr.s_addr = address->s_addr;
+  if (bind (shard->sd, (struct sockaddr *)&addr, sizeof (addr)) < 0) {
+    OAILOG_ERROR (LOG_S11, "Shard %u: bind to %s:%u failed: %s\n", shard->index, inet_ntoa (*address), port, strerror (errno));
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static int s11_shard_create_stack (
+  s11_shard_t * const shard,
+  nw_rc_t (*ulp_callback)(nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t *pUlpApi))
+{
+  nw_gtpv2c_ulp_entity_t                  ulp;
+  nw_gtpv2c_udp_entity_t                  udp;
+  nw_gtpv2c_timer_mgr_entity_t            tmrMgr;
+  nw_gtpv2c_log_mgr_entity_t              logMgr;
+  nw_gtpv2c_stack_config_t                config;
+
+  if (nwGtpv2cInitialize (&shard->stack_handle) != NW_OK) {
+    OAILOG_ERROR (LOG_S11, "Shard %u: failed to initialize gtpv2-c stack\n", shard->index);
+    return RETURNerror;
+  }
+  ulp.hUlp = (nw_gtpv2c_ulp_handle_t) &shard->stack_handle;
+  ulp.ulpReqCallback = ulp_callback;
+  DevAssert (NW_OK == nwGtpv2cSetUlpEntity (shard->stack_handle, &ulp));
+  udp.hUdp = (nw_gtpv2c_udp_handle_t) shard;
+  udp.udpDataReqCallback = s11_shard_send_udp_msg;
+  DevAssert (NW_OK == nwGtpv2cSetUdpEntity (shard->stack_handle, &udp));
+  tmrMgr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t) shard;
+  tmrMgr.tmrStartCallback = s11_shard_start_timer_wrapper;
+  tmrMgr.tmrStopCallback = s11_shard_stop_timer_wrapper;
+  DevAssert (NW_OK == nwGtpv2cSetTimerMgrEntity (shard->stack_handle, &tmrMgr));
+  logMgr.logMgrHandle = 0;
+  logMgr.logReqCallback = s11_shard_log_wrapper;
+  DevAssert (NW_OK == nwGtpv2cSetLogMgrEntity (shard->stack_handle, &logMgr));
+  DevAssert (NW_OK == nwGtpv2cSetLogLevel (shard->stack_handle, NW_LOG_LEVEL_DEBG));
+  // Responses to locally initiated requests without TEID are steered by sequence number
+  config.seqNumStart = shard->index;
+  config.seqNumStep = s11_nb_shards;
+  DevAssert (NW_OK == nwGtpv2cConfigSet (&shard->stack_handle, &config));
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int s11_shard_init (
+  const uint32_t nb_shards,
+  const struct in_addr * const address,
+  const uint16_t port,
+  nw_rc_t (*ulp_callback)(nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t *pUlpApi),
+  s11_shard_message_handler_t handler)
+{
+  struct epoll_event                      event = {0};
+  uint32_t                                i;
+
+  DevAssert (nb_shards > 0);
+  DevAssert (!s11_shards);
+  s11_nb_shards = nb_shards;
+  if (s11_nb_shards > S11_SHARD_MAX) {
+    OAILOG_WARNING (LOG_S11, "Reducing S11 threads from %u to %u\n", s11_nb_shards, S11_SHARD_MAX);
+    s11_nb_shards = S11_SHARD_MAX;
+  }
+  s11_shards = calloc (s11_nb_shards, sizeof (s11_shard_t));
+  if (!s11_shards) {
+    return RETURNerror;
+  }
+  for (i = 0; i < s11_nb_shards; i++) {
+    s11_shards[i].sd = -1;
+    s11_shards[i].event_fd = -1;
+    s11_shards[i].epoll_fd = -1;
+  }
+  __atomic_store_n (&s11_shard_terminate, 0, __ATOMIC_RELEASE);
+  s11_shard_posted_mask = 0;
+
+  // Sockets first, the number of shards is known once the steering program is attached
+  for (i = 0; i < s11_nb_shards; i++) {
+    s11_shards[i].index = i;
+    if (s11_shard_create_socket (&s11_shards[i], address, port, (s11_nb_shards > 1)) != RETURNok) {
+      goto fail;
+    }
+    if ((i == 0) && (s11_nb_shards > 1) && (s11_shard_attach_steering (s11_shards[0].sd, s11_nb_shards) < 0)) {
+      OAILOG_WARNING (LOG_S11, "Cannot steer S11 datagrams to %u threads (%s), using 1 thread\n", s11_nb_shards, strerror (errno));
+      s11_nb_shards = 1;
+    }
+  }
+
+  for (i = 0; i < s11_nb_shards; i++) {
+    s11_shard_t                          *shard = &s11_shards[i];
+
+    if (s11_shard_create_stack (shard, ulp_callback) != RETURNok) {
+      goto fail;
+    }
+    shard->message_handler = handler;
+    shard->qbmme = calloc (S11_SHARD_QUEUE_SIZE, sizeof (struct lfds710_queue_bmm_element));
+    if (!shard->qbmme) {
+      goto fail;
+    }
+    lfds710_queue_bmm_init_valid_on_current_logical_core (&shard->message_queue, shard->qbmme, S11_SHARD_QUEUE_SIZE, NULL);
+    shard->event_fd = eventfd (0, EFD_CLOEXEC);
+    shard->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+    if ((shard->event_fd < 0) || (shard->epoll_fd < 0)) {
+      OAILOG_ERROR (LOG_S11, "Shard %u: eventfd/epoll failed: %s\n", i, strerror (errno));
+      goto fail;
+    }
+    event.events = EPOLLIN;
+    event.data.fd = shard->event_fd;
+    AssertFatal (epoll_ctl (shard->epoll_fd, EPOLL_CTL_ADD, shard->event_fd, &event) == 0, "epoll_ctl failed: %s\n", strerror (errno));
+    event.data.fd = shard->sd;
+    AssertFatal (epoll_ctl (shard->epoll_fd, EPOLL_CTL_ADD, shard->sd, &event) == 0, "epoll_ctl failed: %s\n", strerror (errno));
+  }
+
+  for (i = 0; i < s11_nb_shards; i++) {
+    if (pthread_create (&s11_shards[i].thread, NULL, s11_shard_thread, &s11_shards[i]) != 0) {
+      OAILOG_ERROR (LOG_S11, "Shard %u: pthread_create failed\n", i);
+      goto fail;
+    }
+    s11_shards[i].is_running = true;
+    char name[16];
+    snprintf (name, sizeof (name), "S11_%u", i);
+    pthread_setname_np (s11_shards[i].thread, name);
+  }
+  OAILOG_INFO (LOG_S11, "S11 listening on %s:%u with %u GTPv2-C stack(s)\n", inet_ntoa (*address), port, s11_nb_shards);
+  return RETURNok;
+
+fail:
+  s11_shard_exit ();
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+static void s11_shard_queue_cleanup (struct lfds710_queue_bmm_state *qbmms, void *key, void *value)
+{
+  MessageDef                             *message_p = (MessageDef *)value;
+
+  if (message_p) {
+    itti_free_msg_content (message_p);
+    itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+  }
+}
+
+//------------------------------------------------------------------------------
+void s11_shard_exit (void)
+{
+  eventfd_t                               sem_counter = 1;
+  uint32_t                                i;
+
+  if (!s11_shards) {
+    return;
+  }
+  __atomic_store_n (&s11_shard_terminate, 1, __ATOMIC_RELEASE);
+  for (i = 0; i < s11_nb_shards; i++) {
+    if (s11_shards[i].is_running) {
+      if (write (s11_shards[i].event_fd, &sem_counter, sizeof (sem_counter)) != sizeof (sem_counter)) {
+        OAILOG_ERROR (LOG_S11, "Shard %u: cannot wake up thread: %s\n", i, strerror (errno));
+      }
+    }
+  }
+  for (i = 0; i < s11_nb_shards; i++) {
+    s11_shard_t                          *shard = &s11_shards[i];
+
+    if (shard->is_running) {
+      pthread_join (shard->thread, NULL);
+    }
+    if (shard->qbmme) {
+      lfds710_queue_bmm_cleanup (&shard->message_queue, s11_shard_queue_cleanup);
+      free_wrapper ((void**)&shard->qbmme);
+    }
+    if ((shard->stack_handle) && (nwGtpv2cFinalize (shard->stack_handle) != NW_OK)) {
+      OAI_FPRINTF_ERR ("An error occurred during tear down of nwGtp s11 stack %u.\n", i);
+    }
+    if (shard->epoll_fd >= 0) close (shard->epoll_fd);
+    if (shard->event_fd >= 0) close (shard->event_fd);
+    if (shard->sd >= 0) close (shard->sd);
+  }
+  free_wrapper ((void**)&s11_shards);
+  s11_nb_shards = 0;
+  s11_shard_posted_mask = 0;
+}
+
+//------------------------------------------------------------------------------
+uint32_t s11_shard_count (void)
+{
+  return s11_nb_shards;
+}
+
+//------------------------------------------------------------------------------
+uint32_t s11_shard_from_teid (const teid_t teid)
+{
+  return teid % s11_nb_shards;
+}
+
+//------------------------------------------------------------------------------
+uint32_t s11_shard_from_trxn (const void * const trxn)
+{
+  nw_gtpv2c_stack_handle_t                stack_handle;
+  uint32_t                                i;
+
+  if ((trxn) && (s11_nb_shards > 1)) {
+    stack_handle = nwGtpv2cTrxnGetStackHandle ((nw_gtpv2c_trxn_handle_t)trxn);
+    for (i = 0; i < s11_nb_shards; i++) {
+      if (s11_shards[i].stack_handle == stack_handle) {
+        return i;
+      }
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void s11_shard_wakeup (s11_shard_t * const shard)
+{
+  eventfd_t                               sem_counter = 1;
+
+  AssertFatal (write (shard->event_fd, &sem_counter, sizeof (sem_counter)) == sizeof (sem_counter),
+      "Write to S11 shard %u event fd failed: %s\n", shard->index, strerror (errno));
+  shard->nb_posted = 0;
+  s11_shard_posted_mask &= ~(UINT64_C(1) << shard->index);
+}
+
+//------------------------------------------------------------------------------
+int s11_shard_send_msg (const uint32_t shard_index, MessageDef * const message_p)
+{
+  s11_shard_t                            *shard = NULL;
+
+  if (shard_index >= s11_nb_shards) {
+    OAILOG_ERROR (LOG_S11, "No S11 shard %u for message %s\n", shard_index, ITTI_MSG_NAME (message_p));
+    goto drop;
+  }
+  shard = &s11_shards[shard_index];
+  if (!lfds710_queue_bmm_enqueue (&shard->message_queue, NULL, message_p)) {
+    OAILOG_ERROR (LOG_S11, "S11 shard %u queue full, dropping message %s\n", shard_index, ITTI_MSG_NAME (message_p));
+    goto drop;
+  }
+  // One eventfd write per burst, a shard is not left idle for more than S11_SHARD_WAKEUP_BATCH messages
+  s11_shard_posted_mask |= (UINT64_C(1) << shard_index);
+  if (++shard->nb_posted >= S11_SHARD_WAKEUP_BATCH) {
+    s11_shard_wakeup (shard);
+  }
+  return RETURNok;
+
+drop:
+  itti_free_msg_content (message_p);
+  itti_free (ITTI_MSG_ORIGIN_ID (message_p), message_p);
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+bool s11_shard_flush_pending (void)
+{
+  return (s11_shard_posted_mask != 0);
+}
+
+//------------------------------------------------------------------------------
+void s11_shard_flush (void)
+{
+  while (s11_shard_posted_mask) {
+    s11_shard_wakeup (&s11_shards[__builtin_ctzll (s11_shard_posted_mask)]);
+  }
+}
@@ -0,0 +1,104 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s11_shard.h
+  \brief S11 GTPv2-C stacks sharded over worker threads.
+  Each shard owns a GTPv2-C stack, a thread and a UDP socket bound to the S11 address and port
+  (SO_REUSEPORT). The kernel steers an incoming datagram to shard (TEID % nb shards), or
+  (sequence number % nb shards) when the header TEID is absent or zero; locally initiated
+  transactions of shard i use sequence numbers equal to i modulo nb shards so that responses
+  come back to the shard owning the transaction.
+  TASK_S11 only dispatches ITTI messages to the shards, see s11_shard_send_msg(). A shard is woken
+  up once per burst of messages and sends the datagrams produced by a burst with one sendmmsg.
+*/
+#ifndef FILE_S11_SHARD_SEEN
+#define FILE_S11_SHARD_SEEN
+
+#define S11_SHARD_MAX                 64    /*!< \brief Maximum number of shards */
+#define S11_SHARD_QUEUE_SIZE        4096    /*!< \brief ITTI messages waiting per shard, power of 2 */
+#define S11_SHARD_RX_BUFFER_SIZE    4096    /*!< \brief Largest GTPv2-C datagram received */
+#define S11_SHARD_RX_BATCH_MAX        32    /*!< \brief Datagrams read by one recvmmsg */
+#define S11_SHARD_TX_BATCH_MAX        32    /*!< \brief Datagrams written by one sendmmsg */
+#define S11_SHARD_TX_BUFFER_SIZE    1024    /*!< \brief Largest GTPv2-C datagram sent (NW_GTPV2C_MAX_MSG_LEN) */
+#define S11_SHARD_WAKEUP_BATCH        32    /*!< \brief Messages queued to a shard before it is woken up without s11_shard_flush() */
+
+/*
+ * Handler of the ITTI messages dispatched to a shard, called on the shard thread with the shard stack.
+ * The message is freed by the caller.
+ */
+typedef void (*s11_shard_message_handler_t)(nw_gtpv2c_stack_handle_t * const stack_p, MessageDef * const received_message_p);
+
+/*
+ * Create the shards, their stacks, sockets and threads.
+ * The ULP callback of each stack is called with hUlp pointing to the nw_gtpv2c_stack_handle_t of the shard.
+ *
+ * @param nb_shards    Requested number of shards, reduced to 1 if the kernel cannot steer datagrams.
+ * @param address      Local S11 address.
+ * @param port         Local S11 UDP port.
+ * @param ulp_callback ULP entity callback of the stacks.
+ * @param handler      Handler of the messages sent with s11_shard_send_msg().
+ * @return RETURNok or RETURNerror.
+ */
+int s11_shard_init(
+  const uint32_t nb_shards,
+  const struct in_addr * const address,
+  const uint16_t port,
+  nw_rc_t (*ulp_callback)(nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t *pUlpApi),
+  s11_shard_message_handler_t handler);
+
+/*
+ * Stop the shard threads, free the pending messages and release the stacks and sockets.
+ * Must be called from the thread that called s11_shard_init().
+ */
+void s11_shard_exit(void);
+
+uint32_t s11_shard_count(void);
+
+/*
+ * Shard owning the local tunnel with this TEID, same function as the kernel steering.
+ */
+uint32_t s11_shard_from_teid(const teid_t teid);
+
+/*
+ * Shard owning the GTPv2-C transaction (shard 0 if unknown).
+ */
+uint32_t s11_shard_from_trxn(const void * const trxn);
+
+/*
+ * Give a message to the handler of a shard, the message is freed by this call in any case.
+ * Must be called from the TASK_S11 thread. The shard is only woken up every S11_SHARD_WAKEUP_BATCH
+ * messages, the caller must call s11_shard_flush() before it waits for its next ITTI message.
+ *
+ * @return RETURNok, or RETURNerror if the shard queue is full or the shard does not exist.
+ */
+int s11_shard_send_msg(const uint32_t shard_index, MessageDef * const message_p);
+
+/*
+ * True if messages were given to a shard that has not been woken up since.
+ */
+bool s11_shard_flush_pending(void);
+
+/*
+ * Wake up the shards having messages queued by s11_shard_send_msg().
+ */
+void s11_shard_flush(void);
+
+#endif /* FILE_S11_SHARD_SEEN */
@@ -39,6 +39,7 @@
 #include "msc.h"
 #include "conversions.h"
 #include "intertask_interface.h"
+#include "itti_trace.h"
 #include "asn1_conversions.h"
 #include "s1ap_common.h"
 #include "s1ap_ies_defs.h"
@@ -279,6 +280,9 @@ s1ap_mme_handle_uplink_nas_transport (
                       (enb_ue_s1ap_id_t)uplinkNASTransport_p->eNB_UE_S1AP_ID,
                       uplinkNASTransport_p->nas_pdu.size);
 
+  if (INVALID_MME_UE_S1AP_ID != ue_ref->mme_ue_s1ap_id) {
+    itti_trace_set_ue_id (ue_ref->mme_ue_s1ap_id);
+  }
   bstring b = blk2bstr(uplinkNASTransport_p->nas_pdu.buf, uplinkNASTransport_p->nas_pdu.size);
   s1ap_mme_itti_nas_uplink_ind (uplinkNASTransport_p->mme_ue_s1ap_id,
                                 &b,
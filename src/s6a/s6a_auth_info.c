@@ -177,9 +177,13 @@ s6a_parse_authentication_info_avp (
 
     switch (hdr->avp_code) {
     case AVP_CODE_E_UTRAN_VECTOR:{
-      DevAssert (MAX_EPS_AUTH_VECTORS > authentication_info->nb_of_vectors);
-      CHECK_FCT (s6a_parse_e_utran_vector (avp, &authentication_info->eutran_vector[authentication_info->nb_of_vectors]));
-      authentication_info->nb_of_vectors++;
+      // The HSS may return more vectors than requested (29.272 5.2.3.1.3), keep what fits
+      if (MAX_EPS_AUTH_VECTORS > authentication_info->nb_of_vectors) {
+        CHECK_FCT (s6a_parse_e_utran_vector (avp, &authentication_info->eutran_vector[authentication_info->nb_of_vectors]));
+        authentication_info->nb_of_vectors++;
+      } else {
+        OAILOG_WARNING (LOG_S6A, "Ignoring E-UTRAN-Vector in excess of %d\n", MAX_EPS_AUTH_VECTORS);
+      }
       }
       break;
 
@@ -218,6 +222,12 @@ s6a_aia_cb (
 
   DevAssert (msg );
   ans = *msg;
+  if (RETURNok != s6a_fd_answer_received (ans)) {
+    /*
+     * Timed out, NAS already got a failure for this request
+     */
+    return RETURNok;
+  }
   /*
    * Retrieve the original query associated with the asnwer
    */
@@ -310,7 +320,7 @@ s6a_generate_authentication_info_req (
   /*
    * Create the new update location request message
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, 0, &msg));
+  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_air, MSGFL_ALLOC_ETEID, &msg));
   /*
    * Create a new session
    */
@@ -339,20 +349,8 @@ s6a_generate_authentication_info_req (
   CHECK_FCT (fd_msg_add_origin (msg, 0));
   mme_config_read_lock (&mme_config);
   /*
-   * Destination Host
+   * Destination Host is added once the HSS is chosen, see s6a_fd_send_request()
    */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
-    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
-    bdestroy_wrapper (&host);
-  }
   /*
    * Destination_Realm
    */
@@ -426,6 +424,6 @@ s6a_generate_authentication_info_req (
 
     CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
   }
-  CHECK_FCT (fd_msg_send (&msg, NULL, NULL));
+  CHECK_FCT (s6a_fd_send_request (&msg, S6A_PIPELINE_AIR, air_p->imsi));
   return RETURNok;
 }
@@ -37,6 +37,7 @@
 
 #include "mme_config.h"
 #include "queue.h"
+#include "s6a_pipeline.h"
 
 
 #define VENDOR_3GPP (10415)
@@ -180,6 +181,19 @@ int s6a_init(const mme_config_t *mme_config);
 
 int s6a_fd_new_peer(void);
 
+int s6a_fd_pipeline_init(const mme_config_t *mme_config);
+void s6a_fd_pipeline_exit(void);
+void s6a_fd_pipeline_tick(void);
+
+/* Hand a request (AIR, ULR) to the pipeline, that sends it to an HSS. *msg is set to NULL. */
+int s6a_fd_send_request(struct msg **msg, const s6a_pipeline_cmd_t cmd, const char *imsi);
+
+/* Retire the request of an answer, RETURNerror if it is late or unexpected. */
+int s6a_fd_answer_received(struct msg *ans);
+
+/* Count a ULA received after the timeout of its ULR, that is still delivered. */
+void s6a_fd_late_ula_received(void);
+
 void s6a_peer_connected_cb(struct peer_info *info, void *arg);
 
 int s6a_fd_init_dict_objs(void);
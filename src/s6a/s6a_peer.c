@@ -32,24 +32,38 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <pthread.h>
 
 #include "bstrlib.h"
 
 #include "log.h"
+#include "msc.h"
 #include "common_types.h"
 #include "intertask_interface.h"
 #include "common_defs.h"
 #include "s6a_defs.h"
 #include "s6a_messages.h"
+#include "s6a_messages_types.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 #include "mme_config.h"
+#include "mme_app_statistics.h"
 
 #define NB_MAX_TRIES  (8)
 
 extern __pid_t g_pid;
 
+/* Diameter identities of the HSS, index is the pipeline peer */
+static bstring                          s6a_hss_diamid[MME_CONFIG_MAX_HSS] = {NULL};
+static int                              s6a_nb_hss = 0;
+static s6a_pipeline_t                  *s6a_pipeline_p = NULL;
+static bool                             s6a_pipeline_exiting = false;
+// Serializes the statistics export thread with s6a_fd_pipeline_exit()
+static pthread_mutex_t                  s6a_pipeline_dump_lock = PTHREAD_MUTEX_INITIALIZER;
+// ULAs received after the timeout of their ULR, still given to MME_APP
+static uint64_t                         s6a_late_ulas = 0;
+
 
 void
 s6a_peer_connected_cb (
@@ -92,6 +106,29 @@ s6a_peer_connected_cb (
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Forward the state of the HSS peers to the pipeline, return the number of open peers
+static int s6a_fd_refresh_peers (int * const tc_timer)
+{
+  struct peer_hdr                        *peer = NULL;
+  int                                     nb_open = 0;
+
+  for (int i = 0; i < s6a_nb_hss; i++) {
+    bool                                  is_open = false;
+
+    peer = NULL;
+    if ((0 == fd_peer_getbyid (bdata(s6a_hss_diamid[i]), blength (s6a_hss_diamid[i]), 0, &peer)) && (peer)) {
+      if ((tc_timer) && (peer->info.config.pic_tctimer != 0)) {
+        *tc_timer = peer->info.config.pic_tctimer;
+      }
+      is_open = (STATE_OPEN == fd_peer_get_state (peer));
+    }
+    s6a_pipeline_set_peer_state (s6a_pipeline_p, i, is_open);
+    nb_open += (is_open) ? 1 : 0;
+  }
+  return nb_open;
+}
+
 int
 s6a_fd_new_peer (
   void)
@@ -121,79 +158,237 @@ s6a_fd_new_peer (
   fd_g_config->cnf_diamid = strdup (host_name);
   fd_g_config->cnf_diamid_len = strlen (fd_g_config->cnf_diamid);
   OAILOG_DEBUG (LOG_S6A, "Diameter identity of MME: %s with length: %zd\n", fd_g_config->cnf_diamid, fd_g_config->cnf_diamid_len);
-  bstring                                 hss_name = bstrcpy(mme_config.s6a_config.hss_host_name);
-  bconchar(hss_name, '.');
-  bconcat (hss_name, mme_config.realm);
 
   if (mme_config_unlock (&mme_config) ) {
     OAILOG_ERROR (LOG_S6A, "Failed to unlock configuration\n");
     return RETURNerror;
   }
 #if FD_CONF_FILE_NO_CONNECT_PEERS_CONFIGURED
-  info.pi_diamid    = bdata(hss_name);
-  info.pi_diamidlen = blength (hss_name);
-  OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
-  info.config.pic_flags.sec     = PI_SEC_NONE;
-  info.config.pic_flags.pro3    = PI_P3_DEFAULT;
-  info.config.pic_flags.pro4    = PI_P4_TCP;
-  info.config.pic_flags.alg     = PI_ALGPREF_TCP;
-  info.config.pic_flags.exp     = PI_EXP_INACTIVE;
-  info.config.pic_flags.persist = PI_PRST_NONE;
-  info.config.pic_port          = 3868;
-  info.config.pic_lft           = 3600;
-  info.config.pic_tctimer       = 7; // retry time-out connection
-  info.config.pic_twtimer       = 60; // watchdog
-  CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
+  for (int i = 0; i < s6a_nb_hss; i++) {
+    memset (&info, 0, sizeof (info));
+    info.pi_diamid    = bdata(s6a_hss_diamid[i]);
+    info.pi_diamidlen = blength (s6a_hss_diamid[i]);
+    OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS: %s with length: %zd\n", info.pi_diamid, info.pi_diamidlen);
+    info.config.pic_flags.sec     = PI_SEC_NONE;
+    info.config.pic_flags.pro3    = PI_P3_DEFAULT;
+    info.config.pic_flags.pro4    = PI_P4_TCP;
+    info.config.pic_flags.alg     = PI_ALGPREF_TCP;
+    info.config.pic_flags.exp     = PI_EXP_INACTIVE;
+    info.config.pic_flags.persist = PI_PRST_NONE;
+    info.config.pic_port          = 3868;
+    info.config.pic_lft           = 3600;
+    info.config.pic_tctimer       = 7; // retry time-out connection
+    info.config.pic_twtimer       = 60; // watchdog
+    CHECK_FCT (fd_peer_add (&info, "", s6a_peer_connected_cb, NULL));
+  }
 
   return ret;
 #else
-  DiamId_t          diamid    = bdata(hss_name);
-  size_t            diamidlen = blength (hss_name);
-  struct peer_hdr  *peer      = NULL;
   int               nb_tries  = 0;
   int               timeout   = fd_g_config->cnf_timer_tc;
   for (nb_tries = 0; nb_tries < NB_MAX_TRIES; nb_tries++) {
     OAILOG_DEBUG (LOG_S6A, "S6a peer connection attempt %d / %d\n",
                   1 + nb_tries, NB_MAX_TRIES);
-    ret = fd_peer_getbyid( diamid, diamidlen, 0, &peer );
-    if (peer && peer->info.config.pic_tctimer != 0) {
-        timeout = peer->info.config.pic_tctimer;
-    }
-    if (!ret) {
-      if (peer) {
-        ret = fd_peer_get_state(peer);
-        if (STATE_OPEN == ret) {
-          MessageDef                             *message_p;
-
-          OAILOG_DEBUG (LOG_S6A, "Peer %*s is now connected...\n", (int)diamidlen, diamid);
-          /*
-           * Inform S1AP that connection to HSS is established
-           */
-          message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
-          itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
-
-          {
-            FILE *fp = NULL;
-            bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
-            fp = fopen(bdata(filename), "w+");
-            bdestroy(filename);
-            fflush(fp);
-            fclose(fp);
-          }
-          bdestroy_wrapper (&hss_name);
-          return RETURNok;
-        } else {
-          OAILOG_DEBUG (LOG_S6A, "S6a peer state is %d\n", ret);
-        }
+    // The other HSS join the load balancing as soon as they are open, see s6a_fd_pipeline_tick()
+    ret = s6a_fd_refresh_peers (&timeout);
+    if (0 < ret) {
+      MessageDef                             *message_p;
+
+      OAILOG_DEBUG (LOG_S6A, "%d / %d HSS peer(s) now connected...\n", ret, s6a_nb_hss);
+      /*
+       * Inform S1AP that connection to HSS is established
+       */
+      message_p = itti_alloc_new_message (TASK_S6A, ACTIVATE_MESSAGE);
+      itti_send_msg_to_task (TASK_S1AP, INSTANCE_DEFAULT, message_p);
+
+      {
+        FILE *fp = NULL;
+        bstring  filename = bformat("/tmp/mme_%d.status", g_pid);
+        fp = fopen(bdata(filename), "w+");
+        bdestroy(filename);
+        fflush(fp);
+        fclose(fp);
       }
+      return RETURNok;
     } else {
-      OAILOG_DEBUG (LOG_S6A, "Could not get S6a peer\n");
+      OAILOG_DEBUG (LOG_S6A, "No S6a peer open\n");
     }
     sleep(timeout);
   }
-  bdestroy(hss_name);
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
   return RETURNerror;
 #endif
 }
+
+//------------------------------------------------------------------------------
+// Add the Destination-Host of the chosen HSS and hand the request to freeDiameter
+static int s6a_fd_pipeline_send (void *cb_arg, const int peer, void *request)
+{
+  struct msg                             *msg = (struct msg *)request;
+  struct avp                             *realm_avp = NULL;
+  struct avp                             *avp = NULL;
+  union avp_value                         value;
+
+  CHECK_FCT (fd_msg_search_avp (msg, s6a_fd_cnf.dataobj_s6a_destination_realm, &realm_avp));
+  CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp));
+  value.os.data = (unsigned char *)bdata(s6a_hss_diamid[peer]);
+  value.os.len = blength(s6a_hss_diamid[peer]);
+  CHECK_FCT (fd_msg_avp_setvalue (avp, &value));
+  if (realm_avp) {
+    // Destination-Host precedes Destination-Realm
+    CHECK_FCT (fd_msg_avp_add (realm_avp, MSG_BRW_PREV, avp));
+  } else {
+    CHECK_FCT (fd_msg_avp_add (msg, MSG_BRW_LAST_CHILD, avp));
+  }
+  // On failure the message is still ours, it is freed by s6a_fd_pipeline_expire()
+  CHECK_FCT (fd_msg_send (&msg, NULL, NULL));
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// A request will not be answered (timeout, pipeline full or send failure)
+static void s6a_fd_pipeline_expire (void *cb_arg, const s6a_pipeline_cmd_t cmd, const char * const imsi, void *request)
+{
+  if (request) {
+    fd_msg_free ((struct msg *)request);
+  }
+  if (s6a_pipeline_exiting) {
+    return;
+  }
+  if (S6A_PIPELINE_AIR == cmd) {
+    MessageDef                             *message_p = NULL;
+    s6a_auth_info_ans_t                    *s6a_auth_info_ans_p = NULL;
+
+    /*
+     * Same handling as an HSS answering it is too busy
+     */
+    message_p = itti_alloc_new_message (TASK_S6A, S6A_AUTH_INFO_ANS);
+    s6a_auth_info_ans_p = &message_p->ittiMsg.s6a_auth_info_ans;
+    snprintf (s6a_auth_info_ans_p->imsi, sizeof (s6a_auth_info_ans_p->imsi), "%s", imsi);
+    s6a_auth_info_ans_p->imsi_length = strlen (s6a_auth_info_ans_p->imsi);
+    s6a_auth_info_ans_p->result.present = S6A_RESULT_BASE;
+    s6a_auth_info_ans_p->result.choice.base = ER_DIAMETER_TOO_BUSY;
+    MSC_LOG_TX_MESSAGE (MSC_S6A_MME, MSC_NAS_MME, NULL, 0, "0 S6A_AUTH_INFO_ANS imsi %s timeout", imsi);
+    itti_send_msg_to_task (TASK_NAS_MME, INSTANCE_DEFAULT, message_p);
+  } else {
+    /*
+     * MME_APP has no failure path for the Update Location: a late ULA is still delivered (s6a_ula_cb),
+     * otherwise the attach is left to the NAS supervision timers
+     */
+    OAILOG_ERROR (LOG_S6A, "S6a ULR for IMSI %s not answered in time\n", imsi);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void s6a_fd_pipeline_dump (bstring buffer)
+{
+  const char                             *names[S6A_PIPELINE_MAX_PEERS] = {NULL};
+
+  pthread_mutex_lock (&s6a_pipeline_dump_lock);
+  if (s6a_pipeline_p) {
+    for (int i = 0; i < s6a_nb_hss; i++) {
+      names[i] = bdata(s6a_hss_diamid[i]);
+    }
+    s6a_pipeline_dump (s6a_pipeline_p, names, buffer);
+    bformata (buffer, "mme_s6a_late_ulas_total %" PRIu64 "\n", __atomic_load_n (&s6a_late_ulas, __ATOMIC_RELAXED));
+  }
+  pthread_mutex_unlock (&s6a_pipeline_dump_lock);
+}
+
+//------------------------------------------------------------------------------
+int
+s6a_fd_pipeline_init (
+  const mme_config_t * mme_config_p)
+{
+  s6a_pipeline_conf_t                     conf = {0};
+
+  if ((0 >= mme_config_p->s6a_config.nb_hss) || (S6A_PIPELINE_MAX_PEERS < mme_config_p->s6a_config.nb_hss)) {
+    OAILOG_ERROR (LOG_S6A, "Bad number of HSS %d\n", mme_config_p->s6a_config.nb_hss);
+    return RETURNerror;
+  }
+  for (s6a_nb_hss = 0; s6a_nb_hss < mme_config_p->s6a_config.nb_hss; s6a_nb_hss++) {
+    s6a_hss_diamid[s6a_nb_hss] = bstrcpy (mme_config_p->s6a_config.hss_host_name[s6a_nb_hss]);
+    bconchar (s6a_hss_diamid[s6a_nb_hss], '.');
+    bconcat (s6a_hss_diamid[s6a_nb_hss], mme_config_p->realm);
+    OAILOG_DEBUG (LOG_S6A, "Diameter identity of HSS %d: %s\n", s6a_nb_hss, bdata(s6a_hss_diamid[s6a_nb_hss]));
+  }
+  conf.nb_peers = s6a_nb_hss;
+  conf.window = mme_config_p->s6a_config.max_in_flight_per_hss;
+  conf.backlog = mme_config_p->s6a_config.request_backlog;
+  conf.timeout_msec = mme_config_p->s6a_config.request_timeout_ms;
+  conf.tick_msec = S6A_PIPELINE_TICK_MSEC;
+  conf.send = s6a_fd_pipeline_send;
+  conf.expire = s6a_fd_pipeline_expire;
+  s6a_pipeline_p = s6a_pipeline_create (&conf);
+  if (!s6a_pipeline_p) {
+    return RETURNerror;
+  }
+  mme_app_statistics_register_dump (s6a_fd_pipeline_dump);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void
+s6a_fd_pipeline_exit (
+  void)
+{
+  s6a_pipeline_t                         *pipeline = NULL;
+
+  // No more requests to NAS, only release the messages
+  s6a_pipeline_exiting = true;
+  pthread_mutex_lock (&s6a_pipeline_dump_lock);
+  pipeline = s6a_pipeline_p;
+  s6a_pipeline_p = NULL;
+  pthread_mutex_unlock (&s6a_pipeline_dump_lock);
+  s6a_pipeline_destroy (&pipeline);
+  for (int i = 0; i < s6a_nb_hss; i++) {
+    bdestroy_wrapper (&s6a_hss_diamid[i]);
+  }
+  s6a_nb_hss = 0;
+}
+
+//------------------------------------------------------------------------------
+void
+s6a_fd_pipeline_tick (
+  void)
+{
+  s6a_fd_refresh_peers (NULL);
+  s6a_pipeline_tick (s6a_pipeline_p);
+}
+
+//------------------------------------------------------------------------------
+int
+s6a_fd_send_request (
+  struct msg ** const msg,
+  const s6a_pipeline_cmd_t cmd,
+  const char * const imsi)
+{
+  struct msg_hdr                         *hdr = NULL;
+
+  CHECK_FCT (fd_msg_hdr (*msg, &hdr));
+  if (RETURNok != s6a_pipeline_submit (s6a_pipeline_p, cmd, hdr->msg_eteid, imsi, *msg)) {
+    s6a_fd_pipeline_expire (NULL, cmd, imsi, *msg);
+  }
+  *msg = NULL;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int
+s6a_fd_answer_received (
+  struct msg * const ans)
+{
+  struct msg_hdr                         *hdr = NULL;
+
+  CHECK_FCT (fd_msg_hdr (ans, &hdr));
+  return s6a_pipeline_answer (s6a_pipeline_p, hdr->msg_eteid);
+}
+
+//------------------------------------------------------------------------------
+void
+s6a_fd_late_ula_received (
+  void)
+{
+  __atomic_add_fetch (&s6a_late_ulas, 1, __ATOMIC_RELAXED);
+}
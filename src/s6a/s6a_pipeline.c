@@ -0,0 +1,622 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_pipeline.c
+  \brief Bounded pipelining of S6a requests over one or more HSS peers.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "3gpp_23.003.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "s6a_pipeline.h"
+
+// Power of 2, a timeout of up to S6A_PIPELINE_WHEEL_SLOTS ticks is expired without revisiting its entry
+#define S6A_PIPELINE_WHEEL_SLOTS                 512
+// Callbacks invoked per lock acquisition
+#define S6A_PIPELINE_BATCH                       32
+#define S6A_PIPELINE_NO_PEER                     (-1)
+
+typedef struct s6a_pipeline_entry_s {
+  struct s6a_pipeline_entry_s            *hash_next;
+  struct s6a_pipeline_entry_s            *timer_prev;
+  struct s6a_pipeline_entry_s            *timer_next;
+  struct s6a_pipeline_entry_s            *queue_next;    // backlog, expired or free list
+  uint32_t                                eteid;
+  s6a_pipeline_cmd_t                      cmd;
+  int                                     peer;          // S6A_PIPELINE_NO_PEER while in the backlog
+  bool                                    is_sending;    // being handed to the transport, not expired meanwhile
+  uint64_t                                deadline_tick;
+  uint64_t                                sent_usec;
+  void                                   *request;       // NULL once handed to the transport
+  char                                    imsi[IMSI_BCD_DIGITS_MAX + 1];
+} s6a_pipeline_entry_t;
+
+typedef struct s6a_pipeline_queue_s {
+  s6a_pipeline_entry_t                   *head;
+  s6a_pipeline_entry_t                   *tail;
+} s6a_pipeline_queue_t;
+
+// Callback to invoke once the lock is released
+typedef struct s6a_pipeline_event_s {
+  s6a_pipeline_cmd_t                      cmd;
+  uint32_t                                eteid;
+  int                                     peer;          // send if not S6A_PIPELINE_NO_PEER, expire otherwise
+  void                                   *request;
+  char                                    imsi[IMSI_BCD_DIGITS_MAX + 1];
+} s6a_pipeline_event_t;
+
+struct s6a_pipeline_s {
+  pthread_mutex_t                         lock;
+  s6a_pipeline_conf_t                     conf;
+  uint32_t                                nb_entries;
+  s6a_pipeline_entry_t                   *entries;
+  s6a_pipeline_entry_t                   *free_list;
+  uint32_t                                hash_mask;
+  s6a_pipeline_entry_t                  **hash;          // by eteid
+  s6a_pipeline_entry_t                   *wheel[S6A_PIPELINE_WHEEL_SLOTS];
+  uint64_t                                tick_usec;
+  uint64_t                                timeout_ticks;
+  uint64_t                                current_tick;  // last tick expired
+  s6a_pipeline_queue_t                    backlog;
+  s6a_pipeline_queue_t                    expired;       // timed out or not sent, expire callback pending
+  uint32_t                                next_peer;     // round robin between equally loaded peers
+  s6a_pipeline_stats_t                    stats;
+};
+
+static const char * const               g_pipeline_cmd_names[S6A_PIPELINE_CMD_MAX] = {"air", "ulr"};
+
+//------------------------------------------------------------------------------
+static inline uint64_t s6a_pipeline_now_usec(void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+//------------------------------------------------------------------------------
+static inline void s6a_pipeline_queue_push(s6a_pipeline_queue_t * const queue, s6a_pipeline_entry_t * const entry)
+{
+  entry->queue_next = NULL;
+  if (queue->tail) {
+    queue->tail->queue_next = entry;
+  } else {
+    queue->head = entry;
+  }
+  queue->tail = entry;
+}
+
+//------------------------------------------------------------------------------
+static inline s6a_pipeline_entry_t *s6a_pipeline_queue_pop(s6a_pipeline_queue_t * const queue)
+{
+  s6a_pipeline_entry_t                   *entry = queue->head;
+
+  if (entry) {
+    queue->head = entry->queue_next;
+    if (!queue->head) {
+      queue->tail = NULL;
+    }
+    entry->queue_next = NULL;
+  }
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Backlog entries only time out from the head of the queue in the common case, this is O(backlog) otherwise
+static void s6a_pipeline_queue_remove(s6a_pipeline_queue_t * const queue, s6a_pipeline_entry_t * const entry)
+{
+  s6a_pipeline_entry_t                   *previous = NULL;
+  s6a_pipeline_entry_t                   *current = queue->head;
+
+  while ((current) && (current != entry)) {
+    previous = current;
+    current = current->queue_next;
+  }
+  if (!current) {
+    return;
+  }
+  if (previous) {
+    previous->queue_next = entry->queue_next;
+  } else {
+    queue->head = entry->queue_next;
+  }
+  if (queue->tail == entry) {
+    queue->tail = previous;
+  }
+  entry->queue_next = NULL;
+}
+
+//------------------------------------------------------------------------------
+static s6a_pipeline_entry_t *s6a_pipeline_hash_find(const s6a_pipeline_t * const pipeline, const uint32_t eteid)
+{
+  s6a_pipeline_entry_t                   *entry = pipeline->hash[eteid & pipeline->hash_mask];
+
+  while ((entry) && (entry->eteid != eteid)) {
+    entry = entry->hash_next;
+  }
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_hash_remove(s6a_pipeline_t * const pipeline, s6a_pipeline_entry_t * const entry)
+{
+  s6a_pipeline_entry_t                  **link = &pipeline->hash[entry->eteid & pipeline->hash_mask];
+
+  while ((*link) && (*link != entry)) {
+    link = &(*link)->hash_next;
+  }
+  if (*link) {
+    *link = entry->hash_next;
+  }
+  entry->hash_next = NULL;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_timer_arm(s6a_pipeline_t * const pipeline, s6a_pipeline_entry_t * const entry, const uint64_t deadline_tick)
+{
+  s6a_pipeline_entry_t                  **slot = &pipeline->wheel[deadline_tick & (S6A_PIPELINE_WHEEL_SLOTS - 1)];
+
+  entry->deadline_tick = deadline_tick;
+  entry->timer_prev = NULL;
+  entry->timer_next = *slot;
+  if (*slot) {
+    (*slot)->timer_prev = entry;
+  }
+  *slot = entry;
+}
+
+//------------------------------------------------------------------------------
+static void s6a_pipeline_timer_disarm(s6a_pipeline_t * const pipeline, s6a_pipeline_entry_t * const entry)
+{
+  if (entry->timer_prev) {
+    entry->timer_prev->timer_next = entry->timer_next;
+  } else {
+    pipeline->wheel[entry->deadline_tick & (S6A_PIPELINE_WHEEL_SLOTS - 1)] = entry->timer_next;
+  }
+  if (entry->timer_next) {
+    entry->timer_next->timer_prev = entry->timer_prev;
+  }
+  entry->timer_prev = NULL;
+  entry->timer_next = NULL;
+}
+
+//------------------------------------------------------------------------------
+static inline void s6a_pipeline_entry_free(s6a_pipeline_t * const pipeline, s6a_pipeline_entry_t * const entry)
+{
+  entry->request = NULL;
+  entry->queue_next = pipeline->free_list;
+  pipeline->free_list = entry;
+}
+
+//------------------------------------------------------------------------------
+// Retire a pending request without answer, its expire callback is invoked by s6a_pipeline_run()
+static void s6a_pipeline_expire_locked(s6a_pipeline_t * const pipeline, s6a_pipeline_entry_t * const entry)
+{
+  s6a_pipeline_hash_remove (pipeline, entry);
+  s6a_pipeline_timer_disarm (pipeline, entry);
+  if (S6A_PIPELINE_NO_PEER == entry->peer) {
+    s6a_pipeline_queue_remove (&pipeline->backlog, entry);
+    pipeline->stats.backlog_length--;
+    pipeline->stats.backlog_timeouts++;
+  } else {
+    pipeline->stats.peers[entry->peer].in_flight--;
+    pipeline->stats.peers[entry->peer].timeouts++;
+  }
+  s6a_pipeline_queue_push (&pipeline->expired, entry);
+}
+
+//------------------------------------------------------------------------------
+// Open peer below its window with the fewest requests in flight
+static int s6a_pipeline_select_peer(const s6a_pipeline_t * const pipeline)
+{
+  int                                     best = S6A_PIPELINE_NO_PEER;
+
+  for (uint32_t i = 0; i < pipeline->conf.nb_peers; i++) {
+    int                                   peer = (pipeline->next_peer + i) % pipeline->conf.nb_peers;
+    const s6a_pipeline_peer_stats_t      *peer_stats = &pipeline->stats.peers[peer];
+
+    if ((peer_stats->is_open) && (peer_stats->in_flight < pipeline->conf.window) &&
+        ((S6A_PIPELINE_NO_PEER == best) || (peer_stats->in_flight < pipeline->stats.peers[best].in_flight))) {
+      best = peer;
+    }
+  }
+  return best;
+}
+
+//------------------------------------------------------------------------------
+// Collect a batch of callbacks: expired requests first, then waiting requests that can be sent
+static int s6a_pipeline_collect_locked(s6a_pipeline_t * const pipeline, s6a_pipeline_event_t * const events)
+{
+  s6a_pipeline_entry_t                   *entry = NULL;
+  uint64_t                                now = 0;
+  int                                     nb_events = 0;
+  int                                     peer = S6A_PIPELINE_NO_PEER;
+
+  while ((S6A_PIPELINE_BATCH > nb_events) && (entry = s6a_pipeline_queue_pop (&pipeline->expired))) {
+    events[nb_events].cmd = entry->cmd;
+    events[nb_events].eteid = entry->eteid;
+    events[nb_events].peer = S6A_PIPELINE_NO_PEER;
+    events[nb_events].request = entry->request;
+    memcpy (events[nb_events].imsi, entry->imsi, sizeof (entry->imsi));
+    s6a_pipeline_entry_free (pipeline, entry);
+    nb_events++;
+  }
+  while ((S6A_PIPELINE_BATCH > nb_events) && (pipeline->backlog.head) &&
+         (S6A_PIPELINE_NO_PEER != (peer = s6a_pipeline_select_peer (pipeline)))) {
+    if (!now) {
+      now = s6a_pipeline_now_usec ();
+    }
+    entry = s6a_pipeline_queue_pop (&pipeline->backlog);
+    pipeline->stats.backlog_length--;
+    pipeline->next_peer = (peer + 1) % pipeline->conf.nb_peers;
+    pipeline->stats.peers[peer].in_flight++;
+    pipeline->stats.peers[peer].sent++;
+    entry->peer = peer;
+    entry->is_sending = true;
+    entry->sent_usec = now;
+    events[nb_events].cmd = entry->cmd;
+    events[nb_events].eteid = entry->eteid;
+    events[nb_events].peer = peer;
+    events[nb_events].request = entry->request;
+    memcpy (events[nb_events].imsi, entry->imsi, sizeof (entry->imsi));
+    entry->request = NULL;
+    nb_events++;
+  }
+  return nb_events;
+}
+
+//------------------------------------------------------------------------------
+// Invoke the pending callbacks, until no request is expired or can be sent
+static void s6a_pipeline_run(s6a_pipeline_t * const pipeline)
+{
+  s6a_pipeline_event_t                    events[S6A_PIPELINE_BATCH];
+  bool                                    send_failed[S6A_PIPELINE_BATCH];
+  s6a_pipeline_entry_t                   *entry = NULL;
+  int                                     nb_events = 0;
+  int                                     nb_sent = 0;
+
+  do {
+    pthread_mutex_lock (&pipeline->lock);
+    nb_events = s6a_pipeline_collect_locked (pipeline, events);
+    pthread_mutex_unlock (&pipeline->lock);
+
+    nb_sent = 0;
+    for (int i = 0; i < nb_events; i++) {
+      send_failed[i] = false;
+      if (S6A_PIPELINE_NO_PEER == events[i].peer) {
+        pipeline->conf.expire (pipeline->conf.cb_arg, events[i].cmd, events[i].imsi, events[i].request);
+      } else {
+        send_failed[i] = (0 != pipeline->conf.send (pipeline->conf.cb_arg, events[i].peer, events[i].request));
+        nb_sent++;
+      }
+    }
+    if (!nb_sent) {
+      continue;
+    }
+
+    pthread_mutex_lock (&pipeline->lock);
+    for (int i = 0; i < nb_events; i++) {
+      if (S6A_PIPELINE_NO_PEER == events[i].peer) {
+        continue;
+      }
+      entry = s6a_pipeline_hash_find (pipeline, events[i].eteid);
+      if ((!entry) || (entry->peer != events[i].peer)) {
+        // Already answered, a failed request is still released below
+        continue;
+      }
+      entry->is_sending = false;
+      if (send_failed[i]) {
+        OAILOG_WARNING (LOG_S6A, "S6a %s for IMSI %s (ete-id 0x%08x) could not be sent to peer %d\n",
+            g_pipeline_cmd_names[events[i].cmd], events[i].imsi, events[i].eteid, events[i].peer);
+        // Given back to the expire callback by the next batch
+        s6a_pipeline_hash_remove (pipeline, entry);
+        s6a_pipeline_timer_disarm (pipeline, entry);
+        pipeline->stats.peers[entry->peer].in_flight--;
+        pipeline->stats.peers[entry->peer].send_failures++;
+        entry->request = events[i].request;
+        s6a_pipeline_queue_push (&pipeline->expired, entry);
+        send_failed[i] = false;
+      }
+    }
+    pthread_mutex_unlock (&pipeline->lock);
+
+    for (int i = 0; i < nb_events; i++) {
+      if (send_failed[i]) {
+        pipeline->conf.expire (pipeline->conf.cb_arg, events[i].cmd, events[i].imsi, events[i].request);
+      }
+    }
+  } while (nb_events);
+}
+
+//------------------------------------------------------------------------------
+s6a_pipeline_t *s6a_pipeline_create(const s6a_pipeline_conf_t * const conf)
+{
+  s6a_pipeline_t                         *pipeline = NULL;
+  uint32_t                                nb_buckets = 1;
+
+  if ((!conf->nb_peers) || (S6A_PIPELINE_MAX_PEERS < conf->nb_peers) || (!conf->window) ||
+      (!conf->timeout_msec) || (!conf->tick_msec) || (!conf->send) || (!conf->expire)) {
+    OAILOG_ERROR (LOG_S6A, "Bad S6a pipeline: %u peer(s), window %u, timeout %u ms, tick %u ms\n",
+        conf->nb_peers, conf->window, conf->timeout_msec, conf->tick_msec);
+    return NULL;
+  }
+  pipeline = calloc (1, sizeof (s6a_pipeline_t));
+  if (!pipeline) {
+    return NULL;
+  }
+  pipeline->conf = *conf;
+  pipeline->stats.nb_peers = conf->nb_peers;
+  pipeline->nb_entries = conf->nb_peers * conf->window + conf->backlog;
+  while (nb_buckets < 2 * pipeline->nb_entries) {
+    nb_buckets <<= 1;
+  }
+  pipeline->hash_mask = nb_buckets - 1;
+  pipeline->entries = calloc (pipeline->nb_entries, sizeof (s6a_pipeline_entry_t));
+  pipeline->hash = calloc (nb_buckets, sizeof (s6a_pipeline_entry_t *));
+  if ((!pipeline->entries) || (!pipeline->hash)) {
+    free_wrapper ((void**)&pipeline->entries);
+    free_wrapper ((void**)&pipeline->hash);
+    free_wrapper ((void**)&pipeline);
+    return NULL;
+  }
+  for (uint32_t i = 0; i < pipeline->nb_entries; i++) {
+    s6a_pipeline_entry_free (pipeline, &pipeline->entries[pipeline->nb_entries - 1 - i]);
+  }
+  pipeline->tick_usec = (uint64_t)conf->tick_msec * 1000;
+  // +1: the request is never expired before timeout_msec, whatever its position in its first tick
+  pipeline->timeout_ticks = ((uint64_t)conf->timeout_msec + conf->tick_msec - 1) / conf->tick_msec + 1;
+  pipeline->current_tick = s6a_pipeline_now_usec () / pipeline->tick_usec;
+  pthread_mutex_init (&pipeline->lock, NULL);
+  OAILOG_DEBUG (LOG_S6A, "S6a pipeline: %u peer(s), window %u, backlog %u, timeout %u ms\n",
+      conf->nb_peers, conf->window, conf->backlog, conf->timeout_msec);
+  return pipeline;
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_destroy(s6a_pipeline_t ** const pipeline)
+{
+  s6a_pipeline_t                         *p = NULL;
+
+  if ((!pipeline) || (!*pipeline)) {
+    return;
+  }
+  p = *pipeline;
+  pthread_mutex_lock (&p->lock);
+  for (uint32_t peer = 0; peer < p->conf.nb_peers; peer++) {
+    p->stats.peers[peer].is_open = false;
+  }
+  for (uint32_t i = 0; i <= p->hash_mask; i++) {
+    while (p->hash[i]) {
+      s6a_pipeline_expire_locked (p, p->hash[i]);
+    }
+  }
+  pthread_mutex_unlock (&p->lock);
+  s6a_pipeline_run (p);
+  pthread_mutex_destroy (&p->lock);
+  free_wrapper ((void**)&p->entries);
+  free_wrapper ((void**)&p->hash);
+  free_wrapper ((void**)pipeline);
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_set_peer_state(s6a_pipeline_t * const pipeline, const int peer, const bool is_open)
+{
+  bool                                    changed = false;
+
+  if ((0 > peer) || (pipeline->conf.nb_peers <= (uint32_t)peer)) {
+    return;
+  }
+  pthread_mutex_lock (&pipeline->lock);
+  changed = (pipeline->stats.peers[peer].is_open != is_open);
+  pipeline->stats.peers[peer].is_open = is_open;
+  pthread_mutex_unlock (&pipeline->lock);
+  if (changed) {
+    OAILOG_INFO (LOG_S6A, "S6a pipeline: peer %d %s\n", peer, (is_open) ? "open" : "closed");
+    s6a_pipeline_run (pipeline);
+  }
+}
+
+//------------------------------------------------------------------------------
+int s6a_pipeline_submit(s6a_pipeline_t * const pipeline, const s6a_pipeline_cmd_t cmd, const uint32_t eteid,
+                        const char * const imsi, void *request)
+{
+  s6a_pipeline_entry_t                   *entry = NULL;
+  const char                             *reason = NULL;
+  uint64_t                                now_tick = 0;
+
+  pthread_mutex_lock (&pipeline->lock);
+  if (s6a_pipeline_hash_find (pipeline, eteid)) {
+    reason = "ete-id already pending";
+  } else if ((!pipeline->free_list) ||
+             ((pipeline->stats.backlog_length >= pipeline->conf.backlog) &&
+              (S6A_PIPELINE_NO_PEER == s6a_pipeline_select_peer (pipeline)))) {
+    pipeline->stats.rejected++;
+    reason = "backlog full";
+  } else {
+    entry = pipeline->free_list;
+    pipeline->free_list = entry->queue_next;
+    entry->eteid = eteid;
+    entry->cmd = cmd;
+    entry->peer = S6A_PIPELINE_NO_PEER;
+    entry->is_sending = false;
+    entry->sent_usec = 0;
+    entry->request = request;
+    snprintf (entry->imsi, sizeof (entry->imsi), "%s", (imsi) ? imsi : "");
+    entry->hash_next = pipeline->hash[eteid & pipeline->hash_mask];
+    pipeline->hash[eteid & pipeline->hash_mask] = entry;
+    now_tick = s6a_pipeline_now_usec () / pipeline->tick_usec;
+    s6a_pipeline_timer_arm (pipeline, entry, now_tick + pipeline->timeout_ticks);
+    // Every request goes through the backlog so that they are sent in order
+    s6a_pipeline_queue_push (&pipeline->backlog, entry);
+    pipeline->stats.backlog_length++;
+  }
+  pthread_mutex_unlock (&pipeline->lock);
+  if (reason) {
+    OAILOG_WARNING (LOG_S6A, "S6a %s for IMSI %s (ete-id 0x%08x) refused: %s\n", g_pipeline_cmd_names[cmd],
+        (imsi) ? imsi : "", eteid, reason);
+    return RETURNerror;
+  }
+  s6a_pipeline_run (pipeline);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int s6a_pipeline_answer(s6a_pipeline_t * const pipeline, const uint32_t eteid)
+{
+  s6a_pipeline_entry_t                   *entry = NULL;
+  s6a_pipeline_peer_stats_t              *peer_stats = NULL;
+  uint64_t                                now = s6a_pipeline_now_usec ();
+  uint64_t                                elapsed = 0;
+  int                                     bucket = 0;
+
+  pthread_mutex_lock (&pipeline->lock);
+  entry = s6a_pipeline_hash_find (pipeline, eteid);
+  if ((!entry) || (S6A_PIPELINE_NO_PEER == entry->peer)) {
+    pipeline->stats.unknown_answers++;
+    pthread_mutex_unlock (&pipeline->lock);
+    OAILOG_WARNING (LOG_S6A, "S6a answer with ete-id 0x%08x matches no pending request\n", eteid);
+    return RETURNerror;
+  }
+  elapsed = (now > entry->sent_usec) ? now - entry->sent_usec : 0;
+  // smallest bucket b such as elapsed <= 2^b
+  bucket = (elapsed <= 1) ? 0 : 64 - __builtin_clzll (elapsed - 1);
+  if (S6A_PIPELINE_RTT_BUCKETS <= bucket) {
+    bucket = S6A_PIPELINE_RTT_BUCKETS - 1;
+  }
+  peer_stats = &pipeline->stats.peers[entry->peer];
+  peer_stats->in_flight--;
+  peer_stats->answered++;
+  peer_stats->rtt_count[entry->cmd][bucket]++;
+  peer_stats->rtt_sum_usec[entry->cmd] += elapsed;
+  s6a_pipeline_hash_remove (pipeline, entry);
+  s6a_pipeline_timer_disarm (pipeline, entry);
+  s6a_pipeline_entry_free (pipeline, entry);
+  pthread_mutex_unlock (&pipeline->lock);
+  s6a_pipeline_run (pipeline);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_tick(s6a_pipeline_t * const pipeline)
+{
+  s6a_pipeline_entry_t                   *entry = NULL;
+  s6a_pipeline_entry_t                   *next = NULL;
+  uint64_t                                now_tick = s6a_pipeline_now_usec () / pipeline->tick_usec;
+  uint64_t                                tick = 0;
+  uint64_t                                last_tick = 0;
+
+  pthread_mutex_lock (&pipeline->lock);
+  if (now_tick > pipeline->current_tick) {
+    // A full turn visits every slot
+    last_tick = ((now_tick - pipeline->current_tick) > S6A_PIPELINE_WHEEL_SLOTS) ?
+        pipeline->current_tick + S6A_PIPELINE_WHEEL_SLOTS : now_tick;
+    for (tick = pipeline->current_tick + 1; tick <= last_tick; tick++) {
+      for (entry = pipeline->wheel[tick & (S6A_PIPELINE_WHEEL_SLOTS - 1)]; entry; entry = next) {
+        next = entry->timer_next;
+        if (entry->deadline_tick > now_tick) {
+          continue;
+        }
+        if (entry->is_sending) {
+          // The transport owns the request, it is expired once the send returns
+          s6a_pipeline_timer_disarm (pipeline, entry);
+          s6a_pipeline_timer_arm (pipeline, entry, now_tick + 1);
+          continue;
+        }
+        OAILOG_WARNING (LOG_S6A, "S6a %s for IMSI %s (ete-id 0x%08x) timed out%s\n", g_pipeline_cmd_names[entry->cmd],
+            entry->imsi, entry->eteid, (S6A_PIPELINE_NO_PEER == entry->peer) ? " in backlog" : "");
+        s6a_pipeline_expire_locked (pipeline, entry);
+      }
+    }
+    pipeline->current_tick = now_tick;
+  }
+  pthread_mutex_unlock (&pipeline->lock);
+  s6a_pipeline_run (pipeline);
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_get_stats(s6a_pipeline_t * const pipeline, s6a_pipeline_stats_t * const stats)
+{
+  pthread_mutex_lock (&pipeline->lock);
+  *stats = pipeline->stats;
+  pthread_mutex_unlock (&pipeline->lock);
+}
+
+//------------------------------------------------------------------------------
+void s6a_pipeline_dump(s6a_pipeline_t * const pipeline, const char * const * const peer_names, bstring buffer)
+{
+  s6a_pipeline_stats_t                    stats;
+  char                                    peer_label[16];
+  const char                             *name = NULL;
+
+  s6a_pipeline_get_stats (pipeline, &stats);
+  bcatcstr (buffer, "# TYPE mme_s6a_backlog gauge\n");
+  bformata (buffer, "mme_s6a_backlog %u\n", stats.backlog_length);
+  bformata (buffer, "mme_s6a_rejected_total %" PRIu64 "\n", stats.rejected);
+  bformata (buffer, "mme_s6a_backlog_timeouts_total %" PRIu64 "\n", stats.backlog_timeouts);
+  bformata (buffer, "mme_s6a_unknown_answers_total %" PRIu64 "\n", stats.unknown_answers);
+  for (uint32_t peer = 0; peer < stats.nb_peers; peer++) {
+    const s6a_pipeline_peer_stats_t      *peer_stats = &stats.peers[peer];
+
+    snprintf (peer_label, sizeof (peer_label), "%u", peer);
+    name = ((peer_names) && (peer_names[peer])) ? peer_names[peer] : peer_label;
+    bformata (buffer, "mme_s6a_peer_open{peer=\"%s\"} %d\n", name, (peer_stats->is_open) ? 1 : 0);
+    bformata (buffer, "mme_s6a_in_flight{peer=\"%s\"} %u\n", name, peer_stats->in_flight);
+    bformata (buffer, "mme_s6a_sent_total{peer=\"%s\"} %" PRIu64 "\n", name, peer_stats->sent);
+    bformata (buffer, "mme_s6a_answered_total{peer=\"%s\"} %" PRIu64 "\n", name, peer_stats->answered);
+    bformata (buffer, "mme_s6a_timeouts_total{peer=\"%s\"} %" PRIu64 "\n", name, peer_stats->timeouts);
+    bformata (buffer, "mme_s6a_send_failures_total{peer=\"%s\"} %" PRIu64 "\n", name, peer_stats->send_failures);
+  }
+  bcatcstr (buffer, "# TYPE mme_s6a_rtt_usec histogram\n");
+  for (uint32_t peer = 0; peer < stats.nb_peers; peer++) {
+    const s6a_pipeline_peer_stats_t      *peer_stats = &stats.peers[peer];
+
+    snprintf (peer_label, sizeof (peer_label), "%u", peer);
+    name = ((peer_names) && (peer_names[peer])) ? peer_names[peer] : peer_label;
+    for (int cmd = 0; cmd < S6A_PIPELINE_CMD_MAX; cmd++) {
+      uint64_t                            cumul = 0;
+
+      for (int b = 0; b < S6A_PIPELINE_RTT_BUCKETS - 1; b++) {
+        cumul += peer_stats->rtt_count[cmd][b];
+        bformata (buffer, "mme_s6a_rtt_usec_bucket{peer=\"%s\",command=\"%s\",le=\"%" PRIu64 "\"} %" PRIu64 "\n",
+            name, g_pipeline_cmd_names[cmd], UINT64_C(1) << b, cumul);
+      }
+      cumul += peer_stats->rtt_count[cmd][S6A_PIPELINE_RTT_BUCKETS - 1];
+      bformata (buffer, "mme_s6a_rtt_usec_bucket{peer=\"%s\",command=\"%s\",le=\"+Inf\"} %" PRIu64 "\n",
+          name, g_pipeline_cmd_names[cmd], cumul);
+      bformata (buffer, "mme_s6a_rtt_usec_sum{peer=\"%s\",command=\"%s\"} %" PRIu64 "\n",
+          name, g_pipeline_cmd_names[cmd], peer_stats->rtt_sum_usec[cmd]);
+      bformata (buffer, "mme_s6a_rtt_usec_count{peer=\"%s\",command=\"%s\"} %" PRIu64 "\n",
+          name, g_pipeline_cmd_names[cmd], cumul);
+    }
+  }
+}
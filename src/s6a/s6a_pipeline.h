@@ -0,0 +1,149 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file s6a_pipeline.h
+  \brief Bounded pipelining of S6a requests (AIR, ULR) over one or more HSS peers.
+  Every request is identified by its Diameter End-to-End identifier. It is sent at once to the open
+  peer with the fewest requests in flight if that peer is below its window, otherwise it waits in a
+  FIFO backlog until a slot is freed by an answer or a timeout, or until a peer is opened.
+  Pending requests (sent or waiting) are indexed by End-to-End identifier and armed on a hashed timer
+  wheel, an answer or a timeout retires them in O(1). Round trip times are kept per peer and per
+  command in log2 microsecond histograms.
+  The pipeline does not depend on the Diameter stack: the transport and the timeout handling are
+  provided as callbacks, that are always invoked without any lock held. All functions are thread safe.
+*/
+#ifndef FILE_S6A_PIPELINE_SEEN
+#define FILE_S6A_PIPELINE_SEEN
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bstrlib.h"
+
+#define S6A_PIPELINE_MAX_PEERS                   8
+
+/* Round trip histogram bucket i counts round trips <= 2^i microseconds, last bucket is unbounded */
+#define S6A_PIPELINE_RTT_BUCKETS                 26
+
+typedef enum {
+  S6A_PIPELINE_AIR = 0,
+  S6A_PIPELINE_ULR,
+  S6A_PIPELINE_CMD_MAX
+} s6a_pipeline_cmd_t;
+
+/*
+ * Hand a request to the transport towards a peer.
+ *
+ * @return 0 if the transport took the ownership of the request, any other value if the request
+ *         could not be sent, it is then given back through the expire callback.
+ */
+typedef int (*s6a_pipeline_send_cb_t)(void *cb_arg, const int peer, void *request);
+
+/*
+ * A request will never be answered: it timed out, it could not be sent, or the pipeline is destroyed.
+ * request is NULL if the request was handed to the transport, otherwise the callback must release it.
+ */
+typedef void (*s6a_pipeline_expire_cb_t)(void *cb_arg, const s6a_pipeline_cmd_t cmd, const char * const imsi, void *request);
+
+typedef struct s6a_pipeline_conf_s {
+  uint32_t                 nb_peers;        /*!< \brief 1 to S6A_PIPELINE_MAX_PEERS, all closed at creation */
+  uint32_t                 window;          /*!< \brief requests in flight per peer */
+  uint32_t                 backlog;         /*!< \brief requests waiting for a window slot */
+  uint32_t                 timeout_msec;    /*!< \brief from submission to answer */
+  uint32_t                 tick_msec;       /*!< \brief timer wheel resolution */
+  s6a_pipeline_send_cb_t   send;
+  s6a_pipeline_expire_cb_t expire;
+  void                    *cb_arg;
+} s6a_pipeline_conf_t;
+
+typedef struct s6a_pipeline_peer_stats_s {
+  bool                     is_open;
+  uint32_t                 in_flight;
+  uint64_t                 sent;
+  uint64_t                 answered;
+  uint64_t                 timeouts;
+  uint64_t                 send_failures;
+  uint64_t                 rtt_count[S6A_PIPELINE_CMD_MAX][S6A_PIPELINE_RTT_BUCKETS];
+  uint64_t                 rtt_sum_usec[S6A_PIPELINE_CMD_MAX];
+} s6a_pipeline_peer_stats_t;
+
+typedef struct s6a_pipeline_stats_s {
+  uint32_t                 nb_peers;
+  uint32_t                 backlog_length;
+  uint64_t                 rejected;          /*!< \brief submissions refused, backlog full */
+  uint64_t                 backlog_timeouts;  /*!< \brief requests timed out before being sent */
+  uint64_t                 unknown_answers;   /*!< \brief late or unexpected answers */
+  s6a_pipeline_peer_stats_t peers[S6A_PIPELINE_MAX_PEERS];
+} s6a_pipeline_stats_t;
+
+typedef struct s6a_pipeline_s s6a_pipeline_t;
+
+/*
+ * Create a pipeline.
+ *
+ * @return the pipeline, or NULL if the configuration is invalid or out of memory.
+ */
+s6a_pipeline_t *s6a_pipeline_create(const s6a_pipeline_conf_t * const conf);
+
+/*
+ * Destroy a pipeline, every pending request is reported to the expire callback.
+ */
+void s6a_pipeline_destroy(s6a_pipeline_t ** const pipeline);
+
+/*
+ * Open or close a peer. Opening a peer sends the backlog, the requests in flight on a closed peer
+ * are left to their answer or timeout.
+ */
+void s6a_pipeline_set_peer_state(s6a_pipeline_t * const pipeline, const int peer, const bool is_open);
+
+/*
+ * Submit a request, it is sent now or queued in the backlog.
+ *
+ * @param eteid    End-to-End identifier of the request, that will be echoed by its answer.
+ * @param imsi     Subscriber, given back to the expire callback.
+ * @param request  Opaque to the pipeline, given to the send or expire callback.
+ * @return RETURNok, the request belongs to the pipeline;
+ *         RETURNerror if the backlog is full or eteid is already pending, the request still belongs to the caller.
+ */
+int s6a_pipeline_submit(s6a_pipeline_t * const pipeline, const s6a_pipeline_cmd_t cmd, const uint32_t eteid,
+                        const char * const imsi, void *request);
+
+/*
+ * An answer was received, retire its request and record its round trip time.
+ *
+ * @return RETURNok, RETURNerror if no request is pending for eteid (already timed out or unexpected).
+ */
+int s6a_pipeline_answer(s6a_pipeline_t * const pipeline, const uint32_t eteid);
+
+/*
+ * Expire the requests whose timeout elapsed, to be called every tick_msec.
+ */
+void s6a_pipeline_tick(s6a_pipeline_t * const pipeline);
+
+void s6a_pipeline_get_stats(s6a_pipeline_t * const pipeline, s6a_pipeline_stats_t * const stats);
+
+/*
+ * Append the counters and round trip histograms to buffer (Prometheus text format).
+ *
+ * @param peer_names Name of each peer, for the labels.
+ */
+void s6a_pipeline_dump(s6a_pipeline_t * const pipeline, const char * const * const peer_names, bstring buffer);
+
+#endif /* FILE_S6A_PIPELINE_SEEN */
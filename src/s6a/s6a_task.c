@@ -56,6 +56,7 @@
 
 static int                              gnutls_log_level = 9;
 static long                             timer_id = 0;
+static long                             pipeline_timer_id = 0;
 struct session_handler                 *ts_sess_hdl;
 
 s6a_fd_cnf_t                            s6a_fd_cnf;
@@ -120,6 +121,10 @@ void *s6a_thread (void *args)
       }
       break;
     case TIMER_HAS_EXPIRED:{
+        if (received_message_p->ittiMsg.timer_has_expired.timer_id == pipeline_timer_id) {
+          s6a_fd_pipeline_tick ();
+          break;
+        }
         /*
          * Trying to connect to peers
          */
@@ -252,6 +257,14 @@ int s6a_init (
     OAILOG_DEBUG (LOG_S6A, "s6a_fd_init_dict_objs done\n");
   }
 
+  ret = s6a_fd_pipeline_init (mme_config_p);
+  if (ret) {
+    OAILOG_ERROR (LOG_S6A, "An error occurred during s6a_fd_pipeline_init.\n");
+    return ret;
+  } else {
+    OAILOG_DEBUG (LOG_S6A, "s6a_fd_pipeline_init done\n");
+  }
+
   if (itti_create_task (TASK_S6A, &s6a_thread, NULL) < 0) {
     OAILOG_ERROR (LOG_S6A, "s6a create task\n");
     return RETURNerror;
@@ -261,6 +274,9 @@ int s6a_init (
   /* Add timer here to send message to connect to peer */
   timer_setup(S6A_PEER_CONNECT_TIMEOUT_SEC, S6A_PEER_CONNECT_TIMEOUT_MICRO_SEC,
               TASK_S6A, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
+  /* Expiry of the requests not answered in time */
+  timer_setup(0, S6A_PIPELINE_TICK_MSEC * 1000,
+              TASK_S6A, INSTANCE_DEFAULT, TIMER_PERIODIC, NULL, &pipeline_timer_id);
 
   return RETURNok;
 }
@@ -271,6 +287,9 @@ static void s6a_exit(void)
   if (timer_id) {
     timer_remove(timer_id, NULL);
   }
+  if (pipeline_timer_id) {
+    timer_remove(pipeline_timer_id, NULL);
+  }
   // Release all resources
   free_wrapper((void **) &fd_g_config->cnf_diamid);
   fd_g_config->cnf_diamid_len = 0;
@@ -286,4 +305,6 @@ static void s6a_exit(void)
   if (rv) {
     OAI_FPRINTF_ERR ("An error occurred during fd_core_wait_shutdown_complete().\n");
   }
+  // No more answers from freeDiameter
+  s6a_fd_pipeline_exit();
 }
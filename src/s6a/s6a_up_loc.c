@@ -64,6 +64,13 @@ s6a_ula_cb (
 
   DevAssert (msg_pP );
   ans_p = *msg_pP;
+  if (RETURNok != s6a_fd_answer_received (ans_p)) {
+    /*
+     * Timed out: MME_APP got no failure for the ULR and still waits for its answer
+     */
+    OAILOG_WARNING (LOG_S6A, "Late S6a ULA delivered\n");
+    s6a_fd_late_ula_received ();
+  }
   /*
    * Retrieve the original query associated with the asnwer
    */
@@ -180,7 +187,7 @@ s6a_generate_update_location (
   /*
    * Create the new update location request message
    */
-  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, 0, &msg_p));
+  CHECK_FCT (fd_msg_new (s6a_fd_cnf.dataobj_s6a_ulr, MSGFL_ALLOC_ETEID, &msg_p));
   /*
    * Create a new session
    */
@@ -209,21 +216,8 @@ s6a_generate_update_location (
   CHECK_FCT (fd_msg_add_origin (msg_p, 0));
   mme_config_read_lock (&mme_config);
   /*
-   * Destination Host
+   * Destination Host is added once the HSS is chosen, see s6a_fd_send_request()
    */
-  {
-    bstring                                 host = bstrcpy(mme_config.s6a_config.hss_host_name);
-
-    bconchar(host, '.');
-    bconcat (host, mme_config.realm);
-
-    CHECK_FCT (fd_msg_avp_new (s6a_fd_cnf.dataobj_s6a_destination_host, 0, &avp_p));
-    value.os.data = (unsigned char *)bdata(host);
-    value.os.len = blength(host);
-    CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
-    CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-    bdestroy_wrapper (&host);
-  }
   /*
    * Destination_Realm
    */
@@ -290,7 +284,7 @@ s6a_generate_update_location (
 
   CHECK_FCT (fd_msg_avp_setvalue (avp_p, &value));
   CHECK_FCT (fd_msg_avp_add (msg_p, MSG_BRW_LAST_CHILD, avp_p));
-  CHECK_FCT (fd_msg_send (&msg_p, NULL, NULL));
+  CHECK_FCT (s6a_fd_send_request (&msg_p, S6A_PIPELINE_ULR, ulr_pP->imsi));
   OAILOG_DEBUG (LOG_S6A, "Sending s6a ulr for imsi=%s\n", ulr_pP->imsi);
   return RETURNok;
 }
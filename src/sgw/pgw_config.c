@@ -67,15 +67,28 @@ void pgw_config_init (pgw_config_t * config_pP)
 {
   memset ((char *)config_pP, 0, sizeof (*config_pP));
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
-  STAILQ_INIT (&config_pP->ipv4_pool_list);
+  config_pP->num_ue_pool_apn = 1;
+}
+
+//------------------------------------------------------------------------------
+void pgw_config_exit (pgw_config_t * config_pP)
+{
+  for (int i = 0; i < config_pP->num_ue_pool_apn; i++) {
+    bdestroy_wrapper (&config_pP->ue_pool_apn_name[i]);
+  }
+  for (int i = 0; i < config_pP->num_ue_static_ipv4; i++) {
+    bdestroy_wrapper (&config_pP->ue_static_ipv4[i].imsi);
+    bdestroy_wrapper (&config_pP->ue_static_ipv4[i].apn);
+  }
+  free_wrapper ((void**)&config_pP->ue_static_ipv4);
+  config_pP->num_ue_static_ipv4 = 0;
+  bdestroy_wrapper (&config_pP->ue_pool_persistence_file);
 }
 
 //------------------------------------------------------------------------------
 int pgw_config_process (pgw_config_t * config_pP)
 {
   struct in_addr                          addr_start, addr_mask;
-  uint64_t                                counter64 = 0;
-  conf_ipv4_list_elm_t                   *ip4_ref = NULL;
 
   async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t mangle -F OUTPUT");
   async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t mangle -F POSTROUTING");
@@ -150,22 +163,6 @@ int pgw_config_process (pgw_config_t * config_pP)
           inet_ntoa(config_pP->ue_pool_addr[i]), config_pP->ue_pool_mask[i], addr_start.s_addr, addr_mask.s_addr);
     }
 
-    counter64 = 0x00000000FFFFFFFF >> config_pP->ue_pool_mask[i];  // address Prefix_mask/0..0 not valid
-    /* .1 reserved for gateway
-     * the last address is reserved traditionally (.255 in the case of mask 24)
-     */
-    counter64 = counter64 - 2;
-
-    //Any math should be applied onto host byte order i.e. ntohl()
-    addr_start.s_addr = htonl( ntohl(addr_start.s_addr) + 2 );
-    do {
-      ip4_ref = calloc (1, sizeof (conf_ipv4_list_elm_t));
-      ip4_ref->addr.s_addr = addr_start.s_addr;
-      STAILQ_INSERT_TAIL (&config_pP->ipv4_pool_list, ip4_ref, ipv4_entries);
-      counter64 = counter64 - 1;
-      addr_start.s_addr = htonl( ntohl(addr_start.s_addr) + 1 );
-    } while (counter64 > 0);
-
     //---------------
     if (config_pP->masquerade_SGI) {
       async_system_command (TASK_ASYNC_SYSTEM, PGW_ABORT_ON_ERROR, "iptables -t nat -I POSTROUTING -s %s/%d -o %s  ! --protocol sctp -j SNAT --to-source %s",
@@ -199,6 +196,145 @@ int pgw_config_process (pgw_config_t * config_pP)
   return 0;
 }
 
+//------------------------------------------------------------------------------
+static void pgw_config_parse_ipv4_pool_list (pgw_config_t * config_pP, const config_setting_t * const setting, const int apn_index)
+{
+  const char                             *astring = NULL;
+  int                                     prefix_mask = 0;
+  struct in_addr                          addr = {.s_addr = INADDR_ANY};
+
+  for (int i = 0; i < config_setting_length (setting); i++) {
+    astring = config_setting_get_string_elem (setting, i);
+
+    if (astring) {
+      bstring cidr = bfromcstr (astring);
+      AssertFatal(BSTR_OK == btrimws(cidr), "Error in PGW_CONFIG_STRING_IPV4_ADDRESS_LIST %s", astring);
+      struct bstrList *list = bsplit (cidr, PGW_CONFIG_STRING_IPV4_PREFIX_DELIMITER);
+      AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
+
+      if (inet_pton (AF_INET, bdata(list->entry[0]), &addr) == 1) {
+        prefix_mask = atoi ((const char *)list->entry[1]->data);
+
+        if ((prefix_mask >= 2) && (prefix_mask < 31) && (config_pP->num_ue_pool < PGW_NUM_UE_POOL_MAX)) {
+          config_pP->ue_pool_addr[config_pP->num_ue_pool] = addr;
+          config_pP->ue_pool_mask[config_pP->num_ue_pool] = prefix_mask;
+          config_pP->ue_pool_apn[config_pP->num_ue_pool] = apn_index;
+          config_pP->num_ue_pool += 1;
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: BAD MASQ: %d\n", prefix_mask);
+        }
+      }
+      bstrListDestroy(list);
+      bdestroy_wrapper (&cidr);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void pgw_config_parse_ipv6_pool_list (pgw_config_t * config_pP, const config_setting_t * const setting, const int apn_index)
+{
+  const char                             *astring = NULL;
+  int                                     prefix_len = 0;
+  struct in6_addr                         addr = IN6ADDR_ANY_INIT;
+
+  for (int i = 0; i < config_setting_length (setting); i++) {
+    astring = config_setting_get_string_elem (setting, i);
+
+    if (astring) {
+      bstring cidr = bfromcstr (astring);
+      AssertFatal(BSTR_OK == btrimws(cidr), "Error in PGW_CONFIG_STRING_IPV6_ADDRESS_LIST %s", astring);
+      struct bstrList *list = bsplit (cidr, PGW_CONFIG_STRING_IPV4_PREFIX_DELIMITER);
+      AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
+
+      if (inet_pton (AF_INET6, bdata(list->entry[0]), &addr) == 1) {
+        prefix_len = atoi ((const char *)list->entry[1]->data);
+
+        // UEs are delegated /64 prefixes
+        if ((prefix_len >= 16) && (prefix_len < 64) && (config_pP->num_ue_pool_ipv6 < PGW_NUM_UE_POOL_IPV6_MAX)) {
+          config_pP->ue_pool_ipv6_addr[config_pP->num_ue_pool_ipv6] = addr;
+          config_pP->ue_pool_ipv6_prefix_len[config_pP->num_ue_pool_ipv6] = prefix_len;
+          config_pP->ue_pool_ipv6_apn[config_pP->num_ue_pool_ipv6] = apn_index;
+          config_pP->num_ue_pool_ipv6 += 1;
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "CONFIG POOL ADDR IPV6: BAD PREFIX LENGTH: %d\n", prefix_len);
+        }
+      }
+      bstrListDestroy(list);
+      bdestroy_wrapper (&cidr);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void pgw_config_parse_ip_address_pool (pgw_config_t * config_pP, const config_setting_t * const setting)
+{
+  config_setting_t                       *subsetting = NULL;
+  config_setting_t                       *sub2setting = NULL;
+  const char                             *astring = NULL;
+  const char                             *imsi = NULL;
+  const char                             *ipv4 = NULL;
+
+  subsetting = config_setting_get_member (setting, PGW_CONFIG_STRING_IPV4_ADDRESS_LIST);
+  if (subsetting) {
+    pgw_config_parse_ipv4_pool_list (config_pP, subsetting, 0);
+  } else {
+    OAILOG_WARNING (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: NO IPV4 ADDRESS FOUND\n");
+  }
+  subsetting = config_setting_get_member (setting, PGW_CONFIG_STRING_IPV6_ADDRESS_LIST);
+  if (subsetting) {
+    pgw_config_parse_ipv6_pool_list (config_pP, subsetting, 0);
+  }
+
+  subsetting = config_setting_get_member (setting, PGW_CONFIG_STRING_APN_POOL_LIST);
+  if (subsetting) {
+    for (int i = 0; i < config_setting_length (subsetting); i++) {
+      config_setting_t *apn_setting = config_setting_get_elem (subsetting, i);
+
+      AssertFatal(config_setting_lookup_string (apn_setting, PGW_CONFIG_STRING_APN_POOL_NAME, &astring),
+          "Missing %s in %s entry %d", PGW_CONFIG_STRING_APN_POOL_NAME, PGW_CONFIG_STRING_APN_POOL_LIST, i);
+      AssertFatal(config_pP->num_ue_pool_apn < PGW_NUM_UE_POOL_APN_MAX, "Too many APN pools (max %d)", PGW_NUM_UE_POOL_APN_MAX - 1);
+      const int apn_index = config_pP->num_ue_pool_apn++;
+      config_pP->ue_pool_apn_name[apn_index] = bfromcstr (astring);
+
+      sub2setting = config_setting_get_member (apn_setting, PGW_CONFIG_STRING_IPV4_ADDRESS_LIST);
+      if (sub2setting) {
+        pgw_config_parse_ipv4_pool_list (config_pP, sub2setting, apn_index);
+      }
+      sub2setting = config_setting_get_member (apn_setting, PGW_CONFIG_STRING_IPV6_ADDRESS_LIST);
+      if (sub2setting) {
+        pgw_config_parse_ipv6_pool_list (config_pP, sub2setting, apn_index);
+      }
+    }
+  }
+
+  subsetting = config_setting_get_member (setting, PGW_CONFIG_STRING_STATIC_IPV4_LIST);
+  if (subsetting) {
+    const int num = config_setting_length (subsetting);
+
+    config_pP->ue_static_ipv4 = calloc (num ? num : 1, sizeof (conf_static_ipv4_t));
+    for (int i = 0; i < num; i++) {
+      config_setting_t *static_setting = config_setting_get_elem (subsetting, i);
+      conf_static_ipv4_t *conf_static = &config_pP->ue_static_ipv4[config_pP->num_ue_static_ipv4];
+
+      if ((config_setting_lookup_string (static_setting, PGW_CONFIG_STRING_STATIC_IMSI, &imsi))
+          && (config_setting_lookup_string (static_setting, PGW_CONFIG_STRING_STATIC_IPV4, &ipv4))
+          && (inet_pton (AF_INET, ipv4, &conf_static->addr) == 1)) {
+        conf_static->imsi = bfromcstr (imsi);
+        if (config_setting_lookup_string (static_setting, PGW_CONFIG_STRING_APN_POOL_NAME, &astring)) {
+          conf_static->apn = bfromcstr (astring);
+        }
+        config_pP->num_ue_static_ipv4 += 1;
+      } else {
+        OAILOG_ERROR (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: BAD STATIC ADDRESS ENTRY %d\n", i);
+      }
+    }
+  }
+
+  if (config_setting_lookup_string (setting, PGW_CONFIG_STRING_POOL_PERSISTENCE_FILE, &astring)) {
+    config_pP->ue_pool_persistence_file = bfromcstr (astring);
+  }
+}
+
 //------------------------------------------------------------------------------
 int pgw_config_parse_file (pgw_config_t * config_pP)
 {
@@ -213,16 +349,10 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
   char                                   *default_dns = NULL;
   char                                   *default_dns_sec = NULL;
   const char                             *astring = NULL;
-  bstring                                 address = NULL;
-  bstring                                 cidr = NULL;
-  bstring                                 mask = NULL;
   int                                     num = 0;
   int                                     i = 0;
-  unsigned char                           buf_in_addr[sizeof (struct in_addr)];
-  struct in_addr                          addr_start;
   bstring                                 system_cmd = NULL;
   libconfig_int                           mtu = 0;
-  int                                     prefix_mask = 0;
 
 
   config_init (&cfg);
@@ -287,42 +417,7 @@ int pgw_config_parse_file (pgw_config_t * config_pP)
     subsetting = config_setting_get_member (setting_pgw, PGW_CONFIG_STRING_IP_ADDRESS_POOL);
 
     if (subsetting) {
-      sub2setting = config_setting_get_member (subsetting, PGW_CONFIG_STRING_IPV4_ADDRESS_LIST);
-
-      if (sub2setting) {
-        num = config_setting_length (sub2setting);
-
-        for (i = 0; i < num; i++) {
-          astring = config_setting_get_string_elem (sub2setting, i);
-
-          if (astring) {
-            cidr = bfromcstr (astring);
-            AssertFatal(BSTR_OK == btrimws(cidr), "Error in PGW_CONFIG_STRING_IPV4_ADDRESS_LIST %s", astring);
-            struct bstrList *list = bsplit (cidr, PGW_CONFIG_STRING_IPV4_PREFIX_DELIMITER);
-            AssertFatal(2 == list->qty, "Bad CIDR address %s", bdata(cidr));
-
-            address = list->entry[0];
-            mask    = list->entry[1];
-
-            if (inet_pton (AF_INET, bdata(address), buf_in_addr) == 1) {
-              memcpy (&addr_start, buf_in_addr, sizeof (struct in_addr));
-              // valid address
-              prefix_mask = atoi ((const char *)mask->data);
-
-              if ((prefix_mask >= 2) && (prefix_mask < 32) && (config_pP->num_ue_pool < PGW_NUM_UE_POOL_MAX)) {
-                memcpy (&config_pP->ue_pool_addr[config_pP->num_ue_pool], buf_in_addr, sizeof (struct in_addr));
-                config_pP->ue_pool_mask[config_pP->num_ue_pool] = prefix_mask;
-                config_pP->num_ue_pool += 1;
-              } else {
-                OAILOG_ERROR (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: BAD MASQ: %d\n", prefix_mask);
-              }
-            }
-            bstrListDestroy(list);
-          }
-        }
-      } else {
-        OAILOG_WARNING (LOG_SPGW_APP, "CONFIG POOL ADDR IPV4: NO IPV4 ADDRESS FOUND\n");
-      }
+      pgw_config_parse_ip_address_pool (config_pP, subsetting);
 
       if (config_setting_lookup_string (setting_pgw, PGW_CONFIG_STRING_DEFAULT_DNS_IPV4_ADDRESS, (const char **)&default_dns)
           && config_setting_lookup_string (setting_pgw, PGW_CONFIG_STRING_DEFAULT_DNS_SEC_IPV4_ADDRESS, (const char **)&default_dns_sec)) {
@@ -458,6 +553,19 @@ void pgw_config_display (pgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "    SGi MTU (read)........: %u\n", config_p->ipv4.mtu_SGI);
   OAILOG_INFO (LOG_SPGW_APP, "    User TCP MSS clamping : %s\n", config_p->ue_tcp_mss_clamp == 0 ? "false" : "true");
   OAILOG_INFO (LOG_SPGW_APP, "    User IP masquerading  : %s\n", config_p->masquerade_SGI == 0 ? "false" : "true");
+  OAILOG_INFO (LOG_SPGW_APP, "- UE IP address pools:\n");
+  for (int i = 0; i < config_p->num_ue_pool; i++) {
+    OAILOG_INFO (LOG_SPGW_APP, "    IPv4 pool ............: %s/%u APN %s\n", inet_ntoa (config_p->ue_pool_addr[i]), config_p->ue_pool_mask[i],
+        config_p->ue_pool_apn[i] ? bdata(config_p->ue_pool_apn_name[config_p->ue_pool_apn[i]]) : "(default)");
+  }
+  for (int i = 0; i < config_p->num_ue_pool_ipv6; i++) {
+    char ipv6[INET6_ADDRSTRLEN];
+    inet_ntop (AF_INET6, &config_p->ue_pool_ipv6_addr[i], ipv6, INET6_ADDRSTRLEN);
+    OAILOG_INFO (LOG_SPGW_APP, "    IPv6 pool ............: %s/%u APN %s\n", ipv6, config_p->ue_pool_ipv6_prefix_len[i],
+        config_p->ue_pool_ipv6_apn[i] ? bdata(config_p->ue_pool_apn_name[config_p->ue_pool_ipv6_apn[i]]) : "(default)");
+  }
+  OAILOG_INFO (LOG_SPGW_APP, "    Static IPv4 addresses : %d\n", config_p->num_ue_static_ipv4);
+  OAILOG_INFO (LOG_SPGW_APP, "    Persistence file .....: %s\n", config_p->ue_pool_persistence_file ? bdata(config_p->ue_pool_persistence_file) : "none");
   if (config_p->use_gtp_kernel_module) {
     OAILOG_INFO (LOG_SPGW_APP, "- GTPv1U .................: Enabled (Linux kernel module)\n");
     OAILOG_INFO (LOG_SPGW_APP, "    Load/unload module....: %s\n", (config_p->enable_loading_gtp_kernel_module) ? "enabled" : "disabled");
@@ -46,6 +46,13 @@
 #define PGW_CONFIG_STRING_IP_ADDRESS_POOL                       "IP_ADDRESS_POOL"
 #define PGW_CONFIG_STRING_IPV4_ADDRESS_LIST                     "IPV4_LIST"
 #define PGW_CONFIG_STRING_IPV4_PREFIX_DELIMITER                 '/'
+#define PGW_CONFIG_STRING_IPV6_ADDRESS_LIST                     "IPV6_LIST"
+#define PGW_CONFIG_STRING_APN_POOL_LIST                         "APN_LIST"
+#define PGW_CONFIG_STRING_APN_POOL_NAME                         "APN"
+#define PGW_CONFIG_STRING_STATIC_IPV4_LIST                      "STATIC_IPV4_LIST"
+#define PGW_CONFIG_STRING_STATIC_IMSI                           "IMSI"
+#define PGW_CONFIG_STRING_STATIC_IPV4                           "IPV4"
+#define PGW_CONFIG_STRING_POOL_PERSISTENCE_FILE                 "PERSISTENCE_FILE"
 #define PGW_CONFIG_STRING_DEFAULT_DNS_IPV4_ADDRESS              "DEFAULT_DNS_IPV4_ADDRESS"
 #define PGW_CONFIG_STRING_DEFAULT_DNS_SEC_IPV4_ADDRESS          "DEFAULT_DNS_SEC_IPV4_ADDRESS"
 #define PGW_CONFIG_STRING_UE_MTU                                "UE_MTU"
@@ -73,10 +80,12 @@
 #define PGW_MAX_ALLOCATED_PDN_ADDRESSES 1024
 
 
-typedef struct conf_ipv4_list_elm_s {
-  STAILQ_ENTRY(conf_ipv4_list_elm_s) ipv4_entries;
+// IMSI -> IPv4 address reservation
+typedef struct conf_static_ipv4_s {
+  bstring         imsi;
+  bstring         apn;   // NULL: any APN
   struct in_addr  addr;
-} conf_ipv4_list_elm_t;
+} conf_static_ipv4_t;
 
 
 
@@ -111,6 +120,22 @@ typedef struct pgw_config_s {
 #define PGW_NUM_UE_POOL_MAX 16
   uint8_t          ue_pool_mask[PGW_NUM_UE_POOL_MAX];
   struct in_addr   ue_pool_addr[PGW_NUM_UE_POOL_MAX];
+  int              ue_pool_apn[PGW_NUM_UE_POOL_MAX];               // index in ue_pool_apn_name
+
+  int              num_ue_pool_ipv6;
+#define PGW_NUM_UE_POOL_IPV6_MAX 16
+  uint8_t          ue_pool_ipv6_prefix_len[PGW_NUM_UE_POOL_IPV6_MAX];
+  struct in6_addr  ue_pool_ipv6_addr[PGW_NUM_UE_POOL_IPV6_MAX];
+  int              ue_pool_ipv6_apn[PGW_NUM_UE_POOL_IPV6_MAX];     // index in ue_pool_apn_name
+
+  // APNs having their own pools, index 0 is the default pools (no name)
+  int              num_ue_pool_apn;
+#define PGW_NUM_UE_POOL_APN_MAX 16
+  bstring          ue_pool_apn_name[PGW_NUM_UE_POOL_APN_MAX];
+
+  int                 num_ue_static_ipv4;
+  conf_static_ipv4_t *ue_static_ipv4;
+  bstring             ue_pool_persistence_file;
 
   bool      force_push_pco;
   uint16_t  ue_mtu;
@@ -127,13 +152,12 @@ typedef struct pgw_config_s {
     uint64_t  apn_ambr_ul;
     uint64_t  apn_ambr_dl;
   } pcef;
-
-  STAILQ_HEAD(ipv4_pool_head_s, conf_ipv4_list_elm_s) ipv4_pool_list;
 } pgw_config_t;
 
 
 int pgw_config_process(pgw_config_t* config_pP);
 void pgw_config_init(pgw_config_t* config_pP);
+void pgw_config_exit(pgw_config_t* config_pP);
 int pgw_config_parse_file (pgw_config_t * config_pP);
 void pgw_config_display (pgw_config_t * config_p);
 
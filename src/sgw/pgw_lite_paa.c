@@ -25,10 +25,14 @@
   \company Eurecom
   \email: lionel.gauthier@eurecom.fr
 */
+#include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <inttypes.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -40,104 +44,878 @@
 #include "assertions.h"
 #include "conversions.h"
 #include "hashtable.h"
-#include "obj_hashtable.h"
 #include "common_defs.h"
-#include "intertask_interface.h"
-#include "msc.h"
+#include "common_types.h"
 #include "log.h"
-#include "sgw_ie_defs.h"
-#include "3gpp_23.401.h"
-#include "sgw_defs.h"
-#include "spgw_config.h"
-#include "sgw.h"
+#include "pgw_config.h"
 #include "pgw_lite_paa.h"
 
+#define PGW_PAA_POOL_MAX                (PGW_NUM_UE_POOL_MAX + PGW_NUM_UE_POOL_IPV6_MAX)
+#define PGW_PAA_RELEASED_RING_MIN_SIZE  1024
+#define PGW_PAA_APN_ANY                 PGW_NUM_UE_POOL_APN_MAX    // APN index of the reservations valid for any APN
+// Journal compacted when it holds twice as many records as live allocations, and at least this many
+#define PGW_PAA_JOURNAL_COMPACT_MIN_RECORDS  65536
+#define PGW_PAA_BINDING_KEY(iMSI64, aPNiNDEX, fAMILY) \
+  ((((hash_key_t)(iMSI64)) << 8) | (((hash_key_t)(aPNiNDEX)) << 1) | ((fAMILY) == AF_INET6 ? 1 : 0))
 
-//#define PGW_LITE_FREE_ADDR_POOL_CONFIG 1
+typedef struct pgw_paa_pool_s {
+  int              family;          // AF_INET or AF_INET6
+  int              apn_index;       // index in pgw_paa.apn_name, 0 for the default pools
+  uint32_t         first_ipv4;      // first address, host byte order
+  uint64_t         first_ipv6;      // 64 high bits of the first /64 prefix
+  uint32_t         nb_entries;      // addresses or /64 prefixes
+  uint32_t         nb_allocated;
+  uint32_t         next_fresh;      // entries >= next_fresh have never been allocated from the pool
+  // FIFO ring of the released entries < next_fresh, grows up to next_fresh
+  uint32_t        *released;
+  uint32_t         released_size;
+  uint32_t         released_head;
+  uint32_t         nb_released;
+  uint64_t        *allocated;       // bitmap
+  uint64_t        *reserved;        // bitmap of the static addresses
+} pgw_paa_pool_t;
 
-extern pgw_app_t                        pgw_app;
+// Static reservation, or allocation restored from the persistence backend
+typedef struct pgw_paa_binding_s {
+  imsi64_t         imsi64;
+  int              family;
+  union {
+    struct in_addr   ipv4;
+    struct in6_addr  ipv6;
+  } address;
+  pgw_paa_pool_t  *pool;            // NULL if the address is out of the pools
+  uint32_t         index;           // in pool
+  bool             is_static;
+  bool             in_use;
+} pgw_paa_binding_t;
 
+typedef struct pgw_paa_s {
+  int                     nb_pools;
+  pgw_paa_pool_t          pools[PGW_PAA_POOL_MAX];
+  int                     nb_apns;
+  bstring                 apn_name[PGW_NUM_UE_POOL_APN_MAX];
+  uint32_t                apn_has_pool[2];    // bitmap of APN indexes having pools, IPv4 and IPv6
+  hash_table_t           *bindings;           // pgw_paa_binding_t by PGW_PAA_BINDING_KEY
+  uint32_t                nb_restored_idle;   // restored bindings not claimed by their UE yet
+  time_t                  restored_deadline;  // they are released to the pools after this time
+  pgw_paa_persistence_t   persistence;
+} pgw_paa_t;
 
-// Load in PGW pool, configured PAA address pool
-void
-pgw_load_pool_ip_addresses (
-  void)
+// Append-only journal of "+|- <imsi> <address>" lines
+typedef struct pgw_paa_journal_s {
+  FILE                   *file;
+  bstring                 file_name;
+  uint32_t                nb_records;         // lines in the file
+  uint32_t                nb_live;            // allocations in the file
+  uint32_t                compact_at;         // nb_records triggering a compaction
+} pgw_paa_journal_t;
+
+static pgw_paa_t                        pgw_paa = {0};
+
+#define PGW_PAA_BIT_TEST(bITMAP, iNDEX)   (((bITMAP)[(iNDEX) >> 6] >> ((iNDEX) & 63)) & 1)
+#define PGW_PAA_BIT_SET(bITMAP, iNDEX)    (bITMAP)[(iNDEX) >> 6] |= (UINT64_C(1) << ((iNDEX) & 63))
+#define PGW_PAA_BIT_CLEAR(bITMAP, iNDEX)  (bITMAP)[(iNDEX) >> 6] &= ~(UINT64_C(1) << ((iNDEX) & 63))
+
+//------------------------------------------------------------------------------
+static uint64_t pgw_paa_ipv6_high (const struct in6_addr * const addr)
+{
+  uint64_t high = 0;
+
+  for (int i = 0; i < 8; i++) {
+    high = (high << 8) | addr->s6_addr[i];
+  }
+  return high;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_ipv6_prefix (const uint64_t high, struct in6_addr * const addr)
+{
+  memset (addr, 0, sizeof (*addr));
+  for (int i = 0; i < 8; i++) {
+    addr->s6_addr[i] = (uint8_t)(high >> (56 - 8 * i));
+  }
+}
+
+//------------------------------------------------------------------------------
+static int pgw_paa_pool_create (pgw_paa_pool_t * const pool, const int family, const int apn_index, const uint32_t nb_entries)
+{
+  const size_t nb_words = (nb_entries + 63) >> 6;
+
+  memset (pool, 0, sizeof (*pool));
+  pool->family = family;
+  pool->apn_index = apn_index;
+  pool->nb_entries = nb_entries;
+  pool->released_size = (nb_entries < PGW_PAA_RELEASED_RING_MIN_SIZE) ? nb_entries : PGW_PAA_RELEASED_RING_MIN_SIZE;
+  pool->released = calloc (pool->released_size, sizeof (uint32_t));
+  pool->allocated = calloc (nb_words, sizeof (uint64_t));
+  pool->reserved = calloc (nb_words, sizeof (uint64_t));
+  if ((!pool->released) || (!pool->allocated) || (!pool->reserved)) {
+    free_wrapper ((void**)&pool->released);
+    free_wrapper ((void**)&pool->allocated);
+    free_wrapper ((void**)&pool->reserved);
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_pool_destroy (pgw_paa_pool_t * const pool)
+{
+  free_wrapper ((void**)&pool->released);
+  free_wrapper ((void**)&pool->allocated);
+  free_wrapper ((void**)&pool->reserved);
+  memset (pool, 0, sizeof (*pool));
+}
+
+//------------------------------------------------------------------------------
+static bool pgw_paa_pool_alloc (pgw_paa_pool_t * const pool, uint32_t * const index)
+{
+  uint32_t                                i = 0;
+
+  // Each entry is passed once by next_fresh, skipping the restored and static ones
+  while (pool->next_fresh < pool->nb_entries) {
+    i = pool->next_fresh++;
+    if (!PGW_PAA_BIT_TEST (pool->allocated, i) && !PGW_PAA_BIT_TEST (pool->reserved, i)) {
+      goto found;
+    }
+  }
+  if (pool->nb_released) {
+    i = pool->released[pool->released_head];
+    pool->released_head = (pool->released_head + 1) % pool->released_size;
+    pool->nb_released--;
+    goto found;
+  }
+  return false;
+
+found:
+  PGW_PAA_BIT_SET (pool->allocated, i);
+  pool->nb_allocated++;
+  *index = i;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_pool_free (pgw_paa_pool_t * const pool, const uint32_t index)
+{
+  PGW_PAA_BIT_CLEAR (pool->allocated, index);
+  pool->nb_allocated--;
+  if (index >= pool->next_fresh) {
+    // will be found by next_fresh
+    return;
+  }
+  if (pool->nb_released == pool->released_size) {
+    // Grow the ring, it never holds more than next_fresh entries
+    uint32_t  size = pool->released_size * 2;
+    uint32_t *released = NULL;
+
+    if (size > pool->nb_entries) {
+      size = pool->nb_entries;
+    }
+    released = malloc (size * sizeof (uint32_t));
+    AssertFatal (released, "Cannot grow released ring of UE IP pool (%u entries)", size);
+    for (uint32_t i = 0; i < pool->nb_released; i++) {
+      released[i] = pool->released[(pool->released_head + i) % pool->released_size];
+    }
+    free_wrapper ((void**)&pool->released);
+    pool->released = released;
+    pool->released_size = size;
+    pool->released_head = 0;
+  }
+  pool->released[(pool->released_head + pool->nb_released) % pool->released_size] = index;
+  pool->nb_released++;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_pool_address (const pgw_paa_pool_t * const pool, const uint32_t index, void * const address)
+{
+  if (AF_INET == pool->family) {
+    ((struct in_addr *)address)->s_addr = htonl (pool->first_ipv4 + index);
+  } else {
+    pgw_paa_ipv6_prefix (pool->first_ipv6 + index, (struct in6_addr *)address);
+  }
+}
+
+//------------------------------------------------------------------------------
+static pgw_paa_pool_t *pgw_paa_find_pool (const int family, const void * const address, uint32_t * const index)
+{
+  for (int i = 0; i < pgw_paa.nb_pools; i++) {
+    pgw_paa_pool_t *pool = &pgw_paa.pools[i];
+    uint64_t        offset = 0;
+
+    if (pool->family != family) {
+      continue;
+    }
+    if (AF_INET == family) {
+      offset = (uint32_t)(ntohl (((const struct in_addr *)address)->s_addr) - pool->first_ipv4);
+    } else {
+      offset = pgw_paa_ipv6_high ((const struct in6_addr *)address) - pool->first_ipv6;
+    }
+    if (offset < pool->nb_entries) {
+      *index = (uint32_t)offset;
+      return pool;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static int pgw_paa_apn_index (const char * const apn)
+{
+  if ((apn) && (apn[0])) {
+    for (int i = 1; i < pgw_paa.nb_apns; i++) {
+      if (1 == biseqcstrcaseless (pgw_paa.apn_name[i], apn)) {
+        return i;
+      }
+    }
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static pgw_paa_binding_t *pgw_paa_get_binding (const hash_key_t key)
+{
+  pgw_paa_binding_t *binding = NULL;
+
+  if ((pgw_paa.bindings->num_elements) && (HASH_TABLE_OK == hashtable_get (pgw_paa.bindings, key, (void **)&binding))) {
+    return binding;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Binding in use with this address, whatever its APN
+static pgw_paa_binding_t *pgw_paa_find_binding (const imsi64_t imsi64, const int family, const void * const address, hash_key_t * const key)
+{
+  const size_t addr_size = (AF_INET == family) ? sizeof (struct in_addr) : sizeof (struct in6_addr);
+
+  if (!pgw_paa.bindings->num_elements) {
+    return NULL;
+  }
+  for (int apn_index = 0; apn_index <= PGW_PAA_APN_ANY; apn_index++) {
+    if ((apn_index >= pgw_paa.nb_apns) && (apn_index != PGW_PAA_APN_ANY)) {
+      continue;
+    }
+    pgw_paa_binding_t *binding = pgw_paa_get_binding (PGW_PAA_BINDING_KEY (imsi64, apn_index, family));
+
+    if ((binding) && (binding->in_use) && (0 == memcmp (&binding->address, address, addr_size))) {
+      *key = PGW_PAA_BINDING_KEY (imsi64, apn_index, family);
+      return binding;
+    }
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_save (const bool allocated, const imsi64_t imsi64, const int family, const void * const address)
+{
+  if (pgw_paa.persistence.save) {
+    pgw_paa.persistence.save (pgw_paa.persistence.context, allocated, imsi64, family, address);
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool pgw_paa_collect_idle_restored (hash_key_t key, void *element, void *parameter, void **result)
+{
+  pgw_paa_binding_t                      *binding = (pgw_paa_binding_t *)element;
+  hash_key_t                             *keys = (hash_key_t *)parameter;
+  uint32_t                               *nb_keys = (uint32_t *)result;
+
+  if ((!binding->is_static) && (!binding->in_use) && (*nb_keys < pgw_paa.nb_restored_idle)) {
+    keys[(*nb_keys)++] = key;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Give the restored addresses that their UE did not claim back to the pools
+static void pgw_paa_release_idle_restored (void)
+{
+  hash_key_t                             *keys = NULL;
+  uint32_t                                nb_keys = 0;
+
+  if (!pgw_paa.nb_restored_idle) {
+    return;
+  }
+  keys = calloc (pgw_paa.nb_restored_idle, sizeof (hash_key_t));
+  AssertFatal (keys, "Cannot release %u restored UE IP addresses", pgw_paa.nb_restored_idle);
+  hashtable_apply_callback_on_elements (pgw_paa.bindings, pgw_paa_collect_idle_restored, keys, (void **)&nb_keys);
+  for (uint32_t i = 0; i < nb_keys; i++) {
+    pgw_paa_binding_t *binding = pgw_paa_get_binding (keys[i]);
+
+    pgw_paa_pool_free (binding->pool, binding->index);
+    pgw_paa_save (false, binding->imsi64, binding->family, &binding->address);
+    hashtable_free (pgw_paa.bindings, keys[i]);
+  }
+  free_wrapper ((void**)&keys);
+  OAILOG_INFO (LOG_SPGW_APP, "Released %u restored UE IP addresses not claimed by their UE\n", nb_keys);
+  pgw_paa.nb_restored_idle = 0;
+}
+
+//------------------------------------------------------------------------------
+static int pgw_paa_allocate (const imsi64_t imsi64, const char * const apn, const int family, void * const address)
+{
+  int                                     apn_index = pgw_paa_apn_index (apn);
+  int                                     pool_apn_index = apn_index;
+  pgw_paa_binding_t                      *binding = NULL;
+  uint32_t                                index = 0;
+
+  if ((pgw_paa.nb_restored_idle) && (time (NULL) >= pgw_paa.restored_deadline)) {
+    pgw_paa_release_idle_restored ();
+  }
+  // APN without pool of this family, served by the default pool
+  if (!(pgw_paa.apn_has_pool[AF_INET6 == family] & (1 << apn_index))) {
+    pool_apn_index = 0;
+  }
+  // Reserved address of the UE first, then restored address (keyed by the APN index of its pool)
+  binding = pgw_paa_get_binding (PGW_PAA_BINDING_KEY (imsi64, apn_index, family));
+  if (((!binding) || (binding->in_use)) && (pool_apn_index != apn_index)) {
+    binding = pgw_paa_get_binding (PGW_PAA_BINDING_KEY (imsi64, pool_apn_index, family));
+  }
+  if ((!binding) || (binding->in_use)) {
+    binding = pgw_paa_get_binding (PGW_PAA_BINDING_KEY (imsi64, PGW_PAA_APN_ANY, family));
+  }
+  if ((binding) && (!binding->in_use)) {
+    binding->in_use = true;
+    if ((binding->is_static) && (binding->pool)) {
+      PGW_PAA_BIT_SET (binding->pool->allocated, binding->index);
+      binding->pool->nb_allocated++;
+    } else if (!binding->is_static) {
+      pgw_paa.nb_restored_idle--;
+    }
+    memcpy (address, &binding->address, (AF_INET == family) ? sizeof (struct in_addr) : sizeof (struct in6_addr));
+    pgw_paa_save (true, imsi64, family, address);
+    return RETURNok;
+  }
+
+  for (int retry = 0; retry < 2; retry++) {
+    for (int i = 0; i < pgw_paa.nb_pools; i++) {
+      pgw_paa_pool_t *pool = &pgw_paa.pools[i];
+
+      if ((pool->family == family) && (pool->apn_index == pool_apn_index) && (pgw_paa_pool_alloc (pool, &index))) {
+        pgw_paa_pool_address (pool, index, address);
+        pgw_paa_save (true, imsi64, family, address);
+        return RETURNok;
+      }
+    }
+    // Pools exhausted, the addresses still held for UEs that did not come back are needed now
+    if (!pgw_paa.nb_restored_idle) {
+      break;
+    }
+    pgw_paa_release_idle_restored ();
+  }
+  return RETURNerror;
+}
+
+//------------------------------------------------------------------------------
+static int pgw_paa_release (const imsi64_t imsi64, const int family, const void * const address)
+{
+  pgw_paa_pool_t                         *pool = NULL;
+  pgw_paa_binding_t                      *binding = NULL;
+  uint32_t                                index = 0;
+  hash_key_t                              key = 0;
+
+  pool = pgw_paa_find_pool (family, address, &index);
+  binding = pgw_paa_find_binding (imsi64, family, address, &key);
+  if (binding) {
+    binding->in_use = false;
+    if (binding->is_static) {
+      if (pool) {
+        PGW_PAA_BIT_CLEAR (pool->allocated, index);
+        pool->nb_allocated--;
+      }
+    } else {
+      // restored allocation, back to the pool
+      hashtable_free (pgw_paa.bindings, key);
+      pgw_paa_pool_free (pool, index);
+    }
+  } else if ((pool) && (PGW_PAA_BIT_TEST (pool->allocated, index)) && (!PGW_PAA_BIT_TEST (pool->reserved, index))) {
+    pgw_paa_pool_free (pool, index);
+  } else {
+    return RETURNerror;
+  }
+  pgw_paa_save (false, imsi64, family, address);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int pgw_restore_paa_address (const imsi64_t imsi64, const int family, const void * const address)
+{
+  pgw_paa_pool_t                         *pool = NULL;
+  pgw_paa_binding_t                      *binding = NULL;
+  uint32_t                                index = 0;
+  hash_key_t                              key = 0;
+
+  pool = pgw_paa_find_pool (family, address, &index);
+  if ((!pool) || (PGW_PAA_BIT_TEST (pool->allocated, index)) || (PGW_PAA_BIT_TEST (pool->reserved, index))) {
+    return RETURNerror;
+  }
+  key = PGW_PAA_BINDING_KEY (imsi64, pool->apn_index, family);
+  if (pgw_paa_get_binding (key)) {
+    return RETURNerror;
+  }
+  binding = calloc (1, sizeof (*binding));
+  binding->imsi64 = imsi64;
+  binding->family = family;
+  binding->pool = pool;
+  binding->index = index;
+  pgw_paa_pool_address (pool, index, &binding->address);
+  hashtable_insert (pgw_paa.bindings, key, binding);
+  PGW_PAA_BIT_SET (pool->allocated, index);
+  pool->nb_allocated++;
+  pgw_paa.nb_restored_idle++;
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// Undo a restored allocation not in use
+static void pgw_paa_forget (const imsi64_t imsi64, const int family, const void * const address)
 {
-  struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
-  //struct conf_ipv6_list_elm_s   *conf_ipv6_p = NULL;
-  //struct ipv6_list_elm_s        *ipv6_p = NULL;
-  //char                           print_buffer[INET6_ADDRSTRLEN];
+  pgw_paa_pool_t                         *pool = NULL;
+  pgw_paa_binding_t                      *binding = NULL;
+  uint32_t                                index = 0;
+  hash_key_t                              key = 0;
 
-  STAILQ_INIT (&pgw_app.ipv4_list_free);
-  STAILQ_INIT (&pgw_app.ipv4_list_allocated);
-  STAILQ_FOREACH (conf_ipv4_p, &spgw_config.pgw_config.ipv4_pool_list, ipv4_entries) {
-    ipv4_p = calloc (1, sizeof (struct ipv4_list_elm_s));
-    ipv4_p->addr.s_addr = conf_ipv4_p->addr.s_addr;
-    STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
-    //SPGW_APP_DEBUG("Loaded IPv4 PAA address in pool: %s\n",
-    //        inet_ntoa(conf_ipv4_p->addr));
+  pool = pgw_paa_find_pool (family, address, &index);
+  if (pool) {
+    key = PGW_PAA_BINDING_KEY (imsi64, pool->apn_index, family);
+    binding = pgw_paa_get_binding (key);
+    if ((binding) && (!binding->is_static) && (!binding->in_use) && (binding->index == index)) {
+      hashtable_free (pgw_paa.bindings, key);
+      pgw_paa_pool_free (pool, index);
+      pgw_paa.nb_restored_idle--;
+    }
   }
+}
 
-//  STAILQ_FOREACH (conf_ipv6_p, &spgw_config.pgw_config.pgw_lite_ipv6_pool_list, ipv6_entries) {
-//    ipv6_p = calloc (1, sizeof (struct pgw_lite_ipv6_list_elm_s));
-//    ipv6_p->addr = conf_ipv6_p->addr;
-//    ipv6_p->prefix_len = conf_ipv6_p->prefix_len;
-//    ipv6_p->num_allocated = 0;
-//    STAILQ_INSERT_TAIL (&pgw_app.pgw_lite_ipv6_list_free, ipv6_p, ipv6_entries);
-//
-//    if (inet_ntop (AF_INET6, &ipv6_p->addr, print_buffer, INET6_ADDRSTRLEN) == NULL) {
-//      OAILOG_ERROR (LOG_SPGW_APP, "Could not Load IPv6 PAA address in pool: %s\n", strerror (errno));
-//    }                           /*else {
-//                                 *
-//                                 * SPGW_APP_DEBUG("Loaded IPv6 PAA prefix in pool: %s\n",print_buffer);
-//                                 * } */
-//  }
-#if PGW_LITE_FREE_ADDR_POOL_CONFIG
+//------------------------------------------------------------------------------
+// Persistence in an append-only journal, compacted at init and when it grows twice as large as needed
+static bool pgw_paa_journal_write_record (FILE * const file, const bool allocated, const imsi64_t imsi64, const int family, const void * const address)
+{
+  char                                    str[INET6_ADDRSTRLEN];
 
-  while ((conf_ipv4_p = STAILQ_FIRST (&spgw_config.pgw_config.ipv4_pool_list))) {
-    STAILQ_REMOVE_HEAD (&spgw_config.pgw_config.ipv4_pool_list, ipv4_entries);
-    free_wrapper ((void **) &conf_ipv4_p);
+  if (inet_ntop (family, address, str, INET6_ADDRSTRLEN)) {
+    return (0 < fprintf (file, "%c "IMSI_64_FMT" %s\n", allocated ? '+' : '-', imsi64, str));
   }
+  return false;
+}
 
-#endif
+//------------------------------------------------------------------------------
+static bool pgw_paa_journal_read_record (const char * const line, char * const op, imsi64_t * const imsi64, int * const family, struct in6_addr * const address)
+{
+  char                                    str[INET6_ADDRSTRLEN];
+
+  if (3 != sscanf (line, "%c %"SCNu64" %45s", op, imsi64, str)) {
+    return false;
+  }
+  if (inet_pton (AF_INET, str, address) == 1) {
+    *family = AF_INET;
+  } else if (inet_pton (AF_INET6, str, address) == 1) {
+    *family = AF_INET6;
+  } else {
+    return false;
+  }
+  return true;
 }
 
+//------------------------------------------------------------------------------
+// Live allocation of the journal, while compacting it
+typedef struct pgw_paa_journal_record_s {
+  imsi64_t         imsi64;
+  int              family;
+  struct in6_addr  address;
+} pgw_paa_journal_record_t;
 
+//------------------------------------------------------------------------------
+static bool pgw_paa_journal_write_live_record (hash_key_t key, void *element, void *parameter, void **result)
+{
+  pgw_paa_journal_record_t               *record = (pgw_paa_journal_record_t *)element;
+
+  if (pgw_paa_journal_write_record ((FILE *)parameter, true, record->imsi64, record->family, &record->address)) {
+    (*(uint32_t *)result)++;
+  }
+  return false;
+}
 
+//------------------------------------------------------------------------------
+// Rewrite the journal with its live allocations, replayed from the file (only the bindings know the IMSIs)
+static int pgw_paa_journal_compact (pgw_paa_journal_t * const journal)
+{
+  hash_table_t                           *live[2] = {NULL, NULL};   // records by address, IPv4 and IPv6
+  FILE                                   *file = NULL;
+  char                                    line[128];
+  char                                    op = 0;
+  imsi64_t                                imsi64 = 0;
+  struct in6_addr                         address;
+  int                                     family = 0;
+  hash_key_t                              key = 0;
+  uint32_t                                nb_live = 0;
+  int                                     rc = RETURNerror;
+  bstring                                 tmp_file_name = bformat ("%s.tmp", bdata(journal->file_name));
+
+  fflush (journal->file);
+  for (int i = 0; i < 2; i++) {
+    bstring b = bformat ("pgw_paa_journal_live_%d", i);
+    live[i] = hashtable_create (journal->nb_live + 1024, NULL, NULL, b);
+    bdestroy_wrapper (&b);
+    if (!live[i]) {
+      goto done;
+    }
+    live[i]->log_enabled = false;
+  }
+  if (!(file = fopen (bdata(journal->file_name), "r"))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot read UE IP pool journal %s: %s\n", bdata(journal->file_name), strerror (errno));
+    goto done;
+  }
+  while (fgets (line, sizeof (line), file)) {
+    if (!pgw_paa_journal_read_record (line, &op, &imsi64, &family, &address)) {
+      continue;
+    }
+    key = (AF_INET == family) ? ntohl (((struct in_addr *)&address)->s_addr) : pgw_paa_ipv6_high (&address);
+    if ('+' == op) {
+      pgw_paa_journal_record_t *record = calloc (1, sizeof (*record));
+
+      if (!record) {
+        fclose (file);
+        goto done;
+      }
+      record->imsi64 = imsi64;
+      record->family = family;
+      memcpy (&record->address, &address, sizeof (address));
+      hashtable_insert (live[AF_INET6 == family], key, record);
+    } else if ('-' == op) {
+      hashtable_free (live[AF_INET6 == family], key);
+    }
+  }
+  fclose (file);
+
+  if (!(file = fopen (bdata(tmp_file_name), "w"))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot write UE IP pool journal %s: %s\n", bdata(tmp_file_name), strerror (errno));
+    goto done;
+  }
+  for (int i = 0; i < 2; i++) {
+    hashtable_apply_callback_on_elements (live[i], pgw_paa_journal_write_live_record, file, (void **)&nb_live);
+  }
+  // The new file stays open at its end, for the next records
+  if ((fflush (file)) || (rename (bdata(tmp_file_name), bdata(journal->file_name)))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot replace UE IP pool journal %s: %s\n", bdata(journal->file_name), strerror (errno));
+    fclose (file);
+    remove (bdata(tmp_file_name));
+    goto done;
+  }
+  fclose (journal->file);
+  journal->file = file;
+  OAILOG_INFO (LOG_SPGW_APP, "UE IP pool journal %s compacted from %u to %u records\n", bdata(journal->file_name), journal->nb_records, nb_live);
+  journal->nb_records = nb_live;
+  journal->nb_live = nb_live;
+  rc = RETURNok;
+
+done:
+  for (int i = 0; i < 2; i++) {
+    if (live[i]) {
+      hashtable_destroy (live[i]);
+    }
+  }
+  bdestroy_wrapper (&tmp_file_name);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_journal_save (void *context, const bool allocated, const imsi64_t imsi64, const int family, const void * const address)
+{
+  pgw_paa_journal_t                      *journal = (pgw_paa_journal_t *)context;
+
+  if (pgw_paa_journal_write_record (journal->file, allocated, imsi64, family, address)) {
+    journal->nb_records++;
+    if (allocated) {
+      journal->nb_live++;
+    } else if (journal->nb_live) {
+      journal->nb_live--;
+    }
+  }
+  fflush (journal->file);
+  if (journal->nb_records >= journal->compact_at) {
+    if (RETURNok == pgw_paa_journal_compact (journal)) {
+      journal->compact_at = 2 * journal->nb_live;
+    } else {
+      // try again later
+      journal->compact_at = journal->nb_records;
+    }
+    if (journal->compact_at < journal->nb_records + PGW_PAA_JOURNAL_COMPACT_MIN_RECORDS) {
+      journal->compact_at = journal->nb_records + PGW_PAA_JOURNAL_COMPACT_MIN_RECORDS;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void pgw_paa_journal_close (void *context)
+{
+  pgw_paa_journal_t                      *journal = (pgw_paa_journal_t *)context;
+
+  fclose (journal->file);
+  bdestroy_wrapper (&journal->file_name);
+  free_wrapper ((void**)&journal);
+}
+
+//------------------------------------------------------------------------------
+static bool pgw_paa_journal_write_binding (hash_key_t key, void *element, void *parameter, void **result)
+{
+  pgw_paa_binding_t                      *binding = (pgw_paa_binding_t *)element;
+
+  if ((!binding->is_static) && (pgw_paa_journal_write_record ((FILE *)parameter, true, binding->imsi64, binding->family, &binding->address))) {
+    (*(uint32_t *)result)++;
+  }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+static int pgw_paa_journal_open (const char * const file_name)
+{
+  pgw_paa_journal_t                      *journal = NULL;
+  FILE                                   *file = NULL;
+  char                                    line[128];
+  char                                    op = 0;
+  imsi64_t                                imsi64 = 0;
+  struct in6_addr                         address;
+  int                                     family = 0;
+  uint32_t                                nb_live = 0;
+
+  if ((file = fopen (file_name, "r"))) {
+    while (fgets (line, sizeof (line), file)) {
+      if (!pgw_paa_journal_read_record (line, &op, &imsi64, &family, &address)) {
+        continue;
+      }
+      if ('+' == op) {
+        pgw_restore_paa_address (imsi64, family, &address);
+      } else if ('-' == op) {
+        pgw_paa_forget (imsi64, family, &address);
+      }
+    }
+    fclose (file);
+  } else if (ENOENT != errno) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot read UE IP pool journal %s: %s\n", file_name, strerror (errno));
+    return RETURNerror;
+  }
+  pgw_paa.restored_deadline = time (NULL) + PGW_PAA_RESTORED_HOLD_SEC;
+
+  // Compact: rewrite the restored allocations only
+  bstring tmp_file_name = bformat ("%s.tmp", file_name);
+  if (!(file = fopen (bdata(tmp_file_name), "w"))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot write UE IP pool journal %s: %s\n", bdata(tmp_file_name), strerror (errno));
+    bdestroy_wrapper (&tmp_file_name);
+    return RETURNerror;
+  }
+  hashtable_apply_callback_on_elements (pgw_paa.bindings, pgw_paa_journal_write_binding, file, (void **)&nb_live);
+  fclose (file);
+  if (rename (bdata(tmp_file_name), file_name)) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot rename UE IP pool journal %s: %s\n", bdata(tmp_file_name), strerror (errno));
+    bdestroy_wrapper (&tmp_file_name);
+    return RETURNerror;
+  }
+  bdestroy_wrapper (&tmp_file_name);
+
+  if (!(file = fopen (file_name, "a"))) {
+    OAILOG_ERROR (LOG_SPGW_APP, "Cannot open UE IP pool journal %s: %s\n", file_name, strerror (errno));
+    return RETURNerror;
+  }
+  journal = calloc (1, sizeof (*journal));
+  if (!journal) {
+    fclose (file);
+    return RETURNerror;
+  }
+  journal->file = file;
+  journal->file_name = bfromcstr (file_name);
+  journal->nb_records = nb_live;
+  journal->nb_live = nb_live;
+  journal->compact_at = 2 * nb_live + PGW_PAA_JOURNAL_COMPACT_MIN_RECORDS;
+  pgw_paa_persistence_t persistence = {
+    .context = journal,
+    .save    = pgw_paa_journal_save,
+    .close   = pgw_paa_journal_close,
+  };
+  pgw_set_paa_persistence (&persistence);
+  OAILOG_INFO (LOG_SPGW_APP, "UE IP pool journal %s: %u addresses restored, held %d s for their UE\n", file_name, nb_live, PGW_PAA_RESTORED_HOLD_SEC);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+void pgw_set_paa_persistence (const pgw_paa_persistence_t * const persistence_pP)
+{
+  if (pgw_paa.persistence.close) {
+    pgw_paa.persistence.close (pgw_paa.persistence.context);
+  }
+  if (persistence_pP) {
+    pgw_paa.persistence = *persistence_pP;
+  } else {
+    memset (&pgw_paa.persistence, 0, sizeof (pgw_paa.persistence));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Load in PGW pool, configured PAA address pools
 int
-pgw_get_free_ipv4_paa_address (
-  struct in_addr *const addr_pP)
+pgw_load_pool_ip_addresses (
+  const pgw_config_t * const config_pP)
 {
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
+  pgw_paa_pool_t                         *pool = NULL;
+  pgw_paa_binding_t                      *binding = NULL;
+  uint32_t                                nb_entries = 0;
+  uint32_t                                index = 0;
+  imsi64_t                                imsi64 = 0;
+  int                                     apn_index = 0;
 
-  if (STAILQ_EMPTY (&pgw_app.ipv4_list_free)) {
-    addr_pP->s_addr = INADDR_ANY;
+  memset (&pgw_paa, 0, sizeof (pgw_paa));
+  bstring b = bfromcstr ("pgw_paa_bindings");
+  pgw_paa.bindings = hashtable_create (config_pP->num_ue_static_ipv4 + 1024, NULL, NULL, b);
+  bdestroy_wrapper (&b);
+  if (!pgw_paa.bindings) {
+    return RETURNerror;
+  }
+  pgw_paa.bindings->log_enabled = false;
+
+  pgw_paa.nb_apns = config_pP->num_ue_pool_apn;
+  for (int i = 1; i < pgw_paa.nb_apns; i++) {
+    pgw_paa.apn_name[i] = bstrcpy (config_pP->ue_pool_apn_name[i]);
+  }
+
+  for (int i = 0; i < config_pP->num_ue_pool; i++) {
+    pool = &pgw_paa.pools[pgw_paa.nb_pools];
+    // network address, .1 for the gateway and broadcast address excluded
+    nb_entries = (UINT32_C(1) << (32 - config_pP->ue_pool_mask[i])) - 3;
+    if (pgw_paa_pool_create (pool, AF_INET, config_pP->ue_pool_apn[i], nb_entries)) {
+      pgw_unload_pool_ip_addresses ();
+      return RETURNerror;
+    }
+    pool->first_ipv4 = ntohl (config_pP->ue_pool_addr[i].s_addr) + 2;
+    pgw_paa.apn_has_pool[0] |= (1 << pool->apn_index);
+    pgw_paa.nb_pools++;
+  }
+
+  for (int i = 0; i < config_pP->num_ue_pool_ipv6; i++) {
+    pool = &pgw_paa.pools[pgw_paa.nb_pools];
+    // first /64 prefix left to the gateway
+    if ((PGW_PAA_IPV6_PREFIX_LENGTH - config_pP->ue_pool_ipv6_prefix_len[i]) >= 24) {
+      nb_entries = PGW_PAA_IPV6_POOL_PREFIXES_MAX - 1;
+    } else {
+      nb_entries = (UINT32_C(1) << (PGW_PAA_IPV6_PREFIX_LENGTH - config_pP->ue_pool_ipv6_prefix_len[i])) - 1;
+    }
+    if (pgw_paa_pool_create (pool, AF_INET6, config_pP->ue_pool_ipv6_apn[i], nb_entries)) {
+      pgw_unload_pool_ip_addresses ();
+      return RETURNerror;
+    }
+    pool->first_ipv6 = pgw_paa_ipv6_high (&config_pP->ue_pool_ipv6_addr[i]) + 1;
+    pgw_paa.apn_has_pool[1] |= (1 << pool->apn_index);
+    pgw_paa.nb_pools++;
+  }
+
+  for (int i = 0; i < config_pP->num_ue_static_ipv4; i++) {
+    const conf_static_ipv4_t *conf_static = &config_pP->ue_static_ipv4[i];
+
+    IMSI_STRING_TO_IMSI64 (bdata(conf_static->imsi), &imsi64);
+    apn_index = (conf_static->apn) ? pgw_paa_apn_index (bdata(conf_static->apn)) : PGW_PAA_APN_ANY;
+    pool = pgw_paa_find_pool (AF_INET, &conf_static->addr, &index);
+    if (((pool) && (PGW_PAA_BIT_TEST (pool->reserved, index)))
+        || (pgw_paa_get_binding (PGW_PAA_BINDING_KEY (imsi64, apn_index, AF_INET)))) {
+      OAILOG_ERROR (LOG_SPGW_APP, "Duplicate static IPv4 address %s for IMSI %s\n", inet_ntoa (conf_static->addr), bdata(conf_static->imsi));
+      continue;
+    }
+    binding = calloc (1, sizeof (*binding));
+    binding->imsi64 = imsi64;
+    binding->family = AF_INET;
+    binding->address.ipv4 = conf_static->addr;
+    binding->pool = pool;
+    binding->index = index;
+    binding->is_static = true;
+    hashtable_insert (pgw_paa.bindings, PGW_PAA_BINDING_KEY (imsi64, apn_index, AF_INET), binding);
+    if (pool) {
+      PGW_PAA_BIT_SET (pool->reserved, index);
+    }
+  }
+
+  if ((config_pP->ue_pool_persistence_file) && (pgw_paa_journal_open (bdata(config_pP->ue_pool_persistence_file)))) {
+    pgw_unload_pool_ip_addresses ();
     return RETURNerror;
   }
+  OAILOG_INFO (LOG_SPGW_APP, "Loaded %d UE IP pools, %d static IPv4 addresses\n", pgw_paa.nb_pools, config_pP->num_ue_static_ipv4);
+  return RETURNok;
+}
 
-  ipv4_p = STAILQ_FIRST (&pgw_app.ipv4_list_free);
-  STAILQ_REMOVE (&pgw_app.ipv4_list_free, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-  STAILQ_INSERT_TAIL (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_entries);
-  addr_pP->s_addr = ipv4_p->addr.s_addr;
+//------------------------------------------------------------------------------
+void
+pgw_unload_pool_ip_addresses (
+  void)
+{
+  pgw_set_paa_persistence (NULL);
+  if (pgw_paa.bindings) {
+    hashtable_destroy (pgw_paa.bindings);
+    pgw_paa.bindings = NULL;
+  }
+  for (int i = 0; i < PGW_PAA_POOL_MAX; i++) {
+    pgw_paa_pool_destroy (&pgw_paa.pools[i]);
+  }
+  for (int i = 0; i < PGW_NUM_UE_POOL_APN_MAX; i++) {
+    bdestroy_wrapper (&pgw_paa.apn_name[i]);
+  }
+  pgw_paa.nb_pools = 0;
+  pgw_paa.nb_apns = 0;
+}
+
+//------------------------------------------------------------------------------
+int
+pgw_get_free_ipv4_paa_address (
+  const imsi64_t imsi64,
+  const char * const apn,
+  struct in_addr * const addr_pP)
+{
+  if (RETURNok != pgw_paa_allocate (imsi64, apn, AF_INET, addr_pP)) {
+    addr_pP->s_addr = INADDR_ANY;
+    return RETURNerror;
+  }
   return RETURNok;
 }
 
+//------------------------------------------------------------------------------
 int
 pgw_release_free_ipv4_paa_address (
-  const struct in_addr *const addr_pP)
+  const imsi64_t imsi64,
+  const struct in_addr * const addr_pP)
 {
-  struct ipv4_list_elm_s        *ipv4_p = NULL;
+  return pgw_paa_release (imsi64, AF_INET, addr_pP);
+}
 
-  STAILQ_FOREACH (ipv4_p, &pgw_app.ipv4_list_allocated, ipv4_entries) {
-    if (ipv4_p->addr.s_addr == addr_pP->s_addr) {
-      STAILQ_REMOVE (&pgw_app.ipv4_list_allocated, ipv4_p, ipv4_list_elm_s, ipv4_entries);
-      STAILQ_INSERT_HEAD (&pgw_app.ipv4_list_free, ipv4_p, ipv4_entries);
-      return RETURNok;
-    }
+//------------------------------------------------------------------------------
+int
+pgw_get_free_ipv6_paa_prefix (
+  const imsi64_t imsi64,
+  const char * const apn,
+  struct in6_addr * const prefix_pP)
+{
+  if (RETURNok != pgw_paa_allocate (imsi64, apn, AF_INET6, prefix_pP)) {
+    memset (prefix_pP, 0, sizeof (*prefix_pP));
+    return RETURNerror;
   }
-  return RETURNerror;
+  return RETURNok;
 }
 
+//------------------------------------------------------------------------------
+int
+pgw_release_free_ipv6_paa_prefix (
+  const imsi64_t imsi64,
+  const struct in6_addr * const prefix_pP)
+{
+  return pgw_paa_release (imsi64, AF_INET6, prefix_pP);
+}
 
+//------------------------------------------------------------------------------
+uint32_t
+pgw_nb_allocated_paa (
+  const int family)
+{
+  uint32_t                                nb_allocated = 0;
 
+  for (int i = 0; i < pgw_paa.nb_pools; i++) {
+    if (pgw_paa.pools[i].family == family) {
+      nb_allocated += pgw_paa.pools[i].nb_allocated;
+    }
+  }
+  return nb_allocated;
+}
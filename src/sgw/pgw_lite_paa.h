@@ -19,8 +19,16 @@
  *      contact@openairinterface.org
  */
 
+
 /*! \file pgw_lite_paa.h
-* \brief
+* \brief UE IP address pools (PDN Address Allocation).
+* IPv4 addresses and IPv6 /64 prefixes are allocated from the configured pools of the requested APN
+* (the default pools if the APN has none). Each pool is a bitmap indexed by address, alloc and release
+* are O(1): never allocated addresses are taken first, then released ones in FIFO order.
+* Static IMSI -> IPv4 reservations are honoured, and every allocation and release can be reported to a
+* persistence hook, the default one being an append-only journal file replayed at init. Restored addresses
+* not claimed by their UE within PGW_PAA_RESTORED_HOLD_SEC, or once the pools are exhausted, go back to the pools.
+* Not thread safe, used by the SPGW_APP task only.
 * \author Lionel Gauthier
 * \company Eurecom
 * \email: lionel.gauthier@eurecom.fr
@@ -28,8 +36,43 @@
 #ifndef FILE_PGW_LITE_PAA_SEEN
 #define FILE_PGW_LITE_PAA_SEEN
 
-void pgw_load_pool_ip_addresses       (void);
-int pgw_get_free_ipv4_paa_address     (struct in_addr * const addr_P);
-int pgw_release_free_ipv4_paa_address (const struct in_addr * const addr_P);
+#define PGW_PAA_IPV6_PREFIX_LENGTH          64           /*!< \brief Length of the prefixes delegated to UEs */
+#define PGW_PAA_IPV6_POOL_PREFIXES_MAX     (1 << 24)     /*!< \brief /64 prefixes used per IPv6 pool */
+#define PGW_PAA_RESTORED_HOLD_SEC          600           /*!< \brief Restored addresses wait that long for their UE */
+
+/*
+ * Persistence hook, save() is called after each allocation (allocated true) or release, with
+ * address pointing to a struct in_addr (AF_INET) or to the struct in6_addr prefix (AF_INET6).
+ * A backend restores its records with pgw_restore_paa_address() before it is set.
+ */
+typedef struct pgw_paa_persistence_s {
+  void       *context;
+  void      (*save)(void *context, const bool allocated, const imsi64_t imsi64, const int family, const void * const address);
+  void      (*close)(void *context);
+} pgw_paa_persistence_t;
+
+/*
+ * Build the pools, reservations and persistence journal (if any) from the P-GW configuration.
+ */
+int  pgw_load_pool_ip_addresses       (const pgw_config_t * const config_pP);
+void pgw_unload_pool_ip_addresses     (void);
+
+int  pgw_get_free_ipv4_paa_address    (const imsi64_t imsi64, const char * const apn, struct in_addr * const addr_pP);
+int  pgw_release_free_ipv4_paa_address(const imsi64_t imsi64, const struct in_addr * const addr_pP);
+int  pgw_get_free_ipv6_paa_prefix     (const imsi64_t imsi64, const char * const apn, struct in6_addr * const prefix_pP);
+int  pgw_release_free_ipv6_paa_prefix (const imsi64_t imsi64, const struct in6_addr * const prefix_pP);
+
+/*
+ * Mark an address or prefix as allocated to the UE before any allocation, the UE gets it back at its
+ * next allocation in the same APN (if it comes before the restored addresses are released).
+ */
+int  pgw_restore_paa_address          (const imsi64_t imsi64, const int family, const void * const address);
+
+/*
+ * Replace the persistence hook (closing the previous one), NULL for none.
+ */
+void pgw_set_paa_persistence          (const pgw_paa_persistence_t * const persistence_pP);
+
+uint32_t pgw_nb_allocated_paa         (const int family);
 
 #endif
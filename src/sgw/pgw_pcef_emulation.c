@@ -51,9 +51,11 @@
 #include "sgw_context_manager.h"
 #include "pgw_procedures.h"
 #include "sgw.h"
+#include "gtpv1u.h"
 #include "async_system.h"
 
 extern pgw_app_t                        pgw_app;
+extern const struct gtp_tunnel_ops     *gtp_tunnel_ops;
 
 static void free_pcc_rule (void ** rule);
 
@@ -273,6 +275,13 @@ void pgw_pcef_emulation_apply_rule(const sdf_id_t sdf_id, const pgw_config_t * c
 void pgw_pcef_emulation_apply_sdf_filter(sdf_filter_t   * const sdf_f, const sdf_id_t sdf_id, const pgw_config_t * const pgw_config_p)
 {
   if ((TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == sdf_f->direction)  || (TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == sdf_f->direction)) {
+    if ((gtp_tunnel_ops) && (gtp_tunnel_ops->add_sdf_filter)) {
+      // classified in the data plane, same matching as the marking below but the lowest precedence wins
+      if (RETURNok != gtp_tunnel_ops->add_sdf_filter(sdf_f, sdf_id)) {
+        OAILOG_ERROR (LOG_SPGW_APP, "Failed to add packet filter %u of SDF %u to the data plane\n", sdf_f->identifier, sdf_id);
+      }
+      return;
+    }
     bstring filter = pgw_pcef_emulation_packet_filter_2_iptable_string(&sdf_f->packetfiltercontents, sdf_f->direction);
 
     bstring marking_command = NULL;
@@ -313,13 +322,8 @@ bstring pgw_pcef_emulation_packet_filter_2_iptable_string(packet_filter_contents
   bstring bstr = bfromcstralloc(64, " ");
 
   if ((TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == direction) || (TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == direction)){
+    // the remote end is the source of the downlink packets
     if (TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG & packetfiltercontents->flags) {
-      bformata(bstr, "  --destination %d.%d.%d.%d/%d.%d.%d.%d",
-        packetfiltercontents->ipv4remoteaddr[0].addr, packetfiltercontents->ipv4remoteaddr[1].addr,
-        packetfiltercontents->ipv4remoteaddr[2].addr, packetfiltercontents->ipv4remoteaddr[3].addr,
-        packetfiltercontents->ipv4remoteaddr[0].mask, packetfiltercontents->ipv4remoteaddr[1].mask,
-        packetfiltercontents->ipv4remoteaddr[2].mask, packetfiltercontents->ipv4remoteaddr[3].mask);
-    } else {
       bformata(bstr, " --source %d.%d.%d.%d/%d.%d.%d.%d",
         packetfiltercontents->ipv4remoteaddr[0].addr, packetfiltercontents->ipv4remoteaddr[1].addr,
         packetfiltercontents->ipv4remoteaddr[2].addr, packetfiltercontents->ipv4remoteaddr[3].addr,
@@ -341,7 +345,11 @@ bstring pgw_pcef_emulation_packet_filter_2_iptable_string(packet_filter_contents
     }
   }
   if (TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG & packetfiltercontents->flags) {
-    AssertFatal(0, "TODO LOCAL_PORT_RANGE");
+    if ((TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == direction) || (TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == direction)){
+      bformata(bstr, " --destination-port %" PRIu16":%" PRIu16" ", packetfiltercontents->localportrange.lowlimit, packetfiltercontents->localportrange.highlimit);
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == direction) {
+      bformata(bstr, " --source-port %" PRIu16":%" PRIu16" ", packetfiltercontents->localportrange.lowlimit, packetfiltercontents->localportrange.highlimit);
+    }
   }
   if (TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG & packetfiltercontents->flags) {
     if ((TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == direction) || (TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == direction)){
@@ -351,14 +359,19 @@ bstring pgw_pcef_emulation_packet_filter_2_iptable_string(packet_filter_contents
     }
   }
   if (TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG & packetfiltercontents->flags) {
-    AssertFatal(0, "TODO REMOTE_PORT_RANGE");
+    if ((TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY == direction) || (TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL == direction)){
+      bformata(bstr, " --source-port %" PRIu16":%" PRIu16" ", packetfiltercontents->remoteportrange.lowlimit, packetfiltercontents->remoteportrange.highlimit);
+    } else if (TRAFFIC_FLOW_TEMPLATE_UPLINK_ONLY == direction) {
+      bformata(bstr, " --destination-port %" PRIu16":%" PRIu16" ", packetfiltercontents->remoteportrange.lowlimit, packetfiltercontents->remoteportrange.highlimit);
+    }
   }
   if (TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG & packetfiltercontents->flags) {
     bformata(bstr, " -m esp --espspi %" PRIu32" ", packetfiltercontents->securityparameterindex);
   }
   if (TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG & packetfiltercontents->flags) {
-    // TODO mask
-    bformata(bstr, " -m tos --tos 0x%02X", packetfiltercontents->typdeofservice_trafficclass.value);
+    bformata(bstr, " -m tos --tos 0x%02X/0x%02X",
+        packetfiltercontents->typdeofservice_trafficclass.value & packetfiltercontents->typdeofservice_trafficclass.mask,
+        packetfiltercontents->typdeofservice_trafficclass.mask);
   }
   if (TRAFFIC_FLOW_TEMPLATE_FLOW_LABEL_FLAG & packetfiltercontents->flags) {
     AssertFatal(0, "TODO"); // we have time
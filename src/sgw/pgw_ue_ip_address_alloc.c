@@ -31,20 +31,35 @@
 #include <stdbool.h>
 #include <string.h>
 #include <netinet/in.h>
+#include "bstrlib.h"
+#include "common_types.h"
+#include "conversions.h"
+#include "spgw_config.h"
 #include "pgw_lite_paa.h"
+#include "pgw_ue_ip_address_alloc.h"
 
-int allocate_ue_ipv4_address(const char *imsi, struct in_addr *addr) {
+int allocate_ue_ipv4_address(const imsi_t * const imsi, const char * const apn, struct in_addr *addr) {
   // Call PGW IP Address allocator 
-  return pgw_get_free_ipv4_paa_address (addr); 
+  return pgw_get_free_ipv4_paa_address (imsi_to_imsi64 (imsi), apn, addr);
 }
 
-int release_ue_ipv4_address(const char *imsi, struct in_addr *addr) {
+int release_ue_ipv4_address(const imsi_t * const imsi, const struct in_addr *addr) {
   // Release IP address back to PGW IP Address allocator 
-  return pgw_release_free_ipv4_paa_address (addr); 
+  return pgw_release_free_ipv4_paa_address (imsi_to_imsi64 (imsi), addr);
 }
 
-void pgw_ip_address_pool_init(void) {
-  pgw_load_pool_ip_addresses ();
-  return;
+int allocate_ue_ipv6_prefix(const imsi_t * const imsi, const char * const apn, struct in6_addr *prefix) {
+  return pgw_get_free_ipv6_paa_prefix (imsi_to_imsi64 (imsi), apn, prefix);
 }
 
+int release_ue_ipv6_prefix(const imsi_t * const imsi, const struct in6_addr *prefix) {
+  return pgw_release_free_ipv6_paa_prefix (imsi_to_imsi64 (imsi), prefix);
+}
+
+int pgw_ip_address_pool_init(void) {
+  return pgw_load_pool_ip_addresses (&spgw_config.pgw_config);
+}
+
+void pgw_ip_address_pool_exit(void) {
+  pgw_unload_pool_ip_addresses ();
+}
@@ -29,8 +29,11 @@
 #ifndef PGW_UE_IP_ADDRESS_ALLOC_SEEN
 #define PGW_UE_IP_ADDRESS_ALLOC_SEEN
 
-int allocate_ue_ipv4_address (const char *imsi, struct in_addr *addr); 
-int release_ue_ipv4_address (const char *imsi, struct in_addr *addr);
-void pgw_ip_address_pool_init (void); 
+int allocate_ue_ipv4_address (const imsi_t * const imsi, const char * const apn, struct in_addr *addr);
+int release_ue_ipv4_address (const imsi_t * const imsi, const struct in_addr *addr);
+int allocate_ue_ipv6_prefix (const imsi_t * const imsi, const char * const apn, struct in6_addr *prefix);
+int release_ue_ipv6_prefix (const imsi_t * const imsi, const struct in6_addr *prefix);
+int pgw_ip_address_pool_init (void);
+void pgw_ip_address_pool_exit (void);
 
 #endif /*PGW_UE_IP_ADDRESS_ALLOC_SEEN */
@@ -40,6 +40,10 @@
 #include "sgw_context_manager.h"
 #include "gtpv1u_sgw_defs.h"
 #include "pgw_pcef_emulation.h"
+#include "teid_pool.h"
+
+#define SGW_S11_TEID_POOL_SIZE    (1 << 20)    /*!< \brief S-GW S11 TEIDs, one per UE */
+#define SGW_S1U_TEID_POOL_SIZE    (1 << 21)    /*!< \brief S-GW S1-U TEIDs, one per EPS bearer */
 
 typedef struct sgw_app_s {
 
@@ -60,19 +64,15 @@ typedef struct sgw_app_s {
   // the key of this hashtable is the S11 s-gw local teid.
   hash_table_ts_t *s11_bearer_context_information_hashtable;
 
+  // Local TEIDs, allocated by the SPGW_APP task only (sub-pool 0)
+  teid_pool_t     *s11_teid_pool;
+  teid_pool_t     *s1u_teid_pool;
+
   gtpv1u_data_t    gtpv1u_data;
 } sgw_app_t;
 
 
-struct ipv4_list_elm_s {
-  STAILQ_ENTRY(ipv4_list_elm_s) ipv4_entries;
-  struct in_addr  addr;
-};
-
-
 typedef struct pgw_app_s {
-  STAILQ_HEAD(ipv4_list_free_head_s,     ipv4_list_elm_s)  ipv4_list_free;
-  STAILQ_HEAD(ipv4_list_allocated_head_s, ipv4_list_elm_s) ipv4_list_allocated;
   hash_table_ts_t                                         *deactivated_predefined_pcc_rules;
   hash_table_ts_t                                         *predefined_pcc_rules;
 } pgw_app_t;
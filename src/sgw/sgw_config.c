@@ -66,6 +66,8 @@
 void sgw_config_init (sgw_config_t * config_pP)
 {
   memset(config_pP, 0, sizeof(*config_pP));
+  config_pP->ipv4.threads_S11 = 1;
+  config_pP->threads_gtpu = 1;
   pthread_rwlock_init (&config_pP->rw_lock, NULL);
 }
 //------------------------------------------------------------------------------
@@ -88,6 +90,7 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
   char                                   *sgw_if_name_S11 = NULL;
   char                                   *S11 = NULL;
   libconfig_int                           sgw_udp_port_S1u_S12_S4_up = 2152;
+  libconfig_int                           aint = 0;
   config_setting_t                       *subsetting = NULL;
   const char                             *astring = NULL;
   bstring                                 address = NULL;
@@ -155,6 +158,16 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
         }
       }
 
+      if (config_setting_lookup_string (subsetting, LOG_CONFIG_STRING_OUTPUT_BINARY, (const char **)&astring)) {
+        if (astring != NULL) {
+          if (strcasecmp (astring, "yes") == 0) {
+            config_pP->log_config.is_output_binary = true;
+          } else {
+            config_pP->log_config.is_output_binary = false;
+          }
+        }
+      }
+
       if (config_setting_lookup_string (subsetting, LOG_CONFIG_STRING_COLOR, (const char **)&astring)) {
         if (!strcasecmp("yes", astring)) config_pP->log_config.color = true;
         else config_pP->log_config.color = false;
@@ -248,6 +261,25 @@ int sgw_config_parse_file (sgw_config_t * config_pP)
             inet_ntoa (in_addr_var), config_pP->ipv4.netmask_S11, bdata(config_pP->ipv4.if_name_S11));
       }
 
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_SGW_THREADS_FOR_S11, &aint)) {
+        AssertFatal(aint > 0, "Bad number of S11 threads %d", aint);
+        config_pP->ipv4.threads_S11 = (uint32_t)aint;
+      }
+
+      if (config_setting_lookup_string (subsetting, SGW_CONFIG_STRING_SGW_GTPU_DATA_PLANE, (const char **)&astring)) {
+        if (!strcasecmp(astring, SGW_CONFIG_STRING_GTPU_DATA_PLANE_USERSPACE)) {
+          config_pP->gtpu_userspace = true;
+        } else {
+          AssertFatal(!strcasecmp(astring, SGW_CONFIG_STRING_GTPU_DATA_PLANE_KERNEL), "Bad GTP-U data plane %s", astring);
+          config_pP->gtpu_userspace = false;
+        }
+      }
+
+      if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_SGW_THREADS_FOR_GTPU, &aint)) {
+        AssertFatal(aint > 0, "Bad number of GTP-U threads %d", aint);
+        config_pP->threads_gtpu = (uint32_t)aint;
+      }
+
       if (config_setting_lookup_int (subsetting, SGW_CONFIG_STRING_SGW_PORT_FOR_S1U_S12_S4_UP, &sgw_udp_port_S1u_S12_S4_up)
         ) {
         config_pP->udp_port_S1u_S12_S4_up = sgw_udp_port_S1u_S12_S4_up;
@@ -274,19 +306,25 @@ void sgw_config_display (sgw_config_t * config_p)
   OAILOG_INFO (LOG_SPGW_APP, "    port number ......: %d\n", config_p->udp_port_S1u_S12_S4_up);
   OAILOG_INFO (LOG_SPGW_APP, "    S1u_S12_S4 iface .....: %s\n", bdata(config_p->ipv4.if_name_S1u_S12_S4_up));
   OAILOG_INFO (LOG_SPGW_APP, "    S1u_S12_S4 ip ........: %s/%u\n", inet_ntoa (config_p->ipv4.S1u_S12_S4_up), config_p->ipv4.netmask_S1u_S12_S4_up);
+  OAILOG_INFO (LOG_SPGW_APP, "    data plane ...........: %s\n", (config_p->gtpu_userspace) ? "userspace":"kernel");
+  if (config_p->gtpu_userspace) {
+    OAILOG_INFO (LOG_SPGW_APP, "    GTP-U threads ........: %u\n", config_p->threads_gtpu);
+  }
   OAILOG_INFO (LOG_SPGW_APP, "- S5-S8:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    S5_S8 iface ..........: %s\n", bdata(config_p->ipv4.if_name_S5_S8_up));
   OAILOG_INFO (LOG_SPGW_APP, "    S5_S8 ip .............: %s/%u\n", inet_ntoa (config_p->ipv4.S5_S8_up), config_p->ipv4.netmask_S5_S8_up);
   OAILOG_INFO (LOG_SPGW_APP, "- S11:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    S11 iface ............: %s\n", bdata(config_p->ipv4.if_name_S11));
   OAILOG_INFO (LOG_SPGW_APP, "    S11 ip ...............: %s/%u\n", inet_ntoa (config_p->ipv4.S11), config_p->ipv4.netmask_S11);
+  OAILOG_INFO (LOG_SPGW_APP, "    S11 threads ..........: %u\n", config_p->ipv4.threads_S11);
   OAILOG_INFO (LOG_SPGW_APP, "- ITTI:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    queue size .......: %u (bytes)\n", config_p->itti_config.queue_size);
-  OAILOG_INFO (LOG_SPGW_APP, "    log file .........: %s\n", bdata(config_p->itti_config.log_file));
+  OAILOG_INFO (LOG_SPGW_APP, "    capture file .....: %s\n", bdata(config_p->itti_config.log_file));
 
   OAILOG_INFO (LOG_SPGW_APP, "- Logging:\n");
   OAILOG_INFO (LOG_SPGW_APP, "    Output ..............: %s\n", bdata(config_p->log_config.output));
   OAILOG_INFO (LOG_SPGW_APP, "    Output thread-safe...: %s\n", (config_p->log_config.is_output_thread_safe) ? "true":"false");
+  OAILOG_INFO (LOG_SPGW_APP, "    Output binary........: %s\n", (config_p->log_config.is_output_binary) ? "true":"false");
   OAILOG_INFO (LOG_SPGW_APP, "    UDP log level........: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.udp_log_level));
   OAILOG_INFO (LOG_SPGW_APP, "    GTPV1-U log level....: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.gtpv1u_log_level));
   OAILOG_INFO (LOG_SPGW_APP, "    GTPV2-C log level....: %s\n", OAILOG_LEVEL_INT2STR(config_p->log_config.gtpv2c_log_level));
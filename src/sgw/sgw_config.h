@@ -44,6 +44,11 @@
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S5_S8_UP         "SGW_IPV4_ADDRESS_FOR_S5_S8_UP"
 #define SGW_CONFIG_STRING_SGW_INTERFACE_NAME_FOR_S11            "SGW_INTERFACE_NAME_FOR_S11"
 #define SGW_CONFIG_STRING_SGW_IPV4_ADDRESS_FOR_S11              "SGW_IPV4_ADDRESS_FOR_S11"
+#define SGW_CONFIG_STRING_SGW_THREADS_FOR_S11                   "SGW_THREADS_FOR_S11"
+#define SGW_CONFIG_STRING_SGW_GTPU_DATA_PLANE                   "SGW_GTPU_DATA_PLANE"
+#define SGW_CONFIG_STRING_SGW_THREADS_FOR_GTPU                  "SGW_THREADS_FOR_GTPU"
+#define SGW_CONFIG_STRING_GTPU_DATA_PLANE_KERNEL                "KERNEL"
+#define SGW_CONFIG_STRING_GTPU_DATA_PLANE_USERSPACE             "USERSPACE"
 
 #define SPGW_ABORT_ON_ERROR true
 #define SPGW_WARN_ON_ERROR false
@@ -69,9 +74,13 @@ typedef struct sgw_config_s {
     bstring        if_name_S11;
     struct in_addr S11;
     int            netmask_S11;
+    uint32_t       threads_S11;
   } ipv4;
   uint16_t     udp_port_S1u_S12_S4_up;
 
+  bool         gtpu_userspace;          // GTP-U forwarded by the S-GW process instead of the kernel gtp module
+  uint32_t     threads_gtpu;            // workers of the userspace data plane
+
   bool         local_to_eNB;
 
   log_config_t log_config;
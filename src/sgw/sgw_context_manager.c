@@ -169,11 +169,8 @@ sgw_get_new_S11_tunnel_id (
   void)
 //-----------------------------------------------------------------------------
 {
-  // TO DO: RANDOM
-  static teid_t                           tunnel_id = 0;
-
-  tunnel_id += 1;
-  return tunnel_id;
+  // Released by sgw_cm_remove_s11_tunnel()
+  return teid_pool_alloc (sgw_app.s11_teid_pool, 0);
 }
 
 //-----------------------------------------------------------------------------
@@ -214,6 +211,9 @@ sgw_cm_remove_s11_tunnel (
   int                                     temp = 0;
 
   temp = hashtable_ts_free (sgw_app.s11teid2mme_hashtable, local_teid);
+  if (HASH_TABLE_OK == temp) {
+    teid_pool_free (sgw_app.s11_teid_pool, local_teid);
+  }
   return temp;
 }
 
@@ -268,7 +268,9 @@ void sgw_cm_free_pdn_connection (sgw_pdn_connection_t * pdn_connectionP)
 void sgw_free_sgw_eps_bearer_context (sgw_eps_bearer_ctxt_t ** sgw_eps_bearer_ctxt)
 {
   if (*sgw_eps_bearer_ctxt) {
-    // nothing to do actually
+    if ((*sgw_eps_bearer_ctxt)->s_gw_teid_S1u_S12_S4_up != INVALID_TEID) {
+      teid_pool_free (sgw_app.s1u_teid_pool, (*sgw_eps_bearer_ctxt)->s_gw_teid_S1u_S12_S4_up);
+    }
     free_wrapper((void**) sgw_eps_bearer_ctxt);
   }
 }
@@ -418,9 +420,9 @@ sgw_cm_remove_eps_bearer_entry (
   if ((ebi < EPS_BEARER_IDENTITY_FIRST) || (ebi > EPS_BEARER_IDENTITY_LAST)) {
     return RETURNerror;
   }
-  sgw_eps_bearer_ctxt_t * sgw_eps_bearer_ctxt = sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)];
-  if (sgw_eps_bearer_ctxt) {
-    sgw_free_sgw_eps_bearer_context(&sgw_eps_bearer_ctxt);
+  if (sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)]) {
+    // Clears the slot, the PDN connection would free the bearer (and its TEID) again
+    sgw_free_sgw_eps_bearer_context(&sgw_pdn_connection->sgw_eps_bearers_array[EBI_TO_INDEX(ebi)]);
     return RETURNok;
   }
   return RETURNerror;
@@ -54,9 +54,9 @@
 #include "sgw_handlers.h"
 #include "sgw_context_manager.h"
 #include "sgw.h"
-#include "pgw_lite_paa.h"
 #include "pgw_pco.h"
 #include "spgw_config.h"
+#include "pgw_lite_paa.h"
 #include "gtpv1u.h"
 #include "pgw_ue_ip_address_alloc.h"
 #include "pgw_pcef_emulation.h"
@@ -67,13 +67,12 @@
 extern sgw_app_t                        sgw_app;
 extern spgw_config_t                    spgw_config;
 extern struct gtp_tunnel_ops           *gtp_tunnel_ops;
-static uint32_t                         g_gtpv1u_teid = 0;
 
 //------------------------------------------------------------------------------
 uint32_t sgw_get_new_s1u_teid (void)
 {
-  __sync_fetch_and_add(&g_gtpv1u_teid, 1);
-  return g_gtpv1u_teid;
+  // Released by sgw_free_sgw_eps_bearer_context()
+  return teid_pool_alloc (sgw_app.s1u_teid_pool, 0);
 }
 
 
@@ -112,7 +111,12 @@ sgw_handle_create_session_request (
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
 
-  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, sgw_get_new_S11_tunnel_id ());
+  teid_t s11_teid = sgw_get_new_S11_tunnel_id ();
+  if (s11_teid == INVALID_TEID) {
+    OAILOG_WARNING (LOG_SPGW_APP, "No S11 TEID left for MME S11 teid "TEID_FMT"\n", session_req_pP->sender_fteid_for_cp.teid);
+    OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
+  }
+  new_endpoint_p = sgw_cm_create_s11_tunnel (session_req_pP->sender_fteid_for_cp.teid, s11_teid);
 
   if (new_endpoint_p == NULL) {
     OAILOG_WARNING (LOG_SPGW_APP, "Could not create new tunnel endpoint between S-GW and MME " "for S11 abstraction\n");
@@ -226,7 +230,8 @@ sgw_handle_create_session_request (
     }
   } else {
     OAILOG_WARNING (LOG_SPGW_APP, "Could not create new transaction for SESSION_CREATE message\n");
-    free_wrapper ((void**) &new_endpoint_p);
+    // Frees the tunnel and its TEID
+    sgw_cm_remove_s11_tunnel (new_endpoint_p->local_teid);
     new_endpoint_p = NULL;
     OAILOG_FUNC_RETURN(LOG_SPGW_APP, RETURNerror);
   }
@@ -346,7 +351,8 @@ sgw_handle_gtpv1uCreateTunnelResp (
   struct in_addr                          inaddr;
   itti_sgi_create_end_point_response_t    sgi_create_endpoint_resp = {0};
   int                                     rv = RETURNok;
-  char                                   *imsi = NULL;
+  imsi_t                                 *imsi = NULL;
+  char                                   *apn = NULL;
   gtpv2c_cause_value_t                    cause = REQUEST_ACCEPTED;
 
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx GTPV1U_CREATE_TUNNEL_RESP, Context S-GW S11 teid "TEID_FMT", S-GW S1U teid "TEID_FMT" EPS bearer id %u status %d\n",
@@ -385,7 +391,8 @@ sgw_handle_gtpv1uCreateTunnelResp (
     // TO DO NOW
     sgi_create_endpoint_resp.paa.pdn_type = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message.pdn_type;
 
-    imsi = (char *) new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi.u.value;
+    imsi = &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
+    apn = new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.saved_message.apn;
     switch (sgi_create_endpoint_resp.paa.pdn_type) {
     case IPv4:
       // Use NAS by default if no preference is set.
@@ -409,7 +416,7 @@ sgw_handle_gtpv1uCreateTunnelResp (
       // and using them here in conditional logic. We will also want to
       // implement different logic between the PDN types.
       if (!pco_ids.ci_ipv4_address_allocation_via_dhcpv4) {
-        if (0 == allocate_ue_ipv4_address(imsi, &inaddr)) {
+        if (0 == allocate_ue_ipv4_address(imsi, apn, &inaddr)) {
           sgi_create_endpoint_resp.paa.ipv4_address.s_addr = inaddr.s_addr;
           sgi_create_endpoint_resp.status = SGI_STATUS_OK; 
         } else {
@@ -429,9 +436,15 @@ sgw_handle_gtpv1uCreateTunnelResp (
       break;
 
     case IPv4_AND_v6:
-      if (0 == allocate_ue_ipv4_address(imsi, &inaddr)) {
+      if (0 == allocate_ue_ipv4_address(imsi, apn, &inaddr)) {
         sgi_create_endpoint_resp.paa.ipv4_address.s_addr = inaddr.s_addr;
         sgi_create_endpoint_resp.status = SGI_STATUS_OK;
+        // /64 prefix delegated if the APN (or default) has an IPv6 pool, IPv4 only otherwise
+        if (0 == allocate_ue_ipv6_prefix(imsi, apn, &sgi_create_endpoint_resp.paa.ipv6_address)) {
+          sgi_create_endpoint_resp.paa.ipv6_prefix_length = PGW_PAA_IPV6_PREFIX_LENGTH;
+        } else {
+          sgi_create_endpoint_resp.paa.pdn_type = IPv4;
+        }
       } else {
         OAILOG_ERROR (LOG_SPGW_APP, "Failed to allocate IPv4 PAA for PDN type IPv4_AND_v6\n");
         sgi_create_endpoint_resp.status = SGI_STATUS_ERROR_ALL_DYNAMIC_ADDRESSES_OCCUPIED;
@@ -693,44 +706,53 @@ sgw_handle_sgi_endpoint_deleted (
   sgw_eps_bearer_ctxt_t                 *eps_bearer_ctxt_p = NULL;
   hashtable_rc_t                          hash_rc = HASH_TABLE_OK;
   int                                     rv = RETURNok;
-  char                                   *imsi = NULL;
+  imsi_t                                 *imsi = NULL;
   struct in_addr                          inaddr;
 
-  imsi = (char *) new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi.u.value;
-  switch (resp_pP->paa.pdn_type) {
-    case IPv4:
-      inaddr.s_addr = resp_pP->paa.ipv4_address.s_addr;
-      if (!release_ue_ipv4_address(imsi, &inaddr)) {
-        OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv4 PAA for PDN type IPv4\n");
-      } else {
-        OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv4 PAA for PDN type IPv4\n");
-      }
-      break;
-
-    case IPv6:
-      OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv6 PAA for PDN type IPv6\n");
-      break;
-
-    case IPv4_AND_v6:
-      inaddr.s_addr = resp_pP->paa.ipv4_address.s_addr;
-      if (!release_ue_ipv4_address(imsi, &inaddr)) {
-        OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv4 PAA for PDN type IPv4_AND_v6\n");
-      } else {
-        OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv4 PAA for PDN type IPv4_AND_v6\n");
-      }
-      break;
-
-    default:
-      AssertFatal (0, "Bad paa.pdn_type %d", resp_pP->paa.pdn_type);
-      break;
-  }
-
   OAILOG_DEBUG (LOG_SPGW_APP, "Rx SGI_DELETE_ENDPOINT_REQUEST, Context teid %u, SGW S1U teid %u, EPS bearer id %u\n",
                 resp_pP->context_teid, resp_pP->sgw_S1u_teid, resp_pP->eps_bearer_id);
 
   hash_rc = hashtable_ts_get (sgw_app.s11_bearer_context_information_hashtable, resp_pP->context_teid, (void **)&new_bearer_ctxt_info_p);
 
   if (HASH_TABLE_OK == hash_rc) {
+    imsi = &new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.imsi;
+    switch (resp_pP->paa.pdn_type) {
+      case IPv4:
+        inaddr.s_addr = resp_pP->paa.ipv4_address.s_addr;
+        if (!release_ue_ipv4_address(imsi, &inaddr)) {
+          OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv4 PAA for PDN type IPv4\n");
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv4 PAA for PDN type IPv4\n");
+        }
+        break;
+
+      case IPv6:
+        if (!release_ue_ipv6_prefix(imsi, &resp_pP->paa.ipv6_address)) {
+          OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv6 PAA for PDN type IPv6\n");
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv6 PAA for PDN type IPv6\n");
+        }
+        break;
+
+      case IPv4_AND_v6:
+        inaddr.s_addr = resp_pP->paa.ipv4_address.s_addr;
+        if (!release_ue_ipv4_address(imsi, &inaddr)) {
+          OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv4 PAA for PDN type IPv4_AND_v6\n");
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv4 PAA for PDN type IPv4_AND_v6\n");
+        }
+        if (!release_ue_ipv6_prefix(imsi, &resp_pP->paa.ipv6_address)) {
+          OAILOG_DEBUG (LOG_SPGW_APP, "Released IPv6 PAA for PDN type IPv4_AND_v6\n");
+        } else {
+          OAILOG_ERROR (LOG_SPGW_APP, "Failed to release IPv6 PAA for PDN type IPv4_AND_v6\n");
+        }
+        break;
+
+      default:
+        AssertFatal (0, "Bad paa.pdn_type %d", resp_pP->paa.pdn_type);
+        break;
+    }
+
     eps_bearer_ctxt_p =
         sgw_cm_get_eps_bearer_entry(&new_bearer_ctxt_info_p->sgw_eps_bearer_context_information.pdn_connection,
             resp_pP->eps_bearer_id);
@@ -891,6 +913,8 @@ sgw_handle_delete_session_request (
 
       itti_sgi_delete_end_point_request_t       sgi_delete_end_point_request;
       sgw_eps_bearer_ctxt_t                    *eps_bearer_ctxt_p = NULL;
+      struct gtp_tunnel_entry                   tunnels[BEARERS_PER_UE];
+      uint32_t                                  nb_tunnels = 0;
 
       for (int ebix = 0; ebix < BEARERS_PER_UE; ebix++) {
         ebi_t ebi = INDEX_TO_EBI(ebix);
@@ -898,14 +922,14 @@ sgw_handle_delete_session_request (
 
         if (eps_bearer_ctxt_p) {
           if (ebi != delete_session_req_pP->lbi) {
-            rv = gtp_tunnel_ops->del_tunnel(eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, eps_bearer_ctxt_p->enb_teid_S1u);
-            if (rv < 0) {
-              OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting TUNNEL " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n",
-                  eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up);
-            }
+            // dedicated bearer tunnels deleted at once
+            tunnels[nb_tunnels].i_tei = eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up;
+            tunnels[nb_tunnels].o_tei = eps_bearer_ctxt_p->enb_teid_S1u;
+            nb_tunnels++;
 
 #if ENABLE_SDF_MARKING
-            for (int sdfx = 0; sdfx < eps_bearer_ctxt_p->num_sdf; sdfx++) {
+            // SDFs bound with add_bearer_sdf are released with the tunnel
+            for (int sdfx = 0; (sdfx < eps_bearer_ctxt_p->num_sdf) && !gtp_tunnel_ops->add_bearer_sdf; sdfx++) {
               if (eps_bearer_ctxt_p->sdf_id[sdfx]) {
                 bstring marking_command = bformat(
                     "iptables -D POSTROUTING -t mangle --out-interface gtp0 --dest %"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"/32 -m mark --mark 0x%04X -j MARK --set-mark %d",
@@ -919,6 +943,13 @@ sgw_handle_delete_session_request (
           }
         }
       }
+      if (nb_tunnels) {
+        rv = gtp_tunnel_ops->del_tunnels(tunnels, nb_tunnels);
+        if (rv < 0) {
+          OAILOG_ERROR (LOG_SPGW_APP, "ERROR in deleting %u dedicated bearer TUNNELs of S11 teid " TEID_FMT "\n",
+              nb_tunnels, delete_session_req_pP->teid);
+        }
+      }
 
       eps_bearer_ctxt_p = sgw_cm_get_eps_bearer_entry(&ctx_p->sgw_eps_bearer_context_information.pdn_connection, delete_session_req_pP->lbi);
       if (eps_bearer_ctxt_p) {
@@ -929,7 +960,7 @@ sgw_handle_delete_session_request (
                 eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up);
           }
 #if ENABLE_SDF_MARKING
-          for (int sdfx = 0; sdfx < eps_bearer_ctxt_p->num_sdf; sdfx++) {
+          for (int sdfx = 0; (sdfx < eps_bearer_ctxt_p->num_sdf) && !gtp_tunnel_ops->add_bearer_sdf; sdfx++) {
             if (eps_bearer_ctxt_p->sdf_id[sdfx]) {
               bstring marking_command = bformat(
                   "iptables -D POSTROUTING -t mangle --out-interface gtp0 --dest %"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"/32 -m mark --mark 0x%04X -j MARK --set-mark %d",
@@ -1215,20 +1246,31 @@ sgw_handle_create_bearer_response (
                       OAILOG_INFO (LOG_SPGW_APP, "Failed to setup EPS bearer id %u tunnel " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n",
                           eps_bearer_ctxt_p->eps_bearer_id, eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up);
                     } else {
-
+                      if (gtp_tunnel_ops->add_bearer_sdf) {
+                        // the data plane classifies the downlink packets of the SDF itself
+                        if (gtp_tunnel_ops->add_bearer_sdf(eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up, pgw_ni_cbr_proc->sdf_id) < 0) {
+                          OAILOG_ERROR (LOG_SPGW_APP, "ERROR in binding SDF %u to EPS bearer id %u\n", pgw_ni_cbr_proc->sdf_id, eps_bearer_ctxt_p->eps_bearer_id);
+                        }
+                        if (TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX > eps_bearer_ctxt_p->num_sdf) {
+                          eps_bearer_ctxt_p->sdf_id[eps_bearer_ctxt_p->num_sdf] = pgw_ni_cbr_proc->sdf_id;
+                          eps_bearer_ctxt_p->num_sdf += 1;
+                        }
+                      }
 #if ENABLE_SDF_MARKING
-                      bstring marking_command = bformat(
-                          "iptables -A POSTROUTING -t mangle --out-interface gtp0 --dest %"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"/32 -m mark --mark 0x%04X -j MARK --set-mark %d",
-                          NIPADDR(eps_bearer_ctxt_p->paa.ipv4_address.s_addr), pgw_ni_cbr_proc->sdf_id, eps_bearer_ctxt_p->eps_bearer_id);
-                      async_system_command (TASK_SPGW_APP, false, bdata(marking_command));
-
-                      AssertFatal((TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX > eps_bearer_ctxt_p->num_sdf), "Too much flows aggregated in this Bearer (should not happen => see MME)");
-                      if (TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX > eps_bearer_ctxt_p->num_sdf) {
-                        eps_bearer_ctxt_p->sdf_id[eps_bearer_ctxt_p->num_sdf] = pgw_ni_cbr_proc->sdf_id;
-                        eps_bearer_ctxt_p->num_sdf += 1;
+                      else {
+                        bstring marking_command = bformat(
+                            "iptables -A POSTROUTING -t mangle --out-interface gtp0 --dest %"PRIu8".%"PRIu8".%"PRIu8".%"PRIu8"/32 -m mark --mark 0x%04X -j MARK --set-mark %d",
+                            NIPADDR(eps_bearer_ctxt_p->paa.ipv4_address.s_addr), pgw_ni_cbr_proc->sdf_id, eps_bearer_ctxt_p->eps_bearer_id);
+                        async_system_command (TASK_SPGW_APP, false, bdata(marking_command));
+
+                        AssertFatal((TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX > eps_bearer_ctxt_p->num_sdf), "Too much flows aggregated in this Bearer (should not happen => see MME)");
+                        if (TRAFFIC_FLOW_TEMPLATE_NB_PACKET_FILTERS_MAX > eps_bearer_ctxt_p->num_sdf) {
+                          eps_bearer_ctxt_p->sdf_id[eps_bearer_ctxt_p->num_sdf] = pgw_ni_cbr_proc->sdf_id;
+                          eps_bearer_ctxt_p->num_sdf += 1;
+                        }
+
+                        bdestroy_wrapper(&marking_command);
                       }
-
-                      bdestroy_wrapper(&marking_command);
 #endif
                       OAILOG_INFO (LOG_SPGW_APP, "Setup EPS bearer id %u tunnel " TEID_FMT " (eNB) <-> (SGW) " TEID_FMT "\n",
                           eps_bearer_ctxt_p->eps_bearer_id, eps_bearer_ctxt_p->enb_teid_S1u, eps_bearer_ctxt_p->s_gw_teid_S1u_S12_S4_up);
@@ -163,7 +163,10 @@ int sgw_init (spgw_config_t *spgw_config_pP)
     return RETURNerror;
   }
 
-  pgw_ip_address_pool_init (); 
+  if (pgw_ip_address_pool_init () != RETURNok) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing UE IP address pools: ERROR\n");
+    return RETURNerror;
+  }
 
   bstring b = bfromcstr("sgw_s11teid2mme_hashtable");
   sgw_app.s11teid2mme_hashtable = hashtable_ts_create (512, NULL, NULL, b);
@@ -195,6 +198,13 @@ int sgw_init (spgw_config_t *spgw_config_pP)
     return RETURNerror;
   }
 
+  sgw_app.s11_teid_pool = teid_pool_create ("sgw_s11_teid_pool", 1, SGW_S11_TEID_POOL_SIZE, 1);
+  sgw_app.s1u_teid_pool = teid_pool_create ("sgw_s1u_teid_pool", 1, SGW_S1U_TEID_POOL_SIZE, 1);
+  if ((!sgw_app.s11_teid_pool) || (!sgw_app.s1u_teid_pool)) {
+    OAILOG_ALERT (LOG_SPGW_APP, "Initializing SPGW-APP task interface: ERROR\n");
+    return RETURNerror;
+  }
+
   sgw_app.sgw_if_name_S1u_S12_S4_up    = bstrcpy(spgw_config_pP->sgw_config.ipv4.if_name_S1u_S12_S4_up);
   sgw_app.sgw_ip_address_S1u_S12_S4_up.s_addr = spgw_config_pP->sgw_config.ipv4.S1u_S12_S4_up.s_addr;
   sgw_app.sgw_if_name_S11_S4           = bstrcpy(spgw_config_pP->sgw_config.ipv4.if_name_S11);
@@ -204,11 +214,14 @@ int sgw_init (spgw_config_t *spgw_config_pP)
 
 #if ENABLE_SDF_MARKING
   if (spgw_config_pP->pgw_config.pcef.enabled) {
+#else
+  // the userspace data plane classifies SDFs without iptables marking
+  if ((spgw_config_pP->pgw_config.pcef.enabled) && (spgw_config_pP->sgw_config.gtpu_userspace)) {
+#endif
     if (RETURNerror == pgw_pcef_emulation_init (&spgw_config_pP->pgw_config)) {
       return RETURNerror;
     }
   }
-#endif
 
   if (itti_create_task (TASK_SPGW_APP, &sgw_intertask_interface, NULL) < 0) {
     perror ("pthread_create");
@@ -241,13 +254,12 @@ static void sgw_exit(void)
   if (sgw_app.s11_bearer_context_information_hashtable) {
     hashtable_ts_destroy (sgw_app.s11_bearer_context_information_hashtable);
   }
+  // After the contexts, they release their TEIDs
+  teid_pool_destroy (&sgw_app.s11_teid_pool);
+  teid_pool_destroy (&sgw_app.s1u_teid_pool);
 
   //P-GW code
-  struct conf_ipv4_list_elm_s   *conf_ipv4_p = NULL;
-
-  while ((conf_ipv4_p = STAILQ_FIRST (&spgw_config.pgw_config.ipv4_pool_list))) {
-    STAILQ_REMOVE_HEAD (&spgw_config.pgw_config.ipv4_pool_list, ipv4_entries);
-    free_wrapper ((void**)&conf_ipv4_p);
-  }
+  pgw_ip_address_pool_exit ();
+  pgw_config_exit (&spgw_config.pgw_config);
   OAI_FPRINTF_INFO("TASK_SPGW_APP terminated");
 }
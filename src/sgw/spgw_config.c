@@ -150,7 +150,7 @@ static void usage (char *target)
   OAILOG_INFO (LOG_CONFIG, "        Set the configuration file for S/P-GW\n");
   OAILOG_INFO (LOG_CONFIG, "        See template in ETC\n");
   OAILOG_INFO (LOG_CONFIG, "-K <file>\n");
-  OAILOG_INFO (LOG_CONFIG, "        Output intertask messages to provided file\n");
+  OAILOG_INFO (LOG_CONFIG, "        Record intertask messages in provided capture file (see oai_itti_dump_reader)\n");
   OAILOG_INFO (LOG_CONFIG, "-V      Print %s version and return\n", PACKAGE_NAME);
 }
 //------------------------------------------------------------------------------
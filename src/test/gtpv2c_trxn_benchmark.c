@@ -0,0 +1,359 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under 
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.  
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Replays N concurrent Create Session transactions through the GTPv2-C stack:
+ * N Create Session Requests are sent from N new local tunnels, then the N
+ * Create Session Responses are received, then the tunnels are deleted.
+ * This is done twice, the second round measures the stack with warm pools.
+ * UDP and timer entities are stubs, so that only the stack is measured.
+ * Then a Modify Bearer Request body is encoded IE by IE and from an IE template,
+ * the two encodings must be identical.
+ *
+ * usage: gtpv2c_trxn_benchmark [number of transactions, default 100000]
+ *
+ * Outstanding requests are kept by the stack for retransmission, count ~10kB
+ * of memory per concurrent transaction.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#include "NwTypes.h"
+#include "NwError.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+
+#define GTPV2C_BENCH_DEFAULT_TRANSACTIONS   (100000)
+#define GTPV2C_BENCH_PEER_IPV4              "192.168.11.1"
+#define GTPV2C_BENCH_CSR_RSP_LENGTH         (18)
+
+typedef struct gtpv2c_bench_s {
+  nw_gtpv2c_stack_handle_t      hStack;
+  uint32_t                      num_transactions;
+  uint32_t                     *seq_nums;              /* Sequence numbers of the sent requests */
+  nw_gtpv2c_tunnel_handle_t    *tunnels;
+  uint32_t                      num_sent;
+  uint32_t                      num_responses;
+  uint32_t                      num_failures;
+  nw_gtpv2c_timer_handle_t      last_timer;
+} gtpv2c_bench_t;
+
+//------------------------------------------------------------------------------
+static uint64_t gtpv2c_bench_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t gtpv2c_bench_udp_data_req (nw_gtpv2c_udp_handle_t udpHandle, uint8_t * dataBuf, uint32_t dataSize,
+    struct in_addr *peerIp, uint16_t peerPort)
+{
+  gtpv2c_bench_t                         *bench = (gtpv2c_bench_t *) udpHandle;
+
+  if ((dataSize >= 12) && (bench->num_sent < bench->num_transactions)) {
+    bench->seq_nums[bench->num_sent++] = ntohl (*((uint32_t *) (dataBuf + ((dataBuf[0] & 0x08) ? 8 : 4)))) >> 8;
+  }
+
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t gtpv2c_bench_ulp_req (nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t * pUlpApi)
+{
+  gtpv2c_bench_t                         *bench = (gtpv2c_bench_t *) hUlp;
+
+  switch (pUlpApi->apiType) {
+  case NW_GTPV2C_ULP_API_TRIGGERED_RSP_IND:
+    bench->num_responses++;
+    nwGtpv2cMsgDelete (bench->hStack, pUlpApi->hMsg);
+    break;
+
+  case NW_GTPV2C_ULP_API_RSP_FAILURE_IND:
+    bench->num_failures++;
+    break;
+
+  default:
+    if (pUlpApi->hMsg) {
+      nwGtpv2cMsgDelete (bench->hStack, pUlpApi->hMsg);
+    }
+  }
+
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t gtpv2c_bench_timer_start (nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle, uint32_t timeoutSec, uint32_t timeoutUsec,
+    uint32_t tmrType, void *tmrArg, nw_gtpv2c_timer_handle_t * tmrHandle)
+{
+  gtpv2c_bench_t                         *bench = (gtpv2c_bench_t *) tmrMgrHandle;
+
+  /*
+   * Responses are replayed well before the T3 timer expires, it never fires
+   */
+  *tmrHandle = ++bench->last_timer;
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static nw_rc_t gtpv2c_bench_timer_stop (nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle, nw_gtpv2c_timer_handle_t tmrHandle)
+{
+  return NW_OK;
+}
+
+//------------------------------------------------------------------------------
+static void gtpv2c_bench_report (const char *phase, uint64_t start_ns, uint64_t end_ns, uint32_t count)
+{
+  double                                  elapsed_ms = (end_ns - start_ns) / 1e6;
+
+  printf ("%-32s %8u ops %10.2f ms %8.0f ns/op %10.0f ops/s\n", phase, count, elapsed_ms,
+          (double)(end_ns - start_ns) / count, count / (elapsed_ms / 1e3));
+}
+
+//------------------------------------------------------------------------------
+static int gtpv2c_bench_run (gtpv2c_bench_t * bench, struct in_addr *peer_ip, const char *round)
+{
+  nw_gtpv2c_ulp_api_t                     ulp_req = {0};
+  uint8_t                                 imsi[8] = {0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0xf0};
+  uint8_t                                 csr_rsp[GTPV2C_BENCH_CSR_RSP_LENGTH] = {0};
+  char                                    phase[64];
+  uint64_t                                start_ns = 0;
+  uint32_t                                i = 0;
+
+  bench->num_sent = 0;
+  bench->num_responses = 0;
+  bench->num_failures = 0;
+  /*
+   * Create Session Requests, each one from a new local tunnel
+   */
+  start_ns = gtpv2c_bench_now_ns ();
+
+  for (i = 0; i < bench->num_transactions; i++) {
+    memset (&ulp_req, 0, sizeof (ulp_req));
+    ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
+    nwGtpv2cMsgNew (bench->hStack, true, NW_GTP_CREATE_SESSION_REQ, 0, 0, &ulp_req.hMsg);
+    nwGtpv2cMsgAddIe (ulp_req.hMsg, NW_GTPV2C_IE_IMSI, sizeof (imsi), 0, imsi);
+    nwGtpv2cMsgAddIeTV1 (ulp_req.hMsg, NW_GTPV2C_IE_RAT_TYPE, 0, 6);
+    ulp_req.u_api_info.initialReqInfo.hUlpTrxn = (nw_gtpv2c_ulp_trxn_handle_t) (i + 1);
+    ulp_req.u_api_info.initialReqInfo.teidLocal = i + 1;
+    ulp_req.u_api_info.initialReqInfo.hUlpTunnel = (nw_gtpv2c_ulp_tunnel_handle_t) (i + 1);
+    ulp_req.u_api_info.initialReqInfo.peerIp = *peer_ip;
+
+    if (NW_OK != nwGtpv2cProcessUlpReq (bench->hStack, &ulp_req)) {
+      fprintf (stderr, "Create Session Request %u failed\n", i);
+      return -1;
+    }
+
+    bench->tunnels[i] = ulp_req.u_api_info.initialReqInfo.hTunnel;
+  }
+
+  snprintf (phase, sizeof (phase), "%s Create Session Request", round);
+  gtpv2c_bench_report (phase, start_ns, gtpv2c_bench_now_ns (), bench->num_transactions);
+  /*
+   * Create Session Responses, in reverse order of the requests
+   */
+  csr_rsp[0] = 0x48;                                    /* Version 2, TEID present */
+  csr_rsp[1] = NW_GTP_CREATE_SESSION_RSP;
+  *((uint16_t *) (csr_rsp + 2)) = htons (GTPV2C_BENCH_CSR_RSP_LENGTH - 4);
+  csr_rsp[12] = NW_GTPV2C_IE_CAUSE;
+  csr_rsp[14] = 2;                                      /* IE length */
+  csr_rsp[16] = NW_GTPV2C_CAUSE_REQUEST_ACCEPTED;
+  start_ns = gtpv2c_bench_now_ns ();
+
+  for (i = bench->num_sent; i > 0; i--) {
+    *((uint32_t *) (csr_rsp + 4)) = htonl (i);
+    *((uint32_t *) (csr_rsp + 8)) = htonl (bench->seq_nums[i - 1] << 8);
+    nwGtpv2cProcessUdpReq (bench->hStack, csr_rsp, sizeof (csr_rsp), 2123, peer_ip);
+  }
+
+  snprintf (phase, sizeof (phase), "%s Create Session Response", round);
+  gtpv2c_bench_report (phase, start_ns, gtpv2c_bench_now_ns (), bench->num_sent);
+  /*
+   * Local tunnels deletion
+   */
+  start_ns = gtpv2c_bench_now_ns ();
+
+  for (i = 0; i < bench->num_transactions; i++) {
+    memset (&ulp_req, 0, sizeof (ulp_req));
+    ulp_req.apiType = NW_GTPV2C_ULP_DELETE_LOCAL_TUNNEL;
+    ulp_req.u_api_info.deleteLocalTunnelInfo.hTunnel = bench->tunnels[i];
+    nwGtpv2cProcessUlpReq (bench->hStack, &ulp_req);
+  }
+
+  snprintf (phase, sizeof (phase), "%s Delete local tunnel", round);
+  gtpv2c_bench_report (phase, start_ns, gtpv2c_bench_now_ns (), bench->num_transactions);
+  printf ("%s %u requests sent, %u responses matched, %u failures\n", round, bench->num_sent, bench->num_responses, bench->num_failures);
+  return (bench->num_responses == bench->num_transactions) ? 0 : -1;
+}
+
+//------------------------------------------------------------------------------
+static void gtpv2c_bench_mbr_encode_ies (nw_gtpv2c_msg_handle_t hMsg, uint8_t ebi, uint32_t teid, struct in_addr *ipv4)
+{
+  nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+  nwGtpv2cMsgAddIeTV1 (hMsg, NW_GTPV2C_IE_EBI, 0, ebi);
+  nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IFTYPE_S1U_ENODEB_GTPU, teid, ipv4, NULL);
+  nwGtpv2cMsgGroupedIeEnd (hMsg);
+}
+
+//------------------------------------------------------------------------------
+static int gtpv2c_bench_encode (gtpv2c_bench_t * bench, struct in_addr *peer_ip)
+{
+  nw_gtpv2c_ie_template_t                 ie_template = {0};
+  nw_gtpv2c_ie_template_t                 empty_template;
+  nw_gtpv2c_msg_handle_t                  hMsg = 0;
+  nw_gtpv2c_msg_handle_t                  hMsgTemplate = 0;
+  uint8_t                                *ie = NULL;
+  uint8_t                                *end = NULL;
+  uint16_t                                ebi_offset = 0;
+  uint16_t                                fteid_offset = 0;
+  uint32_t                                teid = 0;
+  uint64_t                                start_ns = 0;
+  uint32_t                                i = 0;
+  int                                     rc = 0;
+
+  nwGtpv2cMsgIeTemplateStart (&hMsg);
+  nwGtpv2cMsgGroupedIeStart (hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+  ebi_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  nwGtpv2cMsgAddIeTV1 (hMsg, NW_GTPV2C_IE_EBI, 0, 0);
+  fteid_offset = nwGtpv2cMsgGetLength (hMsg) + sizeof (nw_gtpv2c_ie_tlv_t);
+  nwGtpv2cMsgAddIeFteid (hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, NW_GTPV2C_IFTYPE_S1U_ENODEB_GTPU, 0, peer_ip, NULL);
+  nwGtpv2cMsgGroupedIeEnd (hMsg);
+
+  if (NW_OK != nwGtpv2cMsgIeTemplateEnd (hMsg, &ie_template)) {
+    fprintf (stderr, "IE template build failed\n");
+    return -1;
+  }
+
+  start_ns = gtpv2c_bench_now_ns ();
+
+  for (i = 0; i < bench->num_transactions; i++) {
+    nwGtpv2cMsgNew (bench->hStack, true, NW_GTP_MODIFY_BEARER_REQ, i, 0, &hMsg);
+    gtpv2c_bench_mbr_encode_ies (hMsg, 5, i, peer_ip);
+    nwGtpv2cMsgDelete (bench->hStack, hMsg);
+  }
+
+  gtpv2c_bench_report ("Modify Bearer Request IE by IE", start_ns, gtpv2c_bench_now_ns (), bench->num_transactions);
+  start_ns = gtpv2c_bench_now_ns ();
+
+  for (i = 0; i < bench->num_transactions; i++) {
+    nwGtpv2cMsgNew (bench->hStack, true, NW_GTP_MODIFY_BEARER_REQ, i, 0, &hMsg);
+    nwGtpv2cMsgAddIeTemplate (hMsg, &ie_template, &ie);
+    ie[ebi_offset] = 5;
+    teid = htonl (i);
+    memcpy (&ie[fteid_offset + 1], &teid, sizeof (teid));
+    memcpy (&ie[fteid_offset + 5], &peer_ip->s_addr, sizeof (peer_ip->s_addr));
+    nwGtpv2cMsgDelete (bench->hStack, hMsg);
+  }
+
+  gtpv2c_bench_report ("Modify Bearer Request template", start_ns, gtpv2c_bench_now_ns (), bench->num_transactions);
+  /*
+   * Both encodings of the same values must be identical
+   */
+  teid = 0x12345678;
+  nwGtpv2cMsgNew (bench->hStack, true, NW_GTP_MODIFY_BEARER_REQ, 1, 0, &hMsg);
+  gtpv2c_bench_mbr_encode_ies (hMsg, 5, teid, peer_ip);
+  nwGtpv2cMsgNew (bench->hStack, true, NW_GTP_MODIFY_BEARER_REQ, 1, 0, &hMsgTemplate);
+  nwGtpv2cMsgAddIeTemplate (hMsgTemplate, &ie_template, &ie);
+  ie[ebi_offset] = 5;
+  teid = htonl (teid);
+  memcpy (&ie[fteid_offset + 1], &teid, sizeof (teid));
+  memcpy (&ie[fteid_offset + 5], &peer_ip->s_addr, sizeof (peer_ip->s_addr));
+
+  /*
+   * Appending an empty template gives the end of the IE by IE encoding
+   */
+  empty_template.len = 0;
+  nwGtpv2cMsgAddIeTemplate (hMsg, &empty_template, &end);
+
+  if ((nwGtpv2cMsgGetLength (hMsg) != nwGtpv2cMsgGetLength (hMsgTemplate)) ||
+      memcmp (end - ie_template.len, ie, ie_template.len)) {
+    fprintf (stderr, "IE template encoding differs from IE by IE encoding\n");
+    rc = -1;
+  }
+
+  nwGtpv2cMsgDelete (bench->hStack, hMsg);
+  nwGtpv2cMsgDelete (bench->hStack, hMsgTemplate);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  gtpv2c_bench_t                          bench = {0};
+  nw_gtpv2c_ulp_entity_t                  ulp = {0};
+  nw_gtpv2c_udp_entity_t                  udp = {0};
+  nw_gtpv2c_timer_mgr_entity_t            tmr_mgr = {0};
+  struct in_addr                          peer_ip = {0};
+  int                                     rc = 0;
+
+  bench.num_transactions = (argc > 1) ? (uint32_t) strtoul (argv[1], NULL, 10) : GTPV2C_BENCH_DEFAULT_TRANSACTIONS;
+
+  if (!bench.num_transactions) {
+    fprintf (stderr, "usage: %s [number of transactions]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bench.seq_nums = calloc (bench.num_transactions, sizeof (uint32_t));
+  bench.tunnels = calloc (bench.num_transactions, sizeof (nw_gtpv2c_tunnel_handle_t));
+
+  if ((!bench.seq_nums) || (!bench.tunnels) || (NW_OK != nwGtpv2cInitialize (&bench.hStack))) {
+    fprintf (stderr, "Initialization failed\n");
+    return EXIT_FAILURE;
+  }
+
+  ulp.hUlp = (nw_gtpv2c_ulp_handle_t) & bench;
+  ulp.ulpReqCallback = gtpv2c_bench_ulp_req;
+  nwGtpv2cSetUlpEntity (bench.hStack, &ulp);
+  udp.hUdp = (nw_gtpv2c_udp_handle_t) & bench;
+  udp.udpDataReqCallback = gtpv2c_bench_udp_data_req;
+  nwGtpv2cSetUdpEntity (bench.hStack, &udp);
+  tmr_mgr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t) & bench;
+  tmr_mgr.tmrStartCallback = gtpv2c_bench_timer_start;
+  tmr_mgr.tmrStopCallback = gtpv2c_bench_timer_stop;
+  nwGtpv2cSetTimerMgrEntity (bench.hStack, &tmr_mgr);
+  inet_pton (AF_INET, GTPV2C_BENCH_PEER_IPV4, &peer_ip);
+  /*
+   * The first round grows the stack pools up to the working set, the second one runs on warm pools
+   */
+  rc = gtpv2c_bench_run (&bench, &peer_ip, "[cold]");
+
+  if (0 == rc) {
+    rc = gtpv2c_bench_run (&bench, &peer_ip, "[warm]");
+  }
+
+  if (0 == rc) {
+    rc = gtpv2c_bench_encode (&bench, &peer_ip);
+  }
+
+  nwGtpv2cFinalize (bench.hStack);
+  free (bench.seq_nums);
+  free (bench.tunnels);
+  return (0 == rc) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Cost of the logging calls made for one NAS message on the attach path when their level is
+ * filtered out (production configuration: every protocol at ERROR).
+ * One message is modelled as nas_message_decode() and the EMM procedure behind it:
+ * a hex dump of the message, nested function entry/exit traces and a few DEBUG and INFO messages.
+ * The calls are made twice: through the OAILOG_* macros, that test the level inline, and as the
+ * macros expanded before (a call into log.c that tests the level).
+ * Function traces are only compiled with TRACE_IS_ON, DEBUG messages with DEBUG_IS_ON: what is
+ * compiled out costs nothing in the first round.
+ *
+ * usage: log_macro_benchmark [number of messages, default 1000000]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "bstrlib.h"
+#include "common_defs.h"
+#include "gcc_diag.h"
+#include "log.h"
+
+#if !LOG_OAI
+#  error "log_macro_benchmark needs LOG_OAI"
+#endif
+
+#define LOG_BENCH_DEFAULT_MESSAGES       (1000000)
+#define LOG_BENCH_FUNCTION_DEPTH         (24)     /* function entries per message */
+#define LOG_BENCH_DEBUG_MESSAGES         (6)
+#define LOG_BENCH_INFO_MESSAGES          (2)
+#define LOG_BENCH_NAS_MESSAGE_LENGTH     (80)     /* octets of a plain attach request */
+
+static uint8_t                            g_nas_message[LOG_BENCH_NAS_MESSAGE_LENGTH];
+static volatile uint32_t                  g_ue_id = 0;
+
+//------------------------------------------------------------------------------
+static uint64_t log_bench_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void log_bench_report (const char *phase, uint64_t start_ns, uint64_t end_ns, uint32_t count)
+{
+  printf ("%-40s %8u msgs %10.2f ms %8.1f ns/msg\n", phase, count, (end_ns - start_ns) / 1e6, (double)(end_ns - start_ns) / count);
+}
+
+//------------------------------------------------------------------------------
+static int __attribute__ ((noinline)) log_bench_macros (int depth)
+{
+  OAILOG_FUNC_IN (LOG_NAS_EMM);
+  if (depth) {
+    int rc = log_bench_macros (depth - 1);
+    OAILOG_FUNC_RETURN (LOG_NAS_EMM, rc);
+  }
+  OAILOG_STREAM_HEX (OAILOG_LEVEL_DEBUG, LOG_NAS, "Incoming NAS message: ", g_nas_message, sizeof (g_nas_message));
+  for (int i = 0; i < LOG_BENCH_DEBUG_MESSAGES; i++) {
+    OAILOG_DEBUG (LOG_NAS_EMM, "ue_id=%u EMM-PROC  - step %d\n", g_ue_id, i);
+  }
+  for (int i = 0; i < LOG_BENCH_INFO_MESSAGES; i++) {
+    OAILOG_INFO (LOG_NAS_EMM, "ue_id=%u EMM-PROC  - state %d\n", g_ue_id, i);
+  }
+  OAILOG_FUNC_RETURN (LOG_NAS_EMM, RETURNok);
+}
+
+//------------------------------------------------------------------------------
+// What the macros expanded to before they tested the level
+static int __attribute__ ((noinline)) log_bench_calls (int depth)
+{
+  log_func (true, LOG_NAS_EMM, __FILE__, __LINE__, __FUNCTION__);
+  if (depth) {
+    int rc = log_bench_calls (depth - 1);
+    log_func_return (LOG_NAS_EMM, __FILE__, __LINE__, __FUNCTION__, (long)rc);
+    return rc;
+  }
+  log_stream_hex (OAILOG_LEVEL_DEBUG, LOG_NAS, __FILE__, __LINE__, "Incoming NAS message: ", (char *)g_nas_message, sizeof (g_nas_message));
+  for (int i = 0; i < LOG_BENCH_DEBUG_MESSAGES; i++) {
+    log_message (NULL, OAILOG_LEVEL_DEBUG, LOG_NAS_EMM, __FILE__, __LINE__, "ue_id=%u EMM-PROC  - step %d\n", g_ue_id, i);
+  }
+  for (int i = 0; i < LOG_BENCH_INFO_MESSAGES; i++) {
+    log_message (NULL, OAILOG_LEVEL_INFO, LOG_NAS_EMM, __FILE__, __LINE__, "ue_id=%u EMM-PROC  - state %d\n", g_ue_id, i);
+  }
+  log_func_return (LOG_NAS_EMM, __FILE__, __LINE__, __FUNCTION__, (long)RETURNok);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint32_t                                nb_messages = LOG_BENCH_DEFAULT_MESSAGES;
+  uint64_t                                start_ns = 0;
+  int                                     rc = RETURNok;
+
+  if (argc > 1) nb_messages = (uint32_t)strtoul (argv[1], NULL, 10);
+  if ((argc > 2) || !nb_messages) {
+    fprintf (stderr, "usage: %s [number of messages]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < MAX_LOG_PROTOS; i++) {
+    g_oai_log_level[i] = OAILOG_LEVEL_ERROR;
+  }
+  for (int i = 0; i < LOG_BENCH_NAS_MESSAGE_LENGTH; i++) {
+    g_nas_message[i] = (uint8_t)i;
+  }
+  printf ("%d function entries, %d DEBUG, %d INFO and a %d octets hex dump per message, levels at ERROR\n",
+          LOG_BENCH_FUNCTION_DEPTH + 1, LOG_BENCH_DEBUG_MESSAGES, LOG_BENCH_INFO_MESSAGES, LOG_BENCH_NAS_MESSAGE_LENGTH);
+
+  for (int round = 0; round < 2; round++) {
+    start_ns = log_bench_now_ns ();
+    for (uint32_t i = 0; i < nb_messages; i++) {
+      g_ue_id = i;
+      rc |= log_bench_macros (LOG_BENCH_FUNCTION_DEPTH);
+    }
+    if (round) log_bench_report ("macros, level tested inline", start_ns, log_bench_now_ns (), nb_messages);
+
+    start_ns = log_bench_now_ns ();
+    for (uint32_t i = 0; i < nb_messages; i++) {
+      g_ue_id = i;
+      rc |= log_bench_calls (LOG_BENCH_FUNCTION_DEPTH);
+    }
+    if (round) log_bench_report ("calls, level tested in log.c", start_ns, log_bench_now_ns (), nb_messages);
+  }
+  return (RETURNok == rc) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,296 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Classifies downlink IPv4 packets against N SDF filters (default 10000) with the
+ * tuple space classifier, and with a linear scan of the filters in precedence order,
+ * which is what the iptables mangle table does for each packet.
+ * The filters mix a few shapes, as PCC rules do: remote host and port, remote subnet,
+ * local port range, ESP SPI, TOS. Half of the packets match no filter.
+ * Both lookups must agree on every packet.
+ *
+ * usage: sdf_classifier_benchmark [number of filters, default 10000] [number of packets, default 1000000]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <netinet/in.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "3gpp_24.008.h"
+#include "sdf_classifier.h"
+
+#define SDF_BENCH_DEFAULT_FILTERS      (10000)
+#define SDF_BENCH_DEFAULT_PACKETS    (1000000)
+#define SDF_BENCH_LINEAR_PACKETS_MAX   (20000)   /* the linear scan is slow */
+#define SDF_BENCH_PACKET_SIZE             (28)
+#define SDF_BENCH_UE_NET          (0xAC100000)   /* 172.16.0.0/12, destination of the packets */
+#define SDF_BENCH_UE_PREFIX_LEN           (12)
+
+typedef struct sdf_bench_rule_s {
+  sdf_rule_t                    rule;
+  uint32_t                      sdf_id;
+  uint8_t                       precedence;
+} sdf_bench_rule_t;
+
+//------------------------------------------------------------------------------
+static uint64_t sdf_bench_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void sdf_bench_report (const char *phase, uint64_t start_ns, uint64_t end_ns, uint32_t count)
+{
+  double                                  elapsed_ms = (end_ns - start_ns) / 1e6;
+
+  printf ("%-32s %8u ops %10.2f ms %8.0f ns/op %10.0f ops/s\n", phase, count, elapsed_ms,
+          (double)(end_ns - start_ns) / count, count / (elapsed_ms / 1e3));
+}
+
+//------------------------------------------------------------------------------
+static void sdf_bench_remote_addr (packet_filter_contents_t * pfc, uint32_t addr, uint32_t mask)
+{
+  pfc->flags |= TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG;
+  for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+    pfc->ipv4remoteaddr[i].addr = (uint8_t)(addr >> (24 - 8 * i));
+    pfc->ipv4remoteaddr[i].mask = (uint8_t)(mask >> (24 - 8 * i));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void sdf_bench_filter (packet_filter_t * filter, uint32_t i)
+{
+  packet_filter_contents_t               *pfc = &filter->packetfiltercontents;
+
+  memset (filter, 0, sizeof (*filter));
+  filter->direction = TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL;
+  filter->eval_precedence = (uint8_t)(rand () & 0xFF);
+  switch (i % 5) {
+  case 0:                      /* remote server 10.x.y.z:port over UDP or TCP */
+    sdf_bench_remote_addr (pfc, 0x0A000000 | (i & 0xFFFFFF), 0xFFFFFFFF);
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG | TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG;
+    pfc->protocolidentifier_nextheader = (i & 1) ? IPPROTO_UDP : IPPROTO_TCP;
+    pfc->singleremoteport = 1024 + (i % 4096);
+    break;
+  case 1:                      /* remote subnet 11.x.y.0/24 */
+    sdf_bench_remote_addr (pfc, 0x0B000000 | ((i << 8) & 0xFFFF00), 0xFFFFFF00);
+    break;
+  case 2:                      /* UE port range */
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG | TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG;
+    pfc->protocolidentifier_nextheader = IPPROTO_UDP;
+    pfc->localportrange.lowlimit = 10000 + (i % 40000);
+    pfc->localportrange.highlimit = pfc->localportrange.lowlimit + 3;
+    break;
+  case 3:                      /* IPsec SA */
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG;
+    pfc->securityparameterindex = 0x1000 + i;
+    break;
+  default:                     /* remote host and DSCP */
+    sdf_bench_remote_addr (pfc, 0x0C000000 | (i & 0xFFFFFF), 0xFFFFFFFF);
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG;
+    pfc->typdeofservice_trafficclass.value = 0xB8;
+    pfc->typdeofservice_trafficclass.mask = 0xFC;
+    break;
+  }
+}
+
+//------------------------------------------------------------------------------
+static void sdf_bench_packet (uint8_t * packet, uint32_t nb_filters)
+{
+  uint32_t                                i = (uint32_t) rand () % nb_filters;
+  uint32_t                                src = 0;
+  uint16_t                                sport = (uint16_t) rand ();
+  uint16_t                                dport = (uint16_t) rand ();
+  uint32_t                                spi = (uint32_t) rand ();
+  uint8_t                                 proto = (rand () & 1) ? IPPROTO_UDP : IPPROTO_TCP;
+  uint8_t                                 tos = 0;
+
+  /* half of the packets are built from a filter */
+  if (rand () & 1) {
+    switch (i % 5) {
+    case 0:
+      src = 0x0A000000 | (i & 0xFFFFFF);
+      proto = (i & 1) ? IPPROTO_UDP : IPPROTO_TCP;
+      sport = 1024 + (i % 4096);
+      break;
+    case 1:
+      src = 0x0B000000 | ((i << 8) & 0xFFFF00) | (rand () & 0xFF);
+      break;
+    case 2:
+      proto = IPPROTO_UDP;
+      dport = 10000 + (i % 40000) + (rand () & 3);
+      break;
+    case 3:
+      proto = IPPROTO_ESP;
+      spi = 0x1000 + i;
+      break;
+    default:
+      src = 0x0C000000 | (i & 0xFFFFFF);
+      tos = 0xB9;
+      break;
+    }
+  }
+  if (!src) {
+    src = 0x0D000000 | ((uint32_t) rand () & 0xFFFFFF);
+  }
+  memset (packet, 0, SDF_BENCH_PACKET_SIZE);
+  packet[0] = 0x45;
+  packet[1] = tos;
+  packet[3] = SDF_BENCH_PACKET_SIZE;
+  packet[8] = 64;
+  packet[9] = proto;
+  packet[12] = (uint8_t)(src >> 24);
+  packet[13] = (uint8_t)(src >> 16);
+  packet[14] = (uint8_t)(src >> 8);
+  packet[15] = (uint8_t) src;
+  packet[16] = 172;
+  packet[17] = 16;
+  packet[19] = 2;
+  if (IPPROTO_ESP == proto) {
+    packet[20] = (uint8_t)(spi >> 24);
+    packet[21] = (uint8_t)(spi >> 16);
+    packet[22] = (uint8_t)(spi >> 8);
+    packet[23] = (uint8_t) spi;
+  } else {
+    packet[20] = (uint8_t)(sport >> 8);
+    packet[21] = (uint8_t) sport;
+    packet[22] = (uint8_t)(dport >> 8);
+    packet[23] = (uint8_t) dport;
+  }
+}
+
+//------------------------------------------------------------------------------
+static bool sdf_bench_rule_match (const sdf_rule_t * rule, const sdf_key_t * key)
+{
+  return ((key->src & rule->mask.src) == rule->value.src) && ((key->dst & rule->mask.dst) == rule->value.dst)
+      && ((key->spi & rule->mask.spi) == rule->value.spi) && ((key->proto & rule->mask.proto) == rule->value.proto)
+      && ((key->tos & rule->mask.tos) == rule->value.tos)
+      && ((key->sport & rule->mask.sport) == rule->value.sport) && ((key->dport & rule->mask.dport) == rule->value.dport)
+      && (key->sport >= rule->sport_min) && (key->sport <= rule->sport_max)
+      && (key->dport >= rule->dport_min) && (key->dport <= rule->dport_max);
+}
+
+//------------------------------------------------------------------------------
+static int sdf_bench_rule_compare (const void *a, const void *b)
+{
+  const sdf_bench_rule_t                 *ra = (const sdf_bench_rule_t *) a;
+  const sdf_bench_rule_t                 *rb = (const sdf_bench_rule_t *) b;
+
+  /* sdf ids follow the insertion order */
+  return (ra->precedence != rb->precedence) ? ((int) ra->precedence - (int) rb->precedence) : ((ra->sdf_id > rb->sdf_id) - (ra->sdf_id < rb->sdf_id));
+}
+
+//------------------------------------------------------------------------------
+static uint32_t sdf_bench_linear_lookup (const sdf_bench_rule_t * rules, uint32_t nb_rules, const sdf_key_t * key)
+{
+  for (uint32_t i = 0; i < nb_rules; i++) {
+    if (sdf_bench_rule_match (&rules[i].rule, key)) {
+      return rules[i].sdf_id;
+    }
+  }
+  return SDF_CLASSIFIER_NO_MATCH;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint32_t                                nb_filters = (argc > 1) ? (uint32_t) strtoul (argv[1], NULL, 10) : SDF_BENCH_DEFAULT_FILTERS;
+  uint32_t                                nb_packets = (argc > 2) ? (uint32_t) strtoul (argv[2], NULL, 10) : SDF_BENCH_DEFAULT_PACKETS;
+  uint32_t                                nb_linear = 0;
+  sdf_classifier_t                       *classifier = NULL;
+  sdf_bench_rule_t                       *rules = NULL;
+  sdf_key_t                              *keys = NULL;
+  uint8_t                                 packet[SDF_BENCH_PACKET_SIZE];
+  packet_filter_t                         filter;
+  uint64_t                                start = 0;
+  uint32_t                                nb_matches = 0;
+  uint32_t                                nb_mismatches = 0;
+  volatile uint32_t                       sink = 0;
+
+  if ((!nb_filters) || (!nb_packets)) {
+    fprintf (stderr, "usage: %s [number of filters] [number of packets]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  nb_linear = (nb_packets < SDF_BENCH_LINEAR_PACKETS_MAX) ? nb_packets : SDF_BENCH_LINEAR_PACKETS_MAX;
+  classifier = sdf_classifier_create ();
+  rules = calloc (nb_filters, sizeof (sdf_bench_rule_t));
+  keys = calloc (nb_packets, sizeof (sdf_key_t));
+  if ((!classifier) || (!rules) || (!keys)) {
+    fprintf (stderr, "Initialization failed\n");
+    return EXIT_FAILURE;
+  }
+
+  srand (10000);
+  start = sdf_bench_now_ns ();
+  for (uint32_t i = 0; i < nb_filters; i++) {
+    sdf_bench_filter (&filter, i);
+    rules[i].sdf_id = i + 1;
+    if ((RETURNok != sdf_classifier_rule_from_packet_filter (&filter, SDF_BENCH_UE_NET, SDF_BENCH_UE_PREFIX_LEN, &rules[i].rule))
+        || (RETURNok != sdf_classifier_add_rule (classifier, &rules[i].rule, rules[i].sdf_id, filter.eval_precedence))) {
+      fprintf (stderr, "Filter %u rejected\n", i);
+      return EXIT_FAILURE;
+    }
+    rules[i].precedence = filter.eval_precedence;
+  }
+  sdf_bench_report ("Add filter", start, sdf_bench_now_ns (), nb_filters);
+  printf ("%u filters in %u tuples\n", sdf_classifier_nb_rules (classifier), sdf_classifier_nb_tuples (classifier));
+  qsort (rules, nb_filters, sizeof (sdf_bench_rule_t), sdf_bench_rule_compare);
+
+  for (uint32_t i = 0; i < nb_packets; i++) {
+    sdf_bench_packet (packet, nb_filters);
+    sdf_classifier_key_from_ipv4 (packet, SDF_BENCH_PACKET_SIZE, &keys[i]);
+  }
+
+  start = sdf_bench_now_ns ();
+  for (uint32_t i = 0; i < nb_packets; i++) {
+    sink += sdf_classifier_lookup (classifier, &keys[i]);
+  }
+  sdf_bench_report ("Tuple space lookup", start, sdf_bench_now_ns (), nb_packets);
+
+  start = sdf_bench_now_ns ();
+  for (uint32_t i = 0; i < nb_linear; i++) {
+    sink += sdf_bench_linear_lookup (rules, nb_filters, &keys[i]);
+  }
+  sdf_bench_report ("Linear lookup", start, sdf_bench_now_ns (), nb_linear);
+
+  for (uint32_t i = 0; i < nb_linear; i++) {
+    uint32_t sdf_id = sdf_classifier_lookup (classifier, &keys[i]);
+
+    nb_matches += (SDF_CLASSIFIER_NO_MATCH != sdf_id);
+    nb_mismatches += (sdf_id != sdf_bench_linear_lookup (rules, nb_filters, &keys[i]));
+  }
+  printf ("%u packets checked, %u in a SDF, %u mismatches\n", nb_linear, nb_matches, nb_mismatches);
+
+  sdf_classifier_destroy (&classifier);
+  free (rules);
+  free (keys);
+  return (nb_mismatches) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
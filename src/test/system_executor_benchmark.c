@@ -0,0 +1,221 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*
+ * Latency of the commands run by the SPGW when bearers are set up, with a shell and a process per
+ * command (C system()) and with the system executor (native rtnetlink, one iptables-restore transaction).
+ * A route to each UE address is added on a TUN device, then, if iptables-restore is installed, the
+ * downlink marking rule of one dedicated bearer per UE (the command of the SPGW on a Create Bearer
+ * Response) is added and removed in the mangle table.
+ * The rules are added as a burst of bearer setups reaching TASK_ASYNC_SYSTEM at once: the setup latency
+ * of a bearer is the time from the start of the burst until its rule is installed.
+ * Must be run as root, the TUN device and the rules are removed at exit.
+ *
+ * usage: system_executor_benchmark [number of bearers, default 200]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "bstrlib.h"
+
+#include "common_defs.h"
+#include "system_executor.h"
+
+#define SE_BENCH_DEFAULT_BEARERS         (200)
+#define SE_BENCH_DEVNAME          "oaibench0"
+
+//------------------------------------------------------------------------------
+static uint64_t se_bench_now_ns (void)
+{
+  struct timespec                         ts = {0};
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+static void se_bench_report (const char *phase, uint64_t start_ns, uint64_t end_ns, uint32_t count)
+{
+  double                                  elapsed_ms = (end_ns - start_ns) / 1e6;
+
+  printf ("%-40s %6u ops %10.2f ms %10.0f ns/op\n", phase, count, elapsed_ms, (double)(end_ns - start_ns) / count);
+}
+
+//------------------------------------------------------------------------------
+static int se_bench_tun_open (void)
+{
+  struct ifreq                            ifr = {.ifr_flags = IFF_TUN | IFF_NO_PI};
+  int                                     fd = open ("/dev/net/tun", O_RDWR);
+
+  if (0 > fd) return -1;
+  strncpy (ifr.ifr_name, SE_BENCH_DEVNAME, IFNAMSIZ - 1);
+  if (ioctl (fd, TUNSETIFF, &ifr)) {
+    close (fd);
+    return -1;
+  }
+  return fd;
+}
+
+//------------------------------------------------------------------------------
+static int se_bench_count_routes (void)
+{
+  char                                    line[256];
+  int                                     count = 0;
+  FILE                                   *f = popen ("ip route show dev " SE_BENCH_DEVNAME, "r");
+
+  if (!f) return -1;
+  while (fgets (line, sizeof (line), f)) count++;
+  pclose (f);
+  return count;
+}
+
+//------------------------------------------------------------------------------
+static bstring se_bench_ue_command (const char *format, uint32_t bearer)
+{
+  return bformat (format, 10 + (bearer >> 16), (bearer >> 8) & 0xFF, bearer & 0xFF);
+}
+
+//------------------------------------------------------------------------------
+static int se_bench_routes (uint32_t nb_bearers, bool is_native)
+{
+  uint64_t                                start_ns = se_bench_now_ns ();
+
+  for (uint32_t i = 0; i < nb_bearers; i++) {
+    bstring                               command = se_bench_ue_command ("ip route add 10.%u.%u.%u/32 dev " SE_BENCH_DEVNAME, i + (is_native ? nb_bearers : 0));
+    int                                   rc = is_native ? system_executor_run (bdata (command)) : system (bdata (command));
+
+    if (rc) {
+      fprintf (stderr, "%s failed: %d\n", bdata (command), rc);
+      bdestroy (command);
+      return RETURNerror;
+    }
+    bdestroy (command);
+  }
+  se_bench_report (is_native ? "ip route add, executor" : "ip route add, system()", start_ns, se_bench_now_ns (), nb_bearers);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+static void se_bench_latency_report (const char *phase, const uint64_t * const latency_ns, uint32_t count)
+{
+  uint64_t                                sum_ns = 0;
+  uint64_t                                max_ns = 0;
+
+  for (uint32_t i = 0; i < count; i++) {
+    sum_ns += latency_ns[i];
+    if (latency_ns[i] > max_ns) max_ns = latency_ns[i];
+  }
+  printf ("%-40s %6u bearers %8.2f ms mean %8.2f ms max\n", phase, count, sum_ns / 1e6 / count, max_ns / 1e6);
+}
+
+//------------------------------------------------------------------------------
+static int se_bench_marks (uint32_t nb_bearers, const char *action, bool is_native)
+{
+  system_executor_batch_t                 batch = {.nb_commands = 0};
+  uint64_t                               *latency_ns = calloc (nb_bearers, sizeof (uint64_t));
+  uint32_t                                nb_installed = 0;
+  uint64_t                                start_ns = se_bench_now_ns ();
+  char                                    phase[64];
+  int                                     rc = 0;
+
+  if (!latency_ns) return RETURNerror;
+  for (uint32_t i = 0; (i < nb_bearers) && !rc; i++) {
+    bstring                               command = bformat ("iptables %s POSTROUTING -t mangle --out-interface " SE_BENCH_DEVNAME
+                                                             " --dest 10.%u.%u.%u/32 -m mark --mark 0x%04X -j MARK --set-mark %u", action,
+                                                             10 + (i >> 16), (i >> 8) & 0xFF, i & 0xFF, (i & 0xFFFF) + 1, 5 + (i % 11));
+
+    if (!is_native) {
+      rc = system (bdata (command));
+      latency_ns[nb_installed++] = se_bench_now_ns () - start_ns;
+    } else if (RETURNok != system_executor_batch_add (&batch, bdata (command))) {
+      // full batch, its bearers are set up now
+      rc = system_executor_batch_commit (&batch);
+      for (uint64_t now_ns = se_bench_now_ns (); nb_installed < i; nb_installed++) latency_ns[nb_installed] = now_ns - start_ns;
+      if (!rc && (RETURNok != system_executor_batch_add (&batch, bdata (command)))) rc = -1;
+    }
+    bdestroy (command);
+  }
+  if (!rc && is_native) {
+    rc = system_executor_batch_commit (&batch);
+    for (uint64_t now_ns = se_bench_now_ns (); nb_installed < nb_bearers; nb_installed++) latency_ns[nb_installed] = now_ns - start_ns;
+  }
+  system_executor_batch_clear (&batch);
+  snprintf (phase, sizeof (phase), "iptables %s, %s", action, is_native ? "executor" : "system()");
+  if (rc) {
+    fprintf (stderr, "%s failed: %d\n", phase, rc);
+    free (latency_ns);
+    return RETURNerror;
+  }
+  se_bench_report (phase, start_ns, se_bench_now_ns (), nb_bearers);
+  if ('A' == action[1]) {
+    snprintf (phase, sizeof (phase), "bearer setup, %s", is_native ? "executor" : "system()");
+    se_bench_latency_report (phase, latency_ns, nb_bearers);
+  }
+  free (latency_ns);
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+int main (int argc, char *argv[])
+{
+  uint32_t                                nb_bearers = SE_BENCH_DEFAULT_BEARERS;
+  int                                     tun_fd = -1;
+  int                                     rc = EXIT_SUCCESS;
+
+  if (argc > 1) nb_bearers = (uint32_t)strtoul (argv[1], NULL, 10);
+  if ((argc > 2) || !nb_bearers || (nb_bearers > 0x7FFFFF)) {
+    fprintf (stderr, "usage: %s [number of bearers]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  if (0 > (tun_fd = se_bench_tun_open ())) {
+    fprintf (stderr, "Cannot create TUN device %s (must be run as root)\n", SE_BENCH_DEVNAME);
+    return EXIT_FAILURE;
+  }
+  if (system_executor_run ("ip link set dev " SE_BENCH_DEVNAME " mtu 1400 up")
+      || (RETURNok != se_bench_routes (nb_bearers, false))
+      || (RETURNok != se_bench_routes (nb_bearers, true))) {
+    rc = EXIT_FAILURE;
+  } else if (se_bench_count_routes () != (int)(2 * nb_bearers)) {
+    fprintf (stderr, "%d routes on %s, %u expected\n", se_bench_count_routes (), SE_BENCH_DEVNAME, 2 * nb_bearers);
+    rc = EXIT_FAILURE;
+  }
+
+  if ((EXIT_SUCCESS == rc) && !system ("iptables-restore --version > /dev/null 2>&1")) {
+    if ((RETURNok != se_bench_marks (nb_bearers, "-A", false)) || (RETURNok != se_bench_marks (nb_bearers, "-D", false))
+        || (RETURNok != se_bench_marks (nb_bearers, "-A", true)) || (RETURNok != se_bench_marks (nb_bearers, "-D", true))) {
+      rc = EXIT_FAILURE;
+    }
+  } else if (EXIT_SUCCESS == rc) {
+    printf ("iptables-restore not found, marking rules skipped\n");
+  }
+  close (tun_fd);
+  return rc;
+}
@@ -0,0 +1,442 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "common_types.h"
+#include "common_defs.h"
+#include "3gpp_24.008.h"
+#include "gtpv1u.h"
+#include "gtpu_forwarder.h"
+
+/*
+ * The forwarder is driven by pcap files: the input capture holds Ethernet frames seen by the S-GW,
+ * GTP-U datagrams to port 2152 from the eNBs and IPv4 packets to the UEs from the SGi network.
+ * What the forwarder outputs is written as a raw IP capture (G-PDUs wrapped in IPv4/UDP) which
+ * can be opened in Wireshark, and read back for the checks.
+ */
+#define TEST_PCAP_LINKTYPE_ETHERNET     1
+#define TEST_PCAP_LINKTYPE_RAW        101
+#define TEST_PACKET_SIZE_MAX         2048
+#define TEST_HEADROOM                  64
+#define TEST_OUTPUTS_MAX               16
+#define TEST_GTPU_PORT               2152
+
+#define TEST_SGW   "192.168.11.17"
+#define TEST_ENB   "192.168.11.30"
+#define TEST_UE    "172.16.0.2"
+#define TEST_UE2   "172.16.0.3"
+#define TEST_UE_NET    "172.16.0.0"
+#define TEST_UE_PREFIX 12
+#define TEST_PEER  "8.8.8.8"
+
+typedef struct test_packet_s {
+  uint8_t  data[TEST_PACKET_SIZE_MAX];
+  uint32_t len;
+} test_packet_t;
+
+static gtpu_fwd_stats_t stats;
+
+//------------------------------------------------------------------------------
+// pcap files
+//------------------------------------------------------------------------------
+static FILE *test_pcap_create(char * const path, const uint32_t linktype)
+{
+  uint32_t global_header[6] = {0xa1b2c3d4, 0x00040002, 0, 0, 65535, linktype};
+  int      fd = mkstemp(path);
+  FILE    *fp = NULL;
+
+  ck_assert(fd >= 0);
+  fp = fdopen(fd, "w+");
+  ck_assert(fp != NULL);
+  ck_assert_uint_eq(fwrite(global_header, sizeof(global_header), 1, fp), 1);
+  return fp;
+}
+
+static void test_pcap_write(FILE * const fp, const uint8_t * const data, const uint32_t len)
+{
+  static uint32_t ts = 0;
+  uint32_t        record_header[4] = {++ts, 0, len, len};
+
+  ck_assert_uint_eq(fwrite(record_header, sizeof(record_header), 1, fp), 1);
+  ck_assert_uint_eq(fwrite(data, len, 1, fp), 1);
+}
+
+// Next record of a pcap file, false at the end
+static bool test_pcap_read(FILE * const fp, uint8_t * const data, uint32_t * const len)
+{
+  uint32_t record_header[4];
+
+  if (fread(record_header, sizeof(record_header), 1, fp) != 1) {
+    return false;
+  }
+  ck_assert(record_header[2] <= TEST_PACKET_SIZE_MAX);
+  ck_assert_uint_eq(fread(data, record_header[2], 1, fp), 1);
+  *len = record_header[2];
+  return true;
+}
+
+static uint32_t test_pcap_read_all(FILE * const fp, const uint32_t linktype, test_packet_t * const packets, const uint32_t max)
+{
+  uint32_t global_header[6];
+  uint32_t n = 0;
+
+  rewind(fp);
+  ck_assert_uint_eq(fread(global_header, sizeof(global_header), 1, fp), 1);
+  ck_assert_uint_eq(global_header[0], 0xa1b2c3d4);
+  ck_assert_uint_eq(global_header[5], linktype);
+  while ((n < max) && test_pcap_read(fp, packets[n].data, &packets[n].len)) {
+    n++;
+  }
+  return n;
+}
+
+//------------------------------------------------------------------------------
+// packet builders
+//------------------------------------------------------------------------------
+static uint16_t test_ip_checksum(const uint8_t * const header, const uint32_t len)
+{
+  uint32_t sum = 0;
+
+  for (uint32_t i = 0; i < len; i += 2) {
+    sum += ((uint32_t)header[i] << 8) | header[i + 1];
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xFFFF) + (sum >> 16);
+  }
+  return (uint16_t)~sum;
+}
+
+static uint32_t test_ipv4(uint8_t * const buf, const char * const src, const char * const dst, const uint8_t proto, const uint32_t payload_len)
+{
+  uint16_t checksum = 0;
+
+  memset(buf, 0, 20);
+  buf[0] = 0x45;
+  buf[2] = (uint8_t)((20 + payload_len) >> 8);
+  buf[3] = (uint8_t)(20 + payload_len);
+  buf[8] = 64;
+  buf[9] = proto;
+  inet_pton(AF_INET, src, &buf[12]);
+  inet_pton(AF_INET, dst, &buf[16]);
+  checksum = test_ip_checksum(buf, 20);
+  buf[10] = (uint8_t)(checksum >> 8);
+  buf[11] = (uint8_t)checksum;
+  return 20 + payload_len;
+}
+
+// IPv4/UDP datagram with a payload of len bytes
+static uint32_t test_udp(uint8_t * const buf, const char * const src, const char * const dst, const uint16_t port, const uint8_t * const payload, const uint32_t len)
+{
+  uint8_t *udp = &buf[20];
+
+  udp[0] = (uint8_t)(port >> 8);
+  udp[1] = (uint8_t)port;
+  udp[2] = (uint8_t)(port >> 8);
+  udp[3] = (uint8_t)port;
+  udp[4] = (uint8_t)((8 + len) >> 8);
+  udp[5] = (uint8_t)(8 + len);
+  udp[6] = 0;
+  udp[7] = 0;
+  memmove(&udp[8], payload, len);
+  return test_ipv4(buf, src, dst, 17, 8 + len);
+}
+
+static uint32_t test_inner(uint8_t * const buf, const char * const src, const char * const dst, const uint32_t payload_len)
+{
+  for (uint32_t i = 0; i < payload_len; i++) {
+    buf[20 + i] = (uint8_t)i;
+  }
+  return test_ipv4(buf, src, dst, 1, payload_len);
+}
+
+// G-PDU, with a PDCP PDU number extension header if ext
+static uint32_t test_gpdu(uint8_t * const buf, const uint32_t teid, const bool ext, const uint8_t * const inner, const uint32_t inner_len)
+{
+  uint32_t header_len = ext ? 16 : 8;
+
+  buf[0] = ext ? 0x34 : 0x30;
+  buf[1] = GTPU_MSG_TYPE_G_PDU;
+  buf[2] = (uint8_t)((header_len - 8 + inner_len) >> 8);
+  buf[3] = (uint8_t)(header_len - 8 + inner_len);
+  buf[4] = (uint8_t)(teid >> 24);
+  buf[5] = (uint8_t)(teid >> 16);
+  buf[6] = (uint8_t)(teid >> 8);
+  buf[7] = (uint8_t)teid;
+  if (ext) {
+    memset(&buf[8], 0, 8);
+    buf[11] = 0xC0;     // PDCP PDU number
+    buf[12] = 1;
+    buf[13] = 0x12;
+    buf[14] = 0x34;
+    buf[15] = 0;        // no more extension header
+  }
+  memcpy(&buf[header_len], inner, inner_len);
+  return header_len + inner_len;
+}
+
+static void test_ethernet_write(FILE * const fp, const uint8_t * const ip, const uint32_t len)
+{
+  uint8_t frame[14 + TEST_PACKET_SIZE_MAX] = {0x02, 0, 0, 0, 0, 1, 0x02, 0, 0, 0, 0, 2, 0x08, 0x00};
+
+  memcpy(&frame[14], ip, len);
+  test_pcap_write(fp, frame, 14 + len);
+}
+
+//------------------------------------------------------------------------------
+// harness
+//------------------------------------------------------------------------------
+/*
+ * Feed the Ethernet frames of a capture to the forwarder, UDP port 2152 datagrams to the uplink,
+ * other IPv4 packets to the downlink. The output capture is read back into outputs.
+ */
+static uint32_t test_replay(gtpu_forwarder_t * const fwd, FILE * const in, test_packet_t * const outputs)
+{
+  char     out_path[] = "/tmp/test_gtpu_forwarder_out_XXXXXX";
+  FILE    *out = test_pcap_create(out_path, TEST_PCAP_LINKTYPE_RAW);
+  uint8_t  frame[TEST_PACKET_SIZE_MAX];
+  uint8_t  buffer[TEST_HEADROOM + TEST_PACKET_SIZE_MAX];
+  uint8_t  wrapped[TEST_PACKET_SIZE_MAX];
+  uint32_t global_header[6];
+  uint32_t len = 0;
+  uint32_t nb_outputs = 0;
+
+  rewind(in);
+  ck_assert_uint_eq(fread(global_header, sizeof(global_header), 1, in), 1);
+  ck_assert_uint_eq(global_header[5], TEST_PCAP_LINKTYPE_ETHERNET);
+  while (test_pcap_read(in, frame, &len)) {
+    const uint8_t     *ip = &frame[14];
+    uint32_t           ip_len = len - 14;
+    uint32_t           ihl = (ip[0] & 0x0F) * 4;
+    uint8_t           *out_data = NULL;
+    uint32_t           out_len = 0;
+    struct in_addr     enb = {.s_addr = INADDR_ANY};
+    char               peer[INET_ADDRSTRLEN];
+    gtpu_fwd_action_t  action = GTPU_FWD_DROP;
+
+    ck_assert(len > 14 && frame[12] == 0x08 && frame[13] == 0x00);
+    gtpu_forwarder_read_lock(fwd);
+    if ((ip[9] == 17) && (((ip[ihl + 2] << 8) | ip[ihl + 3]) == TEST_GTPU_PORT)) {
+      // S1-U: UDP payload
+      memcpy(buffer, &ip[ihl + 8], ip_len - ihl - 8);
+      action = gtpu_forwarder_uplink(fwd, buffer, ip_len - ihl - 8, &out_data, &out_len, &stats);
+      inet_ntop(AF_INET, &ip[12], peer, sizeof(peer));
+    } else {
+      // SGi: IP packet
+      memcpy(&buffer[TEST_HEADROOM], ip, ip_len);
+      action = gtpu_forwarder_downlink(fwd, &buffer[TEST_HEADROOM], ip_len, &out_data, &out_len, &enb, &stats);
+      inet_ntop(AF_INET, &enb, peer, sizeof(peer));
+    }
+    gtpu_forwarder_read_unlock(fwd);
+
+    if (GTPU_FWD_TO_SGI == action) {
+      test_pcap_write(out, out_data, out_len);
+    } else if (GTPU_FWD_TO_S1U == action) {
+      test_pcap_write(out, wrapped, test_udp(wrapped, TEST_SGW, peer, TEST_GTPU_PORT, out_data, out_len));
+    }
+  }
+  fflush(out);
+  nb_outputs = test_pcap_read_all(out, TEST_PCAP_LINKTYPE_RAW, outputs, TEST_OUTPUTS_MAX);
+  fclose(out);
+  unlink(out_path);
+  return nb_outputs;
+}
+
+static gtpu_forwarder_t *test_forwarder(void)
+{
+  gtpu_forwarder_t        *fwd = gtpu_forwarder_create("test", 16, 7);
+  struct gtp_tunnel_entry  tunnels[2] = {
+    {.i_tei = 0x100, .o_tei = 0xA00},
+    {.i_tei = 0x101, .o_tei = 0xA01},   // dedicated bearer of the same UE
+  };
+
+  ck_assert(fwd != NULL);
+  for (int i = 0; i < 2; i++) {
+    inet_pton(AF_INET, TEST_UE, &tunnels[i].ue);
+    inet_pton(AF_INET, TEST_ENB, &tunnels[i].enb);
+  }
+  ck_assert_int_eq(gtpu_forwarder_add_tunnels(fwd, tunnels, 2), RETURNok);
+  ck_assert_uint_eq(gtpu_forwarder_nb_tunnels(fwd), 2);
+  memset(&stats, 0, sizeof(stats));
+  return fwd;
+}
+
+//------------------------------------------------------------------------------
+START_TEST(gtpu_forwarder_uplink_test)
+{
+  gtpu_forwarder_t *fwd = test_forwarder();
+  char              in_path[] = "/tmp/test_gtpu_forwarder_in_XXXXXX";
+  FILE             *in = test_pcap_create(in_path, TEST_PCAP_LINKTYPE_ETHERNET);
+  uint8_t           inner[256];
+  uint8_t           spoofed[256];
+  uint8_t           gtp[512];
+  uint8_t           ip[600];
+  uint32_t          inner_len = test_inner(inner, TEST_UE, TEST_PEER, 100);
+  uint32_t          spoofed_len = test_inner(spoofed, TEST_UE2, TEST_PEER, 100);
+  test_packet_t     outputs[TEST_OUTPUTS_MAX];
+
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, gtp, test_gpdu(gtp, 0x100, false, inner, inner_len)));
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, gtp, test_gpdu(gtp, 0x101, true, inner, inner_len)));
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, gtp, test_gpdu(gtp, 0x999, false, inner, inner_len)));
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, gtp, test_gpdu(gtp, 0x100, false, spoofed, spoofed_len)));
+  // length field larger than the datagram
+  test_gpdu(gtp, 0x100, false, inner, inner_len);
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, gtp, 8 + inner_len - 1));
+
+  // both bearers decapsulated, then dropped
+  ck_assert_uint_eq(test_replay(fwd, in, outputs), 2);
+  for (int i = 0; i < 2; i++) {
+    ck_assert_uint_eq(outputs[i].len, inner_len);
+    ck_assert(!memcmp(outputs[i].data, inner, inner_len));
+  }
+  ck_assert_uint_eq(stats.ul_packets, 2);
+  ck_assert_uint_eq(stats.ul_bytes, 2 * inner_len);
+  ck_assert_uint_eq(stats.drop_unknown_teid, 1);
+  ck_assert_uint_eq(stats.drop_spoofed, 1);
+  ck_assert_uint_eq(stats.drop_malformed, 1);
+  fclose(in);
+  unlink(in_path);
+  gtpu_forwarder_destroy(&fwd);
+  ck_assert(fwd == NULL);
+}
+END_TEST
+
+START_TEST(gtpu_forwarder_downlink_test)
+{
+  gtpu_forwarder_t        *fwd = test_forwarder();
+  char                     in_path[] = "/tmp/test_gtpu_forwarder_in_XXXXXX";
+  FILE                    *in = test_pcap_create(in_path, TEST_PCAP_LINKTYPE_ETHERNET);
+  uint8_t                  inner[256];
+  uint8_t                  other[256];
+  uint32_t                 inner_len = test_inner(inner, TEST_PEER, TEST_UE, 200);
+  uint32_t                 other_len = test_inner(other, TEST_PEER, TEST_UE2, 200);
+  test_packet_t            outputs[TEST_OUTPUTS_MAX];
+  struct gtp_tunnel_entry  default_bearer = {.i_tei = 0x100};
+  const uint8_t           *gtp = NULL;
+
+  test_ethernet_write(in, inner, inner_len);
+  test_ethernet_write(in, other, other_len);
+  ck_assert_uint_eq(test_replay(fwd, in, outputs), 1);
+  // G-PDU to the eNB on the default bearer
+  ck_assert_uint_eq(outputs[0].len, 20 + 8 + GTPU_FWD_HEADER_SIZE + inner_len);
+  ck_assert(!memcmp(&outputs[0].data[16], (uint8_t[]){192, 168, 11, 30}, 4));
+  gtp = &outputs[0].data[28];
+  ck_assert_uint_eq(gtp[0], 0x30);
+  ck_assert_uint_eq(gtp[1], GTPU_MSG_TYPE_G_PDU);
+  ck_assert_uint_eq((gtp[2] << 8) | gtp[3], inner_len);
+  ck_assert(!memcmp(&gtp[4], (uint8_t[]){0, 0, 0x0A, 0x00}, 4));
+  ck_assert(!memcmp(&gtp[8], inner, inner_len));
+  ck_assert_uint_eq(stats.dl_packets, 1);
+  ck_assert_uint_eq(stats.drop_unknown_ue, 1);
+
+  // the dedicated bearer takes over the downlink when the default one is deleted
+  ck_assert_int_eq(gtpu_forwarder_del_tunnels(fwd, &default_bearer, 1), RETURNok);
+  ck_assert_int_eq(gtpu_forwarder_del_tunnels(fwd, &default_bearer, 1), RETURNerror);
+  ck_assert_uint_eq(test_replay(fwd, in, outputs), 1);
+  ck_assert(!memcmp(&outputs[0].data[28 + 4], (uint8_t[]){0, 0, 0x0A, 0x01}, 4));
+  fclose(in);
+  unlink(in_path);
+  gtpu_forwarder_destroy(&fwd);
+}
+END_TEST
+
+START_TEST(gtpu_forwarder_sdf_test)
+{
+  gtpu_forwarder_t *fwd = test_forwarder();
+  char              in_path[] = "/tmp/test_gtpu_forwarder_in_XXXXXX";
+  FILE             *in = test_pcap_create(in_path, TEST_PCAP_LINKTYPE_ETHERNET);
+  uint8_t           inner[256];
+  uint8_t           sip[256];
+  uint8_t           payload[32] = {0};
+  uint8_t           peer[4];
+  test_packet_t     outputs[TEST_OUTPUTS_MAX];
+  packet_filter_t   filter = {.direction = TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL, .eval_precedence = 1};
+  struct in_addr    ue_net;
+
+  // SIP from the peer on the dedicated bearer
+  filter.packetfiltercontents.flags = TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG | TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG
+                                    | TRAFFIC_FLOW_TEMPLATE_SINGLE_LOCAL_PORT_FLAG;
+  inet_pton(AF_INET, TEST_PEER, peer);
+  inet_pton(AF_INET, TEST_UE_NET, &ue_net);
+  for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+    filter.packetfiltercontents.ipv4remoteaddr[i].addr = peer[i];
+    filter.packetfiltercontents.ipv4remoteaddr[i].mask = 0xFF;
+  }
+  filter.packetfiltercontents.protocolidentifier_nextheader = 17;
+  filter.packetfiltercontents.singlelocalport = 5060;
+  ck_assert_int_eq(gtpu_forwarder_add_sdf_filter(fwd, &filter, ue_net, TEST_UE_PREFIX, 42), RETURNok);
+  ck_assert_int_eq(gtpu_forwarder_add_bearer_sdf(fwd, 0x101, 42), RETURNok);
+  ck_assert_int_eq(gtpu_forwarder_add_bearer_sdf(fwd, 0x999, 42), RETURNerror);
+
+  test_ethernet_write(in, sip, test_udp(sip, TEST_PEER, TEST_UE, 5060, payload, sizeof(payload)));
+  test_ethernet_write(in, inner, test_inner(inner, TEST_PEER, TEST_UE, 100));
+  test_ethernet_write(in, sip, test_udp(sip, TEST_UE2, TEST_UE, 5060, payload, sizeof(payload)));
+  ck_assert_uint_eq(test_replay(fwd, in, outputs), 3);
+  ck_assert(!memcmp(&outputs[0].data[28 + 4], (uint8_t[]){0, 0, 0x0A, 0x01}, 4));
+  ck_assert(!memcmp(&outputs[1].data[28 + 4], (uint8_t[]){0, 0, 0x0A, 0x00}, 4));
+  ck_assert(!memcmp(&outputs[2].data[28 + 4], (uint8_t[]){0, 0, 0x0A, 0x00}, 4));
+  fclose(in);
+  unlink(in_path);
+  gtpu_forwarder_destroy(&fwd);
+}
+END_TEST
+
+START_TEST(gtpu_forwarder_echo_test)
+{
+  gtpu_forwarder_t *fwd = test_forwarder();
+  char              in_path[] = "/tmp/test_gtpu_forwarder_in_XXXXXX";
+  FILE             *in = test_pcap_create(in_path, TEST_PCAP_LINKTYPE_ETHERNET);
+  uint8_t           echo[12] = {0x32, GTPU_MSG_TYPE_ECHO_REQUEST, 0, 4, 0, 0, 0, 0, 0xBE, 0xEF, 0, 0};
+  uint8_t           ip[64];
+  test_packet_t     outputs[TEST_OUTPUTS_MAX];
+  const uint8_t     response[GTPU_FWD_ECHO_RESPONSE_SIZE] = {0x32, GTPU_MSG_TYPE_ECHO_RESPONSE, 0, 6, 0, 0, 0, 0, 0xBE, 0xEF, 0, 0, 14, 7};
+
+  test_ethernet_write(in, ip, test_udp(ip, TEST_ENB, TEST_SGW, TEST_GTPU_PORT, echo, sizeof(echo)));
+  ck_assert_uint_eq(test_replay(fwd, in, outputs), 1);
+  ck_assert_uint_eq(outputs[0].len, 28 + GTPU_FWD_ECHO_RESPONSE_SIZE);
+  ck_assert(!memcmp(&outputs[0].data[16], (uint8_t[]){192, 168, 11, 30}, 4));
+  ck_assert(!memcmp(&outputs[0].data[28], response, sizeof(response)));
+  ck_assert_uint_eq(stats.echo_requests, 1);
+  fclose(in);
+  unlink(in_path);
+  gtpu_forwarder_destroy(&fwd);
+}
+END_TEST
+
+Suite * gtpu_forwarder_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("GTP-U forwarder tests");
+
+    /* Core test case */
+    tc_core = tcase_create("GTP-U forwarder test");
+    tcase_add_test(tc_core, gtpu_forwarder_uplink_test);
+    tcase_add_test(tc_core, gtpu_forwarder_downlink_test);
+    tcase_add_test(tc_core, gtpu_forwarder_sdf_test);
+    tcase_add_test(tc_core, gtpu_forwarder_echo_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = gtpu_forwarder_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,115 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/types.h>
+
+#include "log_binary.h"
+
+#define TEST_LOG_BIN_BUFFER_SIZE 4096
+
+static void check_round_trip(const char *format, ...)
+{
+    uint8_t arg_types[LOG_BIN_MAX_ARGS];
+    uint8_t packed_args[TEST_LOG_BIN_BUFFER_SIZE];
+    char    rendered[TEST_LOG_BIN_BUFFER_SIZE];
+    char    expected[TEST_LOG_BIN_BUFFER_SIZE];
+    va_list args;
+    size_t  packed_length;
+    int     num_args;
+
+    num_args = log_bin_parse_format(format, arg_types, LOG_BIN_MAX_ARGS);
+    ck_assert(num_args >= 0);
+
+    va_start(args, format);
+    packed_length = log_bin_pack_args(packed_args, sizeof(packed_args), arg_types, num_args, args);
+    va_end(args);
+
+    va_start(args, format);
+    vsnprintf(expected, sizeof(expected), format, args);
+    va_end(args);
+
+    ck_assert(log_bin_render(rendered, sizeof(rendered), format, arg_types, num_args, packed_args, packed_length) >= 0);
+    ck_assert_str_eq(rendered, expected);
+}
+
+START_TEST(log_binary_parse_format_test)
+{
+    uint8_t arg_types[LOG_BIN_MAX_ARGS];
+
+    ck_assert_int_eq(log_bin_parse_format("no argument %%\n", arg_types, LOG_BIN_MAX_ARGS), 0);
+    ck_assert_int_eq(log_bin_parse_format("%d %lu %s %p %f", arg_types, LOG_BIN_MAX_ARGS), 5);
+    ck_assert_int_eq(arg_types[0], LOG_BIN_ARG_INT32);
+    ck_assert_int_eq(arg_types[1], LOG_BIN_ARG_INT64);
+    ck_assert_int_eq(arg_types[2], LOG_BIN_ARG_STRING);
+    ck_assert_int_eq(arg_types[3], LOG_BIN_ARG_POINTER);
+    ck_assert_int_eq(arg_types[4], LOG_BIN_ARG_DOUBLE);
+    ck_assert_int_eq(log_bin_parse_format("%*.*s", arg_types, LOG_BIN_MAX_ARGS), 3);
+    ck_assert_int_eq(arg_types[0], LOG_BIN_ARG_INT32);
+    ck_assert_int_eq(arg_types[1], LOG_BIN_ARG_INT32);
+    ck_assert_int_eq(arg_types[2], LOG_BIN_ARG_STRING);
+    /* Not deferrable */
+    ck_assert_int_eq(log_bin_parse_format("%n", arg_types, LOG_BIN_MAX_ARGS), -1);
+    ck_assert_int_eq(log_bin_parse_format("%Lf", arg_types, LOG_BIN_MAX_ARGS), -1);
+    ck_assert_int_eq(log_bin_parse_format("%d %d %d", arg_types, 2), -1);
+}
+END_TEST
+
+START_TEST(log_binary_round_trip_test)
+{
+    check_round_trip("Entering %s()\n", "emm_proc_attach_request");
+    check_round_trip("UE %06x %d %u %x %08X %c\n", 0x1234, -42, 42u, 0xabcdu, 0xabcdu, 'K');
+    check_round_trip("%lu %llu %zd %hhu %hd\n", 12345678901UL, 1ULL << 40, (ssize_t)-5, 300, 70000);
+    check_round_trip("%5.2f %e %g\n", 3.14159, 1.5e-7, 2.0);
+    check_round_trip("%*s|%-.*s|%p\n", 8, "ab", 2, "xyz", (void *)0x1234);
+}
+END_TEST
+
+START_TEST(log_binary_truncated_args_test)
+{
+    uint8_t arg_types[LOG_BIN_MAX_ARGS];
+    uint8_t packed_args[4] = {0};
+    char    rendered[64];
+    int     num_args;
+
+    num_args = log_bin_parse_format("%d %s", arg_types, LOG_BIN_MAX_ARGS);
+    ck_assert_int_eq(num_args, 2);
+    /* String argument missing */
+    ck_assert_int_eq(log_bin_render(rendered, sizeof(rendered), "%d %s", arg_types, num_args, packed_args, sizeof(packed_args)), -1);
+}
+END_TEST
+
+Suite * log_binary_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("Binary log tests");
+
+    /* Core test case */
+    tc_core = tcase_create("Binary log test");
+    tcase_add_test(tc_core, log_binary_parse_format_test);
+    tcase_add_test(tc_core, log_binary_round_trip_test);
+    tcase_add_test(tc_core, log_binary_truncated_args_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = log_binary_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
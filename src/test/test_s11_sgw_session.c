@@ -0,0 +1,318 @@
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "hashtable.h"
+#include "common_types.h"
+#include "intertask_interface.h"
+#include "NwGtpv2c.h"
+#include "NwGtpv2cIe.h"
+#include "NwGtpv2cMsg.h"
+#include "sgw_ie_defs.h"
+#include "s11_sgw_session_manager.h"
+
+/*
+ * An MME GTPv2-C stack and two S-GW stacks steered like two S11 shards (TEID % 2, sequence number % 2
+ * without TEID), connected by an in-memory network.
+ */
+#define TEST_S11_NB_SHARDS         2
+#define TEST_S11_MAX_DATAGRAMS     8
+#define TEST_S11_DATAGRAM_SIZE     1024
+#define TEST_S11_MME_IPV4          "192.168.11.1"
+#define TEST_S11_SGW_IPV4          "192.168.11.2"
+
+typedef struct test_s11_node_s {
+    nw_gtpv2c_stack_handle_t  stack;
+    int                       index;                   /* -1 for the MME */
+    uint32_t                  last_timer;
+} test_s11_node_t;
+
+typedef struct test_s11_datagram_s {
+    bool                      to_sgw;
+    uint32_t                  length;
+    uint8_t                   buffer[TEST_S11_DATAGRAM_SIZE];
+} test_s11_datagram_t;
+
+hash_table_ts_t              *s11_sgw_teid_2_gtv2c_teid_handle = NULL;
+
+static test_s11_node_t        mme;
+static test_s11_node_t        sgw[TEST_S11_NB_SHARDS];
+static struct in_addr         mme_ip;
+static struct in_addr         sgw_ip;
+static test_s11_datagram_t    network[TEST_S11_MAX_DATAGRAMS];
+static int                    nb_datagrams;
+// Last indications received by the ULPs
+static uint8_t                sgw_req_type;
+static int                    sgw_req_shard;
+static nw_gtpv2c_trxn_handle_t sgw_req_trxn;
+static uint8_t                mme_rsp_type;
+static gtpv2c_cause_t         mme_rsp_cause;
+
+static nw_rc_t test_s11_udp_data_req(nw_gtpv2c_udp_handle_t udpHandle, uint8_t *dataBuf, uint32_t dataSize,
+                                     struct in_addr *peerIp, uint16_t peerPort)
+{
+    test_s11_node_t     *node = (test_s11_node_t *)udpHandle;
+    test_s11_datagram_t *datagram = &network[nb_datagrams++];
+
+    ck_assert(nb_datagrams <= TEST_S11_MAX_DATAGRAMS);
+    ck_assert(dataSize <= TEST_S11_DATAGRAM_SIZE);
+    datagram->to_sgw = (node->index < 0);
+    datagram->length = dataSize;
+    memcpy(datagram->buffer, dataBuf, dataSize);
+    return NW_OK;
+}
+
+static nw_rc_t test_s11_ulp_req(nw_gtpv2c_ulp_handle_t hUlp, nw_gtpv2c_ulp_api_t *pUlpApi)
+{
+    test_s11_node_t *node = (test_s11_node_t *)hUlp;
+
+    switch (pUlpApi->apiType) {
+    case NW_GTPV2C_ULP_API_INITIAL_REQ_IND:
+        sgw_req_type = pUlpApi->u_api_info.initialReqIndInfo.msgType;
+        sgw_req_trxn = pUlpApi->u_api_info.initialReqIndInfo.hTrxn;
+        sgw_req_shard = node->index;
+        break;
+
+    case NW_GTPV2C_ULP_API_TRIGGERED_RSP_IND:
+        mme_rsp_type = pUlpApi->u_api_info.triggeredRspIndInfo.msgType;
+      {
+        uint8_t                      cause = 0, flags = 0, offending_ie_type = 0, offending_ie_instance = 0;
+
+        memset(&mme_rsp_cause, 0, sizeof(mme_rsp_cause));
+        nwGtpv2cMsgGetIeCause(pUlpApi->hMsg, NW_GTPV2C_IE_INSTANCE_ZERO, &cause,
+                              &flags, &offending_ie_type, &offending_ie_instance);
+        mme_rsp_cause.cause_value = (gtpv2c_cause_value_t)cause;
+      }
+        break;
+
+    default:
+        break;
+    }
+    if (pUlpApi->hMsg) {
+        nwGtpv2cMsgDelete(node->stack, pUlpApi->hMsg);
+    }
+    return NW_OK;
+}
+
+static nw_rc_t test_s11_timer_start(nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle, uint32_t timeoutSec, uint32_t timeoutUsec,
+                                    uint32_t tmrType, void *tmrArg, nw_gtpv2c_timer_handle_t *tmrHandle)
+{
+    test_s11_node_t *node = (test_s11_node_t *)tmrMgrHandle;
+
+    // Datagrams are delivered before any retransmission timer would expire
+    *tmrHandle = ++node->last_timer;
+    return NW_OK;
+}
+
+static nw_rc_t test_s11_timer_stop(nw_gtpv2c_timer_mgr_handle_t tmrMgrHandle, nw_gtpv2c_timer_handle_t tmrHandle)
+{
+    return NW_OK;
+}
+
+static void test_s11_node_init(test_s11_node_t *node, int index)
+{
+    nw_gtpv2c_ulp_entity_t       ulp;
+    nw_gtpv2c_udp_entity_t       udp;
+    nw_gtpv2c_timer_mgr_entity_t tmr;
+
+    memset(node, 0, sizeof(*node));
+    node->index = index;
+    ck_assert_int_eq(nwGtpv2cInitialize(&node->stack), NW_OK);
+    ulp.hUlp = (nw_gtpv2c_ulp_handle_t)node;
+    ulp.ulpReqCallback = test_s11_ulp_req;
+    ck_assert_int_eq(nwGtpv2cSetUlpEntity(node->stack, &ulp), NW_OK);
+    udp.hUdp = (nw_gtpv2c_udp_handle_t)node;
+    udp.udpDataReqCallback = test_s11_udp_data_req;
+    ck_assert_int_eq(nwGtpv2cSetUdpEntity(node->stack, &udp), NW_OK);
+    tmr.tmrMgrHandle = (nw_gtpv2c_timer_mgr_handle_t)node;
+    tmr.tmrStartCallback = test_s11_timer_start;
+    tmr.tmrStopCallback = test_s11_timer_stop;
+    ck_assert_int_eq(nwGtpv2cSetTimerMgrEntity(node->stack, &tmr), NW_OK);
+}
+
+static void test_s11_setup(void)
+{
+    bstring name = bfromcstr("test_s11_sgw_teid_2_gtv2c_teid_handle");
+    int     i;
+
+    inet_pton(AF_INET, TEST_S11_MME_IPV4, &mme_ip);
+    inet_pton(AF_INET, TEST_S11_SGW_IPV4, &sgw_ip);
+    s11_sgw_teid_2_gtv2c_teid_handle = hashtable_ts_create(64, HASH_TABLE_DEFAULT_HASH_FUNC, hash_free_int_func, name);
+    bdestroy(name);
+    ck_assert(s11_sgw_teid_2_gtv2c_teid_handle != NULL);
+    ck_assert_int_eq(s11_sgw_session_manager_init(), RETURNok);
+    test_s11_node_init(&mme, -1);
+    for (i = 0; i < TEST_S11_NB_SHARDS; i++) {
+        test_s11_node_init(&sgw[i], i);
+    }
+    nb_datagrams = 0;
+}
+
+static void test_s11_teardown(void)
+{
+    int i;
+
+    nwGtpv2cFinalize(mme.stack);
+    for (i = 0; i < TEST_S11_NB_SHARDS; i++) {
+        nwGtpv2cFinalize(sgw[i].stack);
+    }
+    hashtable_ts_destroy(s11_sgw_teid_2_gtv2c_teid_handle);
+    s11_sgw_teid_2_gtv2c_teid_handle = NULL;
+}
+
+// Same steering as the SO_REUSEPORT program of the S11 shards
+static int test_s11_steer(const uint8_t *buffer)
+{
+    uint32_t teid = 0;
+    uint32_t seq = 0;
+
+    if (buffer[0] & 0x08) {
+        teid = ntohl(*((uint32_t *)(buffer + 4)));
+        seq = ntohl(*((uint32_t *)(buffer + 8))) >> 8;
+    } else {
+        seq = ntohl(*((uint32_t *)(buffer + 4))) >> 8;
+    }
+    return (teid ? teid : seq) % TEST_S11_NB_SHARDS;
+}
+
+static void test_s11_deliver(void)
+{
+    int i;
+
+    for (i = 0; i < nb_datagrams; i++) {
+        test_s11_datagram_t *datagram = &network[i];
+
+        if (datagram->to_sgw) {
+            nwGtpv2cProcessUdpReq(sgw[test_s11_steer(datagram->buffer)].stack, datagram->buffer, datagram->length, 2123, &mme_ip);
+        } else {
+            nwGtpv2cProcessUdpReq(mme.stack, datagram->buffer, datagram->length, 2123, &sgw_ip);
+        }
+    }
+    nb_datagrams = 0;
+}
+
+static void test_s11_mme_send(uint8_t msg_type, teid_t sgw_teid, teid_t mme_teid, nw_gtpv2c_tunnel_handle_t *hTunnel)
+{
+    nw_gtpv2c_ulp_api_t ulp_req;
+    uint8_t             imsi[8] = {0x00, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0xf0};
+
+    memset(&ulp_req, 0, sizeof(ulp_req));
+    ulp_req.apiType = NW_GTPV2C_ULP_API_INITIAL_REQ;
+    ck_assert_int_eq(nwGtpv2cMsgNew(mme.stack, true, msg_type, sgw_teid, 0, &ulp_req.hMsg), NW_OK);
+    if (NW_GTP_CREATE_SESSION_REQ == msg_type) {
+        nwGtpv2cMsgAddIe(ulp_req.hMsg, NW_GTPV2C_IE_IMSI, sizeof(imsi), 0, imsi);
+        nwGtpv2cMsgAddIeTV1(ulp_req.hMsg, NW_GTPV2C_IE_RAT_TYPE, 0, 6);
+    } else {
+        nwGtpv2cMsgGroupedIeStart(ulp_req.hMsg, NW_GTPV2C_IE_BEARER_CONTEXT, NW_GTPV2C_IE_INSTANCE_ZERO);
+        nwGtpv2cMsgAddIeTV1(ulp_req.hMsg, NW_GTPV2C_IE_EBI, 0, 5);
+        nwGtpv2cMsgGroupedIeEnd(ulp_req.hMsg);
+    }
+    ulp_req.u_api_info.initialReqInfo.peerIp = sgw_ip;
+    ulp_req.u_api_info.initialReqInfo.teidLocal = mme_teid;
+    ulp_req.u_api_info.initialReqInfo.hTunnel = *hTunnel;
+    ck_assert_int_eq(nwGtpv2cProcessUlpReq(mme.stack, &ulp_req), NW_OK);
+    *hTunnel = ulp_req.u_api_info.initialReqInfo.hTunnel;
+}
+
+// Create Session Request from the MME, the S-GW answers with sgw_teid as S11 TEID, then Modify Bearer Request
+static void test_s11_csr_mbr(teid_t mme_teid, teid_t sgw_teid)
+{
+    nw_gtpv2c_tunnel_handle_t          hTunnel = 0;
+    itti_s11_create_session_response_t rsp;
+    int                                trxn_shard;
+
+    test_s11_mme_send(NW_GTP_CREATE_SESSION_REQ, 0, mme_teid, &hTunnel);
+    sgw_req_type = 0;
+    test_s11_deliver();
+    ck_assert_int_eq(sgw_req_type, NW_GTP_CREATE_SESSION_REQ);
+    trxn_shard = sgw_req_shard;
+
+    // What S-PGW APP sends back, handled as TASK_S11 and the shards do it
+    memset(&rsp, 0, sizeof(rsp));
+    rsp.teid = mme_teid;
+    rsp.trxn = (void *)sgw_req_trxn;
+    rsp.peer_ip = mme_ip;
+    rsp.cause.cause_value = REQUEST_ACCEPTED;
+    rsp.s11_sgw_fteid.ipv4 = 1;
+    rsp.s11_sgw_fteid.ipv4_address = sgw_ip;
+    rsp.s11_sgw_fteid.interface_type = S11_SGW_GTP_C;
+    rsp.s11_sgw_fteid.teid = sgw_teid;
+    ck_assert_int_eq(s11_sgw_create_local_tunnel(&sgw[sgw_teid % TEST_S11_NB_SHARDS].stack, &rsp), RETURNok);
+    ck_assert_int_eq(s11_sgw_handle_create_session_response(&sgw[trxn_shard].stack, &rsp), RETURNok);
+    mme_rsp_type = 0;
+    test_s11_deliver();
+    ck_assert_int_eq(mme_rsp_type, NW_GTP_CREATE_SESSION_RSP);
+    ck_assert_int_eq(mme_rsp_cause.cause_value, REQUEST_ACCEPTED);
+
+    test_s11_mme_send(NW_GTP_MODIFY_BEARER_REQ, sgw_teid, mme_teid, &hTunnel);
+    sgw_req_type = 0;
+    sgw_req_shard = -1;
+    test_s11_deliver();
+    ck_assert_int_eq(sgw_req_type, NW_GTP_MODIFY_BEARER_REQ);
+    ck_assert_int_eq(sgw_req_shard, sgw_teid % TEST_S11_NB_SHARDS);
+}
+
+START_TEST(s11_sgw_csr_mbr_test)
+{
+    teid_t i;
+
+    test_s11_setup();
+    // S-GW TEIDs owned by either shard, whatever shard got the Create Session Request
+    for (i = 1; i <= 4; i++) {
+        test_s11_csr_mbr(0x100 + i, 0x8000 + i);
+    }
+    test_s11_teardown();
+}
+END_TEST
+
+START_TEST(s11_sgw_unknown_teid_test)
+{
+    nw_gtpv2c_tunnel_handle_t hTunnel = 0;
+
+    test_s11_setup();
+    // Without a local tunnel on the S-GW, the request is discarded
+    test_s11_mme_send(NW_GTP_MODIFY_BEARER_REQ, 0x9001, 0x101, &hTunnel);
+    sgw_req_type = 0;
+    test_s11_deliver();
+    ck_assert_int_eq(sgw_req_type, 0);
+    test_s11_teardown();
+}
+END_TEST
+
+Suite * s11_sgw_session_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S11 S-GW session tests");
+
+    /* Core test case */
+    tc_core = tcase_create("S11 S-GW session test");
+    tcase_add_test(tc_core, s11_sgw_csr_mbr_test);
+    tcase_add_test(tc_core, s11_sgw_unknown_teid_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s11_sgw_session_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
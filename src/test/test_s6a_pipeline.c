@@ -0,0 +1,389 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "common_types.h"
+#include "common_defs.h"
+#include "s6a_pipeline.h"
+
+#define TEST_MAX_REQUESTS   512
+#define TEST_HSS_QUEUE_SIZE 1024
+
+typedef struct test_request_s {
+    uint32_t eteid;
+    bool     fail_send;
+} test_request_t;
+
+/* Stand-in HSS: one thread per peer, answers every request after a fixed latency */
+typedef struct test_hss_s {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    bool            is_running;
+    bool            is_manual;          // requests are kept for the test to answer
+    uint32_t        latency_usec;
+    uint32_t        head;
+    uint32_t        nb;
+    uint32_t        eteids[TEST_HSS_QUEUE_SIZE];
+    uint64_t        due_usec[TEST_HSS_QUEUE_SIZE];
+} test_hss_t;
+
+static s6a_pipeline_t *pipeline = NULL;
+static test_hss_t      hss[S6A_PIPELINE_MAX_PEERS];
+static test_request_t  requests[TEST_MAX_REQUESTS];
+static int             nb_expired = 0;
+static int             nb_expired_unsent = 0;
+
+static uint64_t test_now_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static int test_send(void *cb_arg, const int peer, void *request)
+{
+    test_request_t *req = (test_request_t *)request;
+    test_hss_t     *h = &hss[peer];
+
+    if (req->fail_send) {
+        return -1;
+    }
+    pthread_mutex_lock(&h->lock);
+    h->eteids[(h->head + h->nb) % TEST_HSS_QUEUE_SIZE] = req->eteid;
+    h->due_usec[(h->head + h->nb) % TEST_HSS_QUEUE_SIZE] = test_now_usec() + h->latency_usec;
+    h->nb++;
+    pthread_cond_signal(&h->cond);
+    pthread_mutex_unlock(&h->lock);
+    return 0;
+}
+
+static void test_expire(void *cb_arg, const s6a_pipeline_cmd_t cmd, const char * const imsi, void *request)
+{
+    __sync_fetch_and_add(&nb_expired, 1);
+    if (request) {
+        __sync_fetch_and_add(&nb_expired_unsent, 1);
+    }
+}
+
+static void *test_hss_thread(void *arg)
+{
+    test_hss_t *h = (test_hss_t *)arg;
+    uint32_t    eteid;
+    uint64_t    due;
+    uint64_t    now;
+
+    pthread_mutex_lock(&h->lock);
+    while (h->is_running) {
+        if (!h->nb) {
+            pthread_cond_wait(&h->cond, &h->lock);
+            continue;
+        }
+        eteid = h->eteids[h->head];
+        due = h->due_usec[h->head];
+        h->head = (h->head + 1) % TEST_HSS_QUEUE_SIZE;
+        h->nb--;
+        pthread_mutex_unlock(&h->lock);
+        now = test_now_usec();
+        if (due > now) {
+            usleep(due - now);
+        }
+        s6a_pipeline_answer(pipeline, eteid);
+        pthread_mutex_lock(&h->lock);
+    }
+    pthread_mutex_unlock(&h->lock);
+    return NULL;
+}
+
+static void test_setup(const uint32_t nb_peers, const uint32_t window, const uint32_t backlog,
+                       const uint32_t timeout_msec, const uint32_t * const latency_usec)
+{
+    s6a_pipeline_conf_t conf = {
+        .nb_peers = nb_peers, .window = window, .backlog = backlog,
+        .timeout_msec = timeout_msec, .tick_msec = 5,
+        .send = test_send, .expire = test_expire, .cb_arg = NULL};
+    uint32_t            i;
+
+    memset(requests, 0, sizeof(requests));
+    for (i = 0; i < TEST_MAX_REQUESTS; i++) {
+        requests[i].eteid = 0x1000 + i;
+    }
+    nb_expired = 0;
+    nb_expired_unsent = 0;
+    pipeline = s6a_pipeline_create(&conf);
+    ck_assert(pipeline != NULL);
+    for (i = 0; i < nb_peers; i++) {
+        memset(&hss[i], 0, sizeof(hss[i]));
+        pthread_mutex_init(&hss[i].lock, NULL);
+        pthread_cond_init(&hss[i].cond, NULL);
+        hss[i].is_manual = (latency_usec == NULL);
+        hss[i].latency_usec = (latency_usec) ? latency_usec[i] : 0;
+        if (!hss[i].is_manual) {
+            hss[i].is_running = true;
+            pthread_create(&hss[i].thread, NULL, test_hss_thread, &hss[i]);
+        }
+    }
+}
+
+static void test_teardown(const uint32_t nb_peers)
+{
+    uint32_t i;
+
+    for (i = 0; i < nb_peers; i++) {
+        if (!hss[i].is_manual) {
+            pthread_mutex_lock(&hss[i].lock);
+            hss[i].is_running = false;
+            pthread_cond_signal(&hss[i].cond);
+            pthread_mutex_unlock(&hss[i].lock);
+            pthread_join(hss[i].thread, NULL);
+        }
+    }
+    s6a_pipeline_destroy(&pipeline);
+    ck_assert(pipeline == NULL);
+}
+
+/* Answer the oldest request held by a manual stand-in HSS */
+static int test_hss_answer_one(const int peer)
+{
+    test_hss_t *h = &hss[peer];
+    uint32_t    eteid;
+
+    ck_assert_uint_gt(h->nb, 0);
+    eteid = h->eteids[h->head];
+    h->head = (h->head + 1) % TEST_HSS_QUEUE_SIZE;
+    h->nb--;
+    return s6a_pipeline_answer(pipeline, eteid);
+}
+
+static int test_submit(const int i)
+{
+    return s6a_pipeline_submit(pipeline, S6A_PIPELINE_AIR, requests[i].eteid, "208950000000001", &requests[i]);
+}
+
+START_TEST(s6a_pipeline_window_test)
+{
+    s6a_pipeline_stats_t stats;
+    int                  i;
+
+    test_setup(1, 4, 8, 10000, NULL);
+    s6a_pipeline_set_peer_state(pipeline, 0, true);
+    for (i = 0; i < 12; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    // Window and backlog full
+    ck_assert_int_eq(test_submit(12), RETURNerror);
+    // Already pending
+    ck_assert_int_eq(test_submit(0), RETURNerror);
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 4);
+    ck_assert_uint_eq(stats.backlog_length, 8);
+    ck_assert_uint_eq(stats.rejected, 1);
+    ck_assert_uint_eq(hss[0].nb, 4);
+
+    // Every answer sends the oldest waiting request
+    ck_assert_int_eq(test_hss_answer_one(0), RETURNok);
+    ck_assert_uint_eq(hss[0].nb, 4);
+    ck_assert_uint_eq(hss[0].eteids[(hss[0].head + 3) % TEST_HSS_QUEUE_SIZE], requests[4].eteid);
+    for (i = 1; i < 12; i++) {
+        ck_assert_int_eq(test_hss_answer_one(0), RETURNok);
+    }
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 0);
+    ck_assert_uint_eq(stats.peers[0].sent, 12);
+    ck_assert_uint_eq(stats.peers[0].answered, 12);
+    ck_assert_uint_eq(stats.backlog_length, 0);
+    ck_assert_int_eq(nb_expired, 0);
+    test_teardown(1);
+}
+END_TEST
+
+START_TEST(s6a_pipeline_balance_test)
+{
+    s6a_pipeline_stats_t stats;
+    int                  i;
+
+    test_setup(2, 8, 8, 10000, NULL);
+    // Nothing is sent until a peer is open
+    ck_assert_int_eq(test_submit(0), RETURNok);
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.backlog_length, 1);
+    s6a_pipeline_set_peer_state(pipeline, 0, true);
+    s6a_pipeline_set_peer_state(pipeline, 1, true);
+    for (i = 1; i < 8; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 4);
+    ck_assert_uint_eq(stats.peers[1].in_flight, 4);
+
+    // Least loaded peer first
+    for (i = 0; i < 3; i++) {
+        test_hss_answer_one(1);
+    }
+    for (i = 8; i < 11; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 4);
+    ck_assert_uint_eq(stats.peers[1].in_flight, 4);
+
+    // A closed peer gets no new request
+    s6a_pipeline_set_peer_state(pipeline, 1, false);
+    for (i = 11; i < 15; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 8);
+    ck_assert_uint_eq(stats.peers[1].in_flight, 4);
+    ck_assert_uint_eq(stats.peers[1].sent, 7);
+    test_teardown(2);
+    // Requests pending at destruction are all reported
+    ck_assert_int_eq(nb_expired, 12);
+    ck_assert_int_eq(nb_expired_unsent, 0);
+}
+END_TEST
+
+START_TEST(s6a_pipeline_timeout_test)
+{
+    s6a_pipeline_stats_t stats;
+    int                  i;
+
+    test_setup(1, 2, 8, 20, NULL);
+    s6a_pipeline_set_peer_state(pipeline, 0, true);
+    for (i = 0; i < 5; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    s6a_pipeline_tick(pipeline);
+    ck_assert_int_eq(nb_expired, 0);
+    usleep(60000);
+    s6a_pipeline_tick(pipeline);
+    ck_assert_int_eq(nb_expired, 5);
+    // Backlog requests are given back
+    ck_assert_int_eq(nb_expired_unsent, 3);
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].timeouts, 2);
+    ck_assert_uint_eq(stats.backlog_timeouts, 3);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 0);
+
+    // Late answer
+    ck_assert_int_eq(test_hss_answer_one(0), RETURNerror);
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.unknown_answers, 1);
+    ck_assert_uint_eq(stats.peers[0].answered, 0);
+
+    // Send failure
+    requests[5].fail_send = true;
+    ck_assert_int_eq(test_submit(5), RETURNok);
+    ck_assert_int_eq(nb_expired, 6);
+    ck_assert_int_eq(nb_expired_unsent, 4);
+    s6a_pipeline_get_stats(pipeline, &stats);
+    ck_assert_uint_eq(stats.peers[0].send_failures, 1);
+    ck_assert_uint_eq(stats.peers[0].in_flight, 0);
+    test_teardown(1);
+}
+END_TEST
+
+START_TEST(s6a_pipeline_latency_test)
+{
+    uint32_t             latency_usec[2] = {1000, 20000};
+    s6a_pipeline_stats_t stats;
+    uint64_t             total;
+    int                  i;
+    int                  b;
+
+    test_setup(2, 4, TEST_MAX_REQUESTS, 5000, latency_usec);
+    s6a_pipeline_set_peer_state(pipeline, 0, true);
+    s6a_pipeline_set_peer_state(pipeline, 1, true);
+    for (i = 0; i < 200; i++) {
+        ck_assert_int_eq(test_submit(i), RETURNok);
+    }
+    for (i = 0; i < 500; i++) {
+        s6a_pipeline_get_stats(pipeline, &stats);
+        if (stats.peers[0].answered + stats.peers[1].answered == 200) {
+            break;
+        }
+        usleep(10000);
+    }
+    ck_assert_uint_eq(stats.peers[0].answered + stats.peers[1].answered, 200);
+    ck_assert_int_eq(nb_expired, 0);
+    // The faster HSS takes most of the load
+    ck_assert_uint_gt(stats.peers[0].answered, stats.peers[1].answered);
+    for (i = 0; i < 2; i++) {
+        total = 0;
+        for (b = 0; b < S6A_PIPELINE_RTT_BUCKETS; b++) {
+            total += stats.peers[i].rtt_count[S6A_PIPELINE_AIR][b];
+            ck_assert_uint_eq(stats.peers[i].rtt_count[S6A_PIPELINE_ULR][b], 0);
+        }
+        ck_assert_uint_eq(total, stats.peers[i].answered);
+        ck_assert_uint_ge(stats.peers[i].rtt_sum_usec[S6A_PIPELINE_AIR], stats.peers[i].answered * latency_usec[i]);
+    }
+    // No round trip of the slow HSS below its latency (bucket 14: <= 16384 usec)
+    for (b = 0; b <= 14; b++) {
+        ck_assert_uint_eq(stats.peers[1].rtt_count[S6A_PIPELINE_AIR][b], 0);
+    }
+    test_teardown(2);
+}
+END_TEST
+
+START_TEST(s6a_pipeline_dump_test)
+{
+    const char * const names[1] = {"hss.test"};
+    bstring            dump = bfromcstr("");
+
+    test_setup(1, 4, 4, 10000, NULL);
+    s6a_pipeline_set_peer_state(pipeline, 0, true);
+    ck_assert_int_eq(s6a_pipeline_submit(pipeline, S6A_PIPELINE_ULR, requests[0].eteid, "208950000000001", &requests[0]), RETURNok);
+    ck_assert_int_eq(test_hss_answer_one(0), RETURNok);
+    s6a_pipeline_dump(pipeline, names, dump);
+    ck_assert(strstr((const char *)dump->data, "mme_s6a_answered_total{peer=\"hss.test\"} 1\n") != NULL);
+    ck_assert(strstr((const char *)dump->data, "mme_s6a_rtt_usec_count{peer=\"hss.test\",command=\"ulr\"} 1\n") != NULL);
+    ck_assert(strstr((const char *)dump->data, "mme_s6a_rtt_usec_count{peer=\"hss.test\",command=\"air\"} 0\n") != NULL);
+    bdestroy(dump);
+    test_teardown(1);
+}
+END_TEST
+
+Suite * s6a_pipeline_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("S6a pipeline tests");
+
+    /* Core test case */
+    tc_core = tcase_create("S6a pipeline test");
+    tcase_set_timeout(tc_core, 30);
+    tcase_add_test(tc_core, s6a_pipeline_window_test);
+    tcase_add_test(tc_core, s6a_pipeline_balance_test);
+    tcase_add_test(tc_core, s6a_pipeline_timeout_test);
+    tcase_add_test(tc_core, s6a_pipeline_latency_test);
+    tcase_add_test(tc_core, s6a_pipeline_dump_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = s6a_pipeline_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
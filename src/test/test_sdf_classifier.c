@@ -0,0 +1,445 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "bstrlib.h"
+
+#include "common_types.h"
+#include "common_defs.h"
+#include "hashtable.h"
+#include "obj_hashtable.h"
+#include "intertask_interface.h"
+#include "3gpp_24.008.h"
+#include "spgw_config.h"
+#include "pgw_pcef_emulation.h"
+#include "sgw.h"
+#include "gtpv1u.h"
+#include "sdf_classifier.h"
+
+/*
+ * The classifier is checked against the iptables marking of the PCEF emulation: the POSTROUTING
+ * commands of pgw_pcef_emulation_apply_sdf_filter() are captured and evaluated the way the mangle
+ * table would (rules inserted on top, MARK does not terminate: the first rule applied wins).
+ */
+#define TEST_NB_RULES         256
+#define TEST_NB_PACKETS     20000
+#define TEST_RULE_ARGS_MAX     32
+#define TEST_UE_POOL   "172.16.0.0"
+#define TEST_UE_PREFIX         12
+#define TEST_UE_NET    UINT32_C(0xAC100000)
+
+// what pgw_pcef_emulation.c needs from the S/P-GW
+pgw_app_t                        pgw_app;
+const struct gtp_tunnel_ops     *gtp_tunnel_ops = NULL;
+
+typedef struct test_iptables_rule_s {
+  uint32_t src, src_mask, dst, dst_mask;
+  bool     has_proto;
+  uint8_t  proto;
+  bool     has_sport, has_dport, has_spi, has_tos;
+  uint16_t sport_min, sport_max, dport_min, dport_max;
+  uint32_t spi;
+  uint8_t  tos, tos_mask;
+  uint32_t mark;
+} test_iptables_rule_t;
+
+static test_iptables_rule_t iptables_rules[TEST_NB_RULES];
+static uint32_t             nb_iptables_rules = 0;
+
+//------------------------------------------------------------------------------
+static uint32_t test_parse_addr(const char * const str, uint32_t * const mask)
+{
+  char           buf[64];
+  char          *slash = NULL;
+  struct in_addr addr;
+
+  snprintf(buf, sizeof(buf), "%s", str);
+  slash = strchr(buf, '/');
+  ck_assert(slash != NULL);
+  *slash = '\0';
+  if (strchr(slash + 1, '.')) {
+    ck_assert_int_eq(inet_pton(AF_INET, slash + 1, &addr), 1);
+    *mask = ntohl(addr.s_addr);
+  } else {
+    int len = atoi(slash + 1);
+    *mask = (len) ? (0xFFFFFFFF << (32 - len)) : 0;
+  }
+  ck_assert_int_eq(inet_pton(AF_INET, buf, &addr), 1);
+  return ntohl(addr.s_addr) & *mask;
+}
+
+//------------------------------------------------------------------------------
+static void test_parse_ports(const char * const str, uint16_t * const min, uint16_t * const max)
+{
+  const char *colon = strchr(str, ':');
+
+  *min = (uint16_t)atoi(str);
+  *max = (colon) ? (uint16_t)atoi(colon + 1) : *min;
+}
+
+// replaces the asynchronous system() of the PCEF emulation
+int async_system_command (int sender_itti_task, bool is_abort_on_error, char *format, ...)
+{
+  char                  command[512];
+  char                 *argv[TEST_RULE_ARGS_MAX];
+  int                   argc = 0;
+  test_iptables_rule_t *rule = &iptables_rules[nb_iptables_rules];
+  va_list               args;
+
+  va_start(args, format);
+  vsnprintf(command, sizeof(command), format, args);
+  va_end(args);
+  for (char *tok = strtok(command, " "); tok && (argc < TEST_RULE_ARGS_MAX); tok = strtok(NULL, " ")) {
+    argv[argc++] = tok;
+  }
+  ck_assert(argc >= 4);
+  ck_assert_str_eq(argv[0], "iptables");
+  ck_assert_str_eq(argv[1], "-I");
+  // UE <-> PGW traffic, not on S1-U
+  if (!strcmp(argv[2], "OUTPUT")) {
+    return 0;
+  }
+  ck_assert_str_eq(argv[2], "POSTROUTING");
+  ck_assert(nb_iptables_rules < TEST_NB_RULES);
+  memset(rule, 0, sizeof(*rule));
+  for (int i = 3; i < argc - 1; i++) {
+    if (!strcmp(argv[i], "--dest") || !strcmp(argv[i], "--destination")) {
+      rule->dst = test_parse_addr(argv[++i], &rule->dst_mask);
+    } else if (!strcmp(argv[i], "--source")) {
+      rule->src = test_parse_addr(argv[++i], &rule->src_mask);
+    } else if (!strcmp(argv[i], "--protocol")) {
+      rule->proto = (uint8_t)atoi(argv[++i]);
+      rule->has_proto = (0 != rule->proto);
+    } else if (!strcmp(argv[i], "--destination-port")) {
+      rule->has_dport = true;
+      test_parse_ports(argv[++i], &rule->dport_min, &rule->dport_max);
+    } else if (!strcmp(argv[i], "--source-port")) {
+      rule->has_sport = true;
+      test_parse_ports(argv[++i], &rule->sport_min, &rule->sport_max);
+    } else if (!strcmp(argv[i], "--espspi")) {
+      rule->has_spi = true;
+      rule->spi = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (!strcmp(argv[i], "--tos")) {
+      char *slash = NULL;
+
+      rule->has_tos = true;
+      rule->tos = (uint8_t)strtoul(argv[++i], &slash, 16);
+      rule->tos_mask = (slash && ('/' == *slash)) ? (uint8_t)strtoul(slash + 1, NULL, 16) : 0xFF;
+    } else if (!strcmp(argv[i], "--set-mark")) {
+      rule->mark = (uint32_t)atoi(argv[++i]);
+    }
+  }
+  nb_iptables_rules++;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static bool test_iptables_rule_match(const test_iptables_rule_t * const rule, const sdf_key_t * const key)
+{
+  if (((key->src & rule->src_mask) != rule->src) || ((key->dst & rule->dst_mask) != rule->dst)) {
+    return false;
+  }
+  if (rule->has_proto && (key->proto != rule->proto)) {
+    return false;
+  }
+  if (rule->has_sport && ((key->sport < rule->sport_min) || (key->sport > rule->sport_max))) {
+    return false;
+  }
+  if (rule->has_dport && ((key->dport < rule->dport_min) || (key->dport > rule->dport_max))) {
+    return false;
+  }
+  if (rule->has_spi && ((IPPROTO_ESP != key->proto) || (key->spi != rule->spi))) {
+    return false;
+  }
+  if (rule->has_tos && ((key->tos & rule->tos_mask) != rule->tos)) {
+    return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static uint32_t test_iptables_mark(const sdf_key_t * const key)
+{
+  for (uint32_t i = 0; i < nb_iptables_rules; i++) {
+    // iptables -D
+    if ((SDF_CLASSIFIER_NO_MATCH != iptables_rules[i].mark) && test_iptables_rule_match(&iptables_rules[i], key)) {
+      return iptables_rules[i].mark;
+    }
+  }
+  return SDF_CLASSIFIER_NO_MATCH;
+}
+
+static const uint8_t  test_protos[] = {IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ESP, IPPROTO_ICMP};
+static const uint16_t test_ports[]  = {53, 80, 443, 1000, 1003, 1009, 5060, 8080};
+static const uint8_t  test_tos[]    = {0x00, 0x20, 0xB8, 0xBB};
+static const char    *test_remotes[] = {"8.8.8.8", "8.8.4.4", "8.8.8.9", "1.1.1.1"};
+// packets matching no SDF: GRE from a host of no filter
+static const uint8_t  test_packet_protos[] = {IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ESP, IPPROTO_ICMP, IPPROTO_GRE};
+static const char    *test_packet_sources[] = {"8.8.8.8", "8.8.4.4", "8.8.8.9", "1.1.1.1", "9.9.9.9"};
+static const uint8_t  test_prefixes[] = {32, 24, 16, 8};
+
+#define TEST_PICK(aRRAY) aRRAY[rand() % (sizeof(aRRAY) / sizeof(aRRAY[0]))]
+
+//------------------------------------------------------------------------------
+static void test_random_filter(packet_filter_t * const filter, const uint8_t precedence)
+{
+  packet_filter_contents_t *pfc = &filter->packetfiltercontents;
+
+  memset(filter, 0, sizeof(*filter));
+  filter->direction = (rand() & 1) ? TRAFFIC_FLOW_TEMPLATE_BIDIRECTIONAL : TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY;
+  filter->eval_precedence = precedence;
+  if (rand() % 10 < 6) {
+    struct in_addr addr;
+    uint8_t        prefix = TEST_PICK(test_prefixes);
+    uint32_t       mask = (prefix) ? (0xFFFFFFFF << (32 - prefix)) : 0;
+
+    inet_pton(AF_INET, TEST_PICK(test_remotes), &addr);
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG;
+    for (int i = 0; i < TRAFFIC_FLOW_TEMPLATE_IPV4_ADDR_SIZE; i++) {
+      pfc->ipv4remoteaddr[i].addr = ((uint8_t *)&addr.s_addr)[i];
+      pfc->ipv4remoteaddr[i].mask = (uint8_t)(mask >> (24 - 8 * i));
+    }
+  }
+  if (rand() % 10 < 3) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SECURITY_PARAMETER_INDEX_FLAG | TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG;
+    pfc->securityparameterindex = 1 + rand() % 3;
+    pfc->protocolidentifier_nextheader = IPPROTO_ESP;
+  } else if (rand() % 10 < 7) {
+    // ports only with a transport protocol, as iptables requires
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG;
+    pfc->protocolidentifier_nextheader = TEST_PICK(test_protos);
+    if ((IPPROTO_TCP == pfc->protocolidentifier_nextheader) || (IPPROTO_UDP == pfc->protocolidentifier_nextheader)) {
+      switch (rand() % 3) {
+      case 0:
+        pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SINGLE_LOCAL_PORT_FLAG;
+        pfc->singlelocalport = TEST_PICK(test_ports);
+        break;
+      case 1:
+        pfc->flags |= TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG;
+        pfc->localportrange.lowlimit = 1000 + rand() % 5;
+        pfc->localportrange.highlimit = pfc->localportrange.lowlimit + rand() % 8;
+        break;
+      default:
+        break;
+      }
+      switch (rand() % 3) {
+      case 0:
+        pfc->flags |= TRAFFIC_FLOW_TEMPLATE_SINGLE_REMOTE_PORT_FLAG;
+        pfc->singleremoteport = TEST_PICK(test_ports);
+        break;
+      case 1:
+        pfc->flags |= TRAFFIC_FLOW_TEMPLATE_REMOTE_PORT_RANGE_FLAG;
+        pfc->remoteportrange.lowlimit = 50 + rand() % 10;
+        pfc->remoteportrange.highlimit = pfc->remoteportrange.lowlimit + rand() % 500;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  if (rand() % 10 < 2) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_TYPE_OF_SERVICE_TRAFFIC_CLASS_FLAG;
+    pfc->typdeofservice_trafficclass.value = TEST_PICK(test_tos);
+    pfc->typdeofservice_trafficclass.mask = (rand() & 1) ? 0xFF : 0xFC;
+  }
+  // no catch-all SDF
+  if (!(pfc->flags & (TRAFFIC_FLOW_TEMPLATE_IPV4_REMOTE_ADDR_FLAG | TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG))) {
+    pfc->flags |= TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG;
+    pfc->protocolidentifier_nextheader = IPPROTO_ICMP;
+  }
+}
+
+//------------------------------------------------------------------------------
+static uint32_t test_random_packet(uint8_t * const packet)
+{
+  uint8_t proto = TEST_PICK(test_packet_protos);
+
+  memset(packet, 0, 28);
+  packet[0] = 0x45;
+  packet[1] = TEST_PICK(test_tos);
+  packet[3] = 28;
+  packet[8] = 64;
+  packet[9] = proto;
+  inet_pton(AF_INET, TEST_PICK(test_packet_sources), &packet[12]);
+  if (rand() % 8) {
+    packet[16] = 172;
+    packet[17] = 16;
+  } else {
+    // UE of another pool, not marked by the rules without remote address
+    packet[16] = 10;
+  }
+  packet[19] = (uint8_t)(1 + rand() % 200);
+  if (IPPROTO_ESP == proto) {
+    packet[23] = (uint8_t)(1 + rand() % 3);
+  } else {
+    uint16_t sport = (rand() & 1) ? TEST_PICK(test_ports) : (uint16_t)(40 + rand() % 600);
+    uint16_t dport = TEST_PICK(test_ports);
+
+    packet[20] = (uint8_t)(sport >> 8);
+    packet[21] = (uint8_t)sport;
+    packet[22] = (uint8_t)(dport >> 8);
+    packet[23] = (uint8_t)dport;
+  }
+  return 28;
+}
+
+//------------------------------------------------------------------------------
+START_TEST(sdf_classifier_iptables_test)
+{
+  sdf_classifier_t *classifier = sdf_classifier_create();
+  pgw_config_t      pgw_config;
+  packet_filter_t   filter;
+  sdf_rule_t        rule;
+  uint8_t           packet[64];
+  sdf_key_t         key;
+  uint32_t          nb_matches = 0;
+
+  srand(41);
+  memset(&pgw_config, 0, sizeof(pgw_config));
+  inet_pton(AF_INET, TEST_UE_POOL, &pgw_config.ue_pool_addr[0]);
+  pgw_config.ue_pool_mask[0] = TEST_UE_PREFIX;
+  nb_iptables_rules = 0;
+  for (uint32_t i = 0; i < TEST_NB_RULES; i++) {
+    // iptables ignores the precedence, keep the rules in precedence order
+    test_random_filter(&filter, (uint8_t)(i / 8));
+    pgw_pcef_emulation_apply_sdf_filter(&filter, (sdf_id_t)(i + 1), &pgw_config);
+    ck_assert_int_eq(sdf_classifier_rule_from_packet_filter(&filter, TEST_UE_NET, TEST_UE_PREFIX, &rule), RETURNok);
+    ck_assert_int_eq(sdf_classifier_add_rule(classifier, &rule, i + 1, filter.eval_precedence), RETURNok);
+  }
+  ck_assert_uint_eq(nb_iptables_rules, TEST_NB_RULES);
+  ck_assert_uint_eq(sdf_classifier_nb_rules(classifier), TEST_NB_RULES);
+
+  for (uint32_t i = 0; i < TEST_NB_PACKETS; i++) {
+    uint32_t len = test_random_packet(packet);
+    uint32_t expected = SDF_CLASSIFIER_NO_MATCH;
+
+    ck_assert_int_eq(sdf_classifier_key_from_ipv4(packet, len, &key), RETURNok);
+    expected = test_iptables_mark(&key);
+    ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), expected);
+    nb_matches += (SDF_CLASSIFIER_NO_MATCH != expected);
+  }
+  // the packets exercise the rules
+  printf("%u packets out of %u in a SDF\n", nb_matches, TEST_NB_PACKETS);
+  ck_assert(nb_matches > TEST_NB_PACKETS / 4);
+  ck_assert(nb_matches < TEST_NB_PACKETS);
+
+  // removing SDFs gives the same result as never adding them
+  for (uint32_t sdf_id = 1; sdf_id <= TEST_NB_RULES; sdf_id += 2) {
+    ck_assert_uint_eq(sdf_classifier_del_sdf(classifier, sdf_id), 1);
+    iptables_rules[sdf_id - 1].mark = SDF_CLASSIFIER_NO_MATCH;
+  }
+  ck_assert_uint_eq(sdf_classifier_nb_rules(classifier), TEST_NB_RULES / 2);
+  for (uint32_t i = 0; i < TEST_NB_PACKETS; i++) {
+    uint32_t len = test_random_packet(packet);
+
+    ck_assert_int_eq(sdf_classifier_key_from_ipv4(packet, len, &key), RETURNok);
+    ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), test_iptables_mark(&key));
+  }
+  sdf_classifier_destroy(&classifier);
+  ck_assert(classifier == NULL);
+}
+END_TEST
+
+START_TEST(sdf_classifier_precedence_test)
+{
+  sdf_classifier_t *classifier = sdf_classifier_create();
+  packet_filter_t   filter;
+  sdf_rule_t        rule;
+  uint8_t           packet[64];
+  sdf_key_t         key;
+
+  srand(42);
+  ck_assert_uint_eq(test_random_packet(packet), 28);
+  packet[16] = 172;
+  packet[17] = 16;
+  packet[9] = IPPROTO_UDP;
+  packet[22] = 0x13;
+  packet[23] = 0xC4;    // 5060
+  ck_assert_int_eq(sdf_classifier_key_from_ipv4(packet, 28, &key), RETURNok);
+  ck_assert_uint_eq(key.dport, 5060);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), SDF_CLASSIFIER_NO_MATCH);
+
+  // any UDP packet, precedence 10
+  memset(&filter, 0, sizeof(filter));
+  filter.direction = TRAFFIC_FLOW_TEMPLATE_DOWNLINK_ONLY;
+  filter.eval_precedence = 10;
+  filter.packetfiltercontents.flags = TRAFFIC_FLOW_TEMPLATE_PROTOCOL_NEXT_HEADER_FLAG;
+  filter.packetfiltercontents.protocolidentifier_nextheader = IPPROTO_UDP;
+  ck_assert_int_eq(sdf_classifier_rule_from_packet_filter(&filter, TEST_UE_NET, TEST_UE_PREFIX, &rule), RETURNok);
+  ck_assert_int_eq(sdf_classifier_add_rule(classifier, &rule, 100, filter.eval_precedence), RETURNok);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 100);
+
+  // SIP added later with a lower precedence value wins (the iptables marking would keep 100)
+  filter.eval_precedence = 2;
+  filter.packetfiltercontents.flags |= TRAFFIC_FLOW_TEMPLATE_LOCAL_PORT_RANGE_FLAG;
+  filter.packetfiltercontents.localportrange.lowlimit = 5060;
+  filter.packetfiltercontents.localportrange.highlimit = 5061;
+  ck_assert_int_eq(sdf_classifier_rule_from_packet_filter(&filter, TEST_UE_NET, TEST_UE_PREFIX, &rule), RETURNok);
+  ck_assert_int_eq(sdf_classifier_add_rule(classifier, &rule, 200, filter.eval_precedence), RETURNok);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 200);
+  // same rule, same precedence: the first one added wins
+  ck_assert_int_eq(sdf_classifier_add_rule(classifier, &rule, 300, filter.eval_precedence), RETURNok);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 200);
+  // UDP, UDP and ports 5060-5061
+  ck_assert_uint_eq(sdf_classifier_nb_tuples(classifier), 2);
+  ck_assert_int_eq(sdf_classifier_add_rule(classifier, &rule, SDF_CLASSIFIER_NO_MATCH, 0), RETURNerror);
+
+  ck_assert_uint_eq(sdf_classifier_del_sdf(classifier, 200), 1);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 300);
+  ck_assert_uint_eq(sdf_classifier_del_sdf(classifier, 300), 1);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 100);
+  key.dport = 5062;
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), 100);
+  ck_assert_uint_eq(sdf_classifier_del_sdf(classifier, 100), 1);
+  ck_assert_uint_eq(sdf_classifier_nb_tuples(classifier), 0);
+  ck_assert_uint_eq(sdf_classifier_lookup(classifier, &key), SDF_CLASSIFIER_NO_MATCH);
+
+  // not supported
+  filter.packetfiltercontents.flags = TRAFFIC_FLOW_TEMPLATE_IPV6_REMOTE_ADDR_FLAG;
+  ck_assert_int_eq(sdf_classifier_rule_from_packet_filter(&filter, TEST_UE_NET, TEST_UE_PREFIX, &rule), RETURNerror);
+  // ports of non first fragments are unknown
+  packet[6] = 0x00;
+  packet[7] = 0x10;
+  ck_assert_int_eq(sdf_classifier_key_from_ipv4(packet, 28, &key), RETURNok);
+  ck_assert_uint_eq(key.dport, 0);
+  ck_assert_int_eq(sdf_classifier_key_from_ipv4(packet, 19, &key), RETURNerror);
+  sdf_classifier_destroy(&classifier);
+}
+END_TEST
+
+Suite * sdf_classifier_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("SDF classifier tests");
+
+    /* Core test case */
+    tc_core = tcase_create("SDF classifier test");
+    tcase_add_test(tc_core, sdf_classifier_iptables_test);
+    tcase_add_test(tc_core, sdf_classifier_precedence_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = sdf_classifier_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
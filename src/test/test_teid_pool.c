@@ -0,0 +1,119 @@
+#include <check.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common_types.h"
+#include "common_defs.h"
+#include "teid_pool.h"
+
+#define TEST_TEID_POOL_SIZE 1000
+
+START_TEST(teid_pool_unique_test)
+{
+    teid_pool_t *pool = teid_pool_create("test", 100, TEST_TEID_POOL_SIZE, 3);
+    bool         seen[TEST_TEID_POOL_SIZE] = {false};
+    teid_t       teid;
+    int          i;
+
+    ck_assert(pool != NULL);
+    for (i = 0; i < TEST_TEID_POOL_SIZE; i++) {
+        teid = teid_pool_alloc(pool, i);
+        ck_assert(teid >= 100 && teid < 100 + TEST_TEID_POOL_SIZE);
+        ck_assert(!seen[teid - 100]);
+        seen[teid - 100] = true;
+    }
+    ck_assert_uint_eq(teid_pool_nb_allocated(pool), TEST_TEID_POOL_SIZE);
+    ck_assert_uint_eq(teid_pool_alloc(pool, 0), INVALID_TEID);
+    teid_pool_destroy(&pool);
+    ck_assert(pool == NULL);
+}
+END_TEST
+
+START_TEST(teid_pool_shard_test)
+{
+    teid_pool_t *pool = teid_pool_create("test", 1, TEST_TEID_POOL_SIZE, 4);
+    teid_t       teid;
+    int          i;
+
+    for (i = 0; i < 100; i++) {
+        teid = teid_pool_alloc(pool, 2);
+        ck_assert_uint_eq(teid_pool_shard(pool, teid), 2);
+    }
+    // Sub-pool 3 lends its TEIDs once sub-pool 2 is exhausted
+    for (i = 100; i < TEST_TEID_POOL_SIZE / 4; i++) {
+        teid_pool_alloc(pool, 2);
+    }
+    teid = teid_pool_alloc(pool, 2);
+    ck_assert_uint_eq(teid_pool_shard(pool, teid), 3);
+    teid_pool_destroy(&pool);
+}
+END_TEST
+
+START_TEST(teid_pool_recycle_test)
+{
+    teid_pool_t *pool = teid_pool_create("test", 1, 4, 1);
+    teid_t       teids[4];
+    int          i;
+
+    for (i = 0; i < 4; i++) {
+        teids[i] = teid_pool_alloc(pool, 0);
+    }
+    ck_assert_int_eq(teid_pool_free(pool, teids[2]), RETURNok);
+    ck_assert_int_eq(teid_pool_free(pool, teids[2]), RETURNerror);
+    ck_assert_int_eq(teid_pool_free(pool, 5), RETURNerror);
+    ck_assert_int_eq(teid_pool_free(pool, INVALID_TEID), RETURNerror);
+    ck_assert_int_eq(teid_pool_free(pool, teids[0]), RETURNok);
+    // Oldest released first
+    ck_assert_uint_eq(teid_pool_alloc(pool, 0), teids[2]);
+    ck_assert_uint_eq(teid_pool_alloc(pool, 0), teids[0]);
+    ck_assert_uint_eq(teid_pool_alloc(pool, 0), INVALID_TEID);
+    ck_assert_uint_eq(teid_pool_nb_allocated(pool), 4);
+    teid_pool_destroy(&pool);
+}
+END_TEST
+
+START_TEST(teid_pool_bad_range_test)
+{
+    ck_assert(teid_pool_create("test", INVALID_TEID, 10, 1) == NULL);
+    ck_assert(teid_pool_create("test", 1, 0, 1) == NULL);
+    ck_assert(teid_pool_create("test", 1, 2, 3) == NULL);
+    ck_assert(teid_pool_create("test", UINT32_MAX, 2, 1) == NULL);
+}
+END_TEST
+
+Suite * teid_pool_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("TEID pool tests");
+
+    /* Core test case */
+    tc_core = tcase_create("TEID pool test");
+    tcase_add_test(tc_core, teid_pool_unique_test);
+    tcase_add_test(tc_core, teid_pool_shard_test);
+    tcase_add_test(tc_core, teid_pool_recycle_test);
+    tcase_add_test(tc_core, teid_pool_bad_range_test);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = teid_pool_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
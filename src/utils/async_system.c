@@ -53,6 +53,7 @@
 #include "intertask_interface.h"
 #include "log.h"
 #include "async_system.h"
+#include "system_executor.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
 #include "itti_free_defined_msg.h"
@@ -61,38 +62,88 @@
 void async_system_exit (void);
 void* async_system_task (__attribute__ ((unused)) void *args_p);
 
+//------------------------------------------------------------------------------
+static void async_system_check (const bstring command, const bool is_abort_on_error, const int rc)
+{
+  if (rc) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d\n", bdata(command), rc);
+    if (is_abort_on_error) {
+      exit (-1);              // may be not exit
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Commit the iptables commands gathered from the queue, replay them one by one if the transaction failed
+static void async_system_flush (system_executor_batch_t * const batch, MessageDef ** const pending, int * const nb_pending)
+{
+  int                                     rc = 0;
+
+  if (1 < *nb_pending) {
+    OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "iptables-restore transaction of %d commands\n", *nb_pending);
+    rc = system_executor_batch_commit (batch);
+    if (rc) {
+      OAILOG_WARNING (LOG_ASYNC_SYSTEM, "iptables-restore transaction of %d commands failed (%d), running them one by one\n", *nb_pending, rc);
+    }
+  }
+  system_executor_batch_clear (batch);
+  for (int i = 0; i < *nb_pending; i++) {
+    if ((1 == *nb_pending) || rc) {
+      async_system_check (ASYNC_SYSTEM_COMMAND (pending[i]).system_command, ASYNC_SYSTEM_COMMAND (pending[i]).is_abort_on_error,
+          system_executor_run (bdata(ASYNC_SYSTEM_COMMAND (pending[i]).system_command)));
+    }
+    itti_free_msg_content(pending[i]);
+    itti_free (ITTI_MSG_ORIGIN_ID (pending[i]), pending[i]);
+  }
+  *nb_pending = 0;
+}
+
 //------------------------------------------------------------------------------
 void* async_system_task (__attribute__ ((unused)) void *args_p)
 {
   MessageDef                             *received_message_p = NULL;
-  int                                     rc = 0;
+  MessageDef                             *pending[SYSTEM_EXECUTOR_BATCH_MAX];
+  int                                     nb_pending = 0;
+  system_executor_batch_t                 batch = {.nb_commands = 0};
 
   itti_mark_task_ready (TASK_ASYNC_SYSTEM);
 
   while (1) {
-    itti_receive_msg (TASK_ASYNC_SYSTEM, &received_message_p);
+    /*
+     * Block for the first command, then drain the queue without blocking so that consecutive
+     * iptables commands share one transaction; commit when the queue is empty.
+     */
+    if (nb_pending) {
+      itti_poll_msg (TASK_ASYNC_SYSTEM, &received_message_p);
+      if (!received_message_p) {
+        async_system_flush (&batch, pending, &nb_pending);
+        continue;
+      }
+    } else {
+      itti_receive_msg (TASK_ASYNC_SYSTEM, &received_message_p);
+    }
 
     if (received_message_p != NULL) {
 
       switch (ITTI_MSG_ID (received_message_p)) {
 
       case ASYNC_SYSTEM_COMMAND:{
-          rc = 0;
-          OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "C system() call: %s\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p).system_command));
-          rc = system (bdata(ASYNC_SYSTEM_COMMAND (received_message_p).system_command));
-
-          if (rc) {
-            OAILOG_ERROR (LOG_ASYNC_SYSTEM, "ERROR in system command %s: %d\n", bdata(ASYNC_SYSTEM_COMMAND (received_message_p).system_command), rc);
-            if (ASYNC_SYSTEM_COMMAND (received_message_p).is_abort_on_error) {
-              bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p).system_command);
-              exit (-1);              // may be not exit
+          bstring command = ASYNC_SYSTEM_COMMAND (received_message_p).system_command;
+
+          if (RETURNok != system_executor_batch_add (&batch, bdata(command))) {
+            async_system_flush (&batch, pending, &nb_pending);
+            if (RETURNok != system_executor_batch_add (&batch, bdata(command))) {
+              async_system_check (command, ASYNC_SYSTEM_COMMAND (received_message_p).is_abort_on_error, system_executor_run (bdata(command)));
+              break;
             }
-            bdestroy_wrapper(&ASYNC_SYSTEM_COMMAND (received_message_p).system_command);
           }
+          pending[nb_pending++] = received_message_p;
+          received_message_p = NULL;    // freed by async_system_flush()
         }
         break;
 
       case TERMINATE_MESSAGE:{
+            async_system_flush (&batch, pending, &nb_pending);
             async_system_exit ();
             itti_exit_task ();
         }
@@ -102,10 +153,12 @@ void* async_system_task (__attribute__ ((unused)) void *args_p)
         }
         break;
       }
-      // Freeing the memory allocated from the memory pool
-      itti_free_msg_content(received_message_p);
-      itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
-      received_message_p = NULL;
+      if (received_message_p) {
+        // Freeing the memory allocated from the memory pool
+        itti_free_msg_content(received_message_p);
+        itti_free (ITTI_MSG_ORIGIN_ID (received_message_p), received_message_p);
+        received_message_p = NULL;
+      }
     }
   }
   return NULL;
@@ -31,6 +31,8 @@
    \brief We still use some unix commands for convenience, and we did not have to replace them by system calls
    \ Instead of calling C system(...) that can take a lot of time (creation of a process, etc), in many cases
    \ it doesn't hurt to do this asynchronously, may be we must tweak thread priority, pin it to a CPU, etc (TODO later)
+   \ The commands are run by the system executor (see system_executor.h): natively when their syntax is known,
+   \ consecutive queued iptables commands in one iptables-restore transaction.
    \author  Lionel GAUTHIER
    \date 2017
    \email: lionel.gauthier@eurecom.fr
@@ -49,11 +49,14 @@
 #include <fcntl.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include <sched.h>
 #include <syslog.h>
+#include <time.h>
 
 #include "intertask_interface.h"
 #include "timer.h"
 #include "log.h"
+#include "log_binary.h"
 #include "shared_ts_log.h"
 #include "assertions.h"
 #include "dynamic_memory_check.h"
@@ -66,6 +69,9 @@
 #define LOG_MAX_QUEUE_ELEMENTS                1024
 #define LOG_MAX_PROTO_NAME_LENGTH               16
 #define LOG_MESSAGE_MIN_ALLOC_SIZE             256
+/* Longest text one format call may append to a message, it is the count given to bvcformata() that
+   grows the message buffer at most by this amount: a longer text is not appended and the message is dropped */
+#define LOG_MESSAGE_MAX_FORMAT_LENGTH         4096
 
 #define LOG_CONNECT_PERIOD_SEC                   2
 #define LOG_CONNECT_PERIOD_MICRO_SEC             0
@@ -81,6 +87,13 @@
 #define LOG_ANSI_CODE_MAX_LENGTH                15
 #define LOG_MAX_SERVER_ADDRESS_LENGTH           96
 #define LOG_MAX_PORT_NUM_LENGTH                  6
+
+#define LOG_BIN_RING_SIZE                  (1 << 18)   /* per thread, must be a power of 2 */
+#define LOG_BIN_RING_WRAP_MARKER          0xFFFFFFFF
+#define LOG_BIN_MAX_THREADS                     128
+#define LOG_BIN_MAX_SITES                  (1 << 14)   /* must be a power of 2, fmt_id is the slot index */
+#define LOG_BIN_MAX_TEXT_LENGTH                4096
+#define LOG_MAX_FILENAME_LENGTH                1024
 //-------------------------------
 
 typedef unsigned long                   log_message_number_t;
@@ -96,6 +109,41 @@ typedef enum {
 
 #define ANSI_CODE_MAX_LENGTH    32
 
+typedef enum {
+  LOG_BIN_SITE_EMPTY = 0,
+  LOG_BIN_SITE_BUSY,
+  LOG_BIN_SITE_READY,
+} log_bin_site_state_t;
+
+/*! \struct  log_bin_site_t
+* \brief A logging call site (format string, source file, line) registered in binary mode.
+* The index of the site in the open addressing table is the format id carried in records.
+*/
+typedef struct log_bin_site_s {
+  volatile uint32_t                       state;                                                /*!< \brief log_bin_site_state_t */
+  bool                                    is_preformatted;                                      /*!< \brief format could not be deferred, message formatted by caller */
+  bool                                    is_written;                                           /*!< \brief definition already written in binary output (log task only) */
+  int8_t                                  num_args;
+  uint32_t                                line_num;
+  const char                             *format;
+  const char                             *source_file;
+  uint8_t                                 arg_types[LOG_BIN_MAX_ARGS];
+} log_bin_site_t;
+
+/*! \struct  log_bin_ring_t
+* \brief Single producer (owner thread) single consumer (log task) ring of binary records.
+* Records are prefixed by their 32 bits length and are 8 bytes aligned.
+*/
+typedef struct log_bin_ring_s {
+  volatile uint64_t                       head __attribute__ ((aligned (64)));                  /*!< \brief written by producer */
+  volatile uint64_t                       tail __attribute__ ((aligned (64)));                  /*!< \brief written by consumer */
+  volatile uint64_t                       num_dropped __attribute__ ((aligned (64)));           /*!< \brief written by producer */
+  volatile bool                           is_orphan;                                            /*!< \brief owner thread exited, freed by consumer once drained */
+  uint64_t                                num_dropped_reported;                                 /*!< \brief written by consumer */
+  pthread_t                               tid;
+  uint8_t                                 data[LOG_BIN_RING_SIZE] __attribute__ ((aligned (8)));
+} log_bin_ring_t;
+
 /*! \struct  oai_log_t
 * \brief Structure containing all the logging utility internal variables.
 */
@@ -114,15 +162,440 @@ typedef struct oai_log_s {
   char                                    log_level2str[MAX_LOG_LEVEL][LOG_LEVEL_NAME_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   char                                    log_level2ansi[MAX_LOG_LEVEL][ANSI_CODE_MAX_LENGTH];     /*!< \brief Convert log level id into human readable log level string */
   int                                     log_start_time_second;                                       /*!< \brief Logging utility reference time              */
-  log_level_t                             log_level[MAX_LOG_PROTOS];                                   /*!< \brief Loglevel id of each client (protocol/layer) */
 
   log_message_number_t                    log_message_number;                                          /*!< \brief Counter of log message        */
 
-  hash_table_ts_t                           *thread_context_htbl;                                         /*!< \brief Container for log_thread_ctxt_t */
+  bool                                    is_output_binary;                                            /*!< \brief Deferred formatting, call sites enqueue binary records */
+  bool                                    is_output_binary_file;                                       /*!< \brief Binary records written as is in output file */
+  log_bin_site_t                         *bin_sites;                                                   /*!< \brief Call sites table, LOG_BIN_MAX_SITES entries */
+  log_bin_ring_t                         *bin_rings[LOG_BIN_MAX_THREADS];                              /*!< \brief One ring per producer thread */
+  volatile uint32_t                       num_bin_rings;                                               /*!< \brief High watermark of used bin_rings slots */
+  pthread_key_t                           bin_ring_key;                                                /*!< \brief Orphans the ring of an exiting thread */
+  volatile uint64_t                       num_bin_dropped;                                             /*!< \brief Records lost because no ring could be allocated */
+  bstring                                 bin_text;                                                    /*!< \brief Text rendering buffer of the log task */
 } oai_log_t;
 
 static oai_log_t g_oai_log={0};    /*!< \brief  logging utility internal variables global var definition*/
 
+log_level_t      g_oai_log_level[MAX_LOG_PROTOS] = {0}; /*!< \brief Loglevel id of each client (protocol/layer), read inline by logging macros */
+
+static __thread log_thread_ctxt_t   g_thread_ctxt = {0};     /*!< \brief  per thread log context */
+static __thread log_bin_ring_t     *g_thread_bin_ring = NULL;  /*!< \brief  per thread binary records ring */
+
+static void log_bin_flush_rings(void);
+static void log_bin_write_file_header(void);
+static void log_bin_message (
+  log_thread_ctxt_t * const thread_ctxtP,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *const source_fileP,
+  const unsigned int line_numP,
+  const char *format,
+  ...);
+
+//------------------------------------------------------------------------------
+static inline log_thread_ctxt_t * log_get_thread_context(void)
+{
+  if (!g_thread_ctxt.is_initialized) {
+    log_start_use();
+  }
+  return &g_thread_ctxt;
+}
+
+//------------------------------------------------------------------------------
+// Common header of a text log line: ANSI code, message number, elapsed time, thread, level, proto, file:line, indentation
+static int log_format_header (
+  bstring bstr,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *source_fileP,
+  const unsigned int line_numP,
+  const pthread_t tid,
+  const int indent,
+  const struct timeval * const elapsed_time)
+{
+  int                                     rv              = 0;
+  int                                     filename_length = strlen(source_fileP);
+
+  if (g_oai_log.is_ansi_codes) {
+    rv = bformata (bstr, "%s", &g_oai_log.log_level2ansi[log_levelP][0]);
+  }
+  if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+    source_fileP = &source_fileP[filename_length-LOG_DISPLAYED_FILENAME_MAX_LENGTH];
+  }
+  rv = bformata (bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
+      __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time->tv_sec, elapsed_time->tv_usec,
+      tid,
+      LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
+      LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
+      LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_fileP, line_numP,
+      indent, " ");
+  return rv;
+}
+
+//------------------------------------------------------------------------------
+// Lock free lookup/registration of a call site, the slot index is the format id.
+static log_bin_site_t * log_bin_get_site (
+  const char *const format,
+  const char *const source_fileP,
+  const unsigned int line_numP,
+  uint16_t * const fmt_id)
+{
+  uint64_t                                hash   = 0;
+  uint32_t                                index  = 0;
+  uint32_t                                probes = 0;
+  log_bin_site_t                         *site   = NULL;
+
+  hash  = (uint64_t)(uintptr_t)format * 0x9E3779B97F4A7C15ULL;
+  hash ^= ((uint64_t)(uintptr_t)source_fileP + line_numP) * 0xC2B2AE3D27D4EB4FULL;
+  index = (uint32_t)(hash >> 32) & (LOG_BIN_MAX_SITES - 1);
+
+  while (probes < LOG_BIN_MAX_SITES) {
+    site = &g_oai_log.bin_sites[index];
+    uint32_t state = __atomic_load_n (&site->state, __ATOMIC_ACQUIRE);
+
+    if (LOG_BIN_SITE_READY == state) {
+      if ((site->format == format) && (site->source_file == source_fileP) && (site->line_num == line_numP)) {
+        *fmt_id = (uint16_t)index;
+        return site;
+      }
+    } else if (LOG_BIN_SITE_EMPTY == state) {
+      uint32_t expected = LOG_BIN_SITE_EMPTY;
+      if (__atomic_compare_exchange_n (&site->state, &expected, LOG_BIN_SITE_BUSY, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        int num_args = log_bin_parse_format (format, site->arg_types, LOG_BIN_MAX_ARGS);
+        site->format          = format;
+        site->source_file     = source_fileP;
+        site->line_num        = line_numP;
+        site->is_preformatted = (0 > num_args);
+        site->num_args        = (0 > num_args) ? 0 : num_args;
+        __atomic_store_n (&site->state, LOG_BIN_SITE_READY, __ATOMIC_RELEASE);
+        *fmt_id = (uint16_t)index;
+        return site;
+      }
+      // lost the race, look again at the same slot
+      continue;
+    } else {
+      // being registered by another thread
+      sched_yield();
+      continue;
+    }
+    index = (index + 1) & (LOG_BIN_MAX_SITES - 1);
+    probes++;
+  }
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Thread exit destructor: the log task flushes the remaining records then frees the ring.
+static void log_bin_release_ring (void *arg)
+{
+  log_bin_ring_t                         *ring = (log_bin_ring_t *)arg;
+
+  g_thread_bin_ring = NULL;
+  __atomic_store_n (&ring->is_orphan, true, __ATOMIC_RELEASE);
+}
+
+//------------------------------------------------------------------------------
+static log_bin_ring_t * log_bin_get_ring (void)
+{
+  if (!g_thread_bin_ring) {
+    log_bin_ring_t *ring = calloc (1, sizeof (log_bin_ring_t));
+
+    if (!ring) {
+      return NULL;
+    }
+    ring->tid = pthread_self();
+    // slots of rings freed by the log task are reused
+    for (uint32_t index = 0; index < LOG_BIN_MAX_THREADS; index++) {
+      log_bin_ring_t *expected = NULL;
+
+      if (__atomic_compare_exchange_n (&g_oai_log.bin_rings[index], &expected, ring, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        uint32_t num_rings = __atomic_load_n (&g_oai_log.num_bin_rings, __ATOMIC_RELAXED);
+
+        while ((num_rings <= index) &&
+               (!__atomic_compare_exchange_n (&g_oai_log.num_bin_rings, &num_rings, index + 1, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED)));
+        pthread_setspecific (g_oai_log.bin_ring_key, ring);
+        g_thread_bin_ring = ring;
+        return ring;
+      }
+    }
+    free_wrapper ((void**)&ring);
+  }
+  return g_thread_bin_ring;
+}
+
+//------------------------------------------------------------------------------
+// Producer side, never blocks: drop the record if the ring is full.
+static bool log_bin_ring_put (
+  log_bin_ring_t * const ring,
+  const log_bin_record_t * const record,
+  const uint8_t * const args,
+  const size_t args_length)
+{
+  const uint32_t                          length     = sizeof (*record) + args_length;
+  const uint64_t                          needed     = (sizeof (uint32_t) + length + 7) & ~((uint64_t)7);
+  const uint64_t                          tail       = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+  uint64_t                                head       = ring->head;
+  uint64_t                                offset     = head & (LOG_BIN_RING_SIZE - 1);
+  const uint64_t                          contiguous = LOG_BIN_RING_SIZE - offset;
+  const uint64_t                          total      = (needed > contiguous) ? (contiguous + needed) : needed;
+
+  if ((head + total - tail) > LOG_BIN_RING_SIZE) {
+    ring->num_dropped++;
+    return false;
+  }
+  if (needed > contiguous) {
+    const uint32_t marker = LOG_BIN_RING_WRAP_MARKER;
+    memcpy (&ring->data[offset], &marker, sizeof (marker));
+    head  += contiguous;
+    offset = 0;
+  }
+  memcpy (&ring->data[offset], &length, sizeof (length));
+  memcpy (&ring->data[offset + sizeof (length)], record, sizeof (*record));
+  memcpy (&ring->data[offset + sizeof (length) + sizeof (*record)], args, args_length);
+  __atomic_store_n (&ring->head, head + needed, __ATOMIC_RELEASE);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_message_v (
+  log_thread_ctxt_t * const thread_ctxtP,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *const source_fileP,
+  const unsigned int line_numP,
+  const char *format,
+  va_list args)
+{
+  log_bin_site_t                         *site = NULL;
+  log_bin_ring_t                         *ring = NULL;
+  log_bin_record_t                        record = {0};
+  uint8_t                                 packed_args[LOG_BIN_MAX_ARGS_LENGTH];
+  struct timespec                         ts = {0};
+  uint16_t                                fmt_id = 0;
+
+  ring = log_bin_get_ring ();
+  if (!ring) {
+    __sync_fetch_and_add (&g_oai_log.num_bin_dropped, 1);
+    return;
+  }
+  site = log_bin_get_site (format, source_fileP, line_numP, &fmt_id);
+  if (!site) {
+    ring->num_dropped++;
+    return;
+  }
+  if (site->is_preformatted) {
+    char text[LOG_BIN_MAX_TEXT_LENGTH];
+
+    vsnprintf (text, sizeof (text), format, args);
+    log_bin_message (thread_ctxtP, log_levelP, protoP, source_fileP, line_numP, LOG_BIN_GENERIC_FORMAT, text);
+    return;
+  }
+  clock_gettime (CLOCK_REALTIME, &ts);
+  record.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+  record.fmt_id       = fmt_id;
+  record.tid          = (uint64_t)thread_ctxtP->tid;
+  record.log_level    = log_levelP;
+  record.proto        = protoP;
+  record.indent       = thread_ctxtP->indent;
+  record.args_length  = log_bin_pack_args (packed_args, sizeof (packed_args), site->arg_types, site->num_args, args);
+  log_bin_ring_put (ring, &record, packed_args, record.args_length);
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_message (
+  log_thread_ctxt_t * const thread_ctxtP,
+  const log_level_t log_levelP,
+  const log_proto_t protoP,
+  const char *const source_fileP,
+  const unsigned int line_numP,
+  const char *format,
+  ...)
+{
+  va_list                                 args;
+
+  va_start (args, format);
+  log_bin_message_v (thread_ctxtP, log_levelP, protoP, source_fileP, line_numP, format, args);
+  va_end (args);
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_write_chunk (
+  const log_bin_chunk_type_t type,
+  const void * const value,
+  const size_t length)
+{
+  log_bin_chunk_header_t                  header = {.type = type, .length = length};
+
+  if ((g_oai_log.log_fd) && (UINT16_MAX >= length)) {
+    if ((1 != fwrite (&header, sizeof (header), 1, g_oai_log.log_fd)) ||
+        (1 != fwrite (value, length, 1, g_oai_log.log_fd))) {
+      OAI_FPRINTF_ERR("Error while writing binary log: %s\n", strerror (errno));
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_write_file_header (void)
+{
+  log_bin_file_header_t                   header = {.version = LOG_BIN_FILE_VERSION, .reserved = 0};
+  log_bin_name_t                          name = {0};
+
+  memcpy (header.magic, LOG_BIN_FILE_MAGIC, LOG_BIN_FILE_MAGIC_LENGTH);
+  header.start_time_sec = g_oai_log.log_start_time_second;
+  if (1 != fwrite (&header, sizeof (header), 1, g_oai_log.log_fd)) {
+    OAI_FPRINTF_ERR("Error while writing binary log header: %s\n", strerror (errno));
+    return;
+  }
+  for (int i = MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
+    name.id = i;
+    strncpy (name.name, &g_oai_log.log_proto2str[i][0], LOG_BIN_MAX_NAME_LENGTH);
+    log_bin_write_chunk (LOG_BIN_CHUNK_PROTO_NAME, &name, sizeof (name));
+  }
+  for (int i = MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
+    name.id = i;
+    strncpy (name.name, &g_oai_log.log_level2str[i][0], LOG_BIN_MAX_NAME_LENGTH);
+    log_bin_write_chunk (LOG_BIN_CHUNK_LEVEL_NAME, &name, sizeof (name));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_write_site (const uint16_t fmt_id, log_bin_site_t * const site)
+{
+  uint8_t                                 buffer[LOG_BIN_MAX_TEXT_LENGTH + LOG_MAX_FILENAME_LENGTH + LOG_BIN_MAX_ARGS + sizeof (log_bin_format_t)];
+  log_bin_format_t                        definition = {0};
+  size_t                                  offset = 0;
+
+  definition.fmt_id        = fmt_id;
+  definition.line          = site->line_num;
+  definition.num_args      = site->num_args;
+  definition.file_length   = strnlen (site->source_file, LOG_MAX_FILENAME_LENGTH);
+  definition.format_length = strnlen (site->format, LOG_BIN_MAX_TEXT_LENGTH);
+
+  memcpy (&buffer[offset], &definition, sizeof (definition));
+  offset += sizeof (definition);
+  memcpy (&buffer[offset], site->arg_types, site->num_args);
+  offset += site->num_args;
+  memcpy (&buffer[offset], site->source_file, definition.file_length);
+  offset += definition.file_length;
+  memcpy (&buffer[offset], site->format, definition.format_length);
+  offset += definition.format_length;
+  log_bin_write_chunk (LOG_BIN_CHUNK_FORMAT, buffer, offset);
+  site->is_written = true;
+}
+
+//------------------------------------------------------------------------------
+// Consumer side (log task): write raw record or format it.
+static void log_bin_output_record (const uint8_t * const data, const uint32_t length)
+{
+  log_bin_record_t                        record = {0};
+  log_bin_site_t                         *site = NULL;
+  struct timeval                          elapsed_time = {0};
+  char                                    text[LOG_BIN_MAX_TEXT_LENGTH];
+
+  if (sizeof (record) > length) return;
+  memcpy (&record, data, sizeof (record));
+  if ((LOG_BIN_MAX_SITES <= record.fmt_id) || ((sizeof (record) + record.args_length) > length) ||
+      (MAX_LOG_PROTOS <= record.proto) || (MAX_LOG_LEVEL <= record.log_level)) {
+    return;
+  }
+  site = &g_oai_log.bin_sites[record.fmt_id];
+
+  if (g_oai_log.is_output_binary_file) {
+    if (!site->is_written) {
+      log_bin_write_site (record.fmt_id, site);
+    }
+    log_bin_write_chunk (LOG_BIN_CHUNK_RECORD, data, sizeof (record) + record.args_length);
+    return;
+  }
+
+  if (!g_oai_log.bin_text) {
+    g_oai_log.bin_text = bfromcstralloc (LOG_MESSAGE_MIN_ALLOC_SIZE, "");
+  }
+  btrunc (g_oai_log.bin_text, 0);
+  elapsed_time.tv_sec  = (record.timestamp_ns / 1000000000ULL) - g_oai_log.log_start_time_second;
+  elapsed_time.tv_usec = (record.timestamp_ns % 1000000000ULL) / 1000;
+  log_format_header (g_oai_log.bin_text, record.log_level, record.proto, site->source_file, site->line_num,
+      (pthread_t)record.tid, record.indent, &elapsed_time);
+  if (0 > log_bin_render (text, sizeof (text), site->format, site->arg_types, site->num_args,
+      &data[sizeof (record)], record.args_length)) {
+    bformata (g_oai_log.bin_text, "<malformed binary record> %s", text);
+  } else {
+    bcatcstr (g_oai_log.bin_text, text);
+  }
+  if (g_oai_log.is_ansi_codes) {
+    bcatcstr (g_oai_log.bin_text, ANSI_COLOR_RESET);
+  }
+  if (g_oai_log.is_output_is_fd) {
+    if (g_oai_log.log_fd) {
+      fputs ((const char *)g_oai_log.bin_text->data, g_oai_log.log_fd);
+    }
+  } else {
+    syslog (record.log_level, "%s", bdata (g_oai_log.bin_text));
+  }
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_output_dropped (const pthread_t tid, const uint64_t num_dropped)
+{
+  if (g_oai_log.is_output_binary_file) {
+    log_bin_dropped_t dropped = {.tid = (uint64_t)tid, .num_dropped = num_dropped};
+    log_bin_write_chunk (LOG_BIN_CHUNK_DROPPED, &dropped, sizeof (dropped));
+  } else if ((g_oai_log.is_output_is_fd) && (g_oai_log.log_fd)) {
+    fprintf (g_oai_log.log_fd, "%08lX %" PRIu64 " log messages dropped\n", tid, num_dropped);
+  } else if (!g_oai_log.is_output_is_fd) {
+    syslog (LOG_WARNING, "%08lX %" PRIu64 " log messages dropped\n", tid, num_dropped);
+  }
+}
+
+//------------------------------------------------------------------------------
+static void log_bin_flush_rings (void)
+{
+  uint32_t                                num_rings = __atomic_load_n (&g_oai_log.num_bin_rings, __ATOMIC_ACQUIRE);
+
+  if (LOG_BIN_MAX_THREADS < num_rings) {
+    num_rings = LOG_BIN_MAX_THREADS;
+  }
+  for (uint32_t i = 0; i < num_rings; i++) {
+    log_bin_ring_t *ring = __atomic_load_n (&g_oai_log.bin_rings[i], __ATOMIC_ACQUIRE);
+
+    if (!ring) continue;
+    uint64_t tail = ring->tail;
+    const uint64_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+
+    while (tail != head) {
+      uint64_t offset = tail & (LOG_BIN_RING_SIZE - 1);
+      uint32_t length = 0;
+
+      memcpy (&length, &ring->data[offset], sizeof (length));
+      if (LOG_BIN_RING_WRAP_MARKER == length) {
+        tail += LOG_BIN_RING_SIZE - offset;
+        continue;
+      }
+      log_bin_output_record (&ring->data[offset + sizeof (length)], length);
+      tail += (sizeof (length) + length + 7) & ~((uint64_t)7);
+    }
+    __atomic_store_n (&ring->tail, tail, __ATOMIC_RELEASE);
+
+    const uint64_t num_dropped = ring->num_dropped;
+    if (num_dropped != ring->num_dropped_reported) {
+      log_bin_output_dropped (ring->tid, num_dropped - ring->num_dropped_reported);
+      ring->num_dropped_reported = num_dropped;
+    }
+    // is_orphan is set after the last record of the thread, a drained orphan ring is never written again
+    if ((__atomic_load_n (&ring->is_orphan, __ATOMIC_ACQUIRE)) && (__atomic_load_n (&ring->head, __ATOMIC_ACQUIRE) == tail)) {
+      __atomic_store_n (&g_oai_log.bin_rings[i], NULL, __ATOMIC_RELEASE);
+      free_wrapper ((void**)&ring);
+    }
+  }
+  if (g_oai_log.num_bin_dropped) {
+    log_bin_output_dropped (0, __sync_fetch_and_and (&g_oai_log.num_bin_dropped, 0));
+  }
+  if (g_oai_log.log_fd) {
+    fflush (g_oai_log.log_fd);
+  }
+}
+
 //------------------------------------------------------------------------------
 void* log_task (__attribute__ ((unused)) void *args_p)
 {
@@ -146,8 +619,16 @@ void* log_task (__attribute__ ((unused)) void *args_p)
           // if tcp logging is enabled
           if (LOG_TCP_STATE_NOT_CONNECTED == g_oai_log.tcp_state) {
             log_connect_to_server();
-            timer_setup (LOG_CONNECT_PERIOD_SEC,
-                         LOG_CONNECT_PERIOD_MICRO_SEC,
+            if (!g_oai_log.is_output_binary) {
+              timer_setup (LOG_CONNECT_PERIOD_SEC,
+                           LOG_CONNECT_PERIOD_MICRO_SEC,
+                           TASK_LOG, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
+            }
+          }
+          if (g_oai_log.is_output_binary) {
+            log_bin_flush_rings ();
+            timer_setup (LOG_FLUSH_PERIOD_SEC,
+                         LOG_FLUSH_PERIOD_MICRO_SEC,
                          TASK_LOG, INSTANCE_DEFAULT, TIMER_ONE_SHOT, NULL, &timer_id);
           }
         }
@@ -243,29 +724,35 @@ void log_connect_to_server(void)
 void log_set_config(const log_config_t * const config)
 {
   if (config) {
-    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log.log_level[LOG_UDP] = config->udp_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log.log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
-    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log.log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
-    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log.log_level[LOG_SCTP]     = config->sctp_log_level;
-    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log.log_level[LOG_S1AP]     = config->s1ap_log_level;
-    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log.log_level[LOG_MME_APP]  = config->mme_app_log_level;
+    if ((MAX_LOG_LEVEL > config->udp_log_level) && (MIN_LOG_LEVEL <= config->udp_log_level))         g_oai_log_level[LOG_UDP] = config->udp_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv1u_log_level) && (MIN_LOG_LEVEL <= config->gtpv1u_log_level))   g_oai_log_level[LOG_GTPV1U]   = config->gtpv1u_log_level;
+    if ((MAX_LOG_LEVEL > config->gtpv2c_log_level) && (MIN_LOG_LEVEL <= config->gtpv2c_log_level))   g_oai_log_level[LOG_GTPV2C]   = config->gtpv2c_log_level;
+    if ((MAX_LOG_LEVEL > config->sctp_log_level) && (MIN_LOG_LEVEL <= config->sctp_log_level))       g_oai_log_level[LOG_SCTP]     = config->sctp_log_level;
+    if ((MAX_LOG_LEVEL > config->s1ap_log_level) && (MIN_LOG_LEVEL <= config->s1ap_log_level))       g_oai_log_level[LOG_S1AP]     = config->s1ap_log_level;
+    if ((MAX_LOG_LEVEL > config->mme_app_log_level) && (MIN_LOG_LEVEL <= config->mme_app_log_level)) g_oai_log_level[LOG_MME_APP]  = config->mme_app_log_level;
     if ((MAX_LOG_LEVEL > config->nas_log_level) && (MIN_LOG_LEVEL <= config->nas_log_level)) {
-      g_oai_log.log_level[LOG_NAS]      = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_EMM]  = config->nas_log_level;
-      g_oai_log.log_level[LOG_NAS_ESM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS]      = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_EMM]  = config->nas_log_level;
+      g_oai_log_level[LOG_NAS_ESM]  = config->nas_log_level;
     }
-    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log.log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
-    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log.log_level[LOG_S11]      = config->s11_log_level;
-    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log.log_level[LOG_S6A]      = config->s6a_log_level;
-    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log.log_level[LOG_SECU]     = config->secu_log_level;
-    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log.log_level[LOG_UTIL]     = config->util_log_level;
-    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log.log_level[LOG_MSC]      = config->msc_log_level;
-    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log.log_level[LOG_ITTI]     = config->itti_log_level;
+    if ((MAX_LOG_LEVEL > config->spgw_app_log_level) && (MIN_LOG_LEVEL <= config->spgw_app_log_level)) g_oai_log_level[LOG_SPGW_APP] = config->spgw_app_log_level;
+    if ((MAX_LOG_LEVEL > config->s11_log_level) && (MIN_LOG_LEVEL <= config->s11_log_level))           g_oai_log_level[LOG_S11]      = config->s11_log_level;
+    if ((MAX_LOG_LEVEL > config->s6a_log_level) && (MIN_LOG_LEVEL <= config->s6a_log_level))           g_oai_log_level[LOG_S6A]      = config->s6a_log_level;
+    if ((MAX_LOG_LEVEL > config->secu_log_level) && (MIN_LOG_LEVEL <= config->secu_log_level))         g_oai_log_level[LOG_SECU]     = config->secu_log_level;
+    if ((MAX_LOG_LEVEL > config->util_log_level) && (MIN_LOG_LEVEL <= config->util_log_level))         g_oai_log_level[LOG_UTIL]     = config->util_log_level;
+    if ((MAX_LOG_LEVEL > config->msc_log_level) && (MIN_LOG_LEVEL <= config->msc_log_level))           g_oai_log_level[LOG_MSC]      = config->msc_log_level;
+    if ((MAX_LOG_LEVEL > config->itti_log_level) && (MIN_LOG_LEVEL <= config->itti_log_level))         g_oai_log_level[LOG_ITTI]     = config->itti_log_level;
     if ((MAX_LOG_LEVEL > config->async_system_log_level) && (MIN_LOG_LEVEL <= config->async_system_log_level))
-      g_oai_log.log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
+      g_oai_log_level[LOG_ASYNC_SYSTEM] = config->async_system_log_level;
 
     g_oai_log.is_output_fd_buffered = config->is_output_thread_safe;
     g_oai_log.is_ansi_codes = config->color;
+    if ((config->is_output_binary) && (!g_oai_log.is_output_binary)) {
+      g_oai_log.bin_sites = calloc(LOG_BIN_MAX_SITES, sizeof(log_bin_site_t));
+      AssertFatal (NULL != g_oai_log.bin_sites, "Could not allocate binary log call sites\n");
+      AssertFatal (0 == pthread_key_create (&g_oai_log.bin_ring_key, log_bin_release_ring), "Could not create binary log ring key\n");
+      g_oai_log.is_output_binary = true;
+    }
 
     if (config->output) {
       g_oai_log.log_fd = NULL;
@@ -284,6 +771,12 @@ void log_set_config(const log_config_t * const config)
           g_oai_log.log_fd = fopen (bdata(config->output), "w");
           AssertFatal (NULL != g_oai_log.log_fd, "Could not open log file %s : %s", bdata(config->output), strerror (errno));
           g_oai_log.is_output_is_fd = true;
+          if (g_oai_log.is_output_binary) {
+            // no ANSI codes in records, decoder is in charge of presentation
+            g_oai_log.is_ansi_codes = false;
+            g_oai_log.is_output_binary_file = true;
+            log_bin_write_file_header();
+          }
         } else {
           // may be a TCP server address host:portnum
           g_oai_log.bserver_address = bstrcpy(config->output);
@@ -357,24 +850,6 @@ log_init (
 
   g_oai_log.log_start_time_second = shared_log_get_start_time_sec();
 
-
-  bstring b = bfromcstr("Logging thread context hashtable");
-  g_oai_log.thread_context_htbl = hashtable_ts_create (LOG_MESSAGE_MIN_ALLOC_SIZE, NULL, free_wrapper, b);
-  bdestroy_wrapper (&b);
-  AssertFatal (NULL != g_oai_log.thread_context_htbl, "Could not create hashtable for Log!\n");
-  g_oai_log.thread_context_htbl->log_enabled = false;
-
-
-  log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-  AssertFatal(NULL != thread_ctxt, "Error Could not create log thread context\n");
-  pthread_t p = pthread_self();
-  thread_ctxt->tid = p;
-  hashtable_rc_t hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-  if (HASH_TABLE_OK != hash_rc) {
-    OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-    free_wrapper((void**)thread_ctxt);
-  }
-
   log_start_use ();
 
   snprintf (&g_oai_log.log_proto2str[LOG_SCTP][0], LOG_MAX_PROTO_NAME_LENGTH, "SCTP");
@@ -418,7 +893,7 @@ log_init (
   snprintf (&g_oai_log.log_level2ansi[OAILOG_LEVEL_EMERGENCY][0], ANSI_CODE_MAX_LENGTH, ANSI_COLOR_FG_REV_RED);
 
   for (i=MIN_LOG_PROTOS; i < MAX_LOG_PROTOS; i++) {
-    g_oai_log.log_level[i] = default_log_levelP;
+    g_oai_log_level[i] = default_log_levelP;
   }
   // did not check return value of snprintf...
   for (i=MIN_LOG_LEVEL; i < MAX_LOG_LEVEL; i++) {
@@ -433,7 +908,7 @@ log_init (
 // listen to ITTI events
 void log_itti_connect(void)
 {
-  if (g_oai_log.is_output_fd_buffered) {
+  if ((g_oai_log.is_output_fd_buffered) || (g_oai_log.is_output_binary)) {
     int                                     rv = 0;
     rv = itti_create_task (TASK_LOG, log_task, NULL);
     AssertFatal (rv == 0, "Create task for OAI logging failed!\n");
@@ -443,20 +918,10 @@ void log_itti_connect(void)
 //------------------------------------------------------------------------------
 void log_start_use (void)
 {
-  pthread_t      p       = pthread_self();
-  hashtable_rc_t hash_rc = hashtable_ts_is_key_exists (g_oai_log.thread_context_htbl, (hash_key_t) p);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    log_thread_ctxt_t *thread_ctxt = calloc(1, sizeof(log_thread_ctxt_t));
-    if (thread_ctxt) {
-      thread_ctxt->tid = p;
-      hash_rc = hashtable_ts_insert(g_oai_log.thread_context_htbl, (hash_key_t) p, thread_ctxt);
-      if (HASH_TABLE_OK != hash_rc) {
-        OAI_FPRINTF_ERR("Error Could not register log thread context\n");
-        free_wrapper((void**)&thread_ctxt);
-      }
-    } else {
-      OAI_FPRINTF_ERR("Error Could not create log thread context\n");
-    }
+  if (!g_thread_ctxt.is_initialized) {
+    g_thread_ctxt.tid            = pthread_self();
+    g_thread_ctxt.indent         = 0;
+    g_thread_ctxt.is_initialized = true;
   }
 }
 
@@ -466,6 +931,10 @@ void log_flush_message (struct shared_log_queue_item_s *item_p)
   int                                     rv = 0;
   int                                     rv_put = 0;
 
+  if (g_oai_log.is_output_binary_file) {
+    // text must not be mixed with binary records
+    return;
+  }
   if (blength(item_p->bstr) > 0) {
     if (g_oai_log.is_output_is_fd) {
       if (g_oai_log.log_fd) {
@@ -499,6 +968,9 @@ void log_exit (void)
   int                                     rv = 0;
 
   OAI_FPRINTF_INFO("[TRACE] Entering %s\n", __FUNCTION__);
+  if (g_oai_log.is_output_binary) {
+    log_bin_flush_rings ();
+  }
   if (g_oai_log.log_fd) {
     rv = fflush (g_oai_log.log_fd);
 
@@ -515,7 +987,10 @@ void log_exit (void)
   if (!g_oai_log.is_output_is_fd) {
     closelog();
   }
-  hashtable_ts_destroy (g_oai_log.thread_context_htbl);
+  if (g_oai_log.is_output_binary) {
+    // rings of still running threads are left allocated, producers may still hold them
+    g_oai_log.is_output_binary = false;
+  }
   bdestroy_wrapper(&g_oai_log.bserver_address);
   bdestroy_wrapper(&g_oai_log.bserver_port);
   OAI_FPRINTF_INFO("[TRACE] Leaving %s\n", __FUNCTION__);
@@ -535,16 +1010,8 @@ void log_stream_hex(
   size_t                            octet_index = 0;
   int                               rv = 0;
   log_thread_ctxt_t                *thread_ctxt = NULL;
-  hashtable_rc_t                    hash_rc = HASH_TABLE_OK;
 
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  thread_ctxt = log_get_thread_context();
   if (messageP) {
     log_message_start(thread_ctxt, log_levelP, protoP, &message, source_fileP, line_numP, "hex stream ");
     if (!message) return;
@@ -580,16 +1047,8 @@ void log_stream_hex_array(
   unsigned long                     octet_index = 0;
   unsigned long                     index = 0;
   log_thread_ctxt_t                *thread_ctxt = NULL;
-  hashtable_rc_t                    hash_rc = HASH_TABLE_OK;
 
-  pthread_t             p           = pthread_self();
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
+  thread_ctxt = log_get_thread_context();
 
   if (messageP) {
     log_message(thread_ctxt, log_levelP, protoP, source_fileP, line_numP, "%s\n", messageP);
@@ -632,7 +1091,7 @@ void log_message_add (struct shared_log_queue_item_s * messageP, char *format, .
 
   if (messageP) {
     va_start (args, format);
-    rv = bvcformata (messageP->bstr, 4096, format, args); // big number, see bvcformata
+    rv = bvcformata (messageP->bstr, LOG_MESSAGE_MAX_FORMAT_LENGTH, format, args);
     va_end (args);
 
     if (BSTR_ERR == rv) {
@@ -646,6 +1105,13 @@ void log_message_finish (struct shared_log_queue_item_s * messageP)
   int                                     rv = 0;
 
   if (messageP) {
+    if (g_oai_log.is_output_binary) {
+      bcatcstr (messageP->bstr, "\n");
+      log_bin_message (log_get_thread_context(), messageP->u_app_log.log.log_level, messageP->u_app_log.log.proto,
+          messageP->u_app_log.log.source_file, messageP->u_app_log.log.line_num, LOG_BIN_GENERIC_FORMAT, bdata(messageP->bstr));
+      shared_log_reuse_item(messageP);
+      return;
+    }
     if (g_oai_log.is_ansi_codes) {
       rv = bformata(messageP->bstr, "%s\n", ANSI_COLOR_RESET);
     } else {
@@ -682,9 +1148,7 @@ void log_message_start (
 {
   va_list                                 args;
   int                                     rv              = 0;
-  int                                     filename_length = 0;
   log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -692,19 +1156,12 @@ void log_message_start (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > g_oai_log_level[protoP]) {
     return;
   }
 
   if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
-    }
+    thread_ctxt = log_get_thread_context();
   }
 
   if (! *messageP) {
@@ -713,38 +1170,24 @@ void log_message_start (
 
   if (*messageP) {
     struct timeval elapsed_time;
-    (*messageP)->u_app_log.log.log_level = log_levelP;
-    shared_log_get_elapsed_time_since_start(&elapsed_time);
+    (*messageP)->u_app_log.log.log_level   = log_levelP;
+    (*messageP)->u_app_log.log.proto       = protoP;
+    (*messageP)->u_app_log.log.source_file = source_fileP;
+    (*messageP)->u_app_log.log.line_num    = line_numP;
 
-    filename_length = strlen(source_fileP);
-    if (g_oai_log.is_ansi_codes) {
-      rv = bformata ((*messageP)->bstr, "%s", &g_oai_log.log_level2ansi[log_levelP][0]);
-    }
-    if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
-      rv = bformata ((*messageP)->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-          __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-          thread_ctxt->tid,
-          LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-          LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-          LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, &source_fileP[filename_length-LOG_DISPLAYED_FILENAME_MAX_LENGTH], line_numP,
-          thread_ctxt->indent, " ");
-    } else {
-      rv = bformata ((*messageP)->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-          __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-          thread_ctxt->tid,
-          LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-          LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-          LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_fileP, line_numP,
-          thread_ctxt->indent, " ");
-    }
+    if (!g_oai_log.is_output_binary) {
+      // in binary mode the header is part of the record, formatted by the log task
+      shared_log_get_elapsed_time_since_start(&elapsed_time);
+      rv = log_format_header ((*messageP)->bstr, log_levelP, protoP, source_fileP, line_numP, thread_ctxt->tid, thread_ctxt->indent, &elapsed_time);
 
-    if (BSTR_ERR == rv) {
-      OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
-      goto error_event_start;
+      if (BSTR_ERR == rv) {
+        OAI_FPRINTF_ERR("Error while logging message : %s", &g_oai_log.log_proto2str[protoP][0]);
+        goto error_event_start;
+      }
     }
 
     va_start (args, format);
-    rv = bformata ((*messageP)->bstr, format, args);
+    rv = bvcformata ((*messageP)->bstr, LOG_MESSAGE_MAX_FORMAT_LENGTH, format, args);
     va_end (args);
 
     if (BSTR_ERR == rv) {
@@ -771,17 +1214,8 @@ void log_func (
   const unsigned int line_numP,
   const char *const functionP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
+  log_thread_ctxt_t        *thread_ctxt = log_get_thread_context();
 
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
   if (is_enteringP) {
     log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Entering %s()\n", functionP);
     thread_ctxt->indent += LOG_FUNC_INDENT_SPACES;
@@ -800,17 +1234,8 @@ void log_func_return (
   const char *const functionP,
   const long return_codeP)
 {
-  log_thread_ctxt_t        *thread_ctxt = NULL;
-  hashtable_rc_t            hash_rc     = HASH_TABLE_OK;
-  pthread_t                 p           = pthread_self();
+  log_thread_ctxt_t        *thread_ctxt = log_get_thread_context();
 
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-    // make the thread safe LFDS collections usable by this thread
-    log_start_use();
-  }
-  hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-  AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
   thread_ctxt->indent -= LOG_FUNC_INDENT_SPACES;
   if (thread_ctxt->indent < 0) thread_ctxt->indent = 0;
   log_message(thread_ctxt, OAILOG_LEVEL_TRACE, protoP, source_fileP, line_numP, "Leaving %s() (rc=%ld)\n", functionP, return_codeP);
@@ -828,10 +1253,8 @@ log_message (
 {
   va_list                                 args;
   int                                     rv              = 0;
-  int                                     filename_length = 0;
   struct shared_log_queue_item_s         *new_item_p      = NULL;
   log_thread_ctxt_t                      *thread_ctxt     = thread_ctxtP;
-  hashtable_rc_t                          hash_rc         = HASH_TABLE_OK;
 
   if ((MIN_LOG_PROTOS > protoP) || (MAX_LOG_PROTOS <= protoP)) {
     return;
@@ -839,53 +1262,33 @@ log_message (
   if ((MIN_LOG_LEVEL > log_levelP) || (MAX_LOG_LEVEL <= log_levelP)) {
     return;
   }
-  if (log_levelP > g_oai_log.log_level[protoP]) {
+  if (log_levelP > g_oai_log_level[protoP]) {
     return;
   }
   if (NULL == thread_ctxt){
-    pthread_t             p           = pthread_self();
-    hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-    if (HASH_TABLE_KEY_NOT_EXISTS == hash_rc) {
-      // make the thread safe LFDS collections usable by this thread
-      log_start_use();
-      hash_rc = hashtable_ts_get (g_oai_log.thread_context_htbl, (hash_key_t) p, (void **)&thread_ctxt);
-      AssertFatal(NULL != thread_ctxt, "Could not get new log thread context\n");
-    }
+    thread_ctxt = log_get_thread_context();
+  }
+
+  if (g_oai_log.is_output_binary) {
+    va_start (args, format);
+    log_bin_message_v (thread_ctxt, log_levelP, protoP, source_fileP, line_numP, format, args);
+    va_end (args);
+    return;
   }
 
   new_item_p = get_new_log_queue_item(SH_TS_LOG_TXT);
 
   if (new_item_p) {
-    if (g_oai_log.is_ansi_codes) {
-      rv = bformata (new_item_p->bstr, "%s", &g_oai_log.log_level2ansi[log_levelP][0]);
-    }
     struct timeval elapsed_time;
     shared_log_get_elapsed_time_since_start(&elapsed_time);
-    filename_length = strlen(source_fileP);
-    if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
-      rv = bformata (new_item_p->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-          __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-          thread_ctxt->tid,
-          LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-          LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-          LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, &source_fileP[filename_length-LOG_DISPLAYED_FILENAME_MAX_LENGTH], line_numP,
-          thread_ctxt->indent, " ");
-    } else {
-      rv = bformata (new_item_p->bstr, "%06" PRIu64 " %05ld:%06ld %08lX %-*.*s %-*.*s %-*.*s:%04u   %*s",
-          __sync_fetch_and_add (&g_oai_log.log_message_number, 1), elapsed_time.tv_sec, elapsed_time.tv_usec,
-          thread_ctxt->tid,
-          LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, &g_oai_log.log_level2str[log_levelP][0],
-          LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, &g_oai_log.log_proto2str[protoP][0],
-          LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_fileP, line_numP,
-          thread_ctxt->indent, " ");
-    }
+    rv = log_format_header (new_item_p->bstr, log_levelP, protoP, source_fileP, line_numP, thread_ctxt->tid, thread_ctxt->indent, &elapsed_time);
 
     if (BSTR_ERR == rv) {
       OAI_FPRINTF_ERR("Error while logging LOG message : %s", &g_oai_log.log_proto2str[protoP][0]);
       goto error_event;
     }
     va_start (args, format);
-    rv = bvcformata (new_item_p->bstr, 4096, format, args); // big number
+    rv = bvcformata (new_item_p->bstr, LOG_MESSAGE_MAX_FORMAT_LENGTH, format, args);
     va_end (args);
 
     if (BSTR_ERR == rv) {
@@ -39,6 +39,8 @@
 
 #include <syslog.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 #include "bstrlib.h"
 
@@ -108,6 +110,7 @@ extern int fd_g_debug_lvl;
 #define LOG_CONFIG_STRING_SPGW_APP_LOG_LEVEL             "SPGW_APP_LOG_LEVEL"
 #define LOG_CONFIG_STRING_SPGW_APP_LOG_LEVEL             "SPGW_APP_LOG_LEVEL"
 #define LOG_CONFIG_STRING_OUTPUT_SYSLOG                  "SYSLOG"
+#define LOG_CONFIG_STRING_OUTPUT_BINARY                  "BINARY"
 #define LOG_CONFIG_STRING_OUTPUT_THREAD_SAFE             "THREAD_SAFE"
 #define LOG_CONFIG_STRING_UDP_LOG_LEVEL                  "UDP_LOG_LEVEL"
 #define LOG_CONFIG_STRING_UTIL_LOG_LEVEL                 "UTIL_LOG_LEVEL"
@@ -163,6 +166,7 @@ typedef enum {
 typedef struct log_thread_ctxt_s {
   int indent;
   pthread_t tid;
+  bool is_initialized;
 } log_thread_ctxt_t;
 
 /*! \struct  log_private_t
@@ -173,6 +177,9 @@ typedef struct log_thread_ctxt_s {
 */
 typedef struct log_private_s {
   int32_t                                 log_level; /*!< \brief log level. */
+  int32_t                                 proto;     /*!< \brief log client (protocol/layer), used by binary output. */
+  const char                             *source_file; /*!< \brief source file of the call site, used by binary output. */
+  uint32_t                                line_num;  /*!< \brief source line of the call site, used by binary output. */
 } log_private_t;
 
 /*! \struct  log_config_t
@@ -182,6 +189,7 @@ typedef struct log_private_s {
 typedef struct log_config_s {
   bstring       output;             /*!< \brief Where logs go, choice in { "CONSOLE", "`path to file`", "`IPv4@`:`TCP port num`"} . */
   bool          is_output_thread_safe; /*!< \brief Is final string goes in a thread safe buffer of is flushed without care . */
+  bool          is_output_binary;   /*!< \brief Log call sites only enqueue binary records in a per-thread ring, formatting is deferred to the log task (raw records are written if output is a file). */
   log_level_t   udp_log_level;      /*!< \brief UDP ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv1u_log_level;   /*!< \brief GTPv1-U ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
   log_level_t   gtpv2c_log_level;   /*!< \brief GTPv2-C ITTI task log level starting from OAILOG_LEVEL_EMERGENCY up to MAX_LOG_LEVEL (no log) */
@@ -282,41 +290,64 @@ void log_message (
 
 int log_get_start_time_sec (void);
 
+extern log_level_t g_oai_log_level[MAX_LOG_PROTOS];
+
+/* Highest log level compiled in, constant levels above it are folded to dead code */
+#    if DEBUG_IS_ON && TRACE_IS_ON && !LOG_OAI_DISABLE_TRACE
+#      define OAILOG_MAX_COMPILED_LEVEL                                 OAILOG_LEVEL_TRACE
+#    elif DEBUG_IS_ON
+#      define OAILOG_MAX_COMPILED_LEVEL                                 OAILOG_LEVEL_DEBUG
+#    else
+#      define OAILOG_MAX_COMPILED_LEVEL                                 OAILOG_LEVEL_INFO
+#    endif
+
+/* Inline filter evaluated before any argument of the log call */
+#    define OAILOG_LEVEL_IS_ON(lOgLeVeL, pRoTo)                         (((lOgLeVeL) <= OAILOG_MAX_COMPILED_LEVEL) && \
+                                                                         __builtin_expect((lOgLeVeL) <= g_oai_log_level[(pRoTo)], 0))
+
 #    define OAILOG_SET_CONFIG                                           log_set_config
 #    define OAILOG_LEVEL_STR2INT                                        log_level_str2int
 #    define OAILOG_LEVEL_INT2STR                                        log_level_int2str
 #    define OAILOG_INIT                                                 log_init
 #    define OAILOG_ITTI_CONNECT                                         log_itti_connect
 #    define OAILOG_EXIT()                                               log_exit()
-#    define OAILOG_SPEC(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief 3GPP trace on specifications */
-#    define OAILOG_EMERGENCY(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_EMERGENCY,pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)/*!< \brief system is unusable */
-#    define OAILOG_ALERT(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ALERT,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief action must be taken immediately */
-#    define OAILOG_CRITICAL(pRoTo, ...)                                 do { log_message(NULL, OAILOG_LEVEL_CRITICAL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief critical conditions */
-#    define OAILOG_ERROR(pRoTo, ...)                                    do { log_message(NULL, OAILOG_LEVEL_ERROR,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief error conditions */
-#    define OAILOG_WARNING(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_WARNING,  pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief warning conditions */
-#    define OAILOG_NOTICE(pRoTo, ...)                                   do { log_message(NULL, OAILOG_LEVEL_NOTICE,   pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief normal but significant condition */
-#    define OAILOG_INFO(pRoTo, ...)                                     do { log_message(NULL, OAILOG_LEVEL_INFO,     pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief informational */
-#    define OAILOG_MESSAGE_START(lOgLeVeL, pRoTo, cOnTeXt, ...)         do { log_message_start(NULL, lOgLeVeL, pRoTo, cOnTeXt, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief when need to log only 1 message with many char messages, ex formating a dumped struct */
-#    define OAILOG_MESSAGE_ADD(cOnTeXt, ...)                            do { log_message_add(cOnTeXt, ##__VA_ARGS__); } while(0) /*!< \brief can be called as many times as needed after OAILOG_MESSAGE_START() */
-#    define OAILOG_MESSAGE_FINISH(cOnTeXt)                              do { log_message_finish(cOnTeXt); } while(0) /*!< \brief Send the message built by OAILOG_MESSAGE_START() n*LOG_MESSAGE_ADD() (n=0..N) */
-#    define OAILOG_STREAM_HEX(lOgLeVeL, pRoTo, mEsSaGe, sTrEaM, sIzE)   do { \
+#    define OAILOG_LOG(lOgLeVeL, pRoTo, ...)                            do { if (OAILOG_LEVEL_IS_ON(lOgLeVeL, pRoTo)) \
+                                                                           log_message(NULL, lOgLeVeL, pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
+#    define OAILOG_SPEC(pRoTo, ...)                                     OAILOG_LOG(OAILOG_LEVEL_NOTICE,    pRoTo, ##__VA_ARGS__) /*!< \brief 3GPP trace on specifications */
+#    define OAILOG_EMERGENCY(pRoTo, ...)                                OAILOG_LOG(OAILOG_LEVEL_EMERGENCY, pRoTo, ##__VA_ARGS__) /*!< \brief system is unusable */
+#    define OAILOG_ALERT(pRoTo, ...)                                    OAILOG_LOG(OAILOG_LEVEL_ALERT,     pRoTo, ##__VA_ARGS__) /*!< \brief action must be taken immediately */
+#    define OAILOG_CRITICAL(pRoTo, ...)                                 OAILOG_LOG(OAILOG_LEVEL_CRITICAL,  pRoTo, ##__VA_ARGS__) /*!< \brief critical conditions */
+#    define OAILOG_ERROR(pRoTo, ...)                                    OAILOG_LOG(OAILOG_LEVEL_ERROR,     pRoTo, ##__VA_ARGS__) /*!< \brief error conditions */
+#    define OAILOG_WARNING(pRoTo, ...)                                  OAILOG_LOG(OAILOG_LEVEL_WARNING,   pRoTo, ##__VA_ARGS__) /*!< \brief warning conditions */
+#    define OAILOG_NOTICE(pRoTo, ...)                                   OAILOG_LOG(OAILOG_LEVEL_NOTICE,    pRoTo, ##__VA_ARGS__) /*!< \brief normal but significant condition */
+#    define OAILOG_INFO(pRoTo, ...)                                     OAILOG_LOG(OAILOG_LEVEL_INFO,      pRoTo, ##__VA_ARGS__) /*!< \brief informational */
+#    define OAILOG_MESSAGE_START(lOgLeVeL, pRoTo, cOnTeXt, ...)         do { if (OAILOG_LEVEL_IS_ON(lOgLeVeL, pRoTo)) \
+                                                                           log_message_start(NULL, lOgLeVeL, pRoTo, cOnTeXt, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief when need to log only 1 message with many char messages, ex formating a dumped struct */
+#    define OAILOG_MESSAGE_ADD(cOnTeXt, ...)                            do { if (cOnTeXt) log_message_add(cOnTeXt, ##__VA_ARGS__); } while(0) /*!< \brief can be called as many times as needed after OAILOG_MESSAGE_START() */
+#    define OAILOG_MESSAGE_FINISH(cOnTeXt)                              do { if (cOnTeXt) log_message_finish(cOnTeXt); } while(0) /*!< \brief Send the message built by OAILOG_MESSAGE_START() n*LOG_MESSAGE_ADD() (n=0..N) */
+#    define OAILOG_STREAM_HEX(lOgLeVeL, pRoTo, mEsSaGe, sTrEaM, sIzE)   do { if (OAILOG_LEVEL_IS_ON(lOgLeVeL, pRoTo)) { \
                                                                    OAI_GCC_DIAG_OFF(pointer-sign); \
                                                                    log_stream_hex(lOgLeVeL, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE);\
                                                                    OAI_GCC_DIAG_ON(pointer-sign); \
-                                                                 } while(0); /*!< \brief trace buffer content */
+                                                                 } } while(0) /*!< \brief trace buffer content */
 #    if DEBUG_IS_ON
-#      define OAILOG_DEBUG(pRoTo, ...)                                  do { log_message(NULL, OAILOG_LEVEL_DEBUG,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief debug informations */
-#      if TRACE_IS_ON
-#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   do { log_message(NULL, lOgLeVeL       ,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0)
-#        define OAILOG_TRACE(pRoTo, ...)                                do { log_message(NULL, OAILOG_LEVEL_TRACE,    pRoTo, __FILE__, __LINE__, ##__VA_ARGS__); } while(0) /*!< \brief most detailled informations, struct dumps */
-#        define OAILOG_FUNC_IN(pRoTo)                                   do { log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_OUT(pRoTo)                                  do { log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
-#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
-#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
+#      define OAILOG_DEBUG(pRoTo, ...)                                  OAILOG_LOG(OAILOG_LEVEL_DEBUG,     pRoTo, ##__VA_ARGS__) /*!< \brief debug informations */
+#      if TRACE_IS_ON && !LOG_OAI_DISABLE_TRACE
+#        define OAILOG_EXTERNAL(lOgLeVeL, pRoTo, ...)                   OAILOG_LOG(lOgLeVeL,               pRoTo, ##__VA_ARGS__)
+#        define OAILOG_TRACE(pRoTo, ...)                                OAILOG_LOG(OAILOG_LEVEL_TRACE,     pRoTo, ##__VA_ARGS__) /*!< \brief most detailled informations, struct dumps */
+#        define OAILOG_FUNC_IN(pRoTo)                                   do { if (OAILOG_LEVEL_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) \
+                                                                             log_func(true, pRoTo, __FILE__, __LINE__, __FUNCTION__); } while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_OUT(pRoTo)                                  do { if (OAILOG_LEVEL_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) \
+                                                                             log_func(false, pRoTo, __FILE__, __LINE__, __FUNCTION__); return;} while(0) /*!< \brief informational */
+#        define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                   do { if (OAILOG_LEVEL_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) \
+                                                                             log_func_return(pRoTo, __FILE__, __LINE__, __FUNCTION__, (long)rEtUrNcOdE); return rEtUrNcOdE;} while(0) /*!< \brief informational */
+#        define OAILOG_STREAM_HEX_ARRAY(pRoTo, mEsSaGe, sTrEaM, sIzE)       do { if (OAILOG_LEVEL_IS_ON(OAILOG_LEVEL_TRACE, pRoTo)) \
+                                                                             log_stream_hex_array(OAILOG_LEVEL_TRACE, pRoTo, __FILE__, __LINE__, mEsSaGe, sTrEaM, sIzE); } while(0) /*!< \brief trace buffer content with indexes */
 #      endif
 #    endif
 #    include "shared_ts_log.h"
 #  else
+#    define OAILOG_LEVEL_IS_ON(lOgLeVeL, pRoTo)                         (0)
 #    define OAILOG_SPEC(...)
 #    define OAILOG_SET_CONFIG(a)
 #    define OAILOG_LEVEL_STR2INT(a)                                     OAILOG_LEVEL_EMERGENCY
@@ -337,28 +368,28 @@ int log_get_start_time_sec (void);
 #  endif
 
 #  if !defined(OAILOG_DEBUG)
-#    define OAILOG_DEBUG(...)                                           {void;}
+#    define OAILOG_DEBUG(...)                                           do {} while(0)
 #  endif
 #  if !defined(OAILOG_TRACE)
-#    define OAILOG_TRACE(...)                                           {void;}
+#    define OAILOG_TRACE(...)                                           do {} while(0)
 #  endif
 #  if !defined(OAILOG_EXTERNAL)
-#    define OAILOG_EXTERNAL(...)                                        {void;}
+#    define OAILOG_EXTERNAL(...)                                        do {} while(0)
 #  endif
 #  if !defined(OAILOG_FUNC_IN)
-#    define OAILOG_FUNC_IN(...)                                         {void;}
+#    define OAILOG_FUNC_IN(...)                                         do {} while(0)
 #  endif
 #  if !defined(OAILOG_FUNC_OUT)
-#    define OAILOG_FUNC_OUT(pRoTo)                                      do{ return;} while 0
+#    define OAILOG_FUNC_OUT(pRoTo)                                      do { return;} while(0)
 #  endif
 #  if !defined(OAILOG_FUNC_RETURN)
-#    define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                       do{ return rEtUrNcOdE;} while 0
+#    define OAILOG_FUNC_RETURN(pRoTo, rEtUrNcOdE)                       do { return rEtUrNcOdE;} while(0)
 #  endif
 #  if !defined(OAILOG_STREAM_HEX)
-#    define OAILOG_STREAM_HEX(...)                                      {void;}
+#    define OAILOG_STREAM_HEX(...)                                      do {} while(0)
 #  endif
 #  if !defined(OAILOG_STREAM_HEX_ARRAY)
-#    define OAILOG_STREAM_HEX_ARRAY(...)                                {void;}
+#    define OAILOG_STREAM_HEX_ARRAY(...)                                do {} while(0)
 #  endif
 
 #  if DAEMONIZE
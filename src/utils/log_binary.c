@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file log_binary.c
+   \brief Binary log records: printf format analysis, argument packing and deferred rendering.
+   \author  Lionel GAUTHIER
+   \date 2016
+   \email: lionel.gauthier@eurecom.fr
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+#include "log_binary.h"
+
+#define LOG_BIN_MAX_SPEC_LENGTH   32
+
+//------------------------------------------------------------------------------
+// Walk one conversion specification starting after '%', return pointer on conversion char or NULL
+static const char * log_bin_parse_spec(const char *p, int * const num_stars, log_bin_arg_type_t * const type)
+{
+  bool  is_64 = false;
+
+  *num_stars = 0;
+  while (('-' == *p) || ('+' == *p) || (' ' == *p) || ('#' == *p) || ('0' == *p) || ('\'' == *p)) p++;
+  if ('*' == *p) {
+    (*num_stars)++;
+    p++;
+  } else {
+    while ((*p >= '0') && (*p <= '9')) p++;
+  }
+  if ('.' == *p) {
+    p++;
+    if ('*' == *p) {
+      (*num_stars)++;
+      p++;
+    } else {
+      while ((*p >= '0') && (*p <= '9')) p++;
+    }
+  }
+  switch (*p) {
+  case 'h':
+    p++;
+    if ('h' == *p) p++;
+    break;
+  case 'l':
+    p++;
+    is_64 = true;
+    if ('l' == *p) p++;
+    break;
+  case 'j':
+  case 'z':
+  case 't':
+  case 'q':
+    p++;
+    is_64 = true;
+    break;
+  case 'L':
+    // long double not supported
+    return NULL;
+  default:;
+  }
+  switch (*p) {
+  case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+    *type = (is_64) ? LOG_BIN_ARG_INT64 : LOG_BIN_ARG_INT32;
+    return p;
+  case 'c':
+    if (is_64) return NULL; // wint_t
+    *type = LOG_BIN_ARG_INT32;
+    return p;
+  case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+    *type = LOG_BIN_ARG_DOUBLE;
+    return p;
+  case 's':
+    if (is_64) return NULL; // wchar_t *
+    *type = LOG_BIN_ARG_STRING;
+    return p;
+  case 'p':
+    *type = LOG_BIN_ARG_POINTER;
+    return p;
+  default:
+    // %n, %m, bad format
+    return NULL;
+  }
+}
+
+//------------------------------------------------------------------------------
+int log_bin_parse_format(const char * const format, uint8_t * const arg_types, const int max_args)
+{
+  const char          *p = format;
+  int                  num_args = 0;
+  int                  num_stars = 0;
+  log_bin_arg_type_t   type = 0;
+
+  if (!format) return -1;
+  while (*p) {
+    if ('%' != *p++) continue;
+    if ('%' == *p) {
+      p++;
+      continue;
+    }
+    p = log_bin_parse_spec(p, &num_stars, &type);
+    if ((!p) || ((num_args + num_stars + 1) > max_args)) {
+      return -1;
+    }
+    for (int i = 0; i < num_stars; i++) {
+      arg_types[num_args++] = LOG_BIN_ARG_INT32;
+    }
+    arg_types[num_args++] = type;
+    p++;
+  }
+  return num_args;
+}
+
+//------------------------------------------------------------------------------
+size_t log_bin_pack_args(uint8_t * const buffer, const size_t size, const uint8_t * const arg_types, const int num_args, va_list args)
+{
+  size_t   offset = 0;
+
+  for (int i = 0; i < num_args; i++) {
+    switch (arg_types[i]) {
+    case LOG_BIN_ARG_INT32: {
+        int32_t v = va_arg(args, int);
+        if ((offset + sizeof(v)) > size) return offset;
+        memcpy(&buffer[offset], &v, sizeof(v));
+        offset += sizeof(v);
+      }
+      break;
+    case LOG_BIN_ARG_INT64: {
+        int64_t v = va_arg(args, long long);
+        if ((offset + sizeof(v)) > size) return offset;
+        memcpy(&buffer[offset], &v, sizeof(v));
+        offset += sizeof(v);
+      }
+      break;
+    case LOG_BIN_ARG_DOUBLE: {
+        double v = va_arg(args, double);
+        if ((offset + sizeof(v)) > size) return offset;
+        memcpy(&buffer[offset], &v, sizeof(v));
+        offset += sizeof(v);
+      }
+      break;
+    case LOG_BIN_ARG_POINTER: {
+        uint64_t v = (uintptr_t)va_arg(args, void *);
+        if ((offset + sizeof(v)) > size) return offset;
+        memcpy(&buffer[offset], &v, sizeof(v));
+        offset += sizeof(v);
+      }
+      break;
+    case LOG_BIN_ARG_STRING: {
+        const char *s = va_arg(args, const char *);
+        uint16_t    length = 0;
+        if (!s) s = "(null)";
+        length = strnlen(s, LOG_BIN_MAX_STRING_LENGTH);
+        if ((offset + sizeof(length) + length) > size) return offset;
+        memcpy(&buffer[offset], &length, sizeof(length));
+        offset += sizeof(length);
+        memcpy(&buffer[offset], s, length);
+        offset += length;
+      }
+      break;
+    default:
+      return offset;
+    }
+  }
+  return offset;
+}
+
+//------------------------------------------------------------------------------
+int log_bin_render(char * const buffer, const size_t size, const char * const format, const uint8_t * const arg_types, const int num_args,
+    const uint8_t * const packed_args, const size_t packed_args_length)
+{
+  const char          *p = format;
+  size_t               out = 0;
+  size_t               in = 0;
+  int                  arg = 0;
+  int                  num_stars = 0;
+  log_bin_arg_type_t   type = 0;
+  char                 spec[LOG_BIN_MAX_SPEC_LENGTH];
+  char                 str[LOG_BIN_MAX_STRING_LENGTH + 1];
+  int32_t              stars[2] = {0, 0};
+
+  if ((!buffer) || (!size) || (!format)) return -1;
+
+#define LOG_BIN_READ(vAlUe) do { \
+    if ((in + sizeof(vAlUe)) > packed_args_length) goto malformed; \
+    memcpy(&(vAlUe), &packed_args[in], sizeof(vAlUe)); \
+    in += sizeof(vAlUe); \
+  } while (0)
+
+#define LOG_BIN_EMIT(...) do { \
+    int rv = snprintf(&buffer[out], size - out, __VA_ARGS__); \
+    if (rv > 0) out += ((size_t)rv < (size - out)) ? (size_t)rv : (size - out - 1); \
+  } while (0)
+
+  buffer[0] = '\0';
+  while ((*p) && (out < (size - 1))) {
+    if ('%' != *p) {
+      buffer[out++] = *p++;
+      continue;
+    }
+    if ('%' == p[1]) {
+      buffer[out++] = '%';
+      p += 2;
+      continue;
+    }
+    const char *conv = log_bin_parse_spec(p + 1, &num_stars, &type);
+    if ((!conv) || ((conv - p + 2) > LOG_BIN_MAX_SPEC_LENGTH) || ((arg + num_stars + 1) > num_args)) goto malformed;
+    memcpy(spec, p, conv - p + 1);
+    spec[conv - p + 1] = '\0';
+    p = conv + 1;
+
+    for (int i = 0; i < num_stars; i++) {
+      if (LOG_BIN_ARG_INT32 != arg_types[arg++]) goto malformed;
+      LOG_BIN_READ(stars[i]);
+    }
+    if (type != arg_types[arg++]) goto malformed;
+
+    switch (type) {
+    case LOG_BIN_ARG_INT32: {
+        int32_t v = 0;
+        LOG_BIN_READ(v);
+        if (0 == num_stars) LOG_BIN_EMIT(spec, v);
+        else if (1 == num_stars) LOG_BIN_EMIT(spec, stars[0], v);
+        else LOG_BIN_EMIT(spec, stars[0], stars[1], v);
+      }
+      break;
+    case LOG_BIN_ARG_INT64: {
+        long long v = 0;
+        int64_t   v64 = 0;
+        LOG_BIN_READ(v64);
+        v = v64;
+        if (0 == num_stars) LOG_BIN_EMIT(spec, v);
+        else if (1 == num_stars) LOG_BIN_EMIT(spec, stars[0], v);
+        else LOG_BIN_EMIT(spec, stars[0], stars[1], v);
+      }
+      break;
+    case LOG_BIN_ARG_DOUBLE: {
+        double v = 0;
+        LOG_BIN_READ(v);
+        if (0 == num_stars) LOG_BIN_EMIT(spec, v);
+        else if (1 == num_stars) LOG_BIN_EMIT(spec, stars[0], v);
+        else LOG_BIN_EMIT(spec, stars[0], stars[1], v);
+      }
+      break;
+    case LOG_BIN_ARG_POINTER: {
+        uint64_t v = 0;
+        LOG_BIN_READ(v);
+        void *ptr = (void *)(uintptr_t)v;
+        if (0 == num_stars) LOG_BIN_EMIT(spec, ptr);
+        else if (1 == num_stars) LOG_BIN_EMIT(spec, stars[0], ptr);
+        else LOG_BIN_EMIT(spec, stars[0], stars[1], ptr);
+      }
+      break;
+    case LOG_BIN_ARG_STRING: {
+        uint16_t length = 0;
+        LOG_BIN_READ(length);
+        if ((length > LOG_BIN_MAX_STRING_LENGTH) || ((in + length) > packed_args_length)) goto malformed;
+        memcpy(str, &packed_args[in], length);
+        str[length] = '\0';
+        in += length;
+        if (0 == num_stars) LOG_BIN_EMIT(spec, str);
+        else if (1 == num_stars) LOG_BIN_EMIT(spec, stars[0], str);
+        else LOG_BIN_EMIT(spec, stars[0], stars[1], str);
+      }
+      break;
+    default:
+      goto malformed;
+    }
+  }
+  buffer[out] = '\0';
+  return (int)out;
+
+malformed:
+  buffer[out] = '\0';
+  return -1;
+#undef LOG_BIN_READ
+#undef LOG_BIN_EMIT
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file log_binary.h
+   \brief Binary log records: printf format analysis, argument packing and deferred rendering.
+   This file has no dependency on the rest of the logging utility so that it can be
+   linked in the offline decoder.
+   \author  Lionel GAUTHIER
+   \date 2016
+   \email: lionel.gauthier@eurecom.fr
+*/
+#ifndef FILE_LOG_BINARY_SEEN
+#define FILE_LOG_BINARY_SEEN
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#define LOG_BIN_FILE_MAGIC                  "OAIBLOG1"
+#define LOG_BIN_FILE_MAGIC_LENGTH                    8
+#define LOG_BIN_FILE_VERSION                         1
+
+#define LOG_BIN_MAX_ARGS                            24
+#define LOG_BIN_MAX_STRING_LENGTH                 2048  /*!< \brief %s arguments are truncated to this length */
+#define LOG_BIN_MAX_ARGS_LENGTH                   4096
+#define LOG_BIN_MAX_NAME_LENGTH                     16
+
+/*! \brief Id of the site used for messages that could not be analyzed or were formatted by caller */
+#define LOG_BIN_GENERIC_FORMAT                    "%s"
+
+typedef enum {
+  LOG_BIN_ARG_INT32 = 1,
+  LOG_BIN_ARG_INT64,
+  LOG_BIN_ARG_DOUBLE,
+  LOG_BIN_ARG_POINTER,
+  LOG_BIN_ARG_STRING,
+} log_bin_arg_type_t;
+
+typedef enum {
+  LOG_BIN_CHUNK_PROTO_NAME = 1,   /*!< \brief log_bin_name_t */
+  LOG_BIN_CHUNK_LEVEL_NAME,       /*!< \brief log_bin_name_t */
+  LOG_BIN_CHUNK_FORMAT,           /*!< \brief log_bin_format_t + arg types + file name + format string */
+  LOG_BIN_CHUNK_RECORD,           /*!< \brief log_bin_record_t + packed arguments */
+  LOG_BIN_CHUNK_DROPPED,          /*!< \brief log_bin_dropped_t */
+} log_bin_chunk_type_t;
+
+/*! \struct  log_bin_file_header_t
+* \brief Header at the beginning of a binary log file.
+*/
+typedef struct log_bin_file_header_s {
+  char                 magic[LOG_BIN_FILE_MAGIC_LENGTH];
+  uint32_t             version;
+  uint32_t             reserved;
+  int64_t              start_time_sec;      /*!< \brief epoch seconds, reference of displayed elapsed time */
+} __attribute__((packed)) log_bin_file_header_t;
+
+/*! \struct  log_bin_chunk_header_t
+* \brief Every item following the file header is a TLV chunk.
+*/
+typedef struct log_bin_chunk_header_s {
+  uint16_t             type;                /*!< \brief log_bin_chunk_type_t */
+  uint16_t             length;              /*!< \brief length of the value following this header */
+} __attribute__((packed)) log_bin_chunk_header_t;
+
+typedef struct log_bin_name_s {
+  uint8_t              id;
+  char                 name[LOG_BIN_MAX_NAME_LENGTH];
+} __attribute__((packed)) log_bin_name_t;
+
+/*! \struct  log_bin_format_t
+* \brief Definition of a logging call site, written once before its first record.
+* Followed by num_args arg types (uint8_t), file_length bytes of file name, format_length bytes of format.
+*/
+typedef struct log_bin_format_s {
+  uint16_t             fmt_id;
+  uint16_t             line;
+  uint8_t              num_args;
+  uint8_t              reserved;
+  uint16_t             file_length;
+  uint16_t             format_length;
+} __attribute__((packed)) log_bin_format_t;
+
+/*! \struct  log_bin_record_t
+* \brief One log message, followed by args_length bytes of packed arguments.
+*/
+typedef struct log_bin_record_s {
+  uint64_t             timestamp_ns;        /*!< \brief CLOCK_REALTIME */
+  uint64_t             tid;
+  uint16_t             fmt_id;
+  uint8_t              log_level;
+  uint8_t              proto;
+  uint16_t             indent;
+  uint16_t             args_length;
+} __attribute__((packed)) log_bin_record_t;
+
+typedef struct log_bin_dropped_s {
+  uint64_t             tid;
+  uint64_t             num_dropped;         /*!< \brief records lost because the thread ring was full */
+} __attribute__((packed)) log_bin_dropped_t;
+
+/*
+ * Analyze a printf format string.
+ *
+ * @param format     printf format string
+ * @param arg_types  out, one log_bin_arg_type_t per expected argument (including '*' width/precision)
+ * @param max_args   capacity of arg_types
+ *
+ * @return number of arguments, or -1 if the format cannot be deferred (%n, long double, wide chars, too many args).
+ */
+int log_bin_parse_format(const char * const format, uint8_t * const arg_types, const int max_args);
+
+/*
+ * Pack the arguments described by arg_types from a va_list.
+ *
+ * @return number of bytes written in buffer.
+ */
+size_t log_bin_pack_args(uint8_t * const buffer, const size_t size, const uint8_t * const arg_types, const int num_args, va_list args);
+
+/*
+ * Render a message from its format string and packed arguments, like snprintf.
+ *
+ * @return number of characters written (excluding terminating nul), or -1 on malformed arguments.
+ */
+int log_bin_render(char * const buffer, const size_t size, const char * const format, const uint8_t * const arg_types, const int num_args,
+    const uint8_t * const packed_args, const size_t packed_args_length);
+
+#endif /* FILE_LOG_BINARY_SEEN */
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2015, EURECOM (www.eurecom.fr)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are those
+ * of the authors and should not be interpreted as representing official policies,
+ * either expressed or implied, of the FreeBSD Project.
+ */
+
+/*! \file log_decoder.c
+   \brief Offline decoder of binary log files (LOGGING.BINARY = "yes" with a file OUTPUT).
+   Output has the same layout as the text logging utility.
+   \author  Lionel GAUTHIER
+   \date 2016
+   \email: lionel.gauthier@eurecom.fr
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <errno.h>
+
+#include "log_binary.h"
+
+#define LOG_DECODER_MAX_SITES                 65536
+#define LOG_DECODER_MAX_NAMES                   256
+#define LOG_DECODER_MAX_TEXT_LENGTH            8192
+#define LOG_DISPLAYED_FILENAME_MAX_LENGTH        32
+#define LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH   5
+#define LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH       6
+
+typedef struct log_decoder_site_s {
+  bool      is_defined;
+  uint16_t  line;
+  int       num_args;
+  uint8_t   arg_types[LOG_BIN_MAX_ARGS];
+  char     *source_file;
+  char     *format;
+} log_decoder_site_t;
+
+static log_decoder_site_t  sites[LOG_DECODER_MAX_SITES];
+static char                proto2str[LOG_DECODER_MAX_NAMES][LOG_BIN_MAX_NAME_LENGTH + 1];
+static char                level2str[LOG_DECODER_MAX_NAMES][LOG_BIN_MAX_NAME_LENGTH + 1];
+static uint64_t            message_number = 0;
+
+//------------------------------------------------------------------------------
+static char * dup_string(const uint8_t * const data, const size_t length)
+{
+  char *s = malloc(length + 1);
+
+  if (s) {
+    memcpy(s, data, length);
+    s[length] = '\0';
+  }
+  return s;
+}
+
+//------------------------------------------------------------------------------
+static int decode_format(const uint8_t * const value, const size_t length)
+{
+  log_bin_format_t    definition;
+  log_decoder_site_t *site = NULL;
+  size_t              offset = sizeof(definition);
+
+  if (length < sizeof(definition)) return -1;
+  memcpy(&definition, value, sizeof(definition));
+  if ((definition.num_args > LOG_BIN_MAX_ARGS) ||
+      ((offset + definition.num_args + definition.file_length + definition.format_length) > length)) {
+    return -1;
+  }
+  site = &sites[definition.fmt_id];
+  free(site->source_file);
+  free(site->format);
+  site->line     = definition.line;
+  site->num_args = definition.num_args;
+  memcpy(site->arg_types, &value[offset], definition.num_args);
+  offset += definition.num_args;
+  site->source_file = dup_string(&value[offset], definition.file_length);
+  offset += definition.file_length;
+  site->format = dup_string(&value[offset], definition.format_length);
+  site->is_defined = (site->source_file) && (site->format);
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int decode_record(FILE * const out, const uint8_t * const value, const size_t length, const int64_t start_time_sec)
+{
+  log_bin_record_t    record;
+  log_decoder_site_t *site = NULL;
+  const char         *source_file = NULL;
+  size_t              filename_length = 0;
+  char                text[LOG_DECODER_MAX_TEXT_LENGTH];
+
+  if (length < sizeof(record)) return -1;
+  memcpy(&record, value, sizeof(record));
+  if ((sizeof(record) + record.args_length) > length) return -1;
+  site = &sites[record.fmt_id];
+  if (!site->is_defined) {
+    fprintf(out, "<undefined format id %u>\n", record.fmt_id);
+    return 0;
+  }
+  source_file = site->source_file;
+  filename_length = strlen(source_file);
+  if (filename_length > LOG_DISPLAYED_FILENAME_MAX_LENGTH) {
+    source_file = &source_file[filename_length - LOG_DISPLAYED_FILENAME_MAX_LENGTH];
+  }
+  fprintf(out, "%06" PRIu64 " %05ld:%06ld %08" PRIX64 " %-*.*s %-*.*s %-*.*s:%04u   %*s",
+      message_number++,
+      (long)((record.timestamp_ns / 1000000000ULL) - start_time_sec), (long)((record.timestamp_ns % 1000000000ULL) / 1000),
+      record.tid,
+      LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, LOG_DISPLAYED_LOG_LEVEL_NAME_MAX_LENGTH, level2str[record.log_level],
+      LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, LOG_DISPLAYED_PROTO_NAME_MAX_LENGTH, proto2str[record.proto],
+      LOG_DISPLAYED_FILENAME_MAX_LENGTH, LOG_DISPLAYED_FILENAME_MAX_LENGTH, source_file, site->line,
+      record.indent, " ");
+  if (0 > log_bin_render(text, sizeof(text), site->format, site->arg_types, site->num_args, &value[sizeof(record)], record.args_length)) {
+    fprintf(out, "<malformed record> %s\n", text);
+  } else {
+    fputs(text, out);
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static void usage(const char * const exe)
+{
+  fprintf(stderr, "Usage: %s <binary log file> [output text file]\n", exe);
+  fprintf(stderr, "Converts a binary log file written with LOGGING.BINARY = \"yes\" to text.\n");
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  FILE                   *in = NULL;
+  FILE                   *out = stdout;
+  log_bin_file_header_t   header;
+  log_bin_chunk_header_t  chunk;
+  log_bin_name_t          name;
+  uint8_t                 value[UINT16_MAX + 1];
+  uint64_t                num_chunks = 0;
+  int                     rc = EXIT_SUCCESS;
+
+  if ((argc < 2) || (argc > 3)) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  in = fopen(argv[1], "rb");
+  if (!in) {
+    fprintf(stderr, "Could not open %s: %s\n", argv[1], strerror(errno));
+    return EXIT_FAILURE;
+  }
+  if (3 == argc) {
+    out = fopen(argv[2], "w");
+    if (!out) {
+      fprintf(stderr, "Could not open %s: %s\n", argv[2], strerror(errno));
+      fclose(in);
+      return EXIT_FAILURE;
+    }
+  }
+  if ((1 != fread(&header, sizeof(header), 1, in)) ||
+      (memcmp(header.magic, LOG_BIN_FILE_MAGIC, LOG_BIN_FILE_MAGIC_LENGTH)) ||
+      (LOG_BIN_FILE_VERSION != header.version)) {
+    fprintf(stderr, "%s is not a binary log file (version %u)\n", argv[1], LOG_BIN_FILE_VERSION);
+    rc = EXIT_FAILURE;
+    goto end;
+  }
+  for (int i = 0; i < LOG_DECODER_MAX_NAMES; i++) {
+    snprintf(proto2str[i], sizeof(proto2str[i]), "%d", i);
+    snprintf(level2str[i], sizeof(level2str[i]), "%d", i);
+  }
+
+  while (1 == fread(&chunk, sizeof(chunk), 1, in)) {
+    if ((chunk.length) && (1 != fread(value, chunk.length, 1, in))) {
+      fprintf(stderr, "Truncated chunk %" PRIu64 "\n", num_chunks);
+      break;
+    }
+    num_chunks++;
+    switch (chunk.type) {
+    case LOG_BIN_CHUNK_PROTO_NAME:
+    case LOG_BIN_CHUNK_LEVEL_NAME:
+      if (chunk.length >= sizeof(name)) {
+        memcpy(&name, value, sizeof(name));
+        char *dest = (LOG_BIN_CHUNK_PROTO_NAME == chunk.type) ? proto2str[name.id] : level2str[name.id];
+        memcpy(dest, name.name, LOG_BIN_MAX_NAME_LENGTH);
+        dest[LOG_BIN_MAX_NAME_LENGTH] = '\0';
+      }
+      break;
+    case LOG_BIN_CHUNK_FORMAT:
+      if (decode_format(value, chunk.length)) {
+        fprintf(stderr, "Bad format definition in chunk %" PRIu64 "\n", num_chunks);
+      }
+      break;
+    case LOG_BIN_CHUNK_RECORD:
+      if (decode_record(out, value, chunk.length, header.start_time_sec)) {
+        fprintf(stderr, "Bad record in chunk %" PRIu64 "\n", num_chunks);
+      }
+      break;
+    case LOG_BIN_CHUNK_DROPPED:
+      if (chunk.length >= sizeof(log_bin_dropped_t)) {
+        log_bin_dropped_t dropped;
+        memcpy(&dropped, value, sizeof(dropped));
+        fprintf(out, "%08" PRIX64 " %" PRIu64 " log messages dropped\n", dropped.tid, dropped.num_dropped);
+      }
+      break;
+    default:
+      // unknown chunk, skip it
+      break;
+    }
+  }
+
+end:
+  for (int i = 0; i < LOG_DECODER_MAX_SITES; i++) {
+    free(sites[i].source_file);
+    free(sites[i].format);
+  }
+  fclose(in);
+  if (stdout != out) fclose(out);
+  return rc;
+}
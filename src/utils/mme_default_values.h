@@ -55,6 +55,15 @@
 
 #define S6A_CONF_FILE "../S6A/freediameter/s6a.conf"
 
+#define S6A_MAX_IN_FLIGHT_PER_HSS  (128)   ///< Requests sent and not yet answered, per HSS
+#define S6A_REQUEST_BACKLOG        (1024)  ///< Requests waiting for an HSS window slot
+#define S6A_REQUEST_TIMEOUT_MS     (1500)  ///< Requests without answer after this delay time out
+#define S6A_PIPELINE_TICK_MSEC     (50)    ///< Period of the S6A task timer expiring the requests
+/* The failure AIA of an AIR timeout is matched by IMSI in NAS: it must arrive while the NAS
+   procedure of the AIR waits. The timer wheel expires a request up to 2 ticks after its
+   timeout, so REQUEST_TIMEOUT_MS + 2 * S6A_PIPELINE_TICK_MSEC must stay below the NAS timer */
+#define S6A_AUTH_INFO_RSP_TIMER_MS (2000)  ///< TIMER_S6A_AUTH_INFO_RSP_DEFAULT_VALUE in ms
+
 /*******************************************************************************
  * SCTP Constants
  ******************************************************************************/
@@ -0,0 +1,495 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file system_executor.c
+  \brief Executor of the unix commands issued by the EPC, without a shell when possible.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/pkt_sched.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "log.h"
+#include "common_defs.h"
+#include "system_executor.h"
+
+#define SYSTEM_EXECUTOR_NOT_NATIVE      -1     // syntax not handled natively, run the command with system()
+#define SYSTEM_EXECUTOR_ARGV_MAX        64
+#define SYSTEM_EXECUTOR_NL_BUFFER_SIZE  4096
+
+extern char **environ;
+
+typedef struct system_executor_nl_request_s {
+  struct nlmsghdr                         header;
+  char                                    payload[512];
+} system_executor_nl_request_t;
+
+typedef int (*system_executor_handler_t)(int argc, char **argv);
+
+static pthread_mutex_t                    nl_lock = PTHREAD_MUTEX_INITIALIZER;
+static int                                nl_fd = -1;     // persistent NETLINK_ROUTE socket, opened on first use
+static uint32_t                           nl_seq = 0;
+
+//------------------------------------------------------------------------------
+// Split a command in words, fails if it needs a shell (quotes, redirections, variables, globs, etc.)
+static int system_executor_split(char * const command, char **argv)
+{
+  int                                     argc = 0;
+  char                                   *p = command;
+
+  if (strpbrk(command, "|&;<>()$`'\"\\*?[]{}~#") || (strchr(command, '=') && strncmp(command, "sysctl ", 7))) {
+    return -1;
+  }
+  while (*p) {
+    while ((*p == ' ') || (*p == '\t') || (*p == '\n')) *p++ = '\0';
+    if (!*p) break;
+    if (SYSTEM_EXECUTOR_ARGV_MAX == argc) return -1;
+    argv[argc++] = p;
+    while (*p && (*p != ' ') && (*p != '\t') && (*p != '\n')) p++;
+  }
+  return argc;
+}
+
+//------------------------------------------------------------------------------
+static void nl_add_attr(struct nlmsghdr * const header, const int type, const void * const data, const int len)
+{
+  struct rtattr                          *rta = (struct rtattr *)(((char *)header) + NLMSG_ALIGN(header->nlmsg_len));
+
+  rta->rta_type = type;
+  rta->rta_len = RTA_LENGTH(len);
+  if (len) memcpy(RTA_DATA(rta), data, len);
+  header->nlmsg_len = NLMSG_ALIGN(header->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+//------------------------------------------------------------------------------
+static int nl_open(void)
+{
+  struct sockaddr_nl                      local = {.nl_family = AF_NETLINK};
+
+  if (0 <= nl_fd) return RETURNok;
+  nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (0 > nl_fd) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "Cannot open rtnetlink socket: %s\n", strerror(errno));
+    return RETURNerror;
+  }
+  if (bind(nl_fd, (struct sockaddr *)&local, sizeof(local))) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "Cannot bind rtnetlink socket: %s\n", strerror(errno));
+    close(nl_fd);
+    nl_fd = -1;
+    return RETURNerror;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// Send a request on the persistent socket and wait for its acknowledgement, returns 0 or an errno
+static int nl_transaction(struct nlmsghdr * const header)
+{
+  struct sockaddr_nl                      kernel = {.nl_family = AF_NETLINK};
+  char                                    buffer[SYSTEM_EXECUTOR_NL_BUFFER_SIZE] __attribute__((aligned(NLMSG_ALIGNTO)));
+  int                                     rc = EIO;
+
+  pthread_mutex_lock(&nl_lock);
+  if (RETURNok != nl_open()) {
+    pthread_mutex_unlock(&nl_lock);
+    return EIO;
+  }
+  header->nlmsg_flags |= NLM_F_REQUEST | NLM_F_ACK;
+  header->nlmsg_seq = ++nl_seq;
+  if (0 > sendto(nl_fd, header, header->nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel))) {
+    rc = errno;
+    pthread_mutex_unlock(&nl_lock);
+    return rc;
+  }
+  while (1) {
+    ssize_t                               len = recv(nl_fd, buffer, sizeof(buffer), 0);
+
+    if (0 > len) {
+      if (EINTR == errno) continue;
+      rc = errno;
+      break;
+    }
+    for (struct nlmsghdr *h = (struct nlmsghdr *)buffer; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+      if ((h->nlmsg_seq == header->nlmsg_seq) && (NLMSG_ERROR == h->nlmsg_type)) {
+        rc = -((struct nlmsgerr *)NLMSG_DATA(h))->error;
+        pthread_mutex_unlock(&nl_lock);
+        return rc;
+      }
+    }
+  }
+  pthread_mutex_unlock(&nl_lock);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+static int parse_prefix(const char * const str, struct in_addr * const addr, uint8_t * const prefix_len)
+{
+  char                                    buf[INET_ADDRSTRLEN];
+  const char                             *slash = strchr(str, '/');
+  size_t                                  len = slash ? (size_t)(slash - str) : strlen(str);
+  char                                   *end = NULL;
+
+  if (len >= sizeof(buf)) return RETURNerror;
+  memcpy(buf, str, len);
+  buf[len] = '\0';
+  if (1 != inet_pton(AF_INET, buf, addr)) return RETURNerror;
+  *prefix_len = 32;
+  if (slash) {
+    unsigned long                         l = strtoul(slash + 1, &end, 10);
+
+    if ((end == slash + 1) || *end || (l > 32)) return RETURNerror;
+    *prefix_len = (uint8_t)l;
+  }
+  return RETURNok;
+}
+
+//------------------------------------------------------------------------------
+// ip link set [dev] NAME [mtu N] [up|down]
+static int system_executor_ip_link(int argc, char **argv)
+{
+  system_executor_nl_request_t            req = {.header = {0}};
+  struct ifinfomsg                       *ifi = NLMSG_DATA(&req.header);
+  const char                             *name = NULL;
+  int                                     i = 1;
+
+  if ((argc < 4) || strcmp(argv[i++], "set")) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  if (!strcmp(argv[i], "dev")) i++;
+  name = argv[i++];
+  req.header.nlmsg_len = NLMSG_LENGTH(sizeof(*ifi));
+  req.header.nlmsg_type = RTM_NEWLINK;
+  ifi->ifi_family = AF_UNSPEC;
+  for (; i < argc; i++) {
+    if (!strcmp(argv[i], "up")) {
+      ifi->ifi_change |= IFF_UP;
+      ifi->ifi_flags |= IFF_UP;
+    } else if (!strcmp(argv[i], "down")) {
+      ifi->ifi_change |= IFF_UP;
+      ifi->ifi_flags &= ~IFF_UP;
+    } else if (!strcmp(argv[i], "mtu") && (i + 1 < argc)) {
+      char                               *end = NULL;
+      uint32_t                            mtu = (uint32_t)strtoul(argv[++i], &end, 10);
+
+      if (*end) return SYSTEM_EXECUTOR_NOT_NATIVE;
+      nl_add_attr(&req.header, IFLA_MTU, &mtu, sizeof(mtu));
+    } else {
+      return SYSTEM_EXECUTOR_NOT_NATIVE;
+    }
+  }
+  if (!(ifi->ifi_index = if_nametoindex(name))) return ENODEV;
+  return nl_transaction(&req.header);
+}
+
+//------------------------------------------------------------------------------
+// ip addr add A/L dev NAME, ip route add A/L dev NAME
+static int system_executor_ip_addr_route(int argc, char **argv, const bool is_route)
+{
+  system_executor_nl_request_t            req = {.header = {0}};
+  struct in_addr                          addr = {0};
+  uint8_t                                 prefix_len = 0;
+  int                                     ifindex = 0;
+
+  if ((6 != argc) || strcmp(argv[2], "add") || strcmp(argv[4], "dev")) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  if (RETURNok != parse_prefix(argv[3], &addr, &prefix_len)) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  if (!(ifindex = if_nametoindex(argv[5]))) return ENODEV;
+  req.header.nlmsg_flags = NLM_F_CREATE | NLM_F_EXCL;
+  if (is_route) {
+    struct rtmsg                         *rtm = NLMSG_DATA(&req.header);
+
+    req.header.nlmsg_len = NLMSG_LENGTH(sizeof(*rtm));
+    req.header.nlmsg_type = RTM_NEWROUTE;
+    rtm->rtm_family = AF_INET;
+    rtm->rtm_dst_len = prefix_len;
+    rtm->rtm_table = RT_TABLE_MAIN;
+    rtm->rtm_protocol = RTPROT_BOOT;
+    rtm->rtm_scope = RT_SCOPE_LINK;
+    rtm->rtm_type = RTN_UNICAST;
+    nl_add_attr(&req.header, RTA_DST, &addr, sizeof(addr));
+    nl_add_attr(&req.header, RTA_OIF, &ifindex, sizeof(ifindex));
+  } else {
+    struct ifaddrmsg                     *ifa = NLMSG_DATA(&req.header);
+
+    req.header.nlmsg_len = NLMSG_LENGTH(sizeof(*ifa));
+    req.header.nlmsg_type = RTM_NEWADDR;
+    ifa->ifa_family = AF_INET;
+    ifa->ifa_prefixlen = prefix_len;
+    ifa->ifa_index = ifindex;
+    nl_add_attr(&req.header, IFA_LOCAL, &addr, sizeof(addr));
+    nl_add_attr(&req.header, IFA_ADDRESS, &addr, sizeof(addr));
+  }
+  return nl_transaction(&req.header);
+}
+
+//------------------------------------------------------------------------------
+static int system_executor_ip(int argc, char **argv)
+{
+  if (argc < 2) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  if (!strcmp(argv[1], "link")) return system_executor_ip_link(argc - 1, argv + 1);
+  if (!strcmp(argv[1], "addr") || !strcmp(argv[1], "address") || !strcmp(argv[1], "a"))
+    return system_executor_ip_addr_route(argc, argv, false);
+  if (!strcmp(argv[1], "route") || !strcmp(argv[1], "r"))
+    return system_executor_ip_addr_route(argc, argv, true);
+  return SYSTEM_EXECUTOR_NOT_NATIVE;
+}
+
+//------------------------------------------------------------------------------
+// tc qdisc del root dev NAME, tc qdisc add dev NAME root handle M: htb [default N]
+static int system_executor_tc(int argc, char **argv)
+{
+  system_executor_nl_request_t            req = {.header = {0}};
+  struct tcmsg                           *tcm = NLMSG_DATA(&req.header);
+  const char                             *name = NULL;
+  const char                             *kind = NULL;
+  struct tc_htb_glob                      htb = {.version = TC_HTB_PROTOVER, .rate2quantum = 10};
+  bool                                    is_add = false;
+  bool                                    is_root = false;
+  char                                   *end = NULL;
+
+  if ((argc < 5) || strcmp(argv[1], "qdisc")) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  if (!strcmp(argv[2], "add")) is_add = true;
+  else if (strcmp(argv[2], "del") && strcmp(argv[2], "delete")) return SYSTEM_EXECUTOR_NOT_NATIVE;
+
+  for (int i = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "dev") && (i + 1 < argc)) {
+      name = argv[++i];
+    } else if (!strcmp(argv[i], "root")) {
+      is_root = true;
+    } else if (is_add && !strcmp(argv[i], "handle") && (i + 1 < argc)) {
+      uint32_t                            major = (uint32_t)strtoul(argv[++i], &end, 16);
+
+      if ((':' != end[0]) || end[1] || (major > 0xFFFF)) return SYSTEM_EXECUTOR_NOT_NATIVE;
+      tcm->tcm_handle = major << 16;
+    } else if (is_add && !kind && !strcmp(argv[i], "htb")) {
+      kind = argv[i];
+    } else if (kind && !strcmp(argv[i], "default") && (i + 1 < argc)) {
+      htb.defcls = (uint32_t)strtoul(argv[++i], &end, 16);      // hexadecimal, as tc
+      if (*end) return SYSTEM_EXECUTOR_NOT_NATIVE;
+    } else {
+      return SYSTEM_EXECUTOR_NOT_NATIVE;
+    }
+  }
+  if (!name || !is_root || (is_add && !kind)) return SYSTEM_EXECUTOR_NOT_NATIVE;
+
+  req.header.nlmsg_len = NLMSG_LENGTH(sizeof(*tcm));
+  tcm->tcm_family = AF_UNSPEC;
+  tcm->tcm_parent = TC_H_ROOT;
+  if (!(tcm->tcm_ifindex = if_nametoindex(name))) return ENODEV;
+  if (is_add) {
+    struct rtattr                        *options = NULL;
+
+    req.header.nlmsg_type = RTM_NEWQDISC;
+    req.header.nlmsg_flags = NLM_F_CREATE | NLM_F_EXCL;
+    nl_add_attr(&req.header, TCA_KIND, kind, strlen(kind) + 1);
+    options = (struct rtattr *)(((char *)&req.header) + NLMSG_ALIGN(req.header.nlmsg_len));
+    nl_add_attr(&req.header, TCA_OPTIONS, NULL, 0);
+    nl_add_attr(&req.header, TCA_HTB_INIT, &htb, sizeof(htb));
+    options->rta_len = (unsigned short)(((char *)&req.header) + req.header.nlmsg_len - (char *)options);
+  } else {
+    req.header.nlmsg_type = RTM_DELQDISC;
+  }
+  return nl_transaction(&req.header);
+}
+
+//------------------------------------------------------------------------------
+// sysctl -w key=value...
+static int system_executor_sysctl(int argc, char **argv)
+{
+  if ((argc < 3) || strcmp(argv[1], "-w")) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  for (int i = 2; i < argc; i++) {
+    char                                  path[256];
+    char                                 *value = strchr(argv[i], '=');
+    int                                   len = 0;
+    int                                   fd = -1;
+
+    if (!value || (value == argv[i])) return SYSTEM_EXECUTOR_NOT_NATIVE;
+    len = snprintf(path, sizeof(path), "/proc/sys/%.*s", (int)(value - argv[i]), argv[i]);
+    if ((0 > len) || (len >= (int)sizeof(path))) return SYSTEM_EXECUTOR_NOT_NATIVE;
+    for (char *p = path + 10; *p; p++) {
+      if ('.' == *p) *p = '/';
+    }
+    value++;
+    if (0 > (fd = open(path, O_WRONLY | O_CLOEXEC))) return errno;
+    if (write(fd, value, strlen(value)) != (ssize_t)strlen(value)) {
+      int                                 rc = errno ? errno : EIO;
+
+      close(fd);
+      return rc;
+    }
+    close(fd);
+  }
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+static int system_executor_sync(int argc, __attribute__ ((unused)) char **argv)
+{
+  if (1 != argc) return SYSTEM_EXECUTOR_NOT_NATIVE;
+  sync();
+  return 0;
+}
+
+static const struct {
+  const char                             *program;
+  system_executor_handler_t               handler;
+} native_commands[] = {
+  {"ip",     system_executor_ip},
+  {"tc",     system_executor_tc},
+  {"sysctl", system_executor_sysctl},
+  {"sync",   system_executor_sync},
+};
+
+//------------------------------------------------------------------------------
+int system_executor_run(const char * const command)
+{
+  char                                   *argv[SYSTEM_EXECUTOR_ARGV_MAX];
+  char                                   *words = strdup(command);
+  int                                     argc = 0;
+  int                                     rc = SYSTEM_EXECUTOR_NOT_NATIVE;
+
+  if (words && (0 < (argc = system_executor_split(words, argv)))) {
+    for (int i = 0; i < (int)(sizeof(native_commands) / sizeof(native_commands[0])); i++) {
+      if (!strcmp(argv[0], native_commands[i].program)) {
+        rc = native_commands[i].handler(argc, argv);
+        break;
+      }
+    }
+  }
+  free_wrapper((void**)&words);
+  if (SYSTEM_EXECUTOR_NOT_NATIVE != rc) {
+    if (rc) {
+      OAILOG_ERROR (LOG_ASYNC_SYSTEM, "Native command %s failed: %s\n", command, strerror(rc));
+    }
+    return rc;
+  }
+  OAILOG_DEBUG (LOG_ASYNC_SYSTEM, "C system() call: %s\n", command);
+  return system(command);
+}
+
+//------------------------------------------------------------------------------
+int system_executor_batch_add(system_executor_batch_t * const batch, const char * const command)
+{
+  char                                   *argv[SYSTEM_EXECUTOR_ARGV_MAX];
+  char                                   *words = NULL;
+  const char                             *table = "filter";
+  int                                     argc = 0;
+  int                                     first = -1;
+  int                                     rc = RETURNerror;
+
+  if ((SYSTEM_EXECUTOR_BATCH_MAX <= batch->nb_commands) || strncmp(command, "iptables ", 9)) return RETURNerror;
+  words = strdup(command);
+  if (!words || (2 > (argc = system_executor_split(words, argv)))) goto done;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-t") || !strcmp(argv[i], "--table")) {
+      if ((i + 1 == argc) || strcmp(table, "filter")) goto done;
+      table = argv[++i];
+      argv[i - 1] = argv[i] = NULL;
+    } else if (!strcmp(argv[i], "-w") || !strcmp(argv[i], "--wait")) {
+      goto done;
+    } else if (0 > first) {
+      first = i;
+    }
+  }
+  // only rule and chain updates, no listing
+  if ((0 > first) || (strcmp(argv[first], "-A") && strcmp(argv[first], "-I") && strcmp(argv[first], "-D")
+                      && strcmp(argv[first], "-R") && strcmp(argv[first], "-F") && strcmp(argv[first], "-N"))) goto done;
+  if (batch->nb_commands && strcmp(batch->table, table)) goto done;
+  if (strlen(table) >= sizeof(batch->table)) goto done;
+
+  if (!batch->nb_commands) {
+    strcpy(batch->table, table);
+    if (!batch->restore_input) batch->restore_input = bfromcstralloc(4096, "");
+    btrunc(batch->restore_input, 0);
+    bformata(batch->restore_input, "*%s\n", table);
+  }
+  for (int i = first; i < argc; i++) {
+    if (argv[i]) bformata(batch->restore_input, "%s%s", argv[i], (i + 1 < argc) ? " " : "\n");
+  }
+  batch->nb_commands++;
+  rc = RETURNok;
+done:
+  free_wrapper((void**)&words);
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+int system_executor_batch_commit(system_executor_batch_t * const batch)
+{
+  char                                   *argv[] = {"iptables-restore", "--noflush", NULL};
+  posix_spawn_file_actions_t              actions;
+  int                                     fds[2] = {-1, -1};
+  pid_t                                   pid = 0;
+  int                                     status = -1;
+  int                                     rc = 0;
+
+  if (!batch->nb_commands) return 0;
+  batch->nb_commands = 0;
+  bcatcstr(batch->restore_input, "COMMIT\n");
+  // a socket pair rather than a pipe: no SIGPIPE if iptables-restore exits early, and the write end
+  // does not leak to iptables-restore, otherwise it would never read EOF
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds)) return -1;
+
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+  rc = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fds[0]);
+  if (rc) {
+    OAILOG_ERROR (LOG_ASYNC_SYSTEM, "Cannot spawn %s: %s\n", argv[0], strerror(rc));
+    close(fds[1]);
+    return -1;
+  }
+  for (int done = 0; done < blength(batch->restore_input); ) {
+    ssize_t                               len = send(fds[1], bdata(batch->restore_input) + done, blength(batch->restore_input) - done, MSG_NOSIGNAL);
+
+    if (0 > len) {
+      if (EINTR == errno) continue;
+      break;                              // iptables-restore exited, its status tells
+    }
+    done += len;
+  }
+  close(fds[1]);
+  while ((0 > waitpid(pid, &status, 0)) && (EINTR == errno));
+  return status;
+}
+
+//------------------------------------------------------------------------------
+void system_executor_batch_clear(system_executor_batch_t * const batch)
+{
+  batch->nb_commands = 0;
+  bdestroy_wrapper(&batch->restore_input);
+}
@@ -0,0 +1,70 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file system_executor.h
+  \brief Executor of the unix commands issued by the EPC, without a shell when possible.
+  A command whose syntax is known is run natively on a persistent rtnetlink socket or with a system
+  call, without any fork: "ip link set", "ip addr add", "ip route add", "tc qdisc add|del" (root htb),
+  "sysctl -w" and "sync". Any other command is run with system().
+  Consecutive iptables commands on the same table can be gathered in a batch committed as one atomic
+  iptables-restore transaction, i.e. with one process instead of one shell and one iptables process
+  per rule.
+*/
+#ifndef FILE_SYSTEM_EXECUTOR_SEEN
+#define FILE_SYSTEM_EXECUTOR_SEEN
+
+#define SYSTEM_EXECUTOR_BATCH_MAX       256    /*!< \brief Commands in one iptables-restore transaction */
+
+typedef struct system_executor_batch_s {
+  char                                    table[32];        // iptables table of the commands
+  int                                     nb_commands;
+  bstring                                 restore_input;    // iptables-restore input, without COMMIT
+} system_executor_batch_t;
+
+/*
+ * Run a command, natively if its syntax is known, with system() otherwise. Thread safe.
+ *
+ * @return 0 on success, the errno of the failed native call or the status returned by system() otherwise.
+ */
+int system_executor_run(const char * const command);
+
+/*
+ * Append an iptables command to a batch.
+ *
+ * @return RETURNok, RETURNerror if the command cannot be expressed as an iptables-restore line, targets
+ *         another table than the commands already in the batch or the batch is full.
+ */
+int system_executor_batch_add(system_executor_batch_t * const batch, const char * const command);
+
+/*
+ * Commit the commands of a batch in one iptables-restore transaction and empty the batch.
+ * Either all the commands are applied or none of them.
+ *
+ * @return 0 on success, the status of iptables-restore otherwise.
+ */
+int system_executor_batch_commit(system_executor_batch_t * const batch);
+
+/*
+ * Empty a batch without running its commands, release its memory.
+ */
+void system_executor_batch_clear(system_executor_batch_t * const batch);
+
+#endif /* FILE_SYSTEM_EXECUTOR_SEEN */
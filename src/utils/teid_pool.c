@@ -0,0 +1,211 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file teid_pool.c
+  \brief Allocator of unique tunnel endpoint identifiers.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bstrlib.h"
+
+#include "dynamic_memory_check.h"
+#include "assertions.h"
+#include "log.h"
+#include "common_types.h"
+#include "common_defs.h"
+#include "teid_pool.h"
+
+// TEIDs of one sub-pool are numbered by their index i: TEID = first_teid + i * nb_shards + shard
+typedef struct teid_sub_pool_s {
+  pthread_mutex_t                         lock;
+  uint32_t                                nb_teids;
+  uint32_t                                next_fresh;    // indexes >= next_fresh were never handed out
+  uint32_t                                nb_allocated;
+  uint32_t                                fifo_head;     // released indexes, oldest first
+  uint32_t                                fifo_nb;
+  uint32_t                               *fifo;
+  uint64_t                               *allocated;     // bitmap by index
+} teid_sub_pool_t;
+
+struct teid_pool_s {
+  char                                    name[32];
+  teid_t                                  first_teid;
+  uint32_t                                nb_teids;
+  uint32_t                                nb_shards;
+  teid_sub_pool_t                        *shards;
+};
+
+//------------------------------------------------------------------------------
+teid_pool_t *teid_pool_create (const char * const name, const teid_t first_teid, const uint32_t nb_teids, const uint32_t nb_shards)
+{
+  teid_pool_t                            *pool = NULL;
+  uint32_t                                s;
+
+  if ((first_teid == INVALID_TEID) || (!nb_teids) || (!nb_shards) || (nb_shards > nb_teids) ||
+      (((uint64_t)first_teid + nb_teids - 1) > UINT32_MAX)) {
+    OAILOG_ERROR (LOG_UTIL, "Bad TEID pool %s: first " TEID_FMT " size %u shards %u\n", name, first_teid, nb_teids, nb_shards);
+    return NULL;
+  }
+  pool = calloc (1, sizeof (teid_pool_t));
+  if (!pool) {
+    return NULL;
+  }
+  snprintf (pool->name, sizeof (pool->name), "%s", name);
+  pool->first_teid = first_teid;
+  pool->nb_teids = nb_teids;
+  pool->nb_shards = nb_shards;
+  pool->shards = calloc (nb_shards, sizeof (teid_sub_pool_t));
+  if (!pool->shards) {
+    free_wrapper ((void**)&pool);
+    return NULL;
+  }
+  for (s = 0; s < nb_shards; s++) {
+    teid_sub_pool_t                      *shard = &pool->shards[s];
+
+    pthread_mutex_init (&shard->lock, NULL);
+    shard->nb_teids = (nb_teids - s + nb_shards - 1) / nb_shards;
+    // Pages are only touched once TEIDs are released
+    shard->fifo = calloc (shard->nb_teids, sizeof (uint32_t));
+    shard->allocated = calloc ((shard->nb_teids + 63) / 64, sizeof (uint64_t));
+    if ((!shard->fifo) || (!shard->allocated)) {
+      teid_pool_destroy (&pool);
+      return NULL;
+    }
+  }
+  OAILOG_DEBUG (LOG_UTIL, "TEID pool %s: " TEID_FMT " to " TEID_FMT ", %u shard(s)\n", pool->name, first_teid,
+      (teid_t)(first_teid + nb_teids - 1), nb_shards);
+  return pool;
+}
+
+//------------------------------------------------------------------------------
+void teid_pool_destroy (teid_pool_t ** const pool)
+{
+  uint32_t                                s;
+
+  if ((!pool) || (!*pool)) {
+    return;
+  }
+  if ((*pool)->shards) {
+    for (s = 0; s < (*pool)->nb_shards; s++) {
+      free_wrapper ((void**)&(*pool)->shards[s].fifo);
+      free_wrapper ((void**)&(*pool)->shards[s].allocated);
+      pthread_mutex_destroy (&(*pool)->shards[s].lock);
+    }
+    free_wrapper ((void**)&(*pool)->shards);
+  }
+  free_wrapper ((void**)pool);
+}
+
+//------------------------------------------------------------------------------
+static bool teid_sub_pool_alloc (teid_sub_pool_t * const shard, uint32_t * const index)
+{
+  bool                                    found = true;
+
+  pthread_mutex_lock (&shard->lock);
+  if (shard->next_fresh < shard->nb_teids) {
+    *index = shard->next_fresh++;
+  } else if (shard->fifo_nb) {
+    *index = shard->fifo[shard->fifo_head];
+    shard->fifo_head = (shard->fifo_head + 1 == shard->nb_teids) ? 0 : shard->fifo_head + 1;
+    shard->fifo_nb--;
+  } else {
+    found = false;
+  }
+  if (found) {
+    shard->allocated[*index >> 6] |= (UINT64_C(1) << (*index & 63));
+    shard->nb_allocated++;
+  }
+  pthread_mutex_unlock (&shard->lock);
+  return found;
+}
+
+//------------------------------------------------------------------------------
+teid_t teid_pool_alloc (teid_pool_t * const pool, const uint32_t shard)
+{
+  uint32_t                                s = shard % pool->nb_shards;
+  uint32_t                                i;
+  uint32_t                                index;
+
+  for (i = 0; i < pool->nb_shards; i++) {
+    if (teid_sub_pool_alloc (&pool->shards[s], &index)) {
+      return (teid_t)(pool->first_teid + index * pool->nb_shards + s);
+    }
+    s = (s + 1 == pool->nb_shards) ? 0 : s + 1;
+  }
+  OAILOG_ERROR (LOG_UTIL, "TEID pool %s exhausted (%u TEIDs)\n", pool->name, pool->nb_teids);
+  return INVALID_TEID;
+}
+
+//------------------------------------------------------------------------------
+int teid_pool_free (teid_pool_t * const pool, const teid_t teid)
+{
+  teid_sub_pool_t                        *shard = NULL;
+  uint32_t                                offset = teid - pool->first_teid;
+  uint32_t                                index;
+  int                                     rc = RETURNok;
+
+  if ((teid < pool->first_teid) || (offset >= pool->nb_teids)) {
+    OAILOG_ERROR (LOG_UTIL, "TEID pool %s: releasing " TEID_FMT " out of range\n", pool->name, teid);
+    return RETURNerror;
+  }
+  shard = &pool->shards[offset % pool->nb_shards];
+  index = offset / pool->nb_shards;
+  pthread_mutex_lock (&shard->lock);
+  if (shard->allocated[index >> 6] & (UINT64_C(1) << (index & 63))) {
+    shard->allocated[index >> 6] &= ~(UINT64_C(1) << (index & 63));
+    shard->nb_allocated--;
+    // Cannot overflow: at most nb_teids indexes are released and not reallocated
+    shard->fifo[(shard->fifo_head + shard->fifo_nb) % shard->nb_teids] = index;
+    shard->fifo_nb++;
+  } else {
+    rc = RETURNerror;
+  }
+  pthread_mutex_unlock (&shard->lock);
+  if (rc != RETURNok) {
+    OAILOG_ERROR (LOG_UTIL, "TEID pool %s: releasing " TEID_FMT " not allocated\n", pool->name, teid);
+  }
+  return rc;
+}
+
+//------------------------------------------------------------------------------
+uint32_t teid_pool_shard (const teid_pool_t * const pool, const teid_t teid)
+{
+  return (uint32_t)(teid - pool->first_teid) % pool->nb_shards;
+}
+
+//------------------------------------------------------------------------------
+uint32_t teid_pool_nb_allocated (teid_pool_t * const pool)
+{
+  uint32_t                                nb_allocated = 0;
+  uint32_t                                s;
+
+  for (s = 0; s < pool->nb_shards; s++) {
+    pthread_mutex_lock (&pool->shards[s].lock);
+    nb_allocated += pool->shards[s].nb_allocated;
+    pthread_mutex_unlock (&pool->shards[s].lock);
+  }
+  return nb_allocated;
+}
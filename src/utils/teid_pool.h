@@ -0,0 +1,74 @@
+/*
+ * Licensed to the OpenAirInterface (OAI) Software Alliance under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The OpenAirInterface Software Alliance licenses this file to You under
+ * the Apache License, Version 2.0  (the "License"); you may not use this file
+ * except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *-------------------------------------------------------------------------------
+ * For more information about the OpenAirInterface (OAI) Software Alliance:
+ *      contact@openairinterface.org
+ */
+
+/*! \file teid_pool.h
+  \brief Allocator of unique tunnel endpoint identifiers, shared by S11, S1-U and S5/S8.
+  A pool hands out the TEIDs of a range [first_teid, first_teid + nb_teids). The range is split
+  between nb_shards sub-pools, sub-pool s owns the TEIDs t such that (t - first_teid) % nb_shards == s,
+  so that threads allocating from different sub-pools never collide and the owner of a TEID is
+  known without any lookup. Each sub-pool has its own lock.
+  Allocation and release are O(1): never used TEIDs are handed out first, released TEIDs are then
+  recycled in FIFO order so that a TEID is reused as late as possible. A bitmap rejects the release
+  of a TEID that is not allocated.
+*/
+#ifndef FILE_TEID_POOL_SEEN
+#define FILE_TEID_POOL_SEEN
+
+typedef struct teid_pool_s teid_pool_t;
+
+/*
+ * Create a pool.
+ *
+ * @param name       Name of the pool, for logs.
+ * @param first_teid First TEID of the range, INVALID_TEID (0) is never handed out.
+ * @param nb_teids   Size of the range.
+ * @param nb_shards  Number of sub-pools (at least 1).
+ * @return the pool, or NULL if the range is invalid or out of memory.
+ */
+teid_pool_t *teid_pool_create(const char * const name, const teid_t first_teid, const uint32_t nb_teids, const uint32_t nb_shards);
+
+void teid_pool_destroy(teid_pool_t ** const pool);
+
+/*
+ * Allocate a TEID from a sub-pool, from the other sub-pools if it is exhausted.
+ *
+ * @return the TEID, INVALID_TEID if the pool is exhausted.
+ */
+teid_t teid_pool_alloc(teid_pool_t * const pool, const uint32_t shard);
+
+/*
+ * Give back a TEID, thread safe.
+ *
+ * @return RETURNok, RETURNerror if the TEID is not in the range or not allocated.
+ */
+int teid_pool_free(teid_pool_t * const pool, const teid_t teid);
+
+/*
+ * Sub-pool owning a TEID of the range.
+ */
+uint32_t teid_pool_shard(const teid_pool_t * const pool, const teid_t teid);
+
+/*
+ * Number of TEIDs currently allocated.
+ */
+uint32_t teid_pool_nb_allocated(teid_pool_t * const pool);
+
+#endif /* FILE_TEID_POOL_SEEN */